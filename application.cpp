@@ -1,11 +1,24 @@
 
-#include "main.h"
+#include <cstdio>
+#include <cstring>
+
 #include "application.h"
-#include "window.h"
-#include "directx11_wrapper.h"
+#include "profiler.h"
 
 namespace Application
 {
+	/// <summary>
+	/// constructor for apps
+	/// </summary>
+	Manager::Manager()
+	{
+		_platform = nullptr;
+		_graphics = nullptr;
+		_title    = "";
+
+		_frameCount = 0;
+	}
+
 	/// <summary>
 	/// instantiate with the Singleton Method Design Pattern
 	/// </summary>
@@ -18,10 +31,32 @@ namespace Application
 	/// <summary>
 	/// initialization process for apps
 	/// </summary>
-	int Manager::Initialize()
+	int Manager::Initialize(_In_ Platform::Backend& platform, _In_ const Platform::WindowDesc& desc, _In_ Graphics& graphics,
+		_In_ const FrameScheduler::Settings& settings)
 	{
-		Window::Manager::Instance().Initialize();
-		DirectXWrapper::Manager::Instance().Initialize();
+		PROFILE_THREAD_NAME("main");
+
+		_platform = &platform;
+		_graphics = &graphics;
+		_title    = desc.Title;
+		Platform::Manager::Instance().SetBackend(_platform);
+
+		if (_platform->CreateMainWindow(desc))
+		{
+			Platform::Manager::Instance().SetBackend(nullptr);
+			return -1;
+		}
+
+		if (_graphics->Initialize())
+		{
+			_platform->DestroyMainWindow();
+			Platform::Manager::Instance().SetBackend(nullptr);
+			return -1;
+		}
+
+		// the first frame is due now
+		_scheduler.Initialize(&_platform->GetClock(), settings);
+		_frameCount = 0;
 
 		return 0;
 	}
@@ -31,8 +66,12 @@ namespace Application
 	/// </summary>
 	void Manager::Terminate()
 	{
-		DirectXWrapper::Manager::Instance().Terminate();
-		Window::Manager::Instance().Terminate();
+		_graphics->Terminate();
+		_platform->DestroyMainWindow();
+
+		Platform::Manager::Instance().SetBackend(nullptr);
+
+		PROFILE_WRITE_TRACE(Profiler::TRACE_FILE_PATH);
 	}
 
 	/// <summary>
@@ -40,32 +79,95 @@ namespace Application
 	/// </summary>
 	void Manager::Run()
 	{
-		Window::Manager window_manager = Window::Manager::Instance();
-		
-		HWND& hWnd = window_manager.GetWindowHandle();
-		MSG message;
-		
-		// show (display) and update window
-		ShowWindow(hWnd, SW_SHOW);
-		UpdateWindow(hWnd);
-
-		// busy loop
-		while (1)
-		{
-			// if there are messages in the Windows Message Queue, process the following
-			if (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE))
-			{
-				// if "PostQuitMessage(0)" is called in the Window Procedure, exit the busy loop
-				if (message.message == WM_QUIT) break;
+		_platform->ShowMainWindow();
 
-				// translate and dispatch of messages
-				TranslateMessage(&message);
-				DispatchMessage(&message);
-			}
-			else
+		// frame loop, the scheduler waits for the next frame instead of spinning the whole period
+		bool is_quit = false;
+		while (!is_quit)
+		{
+			// drain every pending event before the frame
+			Platform::Event event;
+			while (_platform->PollEvent(&event))
 			{
-				window_manager.Run();
+				if (!HandleEvent(event))
+				{
+					is_quit = true;
+					break;
+				}
 			}
+
+			if (!is_quit) RunFrame();
+		}
+	}
+
+	/// <summary>
+	/// handle an event, returns false to exit the frame loop
+	/// </summary>
+	bool Manager::HandleEvent(_In_ const Platform::Event& event)
+	{
+		switch (event.Type)
+		{
+		case Platform::EventType::Quit:
+			return false;
+
+		case Platform::EventType::KeyDown:
+			// the escape key closes the application on every platform
+			if (event.Key == Platform::KEY_ESCAPE) return false;
+			break;
+
+		default:
+			break;
+		}
+
+		return true;
+	}
+
+	/// <summary>
+	/// waits for the frame, runs the fixed steps of the simulation, and draws
+	/// </summary>
+	void Manager::RunFrame()
+	{
+		_scheduler.WaitForNextFrame();
+		const uint32_t steps = _scheduler.BeginFrame();
+
+		// the simulation runs on a fixed step, decoupled from the frame rate
+		for (uint32_t s = 0; s < steps; ++s)
+		{
+			_graphics->FixedUpdate();
 		}
+
+		// if you run a graphics pipeline, do it here
+		_graphics->Update();
+		_graphics->Draw(_scheduler.GetInterpolation());
+		_frameCount++;
+
+#ifdef _DEBUG
+		// display debug strings
+		const FrameScheduler::FrameStats& frame_stats = _scheduler.GetLastFrameStats();
+
+		char debug_title[DEBUG_TITLE_SIZE];
+		std::snprintf(debug_title, sizeof(debug_title), "%s - fps [ %u ] jitter [ %u us ]",
+			_title, frame_stats.Frames, static_cast<unsigned>(frame_stats.JitterMs * 1000.0));
+
+		const size_t length = std::strlen(debug_title);
+		_graphics->AppendDebugTitle(&debug_title[length], sizeof(debug_title) - length);
+		_platform->SetTitle(debug_title);
+#endif
+	}
+
+	/// <summary>
+	/// get the number of drawn frames
+	/// </summary>
+	uint64_t Manager::GetFrameCount() const
+	{
+		return _frameCount;
+	}
+
+	/// <summary>
+	/// get frame statistics of the last second
+	/// </summary>
+	const FrameScheduler::FrameStats& Manager::GetLastFrameStats() const
+	{
+		return _scheduler.GetLastFrameStats();
 	}
 }
@@ -1,15 +1,75 @@
 
 #pragma once
 
+#include "platform.h"
+#include "frame_scheduler.h"
+
 namespace Application
 {
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// size of the debug title
+	constexpr size_t DEBUG_TITLE_SIZE = 2048;
+
+	//--------------------------------------------------------
+	// graphics interface
+	//--------------------------------------------------------
+	/// <summary>
+	/// what the frame loop drives (DirectXWrapper, or a cpu renderer without a gpu)
+	/// </summary>
+	class Graphics
+	{
+	public:
+		virtual ~Graphics() = default;
+
+		virtual int Initialize() = 0;
+		virtual void Terminate() = 0;
+
+		// called at the fixed rate of the frame scheduler
+		virtual void FixedUpdate() = 0;
+
+		// called once per frame
+		virtual void Update() = 0;
+		virtual void Draw(_In_ float interpolation) = 0;
+
+		// statistics of the previous frame for the debug title
+		virtual void AppendDebugTitle(_Inout_ char* buffer, _In_ size_t size) const = 0;
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
 	class Manager
 	{
+		Platform::Backend* _platform;
+		Graphics* _graphics;
+		const char* _title;
+
+		// time
+		FrameScheduler::Scheduler _scheduler;
+		uint64_t _frameCount;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		bool HandleEvent(_In_ const Platform::Event& event);
+		void RunFrame();
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
 	public:
+		Manager();
 		static Manager& Instance();
 
-		int  Initialize();
+		int  Initialize(_In_ Platform::Backend& platform, _In_ const Platform::WindowDesc& desc, _In_ Graphics& graphics,
+			_In_ const FrameScheduler::Settings& settings = FrameScheduler::GetDefaultSettings());
 		void Terminate();
 		void Run();
+
+		// getter
+		uint64_t GetFrameCount() const;
+		const FrameScheduler::FrameStats& GetLastFrameStats() const;
 	};
 }
@@ -0,0 +1,82 @@
+
+#include "directx11_wrapper.h"
+#include "atlas.h"
+#include "texture_stream.h"
+
+namespace Atlas
+{
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// initialization process for atlas
+	/// loads the manifest, and requests every page from the texture stream
+	/// </summary>
+	HRESULT Manager::Initialize(_In_ const char* manifestPath)
+	{
+		const int result = _manifest.Load(manifestPath);
+		if (result == -1)
+			return S_FALSE;
+		if (result != 0)
+			return E_FAIL;
+
+		// page files are relative to the manifest
+		std::string directory = manifestPath;
+		directory.erase(directory.find_last_of("/\\") + 1);
+
+		for (size_t p = 0; p < _manifest.GetPageCount(); ++p)
+		{
+			const std::string page_path = directory + _manifest.GetPage(p).File;
+
+			std::wstring wide_path(page_path.size() + 1, L'\0');
+			mbstowcs_s(0, &wide_path[0], wide_path.size(), page_path.c_str(), _TRUNCATE);
+
+			_pageHandles.push_back(TextureStream::Manager::Instance().Load(wide_path.c_str(), ATLAS_PAGE_PRIORITY));
+		}
+
+		return S_OK;
+	}
+
+	/// <summary>
+	/// termination process for atlas
+	/// </summary>
+	void Manager::Terminate()
+	{
+		for (TextureStream::Handle handle : _pageHandles)
+		{
+			TextureStream::Manager::Instance().Unload(handle);
+		}
+		_pageHandles.clear();
+
+		_manifest.Clear();
+	}
+
+	/// <summary>
+	/// find a region by name, and the page it lives in
+	/// </summary>
+	const AtlasManifest::Region* Manager::Find(_In_ const char* name, _Out_ TextureStream::Handle* p_handle) const
+	{
+		*p_handle = TextureStream::INVALID_HANDLE;
+
+		const AtlasManifest::Region* p_region = _manifest.Find(name);
+		if (!p_region) return nullptr;
+
+		*p_handle = _pageHandles[p_region->Atlas];
+
+		return p_region;
+	}
+
+	/// <summary>
+	/// get the number of regions
+	/// </summary>
+	size_t Manager::GetRegionCount() const
+	{
+		return _manifest.GetRegionCount();
+	}
+}
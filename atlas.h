@@ -0,0 +1,47 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "atlas_manifest.h"
+#include "texture_stream_core.h"
+
+namespace Atlas
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// written by "tools atlas", see README
+	constexpr char* ATLAS_MANIFEST_PATH = "resource/atlas/sprites.atlas";
+
+	// pages are shared by many sprites, so they are streamed before single textures
+	constexpr int ATLAS_PAGE_PRIORITY = 1;
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		AtlasManifest::Manifest _manifest;
+
+		// streamed atlas pages, indexed by the atlas of a region
+		std::vector<TextureStream::Handle> _pageHandles;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		static Manager& Instance();
+
+		// returns S_FALSE if there is no manifest
+		HRESULT Initialize(_In_ const char* manifestPath = ATLAS_MANIFEST_PATH);
+		void Terminate();
+
+		// returns nullptr if the name is unknown
+		const AtlasManifest::Region* Find(_In_ const char* name, _Out_ TextureStream::Handle* p_handle) const;
+
+		// getter
+		size_t GetRegionCount() const;
+	};
+}
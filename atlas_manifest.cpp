@@ -0,0 +1,174 @@
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "atlas_manifest.h"
+
+namespace AtlasManifest
+{
+	namespace
+	{
+		/// <summary>
+		/// split a record at the tabs, names may contain spaces
+		/// </summary>
+		std::vector<std::string> SplitRecord(const std::string& line)
+		{
+			std::vector<std::string> fields;
+
+			size_t begin = 0;
+			for (;;)
+			{
+				const size_t end = line.find('\t', begin);
+				fields.push_back(line.substr(begin, end - begin));
+				if (end == std::string::npos) break;
+				begin = end + 1;
+			}
+
+			return fields;
+		}
+	}
+
+	/// <summary>
+	/// load the manifest
+	/// </summary>
+	int Manifest::Load(_In_ const std::string& path)
+	{
+		Clear();
+
+		std::ifstream stream(path);
+		if (!stream)
+			return -1;
+
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			if (!line.empty() && line.back() == '\r') line.pop_back();
+			if (line.empty() || line[0] == '#') continue;
+
+			const std::vector<std::string> fields = SplitRecord(line);
+
+			if (fields[0] == "page" && fields.size() == 4)
+			{
+				Page page;
+				page.File   = fields[1];
+				page.Width  = static_cast<uint32_t>(std::strtoul(fields[2].c_str(), nullptr, 10));
+				page.Height = static_cast<uint32_t>(std::strtoul(fields[3].c_str(), nullptr, 10));
+				AddPage(page);
+			}
+			else if (fields[0] == "region" && fields.size() == 10)
+			{
+				Region region;
+				region.Atlas       = static_cast<uint32_t>(std::strtoul(fields[2].c_str(), nullptr, 10));
+				region.Texcoord[0] = std::strtof(fields[3].c_str(), nullptr);
+				region.Texcoord[1] = std::strtof(fields[4].c_str(), nullptr);
+				region.TexSize[0]  = std::strtof(fields[5].c_str(), nullptr);
+				region.TexSize[1]  = std::strtof(fields[6].c_str(), nullptr);
+				region.Width       = static_cast<uint32_t>(std::strtoul(fields[7].c_str(), nullptr, 10));
+				region.Height      = static_cast<uint32_t>(std::strtoul(fields[8].c_str(), nullptr, 10));
+				region.Rotated     = fields[9] == "1";
+				if (region.Atlas >= _pages.size())
+					return -2;
+
+				AddRegion(fields[1], region);
+			}
+			else
+			{
+				return -2;
+			}
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// save the manifest, regions in the order they were added
+	/// </summary>
+	int Manifest::Save(_In_ const std::string& path) const
+	{
+		std::ofstream stream(path);
+		if (!stream)
+			return -1;
+
+		// 9 digits round trip a float
+		stream.precision(9);
+
+		stream << FILE_HEADER << '\n';
+		for (const Page& page : _pages)
+		{
+			stream << "page\t" << page.File << '\t' << page.Width << '\t' << page.Height << '\n';
+		}
+
+		for (const std::string& name : _names)
+		{
+			const Region& region = _regions.at(name);
+			stream << "region\t" << name << '\t' << region.Atlas
+				<< '\t' << region.Texcoord[0] << '\t' << region.Texcoord[1]
+				<< '\t' << region.TexSize[0]  << '\t' << region.TexSize[1]
+				<< '\t' << region.Width << '\t' << region.Height
+				<< '\t' << (region.Rotated ? 1 : 0) << '\n';
+		}
+
+		return stream ? 0 : -1;
+	}
+
+	/// <summary>
+	/// remove all pages and regions
+	/// </summary>
+	void Manifest::Clear()
+	{
+		_pages.clear();
+		_names.clear();
+		_regions.clear();
+	}
+
+	/// <summary>
+	/// add an atlas page
+	/// </summary>
+	void Manifest::AddPage(_In_ const Page& page)
+	{
+		_pages.push_back(page);
+	}
+
+	/// <summary>
+	/// add a named region, a duplicated name replaces the previous region
+	/// </summary>
+	void Manifest::AddRegion(_In_ const std::string& name, _In_ const Region& region)
+	{
+		if (_regions.count(name) == 0) _names.push_back(name);
+		_regions[name] = region;
+	}
+
+	/// <summary>
+	/// find a region by name
+	/// </summary>
+	const Region* Manifest::Find(_In_ const std::string& name) const
+	{
+		auto it = _regions.find(name);
+		return it != _regions.end() ? &it->second : nullptr;
+	}
+
+	/// <summary>
+	/// get the number of pages
+	/// </summary>
+	size_t Manifest::GetPageCount() const
+	{
+		return _pages.size();
+	}
+
+	/// <summary>
+	/// get a page
+	/// </summary>
+	const Page& Manifest::GetPage(_In_ size_t index) const
+	{
+		return _pages[index];
+	}
+
+	/// <summary>
+	/// get the number of regions
+	/// </summary>
+	size_t Manifest::GetRegionCount() const
+	{
+		return _regions.size();
+	}
+}
@@ -0,0 +1,79 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "portable_sal.h"
+
+namespace AtlasManifest
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	constexpr const char* FILE_HEADER = "# atlas manifest 1";
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// atlas page
+	/// </summary>
+	struct Page
+	{
+		std::string File;        // relative to the manifest
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	/// <summary>
+	/// where a named image lives in an atlas
+	/// </summary>
+	struct Region
+	{
+		uint32_t Atlas;
+		float Texcoord[2];       // top left in the atlas
+		float TexSize[2];        // size in the atlas (swapped when rotated)
+		uint32_t Width;          // source size in texels
+		uint32_t Height;
+		bool Rotated;            // stored 90 degrees clockwise
+	};
+
+	//--------------------------------------------------------
+	// manifest class
+	//--------------------------------------------------------
+	/// <summary>
+	/// text manifest, one tab separated record per line
+	///   page   file width height
+	///   region name atlas u v width height source-width source-height rotated
+	/// </summary>
+	class Manifest
+	{
+		std::vector<Page> _pages;
+		std::vector<std::string> _names;
+		std::unordered_map<std::string, Region> _regions;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		// returns 0 on success, -1 if the file cannot be opened, -2 on a malformed record
+		int Load(_In_ const std::string& path);
+		int Save(_In_ const std::string& path) const;
+		void Clear();
+
+		void AddPage(_In_ const Page& page);
+		void AddRegion(_In_ const std::string& name, _In_ const Region& region);
+
+		// returns nullptr if the name is unknown
+		const Region* Find(_In_ const std::string& name) const;
+
+		// getter
+		size_t GetPageCount() const;
+		const Page& GetPage(_In_ size_t index) const;
+		size_t GetRegionCount() const;
+	};
+}
@@ -0,0 +1,286 @@
+
+#include <algorithm>
+#include <numeric>
+
+#include "atlas_packer.h"
+
+namespace AtlasPacker
+{
+	//--------------------------------------------------------
+	// bin
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for MaxRects bin
+	/// </summary>
+	MaxRectsBin::MaxRectsBin()
+	{
+		_width  = 0;
+		_height = 0;
+		_usedWidth  = 0;
+		_usedHeight = 0;
+	}
+
+	/// <summary>
+	/// initialization process for MaxRects bin
+	/// </summary>
+	void MaxRectsBin::Initialize(_In_ uint32_t width, _In_ uint32_t height)
+	{
+		_width  = width;
+		_height = height;
+		_usedWidth  = 0;
+		_usedHeight = 0;
+
+		_freeRects.clear();
+		_freeRects.push_back({ 0, 0, width, height });
+	}
+
+	/// <summary>
+	/// insert a rectangle where its shorter leftover side is the smallest
+	/// </summary>
+	bool MaxRectsBin::Insert(_In_ uint32_t width, _In_ uint32_t height, _In_ bool allowRotation,
+		_Out_ uint32_t* x, _Out_ uint32_t* y, _Out_ bool* rotated)
+	{
+		uint32_t best_short = UINT32_MAX;
+		uint32_t best_long  = UINT32_MAX;
+		Rect best = {};
+		bool best_rotated = false;
+
+		for (const Rect& free_rect : _freeRects)
+		{
+			for (int r = 0; r < (allowRotation ? 2 : 1); ++r)
+			{
+				const uint32_t w = r ? height : width;
+				const uint32_t h = r ? width  : height;
+				if (w > free_rect.Width || h > free_rect.Height) continue;
+
+				const uint32_t leftover_x = free_rect.Width  - w;
+				const uint32_t leftover_y = free_rect.Height - h;
+				const uint32_t short_side = std::min(leftover_x, leftover_y);
+				const uint32_t long_side  = std::max(leftover_x, leftover_y);
+
+				if (short_side < best_short || (short_side == best_short && long_side < best_long))
+				{
+					best_short = short_side;
+					best_long  = long_side;
+					best = { free_rect.X, free_rect.Y, w, h };
+					best_rotated = (r == 1);
+				}
+			}
+		}
+
+		if (best_short == UINT32_MAX)
+			return false;
+
+		SplitFreeRects(best);
+		PruneFreeRects();
+
+		_usedWidth  = std::max(_usedWidth,  best.X + best.Width);
+		_usedHeight = std::max(_usedHeight, best.Y + best.Height);
+
+		*x = best.X;
+		*y = best.Y;
+		*rotated = best_rotated;
+
+		return true;
+	}
+
+	/// <summary>
+	/// split every free rectangle which overlaps the used one into up to four maximal rectangles
+	/// </summary>
+	void MaxRectsBin::SplitFreeRects(_In_ const Rect& used)
+	{
+		std::vector<Rect> split;
+
+		for (size_t i = 0; i < _freeRects.size();)
+		{
+			const Rect free_rect = _freeRects[i];
+
+			const bool is_overlapped =
+				used.X < free_rect.X + free_rect.Width  && used.X + used.Width  > free_rect.X &&
+				used.Y < free_rect.Y + free_rect.Height && used.Y + used.Height > free_rect.Y;
+			if (!is_overlapped)
+			{
+				++i;
+				continue;
+			}
+
+			// left, right, top and bottom of the used rectangle
+			if (used.X > free_rect.X)
+				split.push_back({ free_rect.X, free_rect.Y, used.X - free_rect.X, free_rect.Height });
+			if (used.X + used.Width < free_rect.X + free_rect.Width)
+				split.push_back({ used.X + used.Width, free_rect.Y, free_rect.X + free_rect.Width - (used.X + used.Width), free_rect.Height });
+			if (used.Y > free_rect.Y)
+				split.push_back({ free_rect.X, free_rect.Y, free_rect.Width, used.Y - free_rect.Y });
+			if (used.Y + used.Height < free_rect.Y + free_rect.Height)
+				split.push_back({ free_rect.X, used.Y + used.Height, free_rect.Width, free_rect.Y + free_rect.Height - (used.Y + used.Height) });
+
+			_freeRects[i] = _freeRects.back();
+			_freeRects.pop_back();
+		}
+
+		_freeRects.insert(_freeRects.end(), split.begin(), split.end());
+	}
+
+	/// <summary>
+	/// remove free rectangles contained in another one
+	/// </summary>
+	void MaxRectsBin::PruneFreeRects()
+	{
+		auto is_contained = [](const Rect& a, const Rect& b)
+		{
+			return a.X >= b.X && a.Y >= b.Y && a.X + a.Width <= b.X + b.Width && a.Y + a.Height <= b.Y + b.Height;
+		};
+
+		for (size_t i = 0; i < _freeRects.size(); ++i)
+		{
+			for (size_t j = i + 1; j < _freeRects.size();)
+			{
+				if (is_contained(_freeRects[i], _freeRects[j]))
+				{
+					_freeRects.erase(_freeRects.begin() + i);
+					--i;
+					break;
+				}
+				if (is_contained(_freeRects[j], _freeRects[i]))
+				{
+					_freeRects.erase(_freeRects.begin() + j);
+					continue;
+				}
+				++j;
+			}
+		}
+	}
+
+	/// <summary>
+	/// get the width of the used area
+	/// </summary>
+	uint32_t MaxRectsBin::GetUsedWidth() const
+	{
+		return _usedWidth;
+	}
+
+	/// <summary>
+	/// get the height of the used area
+	/// </summary>
+	uint32_t MaxRectsBin::GetUsedHeight() const
+	{
+		return _usedHeight;
+	}
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the default settings
+	/// </summary>
+	Settings GetDefaultSettings()
+	{
+		Settings settings;
+		settings.MaxWidth  = DEFAULT_MAX_SIZE;
+		settings.MaxHeight = DEFAULT_MAX_SIZE;
+		settings.Padding   = DEFAULT_PADDING;
+		settings.Extrude   = DEFAULT_EXTRUDE;
+		settings.AllowRotation = true;
+
+		return settings;
+	}
+
+	/// <summary>
+	/// pack images into atlases, the largest images first
+	/// </summary>
+	int Pack(_In_ const std::vector<AtlasSize>& images, _In_ const Settings& settings,
+		_Out_ std::vector<Placement>* placements, _Out_ std::vector<AtlasSize>* atlases)
+	{
+		placements->assign(images.size(), {});
+		atlases->clear();
+
+		// every image is surrounded by the extrusion, and followed by the padding
+		const uint32_t border = settings.Extrude * 2 + settings.Padding;
+
+		std::vector<size_t> order(images.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&images](size_t a, size_t b)
+		{
+			const uint64_t area_a = static_cast<uint64_t>(images[a].Width) * images[a].Height;
+			const uint64_t area_b = static_cast<uint64_t>(images[b].Width) * images[b].Height;
+			return area_a > area_b;
+		});
+
+		// the padding of the last column and row may lie outside the atlas
+		std::vector<MaxRectsBin> bins;
+		for (size_t index : order)
+		{
+			const uint32_t cell_width  = images[index].Width  + border;
+			const uint32_t cell_height = images[index].Height + border;
+
+			uint32_t x = 0, y = 0;
+			bool rotated = false;
+			size_t bin = 0;
+			for (; bin < bins.size(); ++bin)
+			{
+				if (bins[bin].Insert(cell_width, cell_height, settings.AllowRotation, &x, &y, &rotated)) break;
+			}
+
+			if (bin == bins.size())
+			{
+				bins.emplace_back();
+				bins.back().Initialize(settings.MaxWidth + settings.Padding, settings.MaxHeight + settings.Padding);
+				if (!bins.back().Insert(cell_width, cell_height, settings.AllowRotation, &x, &y, &rotated))
+					return -1;
+			}
+
+			Placement& placement = (*placements)[index];
+			placement.Atlas   = static_cast<uint32_t>(bin);
+			placement.X       = x + settings.Extrude;
+			placement.Y       = y + settings.Extrude;
+			placement.Width   = rotated ? images[index].Height : images[index].Width;
+			placement.Height  = rotated ? images[index].Width  : images[index].Height;
+			placement.Rotated = rotated;
+		}
+
+		for (const MaxRectsBin& bin : bins)
+		{
+			// multiples of 4 keep block compression possible
+			AtlasSize size;
+			size.Width  = (std::min(bin.GetUsedWidth(),  settings.MaxWidth)  + 3) & ~3u;
+			size.Height = (std::min(bin.GetUsedHeight(), settings.MaxHeight) + 3) & ~3u;
+			atlases->push_back(size);
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// copy an image into the atlas
+	/// a rotated image is turned 90 degrees clockwise, and the edge texels are repeated into the extrusion
+	/// </summary>
+	void Blit(_In_ const uint32_t* image, _In_ uint32_t imageWidth, _In_ uint32_t imageHeight,
+		_In_ const Placement& placement, _In_ uint32_t extrude,
+		_Inout_ uint32_t* atlas, _In_ uint32_t atlasWidth, _In_ uint32_t atlasHeight)
+	{
+		const int e = static_cast<int>(extrude);
+		const int w = static_cast<int>(placement.Width);
+		const int h = static_cast<int>(placement.Height);
+
+		for (int ay = -e; ay < h + e; ++ay)
+		{
+			const int py = static_cast<int>(placement.Y) + ay;
+			if (py < 0 || py >= static_cast<int>(atlasHeight)) continue;
+
+			const int cy = std::min(std::max(ay, 0), h - 1);
+			for (int ax = -e; ax < w + e; ++ax)
+			{
+				const int px = static_cast<int>(placement.X) + ax;
+				if (px < 0 || px >= static_cast<int>(atlasWidth)) continue;
+
+				const int cx = std::min(std::max(ax, 0), w - 1);
+
+				// atlas (cx, cy) of a clockwise rotation comes from source (cy, height - 1 - cx)
+				const int sx = placement.Rotated ? cy : cx;
+				const int sy = placement.Rotated ? static_cast<int>(imageHeight) - 1 - cx : cy;
+
+				atlas[static_cast<size_t>(py) * atlasWidth + px] = image[static_cast<size_t>(sy) * imageWidth + sx];
+			}
+		}
+	}
+}
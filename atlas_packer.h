@@ -0,0 +1,112 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "portable_sal.h"
+
+namespace AtlasPacker
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	constexpr uint32_t DEFAULT_MAX_SIZE = 2048;
+	constexpr uint32_t DEFAULT_PADDING  = 2;
+	constexpr uint32_t DEFAULT_EXTRUDE  = 1;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// packing settings
+	/// </summary>
+	struct Settings
+	{
+		uint32_t MaxWidth;
+		uint32_t MaxHeight;
+		uint32_t Padding;        // empty texels between two images
+		uint32_t Extrude;        // border texels repeated around an image against bleeding
+		bool AllowRotation;      // images may be stored rotated 90 degrees clockwise
+	};
+
+	/// <summary>
+	/// where an image was placed
+	/// </summary>
+	struct Placement
+	{
+		uint32_t Atlas;
+		uint32_t X;              // top left of the image texels (without the extrusion)
+		uint32_t Y;
+		uint32_t Width;          // size in the atlas (swapped when rotated)
+		uint32_t Height;
+		bool Rotated;
+	};
+
+	/// <summary>
+	/// size of an atlas page trimmed to the used area
+	/// </summary>
+	struct AtlasSize
+	{
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	//--------------------------------------------------------
+	// bin class
+	//--------------------------------------------------------
+	/// <summary>
+	/// MaxRects bin with the best short side fit heuristic
+	/// </summary>
+	class MaxRectsBin
+	{
+		struct Rect
+		{
+			uint32_t X, Y, Width, Height;
+		};
+
+		uint32_t _width;
+		uint32_t _height;
+		std::vector<Rect> _freeRects;
+		uint32_t _usedWidth;
+		uint32_t _usedHeight;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void SplitFreeRects(_In_ const Rect& used);
+		void PruneFreeRects();
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		MaxRectsBin();
+
+		void Initialize(_In_ uint32_t width, _In_ uint32_t height);
+
+		// returns false if the rectangle does not fit
+		bool Insert(_In_ uint32_t width, _In_ uint32_t height, _In_ bool allowRotation,
+			_Out_ uint32_t* x, _Out_ uint32_t* y, _Out_ bool* rotated);
+
+		// getter
+		uint32_t GetUsedWidth() const;
+		uint32_t GetUsedHeight() const;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	Settings GetDefaultSettings();
+
+	// pack images (width, height pairs) into as few atlases as possible
+	// returns 0 on success, -1 when an image is larger than an atlas
+	int Pack(_In_ const std::vector<AtlasSize>& images, _In_ const Settings& settings,
+		_Out_ std::vector<Placement>* placements, _Out_ std::vector<AtlasSize>* atlases);
+
+	// copy an RGBA8 image into its place with the extrusion
+	void Blit(_In_ const uint32_t* image, _In_ uint32_t imageWidth, _In_ uint32_t imageHeight,
+		_In_ const Placement& placement, _In_ uint32_t extrude,
+		_Inout_ uint32_t* atlas, _In_ uint32_t atlasWidth, _In_ uint32_t atlasHeight);
+}
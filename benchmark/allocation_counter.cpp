@@ -0,0 +1,126 @@
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "benchmark.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		// the size of an allocation is kept in front of it, without breaking the alignment of malloc
+		constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+
+		// every heap allocation of the process is counted
+		std::atomic<uint64_t> s_allocationCount(0);
+		std::atomic<uint64_t> s_allocatedBytes(0);
+		std::atomic<uint64_t> s_liveBytes(0);
+		std::atomic<uint64_t> s_peakBytes(0);
+
+		/// <summary>
+		/// allocate and count
+		/// </summary>
+		void* CountedAllocate(size_t size)
+		{
+			s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+			s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+			uint8_t* p = static_cast<uint8_t*>(std::malloc(size + HEADER_SIZE));
+			if (!p) throw std::bad_alloc();
+			*reinterpret_cast<size_t*>(p) = size;
+
+			const uint64_t live = s_liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			uint64_t peak = s_peakBytes.load(std::memory_order_relaxed);
+			while (live > peak && !s_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+			return p + HEADER_SIZE;
+		}
+
+		/// <summary>
+		/// free and count
+		/// </summary>
+		void CountedFree(void* p)
+		{
+			if (!p) return;
+
+			uint8_t* p_base = static_cast<uint8_t*>(p) - HEADER_SIZE;
+			s_liveBytes.fetch_sub(*reinterpret_cast<size_t*>(p_base), std::memory_order_relaxed);
+			std::free(p_base);
+		}
+	}
+
+	/// <summary>
+	/// get the number of heap allocations since the start
+	/// </summary>
+	uint64_t GetAllocationCount()
+	{
+		return s_allocationCount.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// get the bytes of heap allocations since the start
+	/// </summary>
+	uint64_t GetAllocatedBytes()
+	{
+		return s_allocatedBytes.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// get the bytes of the heap allocations not freed yet
+	/// </summary>
+	uint64_t GetLiveBytes()
+	{
+		return s_liveBytes.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// get the largest live bytes since the last reset
+	/// </summary>
+	uint64_t GetPeakBytes()
+	{
+		return s_peakBytes.load(std::memory_order_relaxed);
+	}
+
+	/// <summary>
+	/// start measuring the peak from the live bytes
+	/// </summary>
+	void ResetPeakBytes()
+	{
+		s_peakBytes.store(s_liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+}
+
+//--------------------------------------------------------
+// replaced global allocation functions
+//--------------------------------------------------------
+void* operator new(size_t size)
+{
+	return Benchmark::CountedAllocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return Benchmark::CountedAllocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	Benchmark::CountedFree(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	Benchmark::CountedFree(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	Benchmark::CountedFree(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	Benchmark::CountedFree(p);
+}
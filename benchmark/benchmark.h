@@ -0,0 +1,89 @@
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace Benchmark
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// every measurement is repeated and the fastest run is reported
+	constexpr int DEFAULT_REPEAT_COUNT = 5;
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// measure the fastest run of a function in nanoseconds
+	/// </summary>
+	template <typename Func>
+	double MeasureNanoseconds(Func&& func, int repeat = DEFAULT_REPEAT_COUNT)
+	{
+		double best = 0.0;
+
+		for (int r = 0; r < repeat; ++r)
+		{
+			auto begin = std::chrono::steady_clock::now();
+			func();
+			auto end = std::chrono::steady_clock::now();
+
+			double elapsed = std::chrono::duration<double, std::nano>(end - begin).count();
+			if (r == 0 || elapsed < best) best = elapsed;
+		}
+
+		return best;
+	}
+
+	// written by DoNotOptimize so results are observable
+	inline const void* volatile g_sink = nullptr;
+
+	/// <summary>
+	/// keep the optimizer from removing a result
+	/// </summary>
+	inline void DoNotOptimize(const void* p)
+	{
+		g_sink = p;
+	}
+
+	// set by a scenario whose result does not match, the benchmark then exits with an error
+	inline bool g_isFailed = false;
+
+	/// <summary>
+	/// fail the benchmark, the remaining scenarios still run
+	/// </summary>
+	inline void ReportFailure()
+	{
+		g_isFailed = true;
+	}
+
+	// heap allocations of the process (counted by the replaced operator new)
+	uint64_t GetAllocationCount();
+	uint64_t GetAllocatedBytes();
+
+	// live heap bytes, and their peak since ResetPeakBytes (a measurement on one thread)
+	uint64_t GetLiveBytes();
+	uint64_t GetPeakBytes();
+	void ResetPeakBytes();
+
+	// benchmarks
+	void RunQuadKernel();
+	void RunCommandBuffer();
+	void RunTextureContainer();
+	void RunFrameScheduler();
+	void RunProfiler();
+	void RunSpriteThroughput();
+	void RunSpriteRegistry();
+	void RunSpriteGrid();
+	void RunSortKey();
+	void RunStaticGeometry();
+	void RunSpriteInstance();
+	void RunShaderCache();
+	void RunShaderPermutation();
+	void RunMaterialTable();
+	void RunTextureImport();
+	void RunPngDecode();
+	void RunPremultipliedAlpha();
+}
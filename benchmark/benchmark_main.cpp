@@ -0,0 +1,38 @@
+
+#include <cstdio>
+
+#include "benchmark.h"
+
+/// <summary>
+/// main func of the benchmark
+/// </summary>
+int main()
+{
+	std::printf("DrawImageInDirectX11 benchmark\n\n");
+
+	Benchmark::RunQuadKernel();
+	Benchmark::RunCommandBuffer();
+	Benchmark::RunTextureContainer();
+	Benchmark::RunFrameScheduler();
+	Benchmark::RunProfiler();
+	Benchmark::RunSpriteThroughput();
+	Benchmark::RunSpriteRegistry();
+	Benchmark::RunSpriteGrid();
+	Benchmark::RunSortKey();
+	Benchmark::RunStaticGeometry();
+	Benchmark::RunSpriteInstance();
+	Benchmark::RunShaderCache();
+	Benchmark::RunShaderPermutation();
+	Benchmark::RunMaterialTable();
+	Benchmark::RunTextureImport();
+	Benchmark::RunPngDecode();
+	Benchmark::RunPremultipliedAlpha();
+
+	if (Benchmark::g_isFailed)
+	{
+		std::printf("FAILED\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,74 @@
+
+#include <cstdio>
+
+#include "benchmark.h"
+#include "../command_buffer.h"
+#include "../thread_pool.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		/// <summary>
+		/// record the draws of a range like a scene would (bind, texture, constants, draw)
+		/// </summary>
+		void RecordDraws(CommandBuffer::Buffer& buffer, size_t first, size_t count)
+		{
+			float constants[16] = {};
+			for (size_t i = first; i < first + count; ++i)
+			{
+				constants[0] = static_cast<float>(i);
+
+				buffer.BindPipelineState(static_cast<PipelineState::Handle>(i % 4));
+				buffer.SetTexture(0, static_cast<PipelineState::ObjectId>(i % 16 + 1));
+				buffer.UpdateBuffer(1, constants, sizeof(constants));
+				buffer.DrawIndexed(6, 0, static_cast<int32_t>(i * 4));
+			}
+		}
+	}
+
+	/// <summary>
+	/// compare recording draws on one thread with recording on every core
+	/// </summary>
+	void RunCommandBuffer()
+	{
+		ThreadPool::Manager::Instance().Initialize();
+		const size_t thread_count = ThreadPool::Manager::Instance().GetWorkerCount() + 1;
+
+		std::printf("[command buffer] threads: %zu\n", thread_count);
+		std::printf("%10s %14s %14s %14s %12s\n", "draws", "record 1 task", "record N task", "replay", "bytes");
+
+		CommandBuffer::Manager& manager = CommandBuffer::Manager::Instance();
+
+		const size_t draw_counts[] = { 10000, 50000, 200000 };
+		for (size_t draws : draw_counts)
+		{
+			// one task per thread, each recording a contiguous range
+			auto record = [&](size_t tasks)
+			{
+				manager.BeginFrame();
+				manager.Record(tasks, [draws, tasks](CommandBuffer::Buffer& buffer, size_t task)
+				{
+					size_t first = draws * task / tasks;
+					size_t last  = draws * (task + 1) / tasks;
+					RecordDraws(buffer, first, last - first);
+				});
+			};
+
+			double ns_single = MeasureNanoseconds([&]() { record(1); });
+			double ns_multi  = MeasureNanoseconds([&]() { record(thread_count); });
+
+			CommandBuffer::NullBackend backend;
+			double ns_replay = MeasureNanoseconds([&]() { manager.Submit(backend); });
+			manager.EndFrame();
+
+			DoNotOptimize(backend.Commands);
+			std::printf("%10zu %11.2f ns %11.2f ns %11.2f ns %12zu\n", draws,
+				ns_single / draws, ns_multi / draws, ns_replay / draws,
+				manager.GetLastFrameStats().Bytes / DEFAULT_REPEAT_COUNT);
+		}
+
+		manager.Terminate();
+		std::printf("\n");
+	}
+}
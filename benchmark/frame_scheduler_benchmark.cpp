@@ -0,0 +1,173 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "benchmark.h"
+#include "../frame_scheduler.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		// ten seconds of 120 Hz frames
+		constexpr uint32_t FRAME_COUNT = 1200;
+
+		// one spin of the manual clock, the granularity of the deadlines
+		constexpr int64_t SPIN_NS = 1000;
+
+		// work of a frame, drawn at random in [MIN_WORK_NS, MAX_WORK_NS]
+		constexpr int64_t MIN_WORK_NS = 1000000;
+		constexpr int64_t MAX_WORK_NS = 5000000;
+
+		/// <summary>
+		/// timing of the frames a scheduler is driven through
+		/// </summary>
+		struct Sequence
+		{
+			const char* Name;
+			int64_t OversleepNs;  // late wake-ups of the os sleep
+			int64_t WorkNs;       // fixed work of every frame, 0 for the random work
+			uint32_t HitchFrame;  // frame stalled by HitchNs, FRAME_COUNT for none
+			int64_t HitchNs;
+		};
+
+		/// <summary>
+		/// result of a sequence
+		/// </summary>
+		struct Result
+		{
+			uint32_t Steps;
+			uint32_t DroppedSteps;
+			int64_t MaxLatenessNs;   // from the deadline of the frames which waited
+			FrameScheduler::FrameStats Stats;  // the first second
+			bool IsMatch;
+		};
+
+		/// <summary>
+		/// drive a scheduler with a manual clock, and check every frame against the expected pacing and steps
+		/// </summary>
+		Result RunSequence(const Sequence& sequence)
+		{
+			const FrameScheduler::Settings settings = FrameScheduler::GetDefaultSettings();
+
+			FrameScheduler::ManualClock clock(sequence.OversleepNs, SPIN_NS);
+			FrameScheduler::Scheduler scheduler;
+			scheduler.Initialize(&clock, settings);
+
+			// a frame waiting for its deadline is late by the oversleep beyond the spun part, and less than a spin
+			const int64_t max_lateness = std::max<int64_t>(sequence.OversleepNs - settings.SpinThresholdNs, 0) + SPIN_NS;
+
+			std::mt19937 random(7);
+			std::uniform_int_distribution<int64_t> work(MIN_WORK_NS, MAX_WORK_NS);
+
+			Result result = {};
+			result.IsMatch = true;
+
+			int64_t deadline    = 0;
+			int64_t accumulator = 0;
+			int64_t last_begin  = 0;
+			int64_t work_end    = 0;
+			uint32_t window_steps   = 0;
+			uint32_t window_dropped = 0;
+			bool is_window_checked = false;
+
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				scheduler.WaitForNextFrame();
+				const int64_t begin = clock.GetNanoseconds();
+				const uint32_t steps = scheduler.BeginFrame();
+
+				// pacing: on the grid of the period while the frames fit it, right away after an overrun
+				if (work_end <= deadline)
+				{
+					const int64_t lateness = begin - deadline;
+					result.MaxLatenessNs = std::max(result.MaxLatenessNs, lateness);
+					if (lateness < 0 || lateness >= max_lateness) result.IsMatch = false;
+				}
+				else if (begin != work_end)
+				{
+					result.IsMatch = false;
+				}
+
+				// no frames are drawn in a burst to catch up
+				if (frame > 0 && begin - last_begin < settings.FramePeriodNs - SPIN_NS) result.IsMatch = false;
+
+				deadline += settings.FramePeriodNs;
+				if (deadline <= begin) deadline = begin + settings.FramePeriodNs;
+
+				// fixed steps of the elapsed time, the ones beyond the limit are dropped
+				if (frame > 0) accumulator += begin - last_begin;
+				last_begin = begin;
+
+				uint32_t expected_steps = static_cast<uint32_t>(accumulator / settings.FixedStepNs);
+				accumulator -= static_cast<int64_t>(expected_steps) * settings.FixedStepNs;
+				const uint32_t dropped = expected_steps > settings.MaxStepsPerFrame ? expected_steps - settings.MaxStepsPerFrame : 0;
+				expected_steps -= dropped;
+
+				const double expected_interpolation = static_cast<double>(accumulator) / static_cast<double>(settings.FixedStepNs);
+				if (steps != expected_steps || std::fabs(scheduler.GetInterpolation() - expected_interpolation) > 1e-6) result.IsMatch = false;
+
+				// the statistics of the first second are published by the first frame after it, before its own steps
+				const FrameScheduler::FrameStats& stats = scheduler.GetLastFrameStats();
+				if (!is_window_checked && stats.Frames != 0)
+				{
+					is_window_checked = true;
+					result.Stats = stats;
+					if (stats.Frames != frame || stats.Steps != window_steps || stats.DroppedSteps != window_dropped) result.IsMatch = false;
+				}
+				window_steps   += steps;
+				window_dropped += dropped;
+
+				result.Steps        += steps;
+				result.DroppedSteps += dropped;
+
+				// the work of the frame
+				clock.Advance(sequence.WorkNs ? sequence.WorkNs : work(random));
+				if (frame == sequence.HitchFrame) clock.Advance(sequence.HitchNs);
+				work_end = clock.GetNanoseconds();
+			}
+
+			if (!is_window_checked) result.IsMatch = false;
+
+			return result;
+		}
+	}
+
+	/// <summary>
+	/// pace frames with a manual clock through normal, hitched and drifting sequences
+	/// every frame is checked for its deadline and its fixed steps, so the result does not depend on the machine
+	/// </summary>
+	void RunFrameScheduler()
+	{
+		const FrameScheduler::Settings settings = FrameScheduler::GetDefaultSettings();
+		const int64_t period = settings.FramePeriodNs;
+
+		const Sequence sequences[] =
+		{
+			{ "normal",                      500000, 0,                  FRAME_COUNT, 0 },
+			{ "hitch of 100 ms",             500000, 0,                  60,          100000000 },
+			{ "oversleep past the spin",    3000000, 0,                  FRAME_COUNT, 0 },
+			{ "frames longer than a period", 500000, period * 3 / 2,     FRAME_COUNT, 0 },
+		};
+
+		std::printf("[frame scheduler] %u frames at %.1f Hz, steps at %.1f Hz, at most %u per frame, %lld ns spins\n",
+			FRAME_COUNT, 1e9 / period, 1e9 / settings.FixedStepNs, settings.MaxStepsPerFrame, static_cast<long long>(SPIN_NS));
+		std::printf("%-30s %8s %8s %12s %10s %10s %10s %8s\n", "sequence", "steps", "dropped", "late ms", "frame ms", "jitter ms", "max ms", "result");
+
+		bool is_all_match = true;
+		for (const Sequence& sequence : sequences)
+		{
+			const Result result = RunSequence(sequence);
+			is_all_match = is_all_match && result.IsMatch;
+
+			std::printf("%-30s %8u %8u %12.4f %10.4f %10.4f %10.4f %8s\n", sequence.Name, result.Steps, result.DroppedSteps,
+				static_cast<double>(result.MaxLatenessNs) * 1e-6, result.Stats.AverageFrameMs, result.Stats.JitterMs, result.Stats.MaxFrameMs,
+				result.IsMatch ? "ok" : "MISMATCH");
+		}
+
+		std::printf("result: %s\n\n", is_all_match ? "ok" : "MISMATCH");
+		if (!is_all_match) ReportFailure();
+	}
+}
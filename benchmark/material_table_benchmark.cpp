@@ -0,0 +1,179 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "../material_table.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		// materials requested by the scene, most of them equal to another one
+		constexpr uint32_t REGISTRATION_COUNT = 10000;
+		constexpr uint32_t DISTINCT_COUNT     = 256;
+
+		/// <summary>
+		/// gpu table in memory, counting the uploads
+		/// </summary>
+		class CountingBackend : public MaterialTable::Backend
+		{
+			std::vector<MaterialTable::Constants> _table;
+			std::vector<std::pair<MaterialTable::Index, uint32_t>> _uploads;
+
+		public:
+			explicit CountingBackend(uint32_t capacity) : _table(capacity) {}
+
+			void UploadMaterials(const MaterialTable::Constants* p_constants, MaterialTable::Index first, uint32_t count) override
+			{
+				std::copy(p_constants, p_constants + count, _table.begin() + first);
+				_uploads.emplace_back(first, count);
+			}
+
+			/// <summary>
+			/// get the uploads since the last call, as ranges of slots
+			/// </summary>
+			std::vector<std::pair<MaterialTable::Index, uint32_t>> TakeUploads()
+			{
+				std::vector<std::pair<MaterialTable::Index, uint32_t>> uploads;
+				uploads.swap(_uploads);
+				return uploads;
+			}
+
+			const MaterialTable::Constants& GetSlot(MaterialTable::Index index) const { return _table[index]; }
+		};
+
+		/// <summary>
+		/// one of the distinct materials of the scene
+		/// </summary>
+		MaterialTable::Constants CreateMaterial(uint32_t id)
+		{
+			MaterialTable::Constants constants = MaterialTable::Table::GetDefaultConstants();
+			constants.Diffuse[0]     = static_cast<float>(id % 16) / 16.0f;
+			constants.Diffuse[1]     = static_cast<float>(id / 16) / 16.0f;
+			constants.AlphaThreshold = 0.5f;
+
+			return constants;
+		}
+	}
+
+	/// <summary>
+	/// register the materials of a scene with many duplicates, then check what each frame uploads
+	/// a frame without edits must upload nothing, and an edit only its own slot
+	/// </summary>
+	void RunMaterialTable()
+	{
+		std::printf("[material table] %u registrations of %u distinct materials, %zu bytes per slot\n",
+			REGISTRATION_COUNT, DISTINCT_COUNT, sizeof(MaterialTable::Constants));
+		std::printf("%-34s %10s %10s %10s %8s\n", "frame", "calls", "slots", "bytes", "result");
+
+		CountingBackend backend(MaterialTable::DEFAULT_CAPACITY);
+		MaterialTable::Table table;
+		table.Initialize(&backend);
+		backend.TakeUploads();
+
+		// the duplicates share a slot
+		std::mt19937 random(12345);
+		std::uniform_int_distribution<uint32_t> pick(0, DISTINCT_COUNT - 1);
+		std::vector<MaterialTable::Index> indices(REGISTRATION_COUNT);
+		double ns = MeasureNanoseconds([&]()
+		{
+			for (uint32_t i = 0; i < REGISTRATION_COUNT; ++i)
+			{
+				const uint32_t id = pick(random);
+				indices[i] = table.Register(CreateMaterial(id), ShaderPermutation::FEATURE_TEXTURED | ShaderPermutation::FEATURE_TINT);
+			}
+		}, 1);
+		const MaterialTable::FrameStats register_stats = table.GetFrameStats();
+
+		bool is_all_match = true;
+		auto check = [&](const char* frame, uint32_t expected_calls, uint32_t expected_slots)
+		{
+			table.Flush();
+			const MaterialTable::FrameStats& stats = table.GetLastFrameStats();
+			const bool is_match = stats.UploadCalls == expected_calls && stats.UploadedSlots == expected_slots &&
+				backend.TakeUploads().size() == expected_calls;
+			is_all_match = is_all_match && is_match;
+
+			std::printf("%-34s %10u %10u %10llu %8s\n", frame, stats.UploadCalls, stats.UploadedSlots,
+				static_cast<unsigned long long>(stats.UploadBytes), is_match ? "ok" : "MISMATCH");
+		};
+
+		// the default material and the distinct ones are neighbours, so one call writes them all
+		const uint32_t live = table.GetCount();
+		check("first frame", 1, live);
+		check("steady frame", 0, 0);
+
+		// an edit of a shared slot moves the registration to a copy, the other registrations keep the material
+		MaterialTable::Index copied = indices[0];
+		MaterialTable::Constants edited = table.GetConstants(indices[0]);
+		edited.Diffuse[3] = 0.25f;
+		table.Update(&copied, edited, table.GetFeatures(indices[0]));
+		check("shared material edited", 1, 1);
+		bool is_copied = copied != indices[0] && table.GetConstants(indices[0]).Diffuse[3] == 1.0f;
+
+		// the only registration of a slot is edited in place, a new variant is recorded for the geometry baked with it
+		MaterialTable::Index sole = copied;
+		edited.Diffuse[3] = 0.5f;
+		table.Update(&sole, edited, ShaderPermutation::DEFAULT_KEY);
+		check("sole material edited", 1, 1);
+		is_copied = is_copied && sole == copied && table.GetFeaturesRevision(sole) == table.GetFeaturesRevision() &&
+			table.GetFeaturesRevision(indices[0]) == 0;
+
+		// neighbouring edits are uploaded together, the others on their own
+		// one registration of each edited material is kept, so they are edited in place
+		const MaterialTable::Index neighbours[] = { 10, 11, 12, 40, 200 };
+		std::vector<uint8_t> is_kept(table.GetCapacity(), 0);
+		for (MaterialTable::Index& index : indices)
+		{
+			if (std::find(std::begin(neighbours), std::end(neighbours), index) == std::end(neighbours)) continue;
+
+			if (!is_kept[index])
+			{
+				is_kept[index] = 1;
+				continue;
+			}
+
+			table.Release(index);
+			index = MaterialTable::INVALID_INDEX;
+		}
+		for (MaterialTable::Index index : neighbours)
+		{
+			MaterialTable::Index updated = index;
+			edited = table.GetConstants(index);
+			edited.Emission[0] = 1.0f;
+			table.Update(&updated, edited, table.GetFeatures(index));
+			is_copied = is_copied && updated == index;
+		}
+		check("five edits in three ranges", 3, 5);
+
+		// an edit with the same contents is not uploaded
+		table.Update(&indices[0], table.GetConstants(indices[0]), table.GetFeatures(indices[0]));
+		check("edit without a change", 0, 0);
+
+		// a released slot is reused by the next new material
+		const MaterialTable::Index single = table.Register(CreateMaterial(DISTINCT_COUNT), ShaderPermutation::DEFAULT_KEY);
+		check("new material", 1, 1);
+		table.Release(single);
+		const MaterialTable::Index reused = table.Register(CreateMaterial(DISTINCT_COUNT + 1), ShaderPermutation::DEFAULT_KEY);
+		check("released slot reused", 1, 1);
+
+		// the copy of the shared material and the new one
+		const bool is_reused = reused == single && table.GetCount() == live + 2;
+		const bool is_resident = std::memcmp(&backend.GetSlot(reused), &table.GetConstants(reused), sizeof(MaterialTable::Constants)) == 0;
+		is_all_match = is_all_match && is_copied && is_reused && is_resident;
+
+		std::printf("slots: %u of %u, deduplicated: %u (%.1f%%), %.1f ns per registration, copy on write: %s, reuse: %s, result: %s\n\n",
+			table.GetCount(), table.GetCapacity(), register_stats.Deduplicated,
+			100.0 * register_stats.Deduplicated / register_stats.Registrations, ns / REGISTRATION_COUNT,
+			is_copied ? "ok" : "MISMATCH", is_reused ? "ok" : "MISMATCH", is_all_match ? "ok" : "MISMATCH");
+
+		if (!is_all_match) ReportFailure();
+
+		table.Terminate();
+	}
+}
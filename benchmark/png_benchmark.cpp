@@ -0,0 +1,1058 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "../png_decoder.h"
+#include "../thread_pool.h"
+
+#ifdef BENCHMARK_WITH_LIBPNG
+#include <csetjmp>
+#include <png.h>
+#endif
+
+namespace Benchmark
+{
+	namespace
+	{
+		// the checked images are odd sizes, so rows end inside a byte and the Adam7 passes are partial
+		constexpr uint32_t CHECK_WIDTH  = 61;
+		constexpr uint32_t CHECK_HEIGHT = 37;
+
+		constexpr uint32_t LARGE_SIZE = 2048;
+
+		// files decoded one after another and across the thread pool
+		constexpr uint32_t FILE_COUNT = 64;
+		constexpr uint32_t FILE_SIZE  = 256;
+
+		constexpr const char* SAMPLE_PATH = "resource/texture/test.png";
+
+		// IDAT chunks of the checked images split the stream at odd places, the others are as libpng writes them
+		constexpr size_t CHECK_CHUNK_SIZE = 97;
+		constexpr size_t CHUNK_SIZE       = 8192;
+
+		// filter modes beyond the 5 filter types: row y uses filter y % 5, or the one with the smallest sum as encoders choose
+		constexpr uint32_t FILTER_CYCLE    = 5;
+		constexpr uint32_t FILTER_ADAPTIVE = 6;
+
+		// the encoder: greedy matches over a hash chain, and a new Huffman code every block
+		constexpr uint32_t HASH_BITS    = 15;
+		constexpr uint32_t WINDOW_SIZE  = 32768;
+		constexpr uint32_t MAX_CHAIN    = 16;
+		constexpr uint32_t MIN_MATCH    = 3;
+		constexpr uint32_t MAX_MATCH    = 258;
+		constexpr size_t BLOCK_TOKENS   = 16384;
+
+		constexpr uint16_t LENGTH_BASE[29] =
+		{
+			3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+		};
+		constexpr uint8_t LENGTH_EXTRA[29] =
+		{
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+		};
+		constexpr uint16_t DISTANCE_BASE[30] =
+		{
+			1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+		};
+		constexpr uint8_t DISTANCE_EXTRA[30] =
+		{
+			0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+		};
+		constexpr uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+		constexpr uint32_t ADAM7[7][4] =
+		{
+			{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 },
+		};
+
+		/// <summary>
+		/// deflate block types the encoder writes
+		/// </summary>
+		enum class Compression
+		{
+			Stored,
+			Fixed,
+			Dynamic,
+		};
+
+		/// <summary>
+		/// samples of an image as the file holds them, and the texels a decoder must return
+		/// </summary>
+		struct Source
+		{
+			uint32_t Width;
+			uint32_t Height;
+			PngDecoder::ColorType Color;
+			uint8_t BitDepth;
+			std::vector<uint8_t> Samples;        // packed rows without their filter byte
+			std::vector<uint8_t> Palette;        // PLTE
+			std::vector<uint8_t> Transparency;   // tRNS
+			std::vector<uint8_t> Expected;       // RGBA8
+		};
+
+		/// <summary>
+		/// match or literal found by the encoder
+		/// </summary>
+		struct Token
+		{
+			uint16_t Length;                     // 0 for a literal
+			uint16_t Value;                      // the literal, or the distance of the match
+		};
+
+		//--------------------------------------------------------
+		// encoder
+		//--------------------------------------------------------
+		/// <summary>
+		/// deflate bits, from the lowest bit of each byte
+		/// </summary>
+		class BitWriter
+		{
+			std::vector<uint8_t>* _out;
+			uint64_t _bits;
+			uint32_t _count;
+
+		public:
+			explicit BitWriter(std::vector<uint8_t>* out) : _out(out), _bits(0), _count(0) {}
+
+			void Write(uint32_t value, uint32_t count)
+			{
+				_bits  |= static_cast<uint64_t>(value) << _count;
+				_count += count;
+				for (; _count >= 8; _count -= 8, _bits >>= 8) _out->push_back(static_cast<uint8_t>(_bits));
+			}
+
+			// a Huffman code goes from its highest bit
+			void WriteCode(uint32_t code, uint32_t length)
+			{
+				uint32_t reversed = 0;
+				for (uint32_t i = 0; i < length; ++i) reversed |= ((code >> (length - 1 - i)) & 1) << i;
+				Write(reversed, length);
+			}
+
+			void Align()
+			{
+				if (_count) Write(0, 8 - _count);
+			}
+		};
+
+		/// <summary>
+		/// CRC-32 of the bytes, bit by bit (the decoder has its own)
+		/// </summary>
+		uint32_t ComputeCrc(const uint8_t* p, size_t size)
+		{
+			uint32_t crc = 0xffffffffu;
+			for (size_t i = 0; i < size; ++i)
+			{
+				crc ^= p[i];
+				for (int bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+			}
+
+			return crc ^ 0xffffffffu;
+		}
+
+		/// <summary>
+		/// append a big endian 32-bit value
+		/// </summary>
+		void AppendBe32(std::vector<uint8_t>* p_out, uint32_t value)
+		{
+			for (int shift = 24; shift >= 0; shift -= 8) p_out->push_back(static_cast<uint8_t>(value >> shift));
+		}
+
+		/// <summary>
+		/// Huffman code lengths of the frequencies, halved until the longest code fits the limit
+		/// </summary>
+		std::vector<uint8_t> BuildLengths(std::vector<uint32_t> frequencies, uint32_t limit)
+		{
+			std::vector<uint8_t> lengths(frequencies.size(), 0);
+
+			for (;;)
+			{
+				using Node = std::pair<uint64_t, int>;
+				std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+				std::vector<int> parents, symbols;
+				for (size_t i = 0; i < frequencies.size(); ++i)
+				{
+					if (!frequencies[i]) continue;
+					queue.push({ frequencies[i], static_cast<int>(parents.size()) });
+					parents.push_back(-1);
+					symbols.push_back(static_cast<int>(i));
+				}
+
+				// a single symbol still needs a code of one bit
+				if (symbols.size() <= 1)
+				{
+					if (!symbols.empty()) lengths[symbols[0]] = 1;
+					return lengths;
+				}
+
+				while (queue.size() > 1)
+				{
+					const Node a = queue.top(); queue.pop();
+					const Node b = queue.top(); queue.pop();
+					const int node = static_cast<int>(parents.size());
+					parents.push_back(-1);
+					parents[a.second] = parents[b.second] = node;
+					queue.push({ a.first + b.first, node });
+				}
+
+				uint32_t longest = 0;
+				for (size_t leaf = 0; leaf < symbols.size(); ++leaf)
+				{
+					uint32_t depth = 0;
+					for (int node = static_cast<int>(leaf); parents[node] >= 0; node = parents[node]) ++depth;
+					lengths[symbols[leaf]] = static_cast<uint8_t>(depth);
+					longest = std::max(longest, depth);
+				}
+				if (longest <= limit)
+					return lengths;
+
+				for (uint32_t& frequency : frequencies) frequency = (frequency + 1) / 2;
+			}
+		}
+
+		/// <summary>
+		/// canonical codes of the lengths
+		/// </summary>
+		std::vector<uint32_t> AssignCodes(const std::vector<uint8_t>& lengths)
+		{
+			uint32_t counts[16] = {}, next_code[16] = {};
+			for (uint8_t length : lengths) counts[length]++;
+			counts[0] = 0;
+			for (int length = 1; length < 16; ++length) next_code[length] = (next_code[length - 1] + counts[length - 1]) << 1;
+
+			std::vector<uint32_t> codes(lengths.size(), 0);
+			for (size_t i = 0; i < lengths.size(); ++i)
+			{
+				if (lengths[i]) codes[i] = next_code[lengths[i]]++;
+			}
+
+			return codes;
+		}
+
+		/// <summary>
+		/// greedy LZ77 over a hash chain of the last 32k
+		/// </summary>
+		std::vector<Token> FindMatches(const std::vector<uint8_t>& data)
+		{
+			const size_t size = data.size();
+			std::vector<int32_t> heads(static_cast<size_t>(1) << HASH_BITS, -1);
+			std::vector<int32_t> previous(WINDOW_SIZE, -1);
+
+			auto insert = [&](size_t position)
+			{
+				if (position + MIN_MATCH > size) return;
+				const uint32_t hash = ((data[position] << 10) ^ (data[position + 1] << 5) ^ data[position + 2]) & ((1u << HASH_BITS) - 1);
+				previous[position & (WINDOW_SIZE - 1)] = heads[hash];
+				heads[hash] = static_cast<int32_t>(position);
+			};
+
+			std::vector<Token> tokens;
+			tokens.reserve(size / 2);
+			for (size_t i = 0; i < size;)
+			{
+				uint32_t best_length = 0, best_distance = 0;
+				if (i + MIN_MATCH <= size)
+				{
+					const uint32_t hash = ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & ((1u << HASH_BITS) - 1);
+					const size_t limit = std::min(static_cast<size_t>(MAX_MATCH), size - i);
+
+					int32_t candidate = heads[hash];
+					for (uint32_t chain = 0; candidate >= 0 && chain < MAX_CHAIN && i - candidate <= WINDOW_SIZE; ++chain)
+					{
+						uint32_t length = 0;
+						while (length < limit && data[candidate + length] == data[i + length]) ++length;
+						if (length > best_length)
+						{
+							best_length   = length;
+							best_distance = static_cast<uint32_t>(i - candidate);
+							if (length == limit) break;
+						}
+
+						// a slot of the ring may hold a newer position
+						const int32_t next = previous[candidate & (WINDOW_SIZE - 1)];
+						if (next >= candidate) break;
+						candidate = next;
+					}
+				}
+
+				if (best_length >= MIN_MATCH)
+				{
+					tokens.push_back({ static_cast<uint16_t>(best_length), static_cast<uint16_t>(best_distance) });
+					for (uint32_t k = 0; k < best_length; ++k) insert(i + k);
+					i += best_length;
+				}
+				else
+				{
+					tokens.push_back({ 0, data[i] });
+					insert(i);
+					++i;
+				}
+			}
+
+			return tokens;
+		}
+
+		/// <summary>
+		/// write the tokens of a block with its codes, and the end of block
+		/// </summary>
+		void WriteTokens(BitWriter& writer, const Token* p_tokens, size_t count, const std::vector<uint8_t>& lengths, const std::vector<uint32_t>& codes,
+			const std::vector<uint8_t>& distanceLengths, const std::vector<uint32_t>& distanceCodes)
+		{
+			for (size_t t = 0; t < count; ++t)
+			{
+				const Token& token = p_tokens[t];
+				if (token.Length == 0)
+				{
+					writer.WriteCode(codes[token.Value], lengths[token.Value]);
+					continue;
+				}
+
+				int symbol = 28;
+				while (token.Length < LENGTH_BASE[symbol]) --symbol;
+				writer.WriteCode(codes[257 + symbol], lengths[257 + symbol]);
+				writer.Write(token.Length - LENGTH_BASE[symbol], LENGTH_EXTRA[symbol]);
+
+				int distance_symbol = 29;
+				while (token.Value < DISTANCE_BASE[distance_symbol]) --distance_symbol;
+				writer.WriteCode(distanceCodes[distance_symbol], distanceLengths[distance_symbol]);
+				writer.Write(token.Value - DISTANCE_BASE[distance_symbol], DISTANCE_EXTRA[distance_symbol]);
+			}
+			writer.WriteCode(codes[256], lengths[256]);
+		}
+
+		/// <summary>
+		/// write a block with the fixed code, or with its own code and the header of its lengths
+		/// </summary>
+		void WriteBlock(BitWriter& writer, const Token* p_tokens, size_t count, bool isFinal, Compression compression)
+		{
+			std::vector<uint8_t> lengths(286, 0), distance_lengths(30, 0);
+			writer.Write(isFinal ? 1 : 0, 1);
+
+			if (compression == Compression::Fixed)
+			{
+				// the code counts the 2 symbols past 285 and the 2 distances past 29, which are never written
+				writer.Write(1, 2);
+				lengths.resize(288);
+				distance_lengths.assign(32, 5);
+				for (int i = 0; i < 288; ++i) lengths[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+				WriteTokens(writer, p_tokens, count, lengths, AssignCodes(lengths), distance_lengths, AssignCodes(distance_lengths));
+				return;
+			}
+
+			std::vector<uint32_t> frequencies(286, 0), distance_frequencies(30, 0);
+			frequencies[256] = 1;
+			for (size_t t = 0; t < count; ++t)
+			{
+				const Token& token = p_tokens[t];
+				if (token.Length == 0)
+				{
+					frequencies[token.Value]++;
+					continue;
+				}
+
+				int symbol = 28, distance_symbol = 29;
+				while (token.Length < LENGTH_BASE[symbol]) --symbol;
+				while (token.Value < DISTANCE_BASE[distance_symbol]) --distance_symbol;
+				frequencies[257 + symbol]++;
+				distance_frequencies[distance_symbol]++;
+			}
+			lengths          = BuildLengths(frequencies, 15);
+			distance_lengths = BuildLengths(distance_frequencies, 15);
+			if (distance_lengths[0] == 0 && std::count(distance_lengths.begin(), distance_lengths.end(), 0) == 30) distance_lengths[0] = 1;
+
+			uint32_t literal_count = 286, distance_count = 30;
+			while (literal_count > 257 && lengths[literal_count - 1] == 0) --literal_count;
+			while (distance_count > 1 && distance_lengths[distance_count - 1] == 0) --distance_count;
+
+			// the lengths of both codes as one run, zeros and repeats shortened
+			std::vector<uint8_t> run(lengths.begin(), lengths.begin() + literal_count);
+			run.insert(run.end(), distance_lengths.begin(), distance_lengths.begin() + distance_count);
+
+			std::vector<std::pair<uint8_t, uint8_t>> symbols;
+			std::vector<uint32_t> code_length_frequencies(19, 0);
+			for (size_t i = 0; i < run.size();)
+			{
+				size_t repeat = 1;
+				while (i + repeat < run.size() && run[i + repeat] == run[i]) ++repeat;
+
+				if (run[i] == 0 && repeat >= 3)
+				{
+					repeat = std::min<size_t>(repeat, 138);
+					symbols.push_back({ static_cast<uint8_t>(repeat >= 11 ? 18 : 17), static_cast<uint8_t>(repeat >= 11 ? repeat - 11 : repeat - 3) });
+				}
+				else if (run[i] != 0 && repeat >= 4)
+				{
+					repeat = std::min<size_t>(repeat, 7);
+					symbols.push_back({ run[i], 0 });
+					symbols.push_back({ 16, static_cast<uint8_t>(repeat - 4) });
+				}
+				else
+				{
+					repeat = 1;
+					symbols.push_back({ run[i], 0 });
+				}
+				i += repeat;
+			}
+			for (const auto& symbol : symbols) code_length_frequencies[symbol.first]++;
+
+			const std::vector<uint8_t> code_lengths = BuildLengths(code_length_frequencies, 7);
+			const std::vector<uint32_t> code_codes = AssignCodes(code_lengths);
+			uint32_t length_count = 19;
+			while (length_count > 4 && code_lengths[CODE_LENGTH_ORDER[length_count - 1]] == 0) --length_count;
+
+			writer.Write(2, 2);
+			writer.Write(literal_count - 257, 5);
+			writer.Write(distance_count - 1, 5);
+			writer.Write(length_count - 4, 4);
+			for (uint32_t i = 0; i < length_count; ++i) writer.Write(code_lengths[CODE_LENGTH_ORDER[i]], 3);
+			for (const auto& symbol : symbols)
+			{
+				writer.WriteCode(code_codes[symbol.first], code_lengths[symbol.first]);
+				if (symbol.first == 16) writer.Write(symbol.second, 2);
+				if (symbol.first == 17) writer.Write(symbol.second, 3);
+				if (symbol.first == 18) writer.Write(symbol.second, 7);
+			}
+
+			WriteTokens(writer, p_tokens, count, lengths, AssignCodes(lengths), distance_lengths, AssignCodes(distance_lengths));
+		}
+
+		/// <summary>
+		/// zlib stream of the data
+		/// </summary>
+		std::vector<uint8_t> Deflate(const std::vector<uint8_t>& data, Compression compression)
+		{
+			std::vector<uint8_t> stream = { 0x78, 0x01 };
+			BitWriter writer(&stream);
+
+			if (compression == Compression::Stored)
+			{
+				for (size_t first = 0; first < data.size(); first += 65535)
+				{
+					const uint32_t length = static_cast<uint32_t>(std::min<size_t>(65535, data.size() - first));
+					writer.Write(first + length == data.size() ? 1 : 0, 1);
+					writer.Write(0, 2);
+					writer.Align();
+					writer.Write(length, 16);
+					writer.Write(length ^ 0xffff, 16);
+					for (uint32_t i = 0; i < length; ++i) writer.Write(data[first + i], 8);
+				}
+			}
+			else
+			{
+				const std::vector<Token> tokens = FindMatches(data);
+				for (size_t first = 0; first < tokens.size(); first += BLOCK_TOKENS)
+				{
+					const size_t count = std::min(BLOCK_TOKENS, tokens.size() - first);
+					WriteBlock(writer, &tokens[first], count, first + count == tokens.size(), compression);
+				}
+			}
+			writer.Align();
+
+			uint32_t a = 1, b = 0;
+			for (uint8_t byte : data)
+			{
+				a = (a + byte) % 65521;
+				b = (b + a) % 65521;
+			}
+			AppendBe32(&stream, (b << 16) | a);
+
+			return stream;
+		}
+
+		/// <summary>
+		/// Paeth predictor of the PNG specification
+		/// </summary>
+		int Paeth(int left, int above, int upperLeft)
+		{
+			const int pa = std::abs(above - upperLeft), pb = std::abs(left - upperLeft), pc = std::abs(left + above - 2 * upperLeft);
+			return (pa <= pb && pa <= pc) ? left : (pb <= pc) ? above : upperLeft;
+		}
+
+		/// <summary>
+		/// filter rows with a filter type or a mode, each row after its filter byte
+		/// </summary>
+		void FilterRows(const uint8_t* p_rows, size_t rowBytes, uint32_t rowCount, uint32_t stride, uint32_t mode, std::vector<uint8_t>* p_out)
+		{
+			const std::vector<uint8_t> zero(rowBytes, 0);
+			std::vector<uint8_t> filtered(rowBytes);
+
+			for (uint32_t y = 0; y < rowCount; ++y)
+			{
+				const uint8_t* p_row = p_rows + y * rowBytes;
+				const uint8_t* p_above = y ? p_row - rowBytes : zero.data();
+
+				uint32_t best_filter = 0;
+				uint64_t best_sum = ~0ull;
+				std::vector<uint8_t> best;
+				for (uint32_t filter = 0; filter < 5; ++filter)
+				{
+					if (mode < 5 && filter != mode) continue;
+					if (mode == FILTER_CYCLE && filter != y % 5) continue;
+
+					uint64_t sum = 0;
+					for (size_t i = 0; i < rowBytes; ++i)
+					{
+						const int left = (i >= stride) ? p_row[i - stride] : 0;
+						const int upper_left = (i >= stride) ? p_above[i - stride] : 0;
+						int predictor = 0;
+						if (filter == 1) predictor = left;
+						if (filter == 2) predictor = p_above[i];
+						if (filter == 3) predictor = (left + p_above[i]) >> 1;
+						if (filter == 4) predictor = Paeth(left, p_above[i], upper_left);
+
+						filtered[i] = static_cast<uint8_t>(p_row[i] - predictor);
+						sum += std::abs(static_cast<int8_t>(filtered[i]));
+					}
+					if (sum < best_sum)
+					{
+						best_sum    = sum;
+						best_filter = filter;
+						best        = filtered;
+					}
+				}
+
+				p_out->push_back(static_cast<uint8_t>(best_filter));
+				p_out->insert(p_out->end(), best.begin(), best.end());
+			}
+		}
+
+		/// <summary>
+		/// append a chunk with its CRC
+		/// </summary>
+		void AppendChunk(std::vector<uint8_t>* p_file, const char* type, const uint8_t* data, size_t size)
+		{
+			AppendBe32(p_file, static_cast<uint32_t>(size));
+			const size_t first = p_file->size();
+			p_file->insert(p_file->end(), type, type + 4);
+			p_file->insert(p_file->end(), data, data + size);
+			AppendBe32(p_file, ComputeCrc(&(*p_file)[first], size + 4));
+		}
+
+		/// <summary>
+		/// get the bits of a texel
+		/// </summary>
+		uint32_t GetBitsPerTexel(const Source& source)
+		{
+			const uint32_t channels = (source.Color == PngDecoder::ColorType::Rgb) ? 3 : (source.Color == PngDecoder::ColorType::GrayAlpha) ? 2 :
+				(source.Color == PngDecoder::ColorType::Rgba) ? 4 : 1;
+			return channels * source.BitDepth;
+		}
+
+		/// <summary>
+		/// encode a source as a PNG file, tagged sRGB
+		/// </summary>
+		std::vector<uint8_t> EncodePng(const Source& source, bool isInterlaced, uint32_t filterMode, Compression compression, size_t chunkSize)
+		{
+			const uint32_t bits = GetBitsPerTexel(source);
+			const uint32_t stride = std::max(bits / 8, 1u);
+			const size_t row_bytes = (static_cast<size_t>(source.Width) * bits + 7) / 8;
+
+			std::vector<uint8_t> filtered;
+			if (!isInterlaced)
+			{
+				FilterRows(source.Samples.data(), row_bytes, source.Height, stride, filterMode, &filtered);
+			}
+			else
+			{
+				// the texels of each pass are gathered bit by bit, whatever their size
+				for (const uint32_t* pass : ADAM7)
+				{
+					const uint32_t pass_width  = (source.Width  + pass[2] - 1 - pass[0]) / pass[2];
+					const uint32_t pass_height = (source.Height + pass[3] - 1 - pass[1]) / pass[3];
+					if (!pass_width || !pass_height) continue;
+
+					const size_t pass_bytes = (static_cast<size_t>(pass_width) * bits + 7) / 8;
+					std::vector<uint8_t> rows(pass_bytes * pass_height, 0);
+					for (uint32_t y = 0; y < pass_height; ++y)
+					{
+						const uint8_t* p_source = &source.Samples[(pass[1] + y * pass[3]) * row_bytes];
+						for (uint32_t x = 0; x < pass_width; ++x)
+						{
+							const size_t from = static_cast<size_t>(pass[0] + x * pass[2]) * bits, to = static_cast<size_t>(x) * bits;
+							for (uint32_t b = 0; b < bits; ++b)
+							{
+								const uint32_t bit = (p_source[(from + b) / 8] >> (7 - (from + b) % 8)) & 1;
+								rows[y * pass_bytes + (to + b) / 8] |= static_cast<uint8_t>(bit << (7 - (to + b) % 8));
+							}
+						}
+					}
+					FilterRows(rows.data(), pass_bytes, pass_height, stride, filterMode, &filtered);
+				}
+			}
+			const std::vector<uint8_t> stream = Deflate(filtered, compression);
+
+			std::vector<uint8_t> file = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+			std::vector<uint8_t> header;
+			AppendBe32(&header, source.Width);
+			AppendBe32(&header, source.Height);
+			header.insert(header.end(), { source.BitDepth, static_cast<uint8_t>(source.Color), 0, 0, static_cast<uint8_t>(isInterlaced ? 1 : 0) });
+			AppendChunk(&file, "IHDR", header.data(), header.size());
+
+			const uint8_t intent = 0;
+			AppendChunk(&file, "sRGB", &intent, 1);
+			if (!source.Palette.empty())      AppendChunk(&file, "PLTE", source.Palette.data(), source.Palette.size());
+			if (!source.Transparency.empty()) AppendChunk(&file, "tRNS", source.Transparency.data(), source.Transparency.size());
+
+			for (size_t first = 0; first < stream.size(); first += chunkSize)
+			{
+				AppendChunk(&file, "IDAT", &stream[first], std::min(chunkSize, stream.size() - first));
+			}
+			AppendChunk(&file, "IEND", nullptr, 0);
+
+			return file;
+		}
+
+		//--------------------------------------------------------
+		// sources
+		//--------------------------------------------------------
+		/// <summary>
+		/// image of a color type and a bit depth: smooth gradients with a little noise, and a soft disc of alpha
+		/// the tRNS color is one found in the image, so some texels are keyed out
+		/// </summary>
+		Source CreateSource(PngDecoder::ColorType color, uint8_t depth, uint32_t width, uint32_t height)
+		{
+			using PngDecoder::ColorType;
+
+			Source source = { width, height, color, depth, {}, {}, {}, {} };
+			const uint32_t channels = GetBitsPerTexel(source) / depth;
+			const uint32_t max_level = (1u << depth) - 1;
+			const uint32_t palette_size = 1u << std::min<uint32_t>(depth, 8);
+
+			// values of each sample at the bit depth
+			std::vector<uint32_t> values(static_cast<size_t>(width) * height * channels);
+			uint32_t random = 1;
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					random = random * 1664525u + 1013904223u;
+					const int noise = static_cast<int>(random >> 29) - 4;
+
+					const float u = static_cast<float>(x) / width, v = static_cast<float>(y) / height;
+					const float distance = std::sqrt((u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f));
+					const float wave = 0.5f + 0.5f * std::sin(u * 12.0f) * std::cos(v * 9.0f);
+					auto clamp = [](float value) { return static_cast<uint32_t>(std::fmin(std::fmax(value, 0.0f), 255.0f)); };
+					const uint32_t rgba[4] = { clamp(u * 255.0f + noise), clamp(v * 255.0f + noise), clamp(wave * 255.0f + noise), clamp((0.45f - distance) * 2048.0f) };
+
+					// gray follows the red channel, and the alpha of gray is the fourth one
+					const uint32_t picks[4][4] = { { 0 }, { 0, 3 }, { 0, 1, 2 }, { 0, 1, 2, 3 } };
+					const uint32_t* pick = picks[(channels == 1) ? 0 : (channels == 2) ? 1 : (channels == 3) ? 2 : 3];
+					for (uint32_t c = 0; c < channels; ++c)
+					{
+						uint32_t value = rgba[pick[c]];
+						if (color == ColorType::Palette) value = (value * 7 + x) % palette_size;
+						else if (depth == 16) value = (value << 8) | ((random >> 8) & 0xff);
+						else value >>= 8 - depth;
+						values[(static_cast<size_t>(y) * width + x) * channels + c] = value;
+					}
+				}
+			}
+
+			// the palette and its transparency, or the transparent color
+			if (color == ColorType::Palette)
+			{
+				for (uint32_t i = 0; i < palette_size; ++i)
+				{
+					source.Palette.insert(source.Palette.end(), { static_cast<uint8_t>(i * 37), static_cast<uint8_t>(255 - i * 11), static_cast<uint8_t>(i * 97) });
+				}
+				for (uint32_t i = 0; i < (palette_size + 1) / 2; ++i) source.Transparency.push_back(static_cast<uint8_t>(i * 255 / palette_size));
+			}
+			const size_t keyed = (static_cast<size_t>(height / 2) * width + width / 2) * channels;
+			if (color == ColorType::Gray || color == ColorType::Rgb)
+			{
+				for (uint32_t c = 0; c < channels; ++c) source.Transparency.insert(source.Transparency.end(), { static_cast<uint8_t>(values[keyed + c] >> 8), static_cast<uint8_t>(values[keyed + c]) });
+			}
+
+			// packed rows from the highest bits, 16-bit samples big endian
+			const size_t row_bytes = (static_cast<size_t>(width) * channels * depth + 7) / 8;
+			source.Samples.assign(row_bytes * height, 0);
+			source.Expected.resize(static_cast<size_t>(width) * height * 4);
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				uint8_t* p_row = &source.Samples[y * row_bytes];
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const uint32_t* p_values = &values[(static_cast<size_t>(y) * width + x) * channels];
+					for (uint32_t c = 0; c < channels; ++c)
+					{
+						const size_t bit = (static_cast<size_t>(x) * channels + c) * depth;
+						if (depth == 16)
+						{
+							p_row[bit / 8]     = static_cast<uint8_t>(p_values[c] >> 8);
+							p_row[bit / 8 + 1] = static_cast<uint8_t>(p_values[c]);
+						}
+						else
+						{
+							p_row[bit / 8] |= static_cast<uint8_t>(p_values[c] << (8 - depth - bit % 8));
+						}
+					}
+
+					// what the specification makes of the samples
+					auto to_8 = [&](uint32_t value) { return static_cast<uint8_t>((depth == 16) ? value >> 8 : value * 255 / max_level); };
+					const bool is_keyed = (color == ColorType::Gray || color == ColorType::Rgb) &&
+						std::equal(p_values, p_values + channels, &values[keyed]);
+
+					uint8_t* p_expected = &source.Expected[(static_cast<size_t>(y) * width + x) * 4];
+					switch (color)
+					{
+					case ColorType::Gray:
+						p_expected[0] = p_expected[1] = p_expected[2] = to_8(p_values[0]);
+						p_expected[3] = is_keyed ? 0 : 255;
+						break;
+					case ColorType::Rgb:
+						for (int c = 0; c < 3; ++c) p_expected[c] = to_8(p_values[c]);
+						p_expected[3] = is_keyed ? 0 : 255;
+						break;
+					case ColorType::Palette:
+						for (int c = 0; c < 3; ++c) p_expected[c] = source.Palette[p_values[0] * 3 + c];
+						p_expected[3] = (p_values[0] < source.Transparency.size()) ? source.Transparency[p_values[0]] : 255;
+						break;
+					case ColorType::GrayAlpha:
+						p_expected[0] = p_expected[1] = p_expected[2] = to_8(p_values[0]);
+						p_expected[3] = to_8(p_values[1]);
+						break;
+					case ColorType::Rgba:
+						for (int c = 0; c < 4; ++c) p_expected[c] = to_8(p_values[c]);
+						break;
+					}
+				}
+			}
+
+			return source;
+		}
+
+		/// <summary>
+		/// get the name of a color type
+		/// </summary>
+		const char* GetColorName(PngDecoder::ColorType color)
+		{
+			switch (color)
+			{
+			case PngDecoder::ColorType::Gray:      return "gray";
+			case PngDecoder::ColorType::Rgb:       return "rgb";
+			case PngDecoder::ColorType::Palette:   return "palette";
+			case PngDecoder::ColorType::GrayAlpha: return "gray alpha";
+			case PngDecoder::ColorType::Rgba:      return "rgba";
+			default:                               return "unknown";
+			}
+		}
+
+		/// <summary>
+		/// swap red and blue of RGBA8 texels
+		/// </summary>
+		std::vector<uint8_t> SwapRedBlue(std::vector<uint8_t> pixels)
+		{
+			for (size_t i = 0; i < pixels.size(); i += 4) std::swap(pixels[i], pixels[i + 2]);
+			return pixels;
+		}
+
+		/// <summary>
+		/// decode with every instruction set into both layouts, against the expected texels
+		/// </summary>
+		bool CheckDecode(const std::vector<uint8_t>& file, const Source& source)
+		{
+			const std::vector<uint8_t> expected_bgra = SwapRedBlue(source.Expected);
+
+			bool is_match = true;
+			for (QuadKernel::InstructionSet set : { QuadKernel::InstructionSet::Scalar, QuadKernel::GetBestInstructionSet() })
+			{
+				PngDecoder::Image image;
+				is_match = is_match && PngDecoder::Decode(file.data(), file.size(), PngDecoder::Layout::Rgba8, &image, set) == 0 &&
+					image.Width == source.Width && image.Height == source.Height && image.IsSrgb && image.Pixels == source.Expected;
+				is_match = is_match && PngDecoder::Decode(file.data(), file.size(), PngDecoder::Layout::Bgra8, &image, set) == 0 &&
+					image.Pixels == expected_bgra;
+			}
+
+			return is_match;
+		}
+
+#ifdef BENCHMARK_WITH_LIBPNG
+		/// <summary>
+		/// file in memory read by libpng
+		/// </summary>
+		struct MemoryFile
+		{
+			const uint8_t* Data;
+			size_t Size;
+			size_t Position;
+		};
+
+		void ReadMemory(png_structp p_png, png_bytep p_out, png_size_t size)
+		{
+			MemoryFile* p_file = static_cast<MemoryFile*>(png_get_io_ptr(p_png));
+			if (size > p_file->Size - p_file->Position) png_error(p_png, "truncated");
+
+			std::memcpy(p_out, p_file->Data + p_file->Position, size);
+			p_file->Position += size;
+		}
+
+		// libpng and its zlib allocate through the counted heap
+		png_voidp AllocateCounted(png_structp, png_alloc_size_t size)
+		{
+			try { return ::operator new(size); }
+			catch (...) { return nullptr; }
+		}
+
+		void FreeCounted(png_structp, png_voidp p)
+		{
+			::operator delete(p);
+		}
+
+		/// <summary>
+		/// decode with stock libpng into the same texels (expanded, 16 bits stripped, alpha added)
+		/// </summary>
+		bool DecodeLibpng(const std::vector<uint8_t>& file, bool isBgra, std::vector<uint8_t>* p_pixels)
+		{
+			MemoryFile memory = { file.data(), file.size(), 0 };
+			std::vector<png_bytep> rows;
+
+			png_structp p_png = png_create_read_struct_2(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr, nullptr, AllocateCounted, FreeCounted);
+			png_infop p_info = png_create_info_struct(p_png);
+			if (setjmp(png_jmpbuf(p_png)))
+			{
+				png_destroy_read_struct(&p_png, &p_info, nullptr);
+				return false;
+			}
+
+			png_set_read_fn(p_png, &memory, ReadMemory);
+			png_read_info(p_png, p_info);
+			png_set_expand(p_png);
+			png_set_strip_16(p_png);
+			png_set_gray_to_rgb(p_png);
+			png_set_add_alpha(p_png, 0xff, PNG_FILLER_AFTER);
+			if (isBgra) png_set_bgr(p_png);
+			png_set_interlace_handling(p_png);
+			png_read_update_info(p_png, p_info);
+
+			const uint32_t width = png_get_image_width(p_png, p_info), height = png_get_image_height(p_png, p_info);
+			p_pixels->resize(static_cast<size_t>(width) * height * 4);
+			rows.resize(height);
+			for (uint32_t y = 0; y < height; ++y) rows[y] = &(*p_pixels)[static_cast<size_t>(y) * width * 4];
+
+			png_read_image(p_png, rows.data());
+			png_read_end(p_png, nullptr);
+			png_destroy_read_struct(&p_png, &p_info, nullptr);
+
+			return true;
+		}
+#endif
+
+		/// <summary>
+		/// heap bytes above the start while a function runs
+		/// </summary>
+		template <typename Func>
+		uint64_t MeasurePeakBytes(Func&& func)
+		{
+			const uint64_t base = GetLiveBytes();
+			ResetPeakBytes();
+			func();
+			return GetPeakBytes() - base;
+		}
+	}
+
+	/// <summary>
+	/// decode PNG files written by a reference encoder: every color type and bit depth, interlaced or not, with each filter,
+	/// against the texels the specification gives, then the throughput and the peak heap of large images against libpng
+	/// (built in with -DBENCHMARK_WITH_LIBPNG), and many files one after another and across the thread pool
+	/// </summary>
+	void RunPngDecode()
+	{
+		using PngDecoder::ColorType;
+
+		ThreadPool::Manager::Instance().Initialize();
+		const size_t thread_count = ThreadPool::Manager::Instance().GetWorkerCount() + 1;
+
+		std::printf("[png decode] %zu threads, every color type and bit depth %u x %u, each row with another filter, in IDAT chunks of %zu bytes\n",
+			thread_count, CHECK_WIDTH, CHECK_HEIGHT, CHECK_CHUNK_SIZE);
+		std::printf("%-11s %6s %10s %10s %8s\n", "color", "depth", "flat", "adam7", "result");
+
+		struct Format
+		{
+			ColorType Color;
+			uint8_t BitDepth;
+		};
+		const Format formats[] =
+		{
+			{ ColorType::Gray, 1 }, { ColorType::Gray, 2 }, { ColorType::Gray, 4 }, { ColorType::Gray, 8 }, { ColorType::Gray, 16 },
+			{ ColorType::Rgb, 8 }, { ColorType::Rgb, 16 },
+			{ ColorType::Palette, 1 }, { ColorType::Palette, 2 }, { ColorType::Palette, 4 }, { ColorType::Palette, 8 },
+			{ ColorType::GrayAlpha, 8 }, { ColorType::GrayAlpha, 16 },
+			{ ColorType::Rgba, 8 }, { ColorType::Rgba, 16 },
+		};
+
+		bool is_all_match = true;
+		for (const Format& format : formats)
+		{
+			const Source source = CreateSource(format.Color, format.BitDepth, CHECK_WIDTH, CHECK_HEIGHT);
+			const bool is_flat  = CheckDecode(EncodePng(source, false, FILTER_CYCLE, Compression::Dynamic, CHECK_CHUNK_SIZE), source);
+			const bool is_adam7 = CheckDecode(EncodePng(source, true, FILTER_CYCLE, Compression::Dynamic, CHECK_CHUNK_SIZE), source);
+			is_all_match = is_all_match && is_flat && is_adam7;
+
+			std::printf("%-11s %6u %10s %10s %8s\n", GetColorName(format.Color), format.BitDepth,
+				is_flat ? "ok" : "MISMATCH", is_adam7 ? "ok" : "MISMATCH", (is_flat && is_adam7) ? "ok" : "MISMATCH");
+		}
+
+		// stored and fixed blocks, and damaged files which must fail instead of returning texels
+		const Source check = CreateSource(ColorType::Rgba, 8, CHECK_WIDTH, CHECK_HEIGHT);
+		const bool is_blocks = CheckDecode(EncodePng(check, false, FILTER_CYCLE, Compression::Stored, CHECK_CHUNK_SIZE), check) &&
+			CheckDecode(EncodePng(check, false, FILTER_CYCLE, Compression::Fixed, CHECK_CHUNK_SIZE), check);
+
+		const std::vector<uint8_t> file = EncodePng(check, false, FILTER_CYCLE, Compression::Dynamic, CHECK_CHUNK_SIZE);
+		std::vector<uint8_t> damaged = file;
+		damaged[damaged.size() / 2] ^= 0x10;
+		PngDecoder::Image image;
+		const bool is_rejected =
+			PngDecoder::Decode(damaged.data(), damaged.size(), PngDecoder::Layout::Rgba8, &image) == -2 && image.Pixels.empty() &&
+			PngDecoder::Decode(file.data(), file.size() / 2, PngDecoder::Layout::Rgba8, &image) == -2 &&
+			PngDecoder::Decode(file.data() + 1, file.size() - 1, PngDecoder::Layout::Rgba8, &image) == -2;
+		is_all_match = is_all_match && is_blocks && is_rejected;
+		std::printf("stored and fixed blocks: %s, damaged and truncated files rejected: %s\n\n", is_blocks ? "ok" : "MISMATCH", is_rejected ? "ok" : "MISMATCH");
+
+		//-----------------------------------
+		// throughput and peak heap, in MB/s of RGBA8 texels
+		//-----------------------------------
+#ifdef BENCHMARK_WITH_LIBPNG
+		std::printf("%u x %u against libpng %s\n", LARGE_SIZE, LARGE_SIZE, PNG_LIBPNG_VER_STRING);
+#else
+		std::printf("%u x %u (libpng is compared when built with -DBENCHMARK_WITH_LIBPNG -lpng)\n", LARGE_SIZE, LARGE_SIZE);
+#endif
+		std::printf("%-16s %9s %12s %12s %12s %12s %12s %8s\n", "image", "file", "scalar", "simd", "libpng", "peak", "libpng peak", "result");
+
+		struct Case
+		{
+			const char* Name;
+			ColorType Color;
+			uint32_t FilterMode;
+		};
+		const Case cases[] =
+		{
+			{ "rgba none",     ColorType::Rgba,    0 },
+			{ "rgba sub",      ColorType::Rgba,    1 },
+			{ "rgba up",       ColorType::Rgba,    2 },
+			{ "rgba average",  ColorType::Rgba,    3 },
+			{ "rgba paeth",    ColorType::Rgba,    4 },
+			{ "rgba adaptive", ColorType::Rgba,    FILTER_ADAPTIVE },
+			{ "rgb adaptive",  ColorType::Rgb,     FILTER_ADAPTIVE },
+			{ "palette none",  ColorType::Palette, 0 },
+		};
+
+		const double megabytes = static_cast<double>(LARGE_SIZE) * LARGE_SIZE * 4 / 1e6;
+		for (const Case& test : cases)
+		{
+			const Source source = CreateSource(test.Color, 8, LARGE_SIZE, LARGE_SIZE);
+			const std::vector<uint8_t> encoded = EncodePng(source, false, test.FilterMode, Compression::Dynamic, CHUNK_SIZE);
+
+			PngDecoder::Image scalar, simd;
+			const double ns_scalar = MeasureNanoseconds([&]()
+			{
+				PngDecoder::Decode(encoded.data(), encoded.size(), PngDecoder::Layout::Rgba8, &scalar, QuadKernel::InstructionSet::Scalar);
+			}, 3);
+			const double ns_simd = MeasureNanoseconds([&]()
+			{
+				PngDecoder::Decode(encoded.data(), encoded.size(), PngDecoder::Layout::Rgba8, &simd);
+			}, 3);
+
+			// the output is part of the peak
+			const uint64_t peak = MeasurePeakBytes([&]()
+			{
+				PngDecoder::Image measured;
+				PngDecoder::Decode(encoded.data(), encoded.size(), PngDecoder::Layout::Rgba8, &measured);
+			});
+			bool is_match = scalar.Pixels == source.Expected && simd.Pixels == source.Expected;
+
+			char libpng[32] = "-", libpng_peak[32] = "-";
+#ifdef BENCHMARK_WITH_LIBPNG
+			std::vector<uint8_t> reference;
+			const double ns_libpng = MeasureNanoseconds([&]()
+			{
+				DecodeLibpng(encoded, false, &reference);
+			}, 3);
+			const uint64_t reference_peak = MeasurePeakBytes([&]()
+			{
+				std::vector<uint8_t> measured;
+				DecodeLibpng(encoded, false, &measured);
+			});
+			is_match = is_match && reference == source.Expected;
+			std::snprintf(libpng, sizeof(libpng), "%7.1f MB/s", megabytes * 1e9 / ns_libpng);
+			std::snprintf(libpng_peak, sizeof(libpng_peak), "%9.1f MB", reference_peak / 1e6);
+#endif
+			is_all_match = is_all_match && is_match;
+
+			std::printf("%-16s %6.1f MB %7.1f MB/s %7.1f MB/s %12s %9.1f MB %12s %8s\n", test.Name, encoded.size() / 1e6,
+				megabytes * 1e9 / ns_scalar, megabytes * 1e9 / ns_simd, libpng, peak / 1e6, libpng_peak, is_match ? "ok" : "MISMATCH");
+		}
+
+		// the texture of the samples (palette with tRNS, two IDAT chunks), when run from the repository root
+		PngDecoder::Image sample;
+		if (PngDecoder::DecodeFile(SAMPLE_PATH, PngDecoder::Layout::Rgba8, &sample) != -1)
+		{
+			bool is_sample = sample.Width > 0 && !sample.Pixels.empty();
+			const double ns_sample = MeasureNanoseconds([&]()
+			{
+				PngDecoder::DecodeFile(SAMPLE_PATH, PngDecoder::Layout::Rgba8, &sample);
+			}, 3);
+#ifdef BENCHMARK_WITH_LIBPNG
+			FILE* p_file = std::fopen(SAMPLE_PATH, "rb");
+			std::vector<uint8_t> encoded, reference;
+			if (p_file)
+			{
+				uint8_t buffer[65536];
+				for (size_t count; (count = std::fread(buffer, 1, sizeof(buffer), p_file)) > 0;) encoded.insert(encoded.end(), buffer, buffer + count);
+				std::fclose(p_file);
+			}
+			is_sample = is_sample && DecodeLibpng(encoded, false, &reference) && reference == sample.Pixels;
+#endif
+			is_all_match = is_all_match && is_sample;
+			std::printf("%s %u x %u: %.2f ms, %s\n", SAMPLE_PATH, sample.Width, sample.Height, ns_sample / 1e6, is_sample ? "ok" : "MISMATCH");
+		}
+		std::printf("\n");
+
+		//-----------------------------------
+		// many files from the disk, one after another and one per task
+		//-----------------------------------
+		std::vector<std::string> paths;
+		std::vector<std::vector<uint8_t>> expected;
+		for (uint32_t i = 0; i < FILE_COUNT; ++i)
+		{
+			const Source source = CreateSource((i % 2) ? ColorType::Rgba : ColorType::Rgb, 8, FILE_SIZE, FILE_SIZE - i);
+			const std::vector<uint8_t> encoded = EncodePng(source, false, FILTER_ADAPTIVE, Compression::Dynamic, CHUNK_SIZE);
+
+			paths.push_back("benchmark_png_" + std::to_string(i) + ".png");
+			FILE* p_file = std::fopen(paths.back().c_str(), "wb");
+			if (p_file)
+			{
+				std::fwrite(encoded.data(), 1, encoded.size(), p_file);
+				std::fclose(p_file);
+			}
+			expected.push_back(source.Expected);
+		}
+
+		std::vector<PngDecoder::Image> images(FILE_COUNT);
+		std::vector<int> results(FILE_COUNT);
+		const double ns_serial = MeasureNanoseconds([&]()
+		{
+			for (uint32_t i = 0; i < FILE_COUNT; ++i) results[i] = PngDecoder::DecodeFile(paths[i].c_str(), PngDecoder::Layout::Rgba8, &images[i]);
+		}, 3);
+		bool is_files = true;
+		for (uint32_t i = 0; i < FILE_COUNT; ++i) is_files = is_files && results[i] == 0 && images[i].Pixels == expected[i];
+
+		const double ns_parallel = MeasureNanoseconds([&]()
+		{
+			PngDecoder::DecodeFiles(paths, PngDecoder::Layout::Rgba8, &images, &results);
+		}, 3);
+		for (uint32_t i = 0; i < FILE_COUNT; ++i) is_files = is_files && results[i] == 0 && images[i].Pixels == expected[i];
+
+		for (const std::string& path : paths) std::remove(path.c_str());
+		is_all_match = is_all_match && is_files;
+
+		std::printf("%u files of %u x %u: %.1f files/s one after another, %.1f files/s across the pool (x%.2f), files: %s, result: %s\n\n",
+			FILE_COUNT, FILE_SIZE, FILE_SIZE, FILE_COUNT * 1e9 / ns_serial, FILE_COUNT * 1e9 / ns_parallel, ns_serial / ns_parallel,
+			is_files ? "ok" : "MISMATCH", is_all_match ? "ok" : "MISMATCH");
+	}
+}
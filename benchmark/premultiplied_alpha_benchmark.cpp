@@ -0,0 +1,307 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../software_renderer.h"
+#include "../sprite_batch_core.h"
+#include "../sprite_registry.h"
+#include "../texture_container.h"
+#include "../texture_import.h"
+#include "../thread_pool.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		constexpr const char* CONTAINER_PATH = "benchmark_premultiplied.ctex";
+
+		// texels of the kernel measurement
+		constexpr uint32_t IMAGE_SIZE = 2048;
+
+		// sprites of a frame, alternating between additive and alpha blended ones
+		constexpr uint32_t SPRITE_COUNT = 1000;
+
+		constexpr uint32_t TEXTURE_SIZE = 32;
+
+		// the premultiplied frame against the straight one, a few steps of 8 bits are not visible
+		constexpr double MINIMUM_PSNR = 45.0;
+		constexpr int MAXIMUM_DIFFERENCE = 4;
+
+		/// <summary>
+		/// texels of a sprite sheet: opaque and transparent areas, and soft edges between them
+		/// </summary>
+		std::vector<uint8_t> CreateImage(uint32_t size)
+		{
+			std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+
+			uint32_t random = 1;
+			for (uint32_t y = 0; y < size; ++y)
+			{
+				for (uint32_t x = 0; x < size; ++x)
+				{
+					random = random * 1664525u + 1013904223u;
+
+					uint8_t* p = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+					p[0] = static_cast<uint8_t>(random >> 24);
+					p[1] = static_cast<uint8_t>(random >> 16);
+					p[2] = static_cast<uint8_t>(random >> 8);
+
+					// a third opaque, a third transparent, and the edges translucent
+					const uint32_t cell = ((x / 16) + (y / 16) * 3) % 3;
+					p[3] = (cell == 0) ? 255 : (cell == 1) ? 0 : static_cast<uint8_t>(random >> 4);
+				}
+			}
+
+			return pixels;
+		}
+
+		/// <summary>
+		/// check the kernels: the bytes against the exact rounding of c * a / 255, and every instruction set against the scalar one
+		/// </summary>
+		bool CheckKernels()
+		{
+			bool is_exact = true;
+			for (uint32_t a = 0; a < 256; ++a)
+			{
+				std::vector<uint8_t> texels(256 * 4);
+				for (uint32_t c = 0; c < 256; ++c)
+				{
+					texels[c * 4 + 0] = texels[c * 4 + 1] = texels[c * 4 + 2] = static_cast<uint8_t>(c);
+					texels[c * 4 + 3] = static_cast<uint8_t>(a);
+				}
+
+				TextureImport::Premultiply(texels.data(), 256, false);
+				for (uint32_t c = 0; c < 256; ++c)
+				{
+					const uint32_t expected = (c * a * 2 + 255) / 510;
+					is_exact = is_exact && texels[c * 4] == expected && texels[c * 4 + 3] == a;
+				}
+			}
+
+			// an odd count leaves a tail after the groups of 4 texels
+			const std::vector<uint8_t> image = CreateImage(61);
+			bool is_match = true;
+			for (bool is_srgb : { false, true })
+			{
+				std::vector<uint8_t> scalar = image, simd = image;
+				TextureImport::Premultiply(scalar.data(), scalar.size() / 4, is_srgb, QuadKernel::InstructionSet::Scalar);
+				TextureImport::Premultiply(simd.data(), simd.size() / 4, is_srgb);
+				is_match = is_match && scalar == simd;
+			}
+
+			// half coverage of white is half of linear light, 188 in sRGB
+			uint8_t half[4] = { 255, 255, 255, 128 };
+			TextureImport::Premultiply(half, 1, true);
+			const bool is_linear = half[0] == 188 && half[3] == 128;
+
+			std::printf("kernels: exact bytes %s, scalar and simd %s, half white in sRGB %u (188)\n",
+				is_exact ? "ok" : "MISMATCH", is_match ? "ok" : "MISMATCH", half[0]);
+
+			return is_exact && is_match && is_linear;
+		}
+
+		/// <summary>
+		/// draw every sprite of the registry in creation order, and get the batches of the frame
+		/// </summary>
+		uint32_t DrawFrame(SoftwareRenderer::Manager& software, SpriteBatch::Batcher& batcher, SpriteRegistry::Registry& registry,
+			const SoftwareRenderer::Texture& texture, ShaderPermutation::Key features = ShaderPermutation::DEFAULT_KEY)
+		{
+			static SpriteBatch::SpriteInstance s_instances[SpriteRegistry::QUAD_CHUNK_SPRITES];
+
+			software.ClearViews();
+
+			const uint32_t count = registry.GetCount();
+			const Renderer::BlendMode* p_blends = registry.GetBlends();
+
+			batcher.Begin();
+			for (uint32_t first = 0; first < count; first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+			{
+				const uint32_t chunk = std::min(count - first, SpriteRegistry::QUAD_CHUNK_SPRITES);
+				registry.GenerateInstances(first, chunk, 1.0f, s_instances);
+
+				for (uint32_t i = 0; i < chunk; ++i)
+				{
+					*batcher.Allocate(reinterpret_cast<SpriteBatch::TextureId>(&texture), p_blends[first + i], features) = s_instances[i];
+				}
+			}
+			batcher.End();
+
+			software.FlipFrameBuffer();
+
+			return batcher.GetLastFrameStats().Batches;
+		}
+	}
+
+	/// <summary>
+	/// premultiply texels with the scalar and SSE2 kernels, and draw interleaved additive and alpha blended sprites
+	/// with their own blend states and with the premultiplied one, which must draw the same pixels in a single batch
+	/// </summary>
+	void RunPremultipliedAlpha()
+	{
+		ThreadPool::Manager::Instance().Initialize();
+
+		std::printf("[premultiplied alpha]\n");
+		bool is_all_match = CheckKernels();
+
+		//-----------------------------------
+		// throughput of the kernels
+		//-----------------------------------
+		const std::vector<uint8_t> image = CreateImage(IMAGE_SIZE);
+		const double texels = static_cast<double>(IMAGE_SIZE) * IMAGE_SIZE;
+		for (bool is_srgb : { false, true })
+		{
+			// premultiplying again costs the same, the alpha does not change
+			std::vector<uint8_t> pixels = image;
+			const double ns_scalar = MeasureNanoseconds([&]()
+			{
+				TextureImport::Premultiply(pixels.data(), pixels.size() / 4, is_srgb, QuadKernel::InstructionSet::Scalar);
+			});
+			pixels = image;
+			const double ns_simd = MeasureNanoseconds([&]()
+			{
+				TextureImport::Premultiply(pixels.data(), pixels.size() / 4, is_srgb);
+			});
+			std::printf("%u x %u %-5s scalar %8.1f MT/s, simd %8.1f MT/s\n", IMAGE_SIZE, IMAGE_SIZE, is_srgb ? "sRGB" : "bytes",
+				texels * 1e3 / ns_scalar, texels * 1e3 / ns_simd);
+		}
+
+		// the cooked container carries the flag, a mask is never premultiplied
+		TextureImport::Settings settings = TextureImport::GetDefaultSettings();
+		settings.IsPremultiplied = true;
+		TextureImport::Image imported;
+		TextureContainer::Reader container;
+		bool is_cooked =
+			TextureImport::Cook(CONTAINER_PATH, image.data(), 64, 64, settings, &imported) == 0 && imported.IsPremultiplied &&
+			container.Open(CONTAINER_PATH) == 0 && (container.GetHeader().Flags & TextureContainer::FLAG_PREMULTIPLIED_ALPHA) != 0;
+		container.Close();
+		std::remove(CONTAINER_PATH);
+
+		settings.Type = TextureImport::Content::Mask;
+		is_cooked = is_cooked && TextureImport::Import(image.data(), 64, 64, settings, &imported) == 0 && !imported.IsPremultiplied;
+		is_all_match = is_all_match && is_cooked;
+
+		//-----------------------------------
+		// interleaved blend modes on the software renderer
+		//-----------------------------------
+		SoftwareRenderer::Manager& software = SoftwareRenderer::Manager::Instance();
+		software.Initialize();
+		software.SetDepthEnableState(Renderer::DepthEnebleMode::Disable);
+		software.SetCullingMode(Renderer::CullMode::None);
+
+		// textured and tinted by the instance color, whatever the previous scenarios left bound
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		software.SetMaterial(white, ShaderPermutation::DEFAULT_KEY, 0.0f);
+		software.SetMaterialTable(nullptr);
+
+		SpriteBatch::Batcher batcher;
+		batcher.Initialize(&software);
+
+		// one color with a checker of alpha: the bilinear filter of straight and premultiplied texels then agrees,
+		// it differs by design where the colors change under translucent texels (premultiplied texels do not fringe)
+		SoftwareRenderer::Texture straight_texture;
+		straight_texture.Width  = TEXTURE_SIZE;
+		straight_texture.Height = TEXTURE_SIZE;
+		straight_texture.Texels.resize(TEXTURE_SIZE * TEXTURE_SIZE);
+		for (uint32_t y = 0; y < TEXTURE_SIZE; ++y)
+		{
+			for (uint32_t x = 0; x < TEXTURE_SIZE; ++x)
+			{
+				straight_texture.Texels[y * TEXTURE_SIZE + x] = ((x / 8 + y / 8) % 2) ? 0x6060c0ffu : 0xff60c0ffu;
+			}
+		}
+		SoftwareRenderer::Texture premultiplied_texture = straight_texture;
+		TextureImport::Premultiply(reinterpret_cast<uint8_t*>(premultiplied_texture.Texels.data()), premultiplied_texture.Texels.size(), false);
+
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> position_x(0.0f, static_cast<float>(Renderer::SCREEN_SIZE_WIDTH));
+		std::uniform_real_distribution<float> position_y(0.0f, static_cast<float>(Renderer::SCREEN_SIZE_HEIGHT));
+		std::uniform_real_distribution<float> scale(16.0f, 64.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		SpriteRegistry::Registry straight, premultiplied;
+		straight.Reserve(SPRITE_COUNT);
+		premultiplied.Reserve(SPRITE_COUNT);
+		for (uint32_t i = 0; i < SPRITE_COUNT; ++i)
+		{
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			desc.Position[0] = position_x(random);
+			desc.Position[1] = position_y(random);
+			desc.Scale[0]    = scale(random);
+			desc.Scale[1]    = scale(random);
+			desc.Rotation    = unit(random) * 6.0f;
+			desc.Color[0]    = unit(random);
+			desc.Color[1]    = unit(random);
+			desc.Color[2]    = unit(random);
+			desc.Color[3]    = 0.2f + unit(random) * 0.8f;
+			desc.Texture     = 0;
+			desc.Blend       = (random() % 2) ? Renderer::BlendMode::Add : Renderer::BlendMode::AlphaBlend;
+
+			straight.Create(desc);
+			premultiplied.Create(SpriteRegistry::Registry::GetPremultipliedDesc(desc));
+		}
+
+		// the chunk of visible sprites is gathered by index, and must pack the same instances
+		std::vector<uint32_t> indices(SpriteRegistry::QUAD_CHUNK_SPRITES);
+		for (uint32_t i = 0; i < SpriteRegistry::QUAD_CHUNK_SPRITES; ++i) indices[i] = i;
+		std::vector<SpriteBatch::SpriteInstance> ranged(SpriteRegistry::QUAD_CHUNK_SPRITES), gathered(SpriteRegistry::QUAD_CHUNK_SPRITES);
+		premultiplied.GenerateInstances(0u, SpriteRegistry::QUAD_CHUNK_SPRITES, 1.0f, ranged.data());
+		premultiplied.GenerateInstances(indices.data(), SpriteRegistry::QUAD_CHUNK_SPRITES, 1.0f, gathered.data());
+		const bool is_gathered = std::memcmp(ranged.data(), gathered.data(), ranged.size() * sizeof(SpriteBatch::SpriteInstance)) == 0;
+		is_all_match = is_all_match && is_gathered;
+
+		const size_t pixel_count = static_cast<size_t>(software.GetWidth()) * software.GetHeight();
+		uint32_t straight_batches = 0, premultiplied_batches = 0;
+		const double ns_straight = MeasureNanoseconds([&]()
+		{
+			straight_batches = DrawFrame(software, batcher, straight, straight_texture);
+		}, 3);
+		const std::vector<uint32_t> straight_frame(software.GetFrameBuffer(), software.GetFrameBuffer() + pixel_count);
+
+		const double ns_premultiplied = MeasureNanoseconds([&]()
+		{
+			premultiplied_batches = DrawFrame(software, batcher, premultiplied, premultiplied_texture);
+		}, 3);
+		const uint32_t* p_frame = software.GetFrameBuffer();
+
+		// the alpha of the target is not compared, an additive sprite writes 0 there
+		const double psnr = TextureImport::ComputePsnr(reinterpret_cast<const uint8_t*>(straight_frame.data()),
+			reinterpret_cast<const uint8_t*>(p_frame), pixel_count, 0x7);
+		int max_difference = 0;
+		for (size_t i = 0; i < pixel_count; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const int a = static_cast<int>((straight_frame[i] >> (c * 8)) & 0xff);
+				const int b = static_cast<int>((p_frame[i] >> (c * 8)) & 0xff);
+				max_difference = std::max(max_difference, std::abs(a - b));
+			}
+		}
+
+		// a material with the premultiplied feature draws the same pixels, its colors are not multiplied by alpha again
+		const std::vector<uint32_t> premultiplied_frame(p_frame, p_frame + pixel_count);
+		const ShaderPermutation::Key premultiplied_key = ShaderPermutation::DEFAULT_KEY | ShaderPermutation::FEATURE_PREMULTIPLIED;
+		DrawFrame(software, batcher, premultiplied, premultiplied_texture, ShaderPermutation::GetPipelineKey(premultiplied_key, true));
+		const bool is_single_multiply = std::memcmp(premultiplied_frame.data(), software.GetFrameBuffer(), pixel_count * sizeof(uint32_t)) == 0;
+		is_all_match = is_all_match && is_single_multiply;
+
+		batcher.Terminate();
+		software.Terminate();
+
+		// the instance colors and the target are rounded to 8 bits at other steps, which adds up over overlapping sprites
+		const bool is_frame_match = premultiplied_batches == 1 && psnr >= MINIMUM_PSNR && max_difference <= MAXIMUM_DIFFERENCE;
+		is_all_match = is_all_match && is_frame_match;
+
+		std::printf("%u sprites, straight: %u batches %.3f ms, premultiplied: %u batches %.3f ms, %.2f dB, max difference %d, frame: %s\n",
+			SPRITE_COUNT, straight_batches, ns_straight / 1000000.0, premultiplied_batches, ns_premultiplied / 1000000.0, psnr, max_difference,
+			is_frame_match ? "ok" : "MISMATCH");
+		std::printf("container: %s, gathered instances: %s, premultiplied material: %s, result: %s\n\n", is_cooked ? "ok" : "MISMATCH",
+			is_gathered ? "ok" : "MISMATCH", is_single_multiply ? "ok" : "MISMATCH", is_all_match ? "ok" : "MISMATCH");
+
+		if (!is_all_match) ReportFailure();
+	}
+}
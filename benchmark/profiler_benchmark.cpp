@@ -0,0 +1,65 @@
+#include <cstdio>
+
+#include "benchmark.h"
+#include "../profiler.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		// cost of a zone beyond its two timestamps
+		constexpr double MAX_ZONE_OVERHEAD_NS = 20.0;
+	}
+
+	/// <summary>
+	/// measure the cost of an empty zone next to the two timestamps it reads, and the export
+	/// the timer is up to the machine (an rdtsc is slow in some virtual machines), so only the rest of the zone is checked
+	/// </summary>
+	void RunProfiler()
+	{
+		std::printf("[profiler] zone overhead, at most %.0f ns beyond the timestamps\n", MAX_ZONE_OVERHEAD_NS);
+		std::printf("%10s %14s %14s %14s %14s %8s\n", "zones", "per zone", "timestamps", "overhead", "export", "result");
+
+		bool is_all_match = true;
+		const size_t zone_counts[] = { 1000, 60000 };
+		for (size_t zones : zone_counts)
+		{
+			double ns_zones = MeasureNanoseconds([zones]()
+			{
+				for (size_t i = 0; i < zones; ++i)
+				{
+					const Profiler::Zone zone("benchmark zone");
+				}
+			});
+
+			uint64_t ticks = 0;
+			double ns_timestamps = MeasureNanoseconds([zones, &ticks]()
+			{
+				for (size_t i = 0; i < zones; ++i)
+				{
+					ticks += Profiler::GetTimestamp();
+					ticks ^= Profiler::GetTimestamp();
+				}
+			});
+			DoNotOptimize(&ticks);
+
+			double ns_export = MeasureNanoseconds([]()
+			{
+				Profiler::Manager::Instance().WriteChromeTrace("benchmark_trace.json");
+			}, 1);
+
+			const double overhead = (ns_zones - ns_timestamps) / zones;
+			const bool is_match = overhead < MAX_ZONE_OVERHEAD_NS;
+			is_all_match = is_all_match && is_match;
+
+			std::printf("%10zu %11.2f ns %11.2f ns %11.2f ns %11.3f ms %8s\n", zones, ns_zones / zones, ns_timestamps / zones,
+				overhead, ns_export * 1e-6, is_match ? "ok" : "SLOW");
+			Profiler::Manager::Instance().Clear();
+		}
+
+		std::remove("benchmark_trace.json");
+		std::printf("\n");
+
+		if (!is_all_match) ReportFailure();
+	}
+}
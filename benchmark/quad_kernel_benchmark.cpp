@@ -0,0 +1,156 @@
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../quad_kernel.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		/// <summary>
+		/// sprite parameters laid out as one object per sprite
+		/// </summary>
+		struct SpriteObject
+		{
+			float Position[2];
+			float Scale[2];
+			float Texcoord[2];
+			float TexSize[2];
+			float Color[4];
+			float Rotation;
+		};
+
+		/// <summary>
+		/// the reference path: the scalar math over one object per sprite
+		/// </summary>
+		void GenerateQuadsReference(const std::vector<SpriteObject>& sprites, SpriteBatch::QuadVertex* p_vertex)
+		{
+			for (const SpriteObject& sprite : sprites)
+			{
+				float half_scale[2] = { sprite.Scale[0] * 0.5f, sprite.Scale[1] * 0.5f };
+
+				float angle  = static_cast<float>(atan2(static_cast<double>(half_scale[1]), static_cast<double>(half_scale[0])));
+				float radius = std::sqrt(half_scale[0] * half_scale[0] + half_scale[1] * half_scale[1]);
+				float rotation = sprite.Rotation;
+
+				const float x[4] =
+				{
+					sprite.Position[0] - static_cast<float>(cos(angle + rotation)) * radius,
+					sprite.Position[0] + static_cast<float>(cos(angle - rotation)) * radius,
+					sprite.Position[0] - static_cast<float>(cos(angle - rotation)) * radius,
+					sprite.Position[0] + static_cast<float>(cos(angle + rotation)) * radius
+				};
+				const float y[4] =
+				{
+					sprite.Position[1] - static_cast<float>(sin(angle + rotation)) * radius,
+					sprite.Position[1] - static_cast<float>(sin(angle - rotation)) * radius,
+					sprite.Position[1] + static_cast<float>(sin(angle - rotation)) * radius,
+					sprite.Position[1] + static_cast<float>(sin(angle + rotation)) * radius
+				};
+				const float u[4] = { sprite.Texcoord[0], sprite.Texcoord[0] + sprite.TexSize[0], sprite.Texcoord[0], sprite.Texcoord[0] + sprite.TexSize[0] };
+				const float v[4] = { sprite.Texcoord[1], sprite.Texcoord[1], sprite.Texcoord[1] + sprite.TexSize[1], sprite.Texcoord[1] + sprite.TexSize[1] };
+
+				// the vertex is written one field at a time
+				for (int c = 0; c < 4; ++c)
+				{
+					p_vertex[c].Position[0] = x[c];
+					p_vertex[c].Position[1] = y[c];
+					p_vertex[c].Position[2] = 0.0f;
+					for (int k = 0; k < 4; ++k) p_vertex[c].Color[k] = sprite.Color[k];
+					p_vertex[c].Texcoord[0] = u[c];
+					p_vertex[c].Texcoord[1] = v[c];
+				}
+				p_vertex += SpriteBatch::VERTICES_PER_QUAD;
+			}
+		}
+
+		/// <summary>
+		/// structure-of-arrays copy of the sprites
+		/// </summary>
+		struct SpriteSoa
+		{
+			std::vector<float> Data[13];
+
+			QuadKernel::SpriteArrays GetArrays() const
+			{
+				return { Data[0].data(), Data[1].data(), Data[2].data(), Data[3].data(), Data[4].data(),
+					Data[5].data(), Data[6].data(), Data[7].data(), Data[8].data(),
+					Data[9].data(), Data[10].data(), Data[11].data(), Data[12].data(), Data[0].size() };
+			}
+		};
+
+		/// <summary>
+		/// largest corner difference between two vertex arrays
+		/// </summary>
+		float MaxPositionError(const std::vector<SpriteBatch::QuadVertex>& a, const std::vector<SpriteBatch::QuadVertex>& b)
+		{
+			float error = 0.0f;
+			for (size_t i = 0; i < a.size(); ++i)
+			{
+				error = std::fmax(error, std::fabs(a[i].Position[0] - b[i].Position[0]));
+				error = std::fmax(error, std::fabs(a[i].Position[1] - b[i].Position[1]));
+			}
+			return error;
+		}
+	}
+
+	/// <summary>
+	/// compare the quad generation kernels with the reference path
+	/// </summary>
+	void RunQuadKernel()
+	{
+		std::printf("[quad kernel] best instruction set: %s\n", QuadKernel::GetInstructionSetName(QuadKernel::GetBestInstructionSet()));
+		std::printf("%10s %12s %12s %12s %12s %12s\n", "sprites", "reference", "scalar", "sse2", "avx2", "max error");
+
+		const size_t sprite_counts[] = { 10000, 100000, 1000000 };
+		for (size_t count : sprite_counts)
+		{
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> position(0.0f, 1920.0f);
+			std::uniform_real_distribution<float> scale(8.0f, 256.0f);
+			std::uniform_real_distribution<float> rotation(-6.2831853f, 6.2831853f);
+
+			// sprites in both layouts
+			std::vector<SpriteObject> objects(count);
+			SpriteSoa soa;
+			for (auto& data : soa.Data) data.resize(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				SpriteObject& object = objects[i];
+				object = { { position(random), position(random) }, { scale(random), scale(random) },
+					{ 0.0f, 0.0f }, { 1.0f, 1.0f }, { 1.0f, 1.0f, 1.0f, 1.0f }, rotation(random) };
+
+				const float values[13] = { object.Position[0], object.Position[1], object.Scale[0], object.Scale[1], object.Rotation,
+					object.Texcoord[0], object.Texcoord[1], object.TexSize[0], object.TexSize[1],
+					object.Color[0], object.Color[1], object.Color[2], object.Color[3] };
+				for (int k = 0; k < 13; ++k) soa.Data[k][i] = values[k];
+			}
+
+			std::vector<SpriteBatch::QuadVertex> reference(count * SpriteBatch::VERTICES_PER_QUAD);
+			std::vector<SpriteBatch::QuadVertex> output(count * SpriteBatch::VERTICES_PER_QUAD);
+			QuadKernel::SpriteArrays arrays = soa.GetArrays();
+
+			// measure
+			double ns_reference = MeasureNanoseconds([&]() { GenerateQuadsReference(objects, reference.data()); });
+
+			double ns_set[static_cast<int>(QuadKernel::InstructionSet::Maximum)] = {};
+			for (int s = 0; s < static_cast<int>(QuadKernel::InstructionSet::Maximum); ++s)
+			{
+				QuadKernel::InstructionSet set = static_cast<QuadKernel::InstructionSet>(s);
+				ns_set[s] = MeasureNanoseconds([&]() { QuadKernel::GenerateQuads(arrays, output.data(), set); });
+			}
+			DoNotOptimize(output.data());
+
+			std::printf("%10zu %9.2f ns %9.2f ns %9.2f ns %9.2f ns %12g\n", count,
+				ns_reference / count, ns_set[0] / count, ns_set[1] / count, ns_set[2] / count,
+				MaxPositionError(reference, output));
+		}
+
+		std::printf("\n");
+	}
+}
@@ -0,0 +1,224 @@
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "../shader_cache.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		constexpr const char* SHADER_DIRECTORY = "benchmark_shaders";
+		constexpr const char* CACHE_DIRECTORY  = "benchmark_shaders/cache";
+
+		/// <summary>
+		/// compiler standing in for D3DCompileFromFile, the bytecode is the source followed by the options
+		/// </summary>
+		class StandInCompiler : public ShaderCache::Compiler
+		{
+			uint64_t _version;
+			uint32_t _compileCount;
+
+		public:
+			StandInCompiler() : _version(1), _compileCount(0) {}
+
+			uint64_t GetVersion() const override { return _version; }
+
+			int Compile(const ShaderCache::Desc& desc, std::vector<uint8_t>* p_bytecode, std::string* p_errors) override
+			{
+				++_compileCount;
+				p_bytecode->clear();
+				p_errors->clear();
+
+				FILE* p_file = std::fopen(desc.Path.c_str(), "rb");
+				if (!p_file)
+				{
+					*p_errors = "cannot open " + desc.Path;
+					return -1;
+				}
+
+				int c = 0;
+				while ((c = std::fgetc(p_file)) != EOF) p_bytecode->push_back(static_cast<uint8_t>(c));
+				std::fclose(p_file);
+
+				std::string options = desc.EntryPoint + desc.Profile + std::to_string(desc.Flags);
+				for (const ShaderCache::Define& define : desc.Defines) options += define.Name + "=" + define.Value;
+				p_bytecode->insert(p_bytecode->end(), options.begin(), options.end());
+
+				return 0;
+			}
+
+			void SetVersion(uint64_t version) { _version = version; }
+			uint32_t GetCompileCount() const { return _compileCount; }
+		};
+
+		/// <summary>
+		/// write a text file of the scenario
+		/// </summary>
+		void WriteText(const std::string& path, const char* text)
+		{
+			FILE* p_file = std::fopen(path.c_str(), "wb");
+			if (!p_file) return;
+
+			std::fputs(text, p_file);
+			std::fclose(p_file);
+		}
+
+		/// <summary>
+		/// get the name of the result of a load
+		/// </summary>
+		const char* GetLoadName(int result)
+		{
+			switch (result)
+			{
+			case 0:  return "cached";
+			case 1:  return "compiled";
+			default: return "failed";
+			}
+		}
+	}
+
+	/// <summary>
+	/// load a shader through the cache with a stand-in compiler, after each change that must or must not invalidate it
+	/// </summary>
+	void RunShaderCache()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(SHADER_DIRECTORY, error);
+		std::filesystem::create_directories(SHADER_DIRECTORY, error);
+
+		const std::string source_path  = std::string(SHADER_DIRECTORY) + "/shader.hlsl";
+		const std::string header_path  = std::string(SHADER_DIRECTORY) + "/header.hlsli";
+		const std::string common_path  = std::string(SHADER_DIRECTORY) + "/common/common.hlsli";
+		const std::string option_path  = std::string(SHADER_DIRECTORY) + "/option.hlsli";
+		const std::string comment_path = std::string(SHADER_DIRECTORY) + "/comment.hlsli";
+
+		std::filesystem::create_directories(std::string(SHADER_DIRECTORY) + "/common", error);
+		WriteText(source_path,
+			"#include \"header.hlsli\"\n"
+			"// #include \"comment.hlsli\"\n"
+			"/* #include \"comment.hlsli\"\n"
+			"   */\n"
+			"#ifdef OPTION\n"
+			"  #  include <option.hlsli>\n"
+			"#endif\n"
+			"float4 main(float4 position : POSITION) : SV_POSITION { return Transform(position); }\n");
+		WriteText(header_path,
+			"#pragma once\n"
+			"#include \"common/common.hlsli\"\n"
+			"float4 Transform(float4 position) { return mul(position, WVP); }\n");
+		WriteText(common_path,
+			"#include \"../header.hlsli\"\n"
+			"cbuffer Transform : register(b0) { matrix WVP; }\n");
+		WriteText(comment_path, "edited without invalidating\n");
+
+		// the dependencies in the order they are first included, the commented includes are not followed
+		std::vector<std::string> files;
+		ShaderCache::ScanDependencies(source_path, &files);
+		const std::vector<std::string> expected_files = { source_path, header_path, common_path, option_path };
+
+		std::printf("[shader cache] stand-in compiler, dependencies of the scenario: %zu (%s)\n",
+			files.size(), files == expected_files ? "ok" : "MISMATCH");
+		std::printf("%-34s %10s %10s %10s %8s\n", "change", "expected", "load", "time", "result");
+
+		StandInCompiler compiler;
+		ShaderCache::Cache cache;
+		cache.Initialize(CACHE_DIRECTORY, &compiler);
+
+		ShaderCache::Desc desc = {};
+		desc.Path       = source_path;
+		desc.EntryPoint = "main";
+		desc.Profile    = "vs_5_0";
+		desc.Flags      = 0x800;
+
+		bool is_all_match = true;
+		std::vector<uint8_t> bytecode;
+		std::vector<uint8_t> compiled;
+		auto load = [&](const char* change, int expected)
+		{
+			// a compile replaces the entry, so only the first run is timed
+			int result = 0;
+			double ns = MeasureNanoseconds([&]() { result = cache.Load(desc, &bytecode); }, 1);
+
+			if (result == 1) compiled = bytecode;
+
+			// a cached entry gives back the bytes of the last compile
+			const bool is_match = result == expected && bytecode == compiled;
+			is_all_match = is_all_match && is_match;
+
+			std::printf("%-34s %10s %10s %7.1f us %8s\n", change, GetLoadName(expected), GetLoadName(result), ns / 1000.0, is_match ? "ok" : "MISMATCH");
+		};
+
+		load("first launch", 1);
+		load("second launch", 0);
+
+		WriteText(header_path,
+			"#pragma once\n"
+			"#include \"common/common.hlsli\"\n"
+			"float4 Transform(float4 position) { return mul(position, WVP); }\n");
+		load("include rewritten, same contents", 0);
+
+		WriteText(comment_path, "edited again\n");
+		load("commented include edited", 0);
+
+		WriteText(common_path,
+			"#include \"../header.hlsli\"\n"
+			"cbuffer Transform : register(b1) { matrix WVP; }\n");
+		load("nested include edited", 1);
+		load("second launch", 0);
+
+		WriteText(option_path, "#define HAS_OPTION\n");
+		load("missing include created", 1);
+
+		desc.Defines.push_back({ "OPTION", "1" });
+		load("define added", 1);
+		load("second launch", 0);
+
+		desc.Defines.back().Value = "2";
+		load("define value changed", 1);
+
+		desc.Profile = "vs_4_0";
+		load("profile changed", 1);
+
+		desc.Flags = 0x1;
+		load("flags changed", 1);
+
+		compiler.SetVersion(2);
+		load("compiler updated", 1);
+		load("second launch", 0);
+
+		// a torn write
+		std::filesystem::resize_file(cache.GetEntryPath(desc), sizeof(ShaderCache::FileHeader) + 4, error);
+		load("entry truncated", 1);
+		load("second launch", 0);
+
+		// without a cache directory, the bytecode is still returned
+		cache.Initialize(std::string(SHADER_DIRECTORY) + "/shader.hlsl/cache", &compiler);
+		load("cache not writable", 1);
+
+		const ShaderCache::Stats& stats = cache.GetStats();
+		std::printf("compiles: %u, write failures: %u, result: %s\n", compiler.GetCompileCount(), stats.WriteFailures, is_all_match ? "ok" : "MISMATCH");
+
+		// the cost of a launch with an up-to-date cache on the shaders of the renderer
+		const char* renderer_paths[] = { "resource/shader/vertex_shader.hlsl", "resource/shader/pixel_shader.hlsl" };
+		cache.Initialize(CACHE_DIRECTORY, &compiler);
+		for (const char* path : renderer_paths)
+		{
+			ShaderCache::Desc renderer_desc = { path, "main", "vs_5_0", {}, 0 };
+			if (ShaderCache::ScanDependencies(path, &files) != 0)
+				continue;
+
+			cache.Load(renderer_desc, &bytecode);
+			double ns = MeasureNanoseconds([&]() { cache.Load(renderer_desc, &bytecode); });
+			std::printf("%-34s %zu files, %7.1f us per warm load\n", path, files.size(), ns / 1000.0);
+		}
+
+		cache.Terminate();
+		std::filesystem::remove_all(SHADER_DIRECTORY, error);
+
+		std::printf("\n");
+	}
+}
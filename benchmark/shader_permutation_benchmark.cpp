@@ -0,0 +1,165 @@
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../quad_kernel.h"
+#include "../shader_permutation.h"
+#include "../software_renderer.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		constexpr const char* MANIFEST_PATH = "benchmark_permutations.txt";
+
+		// sprites of a frame, the pixels dominate the cost
+		constexpr size_t SPRITE_COUNT = 500;
+
+		/// <summary>
+		/// FNV-1a hash of the presented frame
+		/// </summary>
+		uint64_t HashFrame(const SoftwareRenderer::Manager& software)
+		{
+			const uint32_t* p_pixels = software.GetFrameBuffer();
+			const size_t count = static_cast<size_t>(software.GetWidth()) * software.GetHeight();
+
+			uint64_t hash = 0xcbf29ce484222325ull;
+			for (size_t i = 0; i < count; ++i) hash = (hash ^ p_pixels[i]) * 0x100000001b3ull;
+			return hash;
+		}
+
+		/// <summary>
+		/// corners of random sprites with translucent colors
+		/// </summary>
+		std::vector<SpriteBatch::QuadVertex> CreateQuads()
+		{
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> position_x(0.0f, static_cast<float>(Renderer::SCREEN_RESOLUTION_WIDTH));
+			std::uniform_real_distribution<float> position_y(0.0f, static_cast<float>(Renderer::SCREEN_RESOLUTION_HEIGHT));
+			std::uniform_real_distribution<float> scale(16.0f, 64.0f);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+			std::vector<float> data[13];
+			for (auto& values : data) values.resize(SPRITE_COUNT);
+			for (size_t i = 0; i < SPRITE_COUNT; ++i)
+			{
+				const float values[13] = { position_x(random), position_y(random), scale(random), scale(random), unit(random) * 6.0f,
+					0.0f, 0.0f, 1.0f, 1.0f, unit(random), unit(random), unit(random), unit(random) };
+				for (int k = 0; k < 13; ++k) data[k][i] = values[k];
+			}
+
+			const QuadKernel::SpriteArrays arrays =
+			{
+				data[0].data(), data[1].data(), data[2].data(), data[3].data(), data[4].data(),
+				data[5].data(), data[6].data(), data[7].data(), data[8].data(),
+				data[9].data(), data[10].data(), data[11].data(), data[12].data(), SPRITE_COUNT
+			};
+
+			std::vector<SpriteBatch::QuadVertex> quads(SPRITE_COUNT * SpriteBatch::VERTICES_PER_QUAD);
+			QuadKernel::GenerateQuads(arrays, quads.data());
+
+			return quads;
+		}
+
+		/// <summary>
+		/// checkerboard with transparent squares
+		/// </summary>
+		SoftwareRenderer::Texture CreateTexture()
+		{
+			SoftwareRenderer::Texture texture;
+			texture.Width  = 32;
+			texture.Height = 32;
+			texture.Texels.resize(32 * 32);
+			for (uint32_t y = 0; y < 32; ++y)
+			{
+				for (uint32_t x = 0; x < 32; ++x)
+				{
+					texture.Texels[y * 32 + x] = ((x / 8 + y / 8) % 2) ? 0x40ff8020u : 0xffffffffu;
+				}
+			}
+
+			return texture;
+		}
+	}
+
+	/// <summary>
+	/// draw a frame with every variant of the pixel shader on the software renderer, whose variants are specialized like the hlsl ones
+	/// a white tint and a zero alpha threshold must draw the same pixels as the variant without them
+	/// </summary>
+	void RunShaderPermutation()
+	{
+		// the names and the manifest round trip
+		bool is_parsed = true;
+		std::vector<ShaderPermutation::Key> all_keys;
+		for (ShaderPermutation::Key key = 0; key < ShaderPermutation::VARIANT_COUNT; ++key)
+		{
+			ShaderPermutation::Key parsed = 0;
+			is_parsed = is_parsed && ShaderPermutation::ParseKey(ShaderPermutation::GetKeyName(key), &parsed) == 0 && parsed == key;
+			all_keys.push_back(key);
+		}
+
+		std::vector<ShaderPermutation::Key> loaded_keys;
+		const bool is_manifest_ok =
+			ShaderPermutation::SaveManifest(MANIFEST_PATH, all_keys) == 0 &&
+			ShaderPermutation::LoadManifest(MANIFEST_PATH, &loaded_keys) == 0 && loaded_keys == all_keys;
+		std::remove(MANIFEST_PATH);
+
+		std::vector<ShaderPermutation::Key> shipped_keys;
+		const int shipped_result = ShaderPermutation::LoadManifest(ShaderPermutation::MANIFEST_PATH, &shipped_keys);
+
+		std::printf("[shader permutation] %u variants, shipped: ", ShaderPermutation::VARIANT_COUNT);
+		if (shipped_result == 0) std::printf("%zu", shipped_keys.size());
+		else                     std::printf("no manifest");
+		std::printf(", names: %s, manifest: %s\n", is_parsed ? "ok" : "MISMATCH", is_manifest_ok ? "ok" : "MISMATCH");
+		std::printf("%-40s %12s %16s %8s\n", "variant", "frame", "hash", "result");
+
+		SoftwareRenderer::Manager& software = SoftwareRenderer::Manager::Instance();
+		software.Initialize();
+		software.SetDepthEnableState(Renderer::DepthEnebleMode::Disable);
+		software.SetCullingMode(Renderer::CullMode::None);
+		software.SetMatrixWorldViewProjection2D();
+
+		const std::vector<SpriteBatch::QuadVertex> quads = CreateQuads();
+		const SoftwareRenderer::Texture texture = CreateTexture();
+		software.SetTexture(&texture);
+
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		uint64_t hashes[ShaderPermutation::VARIANT_COUNT] = {};
+		bool is_all_match = true;
+		for (ShaderPermutation::Key key = 0; key < ShaderPermutation::VARIANT_COUNT; ++key)
+		{
+			software.SetMaterial(white, key, 0.0f);
+			double ns = MeasureNanoseconds([&]()
+			{
+				software.ClearViews();
+				for (size_t i = 0; i < SPRITE_COUNT; ++i) software.Draw(&quads[i * SpriteBatch::VERTICES_PER_QUAD], SpriteBatch::VERTICES_PER_QUAD);
+				software.FlipFrameBuffer();
+			}, 3);
+			hashes[key] = HashFrame(software);
+
+			// the variants are in increasing order, so the reduced one is already drawn
+			const ShaderPermutation::Key reduced = key & ~(ShaderPermutation::FEATURE_TINT | ShaderPermutation::FEATURE_ALPHA_TEST);
+			const bool is_match = hashes[key] == hashes[reduced];
+			is_all_match = is_all_match && is_match;
+
+			std::printf("%-40s %9.3f ms %016llx %8s\n", ShaderPermutation::GetKeyName(key).c_str(), ns / 1000000.0,
+				static_cast<unsigned long long>(hashes[key]), is_match ? "ok" : "MISMATCH");
+		}
+
+		// the alpha test discards the transparent squares
+		software.SetMaterial(white, ShaderPermutation::FEATURE_TEXTURED | ShaderPermutation::FEATURE_ALPHA_TEST, 0.5f);
+		software.ClearViews();
+		for (size_t i = 0; i < SPRITE_COUNT; ++i) software.Draw(&quads[i * SpriteBatch::VERTICES_PER_QUAD], SpriteBatch::VERTICES_PER_QUAD);
+		software.FlipFrameBuffer();
+		const bool is_discarded = HashFrame(software) != hashes[ShaderPermutation::FEATURE_TEXTURED];
+
+		// the following scenarios draw with the default material again
+		software.SetMaterial(white, ShaderPermutation::DEFAULT_KEY, 0.0f);
+		software.SetTexture(nullptr);
+		software.Terminate();
+
+		std::printf("alpha test discards: %s, result: %s\n\n", is_discarded ? "ok" : "MISMATCH", is_all_match ? "ok" : "MISMATCH");
+	}
+}
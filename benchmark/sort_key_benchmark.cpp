@@ -0,0 +1,139 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "../sort_key.h"
+#include "../thread_pool.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		/// <summary>
+		/// kind of keys in a scenario
+		/// </summary>
+		enum class KeyKind
+		{
+			Sprites,        // a few layers, depths, blend modes and textures, in creation order
+			SpritesCulled,  // the same, in the order of the culling grid
+			Random,         // every bit of the key and the value
+		};
+
+		/// <summary>
+		/// get the name of a kind of keys
+		/// </summary>
+		const char* GetKeyKindName(KeyKind kind)
+		{
+			switch (kind)
+			{
+			case KeyKind::Sprites:       return "sprites";
+			case KeyKind::SpritesCulled: return "culled";
+			default:                     return "random";
+			}
+		}
+
+		/// <summary>
+		/// fill the keys and values of a scenario
+		/// </summary>
+		void CreateKeys(KeyKind kind, size_t count, std::vector<uint64_t>& keys, std::vector<uint32_t>& values)
+		{
+			std::mt19937_64 random(12345);
+			keys.resize(count);
+			values.resize(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (kind == KeyKind::Random)
+				{
+					keys[i]   = random();
+					values[i] = static_cast<uint32_t>(random());
+					continue;
+				}
+
+				SortKey::Fields fields = {};
+				fields.Layer   = static_cast<uint32_t>(random() % 4);
+				fields.Depth   = static_cast<float>(random() % 16);
+				fields.Blend   = static_cast<Renderer::BlendMode>(random() % static_cast<uint32_t>(Renderer::BlendMode::Maximum));
+				fields.Texture = static_cast<uint32_t>(random() % 64);
+				keys[i]   = SortKey::Make(fields);
+				values[i] = static_cast<uint32_t>(i);
+			}
+
+			if (kind == KeyKind::SpritesCulled)
+			{
+				std::shuffle(values.begin(), values.end(), random);
+			}
+		}
+	}
+
+	/// <summary>
+	/// sort keys of draws with the radix sort against std::sort, and the state changes it saves
+	/// sorting the same number of keys again must not allocate
+	/// </summary>
+	void RunSortKey()
+	{
+		ThreadPool::Manager::Instance().Initialize();
+		const size_t thread_count = ThreadPool::Manager::Instance().GetWorkerCount() + 1;
+
+		std::printf("[sort key] threads: %zu\n", thread_count);
+		std::printf("%10s %8s %12s %12s %7s %11s %7s %12s %12s %8s\n", "keys", "kind", "std::sort", "sorter", "passes", "path", "allocs", "unsorted", "sorted", "result");
+
+		const size_t key_counts[] = { 10000, 100000, 1000000 };
+		const KeyKind kinds[] = { KeyKind::Sprites, KeyKind::SpritesCulled, KeyKind::Random };
+
+		SortKey::Sorter sorter;
+		std::vector<uint64_t> source_keys, keys;
+		std::vector<uint32_t> source_values, values;
+		std::vector<std::pair<uint64_t, uint32_t>> pairs;
+		bool is_all_match = true;
+
+		for (size_t count : key_counts)
+		{
+			for (KeyKind kind : kinds)
+			{
+				CreateKeys(kind, count, source_keys, source_values);
+
+				// the copy of the input is part of both measurements
+				pairs.resize(count);
+				double ns_std = MeasureNanoseconds([&]()
+				{
+					for (size_t i = 0; i < count; ++i) pairs[i] = { source_keys[i], source_values[i] };
+					std::sort(pairs.begin(), pairs.end());
+				});
+
+				double ns_radix = MeasureNanoseconds([&]()
+				{
+					keys   = source_keys;
+					values = source_values;
+					sorter.Sort(keys.data(), values.data(), count);
+				});
+
+				// the buffers of the sorter and the copies have grown by now
+				keys   = source_keys;
+				values = source_values;
+				const uint64_t allocations = GetAllocationCount();
+				sorter.Sort(keys.data(), values.data(), count);
+				const uint64_t sort_allocations = GetAllocationCount() - allocations;
+
+				bool is_match = sort_allocations == 0;
+				for (size_t i = 0; i < count && is_match; ++i)
+				{
+					is_match = keys[i] == pairs[i].first && values[i] == pairs[i].second;
+				}
+
+				const SortKey::SortStats& stats = sorter.GetLastStats();
+				std::printf("%10zu %8s %9.2f ms %9.2f ms %7u %11s %7llu %12u %12u %8s\n", count, GetKeyKindName(kind),
+					ns_std / 1000000.0, ns_radix / 1000000.0, stats.Passes, stats.IsComparisonSort ? "comparison" : "radix",
+					static_cast<unsigned long long>(sort_allocations), stats.StateChangesUnsorted, stats.StateChanges, is_match ? "ok" : "MISMATCH");
+				is_all_match = is_all_match && is_match;
+			}
+		}
+
+		std::printf("\n");
+		if (!is_all_match) ReportFailure();
+	}
+}
@@ -0,0 +1,446 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../material_table.h"
+#include "../quad_kernel.h"
+#include "../software_renderer.h"
+#include "../sort_key.h"
+#include "../sprite_batch_core.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		// machine readable results, diffed between releases
+		constexpr const char* SPRITE_RESULTS_PATH = "sprite_benchmark.json";
+		constexpr int SPRITE_RESULTS_VERSION = 3;
+
+		// the software renderer rasterizes every pixel, so it only runs the small scenarios
+		constexpr size_t MAX_CPU_BACKEND_SPRITES = 1000;
+
+		// small scenarios are repeated within one measurement to get above the timer resolution
+		constexpr size_t MIN_SPRITES_PER_MEASUREMENT = 100000;
+
+		/// <summary>
+		/// mix of textures and blend modes in a scenario
+		/// </summary>
+		struct Mix
+		{
+			const char* Name;
+			uint32_t Textures;
+			float AddRatio;  // the rest is drawn with alpha blending
+		};
+
+		/// <summary>
+		/// results of one scenario
+		/// </summary>
+		struct Result
+		{
+			size_t Sprites;
+			const Mix* SpriteMix;
+
+			// ns per sprite of each stage
+			double PackNs;
+			double ConstantNs;
+			double BatchNs;
+			double FrameNs;
+			double CpuFrameNs;  // 0 if the scenario is too large for the software renderer
+
+			// per frame
+			uint64_t Allocations;
+			uint64_t UploadBytes;
+			uint32_t Draws;
+			uint32_t ConstantUpdates;
+		};
+
+		//--------------------------------------------------------
+		// backends
+		//--------------------------------------------------------
+		/// <summary>
+		/// sprite batch backend which keeps the ring in memory and only counts the draws
+		/// </summary>
+		class NullBatchBackend : public SpriteBatch::Backend
+		{
+			std::vector<SpriteBatch::SpriteInstance> _ring;
+			uint32_t _draws;
+
+		public:
+			explicit NullBatchBackend(uint32_t capacityQuads)
+				: _ring(capacityQuads), _draws(0)
+			{
+			}
+
+			SpriteBatch::SpriteInstance* MapRing(bool) override { return _ring.data(); }
+			void UnmapRing() override {}
+			void DrawRun(const SpriteBatch::Run&) override { _draws++; }
+
+			uint32_t TakeDraws() { uint32_t draws = _draws; _draws = 0; return draws; }
+		};
+
+		/// <summary>
+		/// material table backend in memory
+		/// </summary>
+		class NullMaterialBackend : public MaterialTable::Backend
+		{
+			std::vector<MaterialTable::Constants> _table;
+
+		public:
+			explicit NullMaterialBackend(uint32_t capacity) : _table(capacity) {}
+
+			void UploadMaterials(const MaterialTable::Constants* p_constants, MaterialTable::Index first, uint32_t count) override
+			{
+				std::copy(p_constants, p_constants + count, _table.begin() + first);
+			}
+		};
+
+		//--------------------------------------------------------
+		// scene
+		//--------------------------------------------------------
+		/// <summary>
+		/// sprites of a scenario in structure-of-arrays layout
+		/// </summary>
+		struct Scene
+		{
+			std::vector<float> Data[13];
+			std::vector<uint32_t> Texture;
+			std::vector<Renderer::BlendMode> Blend;
+
+			// one material per texture
+			std::vector<MaterialTable::Constants> Materials;
+			std::vector<SoftwareRenderer::Texture> Textures;
+
+			size_t GetCount() const { return Texture.size(); }
+
+			QuadKernel::SpriteArrays GetArrays() const
+			{
+				return { Data[0].data(), Data[1].data(), Data[2].data(), Data[3].data(), Data[4].data(),
+					Data[5].data(), Data[6].data(), Data[7].data(), Data[8].data(),
+					Data[9].data(), Data[10].data(), Data[11].data(), Data[12].data(), GetCount() };
+			}
+
+			SpriteBatch::TextureId GetTextureId(uint32_t texture) const
+			{
+				return reinterpret_cast<SpriteBatch::TextureId>(&Textures[texture]);
+			}
+		};
+
+		/// <summary>
+		/// creates random sprites on the screen with a mix of textures and blend modes
+		/// </summary>
+		void CreateScene(size_t count, const Mix& mix, Scene& scene)
+		{
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> position_x(0.0f, static_cast<float>(Renderer::SCREEN_RESOLUTION_WIDTH));
+			std::uniform_real_distribution<float> position_y(0.0f, static_cast<float>(Renderer::SCREEN_RESOLUTION_HEIGHT));
+			std::uniform_real_distribution<float> scale(8.0f, 64.0f);
+			std::uniform_real_distribution<float> rotation(-3.1415926f, 3.1415926f);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+			std::uniform_int_distribution<uint32_t> texture(0, mix.Textures - 1);
+
+			for (auto& data : scene.Data) data.resize(count);
+			scene.Texture.resize(count);
+			scene.Blend.resize(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float values[13] = { position_x(random), position_y(random), scale(random), scale(random), rotation(random),
+					0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+				for (int k = 0; k < 13; ++k) scene.Data[k][i] = values[k];
+
+				scene.Texture[i] = texture(random);
+				scene.Blend[i] = (unit(random) < mix.AddRatio) ? Renderer::BlendMode::Add : Renderer::BlendMode::AlphaBlend;
+			}
+
+			scene.Materials.assign(mix.Textures, MaterialTable::Constants());
+			scene.Textures.assign(mix.Textures, SoftwareRenderer::Texture());
+			for (uint32_t t = 0; t < mix.Textures; ++t)
+			{
+				MaterialTable::Constants& material = scene.Materials[t];
+				material = MaterialTable::Table::GetDefaultConstants();
+				material.Diffuse[0] = static_cast<float>(t) / mix.Textures;
+
+				SoftwareRenderer::Texture& software_texture = scene.Textures[t];
+				software_texture.Width  = 16;
+				software_texture.Height = 16;
+				software_texture.Texels.assign(16 * 16, 0xff000000u | (t * 0x00102040u));
+			}
+		}
+
+		//--------------------------------------------------------
+		// frame
+		//--------------------------------------------------------
+		/// <summary>
+		/// everything the sprite path needs for a frame, allocated up front
+		/// </summary>
+		class FramePipeline
+		{
+			const Scene* _scene;
+			std::vector<SpriteBatch::SpriteInstance> _instances;
+			std::vector<uint64_t> _keys;
+			std::vector<uint32_t> _indices;
+			SortKey::Sorter _sorter;
+
+			MaterialTable::Table _materials;
+			SpriteBatch::Batcher _batcher;
+
+			// slot of the material of each texture
+			std::vector<MaterialTable::Index> _materialIndices;
+
+		public:
+			FramePipeline(const Scene& scene, MaterialTable::Backend& materialBackend, SpriteBatch::Backend& batchBackend)
+			{
+				_scene = &scene;
+				_instances.resize(scene.GetCount());
+				_keys.resize(scene.GetCount());
+				_indices.resize(scene.GetCount());
+
+				// the materials are registered once, as Texture::Manager::Initialize does
+				_materials.Initialize(&materialBackend);
+				for (const MaterialTable::Constants& material : scene.Materials)
+				{
+					_materialIndices.push_back(_materials.Register(material, ShaderPermutation::DEFAULT_KEY));
+				}
+				_materials.Flush();
+
+				_batcher.Initialize(&batchBackend);
+			}
+
+			~FramePipeline()
+			{
+				_batcher.Terminate();
+				_materials.Terminate();
+			}
+
+			/// <summary>
+			/// instance packing as in Sprite::Manager::Draw, with the material slot of each sprite
+			/// </summary>
+			void PackInstances()
+			{
+				QuadKernel::PackInstances(_scene->GetArrays(), _scene->Texture.data(), _instances.data());
+				for (size_t i = 0; i < _instances.size(); ++i) _instances[i].Material = _materialIndices[_scene->Texture[i]];
+			}
+
+			/// <summary>
+			/// sort by state as in Sprite::Manager::Draw, so consecutive sprites share a draw
+			/// </summary>
+			void Sort()
+			{
+				for (size_t i = 0; i < _keys.size(); ++i)
+				{
+					const ShaderPermutation::Key features = _materials.GetFeatures(_materialIndices[_scene->Texture[i]]);
+					_keys[i] = SortKey::Make({ 0, 0.0f, features, _scene->Blend[i], _scene->Texture[i] });
+					_indices[i] = static_cast<uint32_t>(i);
+				}
+				_sorter.Sort(_keys.data(), _indices.data(), _keys.size());
+			}
+
+			/// <summary>
+			/// material uploads of a frame, as Renderer::ClearViews (only the edited slots, none in these scenarios)
+			/// </summary>
+			void UpdateConstants()
+			{
+				_materials.Flush();
+			}
+
+			/// <summary>
+			/// allocate the instance of a sprite in a run of its texture, blend mode and variant of the pixel shader
+			/// </summary>
+			SpriteBatch::SpriteInstance* Allocate(uint32_t i)
+			{
+				const ShaderPermutation::Key features = _materials.GetFeatures(_instances[i].Material);
+				return _batcher.Allocate(_scene->GetTextureId(_scene->Texture[i]), _scene->Blend[i], features);
+			}
+
+			/// <summary>
+			/// copy the sorted instances into the batcher
+			/// </summary>
+			void Batch()
+			{
+				_batcher.Begin();
+				for (uint32_t i : _indices) *Allocate(i) = _instances[i];
+				_batcher.End();
+			}
+
+			/// <summary>
+			/// one whole frame of the sprite path
+			/// </summary>
+			void SubmitFrame()
+			{
+				PackInstances();
+				Sort();
+
+				UpdateConstants();
+
+				_batcher.Begin();
+				for (uint32_t i : _indices) *Allocate(i) = _instances[i];
+				_batcher.End();
+			}
+
+			// getter
+			const SpriteBatch::FrameStats& GetLastBatchStats() const { return _batcher.GetLastFrameStats(); }
+			const MaterialTable::FrameStats& GetLastMaterialStats() const { return _materials.GetLastFrameStats(); }
+			const MaterialTable::Table& GetMaterials() const { return _materials; }
+			const SpriteBatch::SpriteInstance* GetInstances() const { return _instances.data(); }
+		};
+
+		/// <summary>
+		/// measure a stage in ns per sprite, repeating small scenarios
+		/// </summary>
+		template <typename Func>
+		double MeasureNsPerSprite(size_t sprites, Func&& func)
+		{
+			const size_t iterations = std::max<size_t>(1, MIN_SPRITES_PER_MEASUREMENT / sprites);
+			double ns = MeasureNanoseconds([&]()
+			{
+				for (size_t i = 0; i < iterations; ++i) func();
+			});
+			return ns / (static_cast<double>(iterations) * sprites);
+		}
+
+		/// <summary>
+		/// run every stage of a scenario
+		/// </summary>
+		Result RunScenario(size_t count, const Mix& mix)
+		{
+			Scene scene;
+			CreateScene(count, mix, scene);
+
+			Result result = {};
+			result.Sprites   = count;
+			result.SpriteMix = &mix;
+
+			NullMaterialBackend material_backend(MaterialTable::DEFAULT_CAPACITY);
+			NullBatchBackend batch_backend(SpriteBatch::DEFAULT_RING_CAPACITY_QUADS);
+			{
+				FramePipeline pipeline(scene, material_backend, batch_backend);
+
+				// stages on their own
+				result.PackNs     = MeasureNsPerSprite(count, [&]() { pipeline.PackInstances(); });
+				result.ConstantNs = MeasureNsPerSprite(count, [&]() { pipeline.UpdateConstants(); });
+				pipeline.Sort();
+				result.BatchNs    = MeasureNsPerSprite(count, [&]() { pipeline.Sort(); pipeline.Batch(); });
+
+				// end-to-end against the null backend
+				result.FrameNs = MeasureNsPerSprite(count, [&]() { pipeline.SubmitFrame(); });
+
+				// a warmed up frame should not touch the heap
+				const uint64_t allocations = GetAllocationCount();
+				batch_backend.TakeDraws();
+				pipeline.SubmitFrame();
+				result.Allocations = GetAllocationCount() - allocations;
+
+				result.Draws           = batch_backend.TakeDraws();
+				result.ConstantUpdates = pipeline.GetLastMaterialStats().UploadCalls;
+				result.UploadBytes     = pipeline.GetLastBatchStats().Bytes + pipeline.GetLastMaterialStats().UploadBytes;
+
+				DoNotOptimize(pipeline.GetInstances());
+			}
+
+			// end-to-end against the software renderer
+			if (count <= MAX_CPU_BACKEND_SPRITES)
+			{
+				SoftwareRenderer::Manager& software = SoftwareRenderer::Manager::Instance();
+				FramePipeline pipeline(scene, material_backend, software);
+
+				software.SetMatrixWorldViewProjection2D();
+				software.SetMaterialTable(&pipeline.GetMaterials());
+				double ns = MeasureNanoseconds([&]()
+				{
+					software.ClearViews();
+					pipeline.SubmitFrame();
+					software.FlipFrameBuffer();
+				});
+				result.CpuFrameNs = ns / count;
+
+				software.SetMaterialTable(nullptr);
+			}
+
+			return result;
+		}
+
+		/// <summary>
+		/// write the results as json, one scenario per line so releases diff line by line
+		/// </summary>
+		bool WriteResults(const char* path, const std::vector<Result>& results)
+		{
+			std::FILE* p_file = std::fopen(path, "w");
+			if (!p_file)
+				return false;
+
+			std::fprintf(p_file, "{\n\t\"version\": %d,\n\t\"instruction_set\": \"%s\",\n\t\"scenarios\": [\n",
+				SPRITE_RESULTS_VERSION, QuadKernel::GetInstructionSetName(QuadKernel::GetBestInstructionSet()));
+
+			for (size_t r = 0; r < results.size(); ++r)
+			{
+				const Result& result = results[r];
+				const double frames_per_second = 1e9 / (result.FrameNs * result.Sprites);
+				const double cpu_frames_per_second = result.CpuFrameNs > 0.0 ? 1e9 / (result.CpuFrameNs * result.Sprites) : 0.0;
+
+				std::fprintf(p_file,
+					"\t\t{ \"sprites\": %zu, \"mix\": \"%s\", \"textures\": %u, \"add_ratio\": %.2f, "
+					"\"pack_ns_per_sprite\": %.3f, \"constant_ns_per_sprite\": %.3f, \"batch_ns_per_sprite\": %.3f, "
+					"\"frame_ns_per_sprite\": %.3f, \"frames_per_second\": %.2f, \"cpu_frames_per_second\": %.2f, "
+					"\"allocations_per_frame\": %llu, \"upload_bytes_per_frame\": %llu, \"draws_per_frame\": %u, \"constant_updates_per_frame\": %u }%s\n",
+					result.Sprites, result.SpriteMix->Name, result.SpriteMix->Textures, result.SpriteMix->AddRatio,
+					result.PackNs, result.ConstantNs, result.BatchNs,
+					result.FrameNs, frames_per_second, cpu_frames_per_second,
+					static_cast<unsigned long long>(result.Allocations), static_cast<unsigned long long>(result.UploadBytes),
+					result.Draws, result.ConstantUpdates, (r + 1 < results.size()) ? "," : "");
+			}
+
+			std::fprintf(p_file, "\t]\n}\n");
+			std::fclose(p_file);
+
+			return true;
+		}
+	}
+
+	/// <summary>
+	/// measure the sprite path from instance packing to submission, without a window
+	/// </summary>
+	void RunSpriteThroughput()
+	{
+		const Mix mixes[] =
+		{
+			{ "single", 1, 0.0f },
+			{ "textures", 16, 0.0f },
+			{ "textures_blend", 16, 0.5f },
+			{ "atlas_pages", 256, 0.1f },
+		};
+		const size_t sprite_counts[] = { 1, 100, 10000, 100000, 1000000 };
+
+		SoftwareRenderer::Manager::Instance().Initialize();
+
+		std::printf("[sprite throughput] ns per sprite, null backend unless noted\n");
+		std::printf("%8s %15s %9s %9s %10s %9s %10s %10s %7s %8s %12s\n",
+			"sprites", "mix", "pack", "constant", "sort+batch", "frame", "frames/s", "cpu fps", "allocs", "draws", "bytes");
+
+		std::vector<Result> results;
+		for (size_t count : sprite_counts)
+		{
+			for (const Mix& mix : mixes)
+			{
+				Result result = RunScenario(count, mix);
+				results.push_back(result);
+
+				std::printf("%8zu %15s %9.2f %9.2f %10.2f %9.2f %10.1f %10.1f %7llu %8u %12llu\n",
+					count, mix.Name, result.PackNs, result.ConstantNs, result.BatchNs, result.FrameNs,
+					1e9 / (result.FrameNs * count), result.CpuFrameNs > 0.0 ? 1e9 / (result.CpuFrameNs * count) : 0.0,
+					static_cast<unsigned long long>(result.Allocations), result.Draws, static_cast<unsigned long long>(result.UploadBytes));
+			}
+		}
+
+		SoftwareRenderer::Manager::Instance().Terminate();
+
+		if (WriteResults(SPRITE_RESULTS_PATH, results))
+			std::printf("results written to %s\n", SPRITE_RESULTS_PATH);
+		std::printf("\n");
+	}
+}
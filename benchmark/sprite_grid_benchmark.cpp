@@ -0,0 +1,107 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../sprite_grid.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		// the view is 1% of the world
+		constexpr float VIEW_WIDTH  = 1920.0f;
+		constexpr float VIEW_HEIGHT = 1080.0f;
+		constexpr float WORLD_SCALE = 10.0f;
+
+		/// <summary>
+		/// dense indices of the visible sprites by testing every sprite
+		/// </summary>
+		void QueryBruteForce(const SpriteRegistry::Registry& registry, const Renderer::ViewRect& view, std::vector<uint32_t>& indices)
+		{
+			indices.clear();
+			for (uint32_t i = 0; i < registry.GetCount(); ++i)
+			{
+				Renderer::ViewRect bounds = SpriteGrid::Grid::ComputeBounds(registry, i);
+				if (bounds.Left <= view.Right && bounds.Right >= view.Left && bounds.Top <= view.Bottom && bounds.Bottom >= view.Top)
+					indices.push_back(i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// synchronization and view queries of the sprite grid in a world 100 times the view
+	/// </summary>
+	void RunSpriteGrid()
+	{
+		std::printf("[sprite grid] view %.0fx%.0f in a world %.0fx%.0f\n", VIEW_WIDTH, VIEW_HEIGHT, VIEW_WIDTH * WORLD_SCALE, VIEW_HEIGHT * WORLD_SCALE);
+		std::printf("%10s %12s %12s %12s %10s %10s %8s\n", "sprites", "insert", "sync", "sync moved", "query", "visible", "result");
+
+		const Renderer::ViewRect world = { 0.0f, 0.0f, VIEW_WIDTH * WORLD_SCALE, VIEW_HEIGHT * WORLD_SCALE };
+
+		const size_t sprite_counts[] = { 100000, 1000000, 10000000 };
+		for (size_t count : sprite_counts)
+		{
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> position_x(world.Left, world.Right);
+			std::uniform_real_distribution<float> position_y(world.Top, world.Bottom);
+			std::uniform_real_distribution<float> scale(8.0f, 64.0f);
+			std::uniform_real_distribution<float> rotation(-3.14159265f, 3.14159265f);
+
+			SpriteRegistry::Registry registry;
+			registry.Reserve(static_cast<uint32_t>(count));
+
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			for (size_t i = 0; i < count; ++i)
+			{
+				desc.Position[0] = position_x(random);
+				desc.Position[1] = position_y(random);
+				desc.Scale[0]    = scale(random);
+				desc.Scale[1]    = scale(random);
+				desc.Rotation    = rotation(random);
+				registry.Create(desc);
+			}
+
+			// the first synchronization inserts every sprite
+			SpriteGrid::Grid grid;
+			grid.Initialize(world);
+			double ns_insert = MeasureNanoseconds([&]() { grid.Synchronize(registry); }, 1);
+
+			// nothing moved
+			double ns_sync = MeasureNanoseconds([&]() { grid.Synchronize(registry); });
+
+			// every sprite moved by a step, a few of them into another cell
+			SpriteRegistry::Transforms& transforms = registry.GetTransforms();
+			double ns_sync_moved = MeasureNanoseconds([&]()
+			{
+				registry.SavePreviousState();
+				for (uint32_t i = 0; i < registry.GetCount(); ++i) transforms.PositionX[i] += 2.0f;
+				grid.Synchronize(registry);
+			});
+
+			// a view in the middle of the world
+			const float left = (world.Right - VIEW_WIDTH) * 0.5f;
+			const float top  = (world.Bottom - VIEW_HEIGHT) * 0.5f;
+			const Renderer::ViewRect view = { left, top, left + VIEW_WIDTH, top + VIEW_HEIGHT };
+
+			std::vector<uint32_t> visible, expected;
+			visible.reserve(count / 50);
+			double ns_query = MeasureNanoseconds([&]() { grid.Query(view, &visible); });
+
+			// the query comes out in the order of the cells
+			QueryBruteForce(registry, view, expected);
+			std::sort(visible.begin(), visible.end());
+
+			std::printf("%10zu %9.2f ns %9.2f ns %9.2f ns %7.3f ms %10zu %8s\n", count,
+				ns_insert / count, ns_sync / count, ns_sync_moved / count, ns_query / 1000000.0,
+				visible.size(), visible == expected ? "ok" : "MISMATCH");
+		}
+
+		std::printf("\n");
+	}
+}
@@ -0,0 +1,137 @@
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../quad_kernel.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		/// <summary>
+		/// structure-of-arrays sprites and their texture indices
+		/// </summary>
+		struct SpriteSoa
+		{
+			std::vector<float> Data[13];
+			std::vector<uint32_t> Textures;
+
+			QuadKernel::SpriteArrays GetArrays() const
+			{
+				return { Data[0].data(), Data[1].data(), Data[2].data(), Data[3].data(), Data[4].data(),
+					Data[5].data(), Data[6].data(), Data[7].data(), Data[8].data(),
+					Data[9].data(), Data[10].data(), Data[11].data(), Data[12].data(), Data[0].size() };
+			}
+		};
+
+		/// <summary>
+		/// random sprites in atlas regions, rotated several turns, with indices above 16 bits
+		/// </summary>
+		void CreateSprites(size_t count, SpriteSoa& soa)
+		{
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> position(0.0f, 1920.0f);
+			std::uniform_real_distribution<float> scale(8.0f, 256.0f);
+			std::uniform_real_distribution<float> rotation(-20.0f, 20.0f);
+			std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+			std::uniform_int_distribution<uint32_t> texture(0, 0x1ffff);
+
+			for (auto& data : soa.Data) data.resize(count);
+			soa.Textures.resize(count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float u = unit(random) * 0.75f;
+				const float v = unit(random) * 0.75f;
+				const float values[13] = { position(random), position(random), scale(random), scale(random), rotation(random),
+					u, v, unit(random) * 0.25f, unit(random) * 0.25f, unit(random), unit(random), unit(random), unit(random) };
+				for (int k = 0; k < 13; ++k) soa.Data[k][i] = values[k];
+
+				soa.Textures[i] = texture(random);
+			}
+		}
+
+		/// <summary>
+		/// check every finite half float converts to a float and back to itself
+		/// </summary>
+		bool CheckHalfRoundTrip()
+		{
+			for (uint32_t half = 0; half < 0x10000; ++half)
+			{
+				if (((half >> 10) & 0x1f) == 0x1f) continue;
+
+				if (QuadKernel::FloatToHalf(QuadKernel::HalfToFloat(static_cast<uint16_t>(half))) != half)
+					return false;
+			}
+			return true;
+		}
+	}
+
+	/// <summary>
+	/// pack the sprites into instances with every instruction set, and compare the expanded instances with the quad kernel
+	/// </summary>
+	void RunSpriteInstance()
+	{
+		std::printf("[sprite instance] %zu bytes per sprite, %zu as quads, half float round trip: %s\n",
+			sizeof(SpriteBatch::SpriteInstance), sizeof(SpriteBatch::QuadVertex) * SpriteBatch::VERTICES_PER_QUAD,
+			CheckHalfRoundTrip() ? "ok" : "BROKEN");
+		std::printf("%10s %12s %12s %12s %12s %10s %10s %8s\n", "sprites", "quads", "scalar", "sse2", "avx2", "max error", "uv error", "result");
+
+		const size_t sprite_counts[] = { 10000, 100000, 1000000 };
+		for (size_t count : sprite_counts)
+		{
+			SpriteSoa soa;
+			CreateSprites(count, soa);
+			const QuadKernel::SpriteArrays arrays = soa.GetArrays();
+
+			std::vector<SpriteBatch::QuadVertex> quads(count * SpriteBatch::VERTICES_PER_QUAD);
+			double ns_quads = MeasureNanoseconds([&]() { QuadKernel::GenerateQuads(arrays, quads.data()); });
+
+			// every instruction set writes the same bits as the scalar packing
+			std::vector<SpriteBatch::SpriteInstance> reference(count);
+			std::vector<SpriteBatch::SpriteInstance> output(count);
+			QuadKernel::PackInstances(arrays, soa.Textures.data(), reference.data(), QuadKernel::InstructionSet::Scalar);
+
+			bool is_match = true;
+			double ns_set[static_cast<int>(QuadKernel::InstructionSet::Maximum)] = {};
+			for (int s = 0; s < static_cast<int>(QuadKernel::InstructionSet::Maximum); ++s)
+			{
+				QuadKernel::InstructionSet set = static_cast<QuadKernel::InstructionSet>(s);
+				ns_set[s] = MeasureNanoseconds([&]() { QuadKernel::PackInstances(arrays, soa.Textures.data(), output.data(), set); });
+				is_match = is_match && std::memcmp(reference.data(), output.data(), sizeof(SpriteBatch::SpriteInstance) * count) == 0;
+			}
+			DoNotOptimize(output.data());
+
+			// the quantization of the instances, in pixels and in texcoords
+			float max_error = 0.0f;
+			float uv_error  = 0.0f;
+			for (size_t i = 0; i < count; ++i)
+			{
+				SpriteBatch::QuadVertex expanded[SpriteBatch::VERTICES_PER_QUAD];
+				QuadKernel::ExpandInstance(reference[i], expanded);
+
+				for (uint32_t v = 0; v < SpriteBatch::VERTICES_PER_QUAD; ++v)
+				{
+					const SpriteBatch::QuadVertex& quad = quads[i * SpriteBatch::VERTICES_PER_QUAD + v];
+					for (int c = 0; c < 2; ++c)
+					{
+						max_error = std::fmax(max_error, std::fabs(quad.Position[c] - expanded[v].Position[c]));
+						uv_error  = std::fmax(uv_error,  std::fabs(quad.Texcoord[c] - expanded[v].Texcoord[c]));
+					}
+				}
+
+				is_match = is_match && reference[i].Texture == (soa.Textures[i] < 0xffff ? soa.Textures[i] : 0xffff);
+			}
+
+			std::printf("%10zu %9.2f ns %9.2f ns %9.2f ns %9.2f ns %10.4f %10.2g %8s\n", count,
+				ns_quads / count, ns_set[0] / count, ns_set[1] / count, ns_set[2] / count,
+				max_error, uv_error, is_match ? "ok" : "MISMATCH");
+		}
+
+		std::printf("\n");
+	}
+}
@@ -0,0 +1,127 @@
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../sprite_registry.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		// sprites destroyed and created again per frame in the churn scenario
+		constexpr double CHURN_RATIO = 0.1;
+
+		/// <summary>
+		/// fill a registry with random sprites
+		/// </summary>
+		void Populate(SpriteRegistry::Registry& registry, std::vector<SpriteRegistry::Handle>& handles, size_t count, std::mt19937& random)
+		{
+			std::uniform_real_distribution<float> position(0.0f, 1920.0f);
+			std::uniform_real_distribution<float> scale(8.0f, 256.0f);
+
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			for (size_t i = 0; i < count; ++i)
+			{
+				desc.Position[0] = position(random);
+				desc.Position[1] = position(random);
+				desc.Scale[0]    = scale(random);
+				desc.Scale[1]    = scale(random);
+				desc.Texture     = static_cast<uint32_t>(i % 16);
+				handles[i] = registry.Create(desc);
+			}
+		}
+
+		/// <summary>
+		/// check that every kept handle still finds its own sprite, and a stale handle does not
+		/// </summary>
+		bool ValidateHandles(const SpriteRegistry::Registry& registry, const std::vector<SpriteRegistry::Handle>& handles, SpriteRegistry::Handle stale)
+		{
+			if (registry.IsAlive(stale))
+				return false;
+
+			for (SpriteRegistry::Handle handle : handles)
+			{
+				const uint32_t index = registry.GetIndex(handle);
+				if (index == SpriteRegistry::INVALID_INDEX || registry.GetHandle(index) != handle)
+					return false;
+			}
+			return registry.GetCount() == handles.size();
+		}
+	}
+
+	/// <summary>
+	/// create, destroy, update and quad generation over the sprite registry
+	/// </summary>
+	void RunSpriteRegistry()
+	{
+		std::printf("[sprite registry]\n");
+		std::printf("%10s %12s %12s %12s %12s %8s\n", "sprites", "create", "churn", "update", "instances", "handles");
+
+		const size_t sprite_counts[] = { 10000, 100000, 1000000 };
+		for (size_t count : sprite_counts)
+		{
+			std::mt19937 random(12345);
+			std::vector<SpriteRegistry::Handle> handles(count);
+
+			// creation into a reserved registry, once since the handles are kept
+			SpriteRegistry::Registry registry;
+			registry.Reserve(static_cast<uint32_t>(count));
+			double ns_create = MeasureNanoseconds([&]() { Populate(registry, handles, count, random); }, 1);
+
+			// destroy random sprites and create them again
+			const size_t churn = static_cast<size_t>(count * CHURN_RATIO);
+			std::uniform_int_distribution<size_t> pick(0, count - 1);
+			SpriteRegistry::Handle stale = SpriteRegistry::INVALID_HANDLE;
+			const SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+
+			double ns_churn = MeasureNanoseconds([&]()
+			{
+				for (size_t c = 0; c < churn; ++c)
+				{
+					size_t i = pick(random);
+					stale = handles[i];
+					registry.Destroy(handles[i]);
+					handles[i] = registry.Create(desc);
+				}
+			});
+
+			// a fixed step moving every sprite
+			double ns_update = MeasureNanoseconds([&]()
+			{
+				registry.SavePreviousState();
+
+				SpriteRegistry::Transforms& transforms = registry.GetTransforms();
+				const uint32_t live = registry.GetCount();
+				for (uint32_t i = 0; i < live; ++i)
+				{
+					transforms.PositionX[i] += 1.0f;
+					transforms.Rotation[i]  += 0.01f;
+				}
+			});
+
+			// interpolated instances, chunk by chunk
+			std::vector<SpriteBatch::SpriteInstance> instances(SpriteRegistry::QUAD_CHUNK_SPRITES);
+			double ns_instances = MeasureNanoseconds([&]()
+			{
+				const uint32_t live = registry.GetCount();
+				for (uint32_t first = 0; first < live; first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+				{
+					const uint32_t chunk = (live - first < SpriteRegistry::QUAD_CHUNK_SPRITES) ? live - first : SpriteRegistry::QUAD_CHUNK_SPRITES;
+					registry.GenerateInstances(first, chunk, 0.5f, instances.data());
+					DoNotOptimize(instances.data());
+				}
+			});
+
+			std::printf("%10zu %9.2f ns %9.2f ns %9.2f ns %9.2f ns %8s\n", count,
+				ns_create / count, ns_churn / churn, ns_update / count, ns_instances / count,
+				ValidateHandles(registry, handles, stale) ? "ok" : "BROKEN");
+		}
+
+		std::printf("\n");
+	}
+}
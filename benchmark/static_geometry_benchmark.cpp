@@ -0,0 +1,362 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "../sprite_batch_core.h"
+#include "../static_geometry.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		//--------------------------------------------------------
+		// backend
+		//--------------------------------------------------------
+		/// <summary>
+		/// sprite batch backend in memory
+		/// </summary>
+		class NullRingBackend : public SpriteBatch::Backend
+		{
+			std::vector<SpriteBatch::SpriteInstance> _ring;
+
+		public:
+			explicit NullRingBackend(uint32_t capacityQuads) : _ring(capacityQuads) {}
+
+			SpriteBatch::SpriteInstance* MapRing(bool) override { return _ring.data(); }
+			void UnmapRing() override {}
+			void DrawRun(const SpriteBatch::Run&) override {}
+		};
+
+		/// <summary>
+		/// static geometry backend in memory, the initial data is copied as the api would
+		/// </summary>
+		class NullStaticBackend : public StaticGeometry::Backend
+		{
+			std::vector<SpriteBatch::SpriteInstance> _copy;
+			StaticGeometry::BufferId _nextBuffer;
+			uint64_t _drawnQuads;
+
+		public:
+			NullStaticBackend() : _copy(StaticGeometry::CHUNK_SPRITES), _nextBuffer(1), _drawnQuads(0) {}
+
+			StaticGeometry::BufferId CreateStaticBuffer(const SpriteBatch::SpriteInstance* p_instances, uint32_t quadCount) override
+			{
+				std::memcpy(_copy.data(), p_instances, sizeof(SpriteBatch::SpriteInstance) * quadCount);
+				return _nextBuffer++;
+			}
+			void ReleaseStaticBuffer(StaticGeometry::BufferId) override {}
+			void UpdateStaticBuffer(StaticGeometry::BufferId, const SpriteBatch::SpriteInstance* p_instances, uint32_t firstQuad, uint32_t quadCount) override
+			{
+				std::memcpy(&_copy[firstQuad], p_instances, sizeof(SpriteBatch::SpriteInstance) * quadCount);
+			}
+			void DrawStaticRun(StaticGeometry::BufferId, const StaticGeometry::Run& run) override { _drawnQuads += run.QuadCount; }
+
+			uint64_t GetDrawnQuads() const { return _drawnQuads; }
+			const SpriteBatch::SpriteInstance& GetQuad(uint32_t quad) const { return _copy[quad]; }
+		};
+
+		/// <summary>
+		/// material table backend without a gpu table
+		/// </summary>
+		class NullMaterialBackend : public MaterialTable::Backend
+		{
+		public:
+			void UploadMaterials(const MaterialTable::Constants*, MaterialTable::Index, uint32_t) override {}
+		};
+	}
+
+	/// <summary>
+	/// a frame of a static scene streamed through the ring, against the baked chunks with a part of the sprites dirty
+	/// the frame of the baked chunks streams the sprites moved in the order, as the sprite manager does
+	/// </summary>
+	void RunStaticGeometry()
+	{
+		std::printf("[static geometry] every sprite static, the view covers the whole scene\n");
+		std::printf("%10s %8s %8s %12s %14s %8s %10s %10s %10s\n", "sprites", "dirty", "kind", "frame", "upload", "draws", "rebuilt", "patched", "streamed");
+
+		const Renderer::ViewRect view = { -1e9f, -1e9f, 1e9f, 1e9f };
+		const size_t sprite_counts[] = { 10000, 100000, 1000000 };
+		const double dirty_ratios[] = { 0.0, 0.001, 0.01, 1.0 };
+
+		for (size_t count : sprite_counts)
+		{
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> position(0.0f, 4096.0f);
+
+			SpriteRegistry::Registry registry;
+			registry.Reserve(static_cast<uint32_t>(count));
+
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			desc.Scale[0] = 16.0f;
+			desc.Scale[1] = 16.0f;
+			desc.Flags    = SpriteRegistry::FLAG_STATIC;
+			for (size_t i = 0; i < count; ++i)
+			{
+				desc.Position[0] = position(random);
+				desc.Position[1] = position(random);
+				desc.Texture     = static_cast<uint32_t>(i % 16);
+				registry.Create(desc);
+			}
+
+			// every sprite generated and uploaded every frame, as the dynamic sprites are
+			{
+				NullRingBackend ring_backend(SpriteBatch::DEFAULT_RING_CAPACITY_QUADS);
+				SpriteBatch::Batcher batcher;
+				batcher.Initialize(&ring_backend);
+
+				std::vector<SpriteBatch::SpriteInstance> instances(SpriteRegistry::QUAD_CHUNK_SPRITES);
+				const uint32_t* p_textures = registry.GetTextures();
+				const Renderer::BlendMode* p_blends = registry.GetBlends();
+
+				double ns = MeasureNanoseconds([&]()
+				{
+					batcher.Begin();
+					for (uint32_t first = 0; first < registry.GetCount(); first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+					{
+						const uint32_t chunk = std::min(registry.GetCount() - first, SpriteRegistry::QUAD_CHUNK_SPRITES);
+						registry.GenerateInstances(first, chunk, 1.0f, instances.data());
+
+						for (uint32_t i = 0; i < chunk; ++i)
+						{
+							*batcher.Allocate(p_textures[first + i], p_blends[first + i]) = instances[i];
+						}
+					}
+					batcher.End();
+				});
+
+				const SpriteBatch::FrameStats& stats = batcher.GetLastFrameStats();
+				std::printf("%10zu %8s %8s %9.3f ms %11.2f MB %8u %10s %10s %10zu\n", count, "stream", "-",
+					ns / 1000000.0, stats.Bytes / (1024.0 * 1024.0), stats.Batches, "-", "-", count);
+
+				batcher.Terminate();
+			}
+
+			// baked once, then only the chunks of the dirty sprites
+			NullRingBackend ring_backend(SpriteBatch::DEFAULT_RING_CAPACITY_QUADS);
+			SpriteBatch::Batcher batcher;
+			batcher.Initialize(&ring_backend);
+			std::vector<SpriteBatch::SpriteInstance> instances(SpriteRegistry::QUAD_CHUNK_SPRITES);
+			std::vector<uint32_t> detached_indices(SpriteRegistry::QUAD_CHUNK_SPRITES);
+
+			NullStaticBackend static_backend;
+			StaticGeometry::Cache cache;
+			cache.Initialize(&static_backend);
+
+			for (uint32_t i = 0; i < registry.GetCount(); ++i) cache.Add(registry.GetSlot(i), 0);
+			cache.Rebuild(registry);
+
+			// a written sprite keeps its place in the chunk and is patched, a moved one changes its depth and is streamed
+			// (the moves add up over the rows, and a chunk with too many streamed sprites is rebuilt)
+			std::uniform_int_distribution<uint32_t> pick(0, registry.GetCount() - 1);
+			for (bool is_moved : { false, true })
+			{
+				for (double ratio : dirty_ratios)
+				{
+					const size_t dirty = static_cast<size_t>(count * ratio);
+
+					double ns = MeasureNanoseconds([&]()
+					{
+						for (size_t d = 0; d < dirty; ++d)
+						{
+							const uint32_t index = ratio >= 1.0 ? static_cast<uint32_t>(d) : pick(random);
+							if (is_moved) registry.GetDepths()[index] += 1.0f;
+							cache.Add(registry.GetSlot(index), 0);
+						}
+
+						cache.Rebuild(registry);
+						cache.Begin(view);
+
+						const std::vector<uint32_t>& detached = cache.GetDetachedSlots();
+						batcher.Begin();
+						for (size_t first = 0; first < detached.size(); first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+						{
+							const uint32_t chunk = static_cast<uint32_t>(std::min<size_t>(detached.size() - first, SpriteRegistry::QUAD_CHUNK_SPRITES));
+							for (uint32_t i = 0; i < chunk; ++i) detached_indices[i] = registry.GetIndexOfSlot(detached[first + i]);
+							registry.GenerateInstances(detached_indices.data(), chunk, 1.0f, instances.data());
+
+							for (uint32_t i = 0; i < chunk; ++i)
+							{
+								const uint32_t index = detached_indices[i];
+								*batcher.Allocate(registry.GetTextures()[index], registry.GetBlends()[index]) = instances[i];
+							}
+						}
+						batcher.End();
+
+						cache.End();
+					});
+
+					char dirty_name[16];
+					std::snprintf(dirty_name, sizeof(dirty_name), "%.1f%%", ratio * 100.0);
+
+					const StaticGeometry::FrameStats& stats = cache.GetLastFrameStats();
+					const uint64_t stream_bytes = batcher.GetLastFrameStats().Bytes;
+					std::printf("%10zu %8s %8s %9.3f ms %11.2f MB %8u %10u %10u %10u\n", count, dirty_name, is_moved ? "moved" : "written",
+						ns / 1000000.0, (stats.UploadBytes + stream_bytes) / (1024.0 * 1024.0), stats.Runs, stats.ChunksRebuilt, stats.ChunksPatched, stats.Detached);
+				}
+			}
+
+			cache.Terminate();
+			batcher.Terminate();
+		}
+
+		// dynamic sprites sorted in between the static ones: every static sprite of a smaller or equal key is drawn before them
+		{
+			constexpr uint32_t STATIC_COUNT  = StaticGeometry::CHUNK_SPRITES + StaticGeometry::CHUNK_SPRITES / 2;
+			constexpr uint32_t DYNAMIC_COUNT = 1000;
+			constexpr uint32_t LAYER_COUNT   = 3;
+
+			std::mt19937 random(12345);
+			std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+			std::uniform_int_distribution<uint32_t> layer(0, LAYER_COUNT - 1);
+
+			SpriteRegistry::Registry registry;
+			registry.Reserve(STATIC_COUNT);
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			desc.Flags = SpriteRegistry::FLAG_STATIC;
+			for (uint32_t i = 0; i < STATIC_COUNT; ++i)
+			{
+				desc.Layer = layer(random);
+				desc.Depth = depth(random);
+				registry.Create(desc);
+			}
+
+			NullStaticBackend static_backend;
+			StaticGeometry::Cache cache;
+			cache.Initialize(&static_backend);
+			for (uint32_t i = 0; i < registry.GetCount(); ++i) cache.Add(registry.GetSlot(i), registry.GetLayers()[i]);
+			cache.Rebuild(registry);
+
+			// the keys as the sprite manager makes them
+			std::vector<uint64_t> static_keys(STATIC_COUNT), dynamic_keys(DYNAMIC_COUNT);
+			for (uint32_t i = 0; i < STATIC_COUNT; ++i)
+			{
+				static_keys[i] = SortKey::Make({ registry.GetLayers()[i], registry.GetDepths()[i], ShaderPermutation::DEFAULT_KEY,
+					registry.GetBlends()[i], registry.GetTextures()[i] });
+			}
+			for (uint64_t& key : dynamic_keys)
+			{
+				key = SortKey::Make({ layer(random), depth(random), ShaderPermutation::DEFAULT_KEY, desc.Blend, desc.Texture });
+			}
+			std::sort(static_keys.begin(), static_keys.end());
+			std::sort(dynamic_keys.begin(), dynamic_keys.end());
+
+			bool is_ordered = true;
+			cache.Begin(view);
+			for (uint64_t key : dynamic_keys)
+			{
+				cache.DrawUpTo(key);
+				const uint64_t expected = std::upper_bound(static_keys.begin(), static_keys.end(), key) - static_keys.begin();
+				is_ordered = is_ordered && static_backend.GetDrawnQuads() == expected;
+			}
+			cache.End();
+			is_ordered = is_ordered && static_backend.GetDrawnQuads() == STATIC_COUNT;
+
+			const StaticGeometry::FrameStats& stats = cache.GetLastFrameStats();
+			std::printf("%u static and %u dynamic sprites in %u layers: %u of %u chunks in %u runs, order: %s\n", STATIC_COUNT, DYNAMIC_COUNT,
+				LAYER_COUNT, stats.ChunksDrawn, stats.Chunks, stats.Runs, is_ordered ? "ok" : "MISMATCH");
+			if (!is_ordered) ReportFailure();
+
+			cache.Terminate();
+		}
+
+		// sprites moved in the order are hidden in their chunk and streamed, until the chunk has too many of them
+		{
+			SpriteRegistry::Registry registry;
+			registry.Reserve(StaticGeometry::CHUNK_SPRITES);
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			desc.Flags = SpriteRegistry::FLAG_STATIC;
+			for (uint32_t i = 0; i < StaticGeometry::CHUNK_SPRITES; ++i) registry.Create(desc);
+
+			NullStaticBackend static_backend;
+			StaticGeometry::Cache cache;
+			cache.Initialize(&static_backend);
+			for (uint32_t i = 0; i < registry.GetCount(); ++i) cache.Add(registry.GetSlot(i), 0);
+			cache.Rebuild(registry);
+
+			// every sprite has the same key, so the quads are in the order of the slots
+			constexpr uint32_t MOVED_COUNT = 10;
+			for (uint32_t i = 0; i < MOVED_COUNT; ++i)
+			{
+				registry.GetDepths()[i] += 1.0f;
+				cache.Add(registry.GetSlot(i), 0);
+			}
+			cache.Rebuild(registry);
+			cache.Begin(view);
+			cache.End();
+
+			const StaticGeometry::FrameStats stats = cache.GetLastFrameStats();
+			bool is_hidden = stats.ChunksRebuilt == 0 && stats.ChunksPatched == 1 && cache.GetDetachedSlots().size() == MOVED_COUNT;
+			for (uint32_t i = 0; i < MOVED_COUNT; ++i)
+			{
+				is_hidden = is_hidden && static_backend.GetQuad(i).Scale[0] == 0 && static_backend.GetQuad(i).Scale[1] == 0;
+			}
+			is_hidden = is_hidden && static_backend.GetQuad(MOVED_COUNT).Scale[0] != 0;
+
+			// one more than the limit rebuilds the chunk, with every sprite in its place
+			for (uint32_t i = MOVED_COUNT; i <= StaticGeometry::MAX_DETACHED_SPRITES; ++i)
+			{
+				registry.GetDepths()[i] += 1.0f;
+				cache.Add(registry.GetSlot(i), 0);
+			}
+			cache.Rebuild(registry);
+			cache.Begin(view);
+			cache.End();
+
+			const bool is_rebuilt = cache.GetLastFrameStats().ChunksRebuilt == 1 && cache.GetDetachedSlots().empty();
+			std::printf("%u of %u sprites moved in the order: %u streamed, hidden: %s, %u moved: rebuilt, result: %s\n", MOVED_COUNT,
+				StaticGeometry::CHUNK_SPRITES, stats.Detached, is_hidden ? "ok" : "MISMATCH", StaticGeometry::MAX_DETACHED_SPRITES + 1,
+				is_rebuilt ? "ok" : "MISMATCH");
+			if (!is_hidden || !is_rebuilt) ReportFailure();
+
+			cache.Terminate();
+		}
+
+		// a material edited in place to another variant rebuilds the chunks of its sprites, and only them
+		{
+			NullMaterialBackend material_backend;
+			MaterialTable::Table materials;
+			materials.Initialize(&material_backend);
+
+			MaterialTable::Constants constants = MaterialTable::Table::GetDefaultConstants();
+			constants.Diffuse[0] = 0.5f;
+			MaterialTable::Index material = materials.Register(constants, ShaderPermutation::DEFAULT_KEY);
+
+			// the first chunk of the layer is drawn with the material, the second one with the default material
+			SpriteRegistry::Registry registry;
+			registry.Reserve(StaticGeometry::CHUNK_SPRITES * 2);
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			desc.Flags = SpriteRegistry::FLAG_STATIC;
+			for (uint32_t i = 0; i < StaticGeometry::CHUNK_SPRITES * 2; ++i)
+			{
+				desc.Material = (i < StaticGeometry::CHUNK_SPRITES) ? material : MaterialTable::DEFAULT_INDEX;
+				registry.Create(desc);
+			}
+
+			NullStaticBackend static_backend;
+			StaticGeometry::Cache cache;
+			cache.Initialize(&static_backend, &materials);
+			for (uint32_t i = 0; i < registry.GetCount(); ++i) cache.Add(registry.GetSlot(i), 0);
+			cache.Rebuild(registry);
+
+			materials.Update(&material, constants, ShaderPermutation::DEFAULT_KEY | ShaderPermutation::FEATURE_ALPHA_TEST);
+			cache.Rebuild(registry);
+			cache.Begin(view);
+			cache.End();
+
+			const StaticGeometry::FrameStats& stats = cache.GetLastFrameStats();
+			const bool is_rebuilt = stats.ChunksRebuilt == 1;
+			std::printf("material variant edited in place: %u of %u chunks rebuilt, result: %s\n", stats.ChunksRebuilt, stats.Chunks,
+				is_rebuilt ? "ok" : "MISMATCH");
+			if (!is_rebuilt) ReportFailure();
+
+			cache.Terminate();
+			materials.Terminate();
+		}
+
+		std::printf("\n");
+	}
+}
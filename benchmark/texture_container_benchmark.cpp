@@ -0,0 +1,159 @@
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <directxtex.h>
+
+#pragma comment (lib, "directxtex.lib")
+#endif
+
+#include "benchmark.h"
+#include "../texture_container.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		constexpr const char* CONTAINER_PATH = "benchmark_texture.ctex";
+		constexpr const char* RAW_PATH       = "benchmark_texture.raw";
+#ifdef _WIN32
+		constexpr const wchar_t* PNG_PATH    = L"benchmark_texture.png";
+#endif
+
+		/// <summary>
+		/// RGBA8 image with gradients and noise, so PNG cannot compress it away
+		/// </summary>
+		std::vector<uint8_t> CreateImage(uint32_t width, uint32_t height)
+		{
+			std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+
+			uint32_t random = 1;
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					random = random * 1664525u + 1013904223u;
+
+					uint8_t* p = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+					p[0] = static_cast<uint8_t>(x * 255 / width);
+					p[1] = static_cast<uint8_t>(y * 255 / height);
+					p[2] = static_cast<uint8_t>(random >> 24);
+					p[3] = 255;
+				}
+			}
+
+			return pixels;
+		}
+
+		/// <summary>
+		/// sum one byte per cache line, like the driver reading the upload
+		/// </summary>
+		uint64_t Touch(const uint8_t* p, size_t size)
+		{
+			uint64_t sum = 0;
+			for (size_t i = 0; i < size; i += 64) sum += p[i];
+			return sum;
+		}
+
+		/// <summary>
+		/// write the base level without the container, for the buffered read path
+		/// </summary>
+		bool WriteRaw(const std::vector<uint8_t>& pixels)
+		{
+			FILE* p_file = std::fopen(RAW_PATH, "wb");
+			if (!p_file) return false;
+
+			bool is_written = std::fwrite(pixels.data(), 1, pixels.size(), p_file) == pixels.size();
+			return (std::fclose(p_file) == 0) && is_written;
+		}
+	}
+
+	/// <summary>
+	/// compare the load of a cooked container with reading a copy, and with decoding PNG (windows only)
+	/// the files are in the page cache after the first run, so this measures the cpu cost of each path
+	/// </summary>
+	void RunTextureContainer()
+	{
+		std::printf("[texture container] mapped container vs buffered read vs PNG decode\n");
+		std::printf("%11s %14s %14s %14s %12s\n", "size", "mapped", "buffered", "png", "data bytes");
+
+		const uint32_t sizes[] = { 256, 1024, 2048 };
+		for (uint32_t size : sizes)
+		{
+			const std::vector<uint8_t> pixels = CreateImage(size, size);
+			if (TextureContainer::CookRgba8(CONTAINER_PATH, pixels.data(), size, size) != 0 || !WriteRaw(pixels))
+			{
+				std::printf("cannot write the benchmark files\n");
+				return;
+			}
+
+			// map, validate, and hand every mip level to the consumer in place
+			size_t file_bytes = 0;
+			double ns_mapped = MeasureNanoseconds([&]()
+			{
+				TextureContainer::Reader container;
+				if (container.Open(CONTAINER_PATH) != 0) return;
+
+				uint64_t sum = 0;
+				for (uint32_t mip = 0; mip < container.GetHeader().MipLevels; ++mip)
+				{
+					sum += Touch(static_cast<const uint8_t*>(container.GetSubresourceData(mip)), container.GetSubresource(mip).SlicePitch);
+				}
+				file_bytes = container.GetDataSize();
+				DoNotOptimize(&sum);
+			});
+
+			// read the base level into memory first (no mip levels)
+			double ns_buffered = MeasureNanoseconds([&]()
+			{
+				std::vector<uint8_t> buffer(pixels.size());
+				FILE* p_file = std::fopen(RAW_PATH, "rb");
+				if (!p_file) return;
+				size_t read = std::fread(buffer.data(), 1, buffer.size(), p_file);
+				std::fclose(p_file);
+
+				uint64_t sum = Touch(buffer.data(), read);
+				DoNotOptimize(&sum);
+			});
+
+			double ns_png = 0.0;
+#ifdef _WIN32
+			// the startup path: WIC decode of the base level (no mip levels)
+			HRESULT h_com = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+			DirectX::Image image = {};
+			image.width      = size;
+			image.height     = size;
+			image.format     = DXGI_FORMAT_R8G8B8A8_UNORM;
+			image.rowPitch   = static_cast<size_t>(size) * 4;
+			image.slicePitch = pixels.size();
+			image.pixels     = const_cast<uint8_t*>(pixels.data());
+			if (SUCCEEDED(DirectX::SaveToWICFile(image, DirectX::WIC_FLAGS_NONE, DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), PNG_PATH)))
+			{
+				ns_png = MeasureNanoseconds([&]()
+				{
+					DirectX::ScratchImage decoded;
+					if (FAILED(DirectX::LoadFromWICFile(PNG_PATH, DirectX::WIC_FLAGS_NONE, nullptr, decoded))) return;
+
+					uint64_t sum = Touch(decoded.GetPixels(), decoded.GetPixelsSize());
+					DoNotOptimize(&sum);
+				});
+				DeleteFileW(PNG_PATH);
+			}
+
+			if (SUCCEEDED(h_com)) CoUninitialize();
+#endif
+
+			std::printf("%5u x %4u %11.3f ms %11.3f ms ", size, size, ns_mapped * 1e-6, ns_buffered * 1e-6);
+			if (ns_png > 0.0) std::printf("%11.3f ms", ns_png * 1e-6);
+			else              std::printf("%14s", "n/a");
+			std::printf(" %12zu\n", file_bytes);
+		}
+
+		std::remove(CONTAINER_PATH);
+		std::remove(RAW_PATH);
+		std::printf("\n");
+	}
+}
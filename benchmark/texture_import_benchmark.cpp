@@ -0,0 +1,216 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "benchmark.h"
+#include "../texture_import.h"
+#include "../thread_pool.h"
+
+namespace Benchmark
+{
+	namespace
+	{
+		constexpr const char* CONTAINER_PATH = "benchmark_import.ctex";
+
+		/// <summary>
+		/// image of an asset: smooth gradients with a little noise, a soft disc of alpha, or a gray mask
+		/// </summary>
+		std::vector<uint8_t> CreateImage(TextureImport::Content type, uint32_t size)
+		{
+			std::vector<uint8_t> pixels(static_cast<size_t>(size) * size * 4);
+
+			uint32_t random = 1;
+			for (uint32_t y = 0; y < size; ++y)
+			{
+				for (uint32_t x = 0; x < size; ++x)
+				{
+					random = random * 1664525u + 1013904223u;
+					const int noise = static_cast<int>(random >> 29) - 4;
+
+					const float u = static_cast<float>(x) / size, v = static_cast<float>(y) / size;
+					const float distance = std::sqrt((u - 0.5f) * (u - 0.5f) + (v - 0.5f) * (v - 0.5f));
+					const float wave = 0.5f + 0.5f * std::sin(u * 12.0f) * std::cos(v * 9.0f);
+
+					auto clamp = [](float value) { return static_cast<uint8_t>(std::fmin(std::fmax(value, 0.0f), 255.0f)); };
+
+					uint8_t* p = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+					if (type == TextureImport::Content::Mask)
+					{
+						p[0] = p[1] = p[2] = clamp((1.0f - distance * 1.6f) * 255.0f + noise);
+						p[3] = 255;
+					}
+					else
+					{
+						p[0] = clamp(u * 255.0f + noise);
+						p[1] = clamp(v * 255.0f + noise);
+						p[2] = clamp(wave * 255.0f + noise);
+						p[3] = (type == TextureImport::Content::Alpha) ? clamp((0.45f - distance) * 2048.0f) : 255;
+					}
+				}
+			}
+
+			return pixels;
+		}
+
+		/// <summary>
+		/// texels of a mip chain
+		/// </summary>
+		size_t GetChainTexels(uint32_t size, uint32_t levels)
+		{
+			size_t texels = 0;
+			for (uint32_t mip = 0; mip < levels; ++mip) texels += static_cast<size_t>(std::max(size >> mip, 1u)) * std::max(size >> mip, 1u);
+			return texels;
+		}
+
+		/// <summary>
+		/// check the filter on images whose mips are known
+		/// </summary>
+		bool CheckFilter()
+		{
+			std::vector<std::vector<uint8_t>> mips;
+
+			// black and white average to the middle of linear light, not of the sRGB values
+			const uint8_t checker[16] = { 0, 0, 0, 255, 255, 255, 255, 255, 255, 255, 255, 255, 0, 0, 0, 255 };
+			TextureImport::GenerateMips(checker, 2, 2, 2, true, &mips);
+			const uint8_t srgb = mips[1][0];
+
+			// one opaque white texel among transparent black ones keeps its color, with a quarter of the coverage
+			const uint8_t coverage[16] = { 255, 255, 255, 255, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+			TextureImport::GenerateMips(coverage, 2, 2, 2, true, &mips);
+			const uint8_t color = mips[1][0], alpha = mips[1][3];
+
+			// data is averaged as it is
+			TextureImport::GenerateMips(checker, 2, 2, 2, false, &mips);
+			const uint8_t linear = mips[1][0];
+
+			std::printf("filter: black and white %u in sRGB (188), %u as data (128), a covered quarter %u alpha %u (255 64)\n",
+				srgb, linear, color, alpha);
+
+			return srgb == 188 && linear == 128 && color == 255 && alpha == 64;
+		}
+	}
+
+	/// <summary>
+	/// import assets of each kind: mip generation with every instruction set, and block compression across the thread pool
+	/// reports the throughput and the PSNR of the base level and of the whole chain against the uncompressed mips
+	/// </summary>
+	void RunTextureImport()
+	{
+		ThreadPool::Manager::Instance().Initialize();
+		const size_t thread_count = ThreadPool::Manager::Instance().GetWorkerCount() + 1;
+
+		std::printf("[texture import] %zu threads, mip filter in linear light weighted by alpha\n", thread_count);
+		bool is_all_match = CheckFilter();
+
+		// the format of each kind of asset
+		TextureImport::Settings settings = TextureImport::GetDefaultSettings();
+		const std::vector<uint8_t> opaque = CreateImage(TextureImport::Content::Opaque, 8);
+		const std::vector<uint8_t> alpha  = CreateImage(TextureImport::Content::Alpha, 8);
+		const bool is_chosen =
+			TextureImport::Classify(opaque.data(), 8, 8) == TextureImport::Content::Opaque &&
+			TextureImport::Classify(alpha.data(), 8, 8) == TextureImport::Content::Alpha &&
+			TextureImport::ChooseFormat(TextureImport::Content::Opaque, settings, 8, 8) == TextureContainer::PixelFormat::Bc1 &&
+			TextureImport::ChooseFormat(TextureImport::Content::Alpha, settings, 8, 8) == TextureContainer::PixelFormat::Bc3 &&
+			TextureImport::ChooseFormat(TextureImport::Content::Mask, settings, 8, 8) == TextureContainer::PixelFormat::Bc4 &&
+			TextureImport::ChooseFormat(TextureImport::Content::Opaque, settings, 6, 8) == TextureContainer::PixelFormat::Rgba8;
+		is_all_match = is_all_match && is_chosen;
+
+		std::printf("%6s %7s %6s %12s %12s %12s %11s %11s %8s\n", "size", "content", "format", "mips scalar", "mips simd", "encode", "psnr base", "psnr chain", "result");
+
+		struct Case
+		{
+			TextureImport::Content Type;
+			bool IsHighQuality;
+			double MinimumPsnr;
+		};
+		const Case cases[] =
+		{
+			{ TextureImport::Content::Opaque, false, 30.0 },
+			{ TextureImport::Content::Alpha,  false, 30.0 },
+			{ TextureImport::Content::Mask,   false, 40.0 },
+			{ TextureImport::Content::Opaque, true,  38.0 },
+			{ TextureImport::Content::Alpha,  true,  36.0 },
+		};
+
+		const uint32_t sizes[] = { 512, 2048 };
+		for (uint32_t size : sizes)
+		{
+			for (const Case& test : cases)
+			{
+				const std::vector<uint8_t> pixels = CreateImage(test.Type, size);
+				const uint32_t levels = TextureContainer::GetMipCount(size, size);
+				const bool is_srgb = test.Type != TextureImport::Content::Mask;
+
+				// the filter with each instruction set, which must write the same bits
+				std::vector<std::vector<uint8_t>> scalar_mips, mips;
+				double ns_scalar = MeasureNanoseconds([&]()
+				{
+					TextureImport::GenerateMips(pixels.data(), size, size, levels, is_srgb, &scalar_mips, QuadKernel::InstructionSet::Scalar);
+				}, 1);
+				double ns_simd = MeasureNanoseconds([&]()
+				{
+					TextureImport::GenerateMips(pixels.data(), size, size, levels, is_srgb, &mips);
+				}, 1);
+				bool is_match = scalar_mips == mips;
+
+				settings.Type          = test.Type;
+				settings.IsHighQuality = test.IsHighQuality;
+				const TextureContainer::PixelFormat format = TextureImport::ChooseFormat(test.Type, settings, size, size);
+
+				// every level in parallel rows of blocks
+				std::vector<std::vector<uint8_t>> blocks(levels);
+				double ns_encode = MeasureNanoseconds([&]()
+				{
+					for (uint32_t mip = 0; mip < levels; ++mip)
+					{
+						const uint32_t mip_size = std::max(size >> mip, 1u);
+						blocks[mip].resize(static_cast<size_t>(TextureContainer::GetRowPitch(format, mip_size)) * TextureContainer::GetRowCount(format, mip_size));
+						TextureImport::EncodeBlocks(format, mips[mip].data(), mip_size, mip_size, blocks[mip].data());
+					}
+				}, 1);
+
+				// decoded against the uncompressed mips, BC4 holds the red channel only
+				const uint32_t channel_mask = (format == TextureContainer::PixelFormat::Bc4) ? 0x1 : (test.Type == TextureImport::Content::Opaque) ? 0x7 : 0xf;
+				std::vector<uint8_t> reference_chain, decoded_chain;
+				double psnr_base = 0.0;
+				for (uint32_t mip = 0; mip < levels; ++mip)
+				{
+					const uint32_t mip_size = std::max(size >> mip, 1u);
+					std::vector<uint8_t> decoded(static_cast<size_t>(mip_size) * mip_size * 4);
+					is_match = TextureImport::DecodeBlocks(format, blocks[mip].data(), mip_size, mip_size, decoded.data()) == 0 && is_match;
+
+					if (mip == 0) psnr_base = TextureImport::ComputePsnr(mips[0].data(), decoded.data(), decoded.size() / 4, channel_mask);
+					reference_chain.insert(reference_chain.end(), mips[mip].begin(), mips[mip].end());
+					decoded_chain.insert(decoded_chain.end(), decoded.begin(), decoded.end());
+				}
+				const double psnr_chain = TextureImport::ComputePsnr(reference_chain.data(), decoded_chain.data(), decoded_chain.size() / 4, channel_mask);
+				is_match = is_match && psnr_base >= test.MinimumPsnr && psnr_chain >= test.MinimumPsnr;
+				is_all_match = is_all_match && is_match;
+
+				const double texels = static_cast<double>(GetChainTexels(size, levels));
+				std::printf("%6u %7s %6s %7.1f MT/s %7.1f MT/s %7.1f MT/s %8.2f dB %8.2f dB %8s\n",
+					size, TextureImport::GetContentName(test.Type), TextureImport::GetFormatName(format),
+					texels * 1e3 / ns_scalar, texels * 1e3 / ns_simd, texels * 1e3 / ns_encode, psnr_base, psnr_chain, is_match ? "ok" : "MISMATCH");
+			}
+		}
+
+		// the cooked container is read back with the chain in the chosen format
+		settings = TextureImport::GetDefaultSettings();
+		const std::vector<uint8_t> pixels = CreateImage(TextureImport::Content::Alpha, 256);
+		TextureImport::Image image;
+		TextureContainer::Reader container;
+		const bool is_cooked =
+			TextureImport::Cook(CONTAINER_PATH, pixels.data(), 256, 256, settings, &image) == 0 &&
+			container.Open(CONTAINER_PATH) == 0 &&
+			container.GetHeader().Format == TextureContainer::PixelFormat::Bc3 &&
+			container.GetHeader().MipLevels == TextureContainer::GetMipCount(256, 256) &&
+			container.GetSubresource(8).SlicePitch == image.Mips[8].size();
+		container.Close();
+		std::remove(CONTAINER_PATH);
+		is_all_match = is_all_match && is_cooked;
+
+		std::printf("formats: %s, container: %s, result: %s\n\n", is_chosen ? "ok" : "MISMATCH", is_cooked ? "ok" : "MISMATCH", is_all_match ? "ok" : "MISMATCH");
+	}
+}
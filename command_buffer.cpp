@@ -0,0 +1,369 @@
+
+#include <cstring>
+
+#include "command_buffer.h"
+#include "thread_pool.h"
+
+namespace CommandBuffer
+{
+	namespace
+	{
+		/// <summary>
+		/// round up to the command alignment
+		/// </summary>
+		inline size_t AlignCommand(size_t size)
+		{
+			return (size + COMMAND_ALIGNMENT - 1) & ~(COMMAND_ALIGNMENT - 1);
+		}
+
+		/// <summary>
+		/// read the command in front of the payload
+		/// </summary>
+		template <typename Command>
+		inline const Command& ReadCommand(const uint8_t* p_header)
+		{
+			return *reinterpret_cast<const Command*>(p_header + AlignCommand(sizeof(CommandHeader)));
+		}
+	}
+
+	//--------------------------------------------------------
+	// buffer
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for command buffer
+	/// </summary>
+	Buffer::Buffer()
+	{
+		_data.resize(DEFAULT_BUFFER_BYTES);
+		_size = 0;
+		_commandCount = 0;
+		_drawCount    = 0;
+	}
+
+	/// <summary>
+	/// forget the recorded commands, keeping the memory
+	/// </summary>
+	void Buffer::Reset()
+	{
+		_size = 0;
+		_commandCount = 0;
+		_drawCount    = 0;
+	}
+
+	/// <summary>
+	/// reserve a command and return the memory of its payload
+	/// </summary>
+	void* Buffer::Push(_In_ CommandType type, _In_ size_t payloadSize)
+	{
+		const size_t header_size  = AlignCommand(sizeof(CommandHeader));
+		const size_t command_size = header_size + AlignCommand(payloadSize);
+
+		// grow geometrically, so a steady frame stops allocating
+		if (_size + command_size > _data.size())
+		{
+			size_t capacity = _data.size() * 2;
+			while (capacity < _size + command_size) capacity *= 2;
+			_data.resize(capacity);
+		}
+
+		uint8_t* p_header = &_data[_size];
+		CommandHeader header = { type, static_cast<uint32_t>(command_size) };
+		std::memcpy(p_header, &header, sizeof(header));
+
+		_size += command_size;
+		_commandCount++;
+
+		return p_header + header_size;
+	}
+
+	/// <summary>
+	/// record a fixed-size command
+	/// </summary>
+	template <typename Command>
+	void Buffer::Write(_In_ CommandType type, _In_ const Command& command)
+	{
+		std::memcpy(Push(type, sizeof(Command)), &command, sizeof(Command));
+	}
+
+	/// <summary>
+	/// record binding a pipeline state
+	/// </summary>
+	void Buffer::BindPipelineState(_In_ PipelineState::Handle handle)
+	{
+		Write(CommandType::BindPipelineState, BindPipelineStateCommand{ handle });
+	}
+
+	/// <summary>
+	/// record setting the vertex buffer
+	/// </summary>
+	void Buffer::SetVertexBuffer(_In_ PipelineState::ObjectId buffer, _In_ uint32_t stride, _In_ uint32_t offset)
+	{
+		Write(CommandType::SetVertexBuffer, SetVertexBufferCommand{ buffer, stride, offset });
+	}
+
+	/// <summary>
+	/// record setting the index buffer
+	/// </summary>
+	void Buffer::SetIndexBuffer(_In_ PipelineState::ObjectId buffer, _In_ bool is32Bit)
+	{
+		Write(CommandType::SetIndexBuffer, SetIndexBufferCommand{ buffer, is32Bit });
+	}
+
+	/// <summary>
+	/// record setting the primitive topology
+	/// </summary>
+	void Buffer::SetPrimitiveTopology(_In_ Topology topology)
+	{
+		Write(CommandType::SetPrimitiveTopology, SetPrimitiveTopologyCommand{ topology });
+	}
+
+	/// <summary>
+	/// record setting a texture of the pixel shader
+	/// </summary>
+	void Buffer::SetTexture(_In_ uint32_t slot, _In_ PipelineState::ObjectId texture)
+	{
+		Write(CommandType::SetTexture, SetTextureCommand{ texture, slot });
+	}
+
+	/// <summary>
+	/// record updating a whole buffer, the data is copied into the command
+	/// </summary>
+	void Buffer::UpdateBuffer(_In_ PipelineState::ObjectId buffer, _In_reads_bytes_(byteSize) const void* data, _In_ uint32_t byteSize)
+	{
+		const size_t command_size = AlignCommand(sizeof(UpdateBufferCommand));
+
+		uint8_t* p_payload = static_cast<uint8_t*>(Push(CommandType::UpdateBuffer, command_size + byteSize));
+		UpdateBufferCommand command = { buffer, byteSize };
+		std::memcpy(p_payload, &command, sizeof(command));
+		std::memcpy(p_payload + command_size, data, byteSize);
+	}
+
+	/// <summary>
+	/// record a non-indexed draw
+	/// </summary>
+	void Buffer::Draw(_In_ uint32_t vertexCount, _In_ uint32_t startVertex)
+	{
+		Write(CommandType::Draw, DrawCommand{ vertexCount, startVertex });
+		_drawCount++;
+	}
+
+	/// <summary>
+	/// record an indexed draw
+	/// </summary>
+	void Buffer::DrawIndexed(_In_ uint32_t indexCount, _In_ uint32_t startIndex, _In_ int32_t baseVertex)
+	{
+		Write(CommandType::DrawIndexed, DrawIndexedCommand{ indexCount, startIndex, baseVertex });
+		_drawCount++;
+	}
+
+	/// <summary>
+	/// execute the commands in recorded order
+	/// </summary>
+	void Buffer::Replay(_Inout_ Backend& backend) const
+	{
+		const uint8_t* p_header = _data.data();
+		const uint8_t* p_end    = p_header + _size;
+
+		while (p_header < p_end)
+		{
+			CommandHeader header;
+			std::memcpy(&header, p_header, sizeof(header));
+
+			switch (header.Type)
+			{
+			case CommandType::BindPipelineState:
+				backend.BindPipelineState(ReadCommand<BindPipelineStateCommand>(p_header));
+				break;
+
+			case CommandType::SetVertexBuffer:
+				backend.SetVertexBuffer(ReadCommand<SetVertexBufferCommand>(p_header));
+				break;
+
+			case CommandType::SetIndexBuffer:
+				backend.SetIndexBuffer(ReadCommand<SetIndexBufferCommand>(p_header));
+				break;
+
+			case CommandType::SetPrimitiveTopology:
+				backend.SetPrimitiveTopology(ReadCommand<SetPrimitiveTopologyCommand>(p_header));
+				break;
+
+			case CommandType::SetTexture:
+				backend.SetTexture(ReadCommand<SetTextureCommand>(p_header));
+				break;
+
+			case CommandType::UpdateBuffer:
+			{
+				const UpdateBufferCommand& command = ReadCommand<UpdateBufferCommand>(p_header);
+				const void* p_data = reinterpret_cast<const uint8_t*>(&command) + AlignCommand(sizeof(UpdateBufferCommand));
+				backend.UpdateBuffer(command, p_data);
+				break;
+			}
+
+			case CommandType::Draw:
+				backend.Draw(ReadCommand<DrawCommand>(p_header));
+				break;
+
+			case CommandType::DrawIndexed:
+				backend.DrawIndexed(ReadCommand<DrawIndexedCommand>(p_header));
+				break;
+
+			default:
+				break;
+			}
+
+			p_header += header.Size;
+		}
+	}
+
+	/// <summary>
+	/// get the recorded bytes
+	/// </summary>
+	size_t Buffer::GetSize() const
+	{
+		return _size;
+	}
+
+	/// <summary>
+	/// get the number of recorded commands
+	/// </summary>
+	uint32_t Buffer::GetCommandCount() const
+	{
+		return _commandCount;
+	}
+
+	/// <summary>
+	/// get the number of recorded draws
+	/// </summary>
+	uint32_t Buffer::GetDrawCount() const
+	{
+		return _drawCount;
+	}
+
+	//--------------------------------------------------------
+	// manager
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for command buffer manager
+	/// </summary>
+	Manager::Manager()
+	{
+		_usedBuffers = 0;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// termination process for command buffer manager
+	/// </summary>
+	void Manager::Terminate()
+	{
+		_buffers.clear();
+		_usedBuffers = 0;
+	}
+
+	/// <summary>
+	/// reset all buffers for a new frame
+	/// </summary>
+	void Manager::BeginFrame()
+	{
+		for (size_t i = 0; i < _usedBuffers; ++i) _buffers[i].Reset();
+		_usedBuffers = 0;
+	}
+
+	/// <summary>
+	/// record tasks in parallel, each task writes its own buffer
+	/// </summary>
+	void Manager::Record(_In_ size_t taskCount, _In_ const std::function<void(Buffer&, size_t)>& func)
+	{
+		const size_t first = _usedBuffers;
+		_usedBuffers += taskCount;
+		if (_buffers.size() < _usedBuffers) _buffers.resize(_usedBuffers);
+
+		// the buffers are owned by the tasks, not the threads, so the replay order is deterministic
+		ThreadPool::Manager::Instance().ParallelFor(taskCount, [this, first, &func](size_t task)
+		{
+			func(_buffers[first + task], task);
+		});
+	}
+
+	/// <summary>
+	/// replay all recorded buffers in task order
+	/// </summary>
+	void Manager::Submit(_Inout_ Backend& backend)
+	{
+		for (size_t i = 0; i < _usedBuffers; ++i) _buffers[i].Replay(backend);
+
+		CountSubmittedBuffers();
+	}
+
+	/// <summary>
+	/// translate all recorded buffers in parallel
+	/// </summary>
+	void Manager::SubmitParallel(_In_ const std::function<void(const Buffer&, size_t)>& func)
+	{
+		ThreadPool::Manager::Instance().ParallelFor(_usedBuffers, [this, &func](size_t index)
+		{
+			func(_buffers[index], index);
+		});
+
+		CountSubmittedBuffers();
+	}
+
+	/// <summary>
+	/// add the submitted buffers to the statistics
+	/// </summary>
+	void Manager::CountSubmittedBuffers()
+	{
+		for (size_t i = 0; i < _usedBuffers; ++i)
+		{
+			const Buffer& buffer = _buffers[i];
+			_frameStats.Buffers++;
+			_frameStats.Commands += buffer.GetCommandCount();
+			_frameStats.Draws    += buffer.GetDrawCount();
+			_frameStats.Bytes    += buffer.GetSize();
+		}
+	}
+
+	/// <summary>
+	/// close statistics of the frame
+	/// </summary>
+	void Manager::EndFrame()
+	{
+		_lastFrameStats = _frameStats;
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// get the number of recorded buffers of the frame
+	/// </summary>
+	size_t Manager::GetBufferCount() const
+	{
+		return _usedBuffers;
+	}
+
+	/// <summary>
+	/// get a recorded buffer
+	/// </summary>
+	const Buffer& Manager::GetBuffer(_In_ size_t index) const
+	{
+		return _buffers[index];
+	}
+
+	/// <summary>
+	/// get statistics of the last frame
+	/// </summary>
+	const FrameStats& Manager::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
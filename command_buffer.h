@@ -0,0 +1,260 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "portable_sal.h"
+#include "pipeline_state.h"
+
+namespace CommandBuffer
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// commands are packed with this alignment in the linear buffer
+	constexpr size_t COMMAND_ALIGNMENT = 8;
+
+	// initial size of a buffer, it grows when a recording needs more
+	constexpr size_t DEFAULT_BUFFER_BYTES = 64 * 1024;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// kinds of recorded commands
+	/// </summary>
+	enum class CommandType : uint32_t
+	{
+		BindPipelineState,
+		SetVertexBuffer,
+		SetIndexBuffer,
+		SetPrimitiveTopology,
+		SetTexture,
+		UpdateBuffer,
+		Draw,
+		DrawIndexed,
+
+		Maximum
+	};
+
+	/// <summary>
+	/// primitive topologies
+	/// </summary>
+	enum class Topology : uint32_t
+	{
+		TriangleList,
+		TriangleStrip,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// header in front of every command
+	/// </summary>
+	struct CommandHeader
+	{
+		CommandType Type;
+		uint32_t Size;   // bytes including this header and the payload
+	};
+
+	struct BindPipelineStateCommand
+	{
+		PipelineState::Handle Handle;
+	};
+
+	struct SetVertexBufferCommand
+	{
+		PipelineState::ObjectId Buffer;
+		uint32_t Stride;
+		uint32_t Offset;
+	};
+
+	struct SetIndexBufferCommand
+	{
+		PipelineState::ObjectId Buffer;
+		bool Is32Bit;
+	};
+
+	struct SetPrimitiveTopologyCommand
+	{
+		Topology PrimitiveTopology;
+	};
+
+	struct SetTextureCommand
+	{
+		PipelineState::ObjectId Texture;
+		uint32_t Slot;
+	};
+
+	// the data of the whole buffer follows the command
+	struct UpdateBufferCommand
+	{
+		PipelineState::ObjectId Buffer;
+		uint32_t ByteSize;
+	};
+
+	struct DrawCommand
+	{
+		uint32_t VertexCount;
+		uint32_t StartVertex;
+	};
+
+	struct DrawIndexedCommand
+	{
+		uint32_t IndexCount;
+		uint32_t StartIndex;
+		int32_t  BaseVertex;
+	};
+
+	/// <summary>
+	/// statistics of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Buffers;
+		uint32_t Commands;
+		uint32_t Draws;
+		size_t Bytes;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	/// <summary>
+	/// executes replayed commands (a device context, a software renderer or nothing)
+	/// </summary>
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		virtual void BindPipelineState(const BindPipelineStateCommand& command) = 0;
+		virtual void SetVertexBuffer(const SetVertexBufferCommand& command) = 0;
+		virtual void SetIndexBuffer(const SetIndexBufferCommand& command) = 0;
+		virtual void SetPrimitiveTopology(const SetPrimitiveTopologyCommand& command) = 0;
+		virtual void SetTexture(const SetTextureCommand& command) = 0;
+		virtual void UpdateBuffer(const UpdateBufferCommand& command, const void* data) = 0;
+		virtual void Draw(const DrawCommand& command) = 0;
+		virtual void DrawIndexed(const DrawIndexedCommand& command) = 0;
+	};
+
+	/// <summary>
+	/// backend which only counts the commands
+	/// </summary>
+	class NullBackend : public Backend
+	{
+	public:
+		uint64_t Commands[static_cast<int>(CommandType::Maximum)] = {};
+
+		void BindPipelineState(const BindPipelineStateCommand&) override { Commands[static_cast<int>(CommandType::BindPipelineState)]++; }
+		void SetVertexBuffer(const SetVertexBufferCommand&) override { Commands[static_cast<int>(CommandType::SetVertexBuffer)]++; }
+		void SetIndexBuffer(const SetIndexBufferCommand&) override { Commands[static_cast<int>(CommandType::SetIndexBuffer)]++; }
+		void SetPrimitiveTopology(const SetPrimitiveTopologyCommand&) override { Commands[static_cast<int>(CommandType::SetPrimitiveTopology)]++; }
+		void SetTexture(const SetTextureCommand&) override { Commands[static_cast<int>(CommandType::SetTexture)]++; }
+		void UpdateBuffer(const UpdateBufferCommand&, const void*) override { Commands[static_cast<int>(CommandType::UpdateBuffer)]++; }
+		void Draw(const DrawCommand&) override { Commands[static_cast<int>(CommandType::Draw)]++; }
+		void DrawIndexed(const DrawIndexedCommand&) override { Commands[static_cast<int>(CommandType::DrawIndexed)]++; }
+	};
+
+	//--------------------------------------------------------
+	// buffer class
+	//--------------------------------------------------------
+	/// <summary>
+	/// linear command buffer written by one thread at a time
+	/// </summary>
+	class Buffer
+	{
+		std::vector<uint8_t> _data;
+		size_t _size;
+		uint32_t _commandCount;
+		uint32_t _drawCount;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void* Push(_In_ CommandType type, _In_ size_t payloadSize);
+
+		template <typename Command>
+		void Write(_In_ CommandType type, _In_ const Command& command);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Buffer();
+
+		void Reset();
+
+		// record
+		void BindPipelineState(_In_ PipelineState::Handle handle);
+		void SetVertexBuffer(_In_ PipelineState::ObjectId buffer, _In_ uint32_t stride, _In_ uint32_t offset);
+		void SetIndexBuffer(_In_ PipelineState::ObjectId buffer, _In_ bool is32Bit);
+		void SetPrimitiveTopology(_In_ Topology topology);
+		void SetTexture(_In_ uint32_t slot, _In_ PipelineState::ObjectId texture);
+		void UpdateBuffer(_In_ PipelineState::ObjectId buffer, _In_reads_bytes_(byteSize) const void* data, _In_ uint32_t byteSize);
+		void Draw(_In_ uint32_t vertexCount, _In_ uint32_t startVertex);
+		void DrawIndexed(_In_ uint32_t indexCount, _In_ uint32_t startIndex, _In_ int32_t baseVertex);
+
+		// execute the commands in recorded order
+		void Replay(_Inout_ Backend& backend) const;
+
+		// getter
+		size_t GetSize() const;
+		uint32_t GetCommandCount() const;
+		uint32_t GetDrawCount() const;
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		// one buffer per recording task, replayed in task order
+		std::vector<Buffer> _buffers;
+		size_t _usedBuffers;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void CountSubmittedBuffers();
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		void Terminate();
+
+		// reset all buffers for a new frame
+		void BeginFrame();
+
+		// record func(buffer, 0) .. func(buffer, taskCount - 1) on the thread pool, one buffer per task
+		void Record(_In_ size_t taskCount, _In_ const std::function<void(Buffer&, size_t)>& func);
+
+		// replay all recorded buffers in task order
+		void Submit(_Inout_ Backend& backend);
+
+		// translate func(buffer, 0) .. func(buffer, count - 1) on the thread pool
+		// (the caller executes the translated results in index order)
+		void SubmitParallel(_In_ const std::function<void(const Buffer&, size_t)>& func);
+
+		// close statistics of the frame
+		void EndFrame();
+
+		// getter
+		size_t GetBufferCount() const;
+		const Buffer& GetBuffer(_In_ size_t index) const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
@@ -0,0 +1,223 @@
+
+#include "directx11_wrapper.h"
+#include "renderer.h"
+#include "profiler.h"
+#include "thread_pool.h"
+#include "command_list.h"
+
+namespace CommandList
+{
+	//--------------------------------------------------------
+	// context backend
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for context backend
+	/// a new context has nothing bound, so the binder starts invalid
+	/// </summary>
+	ContextBackend::ContextBackend(_In_ ID3D11DeviceContext& context)
+		: _context(context, FrameCounters::Subsystem::CommandList)
+	{
+	}
+
+	/// <summary>
+	/// bind a pipeline state
+	/// </summary>
+	void ContextBackend::BindPipelineState(const CommandBuffer::BindPipelineStateCommand& command)
+	{
+		Renderer::Manager::Instance().BindPipelineState(_context, _binder, command.Handle);
+	}
+
+	/// <summary>
+	/// set the vertex buffer
+	/// </summary>
+	void ContextBackend::SetVertexBuffer(const CommandBuffer::SetVertexBufferCommand& command)
+	{
+		ID3D11Buffer* p_buffer = reinterpret_cast<ID3D11Buffer*>(command.Buffer);
+		UINT stride = command.Stride;
+		UINT offset = command.Offset;
+		_context.IASetVertexBuffers(0, 1, &p_buffer, &stride, &offset);
+	}
+
+	/// <summary>
+	/// set the index buffer
+	/// </summary>
+	void ContextBackend::SetIndexBuffer(const CommandBuffer::SetIndexBufferCommand& command)
+	{
+		_context.IASetIndexBuffer(reinterpret_cast<ID3D11Buffer*>(command.Buffer),
+			command.Is32Bit ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT, 0);
+	}
+
+	/// <summary>
+	/// set the primitive topology
+	/// </summary>
+	void ContextBackend::SetPrimitiveTopology(const CommandBuffer::SetPrimitiveTopologyCommand& command)
+	{
+		_context.IASetPrimitiveTopology(command.PrimitiveTopology == CommandBuffer::Topology::TriangleStrip
+			? D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP : D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	}
+
+	/// <summary>
+	/// set a texture of the pixel shader
+	/// </summary>
+	void ContextBackend::SetTexture(const CommandBuffer::SetTextureCommand& command)
+	{
+		ID3D11ShaderResourceView* p_srv = reinterpret_cast<ID3D11ShaderResourceView*>(command.Texture);
+		_context.PSSetShaderResources(command.Slot, 1, &p_srv);
+	}
+
+	/// <summary>
+	/// update a whole buffer
+	/// </summary>
+	void ContextBackend::UpdateBuffer(const CommandBuffer::UpdateBufferCommand& command, const void* data)
+	{
+		_context.UpdateConstantBuffer(reinterpret_cast<ID3D11Buffer*>(command.Buffer), data, command.ByteSize);
+	}
+
+	/// <summary>
+	/// get the counted context the commands are replayed into
+	/// </summary>
+	CountedContext::Context& ContextBackend::GetContext()
+	{
+		return _context;
+	}
+
+	/// <summary>
+	/// non-indexed draw
+	/// </summary>
+	void ContextBackend::Draw(const CommandBuffer::DrawCommand& command)
+	{
+		_context.Draw(command.VertexCount, command.StartVertex);
+	}
+
+	/// <summary>
+	/// indexed draw
+	/// </summary>
+	void ContextBackend::DrawIndexed(const CommandBuffer::DrawIndexedCommand& command)
+	{
+		_context.DrawIndexed(command.IndexCount, command.StartIndex, command.BaseVertex);
+	}
+
+	//--------------------------------------------------------
+	// manager
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for command list
+	/// </summary>
+	Manager::Manager()
+	{
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// termination process for command list
+	/// </summary>
+	void Manager::Terminate()
+	{
+		for (ID3D11CommandList* p_command_list : _commandLists)
+		{
+			if (p_command_list) p_command_list->Release();
+		}
+		_commandLists.clear();
+
+		for (ID3D11DeviceContext* p_context : _deferredContexts)
+		{
+			p_context->Release();
+		}
+		_deferredContexts.clear();
+	}
+
+	/// <summary>
+	/// creates deferred contexts until there is one per command buffer
+	/// </summary>
+	HRESULT Manager::CreateDeferredContexts(_In_ size_t count)
+	{
+		HRESULT h_result = S_OK;
+
+		while (_deferredContexts.size() < count)
+		{
+			ID3D11DeviceContext* p_context = nullptr;
+			h_result = Renderer::Manager::Instance().GetDevice().CreateDeferredContext(0, &p_context);
+			if (FAILED(h_result))
+				return h_result;
+
+			_deferredContexts.push_back(p_context);
+		}
+		_commandLists.resize(_deferredContexts.size(), nullptr);
+
+		return h_result;
+	}
+
+	/// <summary>
+	/// replay the command buffers directly on the immediate context
+	/// </summary>
+	void Manager::SubmitImmediate()
+	{
+		Renderer::Manager& renderer = Renderer::Manager::Instance();
+
+		ContextBackend backend(renderer.GetDeviceContext());
+		CommandBuffer::Manager::Instance().Submit(backend);
+
+		// the backend bound states behind the renderer
+		renderer.InvalidatePipelineState();
+	}
+
+	/// <summary>
+	/// replay the recorded command buffers of the frame
+	/// each buffer is translated on its own deferred context in parallel,
+	/// and the command lists are executed in the recorded order
+	/// </summary>
+	void Manager::Submit()
+	{
+		PROFILE_SCOPE("CommandList::Submit");
+
+		CommandBuffer::Manager& command_buffer = CommandBuffer::Manager::Instance();
+		Renderer::Manager& renderer = Renderer::Manager::Instance();
+
+		const size_t buffer_count = command_buffer.GetBufferCount();
+		if (buffer_count == 0)
+			return;
+
+		// nothing to overlap with, or no deferred contexts available
+		if (buffer_count == 1 || ThreadPool::Manager::Instance().GetWorkerCount() == 0 || FAILED(CreateDeferredContexts(buffer_count)))
+		{
+			SubmitImmediate();
+			return;
+		}
+
+		command_buffer.SubmitParallel([this, &renderer](const CommandBuffer::Buffer& buffer, size_t index)
+		{
+			ID3D11DeviceContext& context = *_deferredContexts[index];
+
+			ContextBackend backend(context);
+			renderer.SetFrameResourcesToContext(backend.GetContext());
+			buffer.Replay(backend);
+
+			context.FinishCommandList(FALSE, &_commandLists[index]);
+		});
+
+		// deterministic order regardless of which thread translated which buffer
+		ID3D11DeviceContext& immediate = renderer.GetDeviceContext();
+		CountedContext::Context counted_immediate(immediate, FrameCounters::Subsystem::CommandList);
+		for (size_t i = 0; i < buffer_count; ++i)
+		{
+			if (!_commandLists[i])
+				continue;
+
+			immediate.ExecuteCommandList(_commandLists[i], FALSE);
+			_commandLists[i]->Release();
+			_commandLists[i] = nullptr;
+		}
+
+		// executing without restoring leaves the immediate context in the default state
+		renderer.InvalidatePipelineState();
+		renderer.SetFrameResourcesToContext(counted_immediate);
+	}
+}
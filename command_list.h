@@ -0,0 +1,65 @@
+
+#pragma once
+
+#include <vector>
+
+#include "command_buffer.h"
+#include "counted_context.h"
+
+namespace CommandList
+{
+	//--------------------------------------------------------
+	// backend class
+	//--------------------------------------------------------
+	/// <summary>
+	/// replays command buffers into a device context (immediate or deferred)
+	/// </summary>
+	class ContextBackend : public CommandBuffer::Backend
+	{
+		CountedContext::Context _context;
+		PipelineState::Binder _binder;
+
+	public:
+		explicit ContextBackend(_In_ ID3D11DeviceContext& context);
+
+		void BindPipelineState(const CommandBuffer::BindPipelineStateCommand& command) override;
+		void SetVertexBuffer(const CommandBuffer::SetVertexBufferCommand& command) override;
+		void SetIndexBuffer(const CommandBuffer::SetIndexBufferCommand& command) override;
+		void SetPrimitiveTopology(const CommandBuffer::SetPrimitiveTopologyCommand& command) override;
+		void SetTexture(const CommandBuffer::SetTextureCommand& command) override;
+		void UpdateBuffer(const CommandBuffer::UpdateBufferCommand& command, const void* data) override;
+		void Draw(const CommandBuffer::DrawCommand& command) override;
+		void DrawIndexed(const CommandBuffer::DrawIndexedCommand& command) override;
+
+		// getter
+		CountedContext::Context& GetContext();
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		// one deferred context and command list per command buffer
+		std::vector<ID3D11DeviceContext*> _deferredContexts;
+		std::vector<ID3D11CommandList*> _commandLists;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		HRESULT CreateDeferredContexts(_In_ size_t count);
+		void SubmitImmediate();
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		void Terminate();
+
+		// replay the recorded command buffers of the frame to the immediate context
+		void Submit();
+	};
+}
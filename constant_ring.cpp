@@ -0,0 +1,117 @@
+
+#include <cstring>
+
+#include "constant_ring.h"
+
+namespace ConstantRing
+{
+	/// <summary>
+	/// constructor for constant ring
+	/// </summary>
+	Allocator::Allocator()
+	{
+		_backend  = nullptr;
+		_capacity = 0;
+		_head     = 0;
+		_generation = 0;
+		_isDiscardPending = true;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for constant ring
+	/// </summary>
+	void Allocator::Initialize(_In_ Backend* backend, _In_ uint32_t capacityBytes)
+	{
+		_backend  = backend;
+		_capacity = AlignConstants(capacityBytes);
+		_head     = 0;
+		_generation = 0;
+
+		// the first upload renames the buffer
+		_isDiscardPending = true;
+	}
+
+	/// <summary>
+	/// termination process for constant ring
+	/// </summary>
+	void Allocator::Terminate()
+	{
+		_backend  = nullptr;
+		_capacity = 0;
+	}
+
+	/// <summary>
+	/// copy constants into the ring
+	/// the used range is never overwritten, so the gpu can still read the older allocations
+	/// </summary>
+	Allocation Allocator::Upload(_In_reads_bytes_(byteSize) const void* data, _In_ uint32_t byteSize)
+	{
+		const uint32_t size = AlignConstants(byteSize);
+
+		// wrap around, the discard gives a fresh buffer without waiting for the gpu
+		if (_head + size > _capacity)
+		{
+			_head = 0;
+			_isDiscardPending = true;
+			_frameStats.Wraps++;
+		}
+
+		bool is_discard = _isDiscardPending;
+		if (is_discard)
+		{
+			_generation++;
+			_isDiscardPending = false;
+		}
+
+		Allocation allocation = { _head, size, _generation };
+
+		uint8_t* p_ring = _backend->MapConstants(is_discard);
+		if (p_ring)
+		{
+			std::memcpy(p_ring + _head, data, byteSize);
+			_backend->UnmapConstants();
+		}
+		_head += size;
+
+		_frameStats.UpdateCalls++;
+		_frameStats.UploadBytes += byteSize;
+
+		return allocation;
+	}
+
+	/// <summary>
+	/// check whether the data of an allocation is still in the ring
+	/// </summary>
+	bool Allocator::IsResident(_In_ const Allocation& allocation) const
+	{
+		return allocation.Generation == _generation && !_isDiscardPending;
+	}
+
+	/// <summary>
+	/// close statistics of the frame
+	/// </summary>
+	void Allocator::EndFrame()
+	{
+		_lastFrameStats = _frameStats;
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// get the size of the ring in bytes
+	/// </summary>
+	uint32_t Allocator::GetCapacity() const
+	{
+		return _capacity;
+	}
+
+	/// <summary>
+	/// get statistics of the last frame
+	/// </summary>
+	const FrameStats& Allocator::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
@@ -0,0 +1,102 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "portable_sal.h"
+
+namespace ConstantRing
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// constant buffer offsets are bound in units of 16 constants (256 bytes)
+	constexpr uint32_t CONSTANT_ALIGNMENT = 256;
+	constexpr uint32_t CONSTANT_SIZE      = 16;
+
+	constexpr uint32_t DEFAULT_CAPACITY_BYTES = 1024 * 1024;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// uploaded constants in the ring
+	/// </summary>
+	struct Allocation
+	{
+		uint32_t Offset;      // bytes from the start of the ring
+		uint32_t Size;        // aligned bytes
+		uint64_t Generation;  // the ring was discarded this many times before
+	};
+
+	/// <summary>
+	/// statistics of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t UpdateCalls;
+		uint32_t UploadBytes;
+		uint32_t Wraps;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	/// <summary>
+	/// owner of the gpu ring buffer
+	/// </summary>
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		// discard: the whole buffer may be renamed, otherwise written without overwriting used ranges
+		virtual uint8_t* MapConstants(bool discard) = 0;
+		virtual void UnmapConstants() = 0;
+	};
+
+	//--------------------------------------------------------
+	// allocator class
+	//--------------------------------------------------------
+	class Allocator
+	{
+		Backend* _backend;
+		uint32_t _capacity;
+		uint32_t _head;
+		uint64_t _generation;
+		bool _isDiscardPending;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+	public:
+		Allocator();
+
+		void Initialize(_In_ Backend* backend, _In_ uint32_t capacityBytes = DEFAULT_CAPACITY_BYTES);
+		void Terminate();
+
+		// copy constants into the ring (the ring is discarded when it is full)
+		Allocation Upload(_In_reads_bytes_(byteSize) const void* data, _In_ uint32_t byteSize);
+
+		// true while the data of the allocation has not been discarded
+		bool IsResident(_In_ const Allocation& allocation) const;
+
+		void EndFrame();
+
+		// getter
+		uint32_t GetCapacity() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// round up to the constant alignment
+	/// </summary>
+	inline uint32_t AlignConstants(uint32_t byteSize)
+	{
+		return (byteSize + CONSTANT_ALIGNMENT - 1) & ~(CONSTANT_ALIGNMENT - 1);
+	}
+}
@@ -0,0 +1,298 @@
+
+#include "directx11_wrapper.h"
+#include "counted_context.h"
+
+namespace CountedContext
+{
+	using FrameCounters::Counter;
+
+	/// <summary>
+	/// constructor for counted context
+	/// </summary>
+	Context::Context(_In_ ID3D11DeviceContext& context, _In_ FrameCounters::Subsystem subsystem, _In_opt_ ID3D11DeviceContext1* p_context1)
+	{
+		_context   = &context;
+		_context1  = p_context1;
+		_subsystem = subsystem;
+	}
+
+	/// <summary>
+	/// count for the subsystem of the context
+	/// </summary>
+	void Context::Count(FrameCounters::Counter counter, uint64_t value) const
+	{
+		FrameCounters::Manager::Instance().Add(_subsystem, counter, value);
+	}
+
+	//--------------------------------------------------------
+	// input assembler
+	//--------------------------------------------------------
+	/// <summary>
+	/// set vertex buffers
+	/// </summary>
+	void Context::IASetVertexBuffers(_In_ UINT slot, _In_ UINT count, _In_ ID3D11Buffer* const* pp_buffers, _In_ const UINT* p_strides, _In_ const UINT* p_offsets)
+	{
+		Count(Counter::StateChanges);
+		_context->IASetVertexBuffers(slot, count, pp_buffers, p_strides, p_offsets);
+	}
+
+	/// <summary>
+	/// set the index buffer
+	/// </summary>
+	void Context::IASetIndexBuffer(_In_opt_ ID3D11Buffer* p_buffer, _In_ DXGI_FORMAT format, _In_ UINT offset)
+	{
+		Count(Counter::StateChanges);
+		_context->IASetIndexBuffer(p_buffer, format, offset);
+	}
+
+	/// <summary>
+	/// set the primitive topology
+	/// </summary>
+	void Context::IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		Count(Counter::StateChanges);
+		_context->IASetPrimitiveTopology(topology);
+	}
+
+	/// <summary>
+	/// set the input layout
+	/// </summary>
+	void Context::IASetInputLayout(_In_opt_ ID3D11InputLayout* p_inputLayout)
+	{
+		Count(Counter::StateChanges);
+		_context->IASetInputLayout(p_inputLayout);
+	}
+
+	//--------------------------------------------------------
+	// shaders
+	//--------------------------------------------------------
+	/// <summary>
+	/// set the vertex shader
+	/// </summary>
+	void Context::VSSetShader(_In_opt_ ID3D11VertexShader* p_shader)
+	{
+		Count(Counter::StateChanges);
+		_context->VSSetShader(p_shader, nullptr, 0);
+	}
+
+	/// <summary>
+	/// set the pixel shader
+	/// </summary>
+	void Context::PSSetShader(_In_opt_ ID3D11PixelShader* p_shader)
+	{
+		Count(Counter::StateChanges);
+		_context->PSSetShader(p_shader, nullptr, 0);
+	}
+
+	/// <summary>
+	/// set Shader-Resource-Views of the pixel shader
+	/// </summary>
+	void Context::PSSetShaderResources(_In_ UINT slot, _In_ UINT count, _In_ ID3D11ShaderResourceView* const* pp_srvs)
+	{
+		Count(Counter::StateChanges);
+		_context->PSSetShaderResources(slot, count, pp_srvs);
+	}
+
+	/// <summary>
+	/// set samplers of the pixel shader
+	/// </summary>
+	void Context::PSSetSamplers(_In_ UINT slot, _In_ UINT count, _In_ ID3D11SamplerState* const* pp_samplers)
+	{
+		Count(Counter::StateChanges);
+		_context->PSSetSamplers(slot, count, pp_samplers);
+	}
+
+	/// <summary>
+	/// bind a range of a constant buffer to the vertex shader
+	/// a context without ID3D11DeviceContext1 is queried on the call
+	/// </summary>
+	void Context::VSSetConstantBuffers1(_In_ UINT slot, _In_ ID3D11Buffer* p_buffer, _In_ UINT firstConstant, _In_ UINT constantCount)
+	{
+		ID3D11DeviceContext1* p_context1 = _context1;
+		if (!p_context1 && FAILED(_context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&p_context1))))
+			return;
+
+		Count(Counter::StateChanges);
+		p_context1->VSSetConstantBuffers1(slot, 1, &p_buffer, &firstConstant, &constantCount);
+
+		if (p_context1 != _context1) p_context1->Release();
+	}
+
+	/// <summary>
+	/// bind a range of a constant buffer to the pixel shader
+	/// </summary>
+	void Context::PSSetConstantBuffers1(_In_ UINT slot, _In_ ID3D11Buffer* p_buffer, _In_ UINT firstConstant, _In_ UINT constantCount)
+	{
+		ID3D11DeviceContext1* p_context1 = _context1;
+		if (!p_context1 && FAILED(_context->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&p_context1))))
+			return;
+
+		Count(Counter::StateChanges);
+		p_context1->PSSetConstantBuffers1(slot, 1, &p_buffer, &firstConstant, &constantCount);
+
+		if (p_context1 != _context1) p_context1->Release();
+	}
+
+	//--------------------------------------------------------
+	// rasterizer and output merger
+	//--------------------------------------------------------
+	/// <summary>
+	/// set the rasterizer state
+	/// </summary>
+	void Context::RSSetState(_In_opt_ ID3D11RasterizerState* p_state)
+	{
+		Count(Counter::StateChanges);
+		_context->RSSetState(p_state);
+	}
+
+	/// <summary>
+	/// set viewports
+	/// </summary>
+	void Context::RSSetViewports(_In_ UINT count, _In_ const D3D11_VIEWPORT* p_viewports)
+	{
+		Count(Counter::StateChanges);
+		_context->RSSetViewports(count, p_viewports);
+	}
+
+	/// <summary>
+	/// set render targets
+	/// </summary>
+	void Context::OMSetRenderTargets(_In_ UINT count, _In_ ID3D11RenderTargetView* const* pp_rtvs, _In_opt_ ID3D11DepthStencilView* p_dsv)
+	{
+		Count(Counter::StateChanges);
+		_context->OMSetRenderTargets(count, pp_rtvs, p_dsv);
+	}
+
+	/// <summary>
+	/// set the blend state
+	/// </summary>
+	void Context::OMSetBlendState(_In_opt_ ID3D11BlendState* p_state, _In_opt_ const FLOAT blendFactor[4], _In_ UINT sampleMask)
+	{
+		Count(Counter::StateChanges);
+		_context->OMSetBlendState(p_state, blendFactor, sampleMask);
+	}
+
+	/// <summary>
+	/// set the depth stencil state
+	/// </summary>
+	void Context::OMSetDepthStencilState(_In_opt_ ID3D11DepthStencilState* p_state, _In_ UINT stencilRef)
+	{
+		Count(Counter::StateChanges);
+		_context->OMSetDepthStencilState(p_state, stencilRef);
+	}
+
+	//--------------------------------------------------------
+	// resources
+	//--------------------------------------------------------
+	/// <summary>
+	/// map a resource
+	/// </summary>
+	HRESULT Context::Map(_In_ ID3D11Resource* p_resource, _In_ UINT subresource, _In_ D3D11_MAP mapType, _Out_ D3D11_MAPPED_SUBRESOURCE* p_mapped)
+	{
+		Count(Counter::Maps);
+		return _context->Map(p_resource, subresource, mapType, 0, p_mapped);
+	}
+
+	/// <summary>
+	/// unmap a resource
+	/// </summary>
+	void Context::Unmap(_In_ ID3D11Resource* p_resource, _In_ UINT subresource)
+	{
+		Count(Counter::Unmaps);
+		_context->Unmap(p_resource, subresource);
+	}
+
+	/// <summary>
+	/// update a whole constant buffer
+	/// </summary>
+	void Context::UpdateConstantBuffer(_In_ ID3D11Buffer* p_buffer, _In_reads_bytes_(size) const void* data, _In_ UINT size)
+	{
+		AddConstantUpdate(size);
+		_context->UpdateSubresource(p_buffer, 0, nullptr, data, 0, 0);
+	}
+
+	/// <summary>
+	/// update a byte range of a buffer (e.g. some elements of a structured buffer)
+	/// </summary>
+	void Context::UpdateBufferRange(_In_ ID3D11Buffer* p_buffer, _In_ UINT offset, _In_reads_bytes_(size) const void* data, _In_ UINT size)
+	{
+		AddConstantUpdate(size);
+
+		const D3D11_BOX box = { offset, 0, 0, offset + size, 1, 1 };
+		_context->UpdateSubresource(p_buffer, 0, &box, data, 0, 0);
+	}
+
+	/// <summary>
+	/// count bytes written without a call of the context
+	/// </summary>
+	void Context::AddUploadBytes(_In_ uint64_t bytes) const
+	{
+		Count(Counter::UploadBytes, bytes);
+	}
+
+	/// <summary>
+	/// count a constant update and its bytes
+	/// </summary>
+	void Context::AddConstantUpdate(_In_ uint64_t bytes) const
+	{
+		Count(Counter::ConstantUpdates);
+		Count(Counter::UploadBytes, bytes);
+	}
+
+	//--------------------------------------------------------
+	// draw
+	//--------------------------------------------------------
+	/// <summary>
+	/// draw non-indexed primitives
+	/// </summary>
+	void Context::Draw(_In_ UINT vertexCount, _In_ UINT startVertex)
+	{
+		Count(Counter::Draws);
+		Count(Counter::Vertices, vertexCount);
+		_context->Draw(vertexCount, startVertex);
+	}
+
+	/// <summary>
+	/// draw indexed primitives
+	/// </summary>
+	void Context::DrawIndexed(_In_ UINT indexCount, _In_ UINT startIndex, _In_ INT baseVertex)
+	{
+		Count(Counter::Draws);
+		Count(Counter::Vertices, indexCount);
+		_context->DrawIndexed(indexCount, startIndex, baseVertex);
+	}
+
+	/// <summary>
+	/// draw non-indexed instances
+	/// </summary>
+	void Context::DrawInstanced(_In_ UINT vertexCountPerInstance, _In_ UINT instanceCount, _In_ UINT startVertex, _In_ UINT startInstance)
+	{
+		Count(Counter::Draws);
+		Count(Counter::Vertices, static_cast<uint64_t>(vertexCountPerInstance) * instanceCount);
+		_context->DrawInstanced(vertexCountPerInstance, instanceCount, startVertex, startInstance);
+	}
+
+	/// <summary>
+	/// clear a Render-Target-View
+	/// </summary>
+	void Context::ClearRenderTargetView(_In_ ID3D11RenderTargetView* p_rtv, _In_ const FLOAT color[4])
+	{
+		_context->ClearRenderTargetView(p_rtv, color);
+	}
+
+	/// <summary>
+	/// clear a Depth-Stencil-View
+	/// </summary>
+	void Context::ClearDepthStencilView(_In_ ID3D11DepthStencilView* p_dsv, _In_ UINT flags, _In_ FLOAT depth, _In_ UINT8 stencil)
+	{
+		_context->ClearDepthStencilView(p_dsv, flags, depth, stencil);
+	}
+
+	/// <summary>
+	/// get the wrapped device context, for calls which are not counted (deferred command lists)
+	/// </summary>
+	ID3D11DeviceContext& Context::GetDeviceContext()
+	{
+		return *_context;
+	}
+}
@@ -0,0 +1,75 @@
+
+#pragma once
+
+#include "frame_counters.h"
+
+namespace CountedContext
+{
+	//--------------------------------------------------------
+	// context class
+	//--------------------------------------------------------
+	/// <summary>
+	/// forwards device context calls, and counts them for a subsystem
+	/// every draw, state change, map and upload of the renderer goes through this
+	/// </summary>
+	class Context
+	{
+		ID3D11DeviceContext* _context;
+		ID3D11DeviceContext1* _context1;
+		FrameCounters::Subsystem _subsystem;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void Count(FrameCounters::Counter counter, uint64_t value = 1) const;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		// context1 is only needed for the constant buffer offsets
+		Context(_In_ ID3D11DeviceContext& context, _In_ FrameCounters::Subsystem subsystem, _In_opt_ ID3D11DeviceContext1* p_context1 = nullptr);
+
+		// input assembler
+		void IASetVertexBuffers(_In_ UINT slot, _In_ UINT count, _In_ ID3D11Buffer* const* pp_buffers, _In_ const UINT* p_strides, _In_ const UINT* p_offsets);
+		void IASetIndexBuffer(_In_opt_ ID3D11Buffer* p_buffer, _In_ DXGI_FORMAT format, _In_ UINT offset);
+		void IASetPrimitiveTopology(_In_ D3D11_PRIMITIVE_TOPOLOGY topology);
+		void IASetInputLayout(_In_opt_ ID3D11InputLayout* p_inputLayout);
+
+		// shaders
+		void VSSetShader(_In_opt_ ID3D11VertexShader* p_shader);
+		void PSSetShader(_In_opt_ ID3D11PixelShader* p_shader);
+		void PSSetShaderResources(_In_ UINT slot, _In_ UINT count, _In_ ID3D11ShaderResourceView* const* pp_srvs);
+		void PSSetSamplers(_In_ UINT slot, _In_ UINT count, _In_ ID3D11SamplerState* const* pp_samplers);
+		void VSSetConstantBuffers1(_In_ UINT slot, _In_ ID3D11Buffer* p_buffer, _In_ UINT firstConstant, _In_ UINT constantCount);
+		void PSSetConstantBuffers1(_In_ UINT slot, _In_ ID3D11Buffer* p_buffer, _In_ UINT firstConstant, _In_ UINT constantCount);
+
+		// rasterizer and output merger
+		void RSSetState(_In_opt_ ID3D11RasterizerState* p_state);
+		void RSSetViewports(_In_ UINT count, _In_ const D3D11_VIEWPORT* p_viewports);
+		void OMSetRenderTargets(_In_ UINT count, _In_ ID3D11RenderTargetView* const* pp_rtvs, _In_opt_ ID3D11DepthStencilView* p_dsv);
+		void OMSetBlendState(_In_opt_ ID3D11BlendState* p_state, _In_opt_ const FLOAT blendFactor[4], _In_ UINT sampleMask);
+		void OMSetDepthStencilState(_In_opt_ ID3D11DepthStencilState* p_state, _In_ UINT stencilRef);
+
+		// resources
+		HRESULT Map(_In_ ID3D11Resource* p_resource, _In_ UINT subresource, _In_ D3D11_MAP mapType, _Out_ D3D11_MAPPED_SUBRESOURCE* p_mapped);
+		void Unmap(_In_ ID3D11Resource* p_resource, _In_ UINT subresource);
+		void UpdateConstantBuffer(_In_ ID3D11Buffer* p_buffer, _In_reads_bytes_(size) const void* data, _In_ UINT size);
+		void UpdateBufferRange(_In_ ID3D11Buffer* p_buffer, _In_ UINT offset, _In_reads_bytes_(size) const void* data, _In_ UINT size);
+
+		// bytes written through a mapping, or created with initial data
+		void AddUploadBytes(_In_ uint64_t bytes) const;
+		void AddConstantUpdate(_In_ uint64_t bytes) const;
+
+		// draw
+		void Draw(_In_ UINT vertexCount, _In_ UINT startVertex);
+		void DrawIndexed(_In_ UINT indexCount, _In_ UINT startIndex, _In_ INT baseVertex);
+		void DrawInstanced(_In_ UINT vertexCountPerInstance, _In_ UINT instanceCount, _In_ UINT startVertex, _In_ UINT startInstance);
+
+		void ClearRenderTargetView(_In_ ID3D11RenderTargetView* p_rtv, _In_ const FLOAT color[4]);
+		void ClearDepthStencilView(_In_ ID3D11DepthStencilView* p_dsv, _In_ UINT flags, _In_ FLOAT depth, _In_ UINT8 stencil);
+
+		// getter
+		ID3D11DeviceContext& GetDeviceContext();
+	};
+}
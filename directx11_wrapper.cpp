@@ -1,11 +1,28 @@
 
+#include <cstdio>
+
 #include "directx11_wrapper.h"
+#include "profiler.h"
+#include "atlas.h"
 #include "renderer.h"
+#include "command_buffer.h"
+#include "command_list.h"
 #include "sprite.h"
+#include "sprite_batch.h"
 #include "texture.h"
+#include "texture_stream.h"
+#include "thread_pool.h"
 
 namespace DirectXWrapper
 {
+	/// <summary>
+	/// constructor for directx
+	/// </summary>
+	Manager::Manager()
+	{
+		_interpolation = 0.0f;
+	}
+
 	/// <summary>
 	/// instantiate with the Singleton Method Design Pattern
 	/// </summary>
@@ -17,15 +34,24 @@ namespace DirectXWrapper
 
 	/// <summary>
 	/// initialization process for directx
+	/// each subsystem uses the ones before it, so the first failure stops the initialization
 	/// </summary>
-	HRESULT Manager::Initialize()
+	int Manager::Initialize()
 	{
-		HRESULT h_result = S_OK;
+		ThreadPool::Manager::Instance().Initialize();
+
+		if (FAILED(Renderer::Manager::Instance().Initialize())) return -1;
+		if (FAILED(SpriteBatch::Manager::Instance().Initialize())) return -1;
+		if (FAILED(TextureStream::Manager::Instance().Initialize())) return -1;
 
-		h_result = Renderer::Manager::Instance().Initialize();
-		h_result = Texture::Manager::Instance().Initialize();
+		// alpha blended and additive sprites are drawn in one batch, the atlas pages are loaded premultiplied too
+		Sprite::Manager::Instance().SetPremultipliedAlpha(true);
 
-		return h_result;
+		if (FAILED(Atlas::Manager::Instance().Initialize())) return -1;
+		if (FAILED(Sprite::Manager::Instance().Initialize())) return -1;
+		if (FAILED(Texture::Manager::Instance().Initialize())) return -1;
+
+		return 0;
 	}
 
 	/// <summary>
@@ -34,26 +60,115 @@ namespace DirectXWrapper
 	void Manager::Terminate()
 	{
 		Texture::Manager::Instance().Terminate();
+		Sprite::Manager::Instance().Terminate();
+		Atlas::Manager::Instance().Terminate();
+		TextureStream::Manager::Instance().Terminate();
+		SpriteBatch::Manager::Instance().Terminate();
+		CommandList::Manager::Instance().Terminate();
+		CommandBuffer::Manager::Instance().Terminate();
 		Renderer::Manager::Instance().Terminate();
+
+		ThreadPool::Manager::Instance().Terminate();
 	}
 
 	/// <summary>
-	/// update process for directx
+	/// simulation step for directx, called at the fixed rate of the frame scheduler
 	/// </summary>
-	void Manager::Update()
+	void Manager::FixedUpdate()
 	{
+		PROFILE_SCOPE("DirectXWrapper::FixedUpdate");
+
+		// the sprites are interpolated from the state before this step
+		Sprite::Manager::Instance().FixedUpdate();
 		Texture::Manager::Instance().Update();
 	}
 
+	/// <summary>
+	/// update process for directx, called once per drawn frame
+	/// </summary>
+	void Manager::Update()
+	{
+		PROFILE_SCOPE("DirectXWrapper::Update");
+
+		// command buffers of the frame are recorded during the update
+		CommandBuffer::Manager::Instance().BeginFrame();
+
+		// textures decoded since the last frame become resident
+		TextureStream::Manager::Instance().Update();
+	}
+
 	/// <summary>
 	/// draw process for directx
 	/// </summary>
-	void Manager::Draw()
+	void Manager::Draw(_In_ float interpolation)
 	{
+		PROFILE_SCOPE("DirectXWrapper::Draw");
+
+		// sprites are drawn between their last two simulated states
+		_interpolation = interpolation;
+
 		Renderer::Manager::Instance().ClearViews();
 
+		// draws recorded by worker threads are replayed before the sprites
+		CommandList::Manager::Instance().Submit();
+
+		SpriteBatch::Manager::Instance().Begin();
 		Texture::Manager::Instance().Draw();
+		Sprite::Manager::Instance().Draw(interpolation);
+		SpriteBatch::Manager::Instance().End();
 
 		Renderer::Manager::Instance().FlipFrameBuffer();
+		CommandBuffer::Manager::Instance().EndFrame();
+	}
+
+	/// <summary>
+	/// statistics of the previous frame for the debug title
+	/// </summary>
+	void Manager::AppendDebugTitle(_Inout_ char* buffer, _In_ size_t size) const
+	{
+		// sprite batch, state changes, constant and material uploads and texture streaming
+		const SpriteBatch::FrameStats& batch_stats = SpriteBatch::Manager::Instance().GetLastFrameStats();
+		const PipelineState::FrameStats& state_stats = Renderer::Manager::Instance().GetLastPipelineStats();
+		const ConstantRing::FrameStats& constant_stats = Renderer::Manager::Instance().GetLastConstantStats();
+		const MaterialTable::FrameStats& material_stats = Renderer::Manager::Instance().GetMaterialTable().GetLastFrameStats();
+		const TextureStream::FrameStats& stream_stats = TextureStream::Manager::Instance().GetLastFrameStats();
+
+		// pipeline counters, over all subsystems
+		const FrameCounters::Manager& counters = FrameCounters::Manager::Instance();
+
+		// sprites left after the culling, and the state changes saved by sorting them
+		const SpriteGrid::QueryStats& culling_stats = Sprite::Manager::Instance().GetLastCullingStats();
+		const SortKey::SortStats& sort_stats = Sprite::Manager::Instance().GetLastSortStats();
+		const StaticGeometry::FrameStats& static_stats = Sprite::Manager::Instance().GetLastStaticStats();
+
+		std::snprintf(buffer, size,
+			" - sprites [ %u / %u visible ]"
+			" - sort [ %u / %u state changes ]"
+			" - static [ %u / %u chunks %u rebuilt %u patched %u streamed ]"
+			" - batches [ %u ] quads [ %u ] bytes [ %u ]"
+			" - states [ %u / %u skipped ]"
+			" - constants [ %u calls %u bytes ]"
+			" - materials [ %u / %u slots %u bytes ]"
+			" - streaming [ %u uploads %u bytes %u pending ]"
+			" - draws [ %u ] maps [ %u ] uploaded [ %u bytes ]",
+			culling_stats.Visible, Sprite::Manager::Instance().GetRegistry().GetCount(),
+			sort_stats.StateChanges, sort_stats.StateChangesUnsorted,
+			static_stats.ChunksDrawn, static_stats.Chunks, static_stats.ChunksRebuilt, static_stats.ChunksPatched, static_stats.Detached,
+			batch_stats.Batches, batch_stats.Quads, static_cast<unsigned>(batch_stats.Bytes),
+			state_stats.Issued, state_stats.Skipped,
+			constant_stats.UpdateCalls, constant_stats.UploadBytes,
+			material_stats.UploadedSlots, Renderer::Manager::Instance().GetMaterialTable().GetCount(), static_cast<unsigned>(material_stats.UploadBytes),
+			stream_stats.Uploads, static_cast<unsigned>(stream_stats.UploadBytes), stream_stats.Queued + stream_stats.InFlight,
+			static_cast<unsigned>(counters.GetLastFrame(FrameCounters::Counter::Draws)),
+			static_cast<unsigned>(counters.GetLastFrame(FrameCounters::Counter::Maps)),
+			static_cast<unsigned>(counters.GetLastFrame(FrameCounters::Counter::UploadBytes)));
+	}
+
+	/// <summary>
+	/// get the position of the drawn frame between the last two fixed steps
+	/// </summary>
+	float Manager::GetInterpolation() const
+	{
+		return _interpolation;
 	}
-}
\ No newline at end of file
+}
@@ -6,8 +6,10 @@
 
 // instructs the preprocessor to include the specified header file
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <directxmath.h>
+#include <directxpackedvector.h>
 #include <directxtex.h>
 
 #pragma warning(pop)
@@ -18,16 +20,31 @@
 #pragma comment (lib, "dxgi.lib")
 #pragma comment (lib, "directxtex.lib")
 
+#include "application.h"
+
 namespace DirectXWrapper
 {
-	class Manager
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager : public Application::Graphics
 	{
+		// position of the drawn frame between the last two fixed steps
+		float _interpolation;
+
 	public:
+		Manager();
 		static Manager& Instance();
 
-		HRESULT Initialize();
-		void Terminate();
-		void Update();
-		void Draw();
+		int Initialize() override;
+		void Terminate() override;
+		void FixedUpdate() override;
+		void Update() override;
+		void Draw(_In_ float interpolation) override;
+
+		void AppendDebugTitle(_Inout_ char* buffer, _In_ size_t size) const override;
+
+		// getter
+		float GetInterpolation() const;
 	};
 }
@@ -0,0 +1,161 @@
+
+#include <algorithm>
+
+#include "frame_counters.h"
+
+namespace FrameCounters
+{
+	/// <summary>
+	/// constructor for frame counters
+	/// </summary>
+	Manager::Manager()
+	{
+		Reset();
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// move the counts of the frame into the history
+	/// </summary>
+	void Manager::EndFrame()
+	{
+		for (int s = 0; s < SUBSYSTEM_COUNT; ++s)
+		{
+			for (int c = 0; c < COUNTER_COUNT; ++c)
+			{
+				_history[_historyHead][s][c] = _current[s][c].exchange(0, std::memory_order_relaxed);
+			}
+		}
+
+		_historyHead = (_historyHead + 1) % HISTORY_FRAMES;
+		_historyCount = std::min(_historyCount + 1, HISTORY_FRAMES);
+	}
+
+	/// <summary>
+	/// clear the frame and the history
+	/// </summary>
+	void Manager::Reset()
+	{
+		for (int s = 0; s < SUBSYSTEM_COUNT; ++s)
+		{
+			for (int c = 0; c < COUNTER_COUNT; ++c)
+			{
+				_current[s][c].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		_historyHead  = 0;
+		_historyCount = 0;
+	}
+
+	/// <summary>
+	/// get a count of a completed frame, age 0 is the last one
+	/// </summary>
+	uint64_t Manager::GetHistory(_In_ uint32_t age, _In_ int subsystem, _In_ int counter) const
+	{
+		const uint32_t index = (_historyHead + HISTORY_FRAMES - 1 - age) % HISTORY_FRAMES;
+		if (subsystem >= 0)
+			return _history[index][subsystem][counter];
+
+		uint64_t total = 0;
+		for (int s = 0; s < SUBSYSTEM_COUNT; ++s)
+		{
+			total += _history[index][s][counter];
+		}
+
+		return total;
+	}
+
+	/// <summary>
+	/// get a count of the last frame over all subsystems
+	/// </summary>
+	uint64_t Manager::GetLastFrame(_In_ Counter counter) const
+	{
+		return _historyCount ? GetHistory(0, -1, static_cast<int>(counter)) : 0;
+	}
+
+	/// <summary>
+	/// get a count of the last frame of a subsystem
+	/// </summary>
+	uint64_t Manager::GetLastFrame(_In_ Subsystem subsystem, _In_ Counter counter) const
+	{
+		return _historyCount ? GetHistory(0, static_cast<int>(subsystem), static_cast<int>(counter)) : 0;
+	}
+
+	/// <summary>
+	/// get min / avg / max of a counter over the history, subsystem -1 is all of them
+	/// </summary>
+	Summary Manager::Summarize(_In_ int subsystem, _In_ int counter) const
+	{
+		Summary summary = {};
+		uint64_t sum = 0;
+		for (uint32_t age = 0; age < _historyCount; ++age)
+		{
+			const uint64_t value = GetHistory(age, subsystem, counter);
+			summary.Min = (age == 0) ? value : std::min(summary.Min, value);
+			summary.Max = std::max(summary.Max, value);
+			sum += value;
+		}
+		summary.Frames  = _historyCount;
+		summary.Average = _historyCount ? static_cast<double>(sum) / _historyCount : 0.0;
+
+		return summary;
+	}
+
+	/// <summary>
+	/// get min / avg / max of a counter over all subsystems
+	/// </summary>
+	Summary Manager::GetSummary(_In_ Counter counter) const
+	{
+		return Summarize(-1, static_cast<int>(counter));
+	}
+
+	/// <summary>
+	/// get min / avg / max of a counter of a subsystem
+	/// </summary>
+	Summary Manager::GetSummary(_In_ Subsystem subsystem, _In_ Counter counter) const
+	{
+		return Summarize(static_cast<int>(subsystem), static_cast<int>(counter));
+	}
+
+	/// <summary>
+	/// get the name of a counter
+	/// </summary>
+	const char* Manager::GetCounterName(_In_ Counter counter)
+	{
+		switch (counter)
+		{
+		case Counter::Draws:           return "draws";
+		case Counter::Vertices:        return "vertices";
+		case Counter::StateChanges:    return "state changes";
+		case Counter::ConstantUpdates: return "constant updates";
+		case Counter::Maps:            return "maps";
+		case Counter::Unmaps:          return "unmaps";
+		case Counter::UploadBytes:     return "upload bytes";
+		default:                       return "";
+		}
+	}
+
+	/// <summary>
+	/// get the name of a subsystem
+	/// </summary>
+	const char* Manager::GetSubsystemName(_In_ Subsystem subsystem)
+	{
+		switch (subsystem)
+		{
+		case Subsystem::Renderer:      return "renderer";
+		case Subsystem::SpriteBatch:   return "sprite batch";
+		case Subsystem::CommandList:   return "command list";
+		case Subsystem::TextureStream: return "texture stream";
+		default:                       return "";
+		}
+	}
+}
@@ -0,0 +1,116 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "portable_sal.h"
+
+namespace FrameCounters
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// frames kept for the rolling min / avg / max
+	constexpr uint32_t HISTORY_FRAMES = 120;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// enumeration of counters
+	/// </summary>
+	enum class Counter
+	{
+		Draws,
+		Vertices,                // vertices or indices submitted by the draws
+		StateChanges,
+		ConstantUpdates,
+		Maps,
+		Unmaps,
+		UploadBytes,
+
+		Maximum
+	};
+
+	/// <summary>
+	/// enumeration of subsystems which talk to the device context
+	/// </summary>
+	enum class Subsystem
+	{
+		Renderer,
+		SpriteBatch,
+		CommandList,
+		TextureStream,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// rolling statistics of a counter
+	/// </summary>
+	struct Summary
+	{
+		uint64_t Min;
+		uint64_t Max;
+		double Average;
+		uint32_t Frames;
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		static constexpr int SUBSYSTEM_COUNT = static_cast<int>(Subsystem::Maximum);
+		static constexpr int COUNTER_COUNT   = static_cast<int>(Counter::Maximum);
+
+		// counted by any thread during the frame
+		std::atomic<uint64_t> _current[SUBSYSTEM_COUNT][COUNTER_COUNT];
+
+		// completed frames, _historyHead is the next to be written
+		uint64_t _history[HISTORY_FRAMES][SUBSYSTEM_COUNT][COUNTER_COUNT];
+		uint32_t _historyHead;
+		uint32_t _historyCount;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		uint64_t GetHistory(_In_ uint32_t age, _In_ int subsystem, _In_ int counter) const;
+		Summary Summarize(_In_ int subsystem, _In_ int counter) const;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		/// <summary>
+		/// count an event of a subsystem (thread safe)
+		/// </summary>
+		void Add(_In_ Subsystem subsystem, _In_ Counter counter, _In_ uint64_t value = 1)
+		{
+			_current[static_cast<int>(subsystem)][static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+		}
+
+		// close the frame into the history
+		void EndFrame();
+		void Reset();
+
+		// the last completed frame, of a subsystem or of all of them
+		uint64_t GetLastFrame(_In_ Counter counter) const;
+		uint64_t GetLastFrame(_In_ Subsystem subsystem, _In_ Counter counter) const;
+
+		// min / avg / max over the history
+		Summary GetSummary(_In_ Counter counter) const;
+		Summary GetSummary(_In_ Subsystem subsystem, _In_ Counter counter) const;
+
+		static const char* GetCounterName(_In_ Counter counter);
+		static const char* GetSubsystemName(_In_ Subsystem subsystem);
+	};
+}
@@ -0,0 +1,259 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+#include "frame_scheduler.h"
+
+namespace FrameScheduler
+{
+	//--------------------------------------------------------
+	// clock
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the time of the steady clock
+	/// </summary>
+	int64_t SteadyClock::GetNanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/// <summary>
+	/// sleep the thread, the granularity is up to the os (1 ms with timeBeginPeriod(1))
+	/// </summary>
+	void SteadyClock::Sleep(int64_t nanoseconds)
+	{
+		std::this_thread::sleep_for(std::chrono::nanoseconds(nanoseconds));
+	}
+
+	/// <summary>
+	/// give the core to another thread for a moment
+	/// </summary>
+	void SteadyClock::Spin()
+	{
+		std::this_thread::yield();
+	}
+
+	/// <summary>
+	/// constructor for manual clock
+	/// </summary>
+	ManualClock::ManualClock(_In_ int64_t oversleepNs, _In_ int64_t spinNs)
+	{
+		_now         = 0;
+		_oversleepNs = oversleepNs;
+		_spinNs      = spinNs;
+	}
+
+	/// <summary>
+	/// get the manual time
+	/// </summary>
+	int64_t ManualClock::GetNanoseconds()
+	{
+		return _now;
+	}
+
+	/// <summary>
+	/// advance by the sleep and the oversleep
+	/// </summary>
+	void ManualClock::Sleep(int64_t nanoseconds)
+	{
+		_now += nanoseconds + _oversleepNs;
+	}
+
+	/// <summary>
+	/// advance by one spin
+	/// </summary>
+	void ManualClock::Spin()
+	{
+		_now += _spinNs;
+	}
+
+	/// <summary>
+	/// advance the time, like the work of a frame
+	/// </summary>
+	void ManualClock::Advance(_In_ int64_t nanoseconds)
+	{
+		_now += nanoseconds;
+	}
+
+	//--------------------------------------------------------
+	// scheduler
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for frame scheduler
+	/// </summary>
+	Scheduler::Scheduler()
+	{
+		_clock    = nullptr;
+		_settings = GetDefaultSettings();
+
+		_nextFrameNs   = 0;
+		_lastFrameNs   = 0;
+		_accumulatorNs = 0;
+		_interpolation = 0.0f;
+		_isFirstFrame  = true;
+
+		_windowBeginNs     = 0;
+		_sumFrameMs        = 0.0;
+		_sumSquaredFrameMs = 0.0;
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for frame scheduler
+	/// </summary>
+	void Scheduler::Initialize(_In_ Clock* clock, _In_ const Settings& settings)
+	{
+		_clock    = clock;
+		_settings = settings;
+
+		const int64_t now = _clock->GetNanoseconds();
+		_nextFrameNs   = now;
+		_lastFrameNs   = now;
+		_accumulatorNs = 0;
+		_interpolation = 0.0f;
+		_isFirstFrame  = true;
+
+		_windowBeginNs     = now;
+		_sumFrameMs        = 0.0;
+		_sumSquaredFrameMs = 0.0;
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// hybrid wait: the os sleep is coarse, so it stops short of the deadline and the rest is spun
+	/// </summary>
+	void Scheduler::WaitForNextFrame()
+	{
+		int64_t remaining = _nextFrameNs - _clock->GetNanoseconds();
+		if (remaining > _settings.SpinThresholdNs)
+		{
+			_clock->Sleep(remaining - _settings.SpinThresholdNs);
+		}
+
+		while (_clock->GetNanoseconds() < _nextFrameNs)
+		{
+			_clock->Spin();
+		}
+	}
+
+	/// <summary>
+	/// start a frame
+	/// </summary>
+	uint32_t Scheduler::BeginFrame()
+	{
+		const int64_t now = _clock->GetNanoseconds();
+		const int64_t interval = now - _lastFrameNs;
+		_lastFrameNs = now;
+
+		if (_isFirstFrame)
+		{
+			// the first frame draws the initial state
+			_isFirstFrame = false;
+		}
+		else
+		{
+			_accumulatorNs += interval;
+			AddFrameInterval(now, interval);
+		}
+
+		// the deadlines stay on the grid of the period, unless the frame is a whole period late
+		_nextFrameNs += _settings.FramePeriodNs;
+		if (_nextFrameNs <= now) _nextFrameNs = now + _settings.FramePeriodNs;
+
+		// fixed steps
+		uint32_t steps = static_cast<uint32_t>(_accumulatorNs / _settings.FixedStepNs);
+		_accumulatorNs -= static_cast<int64_t>(steps) * _settings.FixedStepNs;
+		if (steps > _settings.MaxStepsPerFrame)
+		{
+			_frameStats.DroppedSteps += steps - _settings.MaxStepsPerFrame;
+			steps = _settings.MaxStepsPerFrame;
+		}
+		_frameStats.Steps += steps;
+
+		// how far the drawn frame is between the last two steps
+		_interpolation = static_cast<float>(static_cast<double>(_accumulatorNs) / static_cast<double>(_settings.FixedStepNs));
+
+		return steps;
+	}
+
+	/// <summary>
+	/// add an interval to the statistics, and publish them every second
+	/// </summary>
+	void Scheduler::AddFrameInterval(_In_ int64_t nowNs, _In_ int64_t intervalNs)
+	{
+		const double frame_ms  = static_cast<double>(intervalNs) * 1e-6;
+		const double target_ms = static_cast<double>(_settings.FramePeriodNs) * 1e-6;
+
+		if (_frameStats.Frames == 0)
+		{
+			_frameStats.MinFrameMs = frame_ms;
+			_frameStats.MaxFrameMs = frame_ms;
+		}
+		_frameStats.Frames++;
+		_frameStats.MinFrameMs     = std::min(_frameStats.MinFrameMs, frame_ms);
+		_frameStats.MaxFrameMs     = std::max(_frameStats.MaxFrameMs, frame_ms);
+		_frameStats.MaxDeviationMs = std::max(_frameStats.MaxDeviationMs, std::fabs(frame_ms - target_ms));
+
+		_sumFrameMs        += frame_ms;
+		_sumSquaredFrameMs += frame_ms * frame_ms;
+
+		if (nowNs - _windowBeginNs < NANOSECONDS_PER_SECOND)
+			return;
+
+		const double average = _sumFrameMs / _frameStats.Frames;
+		_frameStats.AverageFrameMs = average;
+		_frameStats.JitterMs = std::sqrt(std::max(_sumSquaredFrameMs / _frameStats.Frames - average * average, 0.0));
+
+		_lastFrameStats = _frameStats;
+
+		_windowBeginNs     = nowNs;
+		_sumFrameMs        = 0.0;
+		_sumSquaredFrameMs = 0.0;
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// get the position of the drawn frame between the last two steps [0, 1)
+	/// </summary>
+	float Scheduler::GetInterpolation() const
+	{
+		return _interpolation;
+	}
+
+	/// <summary>
+	/// get the length of a simulation step
+	/// </summary>
+	int64_t Scheduler::GetFixedStepNs() const
+	{
+		return _settings.FixedStepNs;
+	}
+
+	/// <summary>
+	/// get statistics of the last second
+	/// </summary>
+	const FrameStats& Scheduler::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the default settings
+	/// </summary>
+	Settings GetDefaultSettings()
+	{
+		Settings settings;
+		settings.FramePeriodNs    = DEFAULT_FRAME_PERIOD_NS;
+		settings.FixedStepNs      = DEFAULT_FIXED_STEP_NS;
+		settings.SpinThresholdNs  = DEFAULT_SPIN_THRESHOLD_NS;
+		settings.MaxStepsPerFrame = DEFAULT_MAX_STEPS_PER_FRAME;
+
+		return settings;
+	}
+}
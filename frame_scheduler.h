@@ -0,0 +1,159 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "portable_sal.h"
+
+namespace FrameScheduler
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	constexpr int64_t NANOSECONDS_PER_SECOND = 1000000000;
+
+	// rendering, and the fixed simulation step
+	constexpr int64_t DEFAULT_FRAME_PERIOD_NS = NANOSECONDS_PER_SECOND / 120;
+	constexpr int64_t DEFAULT_FIXED_STEP_NS   = NANOSECONDS_PER_SECOND / 60;
+
+	// the os sleep is only trusted until this close to the deadline, the rest is spun
+	constexpr int64_t DEFAULT_SPIN_THRESHOLD_NS = 2000000;
+
+	// steps beyond this are dropped after a hitch, so the simulation does not spiral
+	constexpr uint32_t DEFAULT_MAX_STEPS_PER_FRAME = 5;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// scheduling settings
+	/// </summary>
+	struct Settings
+	{
+		int64_t FramePeriodNs;
+		int64_t FixedStepNs;
+		int64_t SpinThresholdNs;
+		uint32_t MaxStepsPerFrame;
+	};
+
+	/// <summary>
+	/// statistics of the frame intervals over the last second
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Frames;
+		uint32_t Steps;
+		uint32_t DroppedSteps;
+		double AverageFrameMs;
+		double MinFrameMs;
+		double MaxFrameMs;
+		double JitterMs;         // standard deviation of the interval
+		double MaxDeviationMs;   // largest distance from the target period
+	};
+
+	//--------------------------------------------------------
+	// clock class
+	//--------------------------------------------------------
+	/// <summary>
+	/// source of time, replaced by a manual clock to run the scheduler deterministically
+	/// </summary>
+	class Clock
+	{
+	public:
+		virtual ~Clock() = default;
+
+		// monotonic time
+		virtual int64_t GetNanoseconds() = 0;
+
+		// coarse wait, may return late
+		virtual void Sleep(int64_t nanoseconds) = 0;
+
+		// one iteration of a busy wait
+		virtual void Spin() = 0;
+	};
+
+	/// <summary>
+	/// std::chrono::steady_clock (QueryPerformanceCounter on windows)
+	/// </summary>
+	class SteadyClock : public Clock
+	{
+	public:
+		int64_t GetNanoseconds() override;
+		void Sleep(int64_t nanoseconds) override;
+		void Spin() override;
+	};
+
+	/// <summary>
+	/// clock which only moves when told, sleeps oversleep by a fixed amount like a coarse os timer
+	/// </summary>
+	class ManualClock : public Clock
+	{
+		int64_t _now;
+		int64_t _oversleepNs;
+		int64_t _spinNs;
+
+	public:
+		ManualClock(_In_ int64_t oversleepNs = 0, _In_ int64_t spinNs = 1000);
+
+		int64_t GetNanoseconds() override;
+		void Sleep(int64_t nanoseconds) override;
+		void Spin() override;
+
+		void Advance(_In_ int64_t nanoseconds);
+	};
+
+	//--------------------------------------------------------
+	// scheduler class
+	//--------------------------------------------------------
+	/// <summary>
+	/// paces frames to a target period, and runs the simulation on a fixed step with interpolation
+	/// </summary>
+	class Scheduler
+	{
+		Clock* _clock;
+		Settings _settings;
+
+		int64_t _nextFrameNs;
+		int64_t _lastFrameNs;
+		int64_t _accumulatorNs;
+		float _interpolation;
+		bool _isFirstFrame;
+
+		// statistics of the current second
+		int64_t _windowBeginNs;
+		double _sumFrameMs;
+		double _sumSquaredFrameMs;
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void AddFrameInterval(_In_ int64_t nowNs, _In_ int64_t intervalNs);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Scheduler();
+
+		void Initialize(_In_ Clock* clock, _In_ const Settings& settings);
+
+		// sleep, then spin until the next frame is due
+		void WaitForNextFrame();
+
+		// starts a frame, and returns the number of fixed steps to simulate before it is drawn
+		uint32_t BeginFrame();
+
+		// getter
+		float GetInterpolation() const;
+		int64_t GetFixedStepNs() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	Settings GetDefaultSettings();
+}
@@ -0,0 +1,86 @@
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "headless_scene.h"
+#include "../application.h"
+#include "../platform_headless.h"
+
+namespace
+{
+	// frames of an unattended run
+	constexpr uint64_t DEFAULT_FRAME_COUNT = 600;
+
+	/// <summary>
+	/// print the options
+	/// </summary>
+	void PrintUsage()
+	{
+		std::printf("usage: headless [--frames N] [--sprites N] [--realtime]\n\n");
+		std::printf("  --frames N   quit after N presented frames (default %llu, 0 runs until killed)\n", static_cast<unsigned long long>(DEFAULT_FRAME_COUNT));
+		std::printf("  --sprites N  number of bouncing sprites (default %u)\n", Headless::DEFAULT_SPRITE_COUNT);
+		std::printf("  --realtime   pace frames with the steady clock instead of simulated time\n");
+	}
+}
+
+/// <summary>
+/// main func of the headless application
+/// runs the whole Initialize/Run/Terminate lifecycle without a window, for profiling and soak tests
+/// </summary>
+int main(int argc, char* argv[])
+{
+	uint64_t frames = DEFAULT_FRAME_COUNT;
+	uint32_t sprites = Headless::DEFAULT_SPRITE_COUNT;
+	bool is_realtime = false;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frames = std::strtoull(argv[++i], nullptr, 10);
+		}
+		else if (std::strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+		{
+			sprites = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (std::strcmp(argv[i], "--realtime") == 0)
+		{
+			is_realtime = true;
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	Platform::HeadlessBackend platform(is_realtime);
+	platform.SetFrameLimit(frames);
+
+	// exercise the event pump like a user pressing a key halfway
+	platform.PushEvent({ Platform::EventType::KeyDown, Platform::KEY_SPACE }, frames / 2);
+	platform.PushEvent({ Platform::EventType::KeyUp, Platform::KEY_SPACE }, frames / 2 + 1);
+
+	Headless::Scene scene(sprites);
+	const Platform::WindowDesc window_desc = { "Headless", Renderer::SCREEN_RESOLUTION_WIDTH, Renderer::SCREEN_RESOLUTION_HEIGHT, true };
+
+	Application::Manager& app_manager = Application::Manager::Instance();
+	if (app_manager.Initialize(platform, window_desc, scene)) return -1;
+
+	auto begin = std::chrono::steady_clock::now();
+	app_manager.Run();
+	auto end = std::chrono::steady_clock::now();
+
+	const uint64_t drawn_frames = app_manager.GetFrameCount();
+	app_manager.Terminate();
+
+	const double seconds = std::chrono::duration<double>(end - begin).count();
+	std::printf("frames      %llu drawn, %llu presented\n",
+		static_cast<unsigned long long>(drawn_frames), static_cast<unsigned long long>(platform.GetPresentedFrames()));
+	std::printf("wall time   %.3f s (%.1f frames/s)\n", seconds, seconds > 0.0 ? drawn_frames / seconds : 0.0);
+	std::printf("checksum    %016llx\n", static_cast<unsigned long long>(platform.GetLastFrameChecksum()));
+
+	return platform.GetPresentedFrames() == drawn_frames ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+
+#include <cstdio>
+#include <random>
+
+#include "headless_scene.h"
+#include "../frame_scheduler.h"
+#include "../platform.h"
+#include "../profiler.h"
+
+namespace Headless
+{
+	/// <summary>
+	/// constructor for headless scene
+	/// </summary>
+	Scene::Scene(_In_ uint32_t spriteCount)
+	{
+		_spriteCount = spriteCount;
+	}
+
+	/// <summary>
+	/// initialization process for headless scene
+	/// the sprites are placed with a fixed seed, so every run draws the same frames
+	/// </summary>
+	int Scene::Initialize()
+	{
+		SoftwareRenderer::Manager& software = SoftwareRenderer::Manager::Instance();
+		if (software.Initialize())
+			return -1;
+
+		// sprites are drawn in submission order without depth
+		software.SetDepthEnableState(Renderer::DepthEnebleMode::Disable);
+		software.SetCullingMode(Renderer::CullMode::None);
+		_batcher.Initialize(&software);
+
+		// checkerboards in a few colors
+		_textures.assign(TEXTURE_COUNT, SoftwareRenderer::Texture());
+		for (uint32_t t = 0; t < TEXTURE_COUNT; ++t)
+		{
+			SoftwareRenderer::Texture& texture = _textures[t];
+			texture.Width  = TEXTURE_SIZE;
+			texture.Height = TEXTURE_SIZE;
+			texture.Texels.resize(TEXTURE_SIZE * TEXTURE_SIZE);
+
+			const uint32_t color = 0xff000000u | (0x40u << (8 * (t % 3))) | 0x00202020u;
+			for (uint32_t y = 0; y < TEXTURE_SIZE; ++y)
+			{
+				for (uint32_t x = 0; x < TEXTURE_SIZE; ++x)
+				{
+					texture.Texels[y * TEXTURE_SIZE + x] = ((x / 8 + y / 8) % 2) ? color : 0xffffffffu;
+				}
+			}
+		}
+
+		// sprites
+		_registry.Reserve(_spriteCount);
+		_velocityX.resize(_spriteCount);
+		_velocityY.resize(_spriteCount);
+		_angularVelocity.resize(_spriteCount);
+
+		std::mt19937 random(12345);
+		std::uniform_real_distribution<float> position_x(0.0f, static_cast<float>(Renderer::SCREEN_SIZE_WIDTH));
+		std::uniform_real_distribution<float> position_y(0.0f, static_cast<float>(Renderer::SCREEN_SIZE_HEIGHT));
+		std::uniform_real_distribution<float> velocity(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> scale(16.0f, 64.0f);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		for (uint32_t i = 0; i < _spriteCount; ++i)
+		{
+			SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+			desc.Position[0] = position_x(random);
+			desc.Position[1] = position_y(random);
+
+			_velocityX[i] = velocity(random);
+			_velocityY[i] = velocity(random);
+			_angularVelocity[i] = unit(random) * 3.0f;
+
+			desc.Scale[0] = scale(random);
+			desc.Scale[1] = scale(random);
+			desc.Texture  = i % TEXTURE_COUNT;
+			_registry.Create(desc);
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// termination process for headless scene
+	/// </summary>
+	void Scene::Terminate()
+	{
+		_batcher.Terminate();
+		_registry.Clear();
+		SoftwareRenderer::Manager::Instance().Terminate();
+	}
+
+	/// <summary>
+	/// move the sprites by one fixed step, bouncing off the edges of the screen
+	/// </summary>
+	void Scene::FixedUpdate()
+	{
+		PROFILE_SCOPE("Headless::FixedUpdate");
+
+		const float step = static_cast<float>(FrameScheduler::DEFAULT_FIXED_STEP_NS) / FrameScheduler::NANOSECONDS_PER_SECOND;
+		const float width  = static_cast<float>(Renderer::SCREEN_SIZE_WIDTH);
+		const float height = static_cast<float>(Renderer::SCREEN_SIZE_HEIGHT);
+
+		_registry.SavePreviousState();
+
+		SpriteRegistry::Transforms& transforms = _registry.GetTransforms();
+		for (uint32_t i = 0; i < _spriteCount; ++i)
+		{
+			transforms.PositionX[i] += _velocityX[i] * step;
+			transforms.PositionY[i] += _velocityY[i] * step;
+			transforms.Rotation[i]  += _angularVelocity[i] * step;
+
+			if (transforms.PositionX[i] < 0.0f || transforms.PositionX[i] > width)  _velocityX[i] = -_velocityX[i];
+			if (transforms.PositionY[i] < 0.0f || transforms.PositionY[i] > height) _velocityY[i] = -_velocityY[i];
+		}
+	}
+
+	/// <summary>
+	/// update process for headless scene
+	/// </summary>
+	void Scene::Update()
+	{
+	}
+
+	/// <summary>
+	/// draw the sprites between their last two simulated states, and present the frame
+	/// </summary>
+	void Scene::Draw(_In_ float interpolation)
+	{
+		PROFILE_SCOPE("Headless::Draw");
+
+		SoftwareRenderer::Manager& software = SoftwareRenderer::Manager::Instance();
+		software.ClearViews();
+
+		const uint32_t count = _registry.GetCount();
+		const uint32_t* p_textures = _registry.GetTextures();
+		const Renderer::BlendMode* p_blends = _registry.GetBlends();
+
+		_batcher.Begin();
+		for (uint32_t first = 0; first < count; first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+		{
+			const uint32_t chunk = (count - first < SpriteRegistry::QUAD_CHUNK_SPRITES) ? count - first : SpriteRegistry::QUAD_CHUNK_SPRITES;
+			_registry.GenerateInstances(first, chunk, interpolation, _instances);
+
+			for (uint32_t i = 0; i < chunk; ++i)
+			{
+				SpriteBatch::SpriteInstance* p_instance = _batcher.Allocate(reinterpret_cast<SpriteBatch::TextureId>(&_textures[p_textures[first + i]]), p_blends[first + i]);
+				*p_instance = _instances[i];
+			}
+		}
+		_batcher.End();
+
+		software.FlipFrameBuffer();
+
+		const Platform::Surface surface = { software.GetFrameBuffer(), software.GetWidth(), software.GetHeight() };
+		Platform::Manager::Instance().GetBackend().Present(surface);
+	}
+
+	/// <summary>
+	/// statistics of the previous frame for the debug title
+	/// </summary>
+	void Scene::AppendDebugTitle(_Inout_ char* buffer, _In_ size_t size) const
+	{
+		const SpriteBatch::FrameStats& batch_stats = _batcher.GetLastFrameStats();
+		const SoftwareRenderer::FrameStats& software_stats = SoftwareRenderer::Manager::Instance().GetLastFrameStats();
+
+		std::snprintf(buffer, size, " - batches [ %u ] quads [ %u ] triangles [ %u / %u culled ]",
+			batch_stats.Batches, batch_stats.Quads, software_stats.Triangles, software_stats.CulledTriangles);
+	}
+}
@@ -0,0 +1,53 @@
+
+#pragma once
+
+#include <vector>
+
+#include "../application.h"
+#include "../software_renderer.h"
+#include "../sprite_batch_core.h"
+#include "../sprite_registry.h"
+
+namespace Headless
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	constexpr uint32_t DEFAULT_SPRITE_COUNT = 100;
+	constexpr uint32_t TEXTURE_COUNT = 4;
+	constexpr uint32_t TEXTURE_SIZE  = 32;
+
+	//--------------------------------------------------------
+	// scene class
+	//--------------------------------------------------------
+	/// <summary>
+	/// bouncing sprites drawn by the software renderer, presented to the platform surface
+	/// </summary>
+	class Scene : public Application::Graphics
+	{
+		uint32_t _spriteCount;
+
+		// the texture component is an index of _textures
+		SpriteRegistry::Registry _registry;
+
+		// velocities in the dense order of the registry (sprites are never destroyed)
+		std::vector<float> _velocityX, _velocityY, _angularVelocity;
+
+		// instances of one chunk
+		SpriteBatch::SpriteInstance _instances[SpriteRegistry::QUAD_CHUNK_SPRITES];
+
+		std::vector<SoftwareRenderer::Texture> _textures;
+		SpriteBatch::Batcher _batcher;
+
+	public:
+		explicit Scene(_In_ uint32_t spriteCount = DEFAULT_SPRITE_COUNT);
+
+		int Initialize() override;
+		void Terminate() override;
+		void FixedUpdate() override;
+		void Update() override;
+		void Draw(_In_ float interpolation) override;
+
+		void AppendDebugTitle(_Inout_ char* buffer, _In_ size_t size) const override;
+	};
+}
@@ -1,6 +1,9 @@
 
 #include "main.h"
 #include "application.h"
+#include "directx11_wrapper.h"
+#include "platform_win32.h"
+#include "window.h"
 
 using namespace Application;
 
@@ -11,7 +14,10 @@ int APIENTRY WinMain(_In_ HINSTANCE, _In_opt_ HINSTANCE, _In_ LPSTR, _In_ int)
 {
 	Manager& app_manager = Manager::Instance();
 
-	if (app_manager.Initialize()) return -1;
+	Platform::Win32Backend platform;
+	const Platform::WindowDesc window_desc = { Window::WINDOW_NAME, Window::WINDOW_SIZE_WIDTH, Window::WINDOW_SIZE_HEIGHT, true };
+
+	if (app_manager.Initialize(platform, window_desc, DirectXWrapper::Manager::Instance())) return -1;
 	app_manager.Run();
 	app_manager.Terminate();
 
@@ -0,0 +1,207 @@
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "mapped_file.h"
+
+namespace MappedFile
+{
+	/// <summary>
+	/// constructor for mapped file
+	/// </summary>
+	View::View()
+	{
+		_data = nullptr;
+		_size = 0;
+
+#ifdef _WIN32
+		_file    = INVALID_HANDLE_VALUE;
+		_mapping = nullptr;
+#else
+		_file = -1;
+#endif
+	}
+
+	/// <summary>
+	/// destructor for mapped file
+	/// </summary>
+	View::~View()
+	{
+		Close();
+	}
+
+#ifdef _WIN32
+	/// <summary>
+	/// map a file
+	/// </summary>
+	int View::Open(_In_ const char* path)
+	{
+		Close();
+
+		_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			return -1;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return -1;
+		}
+
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mapping)
+		{
+			Close();
+			return -1;
+		}
+
+		_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!_data)
+		{
+			Close();
+			return -1;
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+
+		return 0;
+	}
+
+	/// <summary>
+	/// map a file with a wide path
+	/// </summary>
+	int View::Open(_In_ const wchar_t* path)
+	{
+		Close();
+
+		_file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE)
+			return -1;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+		{
+			Close();
+			return -1;
+		}
+
+		_mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mapping)
+		{
+			Close();
+			return -1;
+		}
+
+		_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!_data)
+		{
+			Close();
+			return -1;
+		}
+		_size = static_cast<size_t>(size.QuadPart);
+
+		return 0;
+	}
+
+	/// <summary>
+	/// unmap the file
+	/// </summary>
+	void View::Close()
+	{
+		if (_data) UnmapViewOfFile(_data);
+		if (_mapping) CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+
+		_data    = nullptr;
+		_size    = 0;
+		_mapping = nullptr;
+		_file    = INVALID_HANDLE_VALUE;
+	}
+#else
+	/// <summary>
+	/// map a file
+	/// </summary>
+	int View::Open(_In_ const char* path)
+	{
+		Close();
+
+		_file = open(path, O_RDONLY);
+		if (_file < 0)
+			return -1;
+
+		struct stat status;
+		if (fstat(_file, &status) != 0 || status.st_size == 0)
+		{
+			Close();
+			return -1;
+		}
+
+		void* p_data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+		if (p_data == MAP_FAILED)
+		{
+			Close();
+			return -1;
+		}
+		_data = static_cast<const uint8_t*>(p_data);
+		_size = static_cast<size_t>(status.st_size);
+
+		return 0;
+	}
+
+	/// <summary>
+	/// unmap the file
+	/// </summary>
+	void View::Close()
+	{
+		if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+		if (_file >= 0) close(_file);
+
+		_data = nullptr;
+		_size = 0;
+		_file = -1;
+	}
+#endif
+
+	/// <summary>
+	/// read one byte of every page
+	/// </summary>
+	void View::Prefetch() const
+	{
+		volatile uint8_t sink = 0;
+		for (size_t offset = 0; offset < _size; offset += PAGE_SIZE)
+		{
+			sink = sink + _data[offset];
+		}
+		(void)sink;
+	}
+
+	/// <summary>
+	/// get the mapped bytes
+	/// </summary>
+	const uint8_t* View::GetData() const
+	{
+		return _data;
+	}
+
+	/// <summary>
+	/// get the size of the file
+	/// </summary>
+	size_t View::GetSize() const
+	{
+		return _size;
+	}
+
+	/// <summary>
+	/// check whether a file is mapped
+	/// </summary>
+	bool View::IsOpen() const
+	{
+		return _data != nullptr;
+	}
+}
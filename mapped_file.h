@@ -0,0 +1,60 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "portable_sal.h"
+
+namespace MappedFile
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// stride of Prefetch, the smallest page size of the supported platforms
+	constexpr size_t PAGE_SIZE = 4096;
+
+	//--------------------------------------------------------
+	// view class
+	//--------------------------------------------------------
+	/// <summary>
+	/// read-only view of a whole file
+	/// </summary>
+	class View
+	{
+		const uint8_t* _data;
+		size_t _size;
+
+#ifdef _WIN32
+		void* _file;
+		void* _mapping;
+#else
+		int _file;
+#endif
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		View();
+		~View();
+
+		View(const View&) = delete;
+		View& operator=(const View&) = delete;
+
+		// returns 0 on success, -1 if the file cannot be opened or mapped
+		int Open(_In_ const char* path);
+#ifdef _WIN32
+		int Open(_In_ const wchar_t* path);
+#endif
+		void Close();
+
+		// touch every page so later reads do not wait for the disk
+		void Prefetch() const;
+
+		// getter
+		const uint8_t* GetData() const;
+		size_t GetSize() const;
+		bool IsOpen() const;
+	};
+}
@@ -1,4 +1,6 @@
 
+#include <cstring>
+
 #include "directx11_wrapper.h"
 #include "material.h"
 #include "renderer.h"
@@ -15,7 +17,8 @@ namespace Material
 		_specular = {};
 		_emission = {};
 		_specularIntensity = 0.0f;
-		_textureSamplingDisable = 0;
+		_alphaThreshold = 0.0f;
+		_features = ShaderPermutation::DEFAULT_KEY;
 	}
 
 	/// <summary>
@@ -60,18 +63,70 @@ namespace Material
 
 	/// <summary>
 	/// set the flag for texture sampling disable
+	/// (selects a variant without the texture instead of a branch in the shader)
 	/// </summary>
 	void Manager::SetTextureSamplingDisable(_In_ const int& flag)
 	{
-		_textureSamplingDisable = flag;
+		if (flag) _features &= ~ShaderPermutation::FEATURE_TEXTURED;
+		else      _features |=  ShaderPermutation::FEATURE_TEXTURED;
+	}
+
+	/// <summary>
+	/// discard the pixels with an alpha below the threshold, 0 disables the alpha test
+	/// </summary>
+	void Manager::SetAlphaTest(_In_ const float& threshold)
+	{
+		_alphaThreshold = threshold;
+
+		if (threshold > 0.0f) _features |=  ShaderPermutation::FEATURE_ALPHA_TEST;
+		else                  _features &= ~ShaderPermutation::FEATURE_ALPHA_TEST;
+	}
+
+	/// <summary>
+	/// set the features of the pixel shader
+	/// </summary>
+	void Manager::SetFeatures(_In_ const ShaderPermutation::Key& features)
+	{
+		_features = features & ShaderPermutation::FEATURE_ALL;
+	}
+
+	/// <summary>
+	/// register the material to the material table of the renderer
+	/// </summary>
+	MaterialTable::Index Manager::Register() const
+	{
+		return Renderer::Manager::Instance().GetMaterialTable().Register(GetConstants(), _features);
+	}
+
+	/// <summary>
+	/// write the material into a registered slot
+	/// </summary>
+	int Manager::Update(_In_ MaterialTable::Index index) const
+	{
+		return Renderer::Manager::Instance().GetMaterialTable().Update(index, GetConstants(), _features);
+	}
+
+	/// <summary>
+	/// get the constants in the layout of the material table
+	/// </summary>
+	MaterialTable::Constants Manager::GetConstants() const
+	{
+		MaterialTable::Constants constants = {};
+		std::memcpy(constants.Ambient,  &_ambient,  sizeof(constants.Ambient));
+		std::memcpy(constants.Diffuse,  &_diffuse,  sizeof(constants.Diffuse));
+		std::memcpy(constants.Specular, &_specular, sizeof(constants.Specular));
+		std::memcpy(constants.Emission, &_emission, sizeof(constants.Emission));
+		constants.SpecularIntensity = _specularIntensity;
+		constants.AlphaThreshold    = _alphaThreshold;
+
+		return constants;
 	}
 
 	/// <summary>
-	/// set material to the constant buffer
+	/// get the features of the pixel shader
 	/// </summary>
-	void Manager::SetConstantBuffer()
+	ShaderPermutation::Key Manager::GetFeatures() const
 	{
-		Renderer::Manager& renderer = Renderer::Manager::Instance();
-		renderer.GetDeviceContext().UpdateSubresource(&renderer.GetConstantBufferMaterial(), 0, nullptr, this, 0, 0);
+		return _features;
 	}
 }
@@ -1,8 +1,18 @@
 
 #pragma once
 
+#include "material_table.h"
+#include "shader_permutation.h"
+
 namespace Material
 {
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	/// <summary>
+	/// constants of the pixel shader, and the features which select its variant
+	/// a material is registered once to the material table of the renderer, and drawn by its index
+	/// </summary>
 	class Manager
 	{
 		// color
@@ -14,11 +24,11 @@ namespace Material
 		// intensity
 		float _specularIntensity;
 
-		// flags
-		int _textureSamplingDisable;
+		// the alpha test variants discard below it
+		float _alphaThreshold;
 
-		// this padding is for alignment according to HLSL packing rules
-		float _padding[2] = {};
+		// selects the variant of the pixel shader
+		ShaderPermutation::Key _features;
 
 	public:
 		Manager();
@@ -31,7 +41,18 @@ namespace Material
 
 		void SetSpecularIntensity(_In_ const float& intensity);
 		void SetTextureSamplingDisable(_In_ const int& flag);
+		void SetAlphaTest(_In_ const float& threshold);
+		void SetFeatures(_In_ const ShaderPermutation::Key& features);
+
+		// an equal material already in the table shares its slot, release the index when it is no longer drawn
+		MaterialTable::Index Register() const;
+
+		// write the material into a slot, only that slot is uploaded in the next frame
+		// returns 0 on success, -1 if the slot is not registered
+		int Update(_In_ MaterialTable::Index index) const;
 
-		void SetConstantBuffer();
+		// getter
+		MaterialTable::Constants GetConstants() const;
+		ShaderPermutation::Key GetFeatures() const;
 	};
 }
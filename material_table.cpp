@@ -0,0 +1,345 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include "material_table.h"
+
+namespace MaterialTable
+{
+	/// <summary>
+	/// FNV-1a of the constants and the features
+	/// (the bytes are compared, so a material differing in -0.0 or the padding is another material)
+	/// </summary>
+	uint64_t ComputeHash(_In_ const Constants& constants, _In_ ShaderPermutation::Key features)
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		const uint8_t* p_bytes = reinterpret_cast<const uint8_t*>(&constants);
+		for (size_t i = 0; i < sizeof(Constants); ++i) hash = (hash ^ p_bytes[i]) * 0x100000001b3ull;
+
+		p_bytes = reinterpret_cast<const uint8_t*>(&features);
+		for (size_t i = 0; i < sizeof(features); ++i) hash = (hash ^ p_bytes[i]) * 0x100000001b3ull;
+
+		return hash;
+	}
+
+	/// <summary>
+	/// constructor for material table
+	/// </summary>
+	Table::Table()
+	{
+		_backend  = nullptr;
+		_capacity = 0;
+
+		_featuresRevision = 0;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for material table
+	/// the default material is the first slot, and is uploaded by the first flush
+	/// </summary>
+	void Table::Initialize(_In_ Backend* backend, _In_ uint32_t capacity)
+	{
+		Terminate();
+
+		_backend  = backend;
+		_capacity = capacity;
+
+		_constants.reserve(capacity);
+		_features.reserve(capacity);
+		_referenceCounts.reserve(capacity);
+		_hashes.reserve(capacity);
+		_isDirty.reserve(capacity);
+		_featuresRevisions.reserve(capacity);
+		_dirtyIndices.reserve(capacity);
+
+		Register(GetDefaultConstants(), ShaderPermutation::DEFAULT_KEY);
+	}
+
+	/// <summary>
+	/// termination process for material table
+	/// </summary>
+	void Table::Terminate()
+	{
+		_constants.clear();
+		_features.clear();
+		_referenceCounts.clear();
+		_hashes.clear();
+		_isDirty.clear();
+		_featuresRevisions.clear();
+		_featuresRevision = 0;
+		_freeIndices.clear();
+		_lookup.clear();
+		_dirtyIndices.clear();
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+
+		_backend  = nullptr;
+		_capacity = 0;
+	}
+
+	/// <summary>
+	/// find a live slot with the same contents, INVALID_INDEX if there is none
+	/// </summary>
+	Index Table::Find(_In_ uint64_t hash, _In_ const Constants& constants, _In_ ShaderPermutation::Key features) const
+	{
+		auto range = _lookup.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			const Index index = it->second;
+			if (_features[index] == features && std::memcmp(&_constants[index], &constants, sizeof(Constants)) == 0)
+				return index;
+		}
+
+		return INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// remove a slot from the lookup of its contents
+	/// </summary>
+	void Table::Unlink(_In_ Index index)
+	{
+		auto range = _lookup.equal_range(_hashes[index]);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (it->second == index)
+			{
+				_lookup.erase(it);
+				return;
+			}
+		}
+	}
+
+	/// <summary>
+	/// queue a slot for the next flush
+	/// </summary>
+	void Table::MarkDirty(_In_ Index index)
+	{
+		if (_isDirty[index]) return;
+
+		_isDirty[index] = 1;
+		_dirtyIndices.push_back(index);
+	}
+
+	/// <summary>
+	/// register a material, sharing the slot of an equal one
+	/// </summary>
+	Index Table::Register(_In_ const Constants& constants, _In_ ShaderPermutation::Key features)
+	{
+		features &= ShaderPermutation::FEATURE_ALL;
+		const uint64_t hash = ComputeHash(constants, features);
+
+		_frameStats.Registrations++;
+
+		Index index = Find(hash, constants, features);
+		if (index != INVALID_INDEX)
+		{
+			_referenceCounts[index]++;
+			_frameStats.Deduplicated++;
+			return index;
+		}
+
+		if (!_freeIndices.empty())
+		{
+			index = _freeIndices.back();
+			_freeIndices.pop_back();
+		}
+		else
+		{
+			if (_constants.size() >= _capacity)
+				return INVALID_INDEX;
+
+			index = static_cast<Index>(_constants.size());
+			_constants.emplace_back();
+			_features.push_back(0);
+			_referenceCounts.push_back(0);
+			_hashes.push_back(0);
+			_isDirty.push_back(0);
+			_featuresRevisions.push_back(0);
+		}
+
+		_constants[index]       = constants;
+		_features[index]        = features;
+		_referenceCounts[index] = 1;
+		_hashes[index]          = hash;
+		_lookup.emplace(hash, index);
+		MarkDirty(index);
+
+		return index;
+	}
+
+	/// <summary>
+	/// release a registration, the slot is freed with the last one
+	/// the slot is not uploaded again until it is reused
+	/// </summary>
+	void Table::Release(_In_ Index index)
+	{
+		if (!IsAlive(index) || index == DEFAULT_INDEX) return;
+
+		if (--_referenceCounts[index] > 0) return;
+
+		Unlink(index);
+		_freeIndices.push_back(index);
+	}
+
+	/// <summary>
+	/// edit the material of a registration, only the written slot is uploaded by the next flush
+	/// the default slot is used by every draw without a material, so it is always copied
+	/// </summary>
+	int Table::Update(_Inout_ Index* p_index, _In_ const Constants& constants, _In_ ShaderPermutation::Key features)
+	{
+		const Index index = *p_index;
+		if (!IsAlive(index))
+			return -1;
+
+		features &= ShaderPermutation::FEATURE_ALL;
+		if (_features[index] == features && std::memcmp(&_constants[index], &constants, sizeof(Constants)) == 0)
+			return 0;
+
+		// copy on write, the edited material may also be an equal one already registered
+		if (_referenceCounts[index] > 1 || index == DEFAULT_INDEX)
+		{
+			const Index copy = Register(constants, features);
+			if (copy == INVALID_INDEX)
+				return -2;
+
+			Release(index);
+			*p_index = copy;
+			return 0;
+		}
+
+		// the geometry baked with the old variant is built again
+		if (_features[index] != features) _featuresRevisions[index] = ++_featuresRevision;
+
+		// the slot is found by its new contents from now on
+		Unlink(index);
+		_constants[index] = constants;
+		_features[index]  = features;
+		_hashes[index]    = ComputeHash(constants, features);
+		_lookup.emplace(_hashes[index], index);
+		MarkDirty(index);
+
+		return 0;
+	}
+
+	/// <summary>
+	/// upload the dirty slots, neighbouring slots in one call, and start the statistics of the next frame
+	/// </summary>
+	void Table::Flush()
+	{
+		if (!_dirtyIndices.empty())
+		{
+			std::sort(_dirtyIndices.begin(), _dirtyIndices.end());
+
+			size_t first = 0;
+			while (first < _dirtyIndices.size())
+			{
+				size_t last = first + 1;
+				while (last < _dirtyIndices.size() && _dirtyIndices[last] == _dirtyIndices[last - 1] + 1) ++last;
+
+				const Index first_index = _dirtyIndices[first];
+				const uint32_t count = static_cast<uint32_t>(last - first);
+				if (_backend) _backend->UploadMaterials(&_constants[first_index], first_index, count);
+
+				_frameStats.UploadCalls++;
+				_frameStats.UploadedSlots += count;
+				_frameStats.UploadBytes   += static_cast<uint64_t>(count) * sizeof(Constants);
+
+				first = last;
+			}
+
+			for (Index index : _dirtyIndices) _isDirty[index] = 0;
+			_dirtyIndices.clear();
+		}
+
+		_lastFrameStats = _frameStats;
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// check whether a slot holds a registered material
+	/// </summary>
+	bool Table::IsAlive(_In_ Index index) const
+	{
+		return index < _referenceCounts.size() && _referenceCounts[index] > 0;
+	}
+
+	/// <summary>
+	/// get the constants of the default material (white, without specular and emission)
+	/// </summary>
+	Constants Table::GetDefaultConstants()
+	{
+		Constants constants = {};
+		for (int i = 0; i < 4; ++i) constants.Diffuse[i] = 1.0f;
+
+		return constants;
+	}
+
+	/// <summary>
+	/// get the constants of a slot, the default material if it is out of the table
+	/// </summary>
+	const Constants& Table::GetConstants(_In_ Index index) const
+	{
+		return _constants[index < _constants.size() ? index : DEFAULT_INDEX];
+	}
+
+	/// <summary>
+	/// get the variant of the pixel shader of a slot, the default one if it is out of the table
+	/// </summary>
+	ShaderPermutation::Key Table::GetFeatures(_In_ Index index) const
+	{
+		return index < _features.size() ? _features[index] : ShaderPermutation::DEFAULT_KEY;
+	}
+
+	/// <summary>
+	/// get the revision of the last variant edited in place, 0 before any
+	/// </summary>
+	uint32_t Table::GetFeaturesRevision() const
+	{
+		return _featuresRevision;
+	}
+
+	/// <summary>
+	/// get the revision the variant of a slot was last edited in place at, 0 if it never was
+	/// </summary>
+	uint32_t Table::GetFeaturesRevision(_In_ Index index) const
+	{
+		return index < _featuresRevisions.size() ? _featuresRevisions[index] : 0;
+	}
+
+	/// <summary>
+	/// get the number of live slots
+	/// </summary>
+	uint32_t Table::GetCount() const
+	{
+		return static_cast<uint32_t>(_constants.size() - _freeIndices.size());
+	}
+
+	/// <summary>
+	/// get the number of slots of the gpu table
+	/// </summary>
+	uint32_t Table::GetCapacity() const
+	{
+		return _capacity;
+	}
+
+	/// <summary>
+	/// get the statistics since the last flush
+	/// </summary>
+	const FrameStats& Table::GetFrameStats() const
+	{
+		return _frameStats;
+	}
+
+	/// <summary>
+	/// get the statistics of the last flush
+	/// </summary>
+	const FrameStats& Table::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
@@ -0,0 +1,163 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "portable_sal.h"
+#include "shader_permutation.h"
+
+namespace MaterialTable
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// slot of a material in the table, carried by every instance instead of the constants
+	using Index = uint32_t;
+	constexpr Index INVALID_INDEX = 0xffffffff;
+
+	// white, with the default variant, registered by Initialize and never released
+	constexpr Index DEFAULT_INDEX = 0;
+
+	// slots of the gpu table, it is never resized
+	constexpr uint32_t DEFAULT_CAPACITY = 1024;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// constants of one material (same layout as Material in shader_header.hlsli)
+	/// </summary>
+	struct Constants
+	{
+		float Ambient[4];
+		float Diffuse[4];
+		float Specular[4];
+		float Emission[4];
+
+		float SpecularIntensity;
+		float AlphaThreshold;  // the alpha test variants discard below it
+
+		float Padding[2];
+	};
+
+	static_assert(sizeof(Constants) == 80, "the stride of the structured buffer must match the shader");
+
+	/// <summary>
+	/// statistics between two flushes
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Registrations;
+		uint32_t Deduplicated;   // registrations which found an equal material
+		uint32_t UploadCalls;    // contiguous dirty slots are uploaded together
+		uint32_t UploadedSlots;
+		uint64_t UploadBytes;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	/// <summary>
+	/// owner of the gpu table
+	/// </summary>
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		// write the slots [first, first + count), the rest of the table is left as it is
+		virtual void UploadMaterials(_In_reads_(count) const Constants* p_constants, _In_ Index first, _In_ uint32_t count) = 0;
+	};
+
+	//--------------------------------------------------------
+	// table class
+	//--------------------------------------------------------
+	/// <summary>
+	/// materials registered once and kept resident on the gpu, deduplicated by the hash of their contents
+	/// a draw only carries the index of its material, so a frame without edits uploads nothing
+	/// an edit marks its slot dirty, and the next flush uploads only the dirty slots
+	/// a slot shared by several registrations is copied on an edit, so the other registrations keep their material
+	/// </summary>
+	class Table
+	{
+		Backend* _backend;
+		uint32_t _capacity;
+
+		// per slot, each one is either live or in the free list
+		std::vector<Constants> _constants;
+		std::vector<ShaderPermutation::Key> _features;
+		std::vector<uint32_t> _referenceCounts;
+		std::vector<uint64_t> _hashes;
+		std::vector<uint8_t> _isDirty;
+
+		// per slot, the revision its variant last changed at (baked geometry compares it with its own)
+		std::vector<uint32_t> _featuresRevisions;
+		uint32_t _featuresRevision;
+
+		// released slots, reused first
+		std::vector<Index> _freeIndices;
+
+		// hash of the contents to the live slots with that hash
+		std::unordered_multimap<uint64_t, Index> _lookup;
+
+		// slots written since the last flush
+		std::vector<Index> _dirtyIndices;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		Index Find(_In_ uint64_t hash, _In_ const Constants& constants, _In_ ShaderPermutation::Key features) const;
+		void Unlink(_In_ Index index);
+		void MarkDirty(_In_ Index index);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Table();
+
+		void Initialize(_In_ Backend* backend, _In_ uint32_t capacity = DEFAULT_CAPACITY);
+		void Terminate();
+
+		// the slot of an equal material is shared and counted, otherwise a new slot is written
+		// returns INVALID_INDEX if the table is full
+		Index Register(_In_ const Constants& constants, _In_ ShaderPermutation::Key features);
+
+		// the slot is reused once every registration of it is released
+		void Release(_In_ Index index);
+
+		// edit a material, in place when the slot has one registration, otherwise the registration moves to a copy
+		// the index is replaced by the slot of the edited material
+		// returns 0 on success, -1 if the slot is not live, -2 if the table is full
+		int Update(_Inout_ Index* p_index, _In_ const Constants& constants, _In_ ShaderPermutation::Key features);
+
+		// upload the dirty slots, call once per frame before the first draw
+		void Flush();
+
+		bool IsAlive(_In_ Index index) const;
+
+		static Constants GetDefaultConstants();
+
+		// getter
+		const Constants& GetConstants(_In_ Index index) const;
+		ShaderPermutation::Key GetFeatures(_In_ Index index) const;
+		uint32_t GetFeaturesRevision() const;
+		uint32_t GetFeaturesRevision(_In_ Index index) const;
+		uint32_t GetCount() const;
+		uint32_t GetCapacity() const;
+		const FrameStats& GetFrameStats() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// FNV-1a of the constants and the features
+	uint64_t ComputeHash(_In_ const Constants& constants, _In_ ShaderPermutation::Key features);
+}
@@ -0,0 +1,205 @@
+
+#include "pipeline_state.h"
+
+namespace PipelineState
+{
+	namespace
+	{
+		// FNV-1a 64 bit
+		constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+		constexpr uint64_t FNV_PRIME        = 0x100000001b3ull;
+
+		/// <summary>
+		/// mix a value into the hash byte by byte
+		/// </summary>
+		inline void HashValue(uint64_t& hash, uint64_t value)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				hash ^= (value >> (i * 8)) & 0xff;
+				hash *= FNV_PRIME;
+			}
+		}
+	}
+
+	/// <summary>
+	/// compare descriptions
+	/// </summary>
+	bool Desc::operator==(const Desc& other) const
+	{
+		return Diff(*this, other) == 0;
+	}
+
+	/// <summary>
+	/// compare descriptions
+	/// </summary>
+	bool Desc::operator!=(const Desc& other) const
+	{
+		return Diff(*this, other) != 0;
+	}
+
+	/// <summary>
+	/// hash a description field by field (padding is never read)
+	/// </summary>
+	uint64_t Hash(_In_ const Desc& desc)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+		HashValue(hash, desc.VertexShader);
+		HashValue(hash, desc.PixelShader);
+		HashValue(hash, desc.InputLayout);
+		HashValue(hash, static_cast<uint64_t>(desc.CullMode));
+		HashValue(hash, static_cast<uint64_t>(desc.FillMode));
+		HashValue(hash, static_cast<uint64_t>(desc.BlendMode));
+		HashValue(hash, static_cast<uint64_t>(desc.DepthEnableMode));
+		HashValue(hash, desc.Sampler);
+		return hash;
+	}
+
+	/// <summary>
+	/// sub-states that differ between two descriptions
+	/// </summary>
+	uint32_t Diff(_In_ const Desc& a, _In_ const Desc& b)
+	{
+		uint32_t mask = 0;
+		if (a.VertexShader != b.VertexShader) mask |= SUB_STATE_VERTEX_SHADER;
+		if (a.PixelShader  != b.PixelShader)  mask |= SUB_STATE_PIXEL_SHADER;
+		if (a.InputLayout  != b.InputLayout)  mask |= SUB_STATE_INPUT_LAYOUT;
+		if (a.CullMode != b.CullMode || a.FillMode != b.FillMode) mask |= SUB_STATE_RASTERIZER;
+		if (a.BlendMode       != b.BlendMode)       mask |= SUB_STATE_BLEND;
+		if (a.DepthEnableMode != b.DepthEnableMode) mask |= SUB_STATE_DEPTH_STENCIL;
+		if (a.Sampler != b.Sampler) mask |= SUB_STATE_SAMPLER;
+		return mask;
+	}
+
+	//--------------------------------------------------------
+	// cache
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the handle of a description, creating it the first time
+	/// </summary>
+	Handle Cache::GetOrCreate(_In_ const Desc& desc)
+	{
+		uint64_t hash = Hash(desc);
+
+		// a hash collision is resolved by comparing the descriptions
+		auto range = _lookup.equal_range(hash);
+		for (auto it = range.first; it != range.second; ++it)
+		{
+			if (_descs[it->second] == desc) return it->second;
+		}
+
+		Handle handle = static_cast<Handle>(_descs.size());
+		_descs.push_back(desc);
+		_lookup.emplace(hash, handle);
+
+		return handle;
+	}
+
+	/// <summary>
+	/// get the description of a handle
+	/// </summary>
+	const Desc& Cache::Get(_In_ Handle handle) const
+	{
+		return _descs[handle];
+	}
+
+	/// <summary>
+	/// get the number of cached states
+	/// </summary>
+	size_t Cache::GetCount() const
+	{
+		return _descs.size();
+	}
+
+	/// <summary>
+	/// release all cached states
+	/// </summary>
+	void Cache::Clear()
+	{
+		_descs.clear();
+		_lookup.clear();
+	}
+
+	//--------------------------------------------------------
+	// binder
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for binder
+	/// </summary>
+	Binder::Binder()
+	{
+		_bound = {};
+		_validMask = 0;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// bind a description, and return the sub-states to issue
+	/// </summary>
+	uint32_t Binder::Bind(_In_ const Desc& desc, _In_ uint32_t mask)
+	{
+		mask &= SUB_STATE_ALL;
+		uint32_t issue = (Diff(_bound, desc) | ~_validMask) & mask;
+
+		// take the requested sub-states
+		if (mask & SUB_STATE_VERTEX_SHADER) _bound.VertexShader = desc.VertexShader;
+		if (mask & SUB_STATE_PIXEL_SHADER)  _bound.PixelShader  = desc.PixelShader;
+		if (mask & SUB_STATE_INPUT_LAYOUT)  _bound.InputLayout  = desc.InputLayout;
+		if (mask & SUB_STATE_RASTERIZER)
+		{
+			_bound.CullMode = desc.CullMode;
+			_bound.FillMode = desc.FillMode;
+		}
+		if (mask & SUB_STATE_BLEND)         _bound.BlendMode       = desc.BlendMode;
+		if (mask & SUB_STATE_DEPTH_STENCIL) _bound.DepthEnableMode = desc.DepthEnableMode;
+		if (mask & SUB_STATE_SAMPLER)       _bound.Sampler         = desc.Sampler;
+		_validMask |= mask;
+
+		// statistics
+		uint32_t requested = 0;
+		uint32_t issued    = 0;
+		for (uint32_t bits = mask;  bits; bits &= bits - 1) requested++;
+		for (uint32_t bits = issue; bits; bits &= bits - 1) issued++;
+
+		_frameStats.Binds++;
+		_frameStats.Issued  += issued;
+		_frameStats.Skipped += requested - issued;
+
+		return issue;
+	}
+
+	/// <summary>
+	/// forget what is bound
+	/// </summary>
+	void Binder::Invalidate(_In_ uint32_t mask)
+	{
+		_validMask &= ~mask;
+	}
+
+	/// <summary>
+	/// close statistics of the frame
+	/// </summary>
+	void Binder::EndFrame()
+	{
+		_lastFrameStats = _frameStats;
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// get the bound description
+	/// </summary>
+	const Desc& Binder::GetBound() const
+	{
+		return _bound;
+	}
+
+	/// <summary>
+	/// get statistics of the last frame
+	/// </summary>
+	const FrameStats& Binder::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
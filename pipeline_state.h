@@ -0,0 +1,126 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "portable_sal.h"
+#include "renderer_types.h"
+
+namespace PipelineState
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// opaque identifiers of api objects (the backend decides what they point to)
+	using ObjectId = uintptr_t;
+
+	// handle of a cached pipeline state
+	using Handle = uint32_t;
+	constexpr Handle INVALID_HANDLE = 0xffffffff;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// sub-states bundled in a pipeline state (bit flags)
+	/// </summary>
+	enum SubState : uint32_t
+	{
+		SUB_STATE_VERTEX_SHADER = 1 << 0,
+		SUB_STATE_PIXEL_SHADER  = 1 << 1,
+		SUB_STATE_INPUT_LAYOUT  = 1 << 2,
+		SUB_STATE_RASTERIZER    = 1 << 3,
+		SUB_STATE_BLEND         = 1 << 4,
+		SUB_STATE_DEPTH_STENCIL = 1 << 5,
+		SUB_STATE_SAMPLER       = 1 << 6,
+
+		SUB_STATE_COUNT = 7,
+		SUB_STATE_ALL   = (1 << SUB_STATE_COUNT) - 1
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// description of a pipeline state
+	/// </summary>
+	struct Desc
+	{
+		ObjectId VertexShader;
+		ObjectId PixelShader;
+		ObjectId InputLayout;
+		Renderer::CullMode CullMode;
+		Renderer::FillMode FillMode;
+		Renderer::BlendMode BlendMode;
+		Renderer::DepthEnebleMode DepthEnableMode;
+		ObjectId Sampler;
+
+		bool operator==(const Desc& other) const;
+		bool operator!=(const Desc& other) const;
+	};
+
+	/// <summary>
+	/// state changes of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Binds;
+		uint32_t Issued;
+		uint32_t Skipped;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	uint64_t Hash(_In_ const Desc& desc);
+
+	// sub-states that differ between two descriptions
+	uint32_t Diff(_In_ const Desc& a, _In_ const Desc& b);
+
+	//--------------------------------------------------------
+	// cache class
+	//--------------------------------------------------------
+	class Cache
+	{
+		// created states never change, so a handle stays valid
+		std::vector<Desc> _descs;
+		std::unordered_multimap<uint64_t, Handle> _lookup;
+
+	public:
+		Handle GetOrCreate(_In_ const Desc& desc);
+		const Desc& Get(_In_ Handle handle) const;
+		size_t GetCount() const;
+		void Clear();
+	};
+
+	//--------------------------------------------------------
+	// binder class
+	//--------------------------------------------------------
+	class Binder
+	{
+		Desc _bound;
+		uint32_t _validMask;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+	public:
+		Binder();
+
+		// returns the sub-states which have to be issued to the api
+		// (only the sub-states in the mask are compared and taken from the description)
+		uint32_t Bind(_In_ const Desc& desc, _In_ uint32_t mask = SUB_STATE_ALL);
+
+		// forget what is bound (e.g. the api state was changed outside)
+		void Invalidate(_In_ uint32_t mask = SUB_STATE_ALL);
+
+		void EndFrame();
+
+		// getter
+		const Desc& GetBound() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
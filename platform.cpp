@@ -0,0 +1,46 @@
+
+#include "platform.h"
+
+namespace Platform
+{
+	/// <summary>
+	/// constructor for platform
+	/// </summary>
+	Manager::Manager()
+	{
+		_backend = nullptr;
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// set the platform the application runs on
+	/// </summary>
+	void Manager::SetBackend(_In_opt_ Backend* backend)
+	{
+		_backend = backend;
+	}
+
+	/// <summary>
+	/// get the platform the application runs on
+	/// </summary>
+	Backend& Manager::GetBackend()
+	{
+		return *_backend;
+	}
+
+	/// <summary>
+	/// check whether a platform is set
+	/// </summary>
+	bool Manager::HasBackend() const
+	{
+		return _backend != nullptr;
+	}
+}
@@ -0,0 +1,115 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "portable_sal.h"
+#include "frame_scheduler.h"
+
+namespace Platform
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// key codes of the events (same values as the windows virtual keys)
+	constexpr uint32_t KEY_ESCAPE = 0x1B;
+	constexpr uint32_t KEY_SPACE  = 0x20;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// enumeration of events delivered to the application
+	/// </summary>
+	enum class EventType
+	{
+		Quit,
+		KeyDown,
+		KeyUp,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// event of the window or the input
+	/// </summary>
+	struct Event
+	{
+		EventType Type;
+		uint32_t Key;
+	};
+
+	/// <summary>
+	/// settings of the main window
+	/// </summary>
+	struct WindowDesc
+	{
+		const char* Title;
+		uint32_t Width;
+		uint32_t Height;
+		bool Windowed;
+	};
+
+	/// <summary>
+	/// frame drawn in system memory, RGBA8 with red in the lowest byte (same as SoftwareRenderer)
+	/// </summary>
+	struct Surface
+	{
+		const uint32_t* Pixels;
+		uint32_t Width;
+		uint32_t Height;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	/// <summary>
+	/// window, event pump, timer and present surface of a platform
+	/// </summary>
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		// window
+		virtual int CreateMainWindow(_In_ const WindowDesc& desc) = 0;
+		virtual void DestroyMainWindow() = 0;
+		virtual void ShowMainWindow() = 0;
+		virtual void SetTitle(_In_ const char* title) = 0;
+
+		// returns false when there are no more pending events
+		virtual bool PollEvent(_Out_ Event* p_event) = 0;
+
+		// time source of the frame scheduler
+		virtual FrameScheduler::Clock& GetClock() = 0;
+
+		// present a frame drawn by the cpu
+		virtual void Present(_In_ const Surface& surface) = 0;
+
+		// HWND on windows, nullptr without a window
+		virtual void* GetNativeWindow() = 0;
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		Backend* _backend;
+
+	public:
+		Manager();
+		static Manager& Instance();
+
+		// setter
+		void SetBackend(_In_opt_ Backend* backend);
+
+		// getter
+		Backend& GetBackend();
+		bool HasBackend() const;
+	};
+}
@@ -0,0 +1,206 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include "platform_headless.h"
+
+namespace Platform
+{
+	/// <summary>
+	/// constructor for headless platform
+	/// </summary>
+	HeadlessBackend::HeadlessBackend(_In_ bool isRealtime)
+	{
+		_isRealtime = isRealtime;
+
+		_nextEvent  = 0;
+		_frameLimit = 0;
+		_isQuitSent = false;
+
+		_isWindowCreated = false;
+
+		_frameWidth      = 0;
+		_frameHeight     = 0;
+		_presentedFrames = 0;
+	}
+
+	/// <summary>
+	/// synthesize an event before a frame
+	/// </summary>
+	void HeadlessBackend::PushEvent(_In_ const Event& event, _In_ uint64_t frame)
+	{
+		ScheduledEvent scheduled = { frame, event };
+
+		// stable, so events of the same frame keep the order they were pushed in
+		auto it = std::upper_bound(_events.begin() + _nextEvent, _events.end(), scheduled,
+			[](const ScheduledEvent& a, const ScheduledEvent& b) { return a.Frame < b.Frame; });
+		_events.insert(it, scheduled);
+	}
+
+	/// <summary>
+	/// synthesize a quit event after this many presented frames
+	/// </summary>
+	void HeadlessBackend::SetFrameLimit(_In_ uint64_t frames)
+	{
+		_frameLimit = frames;
+	}
+
+	/// <summary>
+	/// creates the in-memory surface of the main window
+	/// </summary>
+	int HeadlessBackend::CreateMainWindow(_In_ const WindowDesc& desc)
+	{
+		_title = desc.Title ? desc.Title : "";
+
+		_frameWidth  = desc.Width;
+		_frameHeight = desc.Height;
+		_frame.assign(static_cast<size_t>(_frameWidth) * _frameHeight, 0);
+
+		_presentedFrames = 0;
+		_nextEvent  = 0;
+		_isQuitSent = false;
+		_isWindowCreated = true;
+
+		return 0;
+	}
+
+	/// <summary>
+	/// destroys the main window
+	/// the last frame stays readable
+	/// </summary>
+	void HeadlessBackend::DestroyMainWindow()
+	{
+		_isWindowCreated = false;
+	}
+
+	/// <summary>
+	/// there is nothing to show
+	/// </summary>
+	void HeadlessBackend::ShowMainWindow()
+	{
+	}
+
+	/// <summary>
+	/// keep the title, e.g. for the log of a soak test
+	/// </summary>
+	void HeadlessBackend::SetTitle(_In_ const char* title)
+	{
+		_title = title;
+	}
+
+	/// <summary>
+	/// take the next synthesized event which is due
+	/// </summary>
+	bool HeadlessBackend::PollEvent(_Out_ Event* p_event)
+	{
+		if (_nextEvent < _events.size() && _events[_nextEvent].Frame <= _presentedFrames)
+		{
+			*p_event = _events[_nextEvent++].SyntheticEvent;
+			return true;
+		}
+
+		// the run ends like a closed window
+		if (_frameLimit > 0 && _presentedFrames >= _frameLimit && !_isQuitSent)
+		{
+			*p_event = { EventType::Quit, 0 };
+			_isQuitSent = true;
+			return true;
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// get the clock of the frame scheduler
+	/// </summary>
+	FrameScheduler::Clock& HeadlessBackend::GetClock()
+	{
+		if (_isRealtime) return _steadyClock;
+
+		return _manualClock;
+	}
+
+	/// <summary>
+	/// copy a frame into the surface
+	/// frames of another size are cropped or padded to the window
+	/// </summary>
+	void HeadlessBackend::Present(_In_ const Surface& surface)
+	{
+		if (!_isWindowCreated)
+			return;
+
+		const uint32_t width  = std::min(surface.Width, _frameWidth);
+		const uint32_t height = std::min(surface.Height, _frameHeight);
+
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			std::memcpy(&_frame[static_cast<size_t>(y) * _frameWidth], &surface.Pixels[static_cast<size_t>(y) * surface.Width], width * sizeof(uint32_t));
+		}
+
+		_presentedFrames++;
+	}
+
+	/// <summary>
+	/// there is no native window
+	/// </summary>
+	void* HeadlessBackend::GetNativeWindow()
+	{
+		return nullptr;
+	}
+
+	//--------------------------------------------------------
+	// getter
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the number of presented frames
+	/// </summary>
+	uint64_t HeadlessBackend::GetPresentedFrames() const
+	{
+		return _presentedFrames;
+	}
+
+	/// <summary>
+	/// get the pixels of the last presented frame
+	/// </summary>
+	const std::vector<uint32_t>& HeadlessBackend::GetLastFrame() const
+	{
+		return _frame;
+	}
+
+	/// <summary>
+	/// get the width of the surface
+	/// </summary>
+	uint32_t HeadlessBackend::GetFrameWidth() const
+	{
+		return _frameWidth;
+	}
+
+	/// <summary>
+	/// get the height of the surface
+	/// </summary>
+	uint32_t HeadlessBackend::GetFrameHeight() const
+	{
+		return _frameHeight;
+	}
+
+	/// <summary>
+	/// get the FNV-1a hash of the last presented frame, to compare runs
+	/// </summary>
+	uint64_t HeadlessBackend::GetLastFrameChecksum() const
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t pixel : _frame)
+		{
+			hash = (hash ^ pixel) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// get the last title
+	/// </summary>
+	const std::string& HeadlessBackend::GetTitle() const
+	{
+		return _title;
+	}
+}
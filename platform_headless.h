@@ -0,0 +1,81 @@
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "platform.h"
+
+namespace Platform
+{
+	//--------------------------------------------------------
+	// headless backend class
+	//--------------------------------------------------------
+	/// <summary>
+	/// platform without a window: events are synthesized, and presented frames are kept in memory
+	/// runs on a manual clock by default, so the frame loop does not wait in real time
+	/// </summary>
+	class HeadlessBackend : public Backend
+	{
+		/// <summary>
+		/// event delivered before a frame
+		/// </summary>
+		struct ScheduledEvent
+		{
+			uint64_t Frame;
+			Event SyntheticEvent;
+		};
+
+		// time
+		FrameScheduler::SteadyClock _steadyClock;
+		FrameScheduler::ManualClock _manualClock;
+		bool _isRealtime;
+
+		// events
+		std::vector<ScheduledEvent> _events;
+		size_t _nextEvent;
+		uint64_t _frameLimit;
+		bool _isQuitSent;
+
+		// window
+		bool _isWindowCreated;
+		std::string _title;
+
+		// present surface
+		std::vector<uint32_t> _frame;
+		uint32_t _frameWidth;
+		uint32_t _frameHeight;
+		uint64_t _presentedFrames;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		explicit HeadlessBackend(_In_ bool isRealtime = false);
+
+		// synthesize an event before a frame (events are delivered in the order of their frames)
+		void PushEvent(_In_ const Event& event, _In_ uint64_t frame);
+
+		// synthesize a quit event after this many presented frames (0 never quits)
+		void SetFrameLimit(_In_ uint64_t frames);
+
+		// window
+		int CreateMainWindow(_In_ const WindowDesc& desc) override;
+		void DestroyMainWindow() override;
+		void ShowMainWindow() override;
+		void SetTitle(_In_ const char* title) override;
+
+		bool PollEvent(_Out_ Event* p_event) override;
+		FrameScheduler::Clock& GetClock() override;
+		void Present(_In_ const Surface& surface) override;
+		void* GetNativeWindow() override;
+
+		// getter
+		uint64_t GetPresentedFrames() const;
+		const std::vector<uint32_t>& GetLastFrame() const;
+		uint32_t GetFrameWidth() const;
+		uint32_t GetFrameHeight() const;
+		uint64_t GetLastFrameChecksum() const;
+		const std::string& GetTitle() const;
+	};
+}
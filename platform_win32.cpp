@@ -0,0 +1,144 @@
+
+#include "main.h"
+#include "window.h"
+#include "platform_win32.h"
+
+namespace Platform
+{
+	/// <summary>
+	/// constructor for win32 platform
+	/// </summary>
+	Win32Backend::Win32Backend()
+	{
+	}
+
+	/// <summary>
+	/// creates the main window
+	/// the size and the style are the settings of Window::Manager
+	/// </summary>
+	int Win32Backend::CreateMainWindow(_In_ const WindowDesc& desc)
+	{
+		if (FAILED(Window::Manager::Instance().Initialize()))
+			return -1;
+
+		SetTitle(desc.Title);
+
+		// requests a min resolution for periodic timers
+		timeBeginPeriod(1);
+
+		return 0;
+	}
+
+	/// <summary>
+	/// destroys the main window
+	/// </summary>
+	void Win32Backend::DestroyMainWindow()
+	{
+		// clears a min resolution for periodic timers
+		timeEndPeriod(1);
+
+		Window::Manager::Instance().Terminate();
+	}
+
+	/// <summary>
+	/// show (display) and update the main window
+	/// </summary>
+	void Win32Backend::ShowMainWindow()
+	{
+		HWND hWnd = Window::Manager::Instance().GetWindowHandle();
+
+		ShowWindow(hWnd, SW_SHOW);
+		UpdateWindow(hWnd);
+	}
+
+	/// <summary>
+	/// set the text of the title bar
+	/// </summary>
+	void Win32Backend::SetTitle(_In_ const char* title)
+	{
+		SetWindowTextA(Window::Manager::Instance().GetWindowHandle(), title);
+	}
+
+	/// <summary>
+	/// take the next message of the Windows Message Queue as an event
+	/// messages without an event are dispatched to the Window Procedure and skipped
+	/// </summary>
+	bool Win32Backend::PollEvent(_Out_ Event* p_event)
+	{
+		MSG message;
+		while (PeekMessage(&message, nullptr, 0, 0, PM_REMOVE))
+		{
+			// if "PostQuitMessage(0)" is called in the Window Procedure, the application quits
+			if (message.message == WM_QUIT)
+			{
+				*p_event = { EventType::Quit, 0 };
+				return true;
+			}
+
+			// translate and dispatch of messages
+			TranslateMessage(&message);
+			DispatchMessage(&message);
+
+			if (message.message == WM_KEYDOWN || message.message == WM_KEYUP)
+			{
+				*p_event = { message.message == WM_KEYDOWN ? EventType::KeyDown : EventType::KeyUp, static_cast<uint32_t>(message.wParam) };
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/// <summary>
+	/// get the clock of the frame scheduler
+	/// </summary>
+	FrameScheduler::Clock& Win32Backend::GetClock()
+	{
+		return _clock;
+	}
+
+	/// <summary>
+	/// stretch a frame drawn by the cpu to the client area
+	/// </summary>
+	void Win32Backend::Present(_In_ const Surface& surface)
+	{
+		const size_t pixel_count = static_cast<size_t>(surface.Width) * surface.Height;
+		_presentBuffer.resize(pixel_count);
+
+		// RGBA to BGRA
+		for (size_t i = 0; i < pixel_count; ++i)
+		{
+			const uint32_t pixel = surface.Pixels[i];
+			_presentBuffer[i] = (pixel & 0xff00ff00u) | ((pixel & 0x000000ffu) << 16) | ((pixel & 0x00ff0000u) >> 16);
+		}
+
+		BITMAPINFO bitmap_info;
+		ZeroMemory(&bitmap_info, sizeof(bitmap_info));
+		{
+			bitmap_info.bmiHeader.biSize        = sizeof(BITMAPINFOHEADER);
+			bitmap_info.bmiHeader.biWidth       = static_cast<LONG>(surface.Width);
+			bitmap_info.bmiHeader.biHeight      = -static_cast<LONG>(surface.Height);  // top-down
+			bitmap_info.bmiHeader.biPlanes      = 1;
+			bitmap_info.bmiHeader.biBitCount    = 32;
+			bitmap_info.bmiHeader.biCompression = BI_RGB;
+		}
+
+		HWND hWnd = Window::Manager::Instance().GetWindowHandle();
+
+		RECT client_rect;
+		GetClientRect(hWnd, &client_rect);
+
+		HDC hDC = GetDC(hWnd);
+		StretchDIBits(hDC, 0, 0, client_rect.right, client_rect.bottom, 0, 0, surface.Width, surface.Height,
+			_presentBuffer.data(), &bitmap_info, DIB_RGB_COLORS, SRCCOPY);
+		ReleaseDC(hWnd, hDC);
+	}
+
+	/// <summary>
+	/// get the window handle
+	/// </summary>
+	void* Win32Backend::GetNativeWindow()
+	{
+		return Window::Manager::Instance().GetWindowHandle();
+	}
+}
@@ -0,0 +1,40 @@
+
+#pragma once
+
+#include <vector>
+
+#include "platform.h"
+
+namespace Platform
+{
+	//--------------------------------------------------------
+	// win32 backend class
+	//--------------------------------------------------------
+	/// <summary>
+	/// the Win32 window of Window::Manager, the Windows Message Queue and QueryPerformanceCounter
+	/// </summary>
+	class Win32Backend : public Backend
+	{
+		FrameScheduler::SteadyClock _clock;
+
+		// frames presented by the cpu are converted to BGRA for GDI
+		std::vector<uint32_t> _presentBuffer;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Win32Backend();
+
+		// window
+		int CreateMainWindow(_In_ const WindowDesc& desc) override;
+		void DestroyMainWindow() override;
+		void ShowMainWindow() override;
+		void SetTitle(_In_ const char* title) override;
+
+		bool PollEvent(_Out_ Event* p_event) override;
+		FrameScheduler::Clock& GetClock() override;
+		void Present(_In_ const Surface& surface) override;
+		void* GetNativeWindow() override;
+	};
+}
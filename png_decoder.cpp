@@ -0,0 +1,1416 @@
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "mapped_file.h"
+#include "png_decoder.h"
+#include "profiler.h"
+#include "thread_pool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PNG_DECODER_X86
+#include <emmintrin.h>
+#endif
+
+namespace PngDecoder
+{
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		constexpr uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+		// bits resolved by the first lookup of a Huffman code, the longer codes continue in a second level
+		constexpr uint32_t LITERAL_TABLE_BITS     = 10;
+		constexpr uint32_t DISTANCE_TABLE_BITS    = 8;
+		constexpr uint32_t CODE_LENGTH_TABLE_BITS = 7;
+		constexpr uint32_t MAX_CODE_LENGTH        = 15;
+
+		// an entry of a table is the symbol in the high half and the bits to consume in the low nibble,
+		// or the offset and the index bits of a second level table
+		constexpr uint32_t ENTRY_SUBTABLE = 0x10;
+
+		// bits the buffer holds before a symbol: the longest length and distance pair (15 + 5 + 15 + 13)
+		constexpr uint32_t PAIR_BITS = 48;
+
+		// bytes past the inflated rows, a match is copied 8 bytes at a time
+		constexpr size_t COPY_SLACK = 8;
+
+		// bytes summed by Adler-32 before the sums can overflow
+		constexpr size_t ADLER_BLOCK = 5552;
+		constexpr uint32_t ADLER_MODULO = 65521;
+
+		// gamma of sRGB in the gAMA chunk, in units of 1 / 100000
+		constexpr uint32_t SRGB_GAMMA = 45455;
+
+		// filter of a row, its first byte
+		constexpr uint8_t FILTER_NONE    = 0;
+		constexpr uint8_t FILTER_SUB     = 1;
+		constexpr uint8_t FILTER_UP      = 2;
+		constexpr uint8_t FILTER_AVERAGE = 3;
+		constexpr uint8_t FILTER_PAETH   = 4;
+
+		constexpr uint16_t LENGTH_BASE[29] =
+		{
+			3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+		};
+		constexpr uint8_t LENGTH_EXTRA[29] =
+		{
+			0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+		};
+		constexpr uint16_t DISTANCE_BASE[30] =
+		{
+			1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+		};
+		constexpr uint8_t DISTANCE_EXTRA[30] =
+		{
+			0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+		};
+		constexpr uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		// Adam7 passes: first column, first row, column step, row step
+		constexpr uint32_t ADAM7[7][4] =
+		{
+			{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 },
+		};
+
+		//--------------------------------------------------------
+		// structure
+		//--------------------------------------------------------
+		/// <summary>
+		/// bytes of one IDAT chunk
+		/// </summary>
+		struct Span
+		{
+			const uint8_t* Data;
+			size_t Size;
+		};
+
+		/// <summary>
+		/// chunks of a file needed to decode it
+		/// </summary>
+		struct Header
+		{
+			Info Format;
+			uint8_t Palette[256][4];     // RGBA, the alpha of the tRNS chunk
+			uint32_t PaletteCount;
+			bool HasKey;                 // tRNS of gray and RGB: the transparent color, in samples
+			uint16_t Key[3];
+			std::vector<Span> Data;      // the zlib stream is split across the IDAT chunks
+		};
+
+		/// <summary>
+		/// texels of a row in the output layout
+		/// </summary>
+		struct Converter
+		{
+			ColorType Color;
+			uint8_t BitDepth;
+			uint32_t Red;                // byte of red in the layout, blue is 2 - Red
+			bool HasKey;
+			uint16_t Key[3];
+			uint8_t Lookup[256][4];      // texel of each palette index or gray value below 16 bits
+		};
+
+		//--------------------------------------------------------
+		// checksums
+		//--------------------------------------------------------
+		/// <summary>
+		/// CRC-32 tables, 8 bytes per step
+		/// </summary>
+		struct CrcTable
+		{
+			uint32_t Entries[8][256];
+
+			CrcTable()
+			{
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					uint32_t crc = i;
+					for (int bit = 0; bit < 8; ++bit) crc = (crc & 1) ? (crc >> 1) ^ 0xedb88320u : crc >> 1;
+					Entries[0][i] = crc;
+				}
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					for (int k = 1; k < 8; ++k) Entries[k][i] = (Entries[k - 1][i] >> 8) ^ Entries[0][Entries[k - 1][i] & 0xff];
+				}
+			}
+		};
+
+		/// <summary>
+		/// read a little endian 32-bit value
+		/// </summary>
+		inline uint32_t ReadLe32(const uint8_t* p)
+		{
+			return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 | static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+		}
+
+		/// <summary>
+		/// read a big endian 32-bit value
+		/// </summary>
+		inline uint32_t ReadBe32(const uint8_t* p)
+		{
+			return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]);
+		}
+
+		/// <summary>
+		/// CRC-32 of the bytes, slicing by 8
+		/// </summary>
+		uint32_t ComputeCrc(const uint8_t* p, size_t size)
+		{
+			static const CrcTable s_table;
+			const uint32_t (*t)[256] = s_table.Entries;
+
+			uint32_t crc = 0xffffffffu;
+			for (; size >= 8; p += 8, size -= 8)
+			{
+				const uint32_t low  = ReadLe32(p) ^ crc;
+				const uint32_t high = ReadLe32(p + 4);
+				crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+					t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+			}
+			for (; size > 0; ++p, --size) crc = (crc >> 8) ^ t[0][(crc ^ *p) & 0xff];
+
+			return crc ^ 0xffffffffu;
+		}
+
+		/// <summary>
+		/// add bytes to an Adler-32
+		/// </summary>
+		uint32_t UpdateAdler(uint32_t adler, const uint8_t* p, size_t size)
+		{
+			uint32_t a = adler & 0xffff, b = adler >> 16;
+			while (size > 0)
+			{
+				size_t count = (size < ADLER_BLOCK) ? size : ADLER_BLOCK;
+				size -= count;
+				for (; count > 0; --count)
+				{
+					a += *p++;
+					b += a;
+				}
+				a %= ADLER_MODULO;
+				b %= ADLER_MODULO;
+			}
+
+			return (b << 16) | a;
+		}
+
+		//--------------------------------------------------------
+		// chunks
+		//--------------------------------------------------------
+		/// <summary>
+		/// check the bit depth against the color type
+		/// </summary>
+		bool IsValidDepth(ColorType color, uint8_t depth)
+		{
+			switch (color)
+			{
+			case ColorType::Gray:    return depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+			case ColorType::Palette: return depth == 1 || depth == 2 || depth == 4 || depth == 8;
+			case ColorType::Rgb:
+			case ColorType::GrayAlpha:
+			case ColorType::Rgba:    return depth == 8 || depth == 16;
+			default:                 return false;
+			}
+		}
+
+		/// <summary>
+		/// get the samples of a texel
+		/// </summary>
+		uint32_t GetChannelCount(ColorType color)
+		{
+			switch (color)
+			{
+			case ColorType::Rgb:       return 3;
+			case ColorType::GrayAlpha: return 2;
+			case ColorType::Rgba:      return 4;
+			default:                   return 1;
+			}
+		}
+
+		/// <summary>
+		/// walk the chunks, checking their CRC, up to IEND (or up to the first IDAT for the header only)
+		/// returns 0 on success, -2 if the data is not a supported PNG or is corrupt
+		/// </summary>
+		int ParseChunks(const uint8_t* data, size_t size, bool isHeaderOnly, Header* p_header)
+		{
+			if (!IsPng(data, size))
+				return -2;
+
+			Info& info = p_header->Format;
+			p_header->PaletteCount = 0;
+			p_header->HasKey = false;
+			p_header->Data.clear();
+
+			bool has_header = false;
+			size_t position = sizeof(SIGNATURE);
+			while (size - position >= 12)
+			{
+				const uint32_t length = ReadBe32(&data[position]);
+				if (length > size - position - 12)
+					return -2;
+
+				const uint8_t* p_type = &data[position + 4];
+				const uint8_t* p_data = p_type + 4;
+				if (!isHeaderOnly && ComputeCrc(p_type, length + 4) != ReadBe32(p_data + length))
+					return -2;
+				position += 12 + static_cast<size_t>(length);
+
+				if (!has_header)
+				{
+					if (std::memcmp(p_type, "IHDR", 4) != 0 || length != 13)
+						return -2;
+
+					info.Width        = ReadBe32(p_data);
+					info.Height       = ReadBe32(p_data + 4);
+					info.BitDepth     = p_data[8];
+					info.Color        = static_cast<ColorType>(p_data[9]);
+					info.IsInterlaced = p_data[12] == 1;
+					info.IsSrgb       = false;
+					if (info.Width == 0 || info.Height == 0 || info.Width > MAX_DIMENSION || info.Height > MAX_DIMENSION ||
+						!IsValidDepth(info.Color, info.BitDepth) || p_data[10] != 0 || p_data[11] != 0 || p_data[12] > 1)
+						return -2;
+
+					has_header = true;
+				}
+				else if (std::memcmp(p_type, "IDAT", 4) == 0)
+				{
+					if (isHeaderOnly)
+						return 0;
+
+					if (length > 0) p_header->Data.push_back({ p_data, length });
+				}
+				else if (std::memcmp(p_type, "PLTE", 4) == 0)
+				{
+					if (length % 3 != 0 || length == 0 || length > 256 * 3)
+						return -2;
+
+					p_header->PaletteCount = length / 3;
+					for (uint32_t i = 0; i < p_header->PaletteCount; ++i)
+					{
+						for (int c = 0; c < 3; ++c) p_header->Palette[i][c] = p_data[i * 3 + c];
+						p_header->Palette[i][3] = 255;
+					}
+				}
+				else if (std::memcmp(p_type, "tRNS", 4) == 0)
+				{
+					if (info.Color == ColorType::Palette)
+					{
+						for (uint32_t i = 0; i < length && i < p_header->PaletteCount; ++i) p_header->Palette[i][3] = p_data[i];
+					}
+					else if (info.Color == ColorType::Gray && length >= 2)
+					{
+						p_header->HasKey = true;
+						p_header->Key[0] = static_cast<uint16_t>(p_data[0] << 8 | p_data[1]);
+					}
+					else if (info.Color == ColorType::Rgb && length >= 6)
+					{
+						p_header->HasKey = true;
+						for (int c = 0; c < 3; ++c) p_header->Key[c] = static_cast<uint16_t>(p_data[c * 2] << 8 | p_data[c * 2 + 1]);
+					}
+				}
+				else if (std::memcmp(p_type, "sRGB", 4) == 0)
+				{
+					info.IsSrgb = true;
+				}
+				else if (std::memcmp(p_type, "gAMA", 4) == 0)
+				{
+					if (length == 4 && ReadBe32(p_data) == SRGB_GAMMA) info.IsSrgb = true;
+				}
+				else if (std::memcmp(p_type, "IEND", 4) == 0)
+				{
+					break;
+				}
+				else if ((p_type[0] & 0x20) == 0)
+				{
+					// an unknown critical chunk changes how the image is read
+					return -2;
+				}
+			}
+
+			if (!has_header)
+				return -2;
+			if (isHeaderOnly)
+				return 0;
+
+			if (p_header->Data.empty() || (info.Color == ColorType::Palette && p_header->PaletteCount == 0))
+				return -2;
+
+			return 0;
+		}
+
+		//--------------------------------------------------------
+		// inflate
+		//--------------------------------------------------------
+		/// <summary>
+		/// bits of the zlib stream across the IDAT chunks, from the lowest bit
+		/// </summary>
+		class BitReader
+		{
+			const Span* _spans;
+			size_t _spanCount;
+			size_t _span;
+			const uint8_t* _position;
+			const uint8_t* _end;
+
+			uint64_t _bits;
+			uint32_t _count;
+			uint32_t _padding;           // zero bytes read past the end of the stream
+
+			//-----------------------------------
+			// private funcs
+			//-----------------------------------
+			/// <summary>
+			/// continue with the next chunk, false at the end of the stream
+			/// </summary>
+			bool NextSpan()
+			{
+				if (_span + 1 >= _spanCount)
+					return false;
+
+				++_span;
+				_position = _spans[_span].Data;
+				_end      = _position + _spans[_span].Size;
+				return true;
+			}
+
+			//-----------------------------------
+			// public funcs
+			//-----------------------------------
+		public:
+			BitReader(const Span* spans, size_t spanCount)
+			{
+				_spans     = spans;
+				_spanCount = spanCount;
+				_span      = 0;
+				_position  = spans[0].Data;
+				_end       = _position + spans[0].Size;
+				_bits      = 0;
+				_count     = 0;
+				_padding   = 0;
+			}
+
+			/// <summary>
+			/// fill the buffer to at least 56 bits, with zeros past the end of the stream
+			/// </summary>
+			void Refill()
+			{
+				if (_count > 56)
+					return;
+
+				// whole 8 bytes inside a chunk (the targets are little endian)
+				if (_end - _position >= 8)
+				{
+					uint64_t word;
+					std::memcpy(&word, _position, sizeof(word));
+					_bits |= word << _count;
+					_position += (63 - _count) >> 3;
+					_count |= 56;
+					return;
+				}
+
+				while (_count <= 56)
+				{
+					uint64_t byte = 0;
+					if (_position != _end) byte = *_position++;
+					else if (NextSpan()) continue;
+					else ++_padding;
+
+					_bits  |= byte << _count;
+					_count += 8;
+				}
+			}
+
+			uint32_t Peek(uint32_t count) const { return static_cast<uint32_t>(_bits & ((1ull << count) - 1)); }
+
+			void Consume(uint32_t count)
+			{
+				_bits >>= count;
+				_count -= count;
+			}
+
+			/// <summary>
+			/// read bits, the buffer must hold them
+			/// </summary>
+			uint32_t Read(uint32_t count)
+			{
+				const uint32_t value = Peek(count);
+				Consume(count);
+				return value;
+			}
+
+			/// <summary>
+			/// skip to the next whole byte
+			/// </summary>
+			void AlignToByte()
+			{
+				Consume(_count & 7);
+			}
+
+			/// <summary>
+			/// copy whole bytes after AlignToByte, false if the stream ends first
+			/// </summary>
+			bool ReadBytes(uint8_t* p_out, size_t size)
+			{
+				// the bytes already in the buffer, without the padding
+				uint32_t buffered = (_count >> 3) - ((_padding < (_count >> 3)) ? _padding : (_count >> 3));
+				for (; size > 0 && buffered > 0; --size, --buffered) *p_out++ = static_cast<uint8_t>(Read(8));
+				if (size == 0)
+					return true;
+
+				// the bits above the empty buffer came from the bytes copied next, so they must not be merged again
+				_bits = 0;
+				while (size > 0)
+				{
+					if (_padding > 0 || (_position == _end && !NextSpan()))
+						return false;
+
+					const size_t count = std::min(size, static_cast<size_t>(_end - _position));
+					std::memcpy(p_out, _position, count);
+					p_out += count;
+					_position += count;
+					size -= count;
+				}
+
+				return true;
+			}
+
+			uint32_t GetCount() const { return _count; }
+
+			// some of the consumed bits were not in the stream
+			bool IsOverrun() const { return _padding * 8 > _count; }
+		};
+
+		/// <summary>
+		/// reverse the lowest bits of a code (deflate sends Huffman codes from their highest bit)
+		/// </summary>
+		inline uint32_t ReverseBits(uint32_t code, uint32_t length)
+		{
+			uint32_t reversed = 0;
+			for (uint32_t i = 0; i < length; ++i, code >>= 1) reversed = (reversed << 1) | (code & 1);
+			return reversed;
+		}
+
+		/// <summary>
+		/// build the lookup of a canonical Huffman code, two levels for the codes longer than tableBits
+		/// an unused code reads as a zero entry, false if the lengths are over-subscribed
+		/// </summary>
+		bool BuildTable(const uint8_t* lengths, uint32_t count, uint32_t tableBits, std::vector<uint32_t>* p_table)
+		{
+			uint32_t counts[MAX_CODE_LENGTH + 1] = {};
+			for (uint32_t i = 0; i < count; ++i) counts[lengths[i]]++;
+			counts[0] = 0;
+
+			int32_t left = 1;
+			uint32_t next_code[MAX_CODE_LENGTH + 1] = {};
+			for (uint32_t length = 1; length <= MAX_CODE_LENGTH; ++length)
+			{
+				left = (left << 1) - static_cast<int32_t>(counts[length]);
+				if (left < 0)
+					return false;
+
+				next_code[length] = (next_code[length - 1] + counts[length - 1]) << 1;
+			}
+
+			uint16_t codes[288];
+			uint8_t longest[1u << LITERAL_TABLE_BITS] = {};
+			const uint32_t mask = (1u << tableBits) - 1;
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t length = lengths[i];
+				if (length == 0) continue;
+
+				codes[i] = static_cast<uint16_t>(ReverseBits(next_code[length]++, length));
+				if (length > tableBits) longest[codes[i] & mask] = std::max(longest[codes[i] & mask], static_cast<uint8_t>(length));
+			}
+
+			// a second level for each prefix of the long codes, as deep as the longest of them
+			p_table->assign(static_cast<size_t>(1) << tableBits, 0);
+			for (uint32_t prefix = 0; prefix <= mask; ++prefix)
+			{
+				if (longest[prefix] == 0) continue;
+
+				const uint32_t sub_bits = longest[prefix] - tableBits;
+				const uint32_t offset = static_cast<uint32_t>(p_table->size());
+				(*p_table)[prefix] = (offset << 16) | ENTRY_SUBTABLE | sub_bits;
+				p_table->resize(offset + (static_cast<size_t>(1) << sub_bits), 0);
+			}
+
+			uint32_t* p_entries = p_table->data();
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t length = lengths[i];
+				if (length == 0) continue;
+
+				if (length <= tableBits)
+				{
+					for (uint32_t j = codes[i]; j <= mask; j += 1u << length) p_entries[j] = (i << 16) | length;
+				}
+				else
+				{
+					const uint32_t link = p_entries[codes[i] & mask];
+					const uint32_t rest = length - tableBits;
+					for (uint32_t j = codes[i] >> tableBits; j < (1u << (link & 0xf)); j += 1u << rest) p_entries[(link >> 16) + j] = (i << 16) | rest;
+				}
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// decode a symbol, the buffer must hold 15 bits (a zero entry is an unused code)
+		/// </summary>
+		inline uint32_t DecodeSymbol(BitReader& reader, const uint32_t* p_table, uint32_t tableBits)
+		{
+			uint32_t entry = p_table[reader.Peek(tableBits)];
+			if (entry & ENTRY_SUBTABLE)
+			{
+				reader.Consume(tableBits);
+				entry = p_table[(entry >> 16) + reader.Peek(entry & 0xf)];
+			}
+			reader.Consume(entry & 0xf);
+
+			return entry;
+		}
+
+		/// <summary>
+		/// read the code lengths of a dynamic block and build its tables
+		/// </summary>
+		bool ReadDynamicTables(BitReader& reader, std::vector<uint32_t>* p_literals, std::vector<uint32_t>* p_distances)
+		{
+			reader.Refill();
+			const uint32_t literal_count  = reader.Read(5) + 257;
+			const uint32_t distance_count = reader.Read(5) + 1;
+			const uint32_t length_count   = reader.Read(4) + 4;
+			if (literal_count > 286 || distance_count > 30)
+				return false;
+
+			uint8_t code_lengths[19] = {};
+			for (uint32_t i = 0; i < length_count; ++i)
+			{
+				reader.Refill();
+				code_lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(reader.Read(3));
+			}
+
+			std::vector<uint32_t> table;
+			if (!BuildTable(code_lengths, 19, CODE_LENGTH_TABLE_BITS, &table))
+				return false;
+
+			// the lengths of both codes are one run, a repeat may cross from one to the other
+			uint8_t lengths[286 + 30];
+			const uint32_t total = literal_count + distance_count;
+			for (uint32_t i = 0; i < total;)
+			{
+				reader.Refill();
+				const uint32_t entry = DecodeSymbol(reader, table.data(), CODE_LENGTH_TABLE_BITS);
+				if (entry == 0)
+					return false;
+
+				const uint32_t symbol = entry >> 16;
+				if (symbol < 16)
+				{
+					lengths[i++] = static_cast<uint8_t>(symbol);
+					continue;
+				}
+
+				uint8_t value = 0;
+				uint32_t repeat = 0;
+				if (symbol == 16)
+				{
+					if (i == 0)
+						return false;
+					value  = lengths[i - 1];
+					repeat = 3 + reader.Read(2);
+				}
+				else if (symbol == 17) repeat = 3 + reader.Read(3);
+				else                   repeat = 11 + reader.Read(7);
+
+				if (repeat > total - i)
+					return false;
+				std::memset(&lengths[i], value, repeat);
+				i += repeat;
+			}
+
+			if (lengths[256] == 0)
+				return false;
+
+			return BuildTable(lengths, literal_count, LITERAL_TABLE_BITS, p_literals) &&
+				BuildTable(lengths + literal_count, distance_count, DISTANCE_TABLE_BITS, p_distances);
+		}
+
+		/// <summary>
+		/// inflate a zlib stream into exactly size bytes, the buffer must have COPY_SLACK bytes after them
+		/// returns 0 on success with the Adler-32 of the stream, -2 if the stream is corrupt or of another size
+		/// </summary>
+		int Inflate(const std::vector<Span>& spans, uint8_t* p_begin, size_t size, uint32_t* p_adler)
+		{
+			PROFILE_SCOPE("PngDecoder::Inflate");
+
+			BitReader reader(spans.data(), spans.size());
+			reader.Refill();
+
+			// deflate with a window of at most 32k, without a preset dictionary
+			const uint32_t method = reader.Read(8);
+			const uint32_t flags  = reader.Read(8);
+			if ((method & 0xf) != 8 || (method >> 4) > 7 || (method * 256 + flags) % 31 != 0 || (flags & 0x20))
+				return -2;
+
+			std::vector<uint32_t> literals, distances;
+			bool is_fixed = false;
+
+			uint8_t* p_out = p_begin;
+			uint8_t* const p_end = p_begin + size;
+			bool is_final = false;
+			while (!is_final)
+			{
+				reader.Refill();
+				if (reader.IsOverrun())
+					return -2;
+
+				is_final = reader.Read(1) != 0;
+				const uint32_t type = reader.Read(2);
+				if (type == 0)
+				{
+					reader.AlignToByte();
+					reader.Refill();
+					const uint32_t length = reader.Read(16);
+					if ((length ^ 0xffff) != reader.Read(16) || length > static_cast<size_t>(p_end - p_out))
+						return -2;
+					if (!reader.ReadBytes(p_out, length))
+						return -2;
+
+					p_out += length;
+					continue;
+				}
+
+				if (type == 1)
+				{
+					// the fixed code is built once, the first time a block uses it
+					if (!is_fixed)
+					{
+						uint8_t lengths[288 + 32];
+						std::memset(&lengths[0], 8, 144);
+						std::memset(&lengths[144], 9, 112);
+						std::memset(&lengths[256], 7, 24);
+						std::memset(&lengths[280], 8, 8);
+						std::memset(&lengths[288], 5, 32);
+						BuildTable(lengths, 288, LITERAL_TABLE_BITS, &literals);
+						BuildTable(lengths + 288, 32, DISTANCE_TABLE_BITS, &distances);
+						is_fixed = true;
+					}
+				}
+				else if (type == 2)
+				{
+					if (!ReadDynamicTables(reader, &literals, &distances))
+						return -2;
+					is_fixed = false;
+				}
+				else
+				{
+					return -2;
+				}
+
+				const uint32_t* p_literals  = literals.data();
+				const uint32_t* p_distances = distances.data();
+				for (;;)
+				{
+					// a refill is enough for a whole match, or for up to three literals
+					if (reader.GetCount() < PAIR_BITS) reader.Refill();
+
+					const uint32_t entry = DecodeSymbol(reader, p_literals, LITERAL_TABLE_BITS);
+					uint32_t symbol = entry >> 16;
+					if (entry == 0)
+						return -2;
+
+					if (symbol < 256)
+					{
+						if (p_out == p_end)
+							return -2;
+						*p_out++ = static_cast<uint8_t>(symbol);
+						continue;
+					}
+					if (symbol == 256)
+						break;
+
+					symbol -= 257;
+					if (symbol >= 29)
+						return -2;
+					const uint32_t length = LENGTH_BASE[symbol] + reader.Read(LENGTH_EXTRA[symbol]);
+
+					const uint32_t distance_entry = DecodeSymbol(reader, p_distances, DISTANCE_TABLE_BITS);
+					const uint32_t distance_symbol = distance_entry >> 16;
+					if (distance_entry == 0 || distance_symbol >= 30)
+						return -2;
+					const uint32_t distance = DISTANCE_BASE[distance_symbol] + reader.Read(DISTANCE_EXTRA[distance_symbol]);
+
+					if (distance > static_cast<size_t>(p_out - p_begin) || length > static_cast<size_t>(p_end - p_out))
+						return -2;
+
+					// far matches 8 bytes at a time (each word is already written), the slack takes the overrun
+					const uint8_t* p_from = p_out - distance;
+					if (distance >= 8)
+					{
+						uint8_t* p_to = p_out;
+						do
+						{
+							std::memcpy(p_to, p_from, 8);
+							p_to   += 8;
+							p_from += 8;
+						} while (p_to < p_out + length);
+					}
+					else if (distance == 1)
+					{
+						std::memset(p_out, p_out[-1], length);
+					}
+					else
+					{
+						for (uint32_t i = 0; i < length; ++i) p_out[i] = p_from[i];
+					}
+					p_out += length;
+				}
+			}
+
+			// the checksum follows the last block, from its highest byte
+			reader.AlignToByte();
+			reader.Refill();
+			uint32_t adler = 0;
+			for (int i = 0; i < 4; ++i) adler = (adler << 8) | reader.Read(8);
+
+			if (reader.IsOverrun() || p_out != p_end)
+				return -2;
+
+			*p_adler = adler;
+			return 0;
+		}
+
+		//--------------------------------------------------------
+		// unfilter
+		//--------------------------------------------------------
+		/// <summary>
+		/// Paeth predictor: the neighbour closest to left + above - upper left, in the order left, above, upper left on ties
+		/// </summary>
+		inline uint8_t Paeth(int left, int above, int upperLeft)
+		{
+			const int pa = std::abs(above - upperLeft);
+			const int pb = std::abs(left - upperLeft);
+			const int pc = std::abs(left + above - 2 * upperLeft);
+
+			if (pa <= pb && pa <= pc) return static_cast<uint8_t>(left);
+			return static_cast<uint8_t>((pb <= pc) ? above : upperLeft);
+		}
+
+		/// <summary>
+		/// undo the Sub filter byte by byte
+		/// </summary>
+		void UnfilterSubScalar(uint8_t* p_row, size_t size, uint32_t stride)
+		{
+			for (size_t i = stride; i < size; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + p_row[i - stride]);
+		}
+
+		/// <summary>
+		/// undo a filter byte by byte, p_previous is the unfiltered row above
+		/// </summary>
+		void UnfilterScalar(uint8_t filter, uint8_t* p_row, const uint8_t* p_previous, size_t size, uint32_t stride)
+		{
+			switch (filter)
+			{
+			case FILTER_SUB:
+				UnfilterSubScalar(p_row, size, stride);
+				break;
+
+			case FILTER_UP:
+				for (size_t i = 0; i < size; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + p_previous[i]);
+				break;
+
+			case FILTER_AVERAGE:
+				for (size_t i = 0; i < stride; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + (p_previous[i] >> 1));
+				for (size_t i = stride; i < size; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + ((p_row[i - stride] + p_previous[i]) >> 1));
+				break;
+
+			case FILTER_PAETH:
+				for (size_t i = 0; i < stride; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + p_previous[i]);
+				for (size_t i = stride; i < size; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + Paeth(p_row[i - stride], p_previous[i], p_previous[i - stride]));
+				break;
+			}
+		}
+
+#ifdef PNG_DECODER_X86
+		/// <summary>
+		/// load the bytes of a texel into the low lanes, without reading past it
+		/// the bytes are gathered in registers: a narrow store to memory read back by a wide load stalls the forwarding
+		/// </summary>
+		template <uint32_t STRIDE>
+		inline __m128i LoadTexel(const uint8_t* p)
+		{
+			uint32_t low = 0, high = 0;
+			if constexpr (STRIDE == 3)
+			{
+				uint16_t pair;
+				std::memcpy(&pair, p, sizeof(pair));
+				low = pair | (static_cast<uint32_t>(p[2]) << 16);
+			}
+			else
+			{
+				std::memcpy(&low, p, sizeof(low));
+				std::memcpy(&high, p + 4, STRIDE - 4);
+			}
+			return _mm_set_epi32(0, 0, static_cast<int>(high), static_cast<int>(low));
+		}
+
+		/// <summary>
+		/// store the low lanes of a texel, without writing past it
+		/// </summary>
+		template <uint32_t STRIDE>
+		inline void StoreTexel(uint8_t* p, __m128i value)
+		{
+			const uint32_t low = static_cast<uint32_t>(_mm_cvtsi128_si32(value));
+			if constexpr (STRIDE == 3)
+			{
+				const uint16_t pair = static_cast<uint16_t>(low);
+				std::memcpy(p, &pair, sizeof(pair));
+				p[2] = static_cast<uint8_t>(low >> 16);
+			}
+			else
+			{
+				const uint32_t high = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(value, 4)));
+				std::memcpy(p, &low, sizeof(low));
+				std::memcpy(p + 4, &high, STRIDE - 4);
+			}
+		}
+
+		/// <summary>
+		/// select the lanes of a where the mask is set, otherwise the lanes of b
+		/// </summary>
+		inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+		{
+			return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+		}
+
+		/// <summary>
+		/// absolute value of 16-bit lanes
+		/// </summary>
+		inline __m128i Abs16(__m128i value)
+		{
+			return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+		}
+
+		/// <summary>
+		/// undo the Sub filter a texel at a time
+		/// </summary>
+		template <uint32_t STRIDE>
+		void UnfilterSubSse2(uint8_t* p_row, size_t size)
+		{
+			__m128i left = _mm_setzero_si128();
+			for (size_t i = 0; i < size; i += STRIDE)
+			{
+				left = _mm_add_epi8(LoadTexel<STRIDE>(p_row + i), left);
+				StoreTexel<STRIDE>(p_row + i, left);
+			}
+		}
+
+		/// <summary>
+		/// undo the Average filter a texel at a time
+		/// </summary>
+		template <uint32_t STRIDE>
+		void UnfilterAverageSse2(uint8_t* p_row, const uint8_t* p_previous, size_t size)
+		{
+			const __m128i one = _mm_set1_epi8(1);
+
+			__m128i left = _mm_setzero_si128();
+			for (size_t i = 0; i < size; i += STRIDE)
+			{
+				// pavgb rounds up, the filter rounds down
+				const __m128i above   = LoadTexel<STRIDE>(p_previous + i);
+				const __m128i average = _mm_sub_epi8(_mm_avg_epu8(left, above), _mm_and_si128(_mm_xor_si128(left, above), one));
+
+				left = _mm_add_epi8(LoadTexel<STRIDE>(p_row + i), average);
+				StoreTexel<STRIDE>(p_row + i, left);
+			}
+		}
+
+		/// <summary>
+		/// undo the Paeth filter a texel at a time, the distances in 16-bit lanes
+		/// </summary>
+		template <uint32_t STRIDE>
+		void UnfilterPaethSse2(uint8_t* p_row, const uint8_t* p_previous, size_t size)
+		{
+			const __m128i zero = _mm_setzero_si128();
+
+			__m128i left = zero, upper_left = zero;
+			for (size_t i = 0; i < size; i += STRIDE)
+			{
+				const __m128i above = _mm_unpacklo_epi8(LoadTexel<STRIDE>(p_previous + i), zero);
+
+				// |p - left|, |p - above| and |p - upper left| with p = left + above - upper left
+				__m128i pa = _mm_sub_epi16(above, upper_left);
+				__m128i pb = _mm_sub_epi16(left, upper_left);
+				__m128i pc = _mm_add_epi16(pa, pb);
+				pa = Abs16(pa);
+				pb = Abs16(pb);
+				pc = Abs16(pc);
+
+				const __m128i smallest  = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				const __m128i predictor = Select(_mm_cmpeq_epi16(smallest, pa), left, Select(_mm_cmpeq_epi16(smallest, pb), above, upper_left));
+
+				const __m128i texel = _mm_add_epi8(LoadTexel<STRIDE>(p_row + i), _mm_packus_epi16(predictor, predictor));
+				StoreTexel<STRIDE>(p_row + i, texel);
+
+				left       = _mm_unpacklo_epi8(texel, zero);
+				upper_left = above;
+			}
+		}
+
+		/// <summary>
+		/// undo a filter of a row of whole texels of 3 to 8 bytes
+		/// </summary>
+		template <uint32_t STRIDE>
+		void UnfilterSse2(uint8_t filter, uint8_t* p_row, const uint8_t* p_previous, size_t size)
+		{
+			switch (filter)
+			{
+			case FILTER_SUB:     UnfilterSubSse2<STRIDE>(p_row, size);                 break;
+			case FILTER_AVERAGE: UnfilterAverageSse2<STRIDE>(p_row, p_previous, size); break;
+			case FILTER_PAETH:   UnfilterPaethSse2<STRIDE>(p_row, p_previous, size);   break;
+			}
+		}
+
+		/// <summary>
+		/// undo the Up filter 16 bytes at a time
+		/// </summary>
+		void UnfilterUpSse2(uint8_t* p_row, const uint8_t* p_previous, size_t size)
+		{
+			size_t i = 0;
+			for (; i + 16 <= size; i += 16)
+			{
+				const __m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_row + i)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_previous + i)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(p_row + i), sum);
+			}
+			for (; i < size; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + p_previous[i]);
+		}
+#endif
+
+		/// <summary>
+		/// undo the filter of a row in place, p_previous is the unfiltered row above (nullptr for the first row)
+		/// returns false for an unknown filter
+		/// </summary>
+		bool UnfilterRow(uint8_t filter, uint8_t* p_row, const uint8_t* p_previous, size_t size, uint32_t stride, QuadKernel::InstructionSet set)
+		{
+			if (filter > FILTER_PAETH)
+				return false;
+			if (filter == FILTER_NONE)
+				return true;
+
+			// the row above the first one is zero: Up adds nothing, and Paeth predicts the left byte as Sub does
+			if (!p_previous)
+			{
+				if (filter == FILTER_UP)
+					return true;
+
+				if (filter == FILTER_AVERAGE)
+				{
+					for (size_t i = stride; i < size; ++i) p_row[i] = static_cast<uint8_t>(p_row[i] + (p_row[i - stride] >> 1));
+					return true;
+				}
+				filter = FILTER_SUB;
+			}
+
+#ifdef PNG_DECODER_X86
+			if (set != QuadKernel::InstructionSet::Scalar)
+			{
+				if (filter == FILTER_UP)
+				{
+					UnfilterUpSse2(p_row, p_previous, size);
+					return true;
+				}
+
+				// a texel of 1 or 2 bytes has too little in a register to be worth it
+				switch (stride)
+				{
+				case 3: UnfilterSse2<3>(filter, p_row, p_previous, size); return true;
+				case 4: UnfilterSse2<4>(filter, p_row, p_previous, size); return true;
+				case 6: UnfilterSse2<6>(filter, p_row, p_previous, size); return true;
+				case 8: UnfilterSse2<8>(filter, p_row, p_previous, size); return true;
+				}
+			}
+#else
+			(void)set;
+#endif
+
+			UnfilterScalar(filter, p_row, p_previous, size, stride);
+			return true;
+		}
+
+		//--------------------------------------------------------
+		// convert
+		//--------------------------------------------------------
+		/// <summary>
+		/// write a texel in the layout
+		/// </summary>
+		inline void WriteTexel(uint8_t* p_out, uint32_t red, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+		{
+			p_out[red]     = r;
+			p_out[1]       = g;
+			p_out[2 - red] = b;
+			p_out[3]       = a;
+		}
+
+		/// <summary>
+		/// prepare the conversion into the layout, the palette and the gray levels below 16 bits become a lookup
+		/// </summary>
+		void InitializeConverter(const Header& header, Layout layout, Converter* p_converter)
+		{
+			const Info& info = header.Format;
+			p_converter->Color    = info.Color;
+			p_converter->BitDepth = info.BitDepth;
+			p_converter->Red      = (layout == Layout::Bgra8) ? 2 : 0;
+			p_converter->HasKey   = header.HasKey;
+			for (int c = 0; c < 3; ++c) p_converter->Key[c] = header.HasKey ? header.Key[c] : 0;
+
+			if (info.Color == ColorType::Palette)
+			{
+				// an index past the palette is opaque black
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					const uint8_t* p_entry = header.Palette[i];
+					if (i < header.PaletteCount) WriteTexel(p_converter->Lookup[i], p_converter->Red, p_entry[0], p_entry[1], p_entry[2], p_entry[3]);
+					else                         WriteTexel(p_converter->Lookup[i], p_converter->Red, 0, 0, 0, 255);
+				}
+			}
+			else if (info.Color == ColorType::Gray && info.BitDepth <= 8)
+			{
+				// the levels are stretched to 8 bits, as replicating their bits does
+				const uint32_t max_level = (1u << info.BitDepth) - 1;
+				for (uint32_t level = 0; level <= max_level; ++level)
+				{
+					const uint8_t gray  = static_cast<uint8_t>(level * 255 / max_level);
+					const uint8_t alpha = (header.HasKey && level == header.Key[0]) ? 0 : 255;
+					WriteTexel(p_converter->Lookup[level], p_converter->Red, gray, gray, gray, alpha);
+				}
+			}
+		}
+
+		/// <summary>
+		/// convert an unfiltered row into texels of the layout (16-bit samples keep their high byte)
+		/// </summary>
+		void ConvertRow(const Converter& converter, const uint8_t* p_row, uint32_t width, uint8_t* p_out, QuadKernel::InstructionSet set)
+		{
+			const uint32_t red = converter.Red;
+			const bool is_wide = converter.BitDepth == 16;
+			const uint32_t sample = is_wide ? 2 : 1;
+
+			switch (converter.Color)
+			{
+			case ColorType::Gray:
+			case ColorType::Palette:
+				if (is_wide)
+				{
+					for (uint32_t x = 0; x < width; ++x, p_row += 2, p_out += 4)
+					{
+						const bool is_key = converter.HasKey && (p_row[0] << 8 | p_row[1]) == converter.Key[0];
+						WriteTexel(p_out, red, p_row[0], p_row[0], p_row[0], is_key ? 0 : 255);
+					}
+				}
+				else if (converter.BitDepth == 8)
+				{
+					// the palette, and the gray levels below 16 bits, are a lookup
+					for (uint32_t x = 0; x < width; ++x) std::memcpy(&p_out[x * 4], converter.Lookup[p_row[x]], 4);
+				}
+				else
+				{
+					// packed from the highest bits of each byte
+					const uint32_t depth = converter.BitDepth;
+					const uint32_t per_byte = 8 / depth;
+					const uint32_t mask = (1u << depth) - 1;
+					for (uint32_t x = 0; x < width; ++x)
+					{
+						const uint32_t shift = 8 - depth * (x % per_byte + 1);
+						std::memcpy(&p_out[x * 4], converter.Lookup[(p_row[x / per_byte] >> shift) & mask], 4);
+					}
+				}
+				break;
+
+			case ColorType::Rgb:
+				for (uint32_t x = 0; x < width; ++x, p_row += 3 * sample, p_out += 4)
+				{
+					bool is_key = false;
+					if (converter.HasKey)
+					{
+						is_key = is_wide ?
+							(p_row[0] << 8 | p_row[1]) == converter.Key[0] && (p_row[2] << 8 | p_row[3]) == converter.Key[1] && (p_row[4] << 8 | p_row[5]) == converter.Key[2] :
+							p_row[0] == converter.Key[0] && p_row[1] == converter.Key[1] && p_row[2] == converter.Key[2];
+					}
+					WriteTexel(p_out, red, p_row[0], p_row[sample], p_row[2 * sample], is_key ? 0 : 255);
+				}
+				break;
+
+			case ColorType::GrayAlpha:
+				for (uint32_t x = 0; x < width; ++x, p_row += 2 * sample, p_out += 4) WriteTexel(p_out, red, p_row[0], p_row[0], p_row[0], p_row[sample]);
+				break;
+
+			case ColorType::Rgba:
+				if (is_wide)
+				{
+					for (uint32_t x = 0; x < width; ++x, p_row += 8, p_out += 4) WriteTexel(p_out, red, p_row[0], p_row[2], p_row[4], p_row[6]);
+				}
+				else if (red == 0)
+				{
+					std::memcpy(p_out, p_row, static_cast<size_t>(width) * 4);
+				}
+				else
+				{
+					uint32_t x = 0;
+#ifdef PNG_DECODER_X86
+					// swap red and blue of 4 texels at a time
+					if (set != QuadKernel::InstructionSet::Scalar)
+					{
+						const __m128i green_alpha = _mm_set1_epi32(static_cast<int>(0xff00ff00u));
+						const __m128i low  = _mm_set1_epi32(0x000000ff);
+						const __m128i high = _mm_set1_epi32(0x00ff0000);
+						for (; x + 4 <= width; x += 4)
+						{
+							const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_row + x * 4));
+							const __m128i swapped = _mm_or_si128(_mm_and_si128(texels, green_alpha),
+								_mm_or_si128(_mm_and_si128(_mm_srli_epi32(texels, 16), low), _mm_and_si128(_mm_slli_epi32(texels, 16), high)));
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(p_out + x * 4), swapped);
+						}
+					}
+#endif
+					for (; x < width; ++x) WriteTexel(&p_out[x * 4], red, p_row[x * 4], p_row[x * 4 + 1], p_row[x * 4 + 2], p_row[x * 4 + 3]);
+				}
+				break;
+			}
+
+#ifndef PNG_DECODER_X86
+			(void)set;
+#endif
+		}
+
+		//--------------------------------------------------------
+		// decode
+		//--------------------------------------------------------
+		/// <summary>
+		/// get the bytes of a row without its filter byte
+		/// </summary>
+		inline size_t GetRowBytes(uint32_t width, uint32_t bitsPerTexel)
+		{
+			return (static_cast<size_t>(width) * bitsPerTexel + 7) / 8;
+		}
+
+		/// <summary>
+		/// decode the rows of a parsed file into the image
+		/// </summary>
+		int DecodeRows(const Header& header, Layout layout, Image* p_image, QuadKernel::InstructionSet set)
+		{
+			const Info& info = header.Format;
+			const uint32_t bits   = GetChannelCount(info.Color) * info.BitDepth;
+			const uint32_t stride = (bits >= 8) ? bits / 8 : 1;
+
+			Converter converter;
+			InitializeConverter(header, layout, &converter);
+
+			const size_t pitch = static_cast<size_t>(info.Width) * 4;
+			const size_t image_size = pitch * info.Height;
+			std::vector<uint8_t>& pixels = p_image->Pixels;
+
+			uint32_t adler = 0, running_adler = 1;
+			if (!info.IsInterlaced)
+			{
+				// the rows are inflated into the end of the texels and converted from the front,
+				// a texel row never reaches the filtered row it is converted from or the row above it
+				const size_t row_bytes = GetRowBytes(info.Width, bits);
+				const size_t raw_pitch = row_bytes + 1;
+				const size_t raw_size  = raw_pitch * info.Height;
+				const size_t buffer_size = std::max(image_size, raw_size) + raw_pitch + COPY_SLACK;
+
+				pixels.resize(buffer_size);
+				uint8_t* p_raw = pixels.data() + buffer_size - COPY_SLACK - raw_size;
+				if (Inflate(header.Data, p_raw, raw_size, &adler) != 0)
+					return -2;
+
+				PROFILE_SCOPE("PngDecoder::Unfilter");
+				for (uint32_t y = 0; y < info.Height; ++y)
+				{
+					uint8_t* p_row = p_raw + y * raw_pitch;
+					running_adler = UpdateAdler(running_adler, p_row, raw_pitch);
+
+					if (!UnfilterRow(p_row[0], p_row + 1, y ? p_row + 1 - raw_pitch : nullptr, row_bytes, stride, set))
+						return -2;
+					ConvertRow(converter, p_row + 1, info.Width, &pixels[y * pitch], set);
+				}
+
+				// 16-bit rows are larger than the texels, their buffer is not kept
+				pixels.resize(image_size);
+				if (pixels.capacity() > image_size + image_size / 8) pixels.shrink_to_fit();
+			}
+			else
+			{
+				// each pass is an image of its own, the passes follow each other in the stream
+				size_t raw_size = 0;
+				for (const uint32_t* pass : ADAM7)
+				{
+					const uint32_t pass_width  = (info.Width  + pass[2] - 1 - pass[0]) / pass[2];
+					const uint32_t pass_height = (info.Height + pass[3] - 1 - pass[1]) / pass[3];
+					if (pass_width && pass_height) raw_size += (GetRowBytes(pass_width, bits) + 1) * pass_height;
+				}
+
+				std::vector<uint8_t> raw(raw_size + COPY_SLACK);
+				if (Inflate(header.Data, raw.data(), raw_size, &adler) != 0)
+					return -2;
+
+				PROFILE_SCOPE("PngDecoder::Unfilter");
+				pixels.resize(image_size);
+				std::vector<uint8_t> texels(pitch);
+				uint8_t* p_row = raw.data();
+				for (const uint32_t* pass : ADAM7)
+				{
+					const uint32_t pass_width  = (info.Width  + pass[2] - 1 - pass[0]) / pass[2];
+					const uint32_t pass_height = (info.Height + pass[3] - 1 - pass[1]) / pass[3];
+					if (!pass_width || !pass_height) continue;
+
+					const size_t row_bytes = GetRowBytes(pass_width, bits);
+					for (uint32_t y = 0; y < pass_height; ++y, p_row += row_bytes + 1)
+					{
+						running_adler = UpdateAdler(running_adler, p_row, row_bytes + 1);
+
+						if (!UnfilterRow(p_row[0], p_row + 1, y ? p_row - row_bytes : nullptr, row_bytes, stride, set))
+							return -2;
+						ConvertRow(converter, p_row + 1, pass_width, texels.data(), set);
+
+						uint8_t* p_out = &pixels[(pass[1] + y * pass[3]) * pitch + pass[0] * 4];
+						for (uint32_t x = 0; x < pass_width; ++x) std::memcpy(&p_out[x * pass[2] * 4], &texels[x * 4], 4);
+					}
+				}
+			}
+
+			return (running_adler == adler) ? 0 : -2;
+		}
+
+		/// <summary>
+		/// decode a file through a read-only mapping
+		/// </summary>
+		template <typename Char>
+		int DecodeMapped(const Char* path, Layout layout, Image* p_image)
+		{
+			MappedFile::View view;
+			if (view.Open(path) != 0)
+				return -1;
+
+			return Decode(view.GetData(), view.GetSize(), layout, p_image);
+		}
+
+		/// <summary>
+		/// decode many files, one per task of the thread pool
+		/// </summary>
+		template <typename String>
+		void DecodeAll(const std::vector<String>& paths, Layout layout, std::vector<Image>* p_images, std::vector<int>* p_results)
+		{
+			p_images->assign(paths.size(), Image());
+			p_results->assign(paths.size(), -1);
+
+			ThreadPool::Manager::Instance().ParallelFor(paths.size(), [&](size_t i)
+			{
+				(*p_results)[i] = DecodeFile(paths[i].c_str(), layout, &(*p_images)[i]);
+			});
+		}
+	}
+
+	/// <summary>
+	/// check the signature
+	/// </summary>
+	bool IsPng(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size)
+	{
+		return size >= sizeof(SIGNATURE) && std::memcmp(data, SIGNATURE, sizeof(SIGNATURE)) == 0;
+	}
+
+	/// <summary>
+	/// read the header without decoding
+	/// </summary>
+	int ReadInfo(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size, _Out_ Info* p_info)
+	{
+		Header header;
+		const int result = ParseChunks(data, size, true, &header);
+		if (result != 0)
+			return result;
+
+		*p_info = header.Format;
+		return 0;
+	}
+
+	/// <summary>
+	/// decode with the best instruction set
+	/// </summary>
+	int Decode(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size, _In_ Layout layout, _Out_ Image* p_image)
+	{
+		return Decode(data, size, layout, p_image, QuadKernel::GetBestInstructionSet());
+	}
+
+	/// <summary>
+	/// decode with the specified instruction set (avx2 uses the sse2 filters)
+	/// </summary>
+	int Decode(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size, _In_ Layout layout, _Out_ Image* p_image,
+		_In_ QuadKernel::InstructionSet set)
+	{
+		PROFILE_SCOPE("PngDecoder::Decode");
+
+		p_image->Width  = 0;
+		p_image->Height = 0;
+		p_image->IsSrgb = false;
+
+		Header header;
+		int result = ParseChunks(data, size, false, &header);
+		if (result == 0) result = DecodeRows(header, layout, p_image, set);
+		if (result != 0)
+		{
+			p_image->Pixels.clear();
+			return result;
+		}
+
+		p_image->Width  = header.Format.Width;
+		p_image->Height = header.Format.Height;
+		p_image->IsSrgb = header.Format.IsSrgb;
+
+		return 0;
+	}
+
+	/// <summary>
+	/// decode a file
+	/// </summary>
+	int DecodeFile(_In_ const char* path, _In_ Layout layout, _Out_ Image* p_image)
+	{
+		return DecodeMapped(path, layout, p_image);
+	}
+
+#ifdef _WIN32
+	/// <summary>
+	/// decode a file
+	/// </summary>
+	int DecodeFile(_In_ const wchar_t* path, _In_ Layout layout, _Out_ Image* p_image)
+	{
+		return DecodeMapped(path, layout, p_image);
+	}
+#endif
+
+	/// <summary>
+	/// decode many files on the thread pool
+	/// </summary>
+	void DecodeFiles(_In_ const std::vector<std::string>& paths, _In_ Layout layout, _Out_ std::vector<Image>* p_images,
+		_Out_ std::vector<int>* p_results)
+	{
+		DecodeAll(paths, layout, p_images, p_results);
+	}
+
+#ifdef _WIN32
+	/// <summary>
+	/// decode many files on the thread pool
+	/// </summary>
+	void DecodeFiles(_In_ const std::vector<std::wstring>& paths, _In_ Layout layout, _Out_ std::vector<Image>* p_images,
+		_Out_ std::vector<int>* p_results)
+	{
+		DecodeAll(paths, layout, p_images, p_results);
+	}
+#endif
+}
@@ -0,0 +1,103 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "portable_sal.h"
+#include "quad_kernel.h"
+
+namespace PngDecoder
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// largest width and height, the largest texture of D3D11 (a corrupt header must not allocate gigabytes)
+	constexpr uint32_t MAX_DIMENSION = 16384;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// byte order of the decoded texels, 8 bits per channel
+	/// </summary>
+	enum class Layout : uint32_t
+	{
+		Rgba8 = 0,               // red is the lowest byte (DXGI_FORMAT_R8G8B8A8_UNORM)
+		Bgra8,                   // blue is the lowest byte (DXGI_FORMAT_B8G8R8A8_UNORM)
+	};
+
+	/// <summary>
+	/// color type of the IHDR chunk
+	/// </summary>
+	enum class ColorType : uint8_t
+	{
+		Gray      = 0,
+		Rgb       = 2,
+		Palette   = 3,
+		GrayAlpha = 4,
+		Rgba      = 6,
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// header of a file
+	/// </summary>
+	struct Info
+	{
+		uint32_t Width;
+		uint32_t Height;
+		uint8_t BitDepth;        // bits per sample: 1, 2, 4, 8 or 16
+		ColorType Color;
+		bool IsInterlaced;       // Adam7
+		bool IsSrgb;             // sRGB chunk, or the gamma of sRGB
+	};
+
+	/// <summary>
+	/// decoded image, 4 bytes per texel in the requested layout, tightly packed rows
+	/// </summary>
+	struct Image
+	{
+		uint32_t Width;
+		uint32_t Height;
+		bool IsSrgb;
+		std::vector<uint8_t> Pixels;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// check the signature
+	bool IsPng(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size);
+
+	// read the header without decoding
+	// returns 0 on success, -2 if the data is not a supported PNG
+	int ReadInfo(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size, _Out_ Info* p_info);
+
+	// decode every color type and bit depth straight into the layout (16-bit samples keep their high byte)
+	// the rows are inflated into the end of the texel buffer and expanded in place, so no second image is allocated
+	// every chunk CRC and the Adler-32 of the stream are checked
+	// returns 0 on success, -2 if the data is not a supported PNG or is corrupt
+	int Decode(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size, _In_ Layout layout, _Out_ Image* p_image);
+	int Decode(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size, _In_ Layout layout, _Out_ Image* p_image,
+		_In_ QuadKernel::InstructionSet set);
+
+	// decode a file through a read-only mapping
+	// returns 0 on success, -1 if the file cannot be opened, -2 if it is not a supported PNG or is corrupt
+	int DecodeFile(_In_ const char* path, _In_ Layout layout, _Out_ Image* p_image);
+#ifdef _WIN32
+	int DecodeFile(_In_ const wchar_t* path, _In_ Layout layout, _Out_ Image* p_image);
+#endif
+
+	// decode many files, one per task of the thread pool, with the result of each one
+	void DecodeFiles(_In_ const std::vector<std::string>& paths, _In_ Layout layout, _Out_ std::vector<Image>* p_images,
+		_Out_ std::vector<int>* p_results);
+#ifdef _WIN32
+	void DecodeFiles(_In_ const std::vector<std::wstring>& paths, _In_ Layout layout, _Out_ std::vector<Image>* p_images,
+		_Out_ std::vector<int>* p_results);
+#endif
+}
@@ -0,0 +1,16 @@
+
+#pragma once
+
+// SAL annotations are only provided by the windows sdk.
+// portable modules include this header so they also build on linux.
+#ifdef _WIN32
+#include <sal.h>
+#else
+#define _In_
+#define _In_opt_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _In_reads_(count)
+#define _In_reads_bytes_(size)
+#endif
@@ -0,0 +1,211 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include "profiler.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PROFILER_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace Profiler
+{
+	namespace
+	{
+		// ring of the calling thread, registered on the first zone
+		thread_local ThreadRing* t_ring = nullptr;
+
+		/// <summary>
+		/// nanoseconds of the steady clock
+		/// </summary>
+		int64_t GetSteadyNanoseconds()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		/// <summary>
+		/// write a string with the JSON escapes
+		/// </summary>
+		void WriteJsonString(FILE* p_file, const char* text)
+		{
+			std::fputc('"', p_file);
+			for (const char* p = text; *p; ++p)
+			{
+				if (*p == '"' || *p == '\\') std::fputc('\\', p_file);
+				if (static_cast<unsigned char>(*p) >= 0x20) std::fputc(*p, p_file);
+			}
+			std::fputc('"', p_file);
+		}
+	}
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the current tick
+	/// </summary>
+	uint64_t GetTimestamp()
+	{
+#ifdef PROFILER_X86
+		return __rdtsc();
+#else
+		return static_cast<uint64_t>(GetSteadyNanoseconds());
+#endif
+	}
+
+	/// <summary>
+	/// store a zone without locks, only the owner thread writes its ring
+	/// </summary>
+	void Record(_In_ const char* name, _In_ uint64_t begin, _In_ uint64_t end)
+	{
+		ThreadRing* p_ring = t_ring;
+		if (!p_ring)
+		{
+			p_ring = Manager::Instance().RegisterThread();
+			t_ring = p_ring;
+		}
+
+		const uint64_t head = p_ring->Head.load(std::memory_order_relaxed);
+		Event& event = p_ring->Events[head & (RING_CAPACITY - 1)];
+		event.Name  = name;
+		event.Begin = begin;
+		event.End   = end;
+
+		// the export sees the event once the head has moved past it
+		p_ring->Head.store(head + 1, std::memory_order_release);
+	}
+
+	//--------------------------------------------------------
+	// manager
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for profiler
+	/// </summary>
+	Manager::Manager()
+	{
+		_originTicks = GetTimestamp();
+		_originNs    = GetSteadyNanoseconds();
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// creates the ring of the calling thread
+	/// </summary>
+	ThreadRing* Manager::RegisterThread()
+	{
+		std::unique_ptr<ThreadRing> ring = std::make_unique<ThreadRing>();
+		ring->Head.store(0, std::memory_order_relaxed);
+		ring->ThreadName = nullptr;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		ring->ThreadIndex = static_cast<uint32_t>(_rings.size());
+		_rings.push_back(std::move(ring));
+
+		return _rings.back().get();
+	}
+
+	/// <summary>
+	/// name the calling thread in the trace (string literal)
+	/// </summary>
+	void Manager::SetThreadName(_In_ const char* name)
+	{
+		if (!t_ring) t_ring = RegisterThread();
+
+		t_ring->ThreadName = name;
+	}
+
+	/// <summary>
+	/// write the trace, one complete event ("X") per zone with microsecond timestamps
+	/// </summary>
+	int Manager::WriteChromeTrace(_In_ const char* path)
+	{
+		FILE* p_file = std::fopen(path, "w");
+		if (!p_file)
+			return -1;
+
+		// ticks per nanosecond from the origin to now
+		const uint64_t now_ticks = GetTimestamp();
+		const int64_t now_ns     = GetSteadyNanoseconds();
+		const double ns_per_tick = (now_ticks > _originTicks && now_ns > _originNs)
+			? static_cast<double>(now_ns - _originNs) / static_cast<double>(now_ticks - _originTicks) : 1.0;
+
+		auto to_us = [&](uint64_t ticks)
+		{
+			return static_cast<double>(static_cast<int64_t>(ticks - _originTicks)) * ns_per_tick * 1e-3;
+		};
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		std::fprintf(p_file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+		bool is_first = true;
+		for (const std::unique_ptr<ThreadRing>& ring : _rings)
+		{
+			if (ring->ThreadName)
+			{
+				std::fprintf(p_file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+					is_first ? "" : ",\n", ring->ThreadIndex);
+				WriteJsonString(p_file, ring->ThreadName);
+				std::fprintf(p_file, "}}");
+				is_first = false;
+			}
+
+			const uint64_t head  = ring->Head.load(std::memory_order_acquire);
+			const uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+			for (uint64_t i = first; i < head; ++i)
+			{
+				const Event& event = ring->Events[i & (RING_CAPACITY - 1)];
+
+				std::fprintf(p_file, "%s{\"ph\":\"X\",\"name\":", is_first ? "" : ",\n");
+				WriteJsonString(p_file, event.Name);
+				std::fprintf(p_file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					ring->ThreadIndex, to_us(event.Begin), std::max(to_us(event.End) - to_us(event.Begin), 0.0));
+				is_first = false;
+			}
+		}
+		std::fprintf(p_file, "\n]}\n");
+
+		return std::fclose(p_file) == 0 ? 0 : -1;
+	}
+
+	/// <summary>
+	/// forget the recorded zones, the rings stay registered
+	/// </summary>
+	void Manager::Clear()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (const std::unique_ptr<ThreadRing>& ring : _rings)
+		{
+			ring->Head.store(0, std::memory_order_release);
+		}
+	}
+
+	/// <summary>
+	/// get the number of zones in the rings
+	/// </summary>
+	size_t Manager::GetEventCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		size_t count = 0;
+		for (const std::unique_ptr<ThreadRing>& ring : _rings)
+		{
+			count += static_cast<size_t>(std::min<uint64_t>(ring->Head.load(std::memory_order_acquire), RING_CAPACITY));
+		}
+
+		return count;
+	}
+}
@@ -0,0 +1,140 @@
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "portable_sal.h"
+
+#ifdef _DEBUG
+// the flag for the profiler zones, release builds compile them away unless it is defined in the project
+#define PROFILER_ENABLED
+#endif
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+
+#ifdef PROFILER_ENABLED
+// the name must be a string literal, only the pointer is recorded
+#define PROFILE_SCOPE(name) const Profiler::Zone PROFILER_CONCAT(profiler_zone_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) Profiler::Manager::Instance().SetThreadName(name)
+#define PROFILE_WRITE_TRACE(path) Profiler::Manager::Instance().WriteChromeTrace(path)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_WRITE_TRACE(path)
+#endif
+
+namespace Profiler
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// events kept per thread, the oldest are overwritten (power of 2)
+	constexpr uint32_t RING_CAPACITY = 1 << 16;
+
+	// written at the exit, open in chrome://tracing or ui.perfetto.dev
+	constexpr const char* TRACE_FILE_PATH = "profile_trace.json";
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// a closed zone, in ticks of GetTimestamp
+	/// </summary>
+	struct Event
+	{
+		const char* Name;
+		uint64_t Begin;
+		uint64_t End;
+	};
+
+	/// <summary>
+	/// events of one thread, written only by that thread
+	/// </summary>
+	struct ThreadRing
+	{
+		Event Events[RING_CAPACITY];
+		std::atomic<uint64_t> Head;
+		uint32_t ThreadIndex;
+		const char* ThreadName;
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		// rings live until the exit, threads keep a pointer to theirs
+		std::vector<std::unique_ptr<ThreadRing>> _rings;
+		std::mutex _mutex;
+
+		// reference points to convert ticks to nanoseconds
+		uint64_t _originTicks;
+		int64_t _originNs;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		// called once per thread on its first zone
+		ThreadRing* RegisterThread();
+
+		void SetThreadName(_In_ const char* name);
+
+		// write every recorded zone as Chrome trace / Perfetto JSON, call while the threads are idle
+		// returns 0 on success, -1 if the file cannot be written
+		int WriteChromeTrace(_In_ const char* path);
+
+		// drop every recorded zone, call while the threads are idle
+		void Clear();
+
+		// getter
+		size_t GetEventCount();
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// cheapest monotonic counter of the platform (the time stamp counter on x86)
+	uint64_t GetTimestamp();
+
+	// store a zone in the ring of the calling thread
+	void Record(_In_ const char* name, _In_ uint64_t begin, _In_ uint64_t end);
+
+	//--------------------------------------------------------
+	// zone class
+	//--------------------------------------------------------
+	/// <summary>
+	/// records the time from the construction to the destruction
+	/// </summary>
+	class Zone
+	{
+		const char* _name;
+		uint64_t _begin;
+
+	public:
+		explicit Zone(_In_ const char* name)
+		{
+			_name  = name;
+			_begin = GetTimestamp();
+		}
+
+		~Zone()
+		{
+			Record(_name, _begin, GetTimestamp());
+		}
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+	};
+}
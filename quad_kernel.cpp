@@ -0,0 +1,803 @@
+
+#include <cmath>
+#include <cstring>
+
+#include "quad_kernel.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define QUAD_KERNEL_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// avx2 functions are compiled for the target even if the rest of the file is not
+// (f16c converts the half floats of the instances, every cpu with avx2 has it)
+#if defined(QUAD_KERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define QUAD_KERNEL_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#else
+#define QUAD_KERNEL_TARGET_AVX2
+#endif
+
+namespace QuadKernel
+{
+	using SpriteBatch::QuadVertex;
+	using SpriteBatch::SpriteInstance;
+
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		// minimax polynomial for sine and cosine on [-pi/4, pi/4] (cephes)
+		constexpr float SIN_C0 = -1.9515295891e-4f;
+		constexpr float SIN_C1 =  8.3321608736e-3f;
+		constexpr float SIN_C2 = -1.6666654611e-1f;
+		constexpr float COS_C0 =  2.443315711809948e-5f;
+		constexpr float COS_C1 = -1.388731625493765e-3f;
+		constexpr float COS_C2 =  4.166664568298827e-2f;
+
+		// pi/2 split in three parts for the Cody-Waite range reduction
+		constexpr float TWO_OVER_PI = 0.636619772367581343f;
+		constexpr float PIO2_1 = 1.5703125f;
+		constexpr float PIO2_2 = 4.837512969970703125e-4f;
+		constexpr float PIO2_3 = 7.54978995489188216e-8f;
+
+		// packing of the instances
+		constexpr float PI         = 3.14159265358979f;
+		constexpr float TWO_PI     = 6.28318530717959f;
+		constexpr float INV_TWO_PI = 0.159154943091895f;
+		constexpr float SNORM16_MAX    = 32767.0f;
+		constexpr float ROTATION_SCALE = SNORM16_MAX / PI;
+		constexpr float UNORM16_MAX    = 65535.0f;
+		constexpr float UNORM8_MAX     = 255.0f;
+		constexpr uint32_t TEXTURE_INDEX_MAX = 0xffff;
+
+		/// <summary>
+		/// write 4 vertices of one sprite from its corner positions
+		/// </summary>
+		inline void WriteQuad(QuadVertex* p_vertex, const float (&x)[4], const float (&y)[4], const SpriteArrays& sprites, size_t i)
+		{
+			const float u0 = sprites.TexcoordU[i];
+			const float v0 = sprites.TexcoordV[i];
+			const float u1 = u0 + sprites.TexSizeU[i];
+			const float v1 = v0 + sprites.TexSizeV[i];
+			const float uv[4][2] = { { u0, v0 }, { u1, v0 }, { u0, v1 }, { u1, v1 } };
+
+			const float r = sprites.ColorR[i];
+			const float g = sprites.ColorG[i];
+			const float b = sprites.ColorB[i];
+			const float a = sprites.ColorA[i];
+
+			for (int c = 0; c < 4; ++c)
+			{
+				QuadVertex& vertex = p_vertex[c];
+
+				vertex.Position[0] = x[c];
+				vertex.Position[1] = y[c];
+				vertex.Position[2] = 0.0f;
+
+				vertex.Normal[0] = 0.0f;
+				vertex.Normal[1] = 0.0f;
+				vertex.Normal[2] = 0.0f;
+
+				vertex.Color[0] = r;
+				vertex.Color[1] = g;
+				vertex.Color[2] = b;
+				vertex.Color[3] = a;
+
+				vertex.Texcoord[0] = uv[c][0];
+				vertex.Texcoord[1] = uv[c][1];
+			}
+		}
+
+		/// <summary>
+		/// scalar kernel for the range [begin, end)
+		/// </summary>
+		void GenerateQuadsScalar(const SpriteArrays& sprites, QuadVertex* p_vertex, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				float s, c;
+				SinCos(sprites.Rotation[i], &s, &c);
+
+				const float hx = sprites.ScaleX[i] * 0.5f;
+				const float hy = sprites.ScaleY[i] * 0.5f;
+				const float px = sprites.PositionX[i];
+				const float py = sprites.PositionY[i];
+
+				// corners (-hx,-hy) (hx,-hy) (-hx,hy) (hx,hy) rotated around the center
+				const float ax = hx * c, by = hy * s;
+				const float dx = hx * s, ey = hy * c;
+
+				const float x[4] = { px - ax + by, px + ax + by, px - ax - by, px + ax - by };
+				const float y[4] = { py - dx - ey, py + dx - ey, py - dx + ey, py + dx + ey };
+
+				WriteQuad(&p_vertex[i * SpriteBatch::VERTICES_PER_QUAD], x, y, sprites, i);
+			}
+		}
+
+		/// <summary>
+		/// clamp to [0, 1] and convert to an unsigned normalized integer
+		/// the comparisons are the same as the simd min and max, so a nan becomes 0 in every kernel
+		/// </summary>
+		inline uint32_t PackUnorm(float value, float scale)
+		{
+			value = (value > 0.0f) ? value : 0.0f;
+			value = (value < 1.0f) ? value : 1.0f;
+			return static_cast<uint32_t>(std::nearbyint(value * scale));
+		}
+
+		/// <summary>
+		/// wrap an angle to [-pi, pi] and convert it to snorm16 of the angle over pi
+		/// </summary>
+		inline int16_t PackRotation(float angle)
+		{
+			const float turns = std::nearbyint(angle * INV_TWO_PI);
+			float value = (angle - turns * TWO_PI) * ROTATION_SCALE;
+			value = (value > -SNORM16_MAX) ? value : -SNORM16_MAX;
+			value = (value <  SNORM16_MAX) ? value :  SNORM16_MAX;
+			return static_cast<int16_t>(std::nearbyint(value));
+		}
+
+		/// <summary>
+		/// scalar packing for the range [begin, end)
+		/// </summary>
+		void PackInstancesScalar(const SpriteArrays& sprites, const uint32_t* p_textures, SpriteInstance* p_instance, size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				SpriteInstance& instance = p_instance[i];
+
+				instance.Position[0] = sprites.PositionX[i];
+				instance.Position[1] = sprites.PositionY[i];
+				instance.Scale[0]    = FloatToHalf(sprites.ScaleX[i]);
+				instance.Scale[1]    = FloatToHalf(sprites.ScaleY[i]);
+				instance.Rotation    = PackRotation(sprites.Rotation[i]);
+				instance.Texture     = static_cast<uint16_t>(p_textures[i] < TEXTURE_INDEX_MAX ? p_textures[i] : TEXTURE_INDEX_MAX);
+
+				const float u0 = sprites.TexcoordU[i];
+				const float v0 = sprites.TexcoordV[i];
+				instance.UvRect[0] = static_cast<uint16_t>(PackUnorm(u0, UNORM16_MAX));
+				instance.UvRect[1] = static_cast<uint16_t>(PackUnorm(v0, UNORM16_MAX));
+				instance.UvRect[2] = static_cast<uint16_t>(PackUnorm(u0 + sprites.TexSizeU[i], UNORM16_MAX));
+				instance.UvRect[3] = static_cast<uint16_t>(PackUnorm(v0 + sprites.TexSizeV[i], UNORM16_MAX));
+
+				instance.Color = PackUnorm(sprites.ColorR[i], UNORM8_MAX)
+					| (PackUnorm(sprites.ColorG[i], UNORM8_MAX) << 8)
+					| (PackUnorm(sprites.ColorB[i], UNORM8_MAX) << 16)
+					| (PackUnorm(sprites.ColorA[i], UNORM8_MAX) << 24);
+				instance.Material = 0;
+			}
+		}
+
+#ifdef QUAD_KERNEL_X86
+		/// <summary>
+		/// sse2 kernel, 4 sprites per iteration
+		/// </summary>
+		size_t GenerateQuadsSse2(const SpriteArrays& sprites, QuadVertex* p_vertex)
+		{
+			const size_t count = sprites.Count & ~static_cast<size_t>(3);
+
+			const __m128i one_i  = _mm_set1_epi32(1);
+			const __m128i two_i  = _mm_set1_epi32(2);
+			const __m128  half   = _mm_set1_ps(0.5f);
+			const __m128  one    = _mm_set1_ps(1.0f);
+
+			alignas(16) float cx[4][4];
+			alignas(16) float cy[4][4];
+
+			for (size_t i = 0; i < count; i += 4)
+			{
+				//-----------------------------------
+				// sincos
+				//-----------------------------------
+				__m128 angle = _mm_loadu_ps(&sprites.Rotation[i]);
+				__m128i j = _mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(TWO_OVER_PI)));
+				__m128 jf = _mm_cvtepi32_ps(j);
+
+				__m128 r = _mm_sub_ps(angle, _mm_mul_ps(jf, _mm_set1_ps(PIO2_1)));
+				r = _mm_sub_ps(r, _mm_mul_ps(jf, _mm_set1_ps(PIO2_2)));
+				r = _mm_sub_ps(r, _mm_mul_ps(jf, _mm_set1_ps(PIO2_3)));
+				__m128 z = _mm_mul_ps(r, r);
+
+				__m128 sin_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_C0), z), _mm_set1_ps(SIN_C1));
+				sin_r = _mm_add_ps(_mm_mul_ps(sin_r, z), _mm_set1_ps(SIN_C2));
+				sin_r = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(sin_r, z), r));
+
+				__m128 cos_r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_C0), z), _mm_set1_ps(COS_C1));
+				cos_r = _mm_add_ps(_mm_mul_ps(cos_r, z), _mm_set1_ps(COS_C2));
+				cos_r = _mm_add_ps(_mm_sub_ps(one, _mm_mul_ps(half, z)), _mm_mul_ps(_mm_mul_ps(cos_r, z), z));
+
+				// quadrant: swap on odd, then apply signs
+				__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, one_i), one_i));
+				__m128 s = _mm_or_ps(_mm_and_ps(swap, cos_r), _mm_andnot_ps(swap, sin_r));
+				__m128 c = _mm_or_ps(_mm_and_ps(swap, sin_r), _mm_andnot_ps(swap, cos_r));
+				s = _mm_xor_ps(s, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, two_i), 30)));
+				c = _mm_xor_ps(c, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, one_i), two_i), 30)));
+
+				//-----------------------------------
+				// corners
+				//-----------------------------------
+				__m128 hx = _mm_mul_ps(_mm_loadu_ps(&sprites.ScaleX[i]), half);
+				__m128 hy = _mm_mul_ps(_mm_loadu_ps(&sprites.ScaleY[i]), half);
+				__m128 px = _mm_loadu_ps(&sprites.PositionX[i]);
+				__m128 py = _mm_loadu_ps(&sprites.PositionY[i]);
+
+				__m128 ax = _mm_mul_ps(hx, c), by = _mm_mul_ps(hy, s);
+				__m128 dx = _mm_mul_ps(hx, s), ey = _mm_mul_ps(hy, c);
+
+				__m128 x_minus = _mm_sub_ps(px, ax), x_plus = _mm_add_ps(px, ax);
+				__m128 y_minus = _mm_sub_ps(py, dx), y_plus = _mm_add_ps(py, dx);
+
+				_mm_store_ps(cx[0], _mm_add_ps(x_minus, by));
+				_mm_store_ps(cx[1], _mm_add_ps(x_plus,  by));
+				_mm_store_ps(cx[2], _mm_sub_ps(x_minus, by));
+				_mm_store_ps(cx[3], _mm_sub_ps(x_plus,  by));
+
+				_mm_store_ps(cy[0], _mm_sub_ps(y_minus, ey));
+				_mm_store_ps(cy[1], _mm_sub_ps(y_plus,  ey));
+				_mm_store_ps(cy[2], _mm_add_ps(y_minus, ey));
+				_mm_store_ps(cy[3], _mm_add_ps(y_plus,  ey));
+
+				// transpose to array-of-structures vertices
+				for (size_t k = 0; k < 4; ++k)
+				{
+					const float x[4] = { cx[0][k], cx[1][k], cx[2][k], cx[3][k] };
+					const float y[4] = { cy[0][k], cy[1][k], cy[2][k], cy[3][k] };
+					WriteQuad(&p_vertex[(i + k) * SpriteBatch::VERTICES_PER_QUAD], x, y, sprites, i + k);
+				}
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// convert 4 floats to half floats in the low 16 bits of each lane, rounded to nearest even
+		/// </summary>
+		inline __m128i FloatToHalfSse2(__m128 value)
+		{
+			__m128i bits = _mm_castps_si128(value);
+			const __m128i sign = _mm_and_si128(_mm_srli_epi32(bits, 16), _mm_set1_epi32(0x8000));
+			bits = _mm_and_si128(bits, _mm_set1_epi32(0x7fffffff));
+
+			// too large for a half float, or a nan
+			const __m128i is_infinity = _mm_cmpgt_epi32(bits, _mm_set1_epi32(0x477fffff));
+			const __m128i is_nan      = _mm_cmpgt_epi32(bits, _mm_set1_epi32(0x7f800000));
+			const __m128i infinity    = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(is_nan, _mm_set1_epi32(0x0200)));
+
+			// subnormal: the addition aligns the mantissa and rounds it
+			const __m128i is_subnormal = _mm_cmplt_epi32(bits, _mm_set1_epi32(0x38800000));
+			const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_set1_ps(0.5f))), _mm_set1_epi32(0x3f000000));
+
+			// normal: rebias the exponent and round the mantissa to nearest even
+			const __m128i odd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+			const __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(bits, _mm_set1_epi32(static_cast<int>(0xc8000fff))), odd), 13);
+
+			__m128i half = _mm_or_si128(_mm_and_si128(is_subnormal, subnormal), _mm_andnot_si128(is_subnormal, normal));
+			half = _mm_or_si128(_mm_and_si128(is_infinity, infinity), _mm_andnot_si128(is_infinity, half));
+			return _mm_or_si128(half, sign);
+		}
+
+		/// <summary>
+		/// clamp 4 floats to [0, 1] and convert them to unsigned normalized integers
+		/// </summary>
+		inline __m128i PackUnormSse2(__m128 value, __m128 scale)
+		{
+			value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+			return _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+		}
+
+		/// <summary>
+		/// sse2 packing, 4 sprites per iteration
+		/// </summary>
+		size_t PackInstancesSse2(const SpriteArrays& sprites, const uint32_t* p_textures, SpriteInstance* p_instance)
+		{
+			const size_t count = sprites.Count & ~static_cast<size_t>(3);
+
+			const __m128  unorm16     = _mm_set1_ps(UNORM16_MAX);
+			const __m128  unorm8      = _mm_set1_ps(UNORM8_MAX);
+			const __m128i low_16      = _mm_set1_epi32(0xffff);
+			const __m128i texture_max = _mm_set1_epi32(static_cast<int>(TEXTURE_INDEX_MAX));
+
+			for (size_t i = 0; i < count; i += 4)
+			{
+				//-----------------------------------
+				// transform
+				//-----------------------------------
+				const __m128i scale = _mm_or_si128(FloatToHalfSse2(_mm_loadu_ps(&sprites.ScaleX[i])),
+					_mm_slli_epi32(FloatToHalfSse2(_mm_loadu_ps(&sprites.ScaleY[i])), 16));
+
+				const __m128 angle = _mm_loadu_ps(&sprites.Rotation[i]);
+				const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(INV_TWO_PI))));
+				__m128 rotation = _mm_mul_ps(_mm_sub_ps(angle, _mm_mul_ps(turns, _mm_set1_ps(TWO_PI))), _mm_set1_ps(ROTATION_SCALE));
+				rotation = _mm_min_ps(_mm_max_ps(rotation, _mm_set1_ps(-SNORM16_MAX)), _mm_set1_ps(SNORM16_MAX));
+
+				// the texture index saturates when it does not fit in 16 bits
+				const __m128i texture = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&p_textures[i]));
+				const __m128i is_small = _mm_cmpeq_epi32(_mm_srli_epi32(texture, 16), _mm_setzero_si128());
+				const __m128i texture_index = _mm_or_si128(_mm_and_si128(is_small, texture), _mm_andnot_si128(is_small, texture_max));
+
+				const __m128i rotation_texture = _mm_or_si128(_mm_and_si128(_mm_cvtps_epi32(rotation), low_16), _mm_slli_epi32(texture_index, 16));
+
+				//-----------------------------------
+				// uv rect and color
+				//-----------------------------------
+				const __m128 u0 = _mm_loadu_ps(&sprites.TexcoordU[i]);
+				const __m128 v0 = _mm_loadu_ps(&sprites.TexcoordV[i]);
+				const __m128 u1 = _mm_add_ps(u0, _mm_loadu_ps(&sprites.TexSizeU[i]));
+				const __m128 v1 = _mm_add_ps(v0, _mm_loadu_ps(&sprites.TexSizeV[i]));
+
+				const __m128i uv0 = _mm_or_si128(PackUnormSse2(u0, unorm16), _mm_slli_epi32(PackUnormSse2(v0, unorm16), 16));
+				const __m128i uv1 = _mm_or_si128(PackUnormSse2(u1, unorm16), _mm_slli_epi32(PackUnormSse2(v1, unorm16), 16));
+
+				__m128i color = PackUnormSse2(_mm_loadu_ps(&sprites.ColorR[i]), unorm8);
+				color = _mm_or_si128(color, _mm_slli_epi32(PackUnormSse2(_mm_loadu_ps(&sprites.ColorG[i]), unorm8), 8));
+				color = _mm_or_si128(color, _mm_slli_epi32(PackUnormSse2(_mm_loadu_ps(&sprites.ColorB[i]), unorm8), 16));
+				color = _mm_or_si128(color, _mm_slli_epi32(PackUnormSse2(_mm_loadu_ps(&sprites.ColorA[i]), unorm8), 24));
+
+				//-----------------------------------
+				// transpose to array-of-structures instances, each is two rows of 4 words
+				//-----------------------------------
+				__m128 low0 = _mm_loadu_ps(&sprites.PositionX[i]);
+				__m128 low1 = _mm_loadu_ps(&sprites.PositionY[i]);
+				__m128 low2 = _mm_castsi128_ps(scale);
+				__m128 low3 = _mm_castsi128_ps(rotation_texture);
+				_MM_TRANSPOSE4_PS(low0, low1, low2, low3);
+
+				__m128 high0 = _mm_castsi128_ps(uv0);
+				__m128 high1 = _mm_castsi128_ps(uv1);
+				__m128 high2 = _mm_castsi128_ps(color);
+				__m128 high3 = _mm_setzero_ps();
+				_MM_TRANSPOSE4_PS(high0, high1, high2, high3);
+
+				float* p_out = reinterpret_cast<float*>(&p_instance[i]);
+				_mm_storeu_ps(p_out +  0, low0);
+				_mm_storeu_ps(p_out +  4, high0);
+				_mm_storeu_ps(p_out +  8, low1);
+				_mm_storeu_ps(p_out + 12, high1);
+				_mm_storeu_ps(p_out + 16, low2);
+				_mm_storeu_ps(p_out + 20, high2);
+				_mm_storeu_ps(p_out + 24, low3);
+				_mm_storeu_ps(p_out + 28, high3);
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// avx2 kernel, 8 sprites per iteration
+		/// </summary>
+		QUAD_KERNEL_TARGET_AVX2
+		size_t GenerateQuadsAvx2(const SpriteArrays& sprites, QuadVertex* p_vertex)
+		{
+			const size_t count = sprites.Count & ~static_cast<size_t>(7);
+
+			const __m256i one_i = _mm256_set1_epi32(1);
+			const __m256i two_i = _mm256_set1_epi32(2);
+			const __m256  half  = _mm256_set1_ps(0.5f);
+			const __m256  one   = _mm256_set1_ps(1.0f);
+
+			alignas(32) float cx[4][8];
+			alignas(32) float cy[4][8];
+
+			for (size_t i = 0; i < count; i += 8)
+			{
+				//-----------------------------------
+				// sincos
+				//-----------------------------------
+				__m256 angle = _mm256_loadu_ps(&sprites.Rotation[i]);
+				__m256i j = _mm256_cvtps_epi32(_mm256_mul_ps(angle, _mm256_set1_ps(TWO_OVER_PI)));
+				__m256 jf = _mm256_cvtepi32_ps(j);
+
+				__m256 r = _mm256_sub_ps(angle, _mm256_mul_ps(jf, _mm256_set1_ps(PIO2_1)));
+				r = _mm256_sub_ps(r, _mm256_mul_ps(jf, _mm256_set1_ps(PIO2_2)));
+				r = _mm256_sub_ps(r, _mm256_mul_ps(jf, _mm256_set1_ps(PIO2_3)));
+				__m256 z = _mm256_mul_ps(r, r);
+
+				__m256 sin_r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(SIN_C0), z), _mm256_set1_ps(SIN_C1));
+				sin_r = _mm256_add_ps(_mm256_mul_ps(sin_r, z), _mm256_set1_ps(SIN_C2));
+				sin_r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(sin_r, z), r));
+
+				__m256 cos_r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(COS_C0), z), _mm256_set1_ps(COS_C1));
+				cos_r = _mm256_add_ps(_mm256_mul_ps(cos_r, z), _mm256_set1_ps(COS_C2));
+				cos_r = _mm256_add_ps(_mm256_sub_ps(one, _mm256_mul_ps(half, z)), _mm256_mul_ps(_mm256_mul_ps(cos_r, z), z));
+
+				// quadrant: swap on odd, then apply signs
+				__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, one_i), one_i));
+				__m256 s = _mm256_blendv_ps(sin_r, cos_r, swap);
+				__m256 c = _mm256_blendv_ps(cos_r, sin_r, swap);
+				s = _mm256_xor_ps(s, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, two_i), 30)));
+				c = _mm256_xor_ps(c, _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(j, one_i), two_i), 30)));
+
+				//-----------------------------------
+				// corners
+				//-----------------------------------
+				__m256 hx = _mm256_mul_ps(_mm256_loadu_ps(&sprites.ScaleX[i]), half);
+				__m256 hy = _mm256_mul_ps(_mm256_loadu_ps(&sprites.ScaleY[i]), half);
+				__m256 px = _mm256_loadu_ps(&sprites.PositionX[i]);
+				__m256 py = _mm256_loadu_ps(&sprites.PositionY[i]);
+
+				__m256 ax = _mm256_mul_ps(hx, c), by = _mm256_mul_ps(hy, s);
+				__m256 dx = _mm256_mul_ps(hx, s), ey = _mm256_mul_ps(hy, c);
+
+				__m256 x_minus = _mm256_sub_ps(px, ax), x_plus = _mm256_add_ps(px, ax);
+				__m256 y_minus = _mm256_sub_ps(py, dx), y_plus = _mm256_add_ps(py, dx);
+
+				_mm256_store_ps(cx[0], _mm256_add_ps(x_minus, by));
+				_mm256_store_ps(cx[1], _mm256_add_ps(x_plus,  by));
+				_mm256_store_ps(cx[2], _mm256_sub_ps(x_minus, by));
+				_mm256_store_ps(cx[3], _mm256_sub_ps(x_plus,  by));
+
+				_mm256_store_ps(cy[0], _mm256_sub_ps(y_minus, ey));
+				_mm256_store_ps(cy[1], _mm256_sub_ps(y_plus,  ey));
+				_mm256_store_ps(cy[2], _mm256_add_ps(y_minus, ey));
+				_mm256_store_ps(cy[3], _mm256_add_ps(y_plus,  ey));
+
+				// transpose to array-of-structures vertices
+				for (size_t k = 0; k < 8; ++k)
+				{
+					const float x[4] = { cx[0][k], cx[1][k], cx[2][k], cx[3][k] };
+					const float y[4] = { cy[0][k], cy[1][k], cy[2][k], cy[3][k] };
+					WriteQuad(&p_vertex[(i + k) * SpriteBatch::VERTICES_PER_QUAD], x, y, sprites, i + k);
+				}
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// clamp 8 floats to [0, 1] and convert them to unsigned normalized integers
+		/// </summary>
+		QUAD_KERNEL_TARGET_AVX2
+		inline __m256i PackUnormAvx2(__m256 value, __m256 scale)
+		{
+			value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+			return _mm256_cvtps_epi32(_mm256_mul_ps(value, scale));
+		}
+
+		/// <summary>
+		/// convert 8 floats to half floats in the low 16 bits of each lane
+		/// </summary>
+		QUAD_KERNEL_TARGET_AVX2
+		inline __m256i FloatToHalfAvx2(__m256 value)
+		{
+			return _mm256_cvtepu16_epi32(_mm256_cvtps_ph(value, _MM_FROUND_TO_NEAREST_INT));
+		}
+
+		/// <summary>
+		/// transpose the 4x4 words in each 128-bit lane
+		/// </summary>
+		QUAD_KERNEL_TARGET_AVX2
+		inline void TransposeLanesAvx2(__m256& row0, __m256& row1, __m256& row2, __m256& row3)
+		{
+			const __m256 t0 = _mm256_unpacklo_ps(row0, row1);
+			const __m256 t1 = _mm256_unpackhi_ps(row0, row1);
+			const __m256 t2 = _mm256_unpacklo_ps(row2, row3);
+			const __m256 t3 = _mm256_unpackhi_ps(row2, row3);
+
+			row0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			row1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			row2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			row3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+
+		/// <summary>
+		/// avx2 packing, 8 sprites per iteration
+		/// </summary>
+		QUAD_KERNEL_TARGET_AVX2
+		size_t PackInstancesAvx2(const SpriteArrays& sprites, const uint32_t* p_textures, SpriteInstance* p_instance)
+		{
+			const size_t count = sprites.Count & ~static_cast<size_t>(7);
+
+			const __m256  unorm16     = _mm256_set1_ps(UNORM16_MAX);
+			const __m256  unorm8      = _mm256_set1_ps(UNORM8_MAX);
+			const __m256i low_16      = _mm256_set1_epi32(0xffff);
+			const __m256i texture_max = _mm256_set1_epi32(static_cast<int>(TEXTURE_INDEX_MAX));
+
+			for (size_t i = 0; i < count; i += 8)
+			{
+				//-----------------------------------
+				// transform
+				//-----------------------------------
+				const __m256i scale = _mm256_or_si256(FloatToHalfAvx2(_mm256_loadu_ps(&sprites.ScaleX[i])),
+					_mm256_slli_epi32(FloatToHalfAvx2(_mm256_loadu_ps(&sprites.ScaleY[i])), 16));
+
+				const __m256 angle = _mm256_loadu_ps(&sprites.Rotation[i]);
+				const __m256 turns = _mm256_cvtepi32_ps(_mm256_cvtps_epi32(_mm256_mul_ps(angle, _mm256_set1_ps(INV_TWO_PI))));
+				__m256 rotation = _mm256_mul_ps(_mm256_sub_ps(angle, _mm256_mul_ps(turns, _mm256_set1_ps(TWO_PI))), _mm256_set1_ps(ROTATION_SCALE));
+				rotation = _mm256_min_ps(_mm256_max_ps(rotation, _mm256_set1_ps(-SNORM16_MAX)), _mm256_set1_ps(SNORM16_MAX));
+
+				const __m256i texture = _mm256_min_epu32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&p_textures[i])), texture_max);
+				const __m256i rotation_texture = _mm256_or_si256(_mm256_and_si256(_mm256_cvtps_epi32(rotation), low_16), _mm256_slli_epi32(texture, 16));
+
+				//-----------------------------------
+				// uv rect and color
+				//-----------------------------------
+				const __m256 u0 = _mm256_loadu_ps(&sprites.TexcoordU[i]);
+				const __m256 v0 = _mm256_loadu_ps(&sprites.TexcoordV[i]);
+				const __m256 u1 = _mm256_add_ps(u0, _mm256_loadu_ps(&sprites.TexSizeU[i]));
+				const __m256 v1 = _mm256_add_ps(v0, _mm256_loadu_ps(&sprites.TexSizeV[i]));
+
+				const __m256i uv0 = _mm256_or_si256(PackUnormAvx2(u0, unorm16), _mm256_slli_epi32(PackUnormAvx2(v0, unorm16), 16));
+				const __m256i uv1 = _mm256_or_si256(PackUnormAvx2(u1, unorm16), _mm256_slli_epi32(PackUnormAvx2(v1, unorm16), 16));
+
+				__m256i color = PackUnormAvx2(_mm256_loadu_ps(&sprites.ColorR[i]), unorm8);
+				color = _mm256_or_si256(color, _mm256_slli_epi32(PackUnormAvx2(_mm256_loadu_ps(&sprites.ColorG[i]), unorm8), 8));
+				color = _mm256_or_si256(color, _mm256_slli_epi32(PackUnormAvx2(_mm256_loadu_ps(&sprites.ColorB[i]), unorm8), 16));
+				color = _mm256_or_si256(color, _mm256_slli_epi32(PackUnormAvx2(_mm256_loadu_ps(&sprites.ColorA[i]), unorm8), 24));
+
+				//-----------------------------------
+				// transpose to array-of-structures instances
+				// the low lanes hold the sprites i..i+3 and the high lanes i+4..i+7
+				//-----------------------------------
+				__m256 low[4]  = { _mm256_loadu_ps(&sprites.PositionX[i]), _mm256_loadu_ps(&sprites.PositionY[i]), _mm256_castsi256_ps(scale), _mm256_castsi256_ps(rotation_texture) };
+				__m256 high[4] = { _mm256_castsi256_ps(uv0), _mm256_castsi256_ps(uv1), _mm256_castsi256_ps(color), _mm256_setzero_ps() };
+				TransposeLanesAvx2(low[0], low[1], low[2], low[3]);
+				TransposeLanesAvx2(high[0], high[1], high[2], high[3]);
+
+				for (size_t k = 0; k < 4; ++k)
+				{
+					_mm256_storeu_ps(reinterpret_cast<float*>(&p_instance[i + k]),     _mm256_permute2f128_ps(low[k], high[k], 0x20));
+					_mm256_storeu_ps(reinterpret_cast<float*>(&p_instance[i + k + 4]), _mm256_permute2f128_ps(low[k], high[k], 0x31));
+				}
+			}
+
+			return count;
+		}
+
+		/// <summary>
+		/// check the cpu and the os support avx2 and f16c
+		/// </summary>
+		bool IsAvx2Supported()
+		{
+#ifdef _MSC_VER
+			int info[4] = {};
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+
+			// the os must save the ymm registers
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx     = (info[2] & (1 << 28)) != 0;
+			const bool f16c    = (info[2] & (1 << 29)) != 0;
+			if (!osxsave || !avx || !f16c) return false;
+			if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") != 0 && __builtin_cpu_supports("f16c") != 0;
+#endif
+		}
+#endif
+	}
+
+	/// <summary>
+	/// single precision sine and cosine with one range reduction
+	/// </summary>
+	void SinCos(_In_ float angle, _Out_ float* p_sin, _Out_ float* p_cos)
+	{
+		// reduce to [-pi/4, pi/4] and the quadrant
+		const int j = static_cast<int>(std::nearbyint(angle * TWO_OVER_PI));
+		const float jf = static_cast<float>(j);
+		const float r = ((angle - jf * PIO2_1) - jf * PIO2_2) - jf * PIO2_3;
+		const float z = r * r;
+
+		float s = r + r * z * ((SIN_C0 * z + SIN_C1) * z + SIN_C2);
+		float c = 1.0f - 0.5f * z + z * z * ((COS_C0 * z + COS_C1) * z + COS_C2);
+
+		if (j & 1)
+		{
+			const float t = s;
+			s = c;
+			c = t;
+		}
+		if (j & 2)       s = -s;
+		if ((j + 1) & 2) c = -c;
+
+		*p_sin = s;
+		*p_cos = c;
+	}
+
+	/// <summary>
+	/// get the best instruction set of this cpu
+	/// </summary>
+	InstructionSet GetBestInstructionSet()
+	{
+#ifdef QUAD_KERNEL_X86
+		static const InstructionSet s_best = IsAvx2Supported() ? InstructionSet::Avx2 : InstructionSet::Sse2;
+		return s_best;
+#else
+		return InstructionSet::Scalar;
+#endif
+	}
+
+	/// <summary>
+	/// get the name of instruction set
+	/// </summary>
+	const char* GetInstructionSetName(_In_ InstructionSet set)
+	{
+		switch (set)
+		{
+		case InstructionSet::Sse2: return "sse2";
+		case InstructionSet::Avx2: return "avx2";
+		default:                   return "scalar";
+		}
+	}
+
+	/// <summary>
+	/// generates quads with the best instruction set
+	/// </summary>
+	void GenerateQuads(_In_ const SpriteArrays& sprites, _Out_ QuadVertex* p_vertex)
+	{
+		GenerateQuads(sprites, p_vertex, GetBestInstructionSet());
+	}
+
+	/// <summary>
+	/// generates quads with the specified instruction set
+	/// </summary>
+	void GenerateQuads(_In_ const SpriteArrays& sprites, _Out_ QuadVertex* p_vertex, _In_ InstructionSet set)
+	{
+		size_t done = 0;
+
+#ifdef QUAD_KERNEL_X86
+		if (set == InstructionSet::Avx2 && GetBestInstructionSet() == InstructionSet::Avx2)
+		{
+			done = GenerateQuadsAvx2(sprites, p_vertex);
+		}
+		else if (set != InstructionSet::Scalar)
+		{
+			done = GenerateQuadsSse2(sprites, p_vertex);
+		}
+#else
+		(void)set;
+#endif
+
+		// the remainder
+		GenerateQuadsScalar(sprites, p_vertex, done, sprites.Count);
+	}
+
+	/// <summary>
+	/// packs instances with the best instruction set
+	/// </summary>
+	void PackInstances(_In_ const SpriteArrays& sprites, _In_ const uint32_t* p_textures, _Out_ SpriteInstance* p_instance)
+	{
+		PackInstances(sprites, p_textures, p_instance, GetBestInstructionSet());
+	}
+
+	/// <summary>
+	/// packs instances with the specified instruction set
+	/// </summary>
+	void PackInstances(_In_ const SpriteArrays& sprites, _In_ const uint32_t* p_textures, _Out_ SpriteInstance* p_instance, _In_ InstructionSet set)
+	{
+		size_t done = 0;
+
+#ifdef QUAD_KERNEL_X86
+		if (set == InstructionSet::Avx2 && GetBestInstructionSet() == InstructionSet::Avx2)
+		{
+			done = PackInstancesAvx2(sprites, p_textures, p_instance);
+		}
+		else if (set != InstructionSet::Scalar)
+		{
+			done = PackInstancesSse2(sprites, p_textures, p_instance);
+		}
+#else
+		(void)set;
+#endif
+
+		// the remainder
+		PackInstancesScalar(sprites, p_textures, p_instance, done, sprites.Count);
+	}
+
+	/// <summary>
+	/// expands an instance into 4 vertices, the same as vertex_shader.hlsl
+	/// </summary>
+	void ExpandInstance(_In_ const SpriteInstance& instance, _Out_ QuadVertex* p_vertex)
+	{
+		const float hx = HalfToFloat(instance.Scale[0]) * 0.5f;
+		const float hy = HalfToFloat(instance.Scale[1]) * 0.5f;
+
+		// snorm16 maps -32768 and -32767 to -1
+		const float rotation = static_cast<float>(instance.Rotation) / SNORM16_MAX;
+		float s, c;
+		SinCos((rotation > -1.0f ? rotation : -1.0f) * PI, &s, &c);
+
+		const float uv[4] =
+		{
+			instance.UvRect[0] / UNORM16_MAX, instance.UvRect[1] / UNORM16_MAX,
+			instance.UvRect[2] / UNORM16_MAX, instance.UvRect[3] / UNORM16_MAX,
+		};
+
+		for (uint32_t v = 0; v < SpriteBatch::VERTICES_PER_QUAD; ++v)
+		{
+			// corners in triangle-strip order (top-left, top-right, bottom-left, bottom-right)
+			const uint32_t corner_x = v & 1;
+			const uint32_t corner_y = v >> 1;
+			const float ox = corner_x ? hx : -hx;
+			const float oy = corner_y ? hy : -hy;
+
+			QuadVertex& vertex = p_vertex[v];
+
+			vertex.Position[0] = instance.Position[0] + ox * c - oy * s;
+			vertex.Position[1] = instance.Position[1] + ox * s + oy * c;
+			vertex.Position[2] = 0.0f;
+
+			vertex.Normal[0] = 0.0f;
+			vertex.Normal[1] = 0.0f;
+			vertex.Normal[2] = 0.0f;
+
+			for (int k = 0; k < 4; ++k) vertex.Color[k] = ((instance.Color >> (8 * k)) & 0xff) / UNORM8_MAX;
+
+			vertex.Texcoord[0] = corner_x ? uv[2] : uv[0];
+			vertex.Texcoord[1] = corner_y ? uv[3] : uv[1];
+		}
+	}
+
+	/// <summary>
+	/// convert a float to a half float, rounded to nearest even (too large becomes infinity)
+	/// </summary>
+	uint16_t FloatToHalf(_In_ float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		bits &= 0x7fffffff;
+
+		uint32_t half;
+		if (bits >= 0x47800000)
+		{
+			// infinity, or a quiet nan
+			half = (bits > 0x7f800000) ? 0x7e00 : 0x7c00;
+		}
+		else if (bits < 0x38800000)
+		{
+			// subnormal: the addition aligns the mantissa and rounds it
+			float aligned;
+			std::memcpy(&aligned, &bits, sizeof(aligned));
+			aligned += 0.5f;
+			std::memcpy(&half, &aligned, sizeof(half));
+			half -= 0x3f000000;
+		}
+		else
+		{
+			// normal: rebias the exponent and round the mantissa to nearest even
+			half = (bits + 0xc8000fff + ((bits >> 13) & 1)) >> 13;
+		}
+
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	/// <summary>
+	/// convert a half float to a float
+	/// </summary>
+	float HalfToFloat(_In_ uint16_t value)
+	{
+		const uint32_t sign     = static_cast<uint32_t>(value & 0x8000) << 16;
+		const uint32_t exponent = (value >> 10) & 0x1f;
+		const uint32_t mantissa = value & 0x3ff;
+
+		uint32_t bits;
+		if (exponent == 0x1f)
+		{
+			bits = sign | 0x7f800000 | (mantissa << 13);
+		}
+		else if (exponent == 0)
+		{
+			// subnormal or zero, exact in single precision
+			const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+			std::memcpy(&bits, &magnitude, sizeof(bits));
+			bits |= sign;
+		}
+		else
+		{
+			bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		}
+
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+}
@@ -0,0 +1,84 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "portable_sal.h"
+#include "sprite_batch_core.h"
+
+namespace QuadKernel
+{
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// enumeration of instruction sets for the kernel
+	/// </summary>
+	enum class InstructionSet
+	{
+		Scalar,
+		Sse2,
+		Avx2,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// structure-of-arrays input of the kernel
+	/// every array has Count elements
+	/// </summary>
+	struct SpriteArrays
+	{
+		// transform
+		const float* PositionX;
+		const float* PositionY;
+		const float* ScaleX;
+		const float* ScaleY;
+		const float* Rotation;
+
+		// uv rect
+		const float* TexcoordU;
+		const float* TexcoordV;
+		const float* TexSizeU;
+		const float* TexSizeV;
+
+		// color
+		const float* ColorR;
+		const float* ColorG;
+		const float* ColorB;
+		const float* ColorA;
+
+		size_t Count;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// generates 4 vertices per sprite in triangle-strip order with the best instruction set
+	void GenerateQuads(_In_ const SpriteArrays& sprites, _Out_ SpriteBatch::QuadVertex* p_vertex);
+
+	// generates with the specified instruction set (falls back to scalar if unsupported)
+	void GenerateQuads(_In_ const SpriteArrays& sprites, _Out_ SpriteBatch::QuadVertex* p_vertex, _In_ InstructionSet set);
+
+	// packs one instance per sprite for the vertex shader to expand, with the best instruction set
+	// every instruction set writes the same bits, the material is the default one (the registry writes its own)
+	void PackInstances(_In_ const SpriteArrays& sprites, _In_ const uint32_t* p_textures, _Out_ SpriteBatch::SpriteInstance* p_instance);
+	void PackInstances(_In_ const SpriteArrays& sprites, _In_ const uint32_t* p_textures, _Out_ SpriteBatch::SpriteInstance* p_instance, _In_ InstructionSet set);
+
+	// expands an instance into 4 vertices in triangle-strip order, the same as the vertex shader
+	void ExpandInstance(_In_ const SpriteBatch::SpriteInstance& instance, _Out_ SpriteBatch::QuadVertex* p_vertex);
+
+	// half float conversion, rounded to nearest even
+	uint16_t FloatToHalf(_In_ float value);
+	float HalfToFloat(_In_ uint16_t value);
+
+	// single precision sine and cosine with one range reduction
+	void SinCos(_In_ float angle, _Out_ float* p_sin, _Out_ float* p_cos);
+
+	InstructionSet GetBestInstructionSet();
+	const char* GetInstructionSetName(_In_ InstructionSet set);
+}
@@ -2,6 +2,7 @@
 #include "main.h"
 #include "directx11_wrapper.h"
 #include "renderer.h"
+#include "profiler.h"
 
 namespace Renderer
 {
@@ -12,6 +13,7 @@ namespace Renderer
 	{
 		_device        = nullptr;
 		_deviceContext = nullptr;
+		_deviceContext1 = nullptr;
 
 		_swapChain     = nullptr;
 		_swapChainDesc = {};
@@ -32,8 +34,6 @@ namespace Renderer
 				_rasterizerState[c][f] = {};
 			}
 		}
-		_cullMode = CullMode::Maximum;
-		_fillMode = FillMode::Maximum;
 
 		//-----------------------------------
 		// blend
@@ -42,7 +42,6 @@ namespace Renderer
 		{
 			_blendState[b] = {};
 		}
-		_blendMode = BlendMode::Maximum;
 
 		//-----------------------------------
 		// depth stencil
@@ -51,20 +50,27 @@ namespace Renderer
 		{
 			_depthStencilState[d] = {};
 		}
-		_depthEnableMode = DepthEnebleMode::Maximum;
 
 		_samplerState = nullptr;
 		_inputLayout  = nullptr;
 
 		// shaders
 		_vertexShader = nullptr;
-		_pixelShader  = nullptr;
+		for (ID3D11PixelShader*& p_shader : _pixelShaders) p_shader = nullptr;
+		_isDebugShader = false;
 
-		// constant buffer
-		_constantBufferWorld      = nullptr;
-		_constantBufferView       = nullptr;
-		_constantBufferProjection = nullptr;
-		_constantBufferMaterial   = nullptr;
+		// constant ring
+		_constantRingBuffer = nullptr;
+
+		_transform = {};
+		_transformConstants = {};
+		_isTransform2D = false;
+
+		_camera2D = { { 0.0f, 0.0f }, 1.0f };
+
+		// material table
+		_materialBuffer = nullptr;
+		_materialSrv    = nullptr;
 
 		_viewport = {};
 	}
@@ -100,25 +106,27 @@ namespace Renderer
 		// creates shaders and input-layout
 		CreateShadersAndInputLayout();
 
-		// creates constant buffers
-		CreateConstantBuffers();
+		// creates the constant ring
+		HRESULT h_result = CreateConstantRing();
+		if (FAILED(h_result))
+			return h_result;
+
+		// creates the material table, with the default material
+		h_result = CreateMaterialTable();
+		if (FAILED(h_result))
+			return h_result;
 
 		// viewport
 		SetViewportToRasterizerState();
 
-		// set input-layout to the Input-Assembler stage
-		_deviceContext->IASetInputLayout(_inputLayout);
+		// set shaders, input-layout and states
+		BindPipelineState(CreatePipelineState(GetDefaultPipelineDesc()));
 
-		// set vertex shader
-		_deviceContext->VSSetShader(_vertexShader, nullptr, 0);
-		_deviceContext->VSSetConstantBuffers(0, 1, &_constantBufferWorld);
-		_deviceContext->VSSetConstantBuffers(1, 1, &_constantBufferView);
-		_deviceContext->VSSetConstantBuffers(2, 1, &_constantBufferProjection);
+		// set constant buffers
+		SetMatrixWorldViewProjection2D();
 
-		// set pixel shader
-		_deviceContext->PSSetShader(_pixelShader, nullptr, 0);
-		_deviceContext->PSSetSamplers(0, 1, &_samplerState);
-		_deviceContext->PSSetConstantBuffers(0, 1, &_constantBufferMaterial);
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		SetFrameResourcesToContext(context);
 
 		return S_OK;
 	}
@@ -141,13 +149,25 @@ namespace Renderer
 
 		// shader
 		_vertexShader->Release();
-		_pixelShader ->Release();
+		for (ID3D11PixelShader*& p_shader : _pixelShaders)
+		{
+			if (p_shader) p_shader->Release();
+			p_shader = nullptr;
+		}
+		_shaderCache.Terminate();
+
+		// constant ring
+		_constantRing.Terminate();
+		_constantRingBuffer->Release();
+		_deviceContext1    ->Release();
 
-		// constant buffer
-		_constantBufferWorld      ->Release();
-		_constantBufferView       ->Release();
-		_constantBufferProjection ->Release();
-		_constantBufferMaterial   ->Release();
+		// material table
+		_materialTable.Terminate();
+		_materialSrv   ->Release();
+		_materialBuffer->Release();
+
+		// the cached descriptions refer to the released objects
+		_pipelineStateCache.Clear();
 	}
 
 	/// <summary>
@@ -155,14 +175,21 @@ namespace Renderer
 	/// </summary>
 	void Manager::ClearViews()
 	{
+		PROFILE_SCOPE("Renderer::ClearViews");
+
 		// clear color for back buffer
 		float clear_color[4] = { 0.0f, 1.0f, 0.0f, 1.0 };
 
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+
+		// the materials edited since the last frame, before anything is drawn
+		_materialTable.Flush();
+
 		// clear Render-Target-View
-		_deviceContext->ClearRenderTargetView(_rtv_backbuffer, clear_color);
+		context.ClearRenderTargetView(_rtv_backbuffer, clear_color);
 
 		// clear Depth-Stencil-View
-		_deviceContext->ClearDepthStencilView(_dsv_backbuffer, D3D11_CLEAR_DEPTH, 1.0f, 0);
+		context.ClearDepthStencilView(_dsv_backbuffer, D3D11_CLEAR_DEPTH, 1.0f, 0);
 	}
 
 	/// <summary>
@@ -170,6 +197,14 @@ namespace Renderer
 	/// </summary>
 	void Manager::FlipFrameBuffer()
 	{
+		PROFILE_SCOPE("Renderer::FlipFrameBuffer");
+
 		_swapChain->Present(0, 0);
+
+		_pipelineStateBinder.EndFrame();
+		_constantRing.EndFrame();
+
+		// every subsystem has issued its calls of the frame
+		FrameCounters::Manager::Instance().EndFrame();
 	}
 }
\ No newline at end of file
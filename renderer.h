@@ -6,76 +6,35 @@
 #define DEBUG_HLSL_SHADERS
 #endif
 
+#include "renderer_types.h"
+#include "pipeline_state.h"
+#include "constant_ring.h"
+#include "counted_context.h"
+#include "material_table.h"
+#include "shader_cache.h"
+#include "shader_compiler.h"
+#include "shader_permutation.h"
+
 namespace Renderer
 {
-	//--------------------------------------------------------
-	// constant
-	//--------------------------------------------------------
-	// screen parameter
-	constexpr int SCREEN_SIZE_WIDTH  = 960;
-	constexpr int SCREEN_SIZE_HEIGHT = 540;
-
-	constexpr int SCREEN_RESOLUTION_WIDTH  = 1920;
-	constexpr int SCREEN_RESOLUTION_HEIGHT = 1080;
-
-	//--------------------------------------------------------
-	// enumrator
-	//--------------------------------------------------------
-	/// <summary>
-	/// enumeration of culling modes
-	/// </summary>
-	enum class CullMode
-	{
-		None,
-		Front,
-		Back,
-
-		Maximum
-	};
-
-	/// <summary>
-	/// enumeration of filling modes
-	/// </summary>
-	enum class FillMode
-	{
-		Wireframe,
-		Solid,
-
-		Maximum
-	};
-
-	/// <summary>
-	/// enumeration of blending modes
-	/// </summary>
-	enum class BlendMode
-	{
-		None,
-		Add,
-		Subtract,
-		AlphaBlend,
-
-		Maximum
-	};
-
-	/// <summary>
-	/// enumeration of depth enable mode
-	/// </summary>
-	enum class DepthEnebleMode
-	{
-		Enable,
-		Disable,
-
-		Maximum
-	};
-
 	//--------------------------------------------------------
 	// manager class
 	//--------------------------------------------------------
-	class Manager
+	class Manager : public ConstantRing::Backend, public MaterialTable::Backend
 	{
+		/// <summary>
+		/// constants of the vertex shader (same layout as Transform in shader_header.hlsli)
+		/// </summary>
+		struct TransformConstants
+		{
+			DirectX::XMFLOAT4X4 WorldViewProjection;
+			DirectX::XMFLOAT4X4 World;
+		};
+
 		// device
 		ID3D11Device* _device;
 		ID3D11DeviceContext* _deviceContext;
+		ID3D11DeviceContext1* _deviceContext1;
 
 		// swap chain
 		IDXGISwapChain* _swapChain;
@@ -92,16 +51,12 @@ namespace Renderer
 		ID3D11RasterizerState* _rasterizerState
 			[static_cast<int>(CullMode::Maximum)]
 			[static_cast<int>(FillMode::Maximum)];
-		CullMode _cullMode;
-		FillMode _fillMode;
 
 		// blend
 		ID3D11BlendState* _blendState[static_cast<int>(BlendMode::Maximum)];
-		BlendMode _blendMode;
 
 		// depth stencil
 		ID3D11DepthStencilState* _depthStencilState[static_cast<int>(DepthEnebleMode::Maximum)];
-		DepthEnebleMode _depthEnableMode;
 
 		// sampler
 		ID3D11SamplerState* _samplerState;
@@ -109,19 +64,39 @@ namespace Renderer
 		// input layout
 		ID3D11InputLayout* _inputLayout;
 
-		// shaders
+		// shaders, one pixel shader per variant of the features (nullptr until it is created)
 		ID3D11VertexShader* _vertexShader;
-		ID3D11PixelShader*  _pixelShader;
+		ID3D11PixelShader*  _pixelShaders[ShaderPermutation::VARIANT_COUNT];
+
+		// the shipped variants are created at startup, another one is compiled the first time it is bound
+		ShaderCompiler::Compiler _shaderCompiler;
+		ShaderCache::Cache _shaderCache;
+		bool _isDebugShader;
+
+		// constant ring shared by all constants of the frame, bound by offset
+		ID3D11Buffer* _constantRingBuffer;
+		ConstantRing::Allocator _constantRing;
+
+		// constants bound to the shaders
+		TransformConstants _transform;
+		ConstantRing::Allocation _transformConstants;
+		bool _isTransform2D;
 
-		// constant buffers
-		ID3D11Buffer* _constantBufferWorld;
-		ID3D11Buffer* _constantBufferView;
-		ID3D11Buffer* _constantBufferProjection;
-		ID3D11Buffer* _constantBufferMaterial;
+		// camera of the 2D pass
+		Camera2D _camera2D;
+
+		// materials resident on the gpu, the pixel shader reads the slot carried by each instance
+		ID3D11Buffer* _materialBuffer;
+		ID3D11ShaderResourceView* _materialSrv;
+		MaterialTable::Table _materialTable;
 
 		// viewport
 		D3D11_VIEWPORT _viewport;
 
+		// pipeline states
+		PipelineState::Cache _pipelineStateCache;
+		PipelineState::Binder _pipelineStateBinder;
+
 		//-----------------------------------
 		// private funcs
 		//-----------------------------------
@@ -138,10 +113,25 @@ namespace Renderer
 		HRESULT CreateSamplerState();
 
 		HRESULT CreateShadersAndInputLayout();
-		HRESULT CreateConstantBuffers();
+		HRESULT CreatePixelShaderVariant(_In_ ShaderPermutation::Key key);
+		HRESULT CreateConstantRing();
+		HRESULT CreateMaterialTable();
 
 		void SetViewportToRasterizerState();
 
+		// constant ring
+		uint8_t* MapConstants(bool discard) override;
+		void UnmapConstants() override;
+		void UploadTransform();
+		void SetConstantBuffersToContext(_Inout_ CountedContext::Context& context);
+
+		// material table
+		void UploadMaterials(_In_reads_(count) const MaterialTable::Constants* p_constants, _In_ MaterialTable::Index first, _In_ uint32_t count) override;
+
+		// issue the sub-states which differ from the bound pipeline state
+		void ApplyPipelineDesc(_Inout_ CountedContext::Context& context, _Inout_ PipelineState::Binder& binder,
+			_In_ const PipelineState::Desc& desc, _In_ uint32_t mask);
+
 		//-----------------------------------
 		// public funcs
 		//-----------------------------------
@@ -163,11 +153,33 @@ namespace Renderer
 		void SetBlendMode(_In_ const BlendMode& blendMode);
 		void SetDepthEnableState(_In_ const DepthEnebleMode& depthStencilMode);
 
+		// constants are uploaded only when they change
+		void SetCamera2D(_In_ const Camera2D& camera);
 		void SetMatrixWorldViewProjection2D();
+		void SetTransform(_In_ const DirectX::XMMATRIX& world, _In_ const DirectX::XMMATRIX& viewProjection);
+
+		// pipeline state
+		PipelineState::Handle CreatePipelineState(_In_ const PipelineState::Desc& desc);
+		void BindPipelineState(_In_ PipelineState::Handle handle);
+		void InvalidatePipelineState();
+
+		// other contexts (e.g. deferred contexts) track their own bound state
+		void BindPipelineState(_Inout_ CountedContext::Context& context, _Inout_ PipelineState::Binder& binder, _In_ PipelineState::Handle handle);
+
+		// set render targets, viewport, constant buffers and the material table of the frame to a context
+		void SetFrameResourcesToContext(_Inout_ CountedContext::Context& context);
 
 		// getter
 		ID3D11Device& GetDevice();
 		ID3D11DeviceContext& GetDeviceContext();
-		ID3D11Buffer& GetConstantBufferMaterial();
+		CountedContext::Context GetCountedContext(_In_ FrameCounters::Subsystem subsystem);
+		PipelineState::Desc GetDefaultPipelineDesc() const;
+		MaterialTable::Table& GetMaterialTable();
+		const MaterialTable::Table& GetMaterialTable() const;
+		PipelineState::ObjectId GetPixelShaderVariant(_In_ ShaderPermutation::Key key);
+		const Camera2D& GetCamera2D() const;
+		ViewRect GetViewRect2D() const;
+		const PipelineState::FrameStats& GetLastPipelineStats() const;
+		const ConstantRing::FrameStats& GetLastConstantStats() const;
 	};
 }
@@ -14,9 +14,11 @@ namespace Renderer
 	/// </summary>
 	void Manager::SetRasterizerState(_In_ const CullMode& cullMode, _In_ const FillMode& fillMode)
 	{
-		_deviceContext->RSSetState(_rasterizerState[static_cast<int>(cullMode)][static_cast<int>(fillMode)]);
-		_cullMode = cullMode;
-		_fillMode = fillMode;
+		PipelineState::Desc desc = _pipelineStateBinder.GetBound();
+		desc.CullMode = cullMode;
+		desc.FillMode = fillMode;
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		ApplyPipelineDesc(context, _pipelineStateBinder, desc, PipelineState::SUB_STATE_RASTERIZER);
 	}
 
 	/// <summary>
@@ -24,8 +26,10 @@ namespace Renderer
 	/// </summary>
 	void Manager::SetCullingMode(_In_ const CullMode& cullMode)
 	{
-		_deviceContext->RSSetState(_rasterizerState[static_cast<int>(cullMode)][static_cast<int>(_fillMode)]);
-		_cullMode = cullMode;
+		PipelineState::Desc desc = _pipelineStateBinder.GetBound();
+		desc.CullMode = cullMode;
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		ApplyPipelineDesc(context, _pipelineStateBinder, desc, PipelineState::SUB_STATE_RASTERIZER);
 	}
 
 	/// <summary>
@@ -33,8 +37,10 @@ namespace Renderer
 	/// </summary>
 	void Manager::SetFillingMode(_In_ const FillMode& fillMode)
 	{
-		_deviceContext->RSSetState(_rasterizerState[static_cast<int>(_cullMode)][static_cast<int>(fillMode)]);
-		_fillMode = fillMode;
+		PipelineState::Desc desc = _pipelineStateBinder.GetBound();
+		desc.FillMode = fillMode;
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		ApplyPipelineDesc(context, _pipelineStateBinder, desc, PipelineState::SUB_STATE_RASTERIZER);
 	}
 
 	/// <summary>
@@ -42,8 +48,10 @@ namespace Renderer
 	/// </summary>
 	void Manager::SetBlendMode(_In_ const BlendMode& blendMode)
 	{
-		_deviceContext->OMSetBlendState(_blendState[static_cast<int>(blendMode)], {}, 0xffffffff);
-		_blendMode = blendMode;
+		PipelineState::Desc desc = _pipelineStateBinder.GetBound();
+		desc.BlendMode = blendMode;
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		ApplyPipelineDesc(context, _pipelineStateBinder, desc, PipelineState::SUB_STATE_BLEND);
 	}
 
 	/// <summary>
@@ -51,39 +59,232 @@ namespace Renderer
 	/// </summary>
 	void Manager::SetDepthEnableState(_In_ const DepthEnebleMode& depthEnableMode)
 	{
-		_deviceContext->OMSetDepthStencilState(_depthStencilState[static_cast<int>(depthEnableMode)], NULL);
-		_depthEnableMode = depthEnableMode;
+		PipelineState::Desc desc = _pipelineStateBinder.GetBound();
+		desc.DepthEnableMode = depthEnableMode;
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		ApplyPipelineDesc(context, _pipelineStateBinder, desc, PipelineState::SUB_STATE_DEPTH_STENCIL);
+	}
+
+	/// <summary>
+	/// set the camera of the 2D pass
+	/// </summary>
+	void Manager::SetCamera2D(_In_ const Camera2D& camera)
+	{
+		if (camera.Position[0] == _camera2D.Position[0] && camera.Position[1] == _camera2D.Position[1] && camera.Zoom == _camera2D.Zoom)
+			return;
+
+		_camera2D = camera;
+
+		// the bound 2D transform is stale
+		_isTransform2D = false;
 	}
 
 	/// <summary>
 	/// set MVP matrix for 2D
+	/// the 2D transform is uploaded again only after the camera moved or the ring was discarded
 	/// </summary>
 	void Manager::SetMatrixWorldViewProjection2D()
 	{
-		DirectX::XMMATRIX mtx_world;
-		DirectX::XMMATRIX mtx_view;
-		DirectX::XMMATRIX mtx_projection;
+		if (_isTransform2D && _constantRing.IsResident(_transformConstants))
+			return;
 
-		{// world matrix
+		// left-handed coordinate system
+		DirectX::XMMATRIX mtx_projection = DirectX::XMMatrixOrthographicOffCenterLH
+		(0.0f, static_cast<float>(Window::WINDOW_SIZE_WIDTH), static_cast<float>(Window::WINDOW_SIZE_HEIGHT), 0.0f, 0.0f, 1.0f);
 
-			mtx_world = DirectX::XMMatrixTranspose(DirectX::XMMatrixIdentity());
-			_deviceContext->UpdateSubresource(_constantBufferWorld, 0, nullptr, &mtx_world, 0, 0);
-		}
+		// the camera position comes to the top-left of the screen, then the world is zoomed around it
+		DirectX::XMMATRIX mtx_view = DirectX::XMMatrixMultiply(
+			DirectX::XMMatrixTranslation(-_camera2D.Position[0], -_camera2D.Position[1], 0.0f),
+			DirectX::XMMatrixScaling(_camera2D.Zoom, _camera2D.Zoom, 1.0f));
+
+		// the world matrix is identity
+		SetTransform(DirectX::XMMatrixIdentity(), DirectX::XMMatrixMultiply(mtx_view, mtx_projection));
+		_isTransform2D = true;
+	}
+
+	/// <summary>
+	/// set the world and view-projection matrices
+	/// the MVP is multiplied here once instead of per vertex
+	/// </summary>
+	void Manager::SetTransform(_In_ const DirectX::XMMATRIX& world, _In_ const DirectX::XMMATRIX& viewProjection)
+	{
+		TransformConstants transform;
+		DirectX::XMStoreFloat4x4(&transform.WorldViewProjection, DirectX::XMMatrixTranspose(DirectX::XMMatrixMultiply(world, viewProjection)));
+		DirectX::XMStoreFloat4x4(&transform.World, DirectX::XMMatrixTranspose(world));
+
+		_isTransform2D = false;
+
+		// same constants as the bound ones
+		if (_constantRing.IsResident(_transformConstants) && memcmp(&transform, &_transform, sizeof(transform)) == 0)
+			return;
+
+		_transform = transform;
+		UploadTransform();
+	}
 
-		{// view matrix
+	//--------------------------------------------------------
+	// pipeline state
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the pipeline state of a description, creating it the first time
+	/// </summary>
+	PipelineState::Handle Manager::CreatePipelineState(_In_ const PipelineState::Desc& desc)
+	{
+		return _pipelineStateCache.GetOrCreate(desc);
+	}
+
+	/// <summary>
+	/// bind a pipeline state
+	/// </summary>
+	void Manager::BindPipelineState(_In_ PipelineState::Handle handle)
+	{
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+		ApplyPipelineDesc(context, _pipelineStateBinder, _pipelineStateCache.Get(handle), PipelineState::SUB_STATE_ALL);
+	}
+
+	/// <summary>
+	/// forget the bound pipeline state (e.g. after the context state was cleared)
+	/// </summary>
+	void Manager::InvalidatePipelineState()
+	{
+		_pipelineStateBinder.Invalidate();
+	}
 
-			mtx_view = DirectX::XMMatrixTranspose(DirectX::XMMatrixIdentity());
-			_deviceContext->UpdateSubresource(_constantBufferView, 0, nullptr, &mtx_view, 0, 0);
+	/// <summary>
+	/// bind a pipeline state to another context
+	/// </summary>
+	void Manager::BindPipelineState(_Inout_ CountedContext::Context& context, _Inout_ PipelineState::Binder& binder, _In_ PipelineState::Handle handle)
+	{
+		ApplyPipelineDesc(context, binder, _pipelineStateCache.Get(handle), PipelineState::SUB_STATE_ALL);
+	}
+
+	/// <summary>
+	/// set render targets, viewport, constant buffers and the material table of the frame to a context
+	/// </summary>
+	void Manager::SetFrameResourcesToContext(_Inout_ CountedContext::Context& context)
+	{
+		// output merger and viewport
+		context.OMSetRenderTargets(1, &_rtv_backbuffer, _dsv_backbuffer);
+		context.RSSetViewports(1, &_viewport);
+
+		// constant buffers
+		SetConstantBuffersToContext(context);
+
+		// material table, the texture of the sprites is bound to the slot before it
+		context.PSSetShaderResources(1, 1, &_materialSrv);
+	}
+
+	//--------------------------------------------------------
+	// constant ring
+	//--------------------------------------------------------
+	/// <summary>
+	/// map the constant ring
+	/// </summary>
+	uint8_t* Manager::MapConstants(bool discard)
+	{
+		D3D11_MAPPED_SUBRESOURCE subresource;
+		HRESULT h_result = GetCountedContext(FrameCounters::Subsystem::Renderer).Map(_constantRingBuffer, 0,
+			discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, &subresource);
+		if (FAILED(h_result))
+			return nullptr;
+
+		return static_cast<uint8_t*>(subresource.pData);
+	}
+
+	/// <summary>
+	/// unmap the constant ring
+	/// </summary>
+	void Manager::UnmapConstants()
+	{
+		GetCountedContext(FrameCounters::Subsystem::Renderer).Unmap(_constantRingBuffer, 0);
+	}
+
+	/// <summary>
+	/// upload the transform and bind it to the vertex shader
+	/// </summary>
+	void Manager::UploadTransform()
+	{
+		CountedContext::Context context = GetCountedContext(FrameCounters::Subsystem::Renderer);
+
+		_transformConstants = _constantRing.Upload(&_transform, sizeof(_transform));
+		context.AddConstantUpdate(sizeof(_transform));
+
+		UINT first_constant = _transformConstants.Offset / ConstantRing::CONSTANT_SIZE;
+		UINT constant_count = _transformConstants.Size   / ConstantRing::CONSTANT_SIZE;
+		context.VSSetConstantBuffers1(0, _constantRingBuffer, first_constant, constant_count);
+	}
+
+	/// <summary>
+	/// bind the current constants of the ring to a context
+	/// </summary>
+	void Manager::SetConstantBuffersToContext(_Inout_ CountedContext::Context& context)
+	{
+		// a binding needs at least one slot even before the first upload
+		UINT first_constant = _transformConstants.Offset / ConstantRing::CONSTANT_SIZE;
+		UINT constant_count = ConstantRing::AlignConstants(sizeof(TransformConstants)) / ConstantRing::CONSTANT_SIZE;
+		context.VSSetConstantBuffers1(0, _constantRingBuffer, first_constant, constant_count);
+	}
+
+	//--------------------------------------------------------
+	// material table
+	//--------------------------------------------------------
+	/// <summary>
+	/// write a range of slots of the material table, the rest of the buffer is not touched
+	/// </summary>
+	void Manager::UploadMaterials(_In_reads_(count) const MaterialTable::Constants* p_constants, _In_ MaterialTable::Index first, _In_ uint32_t count)
+	{
+		const UINT offset = first * sizeof(MaterialTable::Constants);
+		const UINT size   = count * sizeof(MaterialTable::Constants);
+		GetCountedContext(FrameCounters::Subsystem::Renderer).UpdateBufferRange(_materialBuffer, offset, p_constants, size);
+	}
+
+	/// <summary>
+	/// issue the sub-states which differ from the bound pipeline state
+	/// </summary>
+	void Manager::ApplyPipelineDesc(_Inout_ CountedContext::Context& context, _Inout_ PipelineState::Binder& binder,
+		_In_ const PipelineState::Desc& desc, _In_ uint32_t mask)
+	{
+		const uint32_t issue = binder.Bind(desc, mask);
+		if (issue == 0)
+			return;
+
+		// shaders
+		if (issue & PipelineState::SUB_STATE_VERTEX_SHADER)
+		{
+			context.VSSetShader(reinterpret_cast<ID3D11VertexShader*>(desc.VertexShader));
+		}
+		if (issue & PipelineState::SUB_STATE_PIXEL_SHADER)
+		{
+			context.PSSetShader(reinterpret_cast<ID3D11PixelShader*>(desc.PixelShader));
 		}
 
-		{// projection matrix
+		// input layout
+		if (issue & PipelineState::SUB_STATE_INPUT_LAYOUT)
+		{
+			context.IASetInputLayout(reinterpret_cast<ID3D11InputLayout*>(desc.InputLayout));
+		}
 
-			// left-handed coordinate system
-			mtx_projection = DirectX::XMMatrixOrthographicOffCenterLH
-			(0.0f, static_cast<float>(Window::WINDOW_SIZE_WIDTH), static_cast<float>(Window::WINDOW_SIZE_HEIGHT), 0.0f, 0.0f, 1.0f);
+		// rasterizer
+		if (issue & PipelineState::SUB_STATE_RASTERIZER)
+		{
+			context.RSSetState(_rasterizerState[static_cast<int>(desc.CullMode)][static_cast<int>(desc.FillMode)]);
+		}
+
+		// output merger
+		if (issue & PipelineState::SUB_STATE_BLEND)
+		{
+			context.OMSetBlendState(_blendState[static_cast<int>(desc.BlendMode)], {}, 0xffffffff);
+		}
+		if (issue & PipelineState::SUB_STATE_DEPTH_STENCIL)
+		{
+			context.OMSetDepthStencilState(_depthStencilState[static_cast<int>(desc.DepthEnableMode)], NULL);
+		}
 
-			mtx_projection = DirectX::XMMatrixTranspose(mtx_projection);
-			_deviceContext->UpdateSubresource(_constantBufferProjection, 0, nullptr, &mtx_projection, 0, 0);
+		// sampler
+		if (issue & PipelineState::SUB_STATE_SAMPLER)
+		{
+			ID3D11SamplerState* p_sampler = reinterpret_cast<ID3D11SamplerState*>(desc.Sampler);
+			context.PSSetSamplers(0, 1, &p_sampler);
 		}
 	}
 
@@ -107,10 +308,98 @@ namespace Renderer
 	}
 
 	/// <summary>
-	/// get pointer for constant buffer of material
+	/// get the immediate context, counting its calls for a subsystem
+	/// </summary>
+	CountedContext::Context Manager::GetCountedContext(_In_ FrameCounters::Subsystem subsystem)
+	{
+		return CountedContext::Context(*_deviceContext, subsystem, _deviceContext1);
+	}
+
+	/// <summary>
+	/// get the description of the default pipeline state
+	/// </summary>
+	PipelineState::Desc Manager::GetDefaultPipelineDesc() const
+	{
+		PipelineState::Desc desc;
+		desc.VertexShader    = reinterpret_cast<PipelineState::ObjectId>(_vertexShader);
+		desc.PixelShader     = reinterpret_cast<PipelineState::ObjectId>(_pixelShaders[ShaderPermutation::DEFAULT_KEY]);
+		desc.InputLayout     = reinterpret_cast<PipelineState::ObjectId>(_inputLayout);
+		desc.CullMode        = CullMode::Back;
+		desc.FillMode        = FillMode::Solid;
+		desc.BlendMode       = BlendMode::AlphaBlend;
+		desc.DepthEnableMode = DepthEnebleMode::Enable;
+		desc.Sampler         = reinterpret_cast<PipelineState::ObjectId>(_samplerState);
+
+		return desc;
+	}
+
+	/// <summary>
+	/// get the material table, the materials are registered to it once
+	/// </summary>
+	MaterialTable::Table& Manager::GetMaterialTable()
+	{
+		return _materialTable;
+	}
+
+	/// <summary>
+	/// get the material table
+	/// </summary>
+	const MaterialTable::Table& Manager::GetMaterialTable() const
+	{
+		return _materialTable;
+	}
+
+	/// <summary>
+	/// get the pixel shader of a variant
+	/// a variant missing from the manifest is compiled here, once, and reported so it can be added
+	/// </summary>
+	PipelineState::ObjectId Manager::GetPixelShaderVariant(_In_ ShaderPermutation::Key key)
+	{
+		key &= ShaderPermutation::FEATURE_ALL;
+		if (!_pixelShaders[key])
+		{
+			const std::string message = "shader variant not in the manifest: " + ShaderPermutation::GetKeyName(key) + "\n";
+			OutputDebugString(message.c_str());
+
+			if (FAILED(CreatePixelShaderVariant(key)))
+				return reinterpret_cast<PipelineState::ObjectId>(_pixelShaders[ShaderPermutation::DEFAULT_KEY]);
+		}
+
+		return reinterpret_cast<PipelineState::ObjectId>(_pixelShaders[key]);
+	}
+
+	/// <summary>
+	/// get the camera of the 2D pass
+	/// </summary>
+	const Camera2D& Manager::GetCamera2D() const
+	{
+		return _camera2D;
+	}
+
+	/// <summary>
+	/// get the world rectangle seen by the 2D camera
+	/// </summary>
+	ViewRect Manager::GetViewRect2D() const
+	{
+		const float width  = static_cast<float>(Window::WINDOW_SIZE_WIDTH)  / _camera2D.Zoom;
+		const float height = static_cast<float>(Window::WINDOW_SIZE_HEIGHT) / _camera2D.Zoom;
+
+		return { _camera2D.Position[0], _camera2D.Position[1], _camera2D.Position[0] + width, _camera2D.Position[1] + height };
+	}
+
+	/// <summary>
+	/// get statistics of state changes in the last frame
+	/// </summary>
+	const PipelineState::FrameStats& Manager::GetLastPipelineStats() const
+	{
+		return _pipelineStateBinder.GetLastFrameStats();
+	}
+
+	/// <summary>
+	/// get statistics of constant uploads in the last frame
 	/// </summary>
-	ID3D11Buffer& Manager::GetConstantBufferMaterial()
+	const ConstantRing::FrameStats& Manager::GetLastConstantStats() const
 	{
-		return *_constantBufferMaterial;
+		return _constantRing.GetLastFrameStats();
 	}
 }
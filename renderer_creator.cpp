@@ -2,8 +2,9 @@
 #include "main.h"
 #include "directx11_wrapper.h"
 #include "renderer.h"
+#include "profiler.h"
 #include "window.h"
-#include "material.h"
+#include "shader_compiler.h"
 
 namespace Renderer
 {
@@ -156,7 +157,7 @@ namespace Renderer
 	/// </summary>
 	void Manager::SetRenderTargetsToOutputMerger()
 	{
-		_deviceContext->OMSetRenderTargets(1, &_rtv_backbuffer, _dsv_backbuffer);
+		GetCountedContext(FrameCounters::Subsystem::Renderer).OMSetRenderTargets(1, &_rtv_backbuffer, _dsv_backbuffer);
 	}
 
 	/// <summary>
@@ -186,9 +187,6 @@ namespace Renderer
 			}
 		}
 
-		// set mode
-		SetRasterizerState(CullMode::Back, FillMode::Solid);
-
 		return h_result;
 	}
 
@@ -246,8 +244,13 @@ namespace Renderer
 			h_result = _device->CreateBlendState(&blend_desc, &_blendState[static_cast<int>(BlendMode::AlphaBlend)]);
 		}
 
-		// set mode
-		SetBlendMode(BlendMode::AlphaBlend);
+		{// premultiplied blend
+			// the color is already multiplied by alpha, so the same state draws alpha blended (alpha kept) and additive (alpha 0) sprites
+			blend_desc.RenderTarget[0].SrcBlend  = D3D11_BLEND_ONE;
+			blend_desc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			blend_desc.RenderTarget[0].BlendOp   = D3D11_BLEND_OP_ADD;
+			h_result = _device->CreateBlendState(&blend_desc, &_blendState[static_cast<int>(BlendMode::Premultiplied)]);
+		}
 
 		return h_result;
 	}
@@ -277,9 +280,6 @@ namespace Renderer
 		depth_stencil_desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
 		h_result = _device->CreateDepthStencilState(&depth_stencil_desc, &_depthStencilState[static_cast<int>(DepthEnebleMode::Disable)]);
 
-		// set mode
-		SetDepthEnableState(DepthEnebleMode::Enable);
-
 		return h_result;
 	}
 
@@ -312,9 +312,6 @@ namespace Renderer
 		// creates state
 		h_result = _device->CreateSamplerState(&sampler_desc, &_samplerState);
 
-		// set sampler to the pixel shader
-		_deviceContext->PSSetSamplers(0, 1, &_samplerState);
-
 		return h_result;
 	}
 
@@ -323,98 +320,168 @@ namespace Renderer
 	/// </summary>
 	HRESULT Manager::CreateShadersAndInputLayout()
 	{
+		PROFILE_SCOPE("Renderer::CreateShadersAndInputLayout");
+
 		HRESULT h_result = S_OK;
 
-		DWORD compile_flag = D3DCOMPILE_ENABLE_STRICTNESS;
+		_isDebugShader = false;
 #ifdef DEBUG_HLSL_SHADERS
-		compile_flag = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+		_isDebugShader = true;
 #endif
 
-		// define binary-large-object
-		ID3DBlob* errorBlob = nullptr;
-		ID3DBlob* vsBlob = nullptr;
-		ID3DBlob* psBlob = nullptr;
+		// the bytecode is read from the cache, the compiler only runs when a source or an option changed
+		_shaderCache.Initialize(ShaderCompiler::CACHE_DIRECTORY, &_shaderCompiler);
+
+		std::vector<uint8_t> vs_bytecode;
+		std::string errors;
 
 		//-----------------------------------
 		// vertex shader
 		//-----------------------------------
 		{
-			// compile shader file
-			h_result = D3DCompileFromFile(L"resource/shader/vertex_shader.hlsl", nullptr,
-				D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", "vs_5_0", compile_flag, 0, &vsBlob, &errorBlob);
-			
-			// error message
-			if (FAILED(h_result))
+			// load or compile shader file
+			if (_shaderCache.Load(ShaderCompiler::GetRendererShader(ShaderCompiler::RendererShader::Vertex, _isDebugShader), &vs_bytecode, &errors) < 0)
 			{
-				MessageBox(nullptr, static_cast<LPCSTR>(errorBlob->GetBufferPointer()), "VS", MB_OK | MB_ICONERROR);
+				MessageBox(nullptr, errors.c_str(), "VS", MB_OK | MB_ICONERROR);
+				return E_FAIL;
 			}
-			
+
 			// creates vertex shader
-			h_result = _device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &_vertexShader);
+			h_result = _device->CreateVertexShader(vs_bytecode.data(), vs_bytecode.size(), nullptr, &_vertexShader);
+			if (FAILED(h_result))
+				return h_result;
 		}
 
 		//-----------------------------------
 		// pixel shader
 		//-----------------------------------
 		{
-			// compile shader file
-			h_result = D3DCompileFromFile(L"resource/shader/pixel_shader.hlsl", nullptr,
-				D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", "ps_5_0", compile_flag, 0, &psBlob, &errorBlob);
+			// one variant per line of the manifest, the default one is always created
+			std::vector<ShaderPermutation::Key> keys;
+			ShaderPermutation::LoadManifest(ShaderPermutation::MANIFEST_PATH, &keys);
+			keys.push_back(ShaderPermutation::DEFAULT_KEY);
 
-			// error message
-			if (FAILED(h_result))
+			for (ShaderPermutation::Key key : keys)
 			{
-				MessageBox(nullptr, static_cast<LPCSTR>(errorBlob->GetBufferPointer()), "PS", MB_OK | MB_ICONERROR);
-			}
+				if (_pixelShaders[key]) continue;
 
-			// creates pixel shader
-			h_result = _device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &_pixelShader);
+				h_result = CreatePixelShaderVariant(key);
+				if (FAILED(h_result))
+					return h_result;
+			}
 		}
 
 		//-----------------------------------
 		// input layout
 		//-----------------------------------
+		// one element per sprite (Vertex::Manager), the vertex shader expands the corners from SV_VertexID
 		D3D11_INPUT_ELEMENT_DESC input_layout_desc[] =
 		{
-			{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT,	 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT,	 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "COLOR",    0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-			{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,		 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 }
+			{ "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT,		 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "SCALE",    0, DXGI_FORMAT_R16G16_FLOAT,		 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "ROTATION", 0, DXGI_FORMAT_R16_SNORM,			 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "TEXTURE",  0, DXGI_FORMAT_R16_UINT,			 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "TEXCOORD", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "COLOR",    0, DXGI_FORMAT_R8G8B8A8_UNORM,	 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+			{ "MATERIAL", 0, DXGI_FORMAT_R32_UINT,			 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
 		};
-		h_result = _device->CreateInputLayout(input_layout_desc, static_cast<UINT>(ARRAYSIZE(input_layout_desc)), vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &_inputLayout);
-
-		// releases binary-large-object
-		vsBlob->Release();
-		psBlob->Release();
+		h_result = _device->CreateInputLayout(input_layout_desc, static_cast<UINT>(ARRAYSIZE(input_layout_desc)), vs_bytecode.data(), vs_bytecode.size(), &_inputLayout);
 
 		return h_result;
 	}
 
 	/// <summary>
-	/// creates constant buffers
+	/// creates the pixel shader of a variant, specialized for its features by the preprocessor
+	/// </summary>
+	HRESULT Manager::CreatePixelShaderVariant(_In_ ShaderPermutation::Key key)
+	{
+		// load or compile shader file
+		std::vector<uint8_t> ps_bytecode;
+		std::string errors;
+		if (_shaderCache.Load(ShaderCompiler::GetPixelShaderVariant(key, _isDebugShader), &ps_bytecode, &errors) < 0)
+		{
+			MessageBox(nullptr, errors.c_str(), "PS", MB_OK | MB_ICONERROR);
+			return E_FAIL;
+		}
+
+		// creates pixel shader
+		return _device->CreatePixelShader(ps_bytecode.data(), ps_bytecode.size(), nullptr, &_pixelShaders[key]);
+	}
+
+	/// <summary>
+	/// creates the constant ring
+	/// binding constants by offset needs the Direct3D 11.1 runtime
 	/// </summary>
-	HRESULT Manager::CreateConstantBuffers()
+	HRESULT Manager::CreateConstantRing()
 	{
 		HRESULT h_result = S_OK;
 
-		// settings for constant buffers
+		h_result = _deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), reinterpret_cast<void**>(&_deviceContext1));
+		if (FAILED(h_result))
+			return h_result;
+
+		// the ring is written with no-overwrite and bound with offsets
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+		ZeroMemory(&options, sizeof(options));
+		h_result = _device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+		if (FAILED(h_result))
+			return h_result;
+
+		if (!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+			return E_NOTIMPL;
+
+		// settings for the constant ring
 		D3D11_BUFFER_DESC buffer_desc;
 		ZeroMemory(&buffer_desc, sizeof(buffer_desc));
-		buffer_desc.Usage               = D3D11_USAGE_DEFAULT;
-		buffer_desc.BindFlags           = D3D11_BIND_CONSTANT_BUFFER;
-		buffer_desc.CPUAccessFlags      = 0;
-		buffer_desc.MiscFlags           = 0;
-		buffer_desc.StructureByteStride = sizeof(float);
+		buffer_desc.Usage          = D3D11_USAGE_DYNAMIC;
+		buffer_desc.ByteWidth      = ConstantRing::DEFAULT_CAPACITY_BYTES;
+		buffer_desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+		buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
 
-		// mvp matrix
-		buffer_desc.ByteWidth = sizeof(DirectX::XMMATRIX);
-		h_result = _device->CreateBuffer(&buffer_desc, nullptr, &_constantBufferWorld);
-		h_result = _device->CreateBuffer(&buffer_desc, nullptr, &_constantBufferView);
-		h_result = _device->CreateBuffer(&buffer_desc, nullptr, &_constantBufferProjection);
+		h_result = _device->CreateBuffer(&buffer_desc, nullptr, &_constantRingBuffer);
+		if (FAILED(h_result))
+			return h_result;
 
-		// material
-		buffer_desc.ByteWidth = sizeof(Material::Manager);
-		h_result = _device->CreateBuffer(&buffer_desc, nullptr, &_constantBufferMaterial);
+		_constantRing.Initialize(this, buffer_desc.ByteWidth);
+
+		return h_result;
+	}
+
+	/// <summary>
+	/// creates the structured buffer of the material table
+	/// it is written slot by slot, only when a material is registered or edited
+	/// </summary>
+	HRESULT Manager::CreateMaterialTable()
+	{
+		HRESULT h_result = S_OK;
+
+		// settings for the material table
+		D3D11_BUFFER_DESC buffer_desc;
+		ZeroMemory(&buffer_desc, sizeof(buffer_desc));
+		buffer_desc.Usage               = D3D11_USAGE_DEFAULT;
+		buffer_desc.ByteWidth           = sizeof(MaterialTable::Constants) * MaterialTable::DEFAULT_CAPACITY;
+		buffer_desc.BindFlags           = D3D11_BIND_SHADER_RESOURCE;
+		buffer_desc.MiscFlags           = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+		buffer_desc.StructureByteStride = sizeof(MaterialTable::Constants);
+
+		h_result = _device->CreateBuffer(&buffer_desc, nullptr, &_materialBuffer);
+		if (FAILED(h_result))
+			return h_result;
+
+		// settings for the view of the pixel shader
+		D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc;
+		ZeroMemory(&srv_desc, sizeof(srv_desc));
+		srv_desc.Format              = DXGI_FORMAT_UNKNOWN;
+		srv_desc.ViewDimension       = D3D11_SRV_DIMENSION_BUFFER;
+		srv_desc.Buffer.FirstElement = 0;
+		srv_desc.Buffer.NumElements  = MaterialTable::DEFAULT_CAPACITY;
+
+		h_result = _device->CreateShaderResourceView(_materialBuffer, &srv_desc, &_materialSrv);
+		if (FAILED(h_result))
+			return h_result;
+
+		// the default material is uploaded by the first flush
+		_materialTable.Initialize(this, MaterialTable::DEFAULT_CAPACITY);
 
 		return h_result;
 	}
@@ -432,6 +499,6 @@ namespace Renderer
 		_viewport.TopLeftY = 0.0f;
 
 		// set viewport to the Rasterizer state
-		_deviceContext->RSSetViewports(1, &_viewport);
+		GetCountedContext(FrameCounters::Subsystem::Renderer).RSSetViewports(1, &_viewport);
 	}
 }
@@ -0,0 +1,89 @@
+
+#pragma once
+
+namespace Renderer
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// screen parameter
+	constexpr int SCREEN_SIZE_WIDTH  = 960;
+	constexpr int SCREEN_SIZE_HEIGHT = 540;
+
+	constexpr int SCREEN_RESOLUTION_WIDTH  = 1920;
+	constexpr int SCREEN_RESOLUTION_HEIGHT = 1080;
+
+	//--------------------------------------------------------
+	// enumrator
+	//--------------------------------------------------------
+	/// <summary>
+	/// enumeration of culling modes
+	/// </summary>
+	enum class CullMode
+	{
+		None,
+		Front,
+		Back,
+
+		Maximum
+	};
+
+	/// <summary>
+	/// enumeration of filling modes
+	/// </summary>
+	enum class FillMode
+	{
+		Wireframe,
+		Solid,
+
+		Maximum
+	};
+
+	/// <summary>
+	/// enumeration of blending modes
+	/// </summary>
+	enum class BlendMode
+	{
+		None,
+		Add,
+		Subtract,
+		AlphaBlend,
+		Premultiplied,           // ONE, INV_SRC_ALPHA: the color is multiplied by alpha before blending, alpha 0 adds it
+
+		Maximum
+	};
+
+	/// <summary>
+	/// enumeration of depth enable mode
+	/// </summary>
+	enum class DepthEnebleMode
+	{
+		Enable,
+		Disable,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// axis-aligned rectangle in 2D world coordinates (y grows downward)
+	/// </summary>
+	struct ViewRect
+	{
+		float Left;
+		float Top;
+		float Right;
+		float Bottom;
+	};
+
+	/// <summary>
+	/// camera of the 2D pass, the position is the world coordinate at the top-left of the screen
+	/// </summary>
+	struct Camera2D
+	{
+		float Position[2];
+		float Zoom;
+	};
+}
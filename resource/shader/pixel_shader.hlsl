@@ -1,11 +1,26 @@
 
 #include "shader_header.hlsli"
 
-cbuffer MaterialBuffer : register(b0) { Material g_Material; }
+// features of the variant, defined by the renderer (ShaderPermutation::GetDefines)
+#ifndef FEATURE_TEXTURED
+#define FEATURE_TEXTURED 1
+#endif
+#ifndef FEATURE_ALPHA_TEST
+#define FEATURE_ALPHA_TEST 0
+#endif
+#ifndef FEATURE_TINT
+#define FEATURE_TINT 1
+#endif
+#ifndef FEATURE_PREMULTIPLIED
+#define FEATURE_PREMULTIPLIED 0
+#endif
 
 Texture2D g_Texture         : register(t0);
 SamplerState g_SamplerState : register(s0);
 
+// every registered material, indexed by the slot of the instance
+StructuredBuffer<Material> g_Materials : register(t1);
+
 // main func
 PS_Output main(VS_to_PS input)
 {
@@ -13,14 +28,29 @@ PS_Output main(VS_to_PS input)
 	
 	float4 color = input.Color;
 
+#if FEATURE_TINT || FEATURE_ALPHA_TEST
+	Material material = g_Materials[input.Material];
+#endif
+
 	// texture sampling
-	if (!g_Material.TextureSamplingDisable)
-	{
-		color *= g_Texture.Sample(g_SamplerState, input.Texcoord.xy);
-		color.rgb *= g_Material.Diffuse.rgb;
-	}
+#if FEATURE_TEXTURED
+	color *= g_Texture.Sample(g_SamplerState, input.Texcoord.xy);
+#endif
+
+#if FEATURE_TINT
+	color.rgb *= material.Diffuse.rgb;
+#endif
+
+#if FEATURE_ALPHA_TEST
+	clip(color.a - material.AlphaThreshold);
+#endif
+
+	// straight colors and texels only, a premultiplied pipeline draws without this feature (ShaderPermutation::GetPipelineKey)
+#if FEATURE_PREMULTIPLIED
+	color.rgb *= color.a;
+#endif
 
 	output.Color = color;
 
 	return output;
-}
\ No newline at end of file
+}
@@ -1,18 +1,26 @@
 
+// one sprite, the same layout as Vertex::Manager
 struct VS_Input
 {
-	float4 Position : POSITION0;
-	float4 Normal   : NORMAL0;
-	float4 Color    : COLOR0;
-	float4 Texcoord : TEXCOORD0;
+	float2 Position : POSITION0;
+	float2 Scale    : SCALE0;     // half float
+	float  Rotation : ROTATION0;  // snorm16 of the angle over pi
+	uint   Texture  : TEXTURE0;
+	float4 UvRect   : TEXCOORD0;  // top-left and bottom-right
+	float4 Color    : COLOR0;     // rgba8
+	uint   Material : MATERIAL0;  // slot in the material table
+
+	uint VertexId : SV_VertexID;
 };
 
 struct VS_to_PS
 {
 	float4 Position : SV_Position;
-	float4 Normal   : NORMAL0;
 	float4 Color    : COLOR0;
-	float4 Texcoord : TEXCOORD0;
+	float2 Texcoord : TEXCOORD0;
+
+	nointerpolation uint Texture  : TEXTURE0;
+	nointerpolation uint Material : MATERIAL0;
 };
 
 struct PS_Output
@@ -20,6 +28,13 @@ struct PS_Output
 	float4 Color : SV_Target0;
 };
 
+struct Transform
+{
+	matrix WorldViewProjection;
+	matrix World;
+};
+
+// one slot of the material table (same layout as MaterialTable::Constants)
 struct Material
 {
 	float4 Ambient;
@@ -28,7 +43,7 @@ struct Material
 	float4 Emission;
 	
 	float SpecularIntensity;
-	int   TextureSamplingDisable;
+	float AlphaThreshold;  // the alpha test variants discard below it
 	
 	float2 Padding;
 };
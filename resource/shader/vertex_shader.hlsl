@@ -1,29 +1,33 @@
 
 #include "shader_header.hlsli"
 
-cbuffer WorldBuffer      : register(b0) { matrix g_MatrixWorld; }
-cbuffer ViewBuffer       : register(b1) { matrix g_MatrixView; }
-cbuffer ProjectoinBuffer : register(b2) { matrix g_MatrixProjection; }
+cbuffer TransformBuffer : register(b0) { Transform g_Transform; }
 
 // main func
 VS_to_PS main( VS_Input input )
 {
 	VS_to_PS output;
 
-	// perspective projection transformation
-	matrix mvp;
-	mvp = mul(g_MatrixWorld, g_MatrixView);
-	mvp = mul(mvp, g_MatrixProjection);
-	output.Position = mul(input.Position, mvp);
+	// corner of the triangle strip (top-left, top-right, bottom-left, bottom-right)
+	float2 corner = float2(input.VertexId & 1, input.VertexId >> 1);
 
-	// normal
-	output.Normal = normalize(mul(input.Normal, g_MatrixWorld));
+	// rotate the corner around the center of the sprite
+	float s, c;
+	sincos(input.Rotation * 3.14159265f, s, c);
+	float2 offset = (corner - 0.5f) * input.Scale;
+	float2 position = input.Position + float2(offset.x * c - offset.y * s, offset.x * s + offset.y * c);
+
+	// perspective projection transformation (the MVP is multiplied on the CPU)
+	output.Position = mul(float4(position, 0.0f, 1.0f), g_Transform.WorldViewProjection);
 
 	// color
 	output.Color = input.Color;
 
 	// texcoord
-	output.Texcoord = input.Texcoord;
+	output.Texcoord = lerp(input.UvRect.xy, input.UvRect.zw, corner);
+
+	output.Texture  = input.Texture;
+	output.Material = input.Material;
 
 	return output;
 }
@@ -0,0 +1,429 @@
+
+#include <cstdio>
+#include <filesystem>
+
+#include "shader_cache.h"
+
+namespace ShaderCache
+{
+	namespace
+	{
+		// FNV-1a 64 bit
+		constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+		constexpr uint64_t FNV_PRIME        = 0x100000001b3ull;
+
+		// length hashed in place of the contents of a missing file
+		constexpr uint64_t MISSING_FILE = UINT64_MAX;
+
+		/// <summary>
+		/// a file the source depends on, and its contents
+		/// </summary>
+		struct Dependency
+		{
+			std::string Path;
+			std::vector<uint8_t> Contents;
+			bool IsFound;
+		};
+
+		/// <summary>
+		/// mix bytes into the hash
+		/// </summary>
+		inline void HashBytes(uint64_t& hash, const void* data, size_t size)
+		{
+			const uint8_t* p_byte = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash ^= p_byte[i];
+				hash *= FNV_PRIME;
+			}
+		}
+
+		/// <summary>
+		/// mix a value into the hash byte by byte
+		/// </summary>
+		inline void HashValue(uint64_t& hash, uint64_t value)
+		{
+			for (int i = 0; i < 8; ++i)
+			{
+				hash ^= (value >> (i * 8)) & 0xff;
+				hash *= FNV_PRIME;
+			}
+		}
+
+		/// <summary>
+		/// mix a string into the hash, with its length so that two strings never run into each other
+		/// </summary>
+		inline void HashString(uint64_t& hash, const std::string& value)
+		{
+			HashValue(hash, value.size());
+			HashBytes(hash, value.data(), value.size());
+		}
+
+		/// <summary>
+		/// read a whole file
+		/// </summary>
+		bool ReadFile(const std::string& path, std::vector<uint8_t>* p_contents)
+		{
+			p_contents->clear();
+
+			FILE* p_file = std::fopen(path.c_str(), "rb");
+			if (!p_file)
+				return false;
+
+			uint8_t buffer[4096];
+			size_t read_size = 0;
+			while ((read_size = std::fread(buffer, 1, sizeof(buffer), p_file)) > 0)
+			{
+				p_contents->insert(p_contents->end(), buffer, buffer + read_size);
+			}
+
+			const bool is_read = !std::ferror(p_file);
+			std::fclose(p_file);
+
+			return is_read;
+		}
+
+		/// <summary>
+		/// collect the names of the #include directives of a file, the comments are skipped
+		/// </summary>
+		void ParseIncludes(const std::vector<uint8_t>& contents, std::vector<std::string>* p_names)
+		{
+			p_names->clear();
+
+			const char* p_text = reinterpret_cast<const char*>(contents.data());
+			const size_t size = contents.size();
+
+			bool is_block_comment = false;
+			size_t position = 0;
+			while (position < size)
+			{
+				// one line without the comments
+				std::string line;
+				for (; position < size && p_text[position] != '\n'; ++position)
+				{
+					const char c = p_text[position];
+					const char next = (position + 1 < size) ? p_text[position + 1] : '\0';
+
+					if (is_block_comment)
+					{
+						if (c == '*' && next == '/')
+						{
+							is_block_comment = false;
+							++position;
+						}
+					}
+					else if (c == '/' && next == '*')
+					{
+						is_block_comment = true;
+						++position;
+					}
+					else if (c == '/' && next == '/')
+					{
+						while (position + 1 < size && p_text[position + 1] != '\n') ++position;
+					}
+					else
+					{
+						line.push_back(c);
+					}
+				}
+				++position;
+
+				// # include "name" or # include <name>
+				size_t i = line.find_first_not_of(" \t\r");
+				if (i == std::string::npos || line[i] != '#')
+					continue;
+
+				i = line.find_first_not_of(" \t", i + 1);
+				if (i == std::string::npos || line.compare(i, 7, "include") != 0)
+					continue;
+
+				i = line.find_first_not_of(" \t", i + 7);
+				if (i == std::string::npos || (line[i] != '"' && line[i] != '<'))
+					continue;
+
+				const size_t end = line.find(line[i] == '"' ? '"' : '>', i + 1);
+				if (end == std::string::npos || end == i + 1)
+					continue;
+
+				p_names->push_back(line.substr(i + 1, end - i - 1));
+			}
+		}
+
+		/// <summary>
+		/// read a file and the files it includes, depth first, each file once
+		/// </summary>
+		void CollectDependencies(const std::string& path, uint32_t depth, std::vector<Dependency>* p_dependencies)
+		{
+			for (const Dependency& dependency : *p_dependencies)
+			{
+				if (dependency.Path == path) return;
+			}
+
+			p_dependencies->push_back({ path, {}, false });
+			const size_t index = p_dependencies->size() - 1;
+
+			std::vector<uint8_t> contents;
+			if (!ReadFile(path, &contents))
+				return;
+
+			std::vector<std::string> names;
+			ParseIncludes(contents, &names);
+
+			(*p_dependencies)[index].Contents = std::move(contents);
+			(*p_dependencies)[index].IsFound  = true;
+
+			if (depth >= MAX_INCLUDE_DEPTH)
+				return;
+
+			// the standard include handler looks next to the including file
+			const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+			for (const std::string& name : names)
+			{
+				CollectDependencies((directory / name).lexically_normal().generic_string(), depth + 1, p_dependencies);
+			}
+		}
+
+		/// <summary>
+		/// read the source and every file it includes
+		/// </summary>
+		int ReadDependencies(const std::string& path, std::vector<Dependency>* p_dependencies)
+		{
+			p_dependencies->clear();
+			CollectDependencies(std::filesystem::path(path).lexically_normal().generic_string(), 0, p_dependencies);
+
+			return p_dependencies->front().IsFound ? 0 : -1;
+		}
+	}
+
+	/// <summary>
+	/// collect the source and every file it includes
+	/// </summary>
+	int ScanDependencies(_In_ const std::string& path, _Out_ std::vector<std::string>* p_files)
+	{
+		p_files->clear();
+
+		std::vector<Dependency> dependencies;
+		const int result = ReadDependencies(path, &dependencies);
+
+		for (const Dependency& dependency : dependencies) p_files->push_back(dependency.Path);
+
+		return result;
+	}
+
+	/// <summary>
+	/// hash the options of a shader
+	/// </summary>
+	uint64_t ComputeName(_In_ const Desc& desc)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+		HashValue(hash, FILE_VERSION);
+		HashString(hash, std::filesystem::path(desc.Path).lexically_normal().generic_string());
+		HashString(hash, desc.EntryPoint);
+		HashString(hash, desc.Profile);
+		HashValue(hash, desc.Flags);
+
+		// the order of the defines is kept, a later one can redefine an earlier one
+		HashValue(hash, desc.Defines.size());
+		for (const Define& define : desc.Defines)
+		{
+			HashString(hash, define.Name);
+			HashString(hash, define.Value);
+		}
+
+		return hash;
+	}
+
+	/// <summary>
+	/// hash the options of a shader, the compiler and the contents of every dependency
+	/// </summary>
+	int ComputeKey(_In_ const Desc& desc, _In_ uint64_t compilerVersion, _Out_ uint64_t* p_key)
+	{
+		*p_key = 0;
+
+		std::vector<Dependency> dependencies;
+		if (ReadDependencies(desc.Path, &dependencies) != 0)
+			return -1;
+
+		uint64_t hash = ComputeName(desc);
+		HashValue(hash, compilerVersion);
+		HashValue(hash, dependencies.size());
+		for (const Dependency& dependency : dependencies)
+		{
+			HashString(hash, dependency.Path);
+			HashValue(hash, dependency.IsFound ? dependency.Contents.size() : MISSING_FILE);
+			HashBytes(hash, dependency.Contents.data(), dependency.Contents.size());
+		}
+
+		*p_key = hash;
+		return 0;
+	}
+
+	/// <summary>
+	/// constructor for shader cache
+	/// </summary>
+	Cache::Cache()
+	{
+		_compiler = nullptr;
+		_stats = {};
+	}
+
+	/// <summary>
+	/// initialization process for shader cache
+	/// </summary>
+	void Cache::Initialize(_In_ const std::string& directory, _In_ Compiler* compiler)
+	{
+		_directory = directory;
+		_compiler = compiler;
+		_stats = {};
+	}
+
+	/// <summary>
+	/// termination process for shader cache
+	/// </summary>
+	void Cache::Terminate()
+	{
+		_directory.clear();
+		_compiler = nullptr;
+	}
+
+	/// <summary>
+	/// read the bytecode of an entry if it was compiled from the same inputs
+	/// returns 0 on success, -1 if there is no entry, -2 if it is stale or broken
+	/// </summary>
+	int Cache::ReadEntry(_In_ const std::string& path, _In_ uint64_t key, _Out_ std::vector<uint8_t>* p_bytecode) const
+	{
+		p_bytecode->clear();
+
+		FILE* p_file = std::fopen(path.c_str(), "rb");
+		if (!p_file)
+			return -1;
+
+		FileHeader header = {};
+		bool is_valid =
+			std::fread(&header, sizeof(header), 1, p_file) == 1 &&
+			header.Magic == FILE_MAGIC && header.Version == FILE_VERSION && header.Key == key &&
+			header.BytecodeSize > 0 && header.BytecodeSize <= SIZE_MAX;
+
+		if (is_valid)
+		{
+			p_bytecode->resize(static_cast<size_t>(header.BytecodeSize));
+			is_valid = std::fread(p_bytecode->data(), 1, p_bytecode->size(), p_file) == p_bytecode->size();
+		}
+		std::fclose(p_file);
+
+		if (is_valid)
+		{
+			uint64_t checksum = FNV_OFFSET_BASIS;
+			HashBytes(checksum, p_bytecode->data(), p_bytecode->size());
+			is_valid = checksum == header.Checksum;
+		}
+
+		if (!is_valid)
+		{
+			p_bytecode->clear();
+			return -2;
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// replace an entry, the bytecode is written to a temporary file first so a reader never sees half of it
+	/// returns 0 on success, -1 if the file cannot be written
+	/// </summary>
+	int Cache::WriteEntry(_In_ const std::string& path, _In_ uint64_t key, _In_ const std::vector<uint8_t>& bytecode) const
+	{
+		std::error_code error;
+		std::filesystem::create_directories(_directory, error);
+
+		FileHeader header = {};
+		header.Magic        = FILE_MAGIC;
+		header.Version      = FILE_VERSION;
+		header.Key          = key;
+		header.BytecodeSize = bytecode.size();
+		header.Checksum     = FNV_OFFSET_BASIS;
+		HashBytes(header.Checksum, bytecode.data(), bytecode.size());
+
+		const std::string temporary_path = path + ".tmp";
+		FILE* p_file = std::fopen(temporary_path.c_str(), "wb");
+		if (!p_file)
+			return -1;
+
+		bool is_written =
+			std::fwrite(&header, sizeof(header), 1, p_file) == 1 &&
+			std::fwrite(bytecode.data(), 1, bytecode.size(), p_file) == bytecode.size();
+
+		is_written = (std::fclose(p_file) == 0) && is_written;
+
+		// rename does not replace an existing file on every platform
+		std::filesystem::remove(path, error);
+		if (!is_written || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+		{
+			std::remove(temporary_path.c_str());
+			return -1;
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// load the bytecode of a shader from the cache, or compile and store it when the inputs changed
+	/// a source edited while it compiles is stored with the old key, so it is only compiled once more
+	/// </summary>
+	int Cache::Load(_In_ const Desc& desc, _Out_ std::vector<uint8_t>* p_bytecode, _Out_opt_ std::string* p_errors)
+	{
+		p_bytecode->clear();
+		if (p_errors) p_errors->clear();
+
+		const uint64_t compiler_version = _compiler->GetVersion();
+
+		uint64_t key = 0;
+		if (ComputeKey(desc, compiler_version, &key) != 0)
+		{
+			++_stats.Failures;
+			if (p_errors) *p_errors = "cannot read " + desc.Path;
+			return -1;
+		}
+
+		const std::string path = GetEntryPath(desc);
+		if (ReadEntry(path, key, p_bytecode) == 0)
+		{
+			++_stats.Hits;
+			return 0;
+		}
+
+		std::string errors;
+		if (_compiler->Compile(desc, p_bytecode, &errors) != 0 || p_bytecode->empty())
+		{
+			++_stats.Failures;
+			p_bytecode->clear();
+			if (p_errors) *p_errors = std::move(errors);
+			return -2;
+		}
+		++_stats.Compiles;
+
+		// the bytecode is still usable when the cache is read-only
+		if (WriteEntry(path, key, *p_bytecode) != 0) ++_stats.WriteFailures;
+
+		return 1;
+	}
+
+	/// <summary>
+	/// get the path of the entry of a shader
+	/// </summary>
+	std::string Cache::GetEntryPath(_In_ const Desc& desc) const
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(ComputeName(desc)));
+
+		return (std::filesystem::path(_directory) / (name + std::string(FILE_EXTENSION))).generic_string();
+	}
+
+	/// <summary>
+	/// get the loads since the cache was initialized
+	/// </summary>
+	const Stats& Cache::GetStats() const
+	{
+		return _stats;
+	}
+}
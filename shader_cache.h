@@ -0,0 +1,143 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "portable_sal.h"
+
+namespace ShaderCache
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// "CSHD" in little endian
+	constexpr uint32_t FILE_MAGIC   = 0x44485343;
+	constexpr uint32_t FILE_VERSION = 1;
+
+	// one entry per shader and its options, named by the hash of the options
+	constexpr const char* FILE_EXTENSION = ".cso";
+
+	// deeper includes are treated as a cycle
+	constexpr uint32_t MAX_INCLUDE_DEPTH = 32;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// preprocessor definition passed to the compiler
+	/// </summary>
+	struct Define
+	{
+		std::string Name;
+		std::string Value;
+	};
+
+	/// <summary>
+	/// what a shader is compiled from and how
+	/// </summary>
+	struct Desc
+	{
+		std::string Path;        // source file, the includes are resolved from its directory
+		std::string EntryPoint;
+		std::string Profile;     // e.g. "vs_5_0"
+		std::vector<Define> Defines;
+		uint32_t Flags;          // flags of the compiler
+	};
+
+	/// <summary>
+	/// header of an entry, followed by the bytecode
+	/// </summary>
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint64_t Key;            // hash of every input of the compilation
+		uint64_t BytecodeSize;
+		uint64_t Checksum;       // hash of the bytecode, a torn write is compiled again
+	};
+
+	static_assert(sizeof(FileHeader) == 32, "the file layout must not depend on the compiler");
+
+	/// <summary>
+	/// loads since the cache was initialized
+	/// </summary>
+	struct Stats
+	{
+		uint32_t Hits;
+		uint32_t Compiles;
+		uint32_t Failures;
+		uint32_t WriteFailures;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	class Compiler
+	{
+	public:
+		virtual ~Compiler() = default;
+
+		// identifies the compiler and its version, another one invalidates every entry
+		virtual uint64_t GetVersion() const = 0;
+
+		// returns 0 on success, the messages of the compiler are written on failure
+		virtual int Compile(_In_ const Desc& desc, _Out_ std::vector<uint8_t>* p_bytecode, _Out_ std::string* p_errors) = 0;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// collect the source and every file it includes, in the order they are first included
+	// every #include is followed, also the ones an #if would skip, so a file is never missed
+	// a missing include is listed too (creating it changes the key)
+	// returns 0 on success, -1 if the source cannot be read
+	int ScanDependencies(_In_ const std::string& path, _Out_ std::vector<std::string>* p_files);
+
+	// hash of the options, it names the entry (another compiler or an edited source replaces the same entry)
+	uint64_t ComputeName(_In_ const Desc& desc);
+
+	// hash of the options, the compiler and the contents of every dependency, it validates the entry
+	// returns 0 on success, -1 if the source cannot be read
+	int ComputeKey(_In_ const Desc& desc, _In_ uint64_t compilerVersion, _Out_ uint64_t* p_key);
+
+	//--------------------------------------------------------
+	// cache class
+	//--------------------------------------------------------
+	/// <summary>
+	/// compiled bytecode on disk, keyed by the hash of the sources, the defines, the profile and the flags
+	/// a matching entry is read back without the compiler, anything else compiles and replaces the entry
+	/// </summary>
+	class Cache
+	{
+		std::string _directory;
+		Compiler* _compiler;
+
+		Stats _stats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		int ReadEntry(_In_ const std::string& path, _In_ uint64_t key, _Out_ std::vector<uint8_t>* p_bytecode) const;
+		int WriteEntry(_In_ const std::string& path, _In_ uint64_t key, _In_ const std::vector<uint8_t>& bytecode) const;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Cache();
+
+		// the directory is created when the first entry is written
+		void Initialize(_In_ const std::string& directory, _In_ Compiler* compiler);
+		void Terminate();
+
+		// returns 0 if read from the cache, 1 if compiled (and stored), -1 if the source cannot be read, -2 if it does not compile
+		int Load(_In_ const Desc& desc, _Out_ std::vector<uint8_t>* p_bytecode, _Out_opt_ std::string* p_errors = nullptr);
+
+		// getter
+		std::string GetEntryPath(_In_ const Desc& desc) const;
+		const Stats& GetStats() const;
+	};
+}
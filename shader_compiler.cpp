@@ -0,0 +1,112 @@
+
+#include <windows.h>
+#include <d3dcompiler.h>
+
+#pragma comment (lib, "d3dcompiler.lib")
+
+#include "shader_compiler.h"
+
+namespace ShaderCompiler
+{
+	/// <summary>
+	/// get the compile flags of the renderer
+	/// </summary>
+	uint32_t GetCompileFlags(_In_ bool isDebug)
+	{
+		return isDebug ? (D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION) : D3DCOMPILE_ENABLE_STRICTNESS;
+	}
+
+	/// <summary>
+	/// get the description of a shader of the renderer
+	/// </summary>
+	ShaderCache::Desc GetRendererShader(_In_ RendererShader shader, _In_ bool isDebug)
+	{
+		ShaderCache::Desc desc = {};
+		desc.EntryPoint = "main";
+		desc.Flags      = GetCompileFlags(isDebug);
+
+		switch (shader)
+		{
+		case RendererShader::Vertex:
+			desc.Path    = "resource/shader/vertex_shader.hlsl";
+			desc.Profile = "vs_5_0";
+			break;
+		case RendererShader::Pixel:
+			desc.Path    = "resource/shader/pixel_shader.hlsl";
+			desc.Profile = "ps_5_0";
+			break;
+		default:
+			break;
+		}
+
+		return desc;
+	}
+
+	/// <summary>
+	/// get the description of a variant of the pixel shader
+	/// </summary>
+	ShaderCache::Desc GetPixelShaderVariant(_In_ ShaderPermutation::Key key, _In_ bool isDebug)
+	{
+		ShaderCache::Desc desc = GetRendererShader(RendererShader::Pixel, isDebug);
+		ShaderPermutation::GetDefines(key, &desc.Defines);
+
+		return desc;
+	}
+
+	/// <summary>
+	/// get the version of the compiler the bytecode comes from
+	/// </summary>
+	uint64_t Compiler::GetVersion() const
+	{
+		return D3D_COMPILER_VERSION;
+	}
+
+	/// <summary>
+	/// compile a shader with D3DCompileFromFile
+	/// </summary>
+	int Compiler::Compile(_In_ const ShaderCache::Desc& desc, _Out_ std::vector<uint8_t>* p_bytecode, _Out_ std::string* p_errors)
+	{
+		p_bytecode->clear();
+		p_errors->clear();
+
+		// the path is given in the code page of the process
+		const int length = MultiByteToWideChar(CP_ACP, 0, desc.Path.c_str(), -1, nullptr, 0);
+		if (length <= 0)
+			return -1;
+
+		std::wstring path(static_cast<size_t>(length), L'\0');
+		MultiByteToWideChar(CP_ACP, 0, desc.Path.c_str(), -1, &path[0], length);
+
+		// terminated by a null macro
+		std::vector<D3D_SHADER_MACRO> macros;
+		for (const ShaderCache::Define& define : desc.Defines)
+		{
+			macros.push_back({ define.Name.c_str(), define.Value.c_str() });
+		}
+		macros.push_back({ nullptr, nullptr });
+
+		ID3DBlob* p_code = nullptr;
+		ID3DBlob* p_error = nullptr;
+		HRESULT h_result = D3DCompileFromFile(path.c_str(), macros.data(), D3D_COMPILE_STANDARD_FILE_INCLUDE,
+			desc.EntryPoint.c_str(), desc.Profile.c_str(), desc.Flags, 0, &p_code, &p_error);
+
+		if (p_error)
+		{
+			p_errors->assign(static_cast<const char*>(p_error->GetBufferPointer()), p_error->GetBufferSize());
+			p_error->Release();
+		}
+
+		if (FAILED(h_result) || !p_code)
+		{
+			if (p_code) p_code->Release();
+			if (p_errors->empty()) *p_errors = "cannot compile " + desc.Path;
+			return -1;
+		}
+
+		const uint8_t* p_data = static_cast<const uint8_t*>(p_code->GetBufferPointer());
+		p_bytecode->assign(p_data, p_data + p_code->GetBufferSize());
+		p_code->Release();
+
+		return 0;
+	}
+}
@@ -0,0 +1,55 @@
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shader_cache.h"
+#include "shader_permutation.h"
+
+namespace ShaderCompiler
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// the renderer and the precompile command share the cache
+	constexpr const char* CACHE_DIRECTORY = "resource/shader/cache";
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// shaders the renderer creates at startup
+	/// </summary>
+	enum class RendererShader
+	{
+		Vertex,
+		Pixel,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// the debug build compiles with debug information and without optimization
+	uint32_t GetCompileFlags(_In_ bool isDebug);
+	ShaderCache::Desc GetRendererShader(_In_ RendererShader shader, _In_ bool isDebug);
+
+	// the pixel shader specialized for the features of a material
+	ShaderCache::Desc GetPixelShaderVariant(_In_ ShaderPermutation::Key key, _In_ bool isDebug);
+
+	//--------------------------------------------------------
+	// compiler class
+	//--------------------------------------------------------
+	/// <summary>
+	/// compiles HLSL with D3DCompileFromFile, the includes are resolved next to the including file
+	/// </summary>
+	class Compiler : public ShaderCache::Compiler
+	{
+	public:
+		uint64_t GetVersion() const override;
+		int Compile(_In_ const ShaderCache::Desc& desc, _Out_ std::vector<uint8_t>* p_bytecode, _Out_ std::string* p_errors) override;
+	};
+}
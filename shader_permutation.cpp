@@ -0,0 +1,196 @@
+
+#include <fstream>
+
+#include "shader_permutation.h"
+
+namespace ShaderPermutation
+{
+	namespace
+	{
+		/// <summary>
+		/// name and define of a feature
+		/// </summary>
+		struct FeatureInfo
+		{
+			Feature Flag;
+			const char* Name;
+			const char* Define;
+		};
+
+		constexpr FeatureInfo FEATURE_INFOS[FEATURE_COUNT] =
+		{
+			{ FEATURE_TEXTURED,      "textured",      "FEATURE_TEXTURED" },
+			{ FEATURE_ALPHA_TEST,    "alpha_test",    "FEATURE_ALPHA_TEST" },
+			{ FEATURE_TINT,          "tint",          "FEATURE_TINT" },
+			{ FEATURE_PREMULTIPLIED, "premultiplied", "FEATURE_PREMULTIPLIED" },
+		};
+
+		/// <summary>
+		/// get the information of a feature, nullptr if it is not one flag
+		/// </summary>
+		const FeatureInfo* FindFeature(Feature feature)
+		{
+			for (const FeatureInfo& info : FEATURE_INFOS)
+			{
+				if (info.Flag == feature) return &info;
+			}
+			return nullptr;
+		}
+
+		/// <summary>
+		/// trim spaces and tabs from both ends
+		/// </summary>
+		std::string Trim(const std::string& text)
+		{
+			const size_t begin = text.find_first_not_of(" \t\r");
+			if (begin == std::string::npos)
+				return std::string();
+
+			const size_t end = text.find_last_not_of(" \t\r");
+			return text.substr(begin, end - begin + 1);
+		}
+	}
+
+	/// <summary>
+	/// get the name of a feature in the manifest
+	/// </summary>
+	const char* GetFeatureName(_In_ Feature feature)
+	{
+		const FeatureInfo* p_info = FindFeature(feature);
+		return p_info ? p_info->Name : "";
+	}
+
+	/// <summary>
+	/// get the define of a feature in the shader
+	/// </summary>
+	const char* GetFeatureDefine(_In_ Feature feature)
+	{
+		const FeatureInfo* p_info = FindFeature(feature);
+		return p_info ? p_info->Define : "";
+	}
+
+	/// <summary>
+	/// get the defines of a variant
+	/// </summary>
+	void GetDefines(_In_ Key key, _Out_ std::vector<ShaderCache::Define>* p_defines)
+	{
+		p_defines->clear();
+		for (const FeatureInfo& info : FEATURE_INFOS)
+		{
+			p_defines->push_back({ info.Define, (key & info.Flag) ? "1" : "0" });
+		}
+	}
+
+	/// <summary>
+	/// get the name of a variant
+	/// </summary>
+	std::string GetKeyName(_In_ Key key)
+	{
+		std::string name;
+		for (const FeatureInfo& info : FEATURE_INFOS)
+		{
+			if (!(key & info.Flag)) continue;
+
+			if (!name.empty()) name += '+';
+			name += info.Name;
+		}
+
+		return name.empty() ? "none" : name;
+	}
+
+	/// <summary>
+	/// get the variant of a material in a straight or a premultiplied pipeline
+	/// </summary>
+	Key GetPipelineKey(_In_ Key key, _In_ bool isPremultipliedAlpha)
+	{
+		return isPremultipliedAlpha ? (key & ~static_cast<Key>(FEATURE_PREMULTIPLIED)) : key;
+	}
+
+	/// <summary>
+	/// parse the name of a variant
+	/// </summary>
+	int ParseKey(_In_ const std::string& name, _Out_ Key* p_key)
+	{
+		*p_key = 0;
+
+		const std::string trimmed = Trim(name);
+		if (trimmed == "none")
+			return 0;
+
+		size_t begin = 0;
+		for (;;)
+		{
+			const size_t end = trimmed.find('+', begin);
+			const std::string feature = Trim(trimmed.substr(begin, end - begin));
+
+			const FeatureInfo* p_found = nullptr;
+			for (const FeatureInfo& info : FEATURE_INFOS)
+			{
+				if (feature == info.Name) p_found = &info;
+			}
+			if (!p_found)
+			{
+				*p_key = 0;
+				return -1;
+			}
+			*p_key |= p_found->Flag;
+
+			if (end == std::string::npos) break;
+			begin = end + 1;
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// load the variants of a manifest
+	/// </summary>
+	int LoadManifest(_In_ const std::string& path, _Out_ std::vector<Key>* p_keys)
+	{
+		p_keys->clear();
+
+		std::ifstream stream(path);
+		if (!stream)
+			return -1;
+
+		bool is_listed[VARIANT_COUNT] = {};
+
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			line = Trim(line);
+			if (line.empty() || line[0] == '#') continue;
+
+			Key key = 0;
+			if (ParseKey(line, &key) != 0)
+			{
+				p_keys->clear();
+				return -2;
+			}
+
+			if (is_listed[key]) continue;
+			is_listed[key] = true;
+			p_keys->push_back(key);
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// save the variants to a manifest
+	/// </summary>
+	int SaveManifest(_In_ const std::string& path, _In_ const std::vector<Key>& keys)
+	{
+		std::ofstream stream(path);
+		if (!stream)
+			return -1;
+
+		stream << MANIFEST_HEADER << '\n';
+		for (Key key : keys)
+		{
+			stream << GetKeyName(key & FEATURE_ALL) << '\n';
+		}
+
+		return stream ? 0 : -1;
+	}
+}
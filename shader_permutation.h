@@ -0,0 +1,71 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "portable_sal.h"
+#include "shader_cache.h"
+
+namespace ShaderPermutation
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// features of a material, each combination is its own pixel shader
+	using Key = uint32_t;
+
+	// the variants the application ships, compiled at startup and by the precompile command
+	constexpr const char* MANIFEST_PATH = "resource/shader/permutations.txt";
+	constexpr const char* MANIFEST_HEADER = "# shader permutations: one variant per line, features separated by '+' (or none)";
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// features of the pixel shader (bit flags)
+	/// </summary>
+	enum Feature : uint32_t
+	{
+		FEATURE_TEXTURED      = 1 << 0,  // multiply the texture
+		FEATURE_ALPHA_TEST    = 1 << 1,  // discard below the alpha threshold of the material
+		FEATURE_TINT          = 1 << 2,  // multiply the diffuse of the material
+		FEATURE_PREMULTIPLIED = 1 << 3,  // write the color multiplied by its alpha (straight colors and texels only)
+
+		FEATURE_COUNT = 4,
+		FEATURE_ALL   = (1 << FEATURE_COUNT) - 1
+	};
+
+	// every combination of the features
+	constexpr uint32_t VARIANT_COUNT = 1 << FEATURE_COUNT;
+
+	// the material of the sprites, and the variant used when the manifest cannot be read
+	constexpr Key DEFAULT_KEY = FEATURE_TEXTURED | FEATURE_TINT;
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// name in the manifest (e.g. "alpha_test"), and the define of the shader (e.g. "FEATURE_ALPHA_TEST")
+	const char* GetFeatureName(_In_ Feature feature);
+	const char* GetFeatureDefine(_In_ Feature feature);
+
+	// every feature is defined to 0 or 1, so the shader tests them with #if
+	void GetDefines(_In_ Key key, _Out_ std::vector<ShaderCache::Define>* p_defines);
+
+	// "textured+tint", or "none"
+	std::string GetKeyName(_In_ Key key);
+
+	// the variant a material is drawn with, a premultiplied pipeline multiplies the colors and texels by alpha
+	// before the pixel shader, so the premultiplied feature is dropped there instead of multiplying them twice
+	Key GetPipelineKey(_In_ Key key, _In_ bool isPremultipliedAlpha);
+
+	// returns 0 on success, -1 if a feature is unknown
+	int ParseKey(_In_ const std::string& name, _Out_ Key* p_key);
+
+	// the variants in the order of the manifest, without duplicates
+	// returns 0 on success, -1 if the file cannot be read, -2 on an invalid line
+	int LoadManifest(_In_ const std::string& path, _Out_ std::vector<Key>* p_keys);
+	int SaveManifest(_In_ const std::string& path, _In_ const std::vector<Key>& keys);
+}
@@ -0,0 +1,361 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "quad_kernel.h"
+#include "software_renderer.h"
+#include "thread_pool.h"
+
+namespace SoftwareRenderer
+{
+	/// <summary>
+	/// constructor for software renderer
+	/// </summary>
+	Manager::Manager()
+	{
+		_width  = 0;
+		_height = 0;
+		_isClearPending = false;
+
+		_tilesX = 0;
+		_tilesY = 0;
+
+		_cullMode = Renderer::CullMode::Back;
+		_fillMode = Renderer::FillMode::Solid;
+
+		_blendMode       = Renderer::BlendMode::AlphaBlend;
+		_depthEnableMode = Renderer::DepthEnebleMode::Enable;
+
+		for (int i = 0; i < 16; ++i) _matrix[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+
+		_texture = nullptr;
+		for (float& d : _diffuse) d = 1.0f;
+		_alphaThreshold = 0.0f;
+		_features = ShaderPermutation::DEFAULT_KEY;
+		_materials = nullptr;
+
+		_isStateDirty = true;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+		_frameCount     = 0;
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// initialization process for software renderer
+	/// </summary>
+	int Manager::Initialize(_In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t ringCapacityQuads)
+	{
+		if (width == 0 || height == 0) return -1;
+
+		_width  = width;
+		_height = height;
+
+		// render target
+		_colorBuffer.assign(static_cast<size_t>(width) * height, 0);
+		_frontBuffer.assign(static_cast<size_t>(width) * height, 0);
+		_depthBuffer.assign(static_cast<size_t>(width) * height, 1.0f);
+
+		// tiles
+		_tilesX = (width  + TILE_SIZE - 1) / TILE_SIZE;
+		_tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+		_bins.assign(static_cast<size_t>(_tilesX) * _tilesY, {});
+
+		_ring.resize(ringCapacityQuads);
+
+		// same initial states as the hardware renderer
+		SetRasterizerState(Renderer::CullMode::Back, Renderer::FillMode::Solid);
+		SetBlendMode(Renderer::BlendMode::AlphaBlend);
+		SetDepthEnableState(Renderer::DepthEnebleMode::Enable);
+		SetMatrixWorldViewProjection2D();
+
+		// the pixel shader starts from the default material, nothing is kept from the previous initialization
+		const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+		SetTexture(nullptr);
+		SetMaterial(white, ShaderPermutation::DEFAULT_KEY);
+		SetMaterialTable(nullptr);
+
+		ThreadPool::Manager::Instance().Initialize();
+
+		return 0;
+	}
+
+	/// <summary>
+	/// termination process for software renderer
+	/// </summary>
+	void Manager::Terminate()
+	{
+		_colorBuffer.clear();
+		_frontBuffer.clear();
+		_depthBuffer.clear();
+		_bins.clear();
+		_triangles.clear();
+		_drawStates.clear();
+		_ring.clear();
+
+		// the texture and the material table belong to the caller and may not outlive the renderer
+		_texture   = nullptr;
+		_materials = nullptr;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// clear view interfaces
+	/// the tiles clear themselves before the next rasterization
+	/// </summary>
+	void Manager::ClearViews()
+	{
+		Flush();
+		_isClearPending = true;
+	}
+
+	/// <summary>
+	/// rasterize all binned triangles, one tile per task
+	/// </summary>
+	void Manager::Flush()
+	{
+		if (_triangles.empty() && !_isClearPending) return;
+
+		ThreadPool::Manager::Instance().ParallelFor(_bins.size(), [this](size_t tile)
+		{
+			RasterizeTile(static_cast<uint32_t>(tile));
+		});
+
+		_frameStats.Tiles += static_cast<uint32_t>(_bins.size());
+
+		// the states stay bound, but the recorded snapshots are no longer referenced
+		_triangles.clear();
+		_drawStates.clear();
+		_isStateDirty   = true;
+		_isClearPending = false;
+	}
+
+	/// <summary>
+	/// flip frame buffer
+	/// </summary>
+	void Manager::FlipFrameBuffer()
+	{
+		Flush();
+
+		// the back buffer becomes the presented frame
+		_colorBuffer.swap(_frontBuffer);
+
+		_lastFrameStats = _frameStats;
+		_frameStats = {};
+		_frameCount++;
+	}
+
+	/// <summary>
+	/// get the snapshot of the current states for the next triangles
+	/// </summary>
+	uint32_t Manager::GetDrawState()
+	{
+		if (_isStateDirty)
+		{
+			DrawState state;
+			state.Blend         = _blendMode;
+			state.DepthWrite    = (_depthEnableMode == Renderer::DepthEnebleMode::Enable);
+			state.Fill          = _fillMode;
+			state.SourceTexture = _texture;
+			for (int i = 0; i < 4; ++i) state.Diffuse[i] = _diffuse[i];
+			state.AlphaThreshold = _alphaThreshold;
+			state.Features       = _features;
+
+			_drawStates.push_back(state);
+			_isStateDirty = false;
+		}
+
+		return static_cast<uint32_t>(_drawStates.size() - 1);
+	}
+
+	/// <summary>
+	/// vertex processing, culling and binning of a triangle
+	/// </summary>
+	void Manager::SetupTriangle(_In_ const SpriteBatch::QuadVertex& v0, _In_ const SpriteBatch::QuadVertex& v1, _In_ const SpriteBatch::QuadVertex& v2, _In_ uint32_t state)
+	{
+		_frameStats.Triangles++;
+
+		const SpriteBatch::QuadVertex* p_vertex[3] = { &v0, &v1, &v2 };
+		Triangle triangle;
+		float attribute[3][ATTRIBUTE_COUNT];
+
+		//-----------------------------------
+		// vertex shader and viewport
+		//-----------------------------------
+		for (int v = 0; v < 3; ++v)
+		{
+			const float* p = p_vertex[v]->Position;
+			float clip[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				clip[c] = p[0] * _matrix[c] + p[1] * _matrix[4 + c] + p[2] * _matrix[8 + c] + _matrix[12 + c];
+			}
+
+			// behind the eye
+			if (clip[3] <= 0.0f)
+			{
+				_frameStats.CulledTriangles++;
+				return;
+			}
+
+			float inv_w = 1.0f / clip[3];
+			float screen_x = (clip[0] * inv_w + 1.0f) * 0.5f * static_cast<float>(_width);
+			float screen_y = (1.0f - clip[1] * inv_w) * 0.5f * static_cast<float>(_height);
+
+			triangle.X[v] = static_cast<int32_t>(std::lround(screen_x * SUBPIXEL_SCALE));
+			triangle.Y[v] = static_cast<int32_t>(std::lround(screen_y * SUBPIXEL_SCALE));
+
+			attribute[v][ATTRIBUTE_DEPTH] = clip[2] * inv_w;
+			for (int c = 0; c < 4; ++c) attribute[v][ATTRIBUTE_COLOR + c] = p_vertex[v]->Color[c];
+			for (int c = 0; c < 2; ++c) attribute[v][ATTRIBUTE_TEXCOORD + c] = p_vertex[v]->Texcoord[c];
+		}
+
+		//-----------------------------------
+		// culling
+		//-----------------------------------
+		// positive area is clockwise on the screen, which is the front face
+		int64_t area = static_cast<int64_t>(triangle.X[1] - triangle.X[0]) * (triangle.Y[2] - triangle.Y[0])
+			- static_cast<int64_t>(triangle.Y[1] - triangle.Y[0]) * (triangle.X[2] - triangle.X[0]);
+
+		bool is_culled = (area == 0)
+			|| (_cullMode == Renderer::CullMode::Back  && area < 0)
+			|| (_cullMode == Renderer::CullMode::Front && area > 0);
+		if (is_culled)
+		{
+			_frameStats.CulledTriangles++;
+			return;
+		}
+
+		// the rasterizer expects a positive area
+		if (area < 0)
+		{
+			std::swap(triangle.X[1], triangle.X[2]);
+			std::swap(triangle.Y[1], triangle.Y[2]);
+			std::swap(attribute[1], attribute[2]);
+			area = -area;
+		}
+		triangle.Area = area;
+
+		//-----------------------------------
+		// attribute planes (linear in screen space, the 2D projection is orthographic)
+		//-----------------------------------
+		{
+			constexpr float INV_SUBPIXEL = 1.0f / SUBPIXEL_SCALE;
+			const float x0 = triangle.X[0] * INV_SUBPIXEL, y0 = triangle.Y[0] * INV_SUBPIXEL;
+			const float x1 = triangle.X[1] * INV_SUBPIXEL - x0, y1 = triangle.Y[1] * INV_SUBPIXEL - y0;
+			const float x2 = triangle.X[2] * INV_SUBPIXEL - x0, y2 = triangle.Y[2] * INV_SUBPIXEL - y0;
+			const float inv_det = 1.0f / (x1 * y2 - x2 * y1);
+
+			for (int a = 0; a < ATTRIBUTE_COUNT; ++a)
+			{
+				const float d1 = attribute[1][a] - attribute[0][a];
+				const float d2 = attribute[2][a] - attribute[0][a];
+				const float dadx = (d1 * y2 - d2 * y1) * inv_det;
+				const float dady = (d2 * x1 - d1 * x2) * inv_det;
+
+				triangle.Plane[a][0] = attribute[0][a] - dadx * x0 - dady * y0;
+				triangle.Plane[a][1] = dadx;
+				triangle.Plane[a][2] = dady;
+			}
+		}
+
+		//-----------------------------------
+		// bounds and binning
+		//-----------------------------------
+		int min_x = (std::min({ triangle.X[0], triangle.X[1], triangle.X[2] })) >> SUBPIXEL_BITS;
+		int min_y = (std::min({ triangle.Y[0], triangle.Y[1], triangle.Y[2] })) >> SUBPIXEL_BITS;
+		int max_x = (std::max({ triangle.X[0], triangle.X[1], triangle.X[2] })) >> SUBPIXEL_BITS;
+		int max_y = (std::max({ triangle.Y[0], triangle.Y[1], triangle.Y[2] })) >> SUBPIXEL_BITS;
+
+		triangle.MinX = std::max(min_x, 0);
+		triangle.MinY = std::max(min_y, 0);
+		triangle.MaxX = std::min(max_x, static_cast<int>(_width)  - 1);
+		triangle.MaxY = std::min(max_y, static_cast<int>(_height) - 1);
+
+		if (triangle.MinX > triangle.MaxX || triangle.MinY > triangle.MaxY)
+		{
+			_frameStats.CulledTriangles++;
+			return;
+		}
+
+		triangle.State = state;
+
+		uint32_t index = static_cast<uint32_t>(_triangles.size());
+		_triangles.push_back(triangle);
+
+		for (int ty = triangle.MinY / TILE_SIZE; ty <= triangle.MaxY / TILE_SIZE; ++ty)
+		{
+			for (int tx = triangle.MinX / TILE_SIZE; tx <= triangle.MaxX / TILE_SIZE; ++tx)
+			{
+				_bins[static_cast<size_t>(ty) * _tilesX + tx].push_back(index);
+				_frameStats.BinnedTriangles++;
+			}
+		}
+	}
+
+	/// <summary>
+	/// draw a triangle strip
+	/// </summary>
+	void Manager::Draw(_In_ const SpriteBatch::QuadVertex* vertices, _In_ uint32_t vertexCount)
+	{
+		uint32_t state = GetDrawState();
+
+		for (uint32_t i = 0; i + 2 < vertexCount; ++i)
+		{
+			// odd triangles swap the first two vertices to keep the winding
+			if (i & 1) SetupTriangle(vertices[i + 1], vertices[i], vertices[i + 2], state);
+			else       SetupTriangle(vertices[i], vertices[i + 1], vertices[i + 2], state);
+		}
+	}
+
+	/// <summary>
+	/// map the ring buffer of the sprite batch
+	/// </summary>
+	SpriteBatch::SpriteInstance* Manager::MapRing(bool)
+	{
+		return _ring.data();
+	}
+
+	/// <summary>
+	/// unmap the ring buffer of the sprite batch
+	/// </summary>
+	void Manager::UnmapRing()
+	{
+	}
+
+	/// <summary>
+	/// draw a run of instances from the sprite batch, expanded as the vertex shader does
+	/// </summary>
+	void Manager::DrawRun(const SpriteBatch::Run& run)
+	{
+		SetTexture(reinterpret_cast<const Texture*>(run.Texture));
+		SetBlendMode(run.Blend);
+
+		SpriteBatch::QuadVertex vertices[SpriteBatch::VERTICES_PER_QUAD];
+		MaterialTable::Index bound_material = MaterialTable::INVALID_INDEX;
+		for (uint32_t q = 0; q < run.QuadCount; ++q)
+		{
+			const SpriteBatch::SpriteInstance& instance = _ring[run.FirstQuad + q];
+
+			// the slot of each instance, as the pixel shader reads it from the table
+			if (_materials && instance.Material != bound_material)
+			{
+				const MaterialTable::Constants& constants = _materials->GetConstants(instance.Material);
+				SetMaterial(constants.Diffuse, run.Features, constants.AlphaThreshold);
+				bound_material = instance.Material;
+			}
+
+			QuadKernel::ExpandInstance(instance, vertices);
+			Draw(vertices, SpriteBatch::VERTICES_PER_QUAD);
+		}
+	}
+}
@@ -0,0 +1,201 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "material_table.h"
+#include "portable_sal.h"
+#include "renderer_types.h"
+#include "shader_permutation.h"
+#include "sprite_batch_core.h"
+
+namespace SoftwareRenderer
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// the screen is split into square tiles which are rasterized in parallel
+	constexpr int TILE_SIZE = 64;
+
+	// sub-pixel precision of the vertex positions
+	constexpr int SUBPIXEL_BITS  = 4;
+	constexpr int SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+
+	// interpolated attributes: depth, color (rgba) and texcoord (uv)
+	constexpr int ATTRIBUTE_DEPTH    = 0;
+	constexpr int ATTRIBUTE_COLOR    = 1;
+	constexpr int ATTRIBUTE_TEXCOORD = 5;
+	constexpr int ATTRIBUTE_COUNT    = 7;
+
+	// clear color for back buffer (same as the hardware renderer)
+	constexpr float CLEAR_COLOR[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// RGBA8 texture in system memory (red is the lowest byte)
+	/// </summary>
+	struct Texture
+	{
+		uint32_t Width;
+		uint32_t Height;
+		std::vector<uint32_t> Texels;
+	};
+
+	/// <summary>
+	/// statistics of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Triangles;
+		uint32_t CulledTriangles;
+		uint32_t BinnedTriangles;
+		uint32_t Tiles;
+	};
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager : public SpriteBatch::Backend
+	{
+		/// <summary>
+		/// pipeline states referenced by the binned triangles
+		/// </summary>
+		struct DrawState
+		{
+			Renderer::BlendMode Blend;
+			bool DepthWrite;
+			Renderer::FillMode Fill;
+			const Texture* SourceTexture;
+			float Diffuse[4];
+			float AlphaThreshold;
+			ShaderPermutation::Key Features;
+		};
+
+		/// <summary>
+		/// triangle after vertex processing and setup
+		/// </summary>
+		struct Triangle
+		{
+			// fixed point screen position with positive area
+			int32_t X[3];
+			int32_t Y[3];
+			int64_t Area;
+
+			// attribute planes: value = a + dadx * x + dady * y at the pixel center
+			float Plane[ATTRIBUTE_COUNT][3];
+
+			// pixel bounds
+			int MinX, MinY, MaxX, MaxY;
+
+			uint32_t State;
+		};
+
+		// render target
+		uint32_t _width;
+		uint32_t _height;
+		std::vector<uint32_t> _colorBuffer;
+		std::vector<uint32_t> _frontBuffer;
+		std::vector<float> _depthBuffer;
+		bool _isClearPending;
+
+		// tiles
+		uint32_t _tilesX;
+		uint32_t _tilesY;
+		std::vector<std::vector<uint32_t>> _bins;
+
+		// rasterizer
+		Renderer::CullMode _cullMode;
+		Renderer::FillMode _fillMode;
+
+		// output merger
+		Renderer::BlendMode _blendMode;
+		Renderer::DepthEnebleMode _depthEnableMode;
+
+		// world-view-projection (row vector times matrix, like the hlsl mul)
+		float _matrix[16];
+
+		// pixel shader
+		const Texture* _texture;
+		float _diffuse[4];
+		float _alphaThreshold;
+		ShaderPermutation::Key _features;
+
+		// materials of the instances of the sprite batch, without a table the bound material is kept
+		const MaterialTable::Table* _materials;
+
+		// recorded work of the frame
+		std::vector<DrawState> _drawStates;
+		std::vector<Triangle> _triangles;
+		bool _isStateDirty;
+
+		// ring buffer for the sprite batch
+		std::vector<SpriteBatch::SpriteInstance> _ring;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+		uint64_t _frameCount;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		uint32_t GetDrawState();
+		void SetupTriangle(_In_ const SpriteBatch::QuadVertex& v0, _In_ const SpriteBatch::QuadVertex& v1, _In_ const SpriteBatch::QuadVertex& v2, _In_ uint32_t state);
+
+		void RasterizeTile(_In_ uint32_t tile);
+		void RasterizeTriangle(_In_ const Triangle& triangle, _In_ int tileMinX, _In_ int tileMinY, _In_ int tileMaxX, _In_ int tileMaxY);
+		void RasterizeWireframe(_In_ const Triangle& triangle, _In_ int tileMinX, _In_ int tileMinY, _In_ int tileMaxX, _In_ int tileMaxY);
+
+		// one specialization per variant of the pixel shader, chosen per triangle (same as the hlsl permutations)
+		template <ShaderPermutation::Key FEATURES>
+		void RasterizeTriangleVariant(_In_ const Triangle& triangle, _In_ int tileMinX, _In_ int tileMinY, _In_ int tileMaxX, _In_ int tileMaxY);
+		template <ShaderPermutation::Key FEATURES>
+		static void ShadePixel(_In_ const DrawState& state, _Inout_ uint32_t* p_color, _Inout_ float* p_depth, _In_ const float (&attribute)[ATTRIBUTE_COUNT]);
+
+		// backend
+		SpriteBatch::SpriteInstance* MapRing(bool discard) override;
+		void UnmapRing() override;
+		void DrawRun(const SpriteBatch::Run& run) override;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		int Initialize(_In_ uint32_t width = Renderer::SCREEN_RESOLUTION_WIDTH, _In_ uint32_t height = Renderer::SCREEN_RESOLUTION_HEIGHT,
+			_In_ uint32_t ringCapacityQuads = SpriteBatch::DEFAULT_RING_CAPACITY_QUADS);
+		void Terminate();
+
+		void ClearViews();
+		void Flush();
+		void FlipFrameBuffer();
+
+		// setter
+		void SetRasterizerState(_In_ const Renderer::CullMode& cullMode, _In_ const Renderer::FillMode& fillMode);
+		void SetCullingMode(_In_ const Renderer::CullMode& cullMode);
+		void SetFillingMode(_In_ const Renderer::FillMode& fillMode);
+
+		void SetBlendMode(_In_ const Renderer::BlendMode& blendMode);
+		void SetDepthEnableState(_In_ const Renderer::DepthEnebleMode& depthEnableMode);
+
+		void SetMatrixWorldViewProjection2D();
+		void SetTexture(_In_opt_ const Texture* texture);
+		void SetMaterial(_In_ const float (&diffuse)[4], _In_ ShaderPermutation::Key features, _In_ float alphaThreshold = 0.0f);
+		void SetMaterialTable(_In_opt_ const MaterialTable::Table* p_materials);
+
+		// draw a triangle strip
+		void Draw(_In_ const SpriteBatch::QuadVertex* vertices, _In_ uint32_t vertexCount);
+
+		// getter
+		const uint32_t* GetFrameBuffer() const;
+		uint32_t GetWidth() const;
+		uint32_t GetHeight() const;
+		uint64_t GetFrameCount() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
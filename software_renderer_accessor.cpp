@@ -0,0 +1,151 @@
+
+#include "software_renderer.h"
+
+namespace SoftwareRenderer
+{
+	//--------------------------------------------------------
+	// setter
+	//--------------------------------------------------------
+	/// <summary>
+	/// set up the Rasterizer state
+	/// </summary>
+	void Manager::SetRasterizerState(_In_ const Renderer::CullMode& cullMode, _In_ const Renderer::FillMode& fillMode)
+	{
+		_cullMode = cullMode;
+		_fillMode = fillMode;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// set up the culling mode
+	/// </summary>
+	void Manager::SetCullingMode(_In_ const Renderer::CullMode& cullMode)
+	{
+		// culling is done at setup, so the snapshot does not change
+		_cullMode = cullMode;
+	}
+
+	/// <summary>
+	/// set up the filling mode
+	/// </summary>
+	void Manager::SetFillingMode(_In_ const Renderer::FillMode& fillMode)
+	{
+		if (_fillMode == fillMode) return;
+
+		_fillMode = fillMode;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// set up the blending mode
+	/// </summary>
+	void Manager::SetBlendMode(_In_ const Renderer::BlendMode& blendMode)
+	{
+		if (_blendMode == blendMode) return;
+
+		_blendMode = blendMode;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// set up the depth enable mode
+	/// </summary>
+	void Manager::SetDepthEnableState(_In_ const Renderer::DepthEnebleMode& depthEnableMode)
+	{
+		if (_depthEnableMode == depthEnableMode) return;
+
+		_depthEnableMode = depthEnableMode;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// set MVP matrix for 2D (same projection as the hardware renderer)
+	/// </summary>
+	void Manager::SetMatrixWorldViewProjection2D()
+	{
+		// orthographic off center, left-handed, (0, 0) is the top left of the window
+		const float w = static_cast<float>(Renderer::SCREEN_SIZE_WIDTH);
+		const float h = static_cast<float>(Renderer::SCREEN_SIZE_HEIGHT);
+
+		for (float& m : _matrix) m = 0.0f;
+		_matrix[0]  =  2.0f / w;
+		_matrix[5]  = -2.0f / h;
+		_matrix[10] =  1.0f;
+		_matrix[12] = -1.0f;
+		_matrix[13] =  1.0f;
+		_matrix[15] =  1.0f;
+	}
+
+	/// <summary>
+	/// set the texture of the pixel shader
+	/// </summary>
+	void Manager::SetTexture(_In_opt_ const Texture* texture)
+	{
+		if (_texture == texture) return;
+
+		_texture = texture;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// set the material and the variant of the pixel shader
+	/// </summary>
+	void Manager::SetMaterial(_In_ const float (&diffuse)[4], _In_ ShaderPermutation::Key features, _In_ float alphaThreshold)
+	{
+		for (int i = 0; i < 4; ++i) _diffuse[i] = diffuse[i];
+		_alphaThreshold = alphaThreshold;
+		_features = features & ShaderPermutation::FEATURE_ALL;
+		_isStateDirty = true;
+	}
+
+	/// <summary>
+	/// set the material table the instances of the sprite batch are drawn with
+	/// </summary>
+	void Manager::SetMaterialTable(_In_opt_ const MaterialTable::Table* p_materials)
+	{
+		_materials = p_materials;
+	}
+
+	//--------------------------------------------------------
+	// getter
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the last presented frame (RGBA8)
+	/// </summary>
+	const uint32_t* Manager::GetFrameBuffer() const
+	{
+		return _frontBuffer.data();
+	}
+
+	/// <summary>
+	/// get width of the render target
+	/// </summary>
+	uint32_t Manager::GetWidth() const
+	{
+		return _width;
+	}
+
+	/// <summary>
+	/// get height of the render target
+	/// </summary>
+	uint32_t Manager::GetHeight() const
+	{
+		return _height;
+	}
+
+	/// <summary>
+	/// get the number of presented frames
+	/// </summary>
+	uint64_t Manager::GetFrameCount() const
+	{
+		return _frameCount;
+	}
+
+	/// <summary>
+	/// get statistics of the last presented frame
+	/// </summary>
+	const FrameStats& Manager::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
@@ -0,0 +1,338 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "software_renderer.h"
+
+namespace SoftwareRenderer
+{
+	namespace
+	{
+		/// <summary>
+		/// unpack RGBA8 to float
+		/// </summary>
+		inline void UnpackColor(uint32_t packed, float (&color)[4])
+		{
+			constexpr float INV_255 = 1.0f / 255.0f;
+			color[0] = static_cast<float>( packed        & 0xff) * INV_255;
+			color[1] = static_cast<float>((packed >>  8) & 0xff) * INV_255;
+			color[2] = static_cast<float>((packed >> 16) & 0xff) * INV_255;
+			color[3] = static_cast<float>((packed >> 24) & 0xff) * INV_255;
+		}
+
+		/// <summary>
+		/// saturate and pack float to RGBA8
+		/// </summary>
+		inline uint32_t PackColor(const float (&color)[4])
+		{
+			uint32_t packed = 0;
+			for (int c = 0; c < 4; ++c)
+			{
+				float v = std::min(std::max(color[c], 0.0f), 1.0f);
+				packed |= static_cast<uint32_t>(v * 255.0f + 0.5f) << (c * 8);
+			}
+			return packed;
+		}
+
+		/// <summary>
+		/// bilinear sampling with wrap addressing
+		/// an unbound texture reads as zero like the hardware
+		/// </summary>
+		inline void SampleTexture(const Texture* texture, float u, float v, float (&texel)[4])
+		{
+			if (!texture || texture->Texels.empty())
+			{
+				texel[0] = texel[1] = texel[2] = texel[3] = 0.0f;
+				return;
+			}
+
+			const int w = static_cast<int>(texture->Width);
+			const int h = static_cast<int>(texture->Height);
+
+			float fx = u * static_cast<float>(w) - 0.5f;
+			float fy = v * static_cast<float>(h) - 0.5f;
+			float floor_x = std::floor(fx);
+			float floor_y = std::floor(fy);
+			float ax = fx - floor_x;
+			float ay = fy - floor_y;
+
+			int x0 = static_cast<int>(floor_x) % w; if (x0 < 0) x0 += w;
+			int y0 = static_cast<int>(floor_y) % h; if (y0 < 0) y0 += h;
+			int x1 = (x0 + 1 == w) ? 0 : x0 + 1;
+			int y1 = (y0 + 1 == h) ? 0 : y0 + 1;
+
+			float c00[4], c10[4], c01[4], c11[4];
+			UnpackColor(texture->Texels[static_cast<size_t>(y0) * w + x0], c00);
+			UnpackColor(texture->Texels[static_cast<size_t>(y0) * w + x1], c10);
+			UnpackColor(texture->Texels[static_cast<size_t>(y1) * w + x0], c01);
+			UnpackColor(texture->Texels[static_cast<size_t>(y1) * w + x1], c11);
+
+			for (int c = 0; c < 4; ++c)
+			{
+				float top    = c00[c] + (c10[c] - c00[c]) * ax;
+				float bottom = c01[c] + (c11[c] - c01[c]) * ax;
+				texel[c] = top + (bottom - top) * ay;
+			}
+		}
+	}
+
+	/// <summary>
+	/// pixel shader, depth test and output merger for one pixel
+	/// the features are resolved at compile time, like the defines of a variant of pixel_shader.hlsl
+	/// </summary>
+	template <ShaderPermutation::Key FEATURES>
+	inline void Manager::ShadePixel(_In_ const DrawState& state, _Inout_ uint32_t* p_color, _Inout_ float* p_depth, _In_ const float (&attribute)[ATTRIBUTE_COUNT])
+	{
+		const float z = attribute[ATTRIBUTE_DEPTH];
+
+		//-----------------------------------
+		// depth (clip, then LESS_EQUAL)
+		//-----------------------------------
+		if (z < 0.0f || z > 1.0f) return;
+		if (z > *p_depth) return;
+
+		//-----------------------------------
+		// pixel shader (same as pixel_shader.hlsl)
+		//-----------------------------------
+		const float* color = &attribute[ATTRIBUTE_COLOR];
+		float src[4] = { color[0], color[1], color[2], color[3] };
+		if constexpr ((FEATURES & ShaderPermutation::FEATURE_TEXTURED) != 0)
+		{
+			float texel[4];
+			SampleTexture(state.SourceTexture, attribute[ATTRIBUTE_TEXCOORD], attribute[ATTRIBUTE_TEXCOORD + 1], texel);
+
+			for (int c = 0; c < 4; ++c) src[c] *= texel[c];
+		}
+		if constexpr ((FEATURES & ShaderPermutation::FEATURE_TINT) != 0)
+		{
+			for (int c = 0; c < 3; ++c) src[c] *= state.Diffuse[c];
+		}
+		if constexpr ((FEATURES & ShaderPermutation::FEATURE_ALPHA_TEST) != 0)
+		{
+			// clip(color.a - threshold)
+			if (src[3] - state.AlphaThreshold < 0.0f) return;
+		}
+		if constexpr ((FEATURES & ShaderPermutation::FEATURE_PREMULTIPLIED) != 0)
+		{
+			// color.rgb *= color.a (straight inputs only, ShaderPermutation::GetPipelineKey drops it in a premultiplied pipeline)
+			for (int c = 0; c < 3; ++c) src[c] *= src[3];
+		}
+
+		//-----------------------------------
+		// blend (same equations as Renderer::Manager::CreateBlendState)
+		//-----------------------------------
+		float dst[4];
+		UnpackColor(*p_color, dst);
+
+		float out[4];
+		const float src_alpha = src[3];
+		switch (state.Blend)
+		{
+		case Renderer::BlendMode::Add:
+			for (int c = 0; c < 3; ++c) out[c] = src[c] * src_alpha + dst[c];
+			break;
+
+		case Renderer::BlendMode::Subtract:
+			for (int c = 0; c < 3; ++c) out[c] = dst[c] - src[c] * src_alpha;
+			break;
+
+		case Renderer::BlendMode::AlphaBlend:
+			for (int c = 0; c < 3; ++c) out[c] = src[c] * src_alpha + dst[c] * (1.0f - src_alpha);
+			break;
+
+		case Renderer::BlendMode::Premultiplied:
+			for (int c = 0; c < 3; ++c) out[c] = src[c] + dst[c] * (1.0f - src_alpha);
+			break;
+
+		case Renderer::BlendMode::None:
+		default:
+			for (int c = 0; c < 3; ++c) out[c] = src[c];
+			break;
+		}
+
+		// the alpha channel is always ONE, ZERO, ADD
+		out[3] = src_alpha;
+
+		*p_color = PackColor(out);
+		if (state.DepthWrite) *p_depth = z;
+	}
+
+	/// <summary>
+	/// rasterize the bin of a tile in submission order
+	/// </summary>
+	void Manager::RasterizeTile(_In_ uint32_t tile)
+	{
+		const int tile_min_x = static_cast<int>(tile % _tilesX) * TILE_SIZE;
+		const int tile_min_y = static_cast<int>(tile / _tilesX) * TILE_SIZE;
+		const int tile_max_x = std::min(tile_min_x + TILE_SIZE, static_cast<int>(_width))  - 1;
+		const int tile_max_y = std::min(tile_min_y + TILE_SIZE, static_cast<int>(_height)) - 1;
+
+		// clear views
+		if (_isClearPending)
+		{
+			const uint32_t clear_color = PackColor(CLEAR_COLOR);
+			for (int y = tile_min_y; y <= tile_max_y; ++y)
+			{
+				size_t row = static_cast<size_t>(y) * _width;
+				std::fill(&_colorBuffer[row + tile_min_x], &_colorBuffer[row + tile_max_x] + 1, clear_color);
+				std::fill(&_depthBuffer[row + tile_min_x], &_depthBuffer[row + tile_max_x] + 1, 1.0f);
+			}
+		}
+
+		std::vector<uint32_t>& bin = _bins[tile];
+		for (uint32_t index : bin)
+		{
+			const Triangle& triangle = _triangles[index];
+
+			if (_drawStates[triangle.State].Fill == Renderer::FillMode::Wireframe)
+			{
+				RasterizeWireframe(triangle, tile_min_x, tile_min_y, tile_max_x, tile_max_y);
+			}
+			else
+			{
+				RasterizeTriangle(triangle, tile_min_x, tile_min_y, tile_max_x, tile_max_y);
+			}
+		}
+		bin.clear();
+	}
+
+	/// <summary>
+	/// rasterize a solid triangle with the variant of the pixel shader of its state
+	/// </summary>
+	void Manager::RasterizeTriangle(_In_ const Triangle& triangle, _In_ int tileMinX, _In_ int tileMinY, _In_ int tileMaxX, _In_ int tileMaxY)
+	{
+		using RasterizeFunc = void (Manager::*)(const Triangle&, int, int, int, int);
+		static constexpr RasterizeFunc s_variants[ShaderPermutation::VARIANT_COUNT] =
+		{
+			&Manager::RasterizeTriangleVariant<0>,  &Manager::RasterizeTriangleVariant<1>,
+			&Manager::RasterizeTriangleVariant<2>,  &Manager::RasterizeTriangleVariant<3>,
+			&Manager::RasterizeTriangleVariant<4>,  &Manager::RasterizeTriangleVariant<5>,
+			&Manager::RasterizeTriangleVariant<6>,  &Manager::RasterizeTriangleVariant<7>,
+			&Manager::RasterizeTriangleVariant<8>,  &Manager::RasterizeTriangleVariant<9>,
+			&Manager::RasterizeTriangleVariant<10>, &Manager::RasterizeTriangleVariant<11>,
+			&Manager::RasterizeTriangleVariant<12>, &Manager::RasterizeTriangleVariant<13>,
+			&Manager::RasterizeTriangleVariant<14>, &Manager::RasterizeTriangleVariant<15>,
+		};
+		static_assert(ShaderPermutation::VARIANT_COUNT == 16, "a variant is missing from the table");
+
+		(this->*s_variants[_drawStates[triangle.State].Features])(triangle, tileMinX, tileMinY, tileMaxX, tileMaxY);
+	}
+
+	/// <summary>
+	/// rasterize a solid triangle inside the tile with edge functions (top-left fill rule)
+	/// </summary>
+	template <ShaderPermutation::Key FEATURES>
+	void Manager::RasterizeTriangleVariant(_In_ const Triangle& triangle, _In_ int tileMinX, _In_ int tileMinY, _In_ int tileMaxX, _In_ int tileMaxY)
+	{
+		const int min_x = std::max(triangle.MinX, tileMinX);
+		const int min_y = std::max(triangle.MinY, tileMinY);
+		const int max_x = std::min(triangle.MaxX, tileMaxX);
+		const int max_y = std::min(triangle.MaxY, tileMaxY);
+		if (min_x > max_x || min_y > max_y) return;
+
+		const DrawState& state = _drawStates[triangle.State];
+
+		// edge i is opposite to vertex i, so its value is the weight of vertex i
+		int64_t step_x[3], step_y[3], w_row[3], bias[3];
+		const int64_t px = static_cast<int64_t>(min_x) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+		const int64_t py = static_cast<int64_t>(min_y) * SUBPIXEL_SCALE + SUBPIXEL_SCALE / 2;
+		for (int e = 0; e < 3; ++e)
+		{
+			const int a = (e + 1) % 3;
+			const int b = (e + 2) % 3;
+			const int64_t dx = triangle.X[b] - triangle.X[a];
+			const int64_t dy = triangle.Y[b] - triangle.Y[a];
+
+			step_x[e] = -dy * SUBPIXEL_SCALE;
+			step_y[e] =  dx * SUBPIXEL_SCALE;
+			w_row[e]  = dx * (py - triangle.Y[a]) - dy * (px - triangle.X[a]);
+
+			// pixels exactly on an edge belong to top or left edges only
+			const bool is_top_left = (dy < 0) || (dy == 0 && dx > 0);
+			bias[e] = is_top_left ? 0 : 1;
+		}
+
+		for (int y = min_y; y <= max_y; ++y)
+		{
+			int64_t w[3] = { w_row[0], w_row[1], w_row[2] };
+
+			// attributes at the first pixel center of the row, then stepped along x
+			float attribute[ATTRIBUTE_COUNT];
+			for (int i = 0; i < ATTRIBUTE_COUNT; ++i)
+			{
+				attribute[i] = triangle.Plane[i][0] + triangle.Plane[i][1] * (min_x + 0.5f) + triangle.Plane[i][2] * (y + 0.5f);
+			}
+
+			uint32_t* p_color = &_colorBuffer[static_cast<size_t>(y) * _width];
+			float*    p_depth = &_depthBuffer[static_cast<size_t>(y) * _width];
+
+			for (int x = min_x; x <= max_x; ++x)
+			{
+				if (((w[0] - bias[0]) | (w[1] - bias[1]) | (w[2] - bias[2])) >= 0)
+				{
+					ShadePixel<FEATURES>(state, &p_color[x], &p_depth[x], attribute);
+				}
+
+				w[0] += step_x[0];
+				w[1] += step_x[1];
+				w[2] += step_x[2];
+
+				for (int i = 0; i < ATTRIBUTE_COUNT; ++i) attribute[i] += triangle.Plane[i][1];
+			}
+
+			w_row[0] += step_y[0];
+			w_row[1] += step_y[1];
+			w_row[2] += step_y[2];
+		}
+	}
+
+	/// <summary>
+	/// rasterize the edges of a triangle inside the tile
+	/// </summary>
+	void Manager::RasterizeWireframe(_In_ const Triangle& triangle, _In_ int tileMinX, _In_ int tileMinY, _In_ int tileMaxX, _In_ int tileMaxY)
+	{
+		using ShadeFunc = void (*)(const DrawState&, uint32_t*, float*, const float (&)[ATTRIBUTE_COUNT]);
+		static constexpr ShadeFunc s_variants[ShaderPermutation::VARIANT_COUNT] =
+		{
+			&Manager::ShadePixel<0>,  &Manager::ShadePixel<1>,  &Manager::ShadePixel<2>,  &Manager::ShadePixel<3>,
+			&Manager::ShadePixel<4>,  &Manager::ShadePixel<5>,  &Manager::ShadePixel<6>,  &Manager::ShadePixel<7>,
+			&Manager::ShadePixel<8>,  &Manager::ShadePixel<9>,  &Manager::ShadePixel<10>, &Manager::ShadePixel<11>,
+			&Manager::ShadePixel<12>, &Manager::ShadePixel<13>, &Manager::ShadePixel<14>, &Manager::ShadePixel<15>,
+		};
+
+		const DrawState& state = _drawStates[triangle.State];
+		const ShadeFunc shade_pixel = s_variants[state.Features];
+		constexpr float INV_SUBPIXEL = 1.0f / SUBPIXEL_SCALE;
+
+		for (int e = 0; e < 3; ++e)
+		{
+			const int a = e;
+			const int b = (e + 1) % 3;
+
+			const float ax = static_cast<float>(triangle.X[a]) * INV_SUBPIXEL;
+			const float ay = static_cast<float>(triangle.Y[a]) * INV_SUBPIXEL;
+			const float dx = static_cast<float>(triangle.X[b]) * INV_SUBPIXEL - ax;
+			const float dy = static_cast<float>(triangle.Y[b]) * INV_SUBPIXEL - ay;
+
+			// one sample per pixel along the major axis
+			const int steps = std::max(1, static_cast<int>(std::ceil(std::max(std::fabs(dx), std::fabs(dy)))));
+			for (int s = 0; s <= steps; ++s)
+			{
+				const float t = static_cast<float>(s) / static_cast<float>(steps);
+				const int x = static_cast<int>(std::floor(ax + dx * t));
+				const int y = static_cast<int>(std::floor(ay + dy * t));
+				if (x < tileMinX || x > tileMaxX || y < tileMinY || y > tileMaxY) continue;
+
+				// the attributes are planes, so evaluate them at the pixel center
+				float attribute[ATTRIBUTE_COUNT];
+				for (int i = 0; i < ATTRIBUTE_COUNT; ++i)
+				{
+					attribute[i] = triangle.Plane[i][0] + triangle.Plane[i][1] * (x + 0.5f) + triangle.Plane[i][2] * (y + 0.5f);
+				}
+
+				const size_t index = static_cast<size_t>(y) * _width + x;
+				shade_pixel(state, &_colorBuffer[index], &_depthBuffer[index], attribute);
+			}
+		}
+	}
+}
@@ -0,0 +1,443 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include "sort_key.h"
+#include "thread_pool.h"
+
+namespace SortKey
+{
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		// more blocks than this do not get more threads
+		constexpr uint32_t MAX_BLOCK_COUNT = 64;
+
+		/// <summary>
+		/// map the bits of a float to an unsigned integer of the same order
+		/// </summary>
+		uint32_t GetOrderedBits(float value)
+		{
+			uint32_t bits = 0;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			// negative values have their order reversed, positive values go above them
+			return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+		}
+	}
+
+	/// <summary>
+	/// pack the fields of a draw into a key
+	/// </summary>
+	uint64_t Make(_In_ const Fields& fields)
+	{
+		const uint64_t layer       = std::min(fields.Layer, (1u << LAYER_BITS) - 1);
+		const uint64_t depth       = (~GetOrderedBits(fields.Depth) >> (32 - DEPTH_BITS)) & ((1u << DEPTH_BITS) - 1);
+		const uint64_t translucent = (fields.Blend != Renderer::BlendMode::None) ? 1 : 0;
+		const uint64_t pipeline    = fields.Pipeline & ((1u << PIPELINE_BITS) - 1);
+		const uint64_t blend       = static_cast<uint32_t>(fields.Blend) & ((1u << BLEND_BITS) - 1);
+		const uint64_t texture     = fields.Texture & ((1u << TEXTURE_BITS) - 1);
+
+		return (layer << LAYER_SHIFT) | (depth << DEPTH_SHIFT) | (translucent << TRANSLUCENT_SHIFT) |
+			(pipeline << PIPELINE_SHIFT) | (blend << BLEND_SHIFT) | (texture << TEXTURE_SHIFT);
+	}
+
+	/// <summary>
+	/// get the layer of a key
+	/// </summary>
+	uint32_t GetLayer(_In_ uint64_t key)
+	{
+		return static_cast<uint32_t>(key >> LAYER_SHIFT) & ((1u << LAYER_BITS) - 1);
+	}
+
+	/// <summary>
+	/// get the pipeline of a key, truncated to the bits of the key
+	/// </summary>
+	uint32_t GetPipeline(_In_ uint64_t key)
+	{
+		return static_cast<uint32_t>(key >> PIPELINE_SHIFT) & ((1u << PIPELINE_BITS) - 1);
+	}
+
+	/// <summary>
+	/// get the blend mode of a key
+	/// </summary>
+	Renderer::BlendMode GetBlend(_In_ uint64_t key)
+	{
+		return static_cast<Renderer::BlendMode>(static_cast<uint32_t>(key >> BLEND_SHIFT) & ((1u << BLEND_BITS) - 1));
+	}
+
+	/// <summary>
+	/// get the texture of a key, truncated to the bits of the key
+	/// </summary>
+	uint32_t GetTexture(_In_ uint64_t key)
+	{
+		return static_cast<uint32_t>(key >> TEXTURE_SHIFT) & ((1u << TEXTURE_BITS) - 1);
+	}
+
+	/// <summary>
+	/// constructor for sorter
+	/// </summary>
+	Sorter::Sorter()
+	{
+		_keys[0] = _keys[1] = nullptr;
+		_values[0] = _values[1] = nullptr;
+		_count = 0;
+		_pass  = 0;
+
+		_blockFunc  = nullptr;
+		_blockCount = 0;
+		_lastStats = {};
+	}
+
+	/// <summary>
+	/// run a step for every block, on the thread pool if there are several
+	/// </summary>
+	void Sorter::RunBlocks(_In_ void (Sorter::*p_func)(size_t))
+	{
+		if (_blockCount == 1)
+		{
+			(this->*p_func)(0);
+			return;
+		}
+
+		_blockFunc = p_func;
+		ThreadPool::Manager::Instance().ParallelFor(_blockCount, &Sorter::RunBlock, this);
+	}
+
+	/// <summary>
+	/// run the step of RunBlocks for a block, on a thread of the pool
+	/// </summary>
+	void Sorter::RunBlock(_In_ void* p_context, _In_ size_t block)
+	{
+		Sorter* p_sorter = static_cast<Sorter*>(p_context);
+		(p_sorter->*(p_sorter->_blockFunc))(block);
+	}
+
+	/// <summary>
+	/// get the pairs of a block
+	/// </summary>
+	void Sorter::GetBlockRange(_In_ size_t block, _Out_ size_t* p_begin, _Out_ size_t* p_end) const
+	{
+		*p_begin = _count * block / _blockCount;
+		*p_end   = _count * (block + 1) / _blockCount;
+	}
+
+	/// <summary>
+	/// get the histogram of a block in the current pass
+	/// </summary>
+	uint32_t* Sorter::GetHistogram(_In_ size_t block)
+	{
+		return &_histograms[block * RADIX_SIZE];
+	}
+
+	/// <summary>
+	/// find the bits shared by every pair, count the state changes and check the order of the values in a block
+	/// </summary>
+	void Sorter::AnalyzeBlock(_In_ size_t block)
+	{
+		size_t begin = 0, end = 0;
+		GetBlockRange(block, &begin, &end);
+
+		const uint64_t* p_keys   = _keys[0];
+		const uint32_t* p_values = _values[0];
+
+		BlockSummary summary = { ~0ull, 0, ~0u, 0, 0, true };
+		if (begin == end)
+		{
+			_blockSummaries[block] = summary;
+			return;
+		}
+
+		// the first pair of a block is compared with the last pair of the previous block
+		summary.StateChanges = (begin == 0) ? 1 : 0;
+
+		for (size_t i = begin; i < end; ++i)
+		{
+			const uint64_t key   = p_keys[i];
+			const uint32_t value = p_values[i];
+
+			summary.KeyAnd   &= key;
+			summary.KeyOr    |= key;
+			summary.ValueAnd &= value;
+			summary.ValueOr  |= value;
+
+			if (i > 0)
+			{
+				summary.StateChanges += ((key ^ p_keys[i - 1]) & STATE_MASK) ? 1 : 0;
+				summary.IsSorted = summary.IsSorted && p_values[i - 1] <= value;
+			}
+		}
+
+		_blockSummaries[block] = summary;
+	}
+
+	/// <summary>
+	/// build the histogram of the current pass in a block
+	/// </summary>
+	void Sorter::BuildBlockHistogram(_In_ size_t block)
+	{
+		size_t begin = 0, end = 0;
+		GetBlockRange(block, &begin, &end);
+
+		uint32_t* p_histogram = GetHistogram(block);
+		std::memset(p_histogram, 0, sizeof(uint32_t) * RADIX_SIZE);
+
+		const uint64_t* p_keys   = _keys[0];
+		const uint32_t* p_values = _values[0];
+
+		if (_pass < VALUE_PASS_COUNT)
+		{
+			const uint32_t shift = _pass * RADIX_BITS;
+			for (size_t i = begin; i < end; ++i) ++p_histogram[(p_values[i] >> shift) & (RADIX_SIZE - 1)];
+		}
+		else
+		{
+			const uint32_t shift = (_pass - VALUE_PASS_COUNT) * RADIX_BITS;
+			for (size_t i = begin; i < end; ++i) ++p_histogram[static_cast<uint32_t>(p_keys[i] >> shift) & (RADIX_SIZE - 1)];
+		}
+	}
+
+	/// <summary>
+	/// move the pairs of a block to the destination of the current pass
+	/// the histogram of the block holds the offsets by now, and the block keeps its order within a digit, so the sort is stable
+	/// </summary>
+	void Sorter::ScatterBlock(_In_ size_t block)
+	{
+		size_t begin = 0, end = 0;
+		GetBlockRange(block, &begin, &end);
+
+		uint32_t* p_offsets = GetHistogram(block);
+
+		const uint64_t* p_keys   = _keys[0];
+		const uint32_t* p_values = _values[0];
+		uint64_t* p_dst_keys   = _keys[1];
+		uint32_t* p_dst_values = _values[1];
+
+		if (_pass < VALUE_PASS_COUNT)
+		{
+			const uint32_t shift = _pass * RADIX_BITS;
+			for (size_t i = begin; i < end; ++i)
+			{
+				const uint32_t offset = p_offsets[(p_values[i] >> shift) & (RADIX_SIZE - 1)]++;
+				p_dst_keys[offset]   = p_keys[i];
+				p_dst_values[offset] = p_values[i];
+			}
+		}
+		else
+		{
+			const uint32_t shift = (_pass - VALUE_PASS_COUNT) * RADIX_BITS;
+			for (size_t i = begin; i < end; ++i)
+			{
+				const uint32_t offset = p_offsets[static_cast<uint32_t>(p_keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+				p_dst_keys[offset]   = p_keys[i];
+				p_dst_values[offset] = p_values[i];
+			}
+		}
+	}
+
+	/// <summary>
+	/// copy the pairs of a block from the temporary buffers back to the caller
+	/// </summary>
+	void Sorter::CopyBackBlock(_In_ size_t block)
+	{
+		size_t begin = 0, end = 0;
+		GetBlockRange(block, &begin, &end);
+
+		std::copy(_keys[0] + begin, _keys[0] + end, _keys[1] + begin);
+		std::copy(_values[0] + begin, _values[0] + end, _values[1] + begin);
+	}
+
+	/// <summary>
+	/// count the state changes of a block in the sorted order
+	/// </summary>
+	void Sorter::CountBlockStateChanges(_In_ size_t block)
+	{
+		size_t begin = 0, end = 0;
+		GetBlockRange(block, &begin, &end);
+
+		const uint64_t* p_keys = _keys[0];
+
+		uint32_t state_changes = (begin == 0 && end > 0) ? 1 : 0;
+		for (size_t i = std::max<size_t>(begin, 1); i < end; ++i)
+		{
+			state_changes += ((p_keys[i] ^ p_keys[i - 1]) & STATE_MASK) ? 1 : 0;
+		}
+
+		_blockSummaries[block].StateChanges = state_changes;
+	}
+
+	/// <summary>
+	/// sort the pairs on the calling thread by one pass on a digit of the key, then by std::sort in each bucket of the digit
+	/// the buckets of high-entropy keys fit in the cache, unlike the whole array
+	/// </summary>
+	void Sorter::SortByComparison(_In_ uint32_t shift)
+	{
+		uint64_t* p_keys   = _keys[0];
+		uint32_t* p_values = _values[0];
+
+		if (_tempPairs.size() < _count) _tempPairs.resize(_count);
+
+		uint32_t* p_offsets = GetHistogram(0);
+		std::memset(p_offsets, 0, sizeof(uint32_t) * RADIX_SIZE);
+		for (size_t i = 0; i < _count; ++i) ++p_offsets[static_cast<uint32_t>(p_keys[i] >> shift) & (RADIX_SIZE - 1)];
+
+		uint32_t offset = 0;
+		for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+		{
+			const uint32_t digit_count = p_offsets[digit];
+			p_offsets[digit] = offset;
+			offset += digit_count;
+		}
+
+		// the pairs are packed into their buckets, the offsets end at the end of each bucket
+		for (size_t i = 0; i < _count; ++i)
+		{
+			const uint32_t digit = static_cast<uint32_t>(p_keys[i] >> shift) & (RADIX_SIZE - 1);
+			_tempPairs[p_offsets[digit]++] = { p_keys[i], p_values[i] };
+		}
+
+		uint32_t begin = 0;
+		for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+		{
+			std::sort(_tempPairs.begin() + begin, _tempPairs.begin() + p_offsets[digit]);
+			begin = p_offsets[digit];
+		}
+
+		for (size_t i = 0; i < _count; ++i)
+		{
+			p_keys[i]   = _tempPairs[i].first;
+			p_values[i] = _tempPairs[i].second;
+		}
+	}
+
+	/// <summary>
+	/// sort the pairs by key and then by value
+	/// </summary>
+	void Sorter::Sort(_Inout_ uint64_t* p_keys, _Inout_ uint32_t* p_values, _In_ size_t count)
+	{
+		_lastStats = {};
+		_lastStats.Keys = static_cast<uint32_t>(count);
+		if (count == 0) return;
+
+		if (_tempKeys.size() < count)
+		{
+			_tempKeys.resize(count);
+			_tempValues.resize(count);
+		}
+
+		// a block per thread, each large enough to pay for the hand-off
+		const uint32_t threads = ThreadPool::Manager::Instance().GetWorkerCount() + 1;
+		_blockCount = (count < PARALLEL_MIN_KEYS) ? 1 : std::min(std::min(threads, MAX_BLOCK_COUNT), static_cast<uint32_t>(count / (PARALLEL_MIN_KEYS / 4)));
+		_blockCount = std::max(_blockCount, 1u);
+
+		if (_blockSummaries.size() < _blockCount)
+		{
+			_histograms.resize(static_cast<size_t>(_blockCount) * RADIX_SIZE);
+			_blockSummaries.resize(_blockCount);
+		}
+
+		_count = count;
+		_keys[0]   = p_keys;
+		_values[0] = p_values;
+		_keys[1]   = _tempKeys.data();
+		_values[1] = _tempValues.data();
+
+		RunBlocks(&Sorter::AnalyzeBlock);
+
+		// a bit set in some pairs but not in all of them
+		uint64_t key_and = ~0ull, key_or = 0;
+		uint32_t value_and = ~0u, value_or = 0;
+		bool is_sorted = true;
+		for (uint32_t block = 0; block < _blockCount; ++block)
+		{
+			const BlockSummary& summary = _blockSummaries[block];
+			key_and   &= summary.KeyAnd;
+			key_or    |= summary.KeyOr;
+			value_and &= summary.ValueAnd;
+			value_or  |= summary.ValueOr;
+
+			// the boundary of the blocks is checked by the next block
+			is_sorted = is_sorted && summary.IsSorted;
+			_lastStats.StateChangesUnsorted += summary.StateChanges;
+		}
+		const uint64_t key_varying   = key_and ^ key_or;
+		const uint32_t value_varying = is_sorted ? 0 : value_and ^ value_or;
+
+		// the digit is the same for every pair, the pass would not move anything
+		auto is_pass_needed = [&](uint32_t pass)
+		{
+			const uint64_t varying = (pass < VALUE_PASS_COUNT)
+				? (value_varying >> (pass * RADIX_BITS))
+				: (key_varying >> ((pass - VALUE_PASS_COUNT) * RADIX_BITS));
+			return (varying & (RADIX_SIZE - 1)) != 0;
+		};
+
+		uint32_t pass_count = 0;
+		for (uint32_t pass = 0; pass < PASS_COUNT; ++pass) pass_count += is_pass_needed(pass) ? 1 : 0;
+
+		// keys varying in most digits, the passes would cost more than a comparison sort on one thread
+		_lastStats.IsComparisonSort = _blockCount == 1 && pass_count > MAX_RADIX_PASSES && count >= COMPARISON_SORT_MIN_KEYS;
+		if (_lastStats.IsComparisonSort)
+		{
+			// the highest digit some keys differ in, every key has the same bits above it
+			uint32_t shift = 64 - RADIX_BITS;
+			while (shift > 0 && !((key_varying >> shift) & (RADIX_SIZE - 1))) shift -= RADIX_BITS;
+
+			SortByComparison(shift);
+			_lastStats.Passes = pass_count;
+		}
+		else
+		{
+			// LSD passes from the lowest byte of the value to the highest byte of the key
+			for (_pass = 0; _pass < PASS_COUNT; ++_pass)
+			{
+				if (!is_pass_needed(_pass)) continue;
+
+				RunBlocks(&Sorter::BuildBlockHistogram);
+
+				// offsets by digit, and by block within a digit
+				uint32_t offset = 0;
+				for (uint32_t digit = 0; digit < RADIX_SIZE; ++digit)
+				{
+					for (uint32_t block = 0; block < _blockCount; ++block)
+					{
+						uint32_t& entry = GetHistogram(block)[digit];
+						const uint32_t entry_count = entry;
+						entry = offset;
+						offset += entry_count;
+					}
+				}
+
+				RunBlocks(&Sorter::ScatterBlock);
+
+				std::swap(_keys[0], _keys[1]);
+				std::swap(_values[0], _values[1]);
+				++_lastStats.Passes;
+			}
+
+			// an odd number of passes leaves the pairs in the temporary buffers
+			if (_keys[0] != p_keys)
+			{
+				RunBlocks(&Sorter::CopyBackBlock);
+				std::swap(_keys[0], _keys[1]);
+				std::swap(_values[0], _values[1]);
+			}
+		}
+
+		RunBlocks(&Sorter::CountBlockStateChanges);
+		for (uint32_t block = 0; block < _blockCount; ++block)
+		{
+			_lastStats.StateChanges += _blockSummaries[block].StateChanges;
+		}
+	}
+
+	/// <summary>
+	/// get statistics of the last sort
+	/// </summary>
+	const SortStats& Sorter::GetLastStats() const
+	{
+		return _lastStats;
+	}
+}
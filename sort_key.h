@@ -0,0 +1,169 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "portable_sal.h"
+#include "renderer_types.h"
+
+namespace SortKey
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// fields of a key from the most significant bit
+	// layer | depth | translucent | pipeline | blend | texture
+	// the layer and the depth come first, so the order of the layers and of overlapping sprites is kept (2D draws do not test depth)
+	// the state fields only reorder the draws of the same layer and depth
+	constexpr uint32_t TEXTURE_BITS     = 20;
+	constexpr uint32_t BLEND_BITS       = 3;
+	constexpr uint32_t PIPELINE_BITS    = 8;
+	constexpr uint32_t TRANSLUCENT_BITS = 1;
+	constexpr uint32_t DEPTH_BITS       = 24;
+	constexpr uint32_t LAYER_BITS       = 8;
+
+	constexpr uint32_t TEXTURE_SHIFT     = 0;
+	constexpr uint32_t BLEND_SHIFT       = TEXTURE_SHIFT + TEXTURE_BITS;
+	constexpr uint32_t PIPELINE_SHIFT    = BLEND_SHIFT + BLEND_BITS;
+	constexpr uint32_t TRANSLUCENT_SHIFT = PIPELINE_SHIFT + PIPELINE_BITS;
+	constexpr uint32_t DEPTH_SHIFT       = TRANSLUCENT_SHIFT + TRANSLUCENT_BITS;
+	constexpr uint32_t LAYER_SHIFT       = DEPTH_SHIFT + DEPTH_BITS;
+
+	static_assert(LAYER_SHIFT + LAYER_BITS == 64, "the fields have to fill the key");
+	static_assert(static_cast<uint32_t>(Renderer::BlendMode::Maximum) <= (1u << BLEND_BITS), "the blend modes have to fit the key");
+
+	// bits compared to count the state changes between consecutive draws
+	constexpr uint64_t STATE_MASK = ((1ull << (TEXTURE_BITS + BLEND_BITS + PIPELINE_BITS)) - 1) << TEXTURE_SHIFT;
+
+	// the radix sort takes 8 bits per pass, over the 4 bytes of the value and then the 8 bytes of the key
+	constexpr uint32_t RADIX_BITS       = 8;
+	constexpr uint32_t RADIX_SIZE       = 1 << RADIX_BITS;
+	constexpr uint32_t VALUE_PASS_COUNT = 4;
+	constexpr uint32_t PASS_COUNT       = VALUE_PASS_COUNT + 8;
+
+	// fewer keys are sorted on the calling thread, the thread pool costs more than it saves
+	constexpr size_t PARALLEL_MIN_KEYS = 0x10000;
+
+	// on one thread, as many keys with more varying digits than this are bucketed by their highest digit and sorted by comparison
+	// the scatter of high-entropy keys misses the cache on every pass, the keys of draws vary in far fewer digits
+	constexpr uint32_t MAX_RADIX_PASSES        = 10;
+	constexpr size_t COMPARISON_SORT_MIN_KEYS = 0x40000;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// what a draw is ordered by
+	/// </summary>
+	struct Fields
+	{
+		uint32_t Layer;               // drawn in increasing order, clamped to 8 bits
+		float Depth;                  // in a layer, a deeper draw comes first
+		uint32_t Pipeline;            // opaque to the key (e.g. a pipeline state handle), truncated to 8 bits
+		Renderer::BlendMode Blend;    // draws without blending come before the translucent ones of the same depth
+		uint32_t Texture;             // opaque to the key, truncated to 20 bits
+	};
+
+	/// <summary>
+	/// statistics of the last sort
+	/// </summary>
+	struct SortStats
+	{
+		uint32_t Keys;
+		uint32_t Passes;                 // passes where not every pair had the same digit
+		uint32_t StateChangesUnsorted;   // state changes in the submission order
+		uint32_t StateChanges;           // state changes in the sorted order
+		bool IsComparisonSort;           // one pass and std::sort per bucket instead of the passes
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	uint64_t Make(_In_ const Fields& fields);
+
+	// fields taken back from a key
+	uint32_t GetLayer(_In_ uint64_t key);
+	uint32_t GetPipeline(_In_ uint64_t key);
+	Renderer::BlendMode GetBlend(_In_ uint64_t key);
+	uint32_t GetTexture(_In_ uint64_t key);
+
+	//--------------------------------------------------------
+	// sorter class
+	//--------------------------------------------------------
+	/// <summary>
+	/// stable LSD radix sort of keys with a 32-bit value each (e.g. the dense index of a sprite)
+	/// pairs are ordered by key and then by value, so the order of equal keys does not depend on the submission order
+	/// the keys are split into a block per thread, and every pass builds the histograms of the blocks and scatters them in parallel
+	/// a pass is skipped when every pair has the same digit, and the value passes when the values come in increasing order
+	/// many high-entropy keys on one thread take one pass and a std::sort per bucket instead, it beats the passes there
+	/// the buffers only grow and the blocks run in a slot of the thread pool, so sorting the same number of keys every frame does not allocate
+	/// </summary>
+	class Sorter
+	{
+		/// <summary>
+		/// what the analysis finds in a block
+		/// </summary>
+		struct BlockSummary
+		{
+			// the bits every pair has set, and the bits any pair has set
+			uint64_t KeyAnd;
+			uint64_t KeyOr;
+			uint32_t ValueAnd;
+			uint32_t ValueOr;
+
+			uint32_t StateChanges;
+			bool IsSorted;
+		};
+
+		// keys and values of the sort in progress, the source and the destination of a pass
+		uint64_t* _keys[2];
+		uint32_t* _values[2];
+		size_t _count;
+		uint32_t _pass;
+
+		std::vector<uint64_t> _tempKeys;
+		std::vector<uint32_t> _tempValues;
+		std::vector<std::pair<uint64_t, uint32_t>> _tempPairs;
+
+		// step run for every block by RunBlocks
+		void (Sorter::*_blockFunc)(size_t);
+
+		// histogram of the current pass per block, turned into the scatter offsets of the block
+		uint32_t _blockCount;
+		std::vector<uint32_t> _histograms;
+		std::vector<BlockSummary> _blockSummaries;
+
+		SortStats _lastStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void RunBlocks(_In_ void (Sorter::*p_func)(size_t));
+		static void RunBlock(_In_ void* p_context, _In_ size_t block);
+		void GetBlockRange(_In_ size_t block, _Out_ size_t* p_begin, _Out_ size_t* p_end) const;
+		uint32_t* GetHistogram(_In_ size_t block);
+
+		void AnalyzeBlock(_In_ size_t block);
+		void BuildBlockHistogram(_In_ size_t block);
+		void ScatterBlock(_In_ size_t block);
+		void CopyBackBlock(_In_ size_t block);
+		void CountBlockStateChanges(_In_ size_t block);
+
+		void SortByComparison(_In_ uint32_t shift);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Sorter();
+
+		// sort the pairs in place
+		void Sort(_Inout_ uint64_t* p_keys, _Inout_ uint32_t* p_values, _In_ size_t count);
+
+		// getter
+		const SortStats& GetLastStats() const;
+	};
+}
@@ -1,8 +1,11 @@
 
 #include "directx11_wrapper.h"
 #include "sprite.h"
+#include "profiler.h"
 #include "renderer.h"
-#include "vertex.h"
+#include "sprite_batch.h"
+#include "atlas.h"
+#include "texture_stream.h"
 
 namespace Sprite
 {
@@ -11,133 +14,359 @@ namespace Sprite
 	/// </summary>
 	Manager::Manager()
 	{
-		VertexBuffer = nullptr;
-		Srv = nullptr;
-
-		TexturePath = nullptr;
-
-		Position = {};
-		Scale    = {};
-		Texcoord = {};
-		TexSize  = {};
-		Color    = { 1.0f, 1.0f, 1.0f, 1.0f };
-		Rotation = 0.0f;
+		_isPremultiplied = false;
+	}
 
-		IsLoad = false;
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
 	}
 
 	/// <summary>
-	/// creates Shader-Resource-View from WIC file
+	/// initialization process for sprite
 	/// </summary>
-	HRESULT Manager::CreateSrvFromFile()
+	HRESULT Manager::Initialize(_In_ uint32_t capacity)
 	{
-		HRESULT h_result = S_OK;
+		if (capacity == 0 || capacity >= SpriteRegistry::INVALID_INDEX)
+			return E_INVALIDARG;
 
-		Srv = nullptr;
+		_registry.Reserve(capacity);
+		_visibleIndices.reserve(capacity);
+		_sortKeys.reserve(capacity);
 
-		// load WIC image
-		DirectX::ScratchImage image;
-		h_result = DirectX::LoadFromWICFile(TexturePath, DirectX::WIC_FLAGS_NONE, nullptr, image);
-		if (FAILED(h_result))
-			return h_result;
+		_grid.Initialize({ 0.0f, 0.0f, WORLD_SIZE_WIDTH, WORLD_SIZE_HEIGHT });
+		_staticGeometry.Initialize(&SpriteBatch::Manager::Instance(), &Renderer::Manager::Instance().GetMaterialTable());
 
-		// creates Shader-Resource-View
-		h_result = DirectX::CreateShaderResourceView(&Renderer::Manager::Instance().GetDevice(),
-			image.GetImage(0, 0, 0), image.GetImageCount(), image.GetMetadata(), &Srv);
-		if (FAILED(h_result))
-			return h_result;
+		return S_OK;
+	}
 
-		IsLoad = true;
+	/// <summary>
+	/// termination process for sprite
+	/// </summary>
+	void Manager::Terminate()
+	{
+		while (_registry.GetCount()) Destroy(_registry.GetHandle(_registry.GetCount() - 1));
 
-		return h_result;
+		_grid.Terminate();
+		_staticGeometry.Terminate();
+		_dirtySprites.clear();
 	}
 
 	/// <summary>
-	/// creates vertex buffer
+	/// keep the state of the last fixed step for the interpolation
 	/// </summary>
-	HRESULT Manager::CreateVertexBuffer()
+	void Manager::FixedUpdate()
 	{
-		HRESULT h_result = S_OK;
+		PROFILE_SCOPE("Sprite::FixedUpdate");
+
+		_registry.SavePreviousState();
+	}
 
-		D3D11_BUFFER_DESC buffer_desc;
-		ZeroMemory(&buffer_desc, sizeof(buffer_desc));
+	/// <summary>
+	/// move the dirty sprites between the static geometry and the culling grid, and mark their chunks to rebuild
+	/// </summary>
+	void Manager::ApplyDirtySprites()
+	{
+		uint8_t* p_flags = _registry.GetFlags();
+		const uint32_t* p_layers = _registry.GetLayers();
+
+		for (Handle handle : _dirtySprites)
 		{
-			buffer_desc.Usage          = D3D11_USAGE_DYNAMIC;
-			buffer_desc.ByteWidth      = sizeof(Vertex::Manager) * 4;
-			buffer_desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
-			buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+			const uint32_t index = _registry.GetIndex(handle);
+			if (index == SpriteRegistry::INVALID_INDEX) continue;
+
+			p_flags[index] &= ~SpriteRegistry::FLAG_DIRTY;
+
+			const uint32_t slot = _registry.GetSlot(index);
+			if (p_flags[index] & SpriteRegistry::FLAG_STATIC)
+			{
+				_grid.Remove(slot);
+				_staticGeometry.Add(slot, p_layers[index]);
+			}
+			else
+			{
+				// the next synchronization inserts it into the grid
+				_staticGeometry.Remove(slot);
+			}
 		}
-		h_result = Renderer::Manager::Instance().GetDevice().CreateBuffer(&buffer_desc, nullptr, &VertexBuffer);
 
-		return h_result;
+		_dirtySprites.clear();
 	}
 
 	/// <summary>
-	/// anchor point set to center of sprite
+	/// cull the sprites with the view of the 2D camera, sort the visible ones by layer, depth and state,
+	/// and generate their quads chunk by chunk into the sprite batch
+	/// the static geometry of a layer is drawn before the dynamic sprites of the layer
 	/// </summary>
-	void Manager::SetAnchorPointCenter()
+	void Manager::Draw(_In_ float interpolation)
 	{
-		// start mapping
-		D3D11_MAPPED_SUBRESOURCE subresource;
-		Renderer::Manager::Instance().GetDeviceContext().Map(VertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
+		PROFILE_SCOPE("Sprite::Draw");
+
+		{
+			PROFILE_SCOPE("Sprite::Bake");
+
+			// nothing to do in a frame without dirty sprites
+			ApplyDirtySprites();
+			_staticGeometry.Rebuild(_registry);
+		}
 
-		// temporary data for calculation
-		DirectX::XMFLOAT2 half_scale = { Scale.x * 0.5f, Scale.y * 0.5f };
-		
-		// for rotation
-		float angle = static_cast<float>(atan2(static_cast<double>(half_scale.y), static_cast<double>(half_scale.x)));
-		float radius = DirectX::XMVectorGetX(DirectX::XMVector2Length(DirectX::XMLoadFloat2(&half_scale)));
+		const Renderer::ViewRect view = Renderer::Manager::Instance().GetViewRect2D();
 
-		// creates vertex data
-		Vertex::Manager* p_vertex = reinterpret_cast<Vertex::Manager*>(subresource.pData);
 		{
-			// vertex position
-			p_vertex[0].Position = { Position.x - static_cast<float>(cos(angle + Rotation)) * radius, Position.y - static_cast<float>(sin(angle + Rotation)) * radius, 0.0f };
-			p_vertex[1].Position = { Position.x + static_cast<float>(cos(angle - Rotation)) * radius, Position.y - static_cast<float>(sin(angle - Rotation)) * radius, 0.0f };
-			p_vertex[2].Position = { Position.x - static_cast<float>(cos(angle - Rotation)) * radius, Position.y + static_cast<float>(sin(angle - Rotation)) * radius, 0.0f };
-			p_vertex[3].Position = { Position.x + static_cast<float>(cos(angle + Rotation)) * radius, Position.y + static_cast<float>(sin(angle + Rotation)) * radius, 0.0f };
-
-			// vertex color
-			p_vertex[0].Color = Color;
-			p_vertex[1].Color = Color;
-			p_vertex[2].Color = Color;
-			p_vertex[3].Color = Color;
-
-			// vertex texcoord
-			p_vertex[0].Texcoord = Texcoord;
-			p_vertex[1].Texcoord = { Texcoord.x + TexSize.x, Texcoord.y };
-			p_vertex[2].Texcoord = { Texcoord.x,             Texcoord.y + TexSize.y };
-			p_vertex[3].Texcoord = { Texcoord.x + TexSize.x, Texcoord.y + TexSize.y };
+			PROFILE_SCOPE("Sprite::Cull");
+
+			// only the sprites changing cells touch the cell lists
+			_grid.Synchronize(_registry);
+			_grid.Query(view, &_visibleIndices);
+
+			// static sprites moved in the order are streamed until their chunk is rebuilt (a few, the rasterizer culls them)
+			for (uint32_t slot : _staticGeometry.GetDetachedSlots()) _visibleIndices.push_back(_registry.GetIndexOfSlot(slot));
 		}
 
-		// finish mapping
-		Renderer::Manager::Instance().GetDeviceContext().Unmap(VertexBuffer, 0);
+		const uint32_t count = static_cast<uint32_t>(_visibleIndices.size());
+		const uint32_t* p_textures = _registry.GetTextures();
+		const uint32_t* p_materials = _registry.GetMaterials();
+		const uint32_t* p_layers = _registry.GetLayers();
+		const Renderer::BlendMode* p_blends = _registry.GetBlends();
+		const MaterialTable::Table& material_table = Renderer::Manager::Instance().GetMaterialTable();
+
+		{
+			PROFILE_SCOPE("Sprite::Sort");
+
+			const float* p_depths = _registry.GetDepths();
+
+			// every sprite goes through the pipeline of the sprite batch, the variant of the pixel shader of its material splits the runs
+			_sortKeys.resize(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				const uint32_t index = _visibleIndices[i];
+				const ShaderPermutation::Key features = ShaderPermutation::GetPipelineKey(material_table.GetFeatures(p_materials[index]), _isPremultiplied);
+				_sortKeys[i] = SortKey::Make({ p_layers[index], p_depths[index], features, p_blends[index], p_textures[index] });
+			}
+
+			// equal keys are drawn in creation order, whatever cells the sprites are in
+			_sorter.Sort(_sortKeys.data(), _visibleIndices.data(), count);
+		}
+
+		SpriteBatch::Manager& sprite_batch = SpriteBatch::Manager::Instance();
+		TextureStream::Manager& texture_stream = TextureStream::Manager::Instance();
+
+		_staticGeometry.Begin(view);
+
+		bool is_full = false;
+		for (uint32_t first = 0; first < count && !is_full; first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+		{
+			const uint32_t chunk = (count - first < SpriteRegistry::QUAD_CHUNK_SPRITES) ? count - first : SpriteRegistry::QUAD_CHUNK_SPRITES;
+			const uint32_t* p_indices = &_visibleIndices[first];
+			_registry.GenerateInstances(p_indices, chunk, interpolation, _instances);
+
+			for (uint32_t i = 0; i < chunk; ++i)
+			{
+				// the sprites come in the order of their keys, the static sprites before them go first
+				_staticGeometry.DrawUpTo(_sortKeys[first + i]);
+
+				// drawn with a placeholder until the texture is resident
+				// the instance carries the index of its material, only the variant of the pixel shader (kept in the key) splits the runs
+				ID3D11ShaderResourceView* p_srv = texture_stream.GetSrv(p_textures[p_indices[i]]);
+				const ShaderPermutation::Key features = SortKey::GetPipeline(_sortKeys[first + i]);
+				SpriteBatch::SpriteInstance* p_instance = sprite_batch.Allocate(p_srv, p_blends[p_indices[i]], features);
+				if (!p_instance)
+				{
+					is_full = true;
+					break;
+				}
+
+				*p_instance = _instances[i];
+			}
+		}
+
+		_staticGeometry.End();
+	}
+
+	/// <summary>
+	/// create a sprite
+	/// </summary>
+	Handle Manager::Create(_In_ const SpriteRegistry::Desc& desc)
+	{
+		// in the premultiplied mode alpha blended and additive sprites share a blend state, and so a batch
+		SpriteRegistry::Desc sprite_desc = _isPremultiplied ? SpriteRegistry::Registry::GetPremultipliedDesc(desc) : desc;
+		sprite_desc.Flags &= ~SpriteRegistry::FLAG_DIRTY;
+
+		Handle handle = _registry.Create(sprite_desc);
+
+		// a static sprite is baked in the next draw
+		if (sprite_desc.Flags & SpriteRegistry::FLAG_STATIC) MarkDirty(handle);
+
+		return handle;
+	}
+
+	/// <summary>
+	/// create a sprite with a texture streamed from a WIC file
+	/// the file is decoded on a worker, and the view becomes resident in a later frame
+	/// </summary>
+	Handle Manager::CreateFromFile(_In_ const wchar_t* path, _In_ const SpriteRegistry::Desc& desc)
+	{
+		TextureStream::Handle texture = TextureStream::Manager::Instance().Load(path);
+		if (texture == TextureStream::INVALID_HANDLE)
+			return INVALID_HANDLE;
+
+		SpriteRegistry::Desc file_desc = desc;
+		file_desc.Texture = texture;
+		file_desc.Flags  |= SpriteRegistry::FLAG_OWNS_TEXTURE;
+
+		return Create(file_desc);
 	}
 
 	/// <summary>
-	/// release the memory
+	/// destroy a sprite, and release its texture if the sprite owns it
 	/// </summary>
-	void Manager::Release()
+	void Manager::Destroy(_In_ Handle handle)
 	{
-		if (!IsLoad) return;
+		const uint32_t index = _registry.GetIndex(handle);
+		if (index == SpriteRegistry::INVALID_INDEX) return;
 
-		// vert buff
-		if (VertexBuffer)
+		if (_registry.GetFlags()[index] & SpriteRegistry::FLAG_OWNS_TEXTURE)
 		{
-			VertexBuffer->Release();
-			VertexBuffer = nullptr;
+			TextureStream::Manager::Instance().Unload(_registry.GetTextures()[index]);
 		}
 
-		// srv
-		if (Srv)
+		// the sprite moved into its place is updated by the next synchronization, and keeps its slot in the static geometry
+		_grid.Remove(_registry.GetSlot(index));
+		_staticGeometry.Remove(_registry.GetSlot(index));
+		_registry.Destroy(handle);
+	}
+
+	/// <summary>
+	/// resolve a region of the atlas by name
+	/// the page is owned by the atlas, so the sprite does not unload it
+	/// </summary>
+	HRESULT Manager::SetRegionFromAtlas(_In_ Handle handle, _In_ const char* name)
+	{
+		const uint32_t index = _registry.GetIndex(handle);
+		if (index == SpriteRegistry::INVALID_INDEX)
+			return E_INVALIDARG;
+
+		TextureStream::Handle texture = TextureStream::INVALID_HANDLE;
+		const AtlasManifest::Region* p_region = Atlas::Manager::Instance().Find(name, &texture);
+		if (!p_region)
+			return E_INVALIDARG;
+
+		uint8_t& flags = _registry.GetFlags()[index];
+		if (flags & SpriteRegistry::FLAG_OWNS_TEXTURE)
 		{
-			Srv->Release();
-			Srv= nullptr;
+			TextureStream::Manager::Instance().Unload(_registry.GetTextures()[index]);
 		}
 
-		// texture file path
-		if (TexturePath) TexturePath = nullptr;
+		flags &= ~(SpriteRegistry::FLAG_REGION_ROTATED | SpriteRegistry::FLAG_OWNS_TEXTURE);
+		if (p_region->Rotated) flags |= SpriteRegistry::FLAG_REGION_ROTATED;
+		_registry.GetTextures()[index] = texture;
+
+		SpriteRegistry::UvRects& uv_rects = _registry.GetUvRects();
+		uv_rects.TexcoordU[index] = p_region->Texcoord[0];
+		uv_rects.TexcoordV[index] = p_region->Texcoord[1];
+		uv_rects.TexSizeU[index]  = p_region->TexSize[0];
+		uv_rects.TexSizeV[index]  = p_region->TexSize[1];
+
+		if (flags & SpriteRegistry::FLAG_STATIC) MarkDirty(handle);
+
+		return S_OK;
+	}
+
+	/// <summary>
+	/// set the material of a sprite, a static sprite is baked again with it
+	/// </summary>
+	void Manager::SetMaterial(_In_ Handle handle, _In_ MaterialTable::Index material)
+	{
+		const uint32_t index = _registry.GetIndex(handle);
+		if (index == SpriteRegistry::INVALID_INDEX) return;
+
+		_registry.GetMaterials()[index] = material;
+
+		if (_registry.GetFlags()[index] & SpriteRegistry::FLAG_STATIC) MarkDirty(handle);
+	}
+
+	/// <summary>
+	/// make a sprite static or dynamic, it moves between the static geometry and the culling grid in the next draw
+	/// </summary>
+	void Manager::SetStatic(_In_ Handle handle, _In_ bool isStatic)
+	{
+		const uint32_t index = _registry.GetIndex(handle);
+		if (index == SpriteRegistry::INVALID_INDEX) return;
+
+		uint8_t& flags = _registry.GetFlags()[index];
+		if (static_cast<bool>(flags & SpriteRegistry::FLAG_STATIC) == isStatic) return;
+
+		flags = isStatic ? (flags | SpriteRegistry::FLAG_STATIC) : (flags & ~SpriteRegistry::FLAG_STATIC);
+		MarkDirty(handle);
+	}
+
+	/// <summary>
+	/// queue a sprite to be baked again in the next draw, a sprite already queued is skipped
+	/// dynamic sprites are generated every frame, so this only matters for static ones
+	/// </summary>
+	void Manager::MarkDirty(_In_ Handle handle)
+	{
+		const uint32_t index = _registry.GetIndex(handle);
+		if (index == SpriteRegistry::INVALID_INDEX) return;
+
+		uint8_t& flags = _registry.GetFlags()[index];
+		if (flags & SpriteRegistry::FLAG_DIRTY) return;
+
+		flags |= SpriteRegistry::FLAG_DIRTY;
+		_dirtySprites.push_back(handle);
+	}
 
-		IsLoad = false;
+	/// <summary>
+	/// set whether sprites and textures are premultiplied
+	/// </summary>
+	void Manager::SetPremultipliedAlpha(_In_ bool isPremultiplied)
+	{
+		_isPremultiplied = isPremultiplied;
+		TextureStream::Manager::Instance().SetPremultipliedAlpha(isPremultiplied);
+		_staticGeometry.SetPremultipliedAlpha(isPremultiplied);
+	}
+
+	/// <summary>
+	/// get the sprite registry
+	/// </summary>
+	SpriteRegistry::Registry& Manager::GetRegistry()
+	{
+		return _registry;
+	}
+
+	/// <summary>
+	/// get whether sprites and textures are premultiplied
+	/// </summary>
+	bool Manager::IsPremultipliedAlpha() const
+	{
+		return _isPremultiplied;
+	}
+
+	/// <summary>
+	/// get statistics of the culling in the last frame
+	/// </summary>
+	const SpriteGrid::QueryStats& Manager::GetLastCullingStats() const
+	{
+		return _grid.GetLastQueryStats();
+	}
+
+	/// <summary>
+	/// get statistics of the sort in the last frame
+	/// </summary>
+	const SortKey::SortStats& Manager::GetLastSortStats() const
+	{
+		return _sorter.GetLastStats();
+	}
+
+	/// <summary>
+	/// get statistics of the static geometry in the last frame
+	/// </summary>
+	const StaticGeometry::FrameStats& Manager::GetLastStaticStats() const
+	{
+		return _staticGeometry.GetLastFrameStats();
 	}
 }
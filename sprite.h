@@ -1,44 +1,107 @@
 
 #pragma once
 
+#include "material_table.h"
+#include "renderer_types.h"
+#include "sort_key.h"
+#include "sprite_grid.h"
+#include "sprite_registry.h"
+#include "static_geometry.h"
+#include "texture_stream_core.h"
+
 namespace Sprite
 {
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	using Handle = SpriteRegistry::Handle;
+	constexpr Handle INVALID_HANDLE = SpriteRegistry::INVALID_HANDLE;
+
+	// sprites reserved at the initialization
+	constexpr uint32_t DEFAULT_CAPACITY = 1024;
+
+	// area covered by the cells of the culling grid, sprites outside are kept in the border cells
+	constexpr float WORLD_SIZE_WIDTH  = 16384.0f;
+	constexpr float WORLD_SIZE_HEIGHT = 16384.0f;
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	/// <summary>
+	/// every sprite of the scene, updated and drawn by linear passes over the registry
+	/// the texture component holds a streamed texture handle, and the material component a slot of the material table of the renderer
+	/// only the sprites intersecting the view of the 2D camera are drawn, ordered by the sort key of each sprite
+	/// static sprites are baked into vertex buffers, and only a sprite marked dirty is generated and uploaded again
+	/// </summary>
 	class Manager
 	{
-	protected:
-		ID3D11Buffer* VertexBuffer;
-		ID3D11ShaderResourceView* Srv;
+		SpriteRegistry::Registry _registry;
 
-		wchar_t* TexturePath;
+		// culling
+		SpriteGrid::Grid _grid;
+		std::vector<uint32_t> _visibleIndices;
 
-		DirectX::XMFLOAT2 Position;
-		DirectX::XMFLOAT2 Scale;
-		DirectX::XMFLOAT2 Texcoord;
-		DirectX::XMFLOAT2 TexSize;
-		DirectX::XMFLOAT4 Color;
-		float Rotation;
+		// draw order
+		std::vector<uint64_t> _sortKeys;
+		SortKey::Sorter _sorter;
 
-		bool IsLoad;
+		// static sprites, and the sprites to bake again in the next draw
+		StaticGeometry::Cache _staticGeometry;
+		std::vector<Handle> _dirtySprites;
 
-		//-----------------------------------
-		// protected funcs
-		//-----------------------------------
-		HRESULT CreateSrvFromFile();
-		HRESULT CreateVertexBuffer();
+		// instances of one chunk, copied into the ring of the sprite batch
+		SpriteBatch::SpriteInstance _instances[SpriteRegistry::QUAD_CHUNK_SPRITES];
 
-		void SetAnchorPointCenter();
+		// alpha blended and additive sprites are created with the premultiplied blend, and the textures are premultiplied
+		bool _isPremultiplied;
 
-		void Release();
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void ApplyDirtySprites();
 
 		//-----------------------------------
 		// public funcs
 		//-----------------------------------
 	public:
 		Manager();
+		static Manager& Instance();
+
+		// returns E_INVALIDARG if the capacity is 0 or more than the sprites a handle can address
+		HRESULT Initialize(_In_ uint32_t capacity = DEFAULT_CAPACITY);
+		void Terminate();
+
+		// call at the start of a fixed step
+		void FixedUpdate();
+
+		// submit every sprite to the sprite batch
+		void Draw(_In_ float interpolation);
+
+		Handle Create(_In_ const SpriteRegistry::Desc& desc);
+
+		// the texture is streamed from the file, and released with the sprite
+		Handle CreateFromFile(_In_ const wchar_t* path, _In_ const SpriteRegistry::Desc& desc);
+
+		void Destroy(_In_ Handle handle);
+
+		// use a named region of the atlas instead of a whole file
+		HRESULT SetRegionFromAtlas(_In_ Handle handle, _In_ const char* name);
+
+		// the material is registered to the renderer by the caller, and outlives the sprites drawn with it
+		void SetMaterial(_In_ Handle handle, _In_ MaterialTable::Index material);
+
+		// a static sprite keeps its baked quad until it is marked dirty (e.g. after writing its components)
+		void SetStatic(_In_ Handle handle, _In_ bool isStatic);
+		void MarkDirty(_In_ Handle handle);
+
+		// set before creating sprites and loading textures, the sprites created before keep their blend
+		void SetPremultipliedAlpha(_In_ bool isPremultiplied);
 
-		virtual HRESULT Initialize() = 0;
-		virtual void Terminate() = 0;
-		virtual void Update() = 0;
-		virtual void Draw() = 0;
+		// getter
+		SpriteRegistry::Registry& GetRegistry();
+		bool IsPremultipliedAlpha() const;
+		const SpriteGrid::QueryStats& GetLastCullingStats() const;
+		const SortKey::SortStats& GetLastSortStats() const;
+		const StaticGeometry::FrameStats& GetLastStaticStats() const;
 	};
 }
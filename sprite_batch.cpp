@@ -0,0 +1,314 @@
+
+#include "directx11_wrapper.h"
+#include "renderer.h"
+#include "profiler.h"
+#include "vertex.h"
+#include "sprite_batch.h"
+#include "texture_stream.h"
+
+namespace SpriteBatch
+{
+	// the instances are read through the input layout of Vertex::Manager, so the layouts must match
+	static_assert(sizeof(SpriteInstance) == sizeof(Vertex::Manager), "SpriteInstance must be the same layout as Vertex::Manager");
+
+	/// <summary>
+	/// constructor for sprite batch
+	/// </summary>
+	Manager::Manager()
+	{
+		_vertexBuffer = nullptr;
+
+		for (auto& handles : _pipelineStates)
+		{
+			for (PipelineState::Handle& handle : handles) handle = PipelineState::INVALID_HANDLE;
+		}
+
+		_boundTexture = 0;
+		_boundVertexBuffer = nullptr;
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// initialization process for sprite batch
+	/// </summary>
+	HRESULT Manager::Initialize()
+	{
+		HRESULT h_result = S_OK;
+
+		h_result = CreateVertexBuffer();
+		if (FAILED(h_result))
+			return h_result;
+
+		CreatePipelineStates();
+
+		_batcher.Initialize(this);
+
+		return h_result;
+	}
+
+	/// <summary>
+	/// termination process for sprite batch
+	/// </summary>
+	void Manager::Terminate()
+	{
+		_batcher.Terminate();
+
+		if (_vertexBuffer)
+		{
+			_vertexBuffer->Release();
+			_vertexBuffer = nullptr;
+		}
+	}
+
+	/// <summary>
+	/// creates the ring vertex buffer of the instances
+	/// </summary>
+	HRESULT Manager::CreateVertexBuffer()
+	{
+		D3D11_BUFFER_DESC buffer_desc;
+		ZeroMemory(&buffer_desc, sizeof(buffer_desc));
+		{
+			buffer_desc.Usage          = D3D11_USAGE_DYNAMIC;
+			buffer_desc.ByteWidth      = sizeof(SpriteInstance) * DEFAULT_RING_CAPACITY_QUADS;
+			buffer_desc.BindFlags      = D3D11_BIND_VERTEX_BUFFER;
+			buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		}
+
+		return Renderer::Manager::Instance().GetDevice().CreateBuffer(&buffer_desc, nullptr, &_vertexBuffer);
+	}
+
+	/// <summary>
+	/// creates the pipeline states of the sprites with the default material
+	/// </summary>
+	void Manager::CreatePipelineStates()
+	{
+		for (int b = 0; b < static_cast<int>(Renderer::BlendMode::Maximum); ++b)
+		{
+			CreatePipelineState(static_cast<Renderer::BlendMode>(b), ShaderPermutation::DEFAULT_KEY);
+		}
+	}
+
+	/// <summary>
+	/// creates the pipeline state of a blend mode and a variant of the pixel shader
+	/// </summary>
+	PipelineState::Handle Manager::CreatePipelineState(_In_ Renderer::BlendMode blend, _In_ ShaderPermutation::Key features)
+	{
+		Renderer::Manager& renderer = Renderer::Manager::Instance();
+
+		PipelineState::Desc desc = renderer.GetDefaultPipelineDesc();
+		desc.DepthEnableMode = Renderer::DepthEnebleMode::Disable;
+		desc.BlendMode       = blend;
+		desc.PixelShader     = renderer.GetPixelShaderVariant(features);
+
+		PipelineState::Handle& handle = _pipelineStates[static_cast<int>(blend)][features];
+		handle = renderer.CreatePipelineState(desc);
+
+		return handle;
+	}
+
+	/// <summary>
+	/// start collecting sprites for a frame
+	/// </summary>
+	void Manager::Begin()
+	{
+		Renderer::Manager& renderer = Renderer::Manager::Instance();
+
+		// the camera is shared by every sprite in the frame
+		renderer.SetMatrixWorldViewProjection2D();
+
+		// setting data for Input-Assembler stage
+		// (the ring may be flushed in the middle of the frame, so this is done up front)
+		CountedContext::Context context = renderer.GetCountedContext(FrameCounters::Subsystem::SpriteBatch);
+		// the vertex shader expands the corners of an instance from SV_VertexID, so no index buffer is bound
+		UINT stride = sizeof(SpriteInstance);
+		UINT offset = 0;
+		context.IASetVertexBuffers(0, 1, &_vertexBuffer, &stride, &offset);
+		context.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+
+		// other passes may have changed it since the last frame
+		_boundTexture = 0;
+		_boundVertexBuffer = _vertexBuffer;
+
+		_batcher.Begin();
+	}
+
+	/// <summary>
+	/// draw all collected sprites
+	/// </summary>
+	void Manager::End()
+	{
+		_batcher.End();
+	}
+
+	/// <summary>
+	/// allocate the instance of a sprite
+	/// </summary>
+	SpriteInstance* Manager::Allocate(_In_ ID3D11ShaderResourceView* srv, _In_ const Renderer::BlendMode& blend, _In_ ShaderPermutation::Key features)
+	{
+		return _batcher.Allocate(reinterpret_cast<TextureId>(srv), blend, features);
+	}
+
+	/// <summary>
+	/// map the ring vertex buffer
+	/// </summary>
+	SpriteInstance* Manager::MapRing(bool discard)
+	{
+		PROFILE_SCOPE("SpriteBatch::MapRing");
+
+		D3D11_MAPPED_SUBRESOURCE subresource;
+		HRESULT h_result = Renderer::Manager::Instance().GetCountedContext(FrameCounters::Subsystem::SpriteBatch).Map(_vertexBuffer, 0,
+			discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, &subresource);
+		if (FAILED(h_result))
+			return nullptr;
+
+		return reinterpret_cast<SpriteInstance*>(subresource.pData);
+	}
+
+	/// <summary>
+	/// unmap the ring vertex buffer
+	/// </summary>
+	void Manager::UnmapRing()
+	{
+		PROFILE_SCOPE("SpriteBatch::UnmapRing");
+
+		Renderer::Manager::Instance().GetCountedContext(FrameCounters::Subsystem::SpriteBatch).Unmap(_vertexBuffer, 0);
+	}
+
+	/// <summary>
+	/// bind the ring or a baked vertex buffer if another one is bound
+	/// </summary>
+	void Manager::BindVertexBuffer(_In_ ID3D11Buffer* p_buffer)
+	{
+		if (p_buffer == _boundVertexBuffer) return;
+
+		UINT stride = sizeof(SpriteInstance);
+		UINT offset = 0;
+		Renderer::Manager::Instance().GetCountedContext(FrameCounters::Subsystem::SpriteBatch).IASetVertexBuffers(0, 1, &p_buffer, &stride, &offset);
+		_boundVertexBuffer = p_buffer;
+	}
+
+	/// <summary>
+	/// bind the texture and the pipeline state of a run, only changing the states that differ
+	/// </summary>
+	void Manager::BindRun(_In_ TextureId texture, _In_ Renderer::BlendMode blend, _In_ ShaderPermutation::Key features)
+	{
+		Renderer::Manager& renderer = Renderer::Manager::Instance();
+
+		if (texture != _boundTexture)
+		{
+			ID3D11ShaderResourceView* p_srv = reinterpret_cast<ID3D11ShaderResourceView*>(texture);
+			renderer.GetCountedContext(FrameCounters::Subsystem::SpriteBatch).PSSetShaderResources(0, 1, &p_srv);
+			_boundTexture = texture;
+		}
+
+		// the variant of the materials of the run, so the pixel shader has no branch on it
+		PipelineState::Handle handle = _pipelineStates[static_cast<int>(blend)][features];
+		if (handle == PipelineState::INVALID_HANDLE) handle = CreatePipelineState(blend, features);
+
+		// the renderer skips the sub-states which are already bound
+		renderer.BindPipelineState(handle);
+	}
+
+	/// <summary>
+	/// draw a run of instances from the ring
+	/// </summary>
+	void Manager::DrawRun(const Run& run)
+	{
+		BindVertexBuffer(_vertexBuffer);
+		BindRun(run.Texture, run.Blend, run.Features);
+
+		// the instances of the run were written through the mapping
+		CountedContext::Context context = Renderer::Manager::Instance().GetCountedContext(FrameCounters::Subsystem::SpriteBatch);
+		context.AddUploadBytes(static_cast<uint64_t>(run.QuadCount) * sizeof(SpriteInstance));
+		context.DrawInstanced(VERTICES_PER_QUAD, run.QuadCount, 0, run.FirstQuad);
+	}
+
+	/// <summary>
+	/// create a vertex buffer of baked instances, written again only where sprites change
+	/// </summary>
+	StaticGeometry::BufferId Manager::CreateStaticBuffer(_In_ const SpriteInstance* p_instances, _In_ uint32_t quadCount)
+	{
+		PROFILE_SCOPE("SpriteBatch::CreateStaticBuffer");
+
+		const UINT byte_width = sizeof(SpriteInstance) * quadCount;
+
+		D3D11_BUFFER_DESC buffer_desc;
+		ZeroMemory(&buffer_desc, sizeof(buffer_desc));
+		{
+			buffer_desc.Usage     = D3D11_USAGE_DEFAULT;
+			buffer_desc.ByteWidth = byte_width;
+			buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		}
+
+		D3D11_SUBRESOURCE_DATA subresource_data;
+		ZeroMemory(&subresource_data, sizeof(subresource_data));
+		subresource_data.pSysMem = p_instances;
+
+		Renderer::Manager& renderer = Renderer::Manager::Instance();
+
+		ID3D11Buffer* p_buffer = nullptr;
+		if (FAILED(renderer.GetDevice().CreateBuffer(&buffer_desc, &subresource_data, &p_buffer)))
+			return 0;
+
+		// the initial data is uploaded once here, and never again while the chunk is clean
+		renderer.GetCountedContext(FrameCounters::Subsystem::SpriteBatch).AddUploadBytes(byte_width);
+
+		return reinterpret_cast<StaticGeometry::BufferId>(p_buffer);
+	}
+
+	/// <summary>
+	/// write a range of quads of a baked vertex buffer
+	/// </summary>
+	void Manager::UpdateStaticBuffer(_In_ StaticGeometry::BufferId buffer, _In_ const SpriteInstance* p_instances, _In_ uint32_t firstQuad, _In_ uint32_t quadCount)
+	{
+		PROFILE_SCOPE("SpriteBatch::UpdateStaticBuffer");
+
+		Renderer::Manager::Instance().GetCountedContext(FrameCounters::Subsystem::SpriteBatch).UpdateBufferRange(
+			reinterpret_cast<ID3D11Buffer*>(buffer), sizeof(SpriteInstance) * firstQuad, p_instances, sizeof(SpriteInstance) * quadCount);
+	}
+
+	/// <summary>
+	/// release a baked vertex buffer
+	/// </summary>
+	void Manager::ReleaseStaticBuffer(_In_ StaticGeometry::BufferId buffer)
+	{
+		ID3D11Buffer* p_buffer = reinterpret_cast<ID3D11Buffer*>(buffer);
+		if (p_buffer == _boundVertexBuffer) _boundVertexBuffer = nullptr;
+
+		p_buffer->Release();
+	}
+
+	/// <summary>
+	/// draw a run of instances from a baked vertex buffer
+	/// the quads already in the ring are drawn first, so the order of submission is kept
+	/// </summary>
+	void Manager::DrawStaticRun(_In_ StaticGeometry::BufferId buffer, _In_ const StaticGeometry::Run& run)
+	{
+		_batcher.Flush();
+
+		// drawn with a placeholder until the texture is resident
+		ID3D11ShaderResourceView* p_srv = TextureStream::Manager::Instance().GetSrv(run.Texture);
+
+		BindVertexBuffer(reinterpret_cast<ID3D11Buffer*>(buffer));
+		BindRun(reinterpret_cast<TextureId>(p_srv), run.Blend, run.Features);
+
+		Renderer::Manager::Instance().GetCountedContext(FrameCounters::Subsystem::SpriteBatch).DrawInstanced(
+			VERTICES_PER_QUAD, run.QuadCount, 0, run.FirstQuad);
+	}
+
+	/// <summary>
+	/// get statistics of the last drawn frame
+	/// </summary>
+	const FrameStats& Manager::GetLastFrameStats() const
+	{
+		return _batcher.GetLastFrameStats();
+	}
+}
@@ -0,0 +1,72 @@
+
+#pragma once
+
+#include "pipeline_state.h"
+#include "shader_permutation.h"
+#include "sprite_batch_core.h"
+#include "static_geometry.h"
+
+namespace SpriteBatch
+{
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	/// <summary>
+	/// draws the instances streamed through the ring every frame, and the baked vertex buffers of the static geometry
+	/// both are drawn as instanced triangle strips with the same pipeline states
+	/// </summary>
+	class Manager : public Backend, public StaticGeometry::Backend
+	{
+		// ring vertex buffer of the instances
+		ID3D11Buffer* _vertexBuffer;
+
+		Batcher _batcher;
+
+		// sprites are drawn in submission order without depth, one state per blend mode and variant of the material
+		// (created the first time they are bound)
+		PipelineState::Handle _pipelineStates[static_cast<int>(Renderer::BlendMode::Maximum)][ShaderPermutation::VARIANT_COUNT];
+
+		// currently bound to the pipeline
+		TextureId _boundTexture;
+		ID3D11Buffer* _boundVertexBuffer;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		HRESULT CreateVertexBuffer();
+		void CreatePipelineStates();
+		PipelineState::Handle CreatePipelineState(_In_ Renderer::BlendMode blend, _In_ ShaderPermutation::Key features);
+		void BindVertexBuffer(_In_ ID3D11Buffer* p_buffer);
+		void BindRun(_In_ TextureId texture, _In_ Renderer::BlendMode blend, _In_ ShaderPermutation::Key features);
+
+		// backend
+		SpriteInstance* MapRing(bool discard) override;
+		void UnmapRing() override;
+		void DrawRun(const Run& run) override;
+
+		// static geometry backend
+		StaticGeometry::BufferId CreateStaticBuffer(_In_ const SpriteInstance* p_instances, _In_ uint32_t quadCount) override;
+		void ReleaseStaticBuffer(_In_ StaticGeometry::BufferId buffer) override;
+		void UpdateStaticBuffer(_In_ StaticGeometry::BufferId buffer, _In_ const SpriteInstance* p_instances, _In_ uint32_t firstQuad, _In_ uint32_t quadCount) override;
+		void DrawStaticRun(_In_ StaticGeometry::BufferId buffer, _In_ const StaticGeometry::Run& run) override;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		HRESULT Initialize();
+		void Terminate();
+
+		void Begin();
+		void End();
+
+		SpriteInstance* Allocate(_In_ ID3D11ShaderResourceView* srv, _In_ const Renderer::BlendMode& blend,
+			_In_ ShaderPermutation::Key features = ShaderPermutation::DEFAULT_KEY);
+
+		// getter
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
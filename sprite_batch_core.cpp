@@ -0,0 +1,157 @@
+
+#include "sprite_batch_core.h"
+
+namespace SpriteBatch
+{
+	/// <summary>
+	/// constructor for sprite batcher
+	/// </summary>
+	Batcher::Batcher()
+	{
+		_backend = nullptr;
+
+		_capacityQuads = 0;
+		_cursorQuads   = 0;
+		_mappedBegin   = 0;
+		_mapped        = nullptr;
+		_needDiscard   = true;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for sprite batcher
+	/// </summary>
+	void Batcher::Initialize(_In_ Backend* backend, _In_ uint32_t capacityQuads)
+	{
+		_backend = backend;
+
+		_capacityQuads = capacityQuads;
+		_cursorQuads   = 0;
+		_mappedBegin   = 0;
+		_mapped        = nullptr;
+		_needDiscard   = true;
+
+		// a run never exceeds the draw limit, so this is the worst case
+		_runs.reserve(capacityQuads / MAX_QUADS_PER_DRAW + 64);
+	}
+
+	/// <summary>
+	/// termination process for sprite batcher
+	/// </summary>
+	void Batcher::Terminate()
+	{
+		Flush();
+
+		_runs.clear();
+		_runs.shrink_to_fit();
+		_backend = nullptr;
+	}
+
+	/// <summary>
+	/// start collecting quads for a frame
+	/// </summary>
+	void Batcher::Begin()
+	{
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// submit all collected quads and close the frame
+	/// </summary>
+	void Batcher::End()
+	{
+		Flush();
+		_lastFrameStats = _frameStats;
+	}
+
+	/// <summary>
+	/// map the ring buffer from the current cursor
+	/// </summary>
+	void Batcher::Map()
+	{
+		// the ring wrapped around, so the previous contents are thrown away
+		_mapped = _backend->MapRing(_needDiscard);
+		_needDiscard = false;
+		_mappedBegin = _cursorQuads;
+	}
+
+	/// <summary>
+	/// unmap the ring buffer and draw the pending runs
+	/// </summary>
+	void Batcher::Flush()
+	{
+		if (!_mapped) return;
+
+		_backend->UnmapRing();
+		_mapped = nullptr;
+
+		for (const Run& run : _runs)
+		{
+			_backend->DrawRun(run);
+		}
+
+		// statistics
+		uint32_t quads = _cursorQuads - _mappedBegin;
+		_frameStats.Batches += static_cast<uint32_t>(_runs.size());
+		_frameStats.Quads   += quads;
+		_frameStats.Bytes   += static_cast<uint64_t>(quads) * sizeof(SpriteInstance);
+		_frameStats.Flushes++;
+
+		_runs.clear();
+	}
+
+	/// <summary>
+	/// allocate the instance of a quad in the ring buffer
+	/// </summary>
+	SpriteInstance* Batcher::Allocate(_In_ TextureId texture, _In_ Renderer::BlendMode blend, _In_ ShaderPermutation::Key features)
+	{
+		// ring is full, draw what we have and start over
+		if (_cursorQuads == _capacityQuads)
+		{
+			Flush();
+			_cursorQuads = 0;
+			_needDiscard = true;
+		}
+
+		if (!_mapped) Map();
+
+		// extend the last run, or start a new one
+		Run* p_last = _runs.empty() ? nullptr : &_runs.back();
+		if (p_last && p_last->Texture == texture && p_last->Blend == blend && p_last->Features == features && p_last->QuadCount < MAX_QUADS_PER_DRAW)
+		{
+			p_last->QuadCount++;
+		}
+		else
+		{
+			_runs.push_back({ texture, blend, features, _cursorQuads, 1 });
+		}
+
+		return &_mapped[_cursorQuads++];
+	}
+
+	/// <summary>
+	/// get capacity of the ring buffer in quads
+	/// </summary>
+	uint32_t Batcher::GetCapacityQuads() const
+	{
+		return _capacityQuads;
+	}
+
+	/// <summary>
+	/// get statistics of the frame being collected
+	/// </summary>
+	const FrameStats& Batcher::GetFrameStats() const
+	{
+		return _frameStats;
+	}
+
+	/// <summary>
+	/// get statistics of the last finished frame
+	/// </summary>
+	const FrameStats& Batcher::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
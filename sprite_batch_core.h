@@ -0,0 +1,143 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "portable_sal.h"
+#include "renderer_types.h"
+#include "shader_permutation.h"
+
+namespace SpriteBatch
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// a quad is drawn as a triangle strip of 4 vertices expanded from one instance
+	constexpr uint32_t VERTICES_PER_QUAD = 4;
+
+	// upper limit of quads in one draw call, a longer run is split
+	constexpr uint32_t MAX_QUADS_PER_DRAW = 0x4000;
+
+	// default capacity of the ring vertex buffer
+	constexpr uint32_t DEFAULT_RING_CAPACITY_QUADS = MAX_QUADS_PER_DRAW * 4;
+
+	// opaque texture identifier (the backend decides what it points to)
+	using TextureId = uintptr_t;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// vertex of a quad expanded on the cpu (the software renderer and the quad kernel)
+	/// </summary>
+	struct QuadVertex
+	{
+		float Position[3];
+		float Normal[3];
+		float Color[4];
+		float Texcoord[2];
+	};
+
+	/// <summary>
+	/// one sprite in the ring, the vertex shader expands its 4 corners from SV_VertexID
+	/// this needs to be the same layout as Vertex::Manager
+	/// </summary>
+	struct SpriteInstance
+	{
+		float Position[2];
+		uint16_t Scale[2];    // half float
+		int16_t Rotation;     // snorm16 of the angle over pi, wrapped to [-pi, pi]
+		uint16_t Texture;     // texture index, 0xffff if it does not fit
+		uint16_t UvRect[4];   // unorm16 of the top-left and bottom-right texcoords
+		uint32_t Color;       // rgba8 unorm, red is the lowest byte
+		uint32_t Material;    // slot in the material table, the constants stay on the gpu
+	};
+	static_assert(sizeof(SpriteInstance) == 32, "SpriteInstance must be 32 bytes");
+
+	/// <summary>
+	/// consecutive quads drawn with the same texture and state
+	/// </summary>
+	struct Run
+	{
+		TextureId Texture;
+		Renderer::BlendMode Blend;
+		ShaderPermutation::Key Features;  // variant of the pixel shader, the materials of the quads may differ otherwise
+		uint32_t FirstQuad;
+		uint32_t QuadCount;
+	};
+
+	/// <summary>
+	/// statistics of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Batches;
+		uint32_t Quads;
+		uint32_t Flushes;
+		uint64_t Bytes;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		// map the whole ring buffer, discard == false means no-overwrite
+		virtual SpriteInstance* MapRing(bool discard) = 0;
+		virtual void UnmapRing() = 0;
+
+		// draw a run of quads from the ring buffer
+		virtual void DrawRun(const Run& run) = 0;
+	};
+
+	//--------------------------------------------------------
+	// batcher class
+	//--------------------------------------------------------
+	class Batcher
+	{
+		Backend* _backend;
+
+		// ring buffer
+		uint32_t _capacityQuads;
+		uint32_t _cursorQuads;
+		uint32_t _mappedBegin;
+		SpriteInstance* _mapped;
+		bool _needDiscard;
+
+		// pending runs in the mapped range
+		std::vector<Run> _runs;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void Map();
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Batcher();
+
+		void Initialize(_In_ Backend* backend, _In_ uint32_t capacityQuads = DEFAULT_RING_CAPACITY_QUADS);
+		void Terminate();
+
+		void Begin();
+		void End();
+		void Flush();
+
+		SpriteInstance* Allocate(_In_ TextureId texture, _In_ Renderer::BlendMode blend, _In_ ShaderPermutation::Key features = ShaderPermutation::DEFAULT_KEY);
+
+		// getter
+		uint32_t GetCapacityQuads() const;
+		const FrameStats& GetFrameStats() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
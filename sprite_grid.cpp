@@ -0,0 +1,265 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "sprite_grid.h"
+#include "quad_kernel.h"
+
+namespace SpriteGrid
+{
+	namespace
+	{
+		/// <summary>
+		/// axis-aligned half extents of a rotated rectangle
+		/// </summary>
+		void GetRotatedHalfExtents(float scaleX, float scaleY, float rotation, float* p_halfX, float* p_halfY)
+		{
+			float sin = 0.0f, cos = 0.0f;
+			QuadKernel::SinCos(rotation, &sin, &cos);
+
+			const float half_x = std::fabs(scaleX) * 0.5f;
+			const float half_y = std::fabs(scaleY) * 0.5f;
+			*p_halfX = std::fabs(cos) * half_x + std::fabs(sin) * half_y;
+			*p_halfY = std::fabs(sin) * half_x + std::fabs(cos) * half_y;
+		}
+
+		/// <summary>
+		/// check whether two rectangles intersect
+		/// </summary>
+		bool Intersects(const Renderer::ViewRect& bounds, const Renderer::ViewRect& view)
+		{
+			return bounds.Left <= view.Right && bounds.Right >= view.Left && bounds.Top <= view.Bottom && bounds.Bottom >= view.Top;
+		}
+	}
+
+	/// <summary>
+	/// constructor for sprite grid
+	/// </summary>
+	Grid::Grid()
+	{
+		_world = {};
+		_cellSize = DEFAULT_CELL_SIZE;
+		_inverseCellSize = 1.0f / DEFAULT_CELL_SIZE;
+		_columns = 0;
+		_rows    = 0;
+
+		_maxHalfSize = 0.0f;
+
+		_lastQueryStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for sprite grid
+	/// </summary>
+	void Grid::Initialize(_In_ const Renderer::ViewRect& world, _In_ float cellSize)
+	{
+		_world = world;
+		_cellSize = cellSize;
+		_inverseCellSize = 1.0f / cellSize;
+
+		_columns = std::max(1u, static_cast<uint32_t>(std::ceil((world.Right - world.Left) * _inverseCellSize)));
+		_rows    = std::max(1u, static_cast<uint32_t>(std::ceil((world.Bottom - world.Top) * _inverseCellSize)));
+
+		_cells.clear();
+		_cells.resize(static_cast<size_t>(_columns) * _rows);
+
+		_itemCell.clear();
+		_itemPosition.clear();
+		_maxHalfSize = 0.0f;
+	}
+
+	/// <summary>
+	/// termination process for sprite grid
+	/// </summary>
+	void Grid::Terminate()
+	{
+		_cells.clear();
+		_cells.shrink_to_fit();
+		_itemCell.clear();
+		_itemCell.shrink_to_fit();
+		_itemPosition.clear();
+		_itemPosition.shrink_to_fit();
+	}
+
+	/// <summary>
+	/// get the cell of a point, clamped to the world
+	/// </summary>
+	uint32_t Grid::GetCellIndex(_In_ float x, _In_ float y) const
+	{
+		const float column = std::min(std::max((x - _world.Left) * _inverseCellSize, 0.0f), static_cast<float>(_columns - 1));
+		const float row    = std::min(std::max((y - _world.Top)  * _inverseCellSize, 0.0f), static_cast<float>(_rows - 1));
+
+		return static_cast<uint32_t>(row) * _columns + static_cast<uint32_t>(column);
+	}
+
+	/// <summary>
+	/// remove a slot from its cell, the last sprite of the cell is moved into its place
+	/// </summary>
+	void Grid::RemoveFromCell(_In_ uint32_t slot)
+	{
+		Cell& cell = _cells[_itemCell[slot]];
+		const uint32_t position = _itemPosition[slot];
+
+		cell.Bounds[position]  = cell.Bounds.back();
+		cell.Indices[position] = cell.Indices.back();
+		cell.Slots[position]   = cell.Slots.back();
+		_itemPosition[cell.Slots[position]] = position;
+
+		cell.Bounds.pop_back();
+		cell.Indices.pop_back();
+		cell.Slots.pop_back();
+
+		_itemCell[slot] = SpriteRegistry::INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// insert a sprite, or move it to the cell of its new bounds
+	/// </summary>
+	void Grid::Update(_In_ uint32_t slot, _In_ uint32_t index, _In_ const Renderer::ViewRect& bounds)
+	{
+		if (slot >= _itemCell.size())
+		{
+			_itemCell.resize(slot + 1, SpriteRegistry::INVALID_INDEX);
+			_itemPosition.resize(slot + 1, 0);
+		}
+
+		_maxHalfSize = std::max(_maxHalfSize, std::max(bounds.Right - bounds.Left, bounds.Bottom - bounds.Top) * 0.5f);
+
+		const uint32_t cell_index = GetCellIndex((bounds.Left + bounds.Right) * 0.5f, (bounds.Top + bounds.Bottom) * 0.5f);
+
+		// most sprites stay in their cell from one step to the next
+		if (_itemCell[slot] == cell_index)
+		{
+			Cell& cell = _cells[cell_index];
+			cell.Bounds[_itemPosition[slot]]  = bounds;
+			cell.Indices[_itemPosition[slot]] = index;
+			return;
+		}
+
+		if (_itemCell[slot] != SpriteRegistry::INVALID_INDEX) RemoveFromCell(slot);
+
+		Cell& cell = _cells[cell_index];
+		_itemCell[slot]     = cell_index;
+		_itemPosition[slot] = static_cast<uint32_t>(cell.Slots.size());
+		cell.Bounds.push_back(bounds);
+		cell.Indices.push_back(index);
+		cell.Slots.push_back(slot);
+	}
+
+	/// <summary>
+	/// remove a sprite, call when the sprite is destroyed
+	/// </summary>
+	void Grid::Remove(_In_ uint32_t slot)
+	{
+		if (slot < _itemCell.size() && _itemCell[slot] != SpriteRegistry::INVALID_INDEX) RemoveFromCell(slot);
+	}
+
+	/// <summary>
+	/// update every live dynamic sprite of the registry
+	/// </summary>
+	void Grid::Synchronize(_In_ const SpriteRegistry::Registry& registry)
+	{
+		// every bounds is visited, so the margin of the query can shrink again
+		_maxHalfSize = 0.0f;
+
+		// static sprites are culled with their chunk of the static geometry
+		const uint8_t* p_flags = registry.GetFlags();
+
+		const uint32_t count = registry.GetCount();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			if (p_flags[i] & SpriteRegistry::FLAG_STATIC) continue;
+
+			Update(registry.GetSlot(i), i, ComputeBounds(registry, i));
+		}
+	}
+
+	/// <summary>
+	/// collect the sprites whose bounds intersect the view
+	/// the cells of the view widened by the largest half size are visited, and a cell fully inside the view is taken without tests
+	/// </summary>
+	void Grid::Query(_In_ const Renderer::ViewRect& view, _Out_ std::vector<uint32_t>* p_indices)
+	{
+		p_indices->clear();
+		_lastQueryStats = {};
+
+		if (_cells.empty() || view.Right < view.Left || view.Bottom < view.Top)
+			return;
+
+		// a sprite is in the cell of its center, so its bounds reach at most the largest half size out of the cell
+		const float margin = _maxHalfSize;
+		const uint32_t first_cell = GetCellIndex(view.Left  - margin, view.Top    - margin);
+		const uint32_t last_cell  = GetCellIndex(view.Right + margin, view.Bottom + margin);
+		const uint32_t first_column = first_cell % _columns, first_row = first_cell / _columns;
+		const uint32_t last_column  = last_cell  % _columns, last_row  = last_cell  / _columns;
+
+		for (uint32_t row = first_row; row <= last_row; ++row)
+		{
+			for (uint32_t column = first_column; column <= last_column; ++column)
+			{
+				const Cell& cell = _cells[row * _columns + column];
+				++_lastQueryStats.Cells;
+
+				const size_t count = cell.Indices.size();
+				if (!count) continue;
+
+				// the border cells also hold the clamped sprites outside the world, so they are always tested
+				const float cell_left = _world.Left + column * _cellSize;
+				const float cell_top  = _world.Top  + row * _cellSize;
+				const bool is_border = column == 0 || row == 0 || column == _columns - 1 || row == _rows - 1;
+				const bool is_inside = !is_border &&
+					cell_left - margin >= view.Left && cell_left + _cellSize + margin <= view.Right &&
+					cell_top  - margin >= view.Top  && cell_top  + _cellSize + margin <= view.Bottom;
+
+				if (is_inside)
+				{
+					p_indices->insert(p_indices->end(), cell.Indices.begin(), cell.Indices.end());
+					continue;
+				}
+
+				_lastQueryStats.Candidates += static_cast<uint32_t>(count);
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (Intersects(cell.Bounds[i], view)) p_indices->push_back(cell.Indices[i]);
+				}
+			}
+		}
+
+		_lastQueryStats.Visible = static_cast<uint32_t>(p_indices->size());
+	}
+
+	/// <summary>
+	/// compute the bounds of a sprite
+	/// the frame is interpolated between the two steps, so both are covered
+	/// a region rotated in the atlas swaps the scale and turns by 90 degrees, which gives the same bounds
+	/// </summary>
+	Renderer::ViewRect Grid::ComputeBounds(_In_ const SpriteRegistry::Registry& registry, _In_ uint32_t index)
+	{
+		const SpriteRegistry::Transforms& transforms = registry.GetTransforms();
+
+		float half_x = 0.0f, half_y = 0.0f;
+		GetRotatedHalfExtents(transforms.ScaleX[index], transforms.ScaleY[index], transforms.Rotation[index], &half_x, &half_y);
+
+		float previous_half_x = 0.0f, previous_half_y = 0.0f;
+		GetRotatedHalfExtents(transforms.ScaleX[index], transforms.ScaleY[index], transforms.PreviousRotation[index], &previous_half_x, &previous_half_y);
+
+		const float x = transforms.PositionX[index], previous_x = transforms.PreviousX[index];
+		const float y = transforms.PositionY[index], previous_y = transforms.PreviousY[index];
+
+		return
+		{
+			std::min(x - half_x, previous_x - previous_half_x),
+			std::min(y - half_y, previous_y - previous_half_y),
+			std::max(x + half_x, previous_x + previous_half_x),
+			std::max(y + half_y, previous_y + previous_half_y)
+		};
+	}
+
+	/// <summary>
+	/// get statistics of the last query
+	/// </summary>
+	const QueryStats& Grid::GetLastQueryStats() const
+	{
+		return _lastQueryStats;
+	}
+}
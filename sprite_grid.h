@@ -0,0 +1,103 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "portable_sal.h"
+#include "renderer_types.h"
+#include "sprite_registry.h"
+
+namespace SpriteGrid
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// a cell a few times larger than a typical sprite keeps the cells short and the ring of neighbors cheap
+	constexpr float DEFAULT_CELL_SIZE = 256.0f;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// sprites whose bounds are centered in a cell
+	/// the dense indices are apart from the bounds, so a cell fully inside the view is copied without reading the bounds
+	/// </summary>
+	struct Cell
+	{
+		std::vector<Renderer::ViewRect> Bounds;
+		std::vector<uint32_t> Indices;  // dense index in the registry, kept up to date by Update
+		std::vector<uint32_t> Slots;
+	};
+
+	/// <summary>
+	/// statistics of the last query
+	/// </summary>
+	struct QueryStats
+	{
+		uint32_t Cells;       // cells visited
+		uint32_t Candidates;  // items tested against the view
+		uint32_t Visible;
+	};
+
+	//--------------------------------------------------------
+	// grid class
+	//--------------------------------------------------------
+	/// <summary>
+	/// loose uniform grid over the sprites of a registry
+	/// a sprite is stored once, in the cell of the center of its bounds, and the query is widened by the largest half size
+	/// positions outside the world are clamped to the border cells
+	/// the query does not read the registry, so a sprite moved to another dense index by a destroy must be updated too
+	/// </summary>
+	class Grid
+	{
+		Renderer::ViewRect _world;
+		float _cellSize;
+		float _inverseCellSize;
+		uint32_t _columns;
+		uint32_t _rows;
+
+		std::vector<Cell> _cells;
+
+		// per slot of the registry, the cell and the position in the cell (INVALID_INDEX if not inserted)
+		std::vector<uint32_t> _itemCell;
+		std::vector<uint32_t> _itemPosition;
+
+		// largest half width or height of the inserted bounds, only grows between synchronizations
+		float _maxHalfSize;
+
+		QueryStats _lastQueryStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		uint32_t GetCellIndex(_In_ float x, _In_ float y) const;
+		void RemoveFromCell(_In_ uint32_t slot);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Grid();
+
+		void Initialize(_In_ const Renderer::ViewRect& world, _In_ float cellSize = DEFAULT_CELL_SIZE);
+		void Terminate();
+
+		// insert or move a sprite, O(1)
+		void Update(_In_ uint32_t slot, _In_ uint32_t index, _In_ const Renderer::ViewRect& bounds);
+		void Remove(_In_ uint32_t slot);
+
+		// update every live sprite of the registry but the static ones, only the sprites changing cells touch the cell lists
+		void Synchronize(_In_ const SpriteRegistry::Registry& registry);
+
+		// dense indices of the sprites whose bounds intersect the view, in the order of the cells
+		void Query(_In_ const Renderer::ViewRect& view, _Out_ std::vector<uint32_t>* p_indices);
+
+		// bounds of a sprite covering its rotated quad at the previous and current fixed step
+		static Renderer::ViewRect ComputeBounds(_In_ const SpriteRegistry::Registry& registry, _In_ uint32_t index);
+
+		// getter
+		const QueryStats& GetLastQueryStats() const;
+	};
+}
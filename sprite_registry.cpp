@@ -0,0 +1,628 @@
+
+#include <algorithm>
+#include <cstring>
+
+#include "sprite_registry.h"
+#include "quad_kernel.h"
+
+namespace SpriteRegistry
+{
+	namespace
+	{
+		/// <summary>
+		/// pack a slot and its generation into a handle
+		/// </summary>
+		Handle MakeHandle(uint32_t slot, uint32_t generation)
+		{
+			return (static_cast<Handle>(generation) << 32) | slot;
+		}
+
+		/// <summary>
+		/// get the slot of a handle
+		/// </summary>
+		uint32_t GetHandleSlot(Handle handle)
+		{
+			return static_cast<uint32_t>(handle & 0xffffffff);
+		}
+
+		/// <summary>
+		/// get the generation of a handle
+		/// </summary>
+		uint32_t GetHandleGeneration(Handle handle)
+		{
+			return static_cast<uint32_t>(handle >> 32);
+		}
+	}
+
+	/// <summary>
+	/// constructor for sprite registry
+	/// </summary>
+	Registry::Registry()
+	{
+		_count = 0;
+	}
+
+	/// <summary>
+	/// resize every dense component
+	/// </summary>
+	void Registry::ResizeComponents(_In_ size_t size)
+	{
+		_transforms.PositionX.resize(size);
+		_transforms.PositionY.resize(size);
+		_transforms.ScaleX.resize(size);
+		_transforms.ScaleY.resize(size);
+		_transforms.Rotation.resize(size);
+		_transforms.PreviousX.resize(size);
+		_transforms.PreviousY.resize(size);
+		_transforms.PreviousRotation.resize(size);
+
+		_uvRects.TexcoordU.resize(size);
+		_uvRects.TexcoordV.resize(size);
+		_uvRects.TexSizeU.resize(size);
+		_uvRects.TexSizeV.resize(size);
+
+		_colors.R.resize(size);
+		_colors.G.resize(size);
+		_colors.B.resize(size);
+		_colors.A.resize(size);
+
+		_textures.resize(size);
+		_materials.resize(size);
+		_layers.resize(size);
+		_depths.resize(size);
+		_blends.resize(size);
+		_flags.resize(size);
+
+		_denseToSlot.resize(size);
+	}
+
+	/// <summary>
+	/// grow the dense components geometrically, they never shrink
+	/// </summary>
+	void Registry::GrowComponents(_In_ size_t size)
+	{
+		const size_t capacity = _flags.size();
+		if (size <= capacity) return;
+
+		ResizeComponents(size < capacity * 2 ? capacity * 2 : size);
+	}
+
+	/// <summary>
+	/// move the components of a sprite to another dense index
+	/// </summary>
+	void Registry::MoveComponents(_In_ uint32_t to, _In_ uint32_t from)
+	{
+		_transforms.PositionX[to]        = _transforms.PositionX[from];
+		_transforms.PositionY[to]        = _transforms.PositionY[from];
+		_transforms.ScaleX[to]           = _transforms.ScaleX[from];
+		_transforms.ScaleY[to]           = _transforms.ScaleY[from];
+		_transforms.Rotation[to]         = _transforms.Rotation[from];
+		_transforms.PreviousX[to]        = _transforms.PreviousX[from];
+		_transforms.PreviousY[to]        = _transforms.PreviousY[from];
+		_transforms.PreviousRotation[to] = _transforms.PreviousRotation[from];
+
+		_uvRects.TexcoordU[to] = _uvRects.TexcoordU[from];
+		_uvRects.TexcoordV[to] = _uvRects.TexcoordV[from];
+		_uvRects.TexSizeU[to]  = _uvRects.TexSizeU[from];
+		_uvRects.TexSizeV[to]  = _uvRects.TexSizeV[from];
+
+		_colors.R[to] = _colors.R[from];
+		_colors.G[to] = _colors.G[from];
+		_colors.B[to] = _colors.B[from];
+		_colors.A[to] = _colors.A[from];
+
+		_textures[to]  = _textures[from];
+		_materials[to] = _materials[from];
+		_layers[to]    = _layers[from];
+		_depths[to]    = _depths[from];
+		_blends[to]    = _blends[from];
+		_flags[to]     = _flags[from];
+
+		_denseToSlot[to] = _denseToSlot[from];
+		_slotToDense[_denseToSlot[to]] = to;
+	}
+
+	/// <summary>
+	/// multiply the color of a chunk sprite by its alpha, an additive sprite then draws with alpha 0 so nothing of the target is removed
+	/// </summary>
+	void Registry::PremultiplyDrawColor(_In_ uint32_t i, _In_ uint8_t flags)
+	{
+		const float alpha = _drawColor[3][i];
+		_drawColor[0][i] *= alpha;
+		_drawColor[1][i] *= alpha;
+		_drawColor[2][i] *= alpha;
+		if (flags & FLAG_ADDITIVE) _drawColor[3][i] = 0.0f;
+	}
+
+	/// <summary>
+	/// reserve the storage of sprites, so creating up to the capacity does not allocate
+	/// </summary>
+	void Registry::Reserve(_In_ uint32_t capacity)
+	{
+		GrowComponents(capacity);
+
+		_slotToDense.reserve(capacity);
+		_generations.reserve(capacity);
+		_freeSlots.reserve(capacity);
+	}
+
+	/// <summary>
+	/// destroy every sprite
+	/// the generations are kept, so the old handles stay invalid
+	/// </summary>
+	void Registry::Clear()
+	{
+		for (uint32_t i = 0; i < _count; ++i)
+		{
+			const uint32_t slot = _denseToSlot[i];
+			_slotToDense[slot] = INVALID_INDEX;
+			++_generations[slot];
+			_freeSlots.push_back(slot);
+		}
+
+		_count = 0;
+	}
+
+	/// <summary>
+	/// create a sprite at the end of the dense arrays
+	/// </summary>
+	Handle Registry::Create(_In_ const Desc& desc)
+	{
+		uint32_t slot = 0;
+		if (_freeSlots.empty())
+		{
+			slot = static_cast<uint32_t>(_slotToDense.size());
+			_slotToDense.push_back(INVALID_INDEX);
+			_generations.push_back(0);
+		}
+		else
+		{
+			slot = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+
+		const uint32_t index = _count++;
+		GrowComponents(_count);
+
+		_transforms.PositionX[index]        = desc.Position[0];
+		_transforms.PositionY[index]        = desc.Position[1];
+		_transforms.ScaleX[index]           = desc.Scale[0];
+		_transforms.ScaleY[index]           = desc.Scale[1];
+		_transforms.Rotation[index]         = desc.Rotation;
+		_transforms.PreviousX[index]        = desc.Position[0];
+		_transforms.PreviousY[index]        = desc.Position[1];
+		_transforms.PreviousRotation[index] = desc.Rotation;
+
+		_uvRects.TexcoordU[index] = desc.Texcoord[0];
+		_uvRects.TexcoordV[index] = desc.Texcoord[1];
+		_uvRects.TexSizeU[index]  = desc.TexSize[0];
+		_uvRects.TexSizeV[index]  = desc.TexSize[1];
+
+		_colors.R[index] = desc.Color[0];
+		_colors.G[index] = desc.Color[1];
+		_colors.B[index] = desc.Color[2];
+		_colors.A[index] = desc.Color[3];
+
+		_textures[index]  = desc.Texture;
+		_materials[index] = desc.Material;
+		_layers[index]    = desc.Layer;
+		_depths[index]    = desc.Depth;
+		_blends[index]    = desc.Blend;
+		_flags[index]     = desc.Flags;
+
+		_denseToSlot[index] = slot;
+		_slotToDense[slot]  = index;
+
+		return MakeHandle(slot, _generations[slot]);
+	}
+
+	/// <summary>
+	/// destroy a sprite, the last sprite is moved into its place
+	/// a stale or invalid handle is ignored
+	/// </summary>
+	void Registry::Destroy(_In_ Handle handle)
+	{
+		const uint32_t index = GetIndex(handle);
+		if (index == INVALID_INDEX) return;
+
+		const uint32_t slot = GetHandleSlot(handle);
+		const uint32_t last = _count - 1;
+		if (index != last) MoveComponents(index, last);
+
+		_count = last;
+
+		// the handles of the slot become stale
+		_slotToDense[slot] = INVALID_INDEX;
+		++_generations[slot];
+		_freeSlots.push_back(slot);
+	}
+
+	/// <summary>
+	/// keep the state of the last fixed step for the interpolation
+	/// </summary>
+	void Registry::SavePreviousState()
+	{
+		std::copy(_transforms.PositionX.begin(), _transforms.PositionX.begin() + _count, _transforms.PreviousX.begin());
+		std::copy(_transforms.PositionY.begin(), _transforms.PositionY.begin() + _count, _transforms.PreviousY.begin());
+		std::copy(_transforms.Rotation.begin(),  _transforms.Rotation.begin()  + _count, _transforms.PreviousRotation.begin());
+	}
+
+	/// <summary>
+	/// interpolate a chunk of sprites between their last two fixed steps into the scratch arrays
+	/// </summary>
+	QuadKernel::SpriteArrays Registry::InterpolateChunk(_In_ uint32_t first, _In_ uint32_t count, _In_ float interpolation)
+	{
+		if (count > QUAD_CHUNK_SPRITES) count = QUAD_CHUNK_SPRITES;
+
+		const float* p_x  = &_transforms.PositionX[first];
+		const float* p_y  = &_transforms.PositionY[first];
+		const float* p_r  = &_transforms.Rotation[first];
+		const float* p_px = &_transforms.PreviousX[first];
+		const float* p_py = &_transforms.PreviousY[first];
+		const float* p_pr = &_transforms.PreviousRotation[first];
+		const float* p_sx = &_transforms.ScaleX[first];
+		const float* p_sy = &_transforms.ScaleY[first];
+		const uint8_t* p_flags = &_flags[first];
+		const Renderer::BlendMode* p_blends = &_blends[first];
+
+		bool has_premultiplied = false;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			_drawX[i] = p_px[i] + (p_x[i] - p_px[i]) * interpolation;
+			_drawY[i] = p_py[i] + (p_y[i] - p_py[i]) * interpolation;
+			_drawRotation[i] = p_pr[i] + (p_r[i] - p_pr[i]) * interpolation;
+
+			// a rotated region is drawn as a quad in the atlas orientation, turned back counterclockwise
+			const bool is_rotated = (p_flags[i] & FLAG_REGION_ROTATED) != 0;
+			_drawScaleX[i] = is_rotated ? p_sy[i] : p_sx[i];
+			_drawScaleY[i] = is_rotated ? p_sx[i] : p_sy[i];
+			if (is_rotated) _drawRotation[i] -= 1.57079632679f;
+
+			has_premultiplied |= (p_blends[i] == Renderer::BlendMode::Premultiplied);
+		}
+
+		// the colors are read in place unless a sprite of the chunk needs them premultiplied
+		const float* p_colors[4] = { &_colors.R[first], &_colors.G[first], &_colors.B[first], &_colors.A[first] };
+		if (has_premultiplied)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				memcpy(_drawColor[c], p_colors[c], sizeof(float) * count);
+				p_colors[c] = _drawColor[c];
+			}
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				if (p_blends[i] == Renderer::BlendMode::Premultiplied) PremultiplyDrawColor(i, p_flags[i]);
+			}
+		}
+
+		return
+		{
+			_drawX, _drawY, _drawScaleX, _drawScaleY, _drawRotation,
+			&_uvRects.TexcoordU[first], &_uvRects.TexcoordV[first], &_uvRects.TexSizeU[first], &_uvRects.TexSizeV[first],
+			p_colors[0], p_colors[1], p_colors[2], p_colors[3],
+			count
+		};
+	}
+
+	/// <summary>
+	/// gather a chunk of sprites by dense index and interpolate them into the scratch arrays
+	/// </summary>
+	QuadKernel::SpriteArrays Registry::InterpolateChunk(_In_ const uint32_t* p_indices, _In_ uint32_t count, _In_ float interpolation)
+	{
+		if (count > QUAD_CHUNK_SPRITES) count = QUAD_CHUNK_SPRITES;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t index = p_indices[i];
+
+			_drawX[i] = _transforms.PreviousX[index] + (_transforms.PositionX[index] - _transforms.PreviousX[index]) * interpolation;
+			_drawY[i] = _transforms.PreviousY[index] + (_transforms.PositionY[index] - _transforms.PreviousY[index]) * interpolation;
+			_drawRotation[i] = _transforms.PreviousRotation[index] + (_transforms.Rotation[index] - _transforms.PreviousRotation[index]) * interpolation;
+
+			const bool is_rotated = (_flags[index] & FLAG_REGION_ROTATED) != 0;
+			_drawScaleX[i] = is_rotated ? _transforms.ScaleY[index] : _transforms.ScaleX[index];
+			_drawScaleY[i] = is_rotated ? _transforms.ScaleX[index] : _transforms.ScaleY[index];
+			if (is_rotated) _drawRotation[i] -= 1.57079632679f;
+
+			_drawUvRect[0][i] = _uvRects.TexcoordU[index];
+			_drawUvRect[1][i] = _uvRects.TexcoordV[index];
+			_drawUvRect[2][i] = _uvRects.TexSizeU[index];
+			_drawUvRect[3][i] = _uvRects.TexSizeV[index];
+
+			_drawColor[0][i] = _colors.R[index];
+			_drawColor[1][i] = _colors.G[index];
+			_drawColor[2][i] = _colors.B[index];
+			_drawColor[3][i] = _colors.A[index];
+			if (_blends[index] == Renderer::BlendMode::Premultiplied) PremultiplyDrawColor(i, _flags[index]);
+
+			_drawTexture[i]  = _textures[index];
+			_drawMaterial[i] = _materials[index];
+		}
+
+		return
+		{
+			_drawX, _drawY, _drawScaleX, _drawScaleY, _drawRotation,
+			_drawUvRect[0], _drawUvRect[1], _drawUvRect[2], _drawUvRect[3],
+			_drawColor[0], _drawColor[1], _drawColor[2], _drawColor[3],
+			count
+		};
+	}
+
+	/// <summary>
+	/// interpolate a chunk of sprites and generate 4 vertices per sprite
+	/// </summary>
+	void Registry::GenerateQuads(_In_ uint32_t first, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::QuadVertex* p_vertex)
+	{
+		QuadKernel::GenerateQuads(InterpolateChunk(first, count, interpolation), p_vertex);
+	}
+
+	/// <summary>
+	/// gather a chunk of sprites by dense index, interpolate them and generate 4 vertices per sprite
+	/// </summary>
+	void Registry::GenerateQuads(_In_ const uint32_t* p_indices, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::QuadVertex* p_vertex)
+	{
+		QuadKernel::GenerateQuads(InterpolateChunk(p_indices, count, interpolation), p_vertex);
+	}
+
+	/// <summary>
+	/// interpolate a chunk of sprites and pack one instance per sprite
+	/// </summary>
+	void Registry::GenerateInstances(_In_ uint32_t first, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::SpriteInstance* p_instance)
+	{
+		QuadKernel::PackInstances(InterpolateChunk(first, count, interpolation), &_textures[first], p_instance);
+
+		for (uint32_t i = 0; i < count; ++i) p_instance[i].Material = _materials[first + i];
+	}
+
+	/// <summary>
+	/// gather a chunk of sprites by dense index, interpolate them and pack one instance per sprite
+	/// </summary>
+	void Registry::GenerateInstances(_In_ const uint32_t* p_indices, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::SpriteInstance* p_instance)
+	{
+		QuadKernel::PackInstances(InterpolateChunk(p_indices, count, interpolation), _drawTexture, p_instance);
+
+		for (uint32_t i = 0; i < count; ++i) p_instance[i].Material = _drawMaterial[i];
+	}
+
+
+	/// <summary>
+	/// check whether a handle refers to a live sprite
+	/// </summary>
+	bool Registry::IsAlive(_In_ Handle handle) const
+	{
+		return GetIndex(handle) != INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// get the dense index of a live handle
+	/// </summary>
+	uint32_t Registry::GetIndex(_In_ Handle handle) const
+	{
+		const uint32_t slot = GetHandleSlot(handle);
+		if (slot >= _slotToDense.size() || _generations[slot] != GetHandleGeneration(handle))
+			return INVALID_INDEX;
+
+		return _slotToDense[slot];
+	}
+
+	/// <summary>
+	/// get the handle of a dense index
+	/// </summary>
+	Handle Registry::GetHandle(_In_ uint32_t index) const
+	{
+		if (index >= _count) return INVALID_HANDLE;
+
+		const uint32_t slot = _denseToSlot[index];
+		return MakeHandle(slot, _generations[slot]);
+	}
+
+	/// <summary>
+	/// get the slot of a dense index
+	/// </summary>
+	uint32_t Registry::GetSlot(_In_ uint32_t index) const
+	{
+		return _denseToSlot[index];
+	}
+
+	/// <summary>
+	/// get the dense index of a slot
+	/// </summary>
+	uint32_t Registry::GetIndexOfSlot(_In_ uint32_t slot) const
+	{
+		return slot < _slotToDense.size() ? _slotToDense[slot] : INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// get the values of a sprite without a texture
+	/// </summary>
+	Desc Registry::GetDefaultDesc()
+	{
+		Desc desc = {};
+		desc.Scale[0]   = 1.0f;
+		desc.Scale[1]   = 1.0f;
+		desc.TexSize[0] = 1.0f;
+		desc.TexSize[1] = 1.0f;
+		for (float& color : desc.Color) color = 1.0f;
+		desc.Texture = 0xffffffff;
+		desc.Blend   = Renderer::BlendMode::AlphaBlend;
+
+		return desc;
+	}
+
+	/// <summary>
+	/// convert the blend of a desc to the premultiplied one
+	/// </summary>
+	Desc Registry::GetPremultipliedDesc(_In_ const Desc& desc)
+	{
+		Desc premultiplied = desc;
+		switch (desc.Blend)
+		{
+		case Renderer::BlendMode::Add:
+			premultiplied.Blend  = Renderer::BlendMode::Premultiplied;
+			premultiplied.Flags |= FLAG_ADDITIVE;
+			break;
+
+		case Renderer::BlendMode::AlphaBlend:
+			premultiplied.Blend = Renderer::BlendMode::Premultiplied;
+			break;
+
+		default:
+			break;
+		}
+
+		return premultiplied;
+	}
+
+	/// <summary>
+	/// get the number of live sprites
+	/// </summary>
+	uint32_t Registry::GetCount() const
+	{
+		return _count;
+	}
+
+	/// <summary>
+	/// get the transform components
+	/// </summary>
+	Transforms& Registry::GetTransforms()
+	{
+		return _transforms;
+	}
+
+	/// <summary>
+	/// get the uv rect components
+	/// </summary>
+	UvRects& Registry::GetUvRects()
+	{
+		return _uvRects;
+	}
+
+	/// <summary>
+	/// get the color components
+	/// </summary>
+	Colors& Registry::GetColors()
+	{
+		return _colors;
+	}
+
+	/// <summary>
+	/// get the texture components
+	/// </summary>
+	uint32_t* Registry::GetTextures()
+	{
+		return _textures.data();
+	}
+
+	/// <summary>
+	/// get the material components
+	/// </summary>
+	uint32_t* Registry::GetMaterials()
+	{
+		return _materials.data();
+	}
+
+	/// <summary>
+	/// get the layer components
+	/// </summary>
+	uint32_t* Registry::GetLayers()
+	{
+		return _layers.data();
+	}
+
+	/// <summary>
+	/// get the depth components
+	/// </summary>
+	float* Registry::GetDepths()
+	{
+		return _depths.data();
+	}
+
+	/// <summary>
+	/// get the blend mode components
+	/// </summary>
+	Renderer::BlendMode* Registry::GetBlends()
+	{
+		return _blends.data();
+	}
+
+	/// <summary>
+	/// get the flag components
+	/// </summary>
+	uint8_t* Registry::GetFlags()
+	{
+		return _flags.data();
+	}
+
+	/// <summary>
+	/// get the transform components
+	/// </summary>
+	const Transforms& Registry::GetTransforms() const
+	{
+		return _transforms;
+	}
+
+	/// <summary>
+	/// get the uv rect components
+	/// </summary>
+	const UvRects& Registry::GetUvRects() const
+	{
+		return _uvRects;
+	}
+
+	/// <summary>
+	/// get the color components
+	/// </summary>
+	const Colors& Registry::GetColors() const
+	{
+		return _colors;
+	}
+
+	/// <summary>
+	/// get the texture components
+	/// </summary>
+	const uint32_t* Registry::GetTextures() const
+	{
+		return _textures.data();
+	}
+
+	/// <summary>
+	/// get the material components
+	/// </summary>
+	const uint32_t* Registry::GetMaterials() const
+	{
+		return _materials.data();
+	}
+
+	/// <summary>
+	/// get the layer components
+	/// </summary>
+	const uint32_t* Registry::GetLayers() const
+	{
+		return _layers.data();
+	}
+
+	/// <summary>
+	/// get the depth components
+	/// </summary>
+	const float* Registry::GetDepths() const
+	{
+		return _depths.data();
+	}
+
+	/// <summary>
+	/// get the blend mode components
+	/// </summary>
+	const Renderer::BlendMode* Registry::GetBlends() const
+	{
+		return _blends.data();
+	}
+
+	/// <summary>
+	/// get the flag components
+	/// </summary>
+	const uint8_t* Registry::GetFlags() const
+	{
+		return _flags.data();
+	}
+}
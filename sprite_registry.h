@@ -0,0 +1,224 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "portable_sal.h"
+#include "quad_kernel.h"
+#include "renderer_types.h"
+#include "sprite_batch_core.h"
+
+namespace SpriteRegistry
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// the slot in the low 32 bits, and the generation of the slot in the high 32 bits
+	using Handle = uint64_t;
+	constexpr Handle INVALID_HANDLE = 0xffffffffffffffff;
+
+	constexpr uint32_t INVALID_INDEX = 0xffffffff;
+
+	// sprites interpolated per call of the quad kernel, so the scratch arrays stay in the cache
+	constexpr uint32_t QUAD_CHUNK_SPRITES = 256;
+
+	// flags of a sprite
+	constexpr uint8_t FLAG_REGION_ROTATED = 0x01;  // the region is stored 90 degrees clockwise in the atlas
+	constexpr uint8_t FLAG_OWNS_TEXTURE   = 0x02;  // the texture is released with the sprite
+	constexpr uint8_t FLAG_STATIC         = 0x04;  // baked into a vertex buffer, changes are picked up only when marked dirty
+	constexpr uint8_t FLAG_DIRTY          = 0x08;  // queued to be baked again
+	constexpr uint8_t FLAG_ADDITIVE       = 0x10;  // with the premultiplied blend, drawn with alpha 0 so its color is added
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// initial values of a sprite
+	/// </summary>
+	struct Desc
+	{
+		float Position[2];
+		float Scale[2];
+		float Rotation;
+
+		float Texcoord[2];
+		float TexSize[2];
+		float Color[4];
+
+		// opaque to the registry (a streamed texture handle, or an index of the caller)
+		uint32_t Texture;
+
+		// slot in the material table, written to the instances (0 is the default material)
+		uint32_t Material;
+
+		// layer of the sprite in the draw order
+		uint32_t Layer;
+
+		// order in the layer, a deeper sprite is drawn first
+		float Depth;
+
+		Renderer::BlendMode Blend;
+		uint8_t Flags;
+	};
+
+	/// <summary>
+	/// transform components, and the state of the previous fixed step
+	/// </summary>
+	struct Transforms
+	{
+		std::vector<float> PositionX;
+		std::vector<float> PositionY;
+		std::vector<float> ScaleX;
+		std::vector<float> ScaleY;
+		std::vector<float> Rotation;
+
+		std::vector<float> PreviousX;
+		std::vector<float> PreviousY;
+		std::vector<float> PreviousRotation;
+	};
+
+	/// <summary>
+	/// uv rect components
+	/// </summary>
+	struct UvRects
+	{
+		std::vector<float> TexcoordU;
+		std::vector<float> TexcoordV;
+		std::vector<float> TexSizeU;
+		std::vector<float> TexSizeV;
+	};
+
+	/// <summary>
+	/// color components
+	/// </summary>
+	struct Colors
+	{
+		std::vector<float> R;
+		std::vector<float> G;
+		std::vector<float> B;
+		std::vector<float> A;
+	};
+
+	//--------------------------------------------------------
+	// registry class
+	//--------------------------------------------------------
+	/// <summary>
+	/// dense structure-of-arrays storage of sprites, addressed by generational handles
+	/// a sparse set maps the slot of a handle to the dense index, so create and destroy are O(1)
+	/// destroy moves the last sprite into the hole, so dense indices are not stable but handles are
+	/// </summary>
+	class Registry
+	{
+		// dense components, the first _count elements of every array are live
+		Transforms _transforms;
+		UvRects _uvRects;
+		Colors _colors;
+		std::vector<uint32_t> _textures;
+		std::vector<uint32_t> _materials;
+		std::vector<uint32_t> _layers;
+		std::vector<float> _depths;
+		std::vector<Renderer::BlendMode> _blends;
+		std::vector<uint8_t> _flags;
+
+		// dense index to slot, and slot to dense index
+		std::vector<uint32_t> _denseToSlot;
+		std::vector<uint32_t> _slotToDense;
+		std::vector<uint32_t> _generations;
+
+		// released slots, reused first
+		std::vector<uint32_t> _freeSlots;
+
+		uint32_t _count;
+
+		// interpolated state of one chunk
+		float _drawX[QUAD_CHUNK_SPRITES];
+		float _drawY[QUAD_CHUNK_SPRITES];
+		float _drawScaleX[QUAD_CHUNK_SPRITES];
+		float _drawScaleY[QUAD_CHUNK_SPRITES];
+		float _drawRotation[QUAD_CHUNK_SPRITES];
+
+		// uv rects, colors, textures and materials of one chunk gathered by index
+		float _drawUvRect[4][QUAD_CHUNK_SPRITES];
+		float _drawColor[4][QUAD_CHUNK_SPRITES];
+		uint32_t _drawTexture[QUAD_CHUNK_SPRITES];
+		uint32_t _drawMaterial[QUAD_CHUNK_SPRITES];
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void ResizeComponents(_In_ size_t size);
+		void GrowComponents(_In_ size_t size);
+		void MoveComponents(_In_ uint32_t to, _In_ uint32_t from);
+		void PremultiplyDrawColor(_In_ uint32_t i, _In_ uint8_t flags);
+
+		// the arrays point to the scratch of the chunk (and to the components which need no interpolation)
+		// the colors of premultiplied sprites are stored straight, and multiplied by alpha into the scratch
+		QuadKernel::SpriteArrays InterpolateChunk(_In_ uint32_t first, _In_ uint32_t count, _In_ float interpolation);
+		QuadKernel::SpriteArrays InterpolateChunk(_In_ const uint32_t* p_indices, _In_ uint32_t count, _In_ float interpolation);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Registry();
+
+		void Reserve(_In_ uint32_t capacity);
+		void Clear();
+
+		Handle Create(_In_ const Desc& desc);
+		void Destroy(_In_ Handle handle);
+
+		// copy the current state of every sprite to the previous state, call at the start of a fixed step
+		void SavePreviousState();
+
+		// interpolate the sprites [first, first + count) and generate their quads, count is up to QUAD_CHUNK_SPRITES
+		void GenerateQuads(_In_ uint32_t first, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::QuadVertex* p_vertex);
+
+		// the same for the sprites of a list of dense indices (e.g. the visible ones)
+		void GenerateQuads(_In_ const uint32_t* p_indices, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::QuadVertex* p_vertex);
+
+		// the same, packed into one instance per sprite for the vertex shader to expand
+		void GenerateInstances(_In_ uint32_t first, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::SpriteInstance* p_instance);
+		void GenerateInstances(_In_ const uint32_t* p_indices, _In_ uint32_t count, _In_ float interpolation, _Out_ SpriteBatch::SpriteInstance* p_instance);
+
+		bool IsAlive(_In_ Handle handle) const;
+
+		// dense index of a live handle, INVALID_INDEX otherwise
+		uint32_t GetIndex(_In_ Handle handle) const;
+		Handle GetHandle(_In_ uint32_t index) const;
+
+		// slot of a dense index, and the dense index of a slot (INVALID_INDEX if the slot is free)
+		uint32_t GetSlot(_In_ uint32_t index) const;
+		uint32_t GetIndexOfSlot(_In_ uint32_t slot) const;
+
+		static Desc GetDefaultDesc();
+
+		// the same look with the premultiplied blend: alpha blended and additive sprites then share the blend state
+		// (subtract and no blending are kept)
+		static Desc GetPremultipliedDesc(_In_ const Desc& desc);
+
+		// getter of the dense components, indices [0, GetCount()) are live, valid until the next create or destroy
+		uint32_t GetCount() const;
+		Transforms& GetTransforms();
+		UvRects& GetUvRects();
+		Colors& GetColors();
+		uint32_t* GetTextures();
+		uint32_t* GetMaterials();
+		uint32_t* GetLayers();
+		float* GetDepths();
+		Renderer::BlendMode* GetBlends();
+		uint8_t* GetFlags();
+
+		const Transforms& GetTransforms() const;
+		const UvRects& GetUvRects() const;
+		const Colors& GetColors() const;
+		const uint32_t* GetTextures() const;
+		const uint32_t* GetMaterials() const;
+		const uint32_t* GetLayers() const;
+		const float* GetDepths() const;
+		const Renderer::BlendMode* GetBlends() const;
+		const uint8_t* GetFlags() const;
+	};
+}
@@ -0,0 +1,564 @@
+
+#include <algorithm>
+#include <cmath>
+
+#include "static_geometry.h"
+
+namespace StaticGeometry
+{
+	namespace
+	{
+		/// <summary>
+		/// check whether two rectangles intersect
+		/// </summary>
+		bool Intersects(const Renderer::ViewRect& bounds, const Renderer::ViewRect& view)
+		{
+			return bounds.Left <= view.Right && bounds.Right >= view.Left && bounds.Top <= view.Bottom && bounds.Bottom >= view.Top;
+		}
+
+		/// <summary>
+		/// grow the bounds of a chunk by a sprite
+		/// the corners are only known to the vertex shader, so a sprite is bounded by the circle through them
+		/// </summary>
+		void Include(Renderer::ViewRect& bounds, const SpriteBatch::SpriteInstance& instance, const SpriteRegistry::Transforms& transforms, uint32_t index)
+		{
+			const float radius = 0.5f * std::sqrt(transforms.ScaleX[index] * transforms.ScaleX[index] + transforms.ScaleY[index] * transforms.ScaleY[index]);
+			const float* p_position = instance.Position;
+			bounds.Left   = std::min(bounds.Left,   p_position[0] - radius);
+			bounds.Top    = std::min(bounds.Top,    p_position[1] - radius);
+			bounds.Right  = std::max(bounds.Right,  p_position[0] + radius);
+			bounds.Bottom = std::max(bounds.Bottom, p_position[1] + radius);
+		}
+	}
+
+	/// <summary>
+	/// constructor for static geometry cache
+	/// </summary>
+	Cache::Cache()
+	{
+		_backend = nullptr;
+		_materials = nullptr;
+		_materialsRevision = 0;
+		_isPremultiplied = false;
+
+		_view = {};
+		_drawCursor = 0;
+		_nextKey = UINT64_MAX;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for static geometry cache
+	/// </summary>
+	void Cache::Initialize(_In_ Backend* backend, _In_opt_ const MaterialTable::Table* p_materials)
+	{
+		_backend = backend;
+		_materials = p_materials;
+		_materialsRevision = p_materials ? p_materials->GetFeaturesRevision() : 0;
+
+		_instances.resize(CHUNK_SPRITES);
+		_isQuadDirty.assign(CHUNK_SPRITES, 0);
+		_positions.reserve(CHUNK_SPRITES);
+		_indices.reserve(CHUNK_SPRITES);
+		_keys.reserve(CHUNK_SPRITES);
+	}
+
+	/// <summary>
+	/// termination process for static geometry cache
+	/// </summary>
+	void Cache::Terminate()
+	{
+		for (Chunk& chunk : _chunks)
+		{
+			if (chunk.Buffer) _backend->ReleaseStaticBuffer(chunk.Buffer);
+		}
+
+		_chunks.clear();
+		_chunks.shrink_to_fit();
+		_chunkOrder.clear();
+		_openChunks.clear();
+		_slotChunk.clear();
+		_slotPosition.clear();
+		_slotQuad.clear();
+		_detachedSlots.clear();
+		_slotDetached.clear();
+
+		_instances.clear();
+		_instances.shrink_to_fit();
+		_isQuadDirty.clear();
+		_ranges.clear();
+		_backend = nullptr;
+		_materials = nullptr;
+	}
+
+	/// <summary>
+	/// create an empty chunk of a layer, kept in the order of the layers
+	/// </summary>
+	uint32_t Cache::CreateChunk(_In_ uint32_t layer)
+	{
+		const uint32_t chunk_index = static_cast<uint32_t>(_chunks.size());
+
+		Chunk chunk = {};
+		chunk.Layer = layer;
+		chunk.Slots.reserve(CHUNK_SPRITES);
+		_chunks.push_back(std::move(chunk));
+
+		// after the chunks of the same layer
+		auto position = std::upper_bound(_chunkOrder.begin(), _chunkOrder.end(), layer,
+			[this](uint32_t value, uint32_t index) { return value < _chunks[index].Layer; });
+		_chunkOrder.insert(position, chunk_index);
+
+		return chunk_index;
+	}
+
+	/// <summary>
+	/// bake a sprite into a chunk of its layer, or queue it to be written again if it is already baked in the same layer
+	/// </summary>
+	void Cache::Add(_In_ uint32_t slot, _In_ uint32_t layer)
+	{
+		if (slot >= _slotChunk.size())
+		{
+			_slotChunk.resize(slot + 1, SpriteRegistry::INVALID_INDEX);
+			_slotPosition.resize(slot + 1, 0);
+			_slotQuad.resize(slot + 1, 0);
+			_slotDetached.resize(slot + 1, SpriteRegistry::INVALID_INDEX);
+		}
+
+		if (_slotChunk[slot] != SpriteRegistry::INVALID_INDEX)
+		{
+			Chunk& chunk = _chunks[_slotChunk[slot]];
+			if (chunk.Layer == layer)
+			{
+				chunk.DirtySlots.push_back(slot);
+				return;
+			}
+
+			Remove(slot);
+		}
+
+		// the open chunk of the layer, or a new one when it is full
+		auto open = _openChunks.find(layer);
+		uint32_t chunk_index = (open != _openChunks.end()) ? open->second : SpriteRegistry::INVALID_INDEX;
+		if (chunk_index == SpriteRegistry::INVALID_INDEX || _chunks[chunk_index].Slots.size() >= CHUNK_SPRITES)
+		{
+			chunk_index = CreateChunk(layer);
+			_openChunks[layer] = chunk_index;
+		}
+
+		Chunk& chunk = _chunks[chunk_index];
+		_slotChunk[slot]    = chunk_index;
+		_slotPosition[slot] = static_cast<uint32_t>(chunk.Slots.size());
+		chunk.Slots.push_back(slot);
+		chunk.IsDirty = true;
+	}
+
+	/// <summary>
+	/// remove a sprite from its chunk, call when the sprite is destroyed or becomes dynamic
+	/// the last sprite of the chunk is moved into its place
+	/// </summary>
+	void Cache::Remove(_In_ uint32_t slot)
+	{
+		if (!Contains(slot)) return;
+
+		Chunk& chunk = _chunks[_slotChunk[slot]];
+		const uint32_t position = _slotPosition[slot];
+		if (_slotDetached[slot] != SpriteRegistry::INVALID_INDEX) Attach(chunk, slot);
+
+		chunk.Slots[position] = chunk.Slots.back();
+		_slotPosition[chunk.Slots[position]] = position;
+		chunk.Slots.pop_back();
+		chunk.IsDirty = true;
+
+		_slotChunk[slot] = SpriteRegistry::INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// check whether a sprite is baked
+	/// </summary>
+	bool Cache::Contains(_In_ uint32_t slot) const
+	{
+		return slot < _slotChunk.size() && _slotChunk[slot] != SpriteRegistry::INVALID_INDEX;
+	}
+
+	/// <summary>
+	/// hide the quad of a sprite in its chunk until the chunk is rebuilt, the sprite is streamed meanwhile
+	/// </summary>
+	void Cache::Detach(_In_ Chunk& chunk, _In_ uint32_t slot)
+	{
+		_slotDetached[slot] = static_cast<uint32_t>(_detachedSlots.size());
+		_detachedSlots.push_back(slot);
+		++chunk.DetachedCount;
+	}
+
+	/// <summary>
+	/// stop streaming a detached sprite, the last detached sprite is moved into its place
+	/// </summary>
+	void Cache::Attach(_In_ Chunk& chunk, _In_ uint32_t slot)
+	{
+		const uint32_t position = _slotDetached[slot];
+
+		_detachedSlots[position] = _detachedSlots.back();
+		_slotDetached[_detachedSlots[position]] = position;
+		_detachedSlots.pop_back();
+		_slotDetached[slot] = SpriteRegistry::INVALID_INDEX;
+		--chunk.DetachedCount;
+	}
+
+	/// <summary>
+	/// make the sort key of a sprite, the same as the one of a dynamic sprite
+	/// </summary>
+	uint64_t Cache::MakeKey(_Inout_ SpriteRegistry::Registry& registry, _In_ uint32_t index) const
+	{
+		const uint32_t material = registry.GetMaterials()[index];
+		const ShaderPermutation::Key features = ShaderPermutation::GetPipelineKey(
+			_materials ? _materials->GetFeatures(material) : ShaderPermutation::DEFAULT_KEY, _isPremultiplied);
+
+		return SortKey::Make({ registry.GetLayers()[index], registry.GetDepths()[index], features, registry.GetBlends()[index], registry.GetTextures()[index] });
+	}
+
+	/// <summary>
+	/// pack the instances of a chunk in the order of the sort keys, and replace its vertex buffer
+	/// the detached sprites are baked in their new place
+	/// </summary>
+	void Cache::RebuildChunk(_In_ Chunk& chunk, _Inout_ SpriteRegistry::Registry& registry)
+	{
+		for (size_t i = 0; i < chunk.Slots.size() && chunk.DetachedCount > 0; ++i)
+		{
+			if (_slotDetached[chunk.Slots[i]] != SpriteRegistry::INVALID_INDEX) Attach(chunk, chunk.Slots[i]);
+		}
+
+		if (chunk.Buffer)
+		{
+			_backend->ReleaseStaticBuffer(chunk.Buffer);
+			chunk.Buffer = 0;
+		}
+		chunk.Runs.clear();
+		chunk.Keys.clear();
+		chunk.QuadSlots.clear();
+		chunk.DirtySlots.clear();
+		chunk.Bounds = { 0.0f, 0.0f, -1.0f, -1.0f };
+		chunk.IsDirty = false;
+
+		const uint32_t count = static_cast<uint32_t>(chunk.Slots.size());
+		if (count == 0) return;
+
+		const uint32_t* p_textures = registry.GetTextures();
+		const Renderer::BlendMode* p_blends = registry.GetBlends();
+
+		// the same order as the dynamic sprites, so the runs share their state
+		// the positions in the chunk come in increasing order, so the sorter skips the passes over the values
+		_positions.resize(count);
+		_indices.resize(count);
+		_keys.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			_positions[i] = i;
+			_keys[i] = MakeKey(registry, registry.GetIndexOfSlot(chunk.Slots[i]));
+		}
+		_sorter.Sort(_keys.data(), _positions.data(), count);
+		chunk.Keys.assign(_keys.begin(), _keys.begin() + count);
+
+		// a dirty sprite finds its quad from its slot
+		chunk.QuadSlots.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t slot = chunk.Slots[_positions[i]];
+			chunk.QuadSlots[i] = slot;
+			_slotQuad[slot] = i;
+			_indices[i] = registry.GetIndexOfSlot(slot);
+		}
+
+		// a static sprite is drawn at its current state
+		for (uint32_t first = 0; first < count; first += SpriteRegistry::QUAD_CHUNK_SPRITES)
+		{
+			const uint32_t quads = std::min(count - first, SpriteRegistry::QUAD_CHUNK_SPRITES);
+			registry.GenerateInstances(&_indices[first], quads, 1.0f, &_instances[first]);
+		}
+
+		const SpriteRegistry::Transforms& transforms = registry.GetTransforms();
+		chunk.Bounds = { _instances[0].Position[0], _instances[0].Position[1], _instances[0].Position[0], _instances[0].Position[1] };
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const uint32_t index = _indices[i];
+			Include(chunk.Bounds, _instances[i], transforms, index);
+
+			// the materials of a run may differ, as long as they share the variant of the pixel shader
+			const ShaderPermutation::Key features = SortKey::GetPipeline(_keys[i]);
+
+			Run* p_last = chunk.Runs.empty() ? nullptr : &chunk.Runs.back();
+			if (p_last && p_last->Texture == p_textures[index] && p_last->Blend == p_blends[index] && p_last->Features == features)
+			{
+				p_last->QuadCount++;
+			}
+			else
+			{
+				chunk.Runs.push_back({ p_textures[index], p_blends[index], features, i, 1 });
+			}
+		}
+
+		chunk.Buffer = _backend->CreateStaticBuffer(_instances.data(), count);
+		if (!chunk.Buffer)
+		{
+			// drawn again after the next change
+			chunk.Runs.clear();
+			chunk.Keys.clear();
+			return;
+		}
+
+		++_frameStats.ChunksRebuilt;
+		_frameStats.UploadBytes += static_cast<uint64_t>(count) * sizeof(SpriteBatch::SpriteInstance);
+	}
+
+	/// <summary>
+	/// generate the quads of the dirty sprites of a chunk again and write them in place, the bounds only grow
+	/// a sprite whose sort key changed has to move in the order, so its quad is hidden and the sprite is streamed instead
+	/// the chunk is rebuilt once too many of its sprites are streamed
+	/// </summary>
+	void Cache::PatchChunk(_In_ Chunk& chunk, _Inout_ SpriteRegistry::Registry& registry)
+	{
+		if (!chunk.Buffer)
+		{
+			RebuildChunk(chunk, registry);
+			return;
+		}
+
+		// the quads of the dirty sprites are marked in the order of the buffer
+		const uint32_t count = static_cast<uint32_t>(chunk.QuadSlots.size());
+		for (uint32_t slot : chunk.DirtySlots)
+		{
+			// a streamed sprite is generated with its current state every frame
+			if (_slotDetached[slot] != SpriteRegistry::INVALID_INDEX) continue;
+
+			const uint32_t quad = _slotQuad[slot];
+			if (MakeKey(registry, registry.GetIndexOfSlot(slot)) != chunk.Keys[quad])
+			{
+				if (chunk.DetachedCount >= MAX_DETACHED_SPRITES)
+				{
+					std::fill(_isQuadDirty.begin(), _isQuadDirty.begin() + count, 0);
+					RebuildChunk(chunk, registry);
+					return;
+				}
+
+				Detach(chunk, slot);
+			}
+
+			_isQuadDirty[quad] = 1;
+		}
+		chunk.DirtySlots.clear();
+
+		// ranges of dirty quads with the small gaps of clean quads between them, every quad of the ranges is generated again
+		_ranges.clear();
+		_indices.clear();
+		for (uint32_t quad = 0; quad < count; ++quad)
+		{
+			if (!_isQuadDirty[quad]) continue;
+
+			uint32_t end = quad + 1;
+			for (uint32_t next = end; next < count && next <= end + PATCH_GAP_QUADS; ++next)
+			{
+				if (_isQuadDirty[next]) end = next + 1;
+			}
+
+			_ranges.push_back({ quad, end - quad });
+			for (; quad < end; ++quad)
+			{
+				_isQuadDirty[quad] = 0;
+				_indices.push_back(registry.GetIndexOfSlot(chunk.QuadSlots[quad]));
+			}
+		}
+
+		// the quads of every range are gathered together
+		const uint32_t quads = static_cast<uint32_t>(_indices.size());
+		for (uint32_t offset = 0; offset < quads; offset += SpriteRegistry::QUAD_CHUNK_SPRITES)
+		{
+			registry.GenerateInstances(&_indices[offset], std::min(quads - offset, SpriteRegistry::QUAD_CHUNK_SPRITES), 1.0f, &_instances[offset]);
+		}
+
+		// a detached sprite is written as a quad without area, which draws nothing
+		const SpriteRegistry::Transforms& transforms = registry.GetTransforms();
+		for (uint32_t i = 0; i < quads; ++i)
+		{
+			if (_slotDetached[registry.GetSlot(_indices[i])] != SpriteRegistry::INVALID_INDEX)
+			{
+				_instances[i] = {};
+				continue;
+			}
+
+			Include(chunk.Bounds, _instances[i], transforms, _indices[i]);
+		}
+
+		uint32_t offset = 0;
+		for (const QuadRange& range : _ranges)
+		{
+			_backend->UpdateStaticBuffer(chunk.Buffer, &_instances[offset], range.First, range.Count);
+			offset += range.Count;
+		}
+		_frameStats.UploadBytes += static_cast<uint64_t>(quads) * sizeof(SpriteBatch::SpriteInstance);
+
+		++_frameStats.ChunksPatched;
+	}
+
+	/// <summary>
+	/// rebuild the dirty chunks, and start the statistics of the frame
+	/// </summary>
+	void Cache::Rebuild(_Inout_ SpriteRegistry::Registry& registry)
+	{
+		_frameStats = {};
+		_frameStats.Chunks = static_cast<uint32_t>(_chunks.size());
+
+		// the runs of a chunk are split by the variants of its materials, so a variant edited in place dirties the chunks using it
+		// (rare, the sprites are only looked at when the table has such an edit since the last rebuild)
+		if (_materials && _materials->GetFeaturesRevision() != _materialsRevision)
+		{
+			const uint32_t* p_materials = registry.GetMaterials();
+			for (Chunk& chunk : _chunks)
+			{
+				for (size_t i = 0; i < chunk.Slots.size() && !chunk.IsDirty; ++i)
+				{
+					const uint32_t index = registry.GetIndexOfSlot(chunk.Slots[i]);
+					if (_materials->GetFeaturesRevision(p_materials[index]) > _materialsRevision) chunk.IsDirty = true;
+				}
+			}
+
+			_materialsRevision = _materials->GetFeaturesRevision();
+		}
+
+		for (Chunk& chunk : _chunks)
+		{
+			if (chunk.IsDirty) RebuildChunk(chunk, registry);
+			else if (!chunk.DirtySlots.empty()) PatchChunk(chunk, registry);
+		}
+
+		_frameStats.Detached = static_cast<uint32_t>(_detachedSlots.size());
+	}
+
+	/// <summary>
+	/// draw the quads of a chunk from the last drawn one up to a position, the runs are cut at both ends
+	/// </summary>
+	void Cache::DrawQuads(_Inout_ Chunk& chunk, _In_ uint32_t end)
+	{
+		if (chunk.DrawnQuads == 0) ++_frameStats.ChunksDrawn;
+
+		// the run the first quad is in
+		auto it = std::upper_bound(chunk.Runs.begin(), chunk.Runs.end(), chunk.DrawnQuads,
+			[](uint32_t quad, const Run& run) { return quad < run.FirstQuad; }) - 1;
+		for (; it != chunk.Runs.end() && it->FirstQuad < end; ++it)
+		{
+			Run run = *it;
+			const uint32_t first = std::max(run.FirstQuad, chunk.DrawnQuads);
+			const uint32_t last  = std::min(run.FirstQuad + run.QuadCount, end);
+			run.FirstQuad = first;
+			run.QuadCount = last - first;
+
+			_backend->DrawStaticRun(chunk.Buffer, run);
+			++_frameStats.Runs;
+		}
+
+		chunk.DrawnQuads = end;
+	}
+
+	/// <summary>
+	/// find the smallest key left to draw, UINT64_MAX if every chunk is drawn
+	/// </summary>
+	uint64_t Cache::FindNextKey() const
+	{
+		uint64_t next_key = UINT64_MAX;
+		for (uint32_t i = _drawCursor; i < _chunkOrder.size(); ++i)
+		{
+			const Chunk& chunk = _chunks[_chunkOrder[i]];
+			if (chunk.DrawnQuads >= chunk.Keys.size()) continue;
+
+			// the layers come in order, a later layer has no smaller key
+			if (next_key != UINT64_MAX && SortKey::GetLayer(chunk.Keys[chunk.DrawnQuads]) > SortKey::GetLayer(next_key)) break;
+
+			next_key = std::min(next_key, chunk.Keys[chunk.DrawnQuads]);
+		}
+
+		return next_key;
+	}
+
+	/// <summary>
+	/// start drawing the chunks of a frame, the chunks out of the view count as drawn
+	/// </summary>
+	void Cache::Begin(_In_ const Renderer::ViewRect& view)
+	{
+		_view = view;
+		_drawCursor = 0;
+
+		for (Chunk& chunk : _chunks)
+		{
+			const bool is_visible = chunk.Buffer && Intersects(chunk.Bounds, _view);
+			chunk.DrawnQuads = is_visible ? 0 : static_cast<uint32_t>(chunk.Keys.size());
+		}
+
+		_nextKey = FindNextKey();
+	}
+
+	/// <summary>
+	/// draw the static sprites whose key is not greater than the key of the next dynamic sprite
+	/// a chunk is drawn in the parts between the dynamic sprites which go in between, and in one run per state when nothing does
+	/// </summary>
+	void Cache::DrawUpTo(_In_ uint64_t key)
+	{
+		// most dynamic sprites have no static sprite before them
+		if (key < _nextKey) return;
+
+		for (uint32_t i = _drawCursor; i < _chunkOrder.size(); ++i)
+		{
+			Chunk& chunk = _chunks[_chunkOrder[i]];
+			if (chunk.DrawnQuads >= chunk.Keys.size()) continue;
+			if (SortKey::GetLayer(chunk.Keys[chunk.DrawnQuads]) > SortKey::GetLayer(key)) break;
+
+			// an equal key goes first, so the static sprites stay below the dynamic ones of the same state and depth
+			const uint32_t end = static_cast<uint32_t>(std::upper_bound(chunk.Keys.begin() + chunk.DrawnQuads, chunk.Keys.end(), key) - chunk.Keys.begin());
+			if (end > chunk.DrawnQuads) DrawQuads(chunk, end);
+		}
+
+		// the chunks drawn to their end are not looked at again
+		for (; _drawCursor < _chunkOrder.size(); ++_drawCursor)
+		{
+			const Chunk& chunk = _chunks[_chunkOrder[_drawCursor]];
+			if (chunk.DrawnQuads < chunk.Keys.size()) break;
+		}
+
+		_nextKey = FindNextKey();
+	}
+
+	/// <summary>
+	/// draw the chunks left, and close the frame
+	/// </summary>
+	void Cache::End()
+	{
+		DrawUpTo(UINT64_MAX);
+		_lastFrameStats = _frameStats;
+	}
+
+	/// <summary>
+	/// set whether the baked instances are premultiplied, the runs of every chunk pick their variants again
+	/// </summary>
+	void Cache::SetPremultipliedAlpha(_In_ bool isPremultiplied)
+	{
+		if (_isPremultiplied == isPremultiplied) return;
+
+		_isPremultiplied = isPremultiplied;
+		for (Chunk& chunk : _chunks) chunk.IsDirty = true;
+	}
+
+	/// <summary>
+	/// get the slots of the static sprites streamed with the dynamic ones
+	/// </summary>
+	const std::vector<uint32_t>& Cache::GetDetachedSlots() const
+	{
+		return _detachedSlots;
+	}
+
+	/// <summary>
+	/// get statistics of the last drawn frame
+	/// </summary>
+	const FrameStats& Cache::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
@@ -0,0 +1,214 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "material_table.h"
+#include "portable_sal.h"
+#include "renderer_types.h"
+#include "sort_key.h"
+#include "sprite_batch_core.h"
+#include "sprite_registry.h"
+
+namespace StaticGeometry
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// sprites baked into one vertex buffer
+	// a dirty sprite keeping its sort key is written in place, a sprite added or removed rebuilds the chunk
+	constexpr uint32_t CHUNK_SPRITES = 4096;
+	static_assert(CHUNK_SPRITES <= SpriteBatch::MAX_QUADS_PER_DRAW, "a run of a chunk is drawn in one call");
+
+	// dirty quads closer than this are uploaded in one call, the clean quads in between are generated again
+	constexpr uint32_t PATCH_GAP_QUADS = 16;
+
+	// a sprite moved in the order is hidden in its chunk and streamed with the dynamic sprites,
+	// until the chunk has more of them than this and is rebuilt with every sprite in place
+	constexpr uint32_t MAX_DETACHED_SPRITES = CHUNK_SPRITES / 16;
+
+	// the variant of the pixel shader is the pipeline of the sort keys, so the sprites of a variant are drawn together
+	static_assert(ShaderPermutation::VARIANT_COUNT <= (1u << SortKey::PIPELINE_BITS), "the variants have to fit the key");
+
+	// opaque identifier of a baked vertex buffer (the backend decides what it points to), 0 is none
+	using BufferId = uintptr_t;
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// consecutive quads of a chunk drawn with the same texture and state
+	/// </summary>
+	struct Run
+	{
+		uint32_t Texture;  // the texture component of the registry
+		Renderer::BlendMode Blend;
+		ShaderPermutation::Key Features;  // variant of the pixel shader of the materials
+		uint32_t FirstQuad;
+		uint32_t QuadCount;
+	};
+
+	/// <summary>
+	/// static sprites of one layer baked into one vertex buffer
+	/// </summary>
+	struct Chunk
+	{
+		uint32_t Layer;
+		std::vector<uint32_t> Slots;
+		std::vector<Run> Runs;
+		std::vector<uint64_t> Keys;        // sort key of each quad of the buffer, in increasing order
+		std::vector<uint32_t> QuadSlots;   // slot of each quad of the buffer
+		std::vector<uint32_t> DirtySlots;  // sprites written since the chunk was built, patched in place
+		uint32_t DetachedCount;            // sprites hidden in the buffer and streamed until the chunk is rebuilt
+		Renderer::ViewRect Bounds;
+		BufferId Buffer;
+		uint32_t DrawnQuads;               // quads drawn in the frame, every quad when the chunk is culled
+		bool IsDirty;
+	};
+
+	/// <summary>
+	/// statistics of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Chunks;
+		uint32_t ChunksDrawn;
+		uint32_t ChunksRebuilt;
+		uint32_t ChunksPatched;
+		uint32_t Detached;  // static sprites streamed with the dynamic ones
+		uint32_t Runs;
+		uint64_t UploadBytes;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		// create a vertex buffer of instances, 0 on failure
+		virtual BufferId CreateStaticBuffer(_In_ const SpriteBatch::SpriteInstance* p_instances, _In_ uint32_t quadCount) = 0;
+		virtual void ReleaseStaticBuffer(_In_ BufferId buffer) = 0;
+
+		// write the quads [firstQuad, firstQuad + quadCount) of a vertex buffer, the rest is left as it is
+		virtual void UpdateStaticBuffer(_In_ BufferId buffer, _In_ const SpriteBatch::SpriteInstance* p_instances, _In_ uint32_t firstQuad, _In_ uint32_t quadCount) = 0;
+
+		// draw a run of quads from a baked vertex buffer
+		virtual void DrawStaticRun(_In_ BufferId buffer, _In_ const Run& run) = 0;
+	};
+
+	//--------------------------------------------------------
+	// cache class
+	//--------------------------------------------------------
+	/// <summary>
+	/// vertex buffers of the static sprites of a registry, patched or rebuilt chunk by chunk when a sprite is marked dirty
+	/// a frame without dirty sprites only culls the chunks and draws their runs, nothing is generated or uploaded
+	/// a dirty sprite keeping its place in the order only uploads its own quad, about the cost of streaming it
+	/// a dirty sprite moved in the order is hidden in its chunk and streamed (GetDetachedSlots), so a few moving sprites never rebuild a chunk
+	/// the quads of the chunks are merged into the sorted dynamic sprites by DrawUpTo, with the same sort keys,
+	/// so the depth order holds between static and dynamic sprites (a static sprite goes first on an equal key)
+	/// the cache keeps slots, so a sprite moved to another dense index by a destroy does not dirty its chunk
+	/// </summary>
+	class Cache
+	{
+		/// <summary>
+		/// quads of a chunk written in one upload
+		/// </summary>
+		struct QuadRange
+		{
+			uint32_t First;
+			uint32_t Count;
+		};
+
+		Backend* _backend;
+
+		// the variants of the materials of the registry, the default one without a table
+		// a material changing its variant in place dirties the chunks of its sprites, at the revision of the table seen last
+		const MaterialTable::Table* _materials;
+		uint32_t _materialsRevision;
+
+		// the baked instances are premultiplied, the variants drop the premultiplied feature
+		bool _isPremultiplied;
+
+		std::vector<Chunk> _chunks;
+
+		// chunks in the order of their layers, and the chunk of each layer which has room
+		std::vector<uint32_t> _chunkOrder;
+		std::unordered_map<uint32_t, uint32_t> _openChunks;
+
+		// per slot of the registry, the chunk, the position in the chunk (INVALID_INDEX if not static) and the quad in its buffer
+		std::vector<uint32_t> _slotChunk;
+		std::vector<uint32_t> _slotPosition;
+		std::vector<uint32_t> _slotQuad;
+
+		// static sprites streamed with the dynamic ones, and the position of each slot in them (INVALID_INDEX if not detached)
+		std::vector<uint32_t> _detachedSlots;
+		std::vector<uint32_t> _slotDetached;
+
+		// scratch of a rebuild
+		std::vector<uint32_t> _positions;
+		std::vector<uint32_t> _indices;
+		std::vector<uint64_t> _keys;
+		std::vector<SpriteBatch::SpriteInstance> _instances;
+		SortKey::Sorter _sorter;
+
+		// scratch of a patch
+		std::vector<uint8_t> _isQuadDirty;
+		std::vector<QuadRange> _ranges;
+
+		// chunks left to draw in the frame (the first one not drawn to its end), and the smallest key left in them
+		Renderer::ViewRect _view;
+		uint32_t _drawCursor;
+		uint64_t _nextKey;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		uint32_t CreateChunk(_In_ uint32_t layer);
+		uint64_t MakeKey(_Inout_ SpriteRegistry::Registry& registry, _In_ uint32_t index) const;
+		void RebuildChunk(_In_ Chunk& chunk, _Inout_ SpriteRegistry::Registry& registry);
+		void PatchChunk(_In_ Chunk& chunk, _Inout_ SpriteRegistry::Registry& registry);
+		void Detach(_In_ Chunk& chunk, _In_ uint32_t slot);
+		void Attach(_In_ Chunk& chunk, _In_ uint32_t slot);
+		void DrawQuads(_Inout_ Chunk& chunk, _In_ uint32_t end);
+		uint64_t FindNextKey() const;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Cache();
+
+		void Initialize(_In_ Backend* backend, _In_opt_ const MaterialTable::Table* p_materials = nullptr);
+		void Terminate();
+
+		// bake a sprite, or write it again in the chunk it is in (e.g. after its components were written)
+		void Add(_In_ uint32_t slot, _In_ uint32_t layer);
+		void Remove(_In_ uint32_t slot);
+		bool Contains(_In_ uint32_t slot) const;
+
+		// patch or rebuild the dirty chunks, call before the first draw of a frame (the instances are packed with the scratch of the registry)
+		void Rebuild(_Inout_ SpriteRegistry::Registry& registry);
+
+		// draw the static sprites intersecting the view up to the sort key of the next dynamic sprite, End draws the rest
+		void Begin(_In_ const Renderer::ViewRect& view);
+		void DrawUpTo(_In_ uint64_t key);
+		void End();
+
+		// setter
+		void SetPremultipliedAlpha(_In_ bool isPremultiplied);
+
+		// getter
+		// slots of the static sprites to draw with the dynamic ones, valid until the next Rebuild
+		const std::vector<uint32_t>& GetDetachedSlots() const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
@@ -2,12 +2,20 @@
 #include "directx11_wrapper.h"
 #include "sprite.h"
 #include "renderer.h"
-#include "vertex.h"
 #include "material.h"
 #include "texture.h"
 
 namespace Texture
 {
+	/// <summary>
+	/// constructor for texture
+	/// </summary>
+	Manager::Manager()
+	{
+		_sprite = Sprite::INVALID_HANDLE;
+		_material = MaterialTable::INVALID_INDEX;
+	}
+
 	/// <summary>
 	/// instantiate with the Singleton Method Design Pattern
 	/// </summary>
@@ -22,23 +30,34 @@ namespace Texture
 	/// </summary>
 	HRESULT Manager::Initialize()
 	{
-		HRESULT h_result = S_OK;
+		// material, an equal one registered before shares its slot
+		Material::Manager material;
+		material.SetDiffuse({ 1.0f, 1.0f, 1.0f, 1.0f });
+		_material = material.Register();
+		if (_material == MaterialTable::INVALID_INDEX)
+			return E_FAIL;
 
 		// texture path
-		TexturePath = new wchar_t[512];
-		mbstowcs_s(0, TexturePath, strlen(TEXTURE_FILE_PATH) + 1, TEXTURE_FILE_PATH, _TRUNCATE);
-
-		h_result = CreateSrvFromFile();
-		h_result = CreateVertexBuffer();
+		wchar_t texture_path[512];
+		mbstowcs_s(0, texture_path, strlen(TEXTURE_FILE_PATH) + 1, TEXTURE_FILE_PATH, _TRUNCATE);
 
 		// setting param
-		Renderer::Manager renderer = Renderer::Manager::Instance();
-		Position  = { Renderer::SCREEN_SIZE_WIDTH * 0.5f,  Renderer::SCREEN_SIZE_HEIGHT * 0.5f  };
-		Scale     = { Renderer::SCREEN_SIZE_WIDTH * 0.75f, Renderer::SCREEN_SIZE_HEIGHT * 0.75f };
-		Texcoord  = { 0.0f, 0.0f };
-		TexSize   = { 1.0f, 1.0f };
-
-		return h_result;
+		SpriteRegistry::Desc desc = SpriteRegistry::Registry::GetDefaultDesc();
+		desc.Position[0] = Renderer::SCREEN_SIZE_WIDTH  * 0.5f;
+		desc.Position[1] = Renderer::SCREEN_SIZE_HEIGHT * 0.5f;
+		desc.Scale[0]    = Renderer::SCREEN_SIZE_WIDTH  * 0.75f;
+		desc.Scale[1]    = Renderer::SCREEN_SIZE_HEIGHT * 0.75f;
+		desc.Blend       = Renderer::BlendMode::None;
+		desc.Material    = _material;
+
+		// it never moves, so it is baked once instead of generated every frame
+		desc.Flags       = SpriteRegistry::FLAG_STATIC;
+
+		_sprite = Sprite::Manager::Instance().CreateFromFile(texture_path, desc);
+		if (_sprite == Sprite::INVALID_HANDLE)
+			return E_FAIL;
+
+		return S_OK;
 	}
 
 	/// <summary>
@@ -46,48 +65,26 @@ namespace Texture
 	/// </summary>
 	void Manager::Terminate()
 	{
-		Release();
+		Sprite::Manager::Instance().Destroy(_sprite);
+		_sprite = Sprite::INVALID_HANDLE;
+
+		Renderer::Manager::Instance().GetMaterialTable().Release(_material);
+		_material = MaterialTable::INVALID_INDEX;
 	}
 
 	/// <summary>
 	/// update process for texture
+	/// the previous state is saved by the sprite manager
 	/// </summary>
 	void Manager::Update()
 	{
-
 	}
 
 	/// <summary>
 	/// draw process for texture
+	/// the sprite itself is submitted by the sprite manager, and its material is already resident
 	/// </summary>
 	void Manager::Draw()
 	{
-		// renderer settings before draw texture
-		Renderer::Manager renderer = Renderer::Manager::Instance();
-		renderer.SetDepthEnableState(Renderer::DepthEnebleMode::Disable);
-		renderer.SetBlendMode(Renderer::BlendMode::None);
-
-		// setting data for Input-Assembler stage
-		UINT stride = sizeof(Vertex::Manager);
-		UINT offset = 0;
-		renderer.GetDeviceContext().IASetVertexBuffers(0, 1, &VertexBuffer, &stride, &offset);
-		renderer.GetDeviceContext().IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-
-		// calculate mvp matrix
-		renderer.SetMatrixWorldViewProjection2D();
-
-		// material
-		Material::Manager material;
-		ZeroMemory(&material, sizeof(material));
-		material.SetDiffuse({ 1.0f, 1.0f, 1.0f, 1.0f });
-		material.SetConstantBuffer();
-
-		// draw
-		renderer.GetDeviceContext().PSSetShaderResources(0, 1, &Srv);
-		SetAnchorPointCenter();
-		renderer.GetDeviceContext().Draw(4, 0);
-
-		// renderer settings after draw texture
-		renderer.SetDepthEnableState(Renderer::DepthEnebleMode::Enable);
 	}
 }
@@ -5,14 +5,21 @@ namespace Texture
 {
 	constexpr char* TEXTURE_FILE_PATH = "resource/texture/test.png";
 
-	class Manager : public Sprite::Manager
+	class Manager
 	{
+		// the sprite of the texture in the sprite registry
+		Sprite::Handle _sprite;
+
+		// registered once, the sprite only carries its index
+		MaterialTable::Index _material;
+
 	public:
+		Manager();
 		static Manager& Instance();
 
-		HRESULT Initialize() override;
-		void Terminate() override;
-		void Update() override;
-		void Draw() override;
+		HRESULT Initialize();
+		void Terminate();
+		void Update();
+		void Draw();
 	};
 }
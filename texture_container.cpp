@@ -0,0 +1,345 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "texture_container.h"
+
+namespace TextureContainer
+{
+	namespace
+	{
+		/// <summary>
+		/// bytes of a texel, or of a 4x4 block
+		/// </summary>
+		uint32_t GetBytesPerElement(PixelFormat format)
+		{
+			switch (format)
+			{
+			case PixelFormat::Rgba8: return 4;
+			case PixelFormat::Bc1:   return 8;
+			case PixelFormat::Bc4:   return 8;
+			case PixelFormat::Bc3:   return 16;
+			case PixelFormat::Bc7:   return 16;
+			default:                 return 0;
+			}
+		}
+
+		/// <summary>
+		/// round up to the alignment of the subresources
+		/// </summary>
+		uint64_t AlignData(uint64_t offset)
+		{
+			return (offset + DATA_ALIGNMENT - 1) & ~static_cast<uint64_t>(DATA_ALIGNMENT - 1);
+		}
+	}
+
+	//--------------------------------------------------------
+	// reader
+	//--------------------------------------------------------
+	/// <summary>
+	/// constructor for container reader
+	/// </summary>
+	Reader::Reader()
+	{
+		_header       = nullptr;
+		_subresources = nullptr;
+	}
+
+	/// <summary>
+	/// map and validate a container
+	/// </summary>
+	int Reader::Open(_In_ const char* path)
+	{
+		Close();
+
+		if (_file.Open(path) != 0)
+			return -1;
+
+		return Validate();
+	}
+
+#ifdef _WIN32
+	/// <summary>
+	/// map and validate a container with a wide path
+	/// </summary>
+	int Reader::Open(_In_ const wchar_t* path)
+	{
+		Close();
+
+		if (_file.Open(path) != 0)
+			return -1;
+
+		return Validate();
+	}
+#endif
+
+	/// <summary>
+	/// check the header and that every subresource lies inside the file
+	/// </summary>
+	int Reader::Validate()
+	{
+		const size_t size = _file.GetSize();
+		if (size < sizeof(FileHeader))
+		{
+			Close();
+			return -2;
+		}
+
+		const FileHeader* p_header = reinterpret_cast<const FileHeader*>(_file.GetData());
+		const bool is_valid_header =
+			p_header->Magic == FILE_MAGIC && p_header->Version == FILE_VERSION &&
+			GetBytesPerElement(p_header->Format) != 0 && p_header->Width != 0 && p_header->Height != 0 &&
+			p_header->MipLevels != 0 && p_header->MipLevels <= GetMipCount(p_header->Width, p_header->Height) &&
+			sizeof(FileHeader) + sizeof(SubresourceHeader) * p_header->MipLevels <= size;
+		if (!is_valid_header)
+		{
+			Close();
+			return -2;
+		}
+
+		const SubresourceHeader* p_subresources = reinterpret_cast<const SubresourceHeader*>(_file.GetData() + sizeof(FileHeader));
+		for (uint32_t mip = 0; mip < p_header->MipLevels; ++mip)
+		{
+			const SubresourceHeader& subresource = p_subresources[mip];
+			const uint32_t width  = std::max(p_header->Width  >> mip, 1u);
+			const uint32_t height = std::max(p_header->Height >> mip, 1u);
+
+			const bool is_valid_subresource =
+				subresource.Width == width && subresource.Height == height &&
+				subresource.RowPitch == GetRowPitch(p_header->Format, width) &&
+				subresource.SlicePitch == subresource.RowPitch * GetRowCount(p_header->Format, height) &&
+				subresource.Offset % DATA_ALIGNMENT == 0 &&
+				subresource.Offset <= size && subresource.SlicePitch <= size - subresource.Offset;
+			if (!is_valid_subresource)
+			{
+				Close();
+				return -2;
+			}
+		}
+
+		_header       = p_header;
+		_subresources = p_subresources;
+
+		return 0;
+	}
+
+	/// <summary>
+	/// unmap the container
+	/// </summary>
+	void Reader::Close()
+	{
+		_file.Close();
+
+		_header       = nullptr;
+		_subresources = nullptr;
+	}
+
+	/// <summary>
+	/// touch the pages of the container
+	/// </summary>
+	void Reader::Prefetch() const
+	{
+		_file.Prefetch();
+	}
+
+	/// <summary>
+	/// get the file header
+	/// </summary>
+	const FileHeader& Reader::GetHeader() const
+	{
+		return *_header;
+	}
+
+	/// <summary>
+	/// get the layout of a mip level
+	/// </summary>
+	const SubresourceHeader& Reader::GetSubresource(_In_ uint32_t mip) const
+	{
+		return _subresources[mip];
+	}
+
+	/// <summary>
+	/// get the texels of a mip level inside the mapping
+	/// </summary>
+	const void* Reader::GetSubresourceData(_In_ uint32_t mip) const
+	{
+		return _file.GetData() + _subresources[mip].Offset;
+	}
+
+	/// <summary>
+	/// get the bytes of all mip levels
+	/// </summary>
+	size_t Reader::GetDataSize() const
+	{
+		size_t bytes = 0;
+		for (uint32_t mip = 0; mip < _header->MipLevels; ++mip)
+		{
+			bytes += _subresources[mip].SlicePitch;
+		}
+
+		return bytes;
+	}
+
+	/// <summary>
+	/// check whether a container is mapped
+	/// </summary>
+	bool Reader::IsOpen() const
+	{
+		return _header != nullptr;
+	}
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the bytes of a row of texels, or of 4x4 blocks
+	/// </summary>
+	uint32_t GetRowPitch(_In_ PixelFormat format, _In_ uint32_t width)
+	{
+		if (format == PixelFormat::Rgba8)
+			return width * GetBytesPerElement(format);
+
+		return std::max((width + 3) / 4, 1u) * GetBytesPerElement(format);
+	}
+
+	/// <summary>
+	/// get the number of rows of texels, or of 4x4 blocks
+	/// </summary>
+	uint32_t GetRowCount(_In_ PixelFormat format, _In_ uint32_t height)
+	{
+		if (format == PixelFormat::Rgba8)
+			return height;
+
+		return std::max((height + 3) / 4, 1u);
+	}
+
+	/// <summary>
+	/// get the number of levels of the full mip chain
+	/// </summary>
+	uint32_t GetMipCount(_In_ uint32_t width, _In_ uint32_t height)
+	{
+		uint32_t count = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+		{
+			++count;
+		}
+
+		return count;
+	}
+
+	/// <summary>
+	/// halve an RGBA8 image
+	/// </summary>
+	void DownsampleRgba8(_In_ const uint8_t* source, _In_ uint32_t width, _In_ uint32_t height, _Out_ std::vector<uint8_t>* p_destination)
+	{
+		const uint32_t dst_width  = std::max(width  >> 1, 1u);
+		const uint32_t dst_height = std::max(height >> 1, 1u);
+		p_destination->resize(static_cast<size_t>(dst_width) * dst_height * 4);
+
+		for (uint32_t y = 0; y < dst_height; ++y)
+		{
+			// an odd last row or column is folded into the last texel
+			const uint32_t y0 = std::min(y * 2, height - 1);
+			const uint32_t y1 = (y == dst_height - 1) ? height - 1 : std::min(y * 2 + 1, height - 1);
+
+			for (uint32_t x = 0; x < dst_width; ++x)
+			{
+				const uint32_t x0 = std::min(x * 2, width - 1);
+				const uint32_t x1 = (x == dst_width - 1) ? width - 1 : std::min(x * 2 + 1, width - 1);
+
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					uint32_t sum = 0, count = 0;
+					for (uint32_t sy = y0; sy <= y1; ++sy)
+					{
+						for (uint32_t sx = x0; sx <= x1; ++sx)
+						{
+							sum += source[(static_cast<size_t>(sy) * width + sx) * 4 + c];
+							++count;
+						}
+					}
+					(*p_destination)[(static_cast<size_t>(y) * dst_width + x) * 4 + c] = static_cast<uint8_t>((sum + count / 2) / count);
+				}
+			}
+		}
+	}
+
+	/// <summary>
+	/// write a container
+	/// </summary>
+	int Write(_In_ const std::string& path, _In_ PixelFormat format, _In_ uint32_t width, _In_ uint32_t height,
+		_In_ uint32_t mipLevels, _In_ const uint8_t* const* p_mips, _In_ uint32_t flags)
+	{
+		if (GetBytesPerElement(format) == 0 || width == 0 || height == 0 ||
+			mipLevels == 0 || mipLevels > GetMipCount(width, height))
+			return -2;
+
+		FileHeader header = {};
+		header.Magic     = FILE_MAGIC;
+		header.Version   = FILE_VERSION;
+		header.Format    = format;
+		header.Width     = width;
+		header.Height    = height;
+		header.MipLevels = mipLevels;
+		header.Flags     = flags;
+
+		std::vector<SubresourceHeader> subresources(mipLevels);
+		uint64_t offset = AlignData(sizeof(FileHeader) + sizeof(SubresourceHeader) * mipLevels);
+		for (uint32_t mip = 0; mip < mipLevels; ++mip)
+		{
+			SubresourceHeader& subresource = subresources[mip];
+			subresource = {};
+			subresource.Width      = std::max(width  >> mip, 1u);
+			subresource.Height     = std::max(height >> mip, 1u);
+			subresource.RowPitch   = GetRowPitch(format, subresource.Width);
+			subresource.SlicePitch = subresource.RowPitch * GetRowCount(format, subresource.Height);
+			subresource.Offset     = offset;
+
+			offset = AlignData(offset + subresource.SlicePitch);
+		}
+
+		FILE* p_file = std::fopen(path.c_str(), "wb");
+		if (!p_file)
+			return -1;
+
+		static const uint8_t s_zero[DATA_ALIGNMENT] = {};
+		bool is_written =
+			std::fwrite(&header, sizeof(header), 1, p_file) == 1 &&
+			std::fwrite(subresources.data(), sizeof(SubresourceHeader), mipLevels, p_file) == mipLevels;
+
+		uint64_t position = sizeof(FileHeader) + sizeof(SubresourceHeader) * mipLevels;
+		for (uint32_t mip = 0; mip < mipLevels && is_written; ++mip)
+		{
+			const size_t padding = static_cast<size_t>(subresources[mip].Offset - position);
+			is_written =
+				std::fwrite(s_zero, 1, padding, p_file) == padding &&
+				std::fwrite(p_mips[mip], 1, subresources[mip].SlicePitch, p_file) == subresources[mip].SlicePitch;
+
+			position = subresources[mip].Offset + subresources[mip].SlicePitch;
+		}
+
+		is_written = (std::fclose(p_file) == 0) && is_written;
+
+		return is_written ? 0 : -1;
+	}
+
+	/// <summary>
+	/// write an RGBA8 image, and the mip levels made by box filtering
+	/// </summary>
+	int CookRgba8(_In_ const std::string& path, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ bool generateMips)
+	{
+		const uint32_t mip_levels = generateMips ? GetMipCount(width, height) : 1;
+
+		std::vector<std::vector<uint8_t>> levels(mip_levels - 1);
+		std::vector<const uint8_t*> p_mips(mip_levels);
+		p_mips[0] = pixels;
+		for (uint32_t mip = 1; mip < mip_levels; ++mip)
+		{
+			DownsampleRgba8(p_mips[mip - 1], std::max(width >> (mip - 1), 1u), std::max(height >> (mip - 1), 1u), &levels[mip - 1]);
+			p_mips[mip] = levels[mip - 1].data();
+		}
+
+		return Write(path, PixelFormat::Rgba8, width, height, mip_levels, p_mips.data());
+	}
+}
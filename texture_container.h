@@ -0,0 +1,142 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+#include "portable_sal.h"
+
+namespace TextureContainer
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// "CTEX" in little endian
+	constexpr uint32_t FILE_MAGIC   = 0x58455443;
+	constexpr uint32_t FILE_VERSION = 1;
+
+	// cooked textures sit next to the source image with this extension
+	constexpr const char* FILE_EXTENSION = ".ctex";
+
+	// subresources start on cache line boundaries, so they can be read in place
+	constexpr size_t DATA_ALIGNMENT = 64;
+
+	constexpr uint32_t MAX_MIP_LEVELS = 16;
+
+	// flags of the file header (files written before the flags hold 0 in their place)
+	constexpr uint32_t FLAG_PREMULTIPLIED_ALPHA = 0x1;  // the colors are multiplied by alpha
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// pixel format of the subresources
+	/// </summary>
+	enum class PixelFormat : uint32_t
+	{
+		Unknown = 0,
+		Rgba8,                   // red is the lowest byte
+		Bc1,
+		Bc3,
+		Bc4,
+		Bc7,
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// file header, followed by a subresource header per mip level
+	/// </summary>
+	struct FileHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		PixelFormat Format;
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t MipLevels;
+		uint32_t Flags;
+		uint32_t Reserved;
+	};
+
+	/// <summary>
+	/// where a mip level lives in the file
+	/// </summary>
+	struct SubresourceHeader
+	{
+		uint64_t Offset;         // from the top of the file, multiple of DATA_ALIGNMENT
+		uint32_t RowPitch;       // bytes per row of texels or blocks
+		uint32_t SlicePitch;     // bytes of the whole level
+		uint32_t Width;
+		uint32_t Height;
+		uint32_t Reserved[2];
+	};
+
+	static_assert(sizeof(FileHeader) == 32, "the file layout must not depend on the compiler");
+	static_assert(sizeof(SubresourceHeader) == 32, "the file layout must not depend on the compiler");
+
+	//--------------------------------------------------------
+	// reader class
+	//--------------------------------------------------------
+	/// <summary>
+	/// maps a container, and hands out pointers into the mapping without copies
+	/// </summary>
+	class Reader
+	{
+		MappedFile::View _file;
+
+		const FileHeader* _header;
+		const SubresourceHeader* _subresources;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		int Validate();
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Reader();
+
+		// returns 0 on success, -1 if the file cannot be mapped, -2 if it is not a valid container
+		int Open(_In_ const char* path);
+#ifdef _WIN32
+		int Open(_In_ const wchar_t* path);
+#endif
+		void Close();
+
+		// read the subresources ahead of the upload
+		void Prefetch() const;
+
+		// getter
+		const FileHeader& GetHeader() const;
+		const SubresourceHeader& GetSubresource(_In_ uint32_t mip) const;
+		const void* GetSubresourceData(_In_ uint32_t mip) const;
+		size_t GetDataSize() const;
+		bool IsOpen() const;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// layout of a mip level
+	uint32_t GetRowPitch(_In_ PixelFormat format, _In_ uint32_t width);
+	uint32_t GetRowCount(_In_ PixelFormat format, _In_ uint32_t height);
+	uint32_t GetMipCount(_In_ uint32_t width, _In_ uint32_t height);
+
+	// halves an RGBA8 image with a box filter (odd sizes fold the last texel in)
+	void DownsampleRgba8(_In_ const uint8_t* source, _In_ uint32_t width, _In_ uint32_t height, _Out_ std::vector<uint8_t>* p_destination);
+
+	// write a container, every mip level is tightly packed with GetRowPitch
+	// returns 0 on success, -1 if the file cannot be written, -2 on invalid arguments
+	int Write(_In_ const std::string& path, _In_ PixelFormat format, _In_ uint32_t width, _In_ uint32_t height,
+		_In_ uint32_t mipLevels, _In_ const uint8_t* const* p_mips, _In_ uint32_t flags = 0);
+
+	// write an RGBA8 image with the full mip chain
+	int CookRgba8(_In_ const std::string& path, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ bool generateMips = true);
+}
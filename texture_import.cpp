@@ -0,0 +1,1343 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "texture_import.h"
+#include "thread_pool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TEXTURE_IMPORT_X86
+#include <emmintrin.h>
+#endif
+
+namespace TextureImport
+{
+	using TextureContainer::PixelFormat;
+
+	namespace
+	{
+		//--------------------------------------------------------
+		// constant
+		//--------------------------------------------------------
+		// entries of the table from linear light to 8-bit sRGB, fine enough for the darkest steps
+		constexpr uint32_t SRGB_TABLE_SIZE = 65536;
+
+		// least squares fits of the endpoints to the chosen indices, kept only while the error drops
+		constexpr int REFINE_PASSES = 2;
+
+		// texels premultiplied per task of the thread pool
+		constexpr size_t PREMULTIPLY_TEXELS_PER_TASK = 0x10000;
+
+		// power iterations for the principal axis of a block
+		constexpr int AXIS_ITERATIONS = 8;
+
+		// weights of the 4-bit indices of BC7, out of 64
+		constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// the only BC7 mode written: one subset, RGBA 7.7.7.7 endpoints with a p-bit each, 4-bit indices
+		constexpr uint32_t BC7_MODE = 6;
+
+		//--------------------------------------------------------
+		// color space
+		//--------------------------------------------------------
+		/// <summary>
+		/// tables between 8-bit sRGB and linear light
+		/// </summary>
+		struct ColorTables
+		{
+			float ToLinear[256];
+			uint8_t ToSrgb[SRGB_TABLE_SIZE];
+		};
+
+		/// <summary>
+		/// create the tables with the exact transfer functions
+		/// </summary>
+		ColorTables* CreateColorTables()
+		{
+			static ColorTables s_tables;
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				const float v = i / 255.0f;
+				s_tables.ToLinear[i] = (v <= 0.04045f) ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+			}
+			for (uint32_t i = 0; i < SRGB_TABLE_SIZE; ++i)
+			{
+				const float v = static_cast<float>(i) / (SRGB_TABLE_SIZE - 1);
+				const float srgb = (v <= 0.0031308f) ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+				s_tables.ToSrgb[i] = static_cast<uint8_t>(srgb * 255.0f + 0.5f);
+			}
+
+			return &s_tables;
+		}
+
+		/// <summary>
+		/// get the tables, created by the first call (thread safe)
+		/// </summary>
+		const ColorTables& GetColorTables()
+		{
+			static const ColorTables* s_p_tables = CreateColorTables();
+			return *s_p_tables;
+		}
+
+		/// <summary>
+		/// convert RGBA8 texels into linear floats (the alpha is always linear)
+		/// </summary>
+		void ToLinear(const uint8_t* pixels, size_t count, bool isSrgb, float* p_linear)
+		{
+			const ColorTables& tables = GetColorTables();
+			for (size_t i = 0; i < count * 4; ++i)
+			{
+				p_linear[i] = (isSrgb && (i & 3) != 3) ? tables.ToLinear[pixels[i]] : pixels[i] / 255.0f;
+			}
+		}
+
+		/// <summary>
+		/// convert linear floats into RGBA8 texels
+		/// </summary>
+		void FromLinear(const float* p_linear, size_t count, bool isSrgb, uint8_t* pixels)
+		{
+			const ColorTables& tables = GetColorTables();
+			for (size_t i = 0; i < count * 4; ++i)
+			{
+				const float v = std::min(std::max(p_linear[i], 0.0f), 1.0f);
+				pixels[i] = (isSrgb && (i & 3) != 3)
+					? tables.ToSrgb[static_cast<uint32_t>(v * (SRGB_TABLE_SIZE - 1) + 0.5f)]
+					: static_cast<uint8_t>(v * 255.0f + 0.5f);
+			}
+		}
+
+		//--------------------------------------------------------
+		// mip filter
+		//--------------------------------------------------------
+		/// <summary>
+		/// source texels of a destination texel, an odd last row or column is folded into the last one
+		/// </summary>
+		inline void GetFootprint(uint32_t d, uint32_t dstSize, uint32_t srcSize, uint32_t* p_first, uint32_t* p_last)
+		{
+			*p_first = std::min(d * 2, srcSize - 1);
+			*p_last  = (d == dstSize - 1) ? srcSize - 1 : std::min(d * 2 + 1, srcSize - 1);
+		}
+
+		/// <summary>
+		/// box filter of the rows [yBegin, yEnd) of a level
+		/// the colors are weighted by alpha, a fully transparent footprint keeps its plain average
+		/// </summary>
+		void FilterRowsScalar(const float* p_src, uint32_t srcWidth, uint32_t srcHeight, float* p_dst, uint32_t dstWidth, uint32_t dstHeight,
+			uint32_t yBegin, uint32_t yEnd)
+		{
+			for (uint32_t y = yBegin; y < yEnd; ++y)
+			{
+				uint32_t y0, y1;
+				GetFootprint(y, dstHeight, srcHeight, &y0, &y1);
+
+				for (uint32_t x = 0; x < dstWidth; ++x)
+				{
+					uint32_t x0, x1;
+					GetFootprint(x, dstWidth, srcWidth, &x0, &x1);
+
+					float weighted[4] = {};
+					float plain[4] = {};
+					uint32_t count = 0;
+					for (uint32_t sy = y0; sy <= y1; ++sy)
+					{
+						for (uint32_t sx = x0; sx <= x1; ++sx)
+						{
+							const float* p = &p_src[(static_cast<size_t>(sy) * srcWidth + sx) * 4];
+							for (int c = 0; c < 3; ++c) weighted[c] += p[c] * p[3];
+							weighted[3] += p[3];
+							for (int c = 0; c < 4; ++c) plain[c] += p[c];
+							++count;
+						}
+					}
+
+					const float inv_count = 1.0f / count;
+					float* q = &p_dst[(static_cast<size_t>(y) * dstWidth + x) * 4];
+					for (int c = 0; c < 3; ++c) q[c] = (weighted[3] > 0.0f) ? weighted[c] / weighted[3] : plain[c] * inv_count;
+					q[3] = weighted[3] * inv_count;
+				}
+			}
+		}
+
+#ifdef TEXTURE_IMPORT_X86
+		/// <summary>
+		/// box filter with a texel per register, the same operations as the scalar one (so the same bits)
+		/// </summary>
+		void FilterRowsSse2(const float* p_src, uint32_t srcWidth, uint32_t srcHeight, float* p_dst, uint32_t dstWidth, uint32_t dstHeight,
+			uint32_t yBegin, uint32_t yEnd)
+		{
+			const __m128 alpha_lane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+			const __m128 one  = _mm_set1_ps(1.0f);
+			const __m128 zero = _mm_setzero_ps();
+
+			for (uint32_t y = yBegin; y < yEnd; ++y)
+			{
+				uint32_t y0, y1;
+				GetFootprint(y, dstHeight, srcHeight, &y0, &y1);
+
+				for (uint32_t x = 0; x < dstWidth; ++x)
+				{
+					uint32_t x0, x1;
+					GetFootprint(x, dstWidth, srcWidth, &x0, &x1);
+
+					__m128 weighted = zero;
+					__m128 plain = zero;
+					uint32_t count = 0;
+					for (uint32_t sy = y0; sy <= y1; ++sy)
+					{
+						for (uint32_t sx = x0; sx <= x1; ++sx)
+						{
+							const __m128 texel = _mm_loadu_ps(&p_src[(static_cast<size_t>(sy) * srcWidth + sx) * 4]);
+
+							// (a, a, a, 1)
+							const __m128 alpha  = _mm_shuffle_ps(texel, texel, _MM_SHUFFLE(3, 3, 3, 3));
+							const __m128 weight = _mm_or_ps(_mm_andnot_ps(alpha_lane, alpha), _mm_and_ps(alpha_lane, one));
+
+							weighted = _mm_add_ps(weighted, _mm_mul_ps(texel, weight));
+							plain    = _mm_add_ps(plain, texel);
+							++count;
+						}
+					}
+
+					const __m128 inv_count = _mm_set1_ps(1.0f / count);
+					const __m128 sum_alpha = _mm_shuffle_ps(weighted, weighted, _MM_SHUFFLE(3, 3, 3, 3));
+					const __m128 has_alpha = _mm_cmpgt_ps(sum_alpha, zero);
+
+					__m128 color = _mm_or_ps(_mm_and_ps(has_alpha, _mm_div_ps(weighted, sum_alpha)), _mm_andnot_ps(has_alpha, _mm_mul_ps(plain, inv_count)));
+					color = _mm_or_ps(_mm_andnot_ps(alpha_lane, color), _mm_and_ps(alpha_lane, _mm_mul_ps(sum_alpha, inv_count)));
+
+					_mm_storeu_ps(&p_dst[(static_cast<size_t>(y) * dstWidth + x) * 4], color);
+				}
+			}
+		}
+#endif
+
+		/// <summary>
+		/// run func(begin, end) over the rows in tasks of the thread pool
+		/// </summary>
+		template <typename Func>
+		void ParallelRows(uint32_t rows, const Func& func)
+		{
+			const size_t task_count = (rows + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+			ThreadPool::Manager::Instance().ParallelFor(task_count, [&func, rows](size_t task)
+			{
+				const uint32_t begin = static_cast<uint32_t>(task) * ROWS_PER_TASK;
+				func(begin, std::min(begin + ROWS_PER_TASK, rows));
+			});
+		}
+
+		//--------------------------------------------------------
+		// premultiplied alpha
+		//--------------------------------------------------------
+		/// <summary>
+		/// c * a / 255 rounded to nearest without a division (exact for every pair of bytes)
+		/// </summary>
+		inline uint8_t MultiplyBytes(uint32_t c, uint32_t a)
+		{
+			const uint32_t t = c * a + 128;
+			return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+		}
+
+		/// <summary>
+		/// multiply the colors of a texel by its alpha, in linear light if the texel is sRGB
+		/// </summary>
+		inline void PremultiplyTexel(uint8_t* p_texel, bool isSrgb, const ColorTables& tables)
+		{
+			const uint32_t a = p_texel[3];
+			if (a == 255) return;
+
+			for (int c = 0; c < 3; ++c)
+			{
+				p_texel[c] = isSrgb
+					? tables.ToSrgb[static_cast<uint32_t>(tables.ToLinear[p_texel[c]] * (a / 255.0f) * (SRGB_TABLE_SIZE - 1) + 0.5f)]
+					: MultiplyBytes(p_texel[c], a);
+			}
+		}
+
+		/// <summary>
+		/// premultiply texels one at a time
+		/// </summary>
+		void PremultiplyScalar(uint8_t* pixels, size_t texelCount, bool isSrgb)
+		{
+			const ColorTables& tables = GetColorTables();
+			for (size_t i = 0; i < texelCount; ++i) PremultiplyTexel(&pixels[i * 4], isSrgb, tables);
+		}
+
+#ifdef TEXTURE_IMPORT_X86
+		/// <summary>
+		/// premultiply two texels widened to 16 bits, the alpha lane is multiplied by 255 so it is kept
+		/// </summary>
+		inline __m128i PremultiplyWords(__m128i texels)
+		{
+			const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+			const __m128i alpha_scale = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+			// (a, a, a, 255) per texel
+			__m128i factor = _mm_shufflehi_epi16(_mm_shufflelo_epi16(texels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			factor = _mm_or_si128(_mm_andnot_si128(alpha_lanes, factor), alpha_scale);
+
+			// c * a + 128 fits 16 bits unsigned, then the same rounding as MultiplyBytes
+			const __m128i t = _mm_add_epi16(_mm_mullo_epi16(texels, factor), _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+		}
+
+		/// <summary>
+		/// premultiply 4 texels per register, groups of opaque texels are skipped
+		/// the bytes are multiplied in 16-bit lanes, sRGB texels are only classified here and go through the tables
+		/// </summary>
+		void PremultiplySse2(uint8_t* pixels, size_t texelCount, bool isSrgb)
+		{
+			const ColorTables& tables = GetColorTables();
+			const __m128i alpha_bytes = _mm_set1_epi32(static_cast<int>(0xff000000));
+			const __m128i zero = _mm_setzero_si128();
+
+			size_t i = 0;
+			for (; i + 4 <= texelCount; i += 4)
+			{
+				__m128i* p_texels = reinterpret_cast<__m128i*>(&pixels[i * 4]);
+				const __m128i texels = _mm_loadu_si128(p_texels);
+				const __m128i alpha = _mm_and_si128(texels, alpha_bytes);
+
+				if (_mm_movemask_epi8(_mm_cmpeq_epi8(alpha, alpha_bytes)) == 0xffff)
+					continue;
+
+				if (!isSrgb)
+				{
+					const __m128i low  = PremultiplyWords(_mm_unpacklo_epi8(texels, zero));
+					const __m128i high = PremultiplyWords(_mm_unpackhi_epi8(texels, zero));
+					_mm_storeu_si128(p_texels, _mm_packus_epi16(low, high));
+				}
+				else if (_mm_movemask_epi8(_mm_cmpeq_epi8(alpha, zero)) == 0xffff)
+				{
+					// every texel is transparent, and its color becomes 0
+					_mm_storeu_si128(p_texels, zero);
+				}
+				else
+				{
+					for (size_t t = i; t < i + 4; ++t) PremultiplyTexel(&pixels[t * 4], true, tables);
+				}
+			}
+
+			for (; i < texelCount; ++i) PremultiplyTexel(&pixels[i * 4], isSrgb, tables);
+		}
+#endif
+
+		//--------------------------------------------------------
+		// block helpers
+		//--------------------------------------------------------
+		/// <summary>
+		/// texels of a block, the ones past the edge repeat the last row and column
+		/// </summary>
+		void LoadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t block[16][4])
+		{
+			for (uint32_t y = 0; y < BLOCK_SIZE; ++y)
+			{
+				const uint32_t sy = std::min(blockY * BLOCK_SIZE + y, height - 1);
+				for (uint32_t x = 0; x < BLOCK_SIZE; ++x)
+				{
+					const uint32_t sx = std::min(blockX * BLOCK_SIZE + x, width - 1);
+					std::memcpy(block[y * BLOCK_SIZE + x], &pixels[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+				}
+			}
+		}
+
+		/// <summary>
+		/// write the texels of a block which are inside the image
+		/// </summary>
+		void StoreBlock(const uint8_t block[16][4], uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t* pixels)
+		{
+			for (uint32_t y = 0; y < BLOCK_SIZE && blockY * BLOCK_SIZE + y < height; ++y)
+			{
+				for (uint32_t x = 0; x < BLOCK_SIZE && blockX * BLOCK_SIZE + x < width; ++x)
+				{
+					const size_t texel = static_cast<size_t>(blockY * BLOCK_SIZE + y) * width + blockX * BLOCK_SIZE + x;
+					std::memcpy(&pixels[texel * 4], block[y * BLOCK_SIZE + x], 4);
+				}
+			}
+		}
+
+		/// <summary>
+		/// write the lowest bits of a value, from the lowest bit of the block
+		/// </summary>
+		void WriteBits(uint8_t* p_block, uint32_t* p_position, uint32_t value, uint32_t count)
+		{
+			for (uint32_t i = 0; i < count; ++i, ++*p_position)
+			{
+				if ((value >> i) & 1) p_block[*p_position >> 3] |= static_cast<uint8_t>(1u << (*p_position & 7));
+			}
+		}
+
+		/// <summary>
+		/// read bits, from the lowest bit of the block
+		/// </summary>
+		uint32_t ReadBits(const uint8_t* p_block, uint32_t* p_position, uint32_t count)
+		{
+			uint32_t value = 0;
+			for (uint32_t i = 0; i < count; ++i, ++*p_position)
+			{
+				value |= ((p_block[*p_position >> 3] >> (*p_position & 7)) & 1u) << i;
+			}
+
+			return value;
+		}
+
+		/// <summary>
+		/// principal axis of the texels, by power iteration on their covariance
+		/// </summary>
+		void ComputeAxis(const float texels[16][4], int channels, float mean[4], float axis[4])
+		{
+			for (int c = 0; c < 4; ++c) mean[c] = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < channels; ++c) mean[c] += texels[i][c] / 16.0f;
+			}
+
+			float covariance[4][4] = {};
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int a = 0; a < channels; ++a)
+				{
+					for (int b = 0; b < channels; ++b) covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+				}
+			}
+
+			// the column of the widest channel is never orthogonal to the principal axis
+			int widest = 0;
+			for (int c = 1; c < channels; ++c)
+			{
+				if (covariance[c][c] > covariance[widest][widest]) widest = c;
+			}
+			for (int c = 0; c < 4; ++c) axis[c] = (c < channels) ? covariance[c][widest] : 0.0f;
+
+			for (int iteration = 0; iteration < AXIS_ITERATIONS; ++iteration)
+			{
+				float next[4] = {};
+				float largest = 0.0f;
+				for (int a = 0; a < channels; ++a)
+				{
+					for (int b = 0; b < channels; ++b) next[a] += covariance[a][b] * axis[b];
+					largest = std::max(largest, std::fabs(next[a]));
+				}
+				if (largest == 0.0f)
+					break;
+
+				for (int c = 0; c < channels; ++c) axis[c] = next[c] / largest;
+			}
+
+			float length = 0.0f;
+			for (int c = 0; c < channels; ++c) length += axis[c] * axis[c];
+			length = std::sqrt(length);
+
+			// a flat block, any axis will do
+			for (int c = 0; c < channels; ++c) axis[c] = (length > 0.0f) ? axis[c] / length : 1.0f;
+		}
+
+		/// <summary>
+		/// endpoints at the extremes of the texels along the principal axis
+		/// </summary>
+		void ComputeEndpoints(const float texels[16][4], int channels, float e0[4], float e1[4])
+		{
+			float mean[4], axis[4];
+			ComputeAxis(texels, channels, mean, axis);
+
+			float low = 0.0f, high = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				float t = 0.0f;
+				for (int c = 0; c < channels; ++c) t += (texels[i][c] - mean[c]) * axis[c];
+				low  = std::min(low, t);
+				high = std::max(high, t);
+			}
+
+			for (int c = 0; c < 4; ++c)
+			{
+				e0[c] = (c < channels) ? std::min(std::max(mean[c] + axis[c] * low,  0.0f), 255.0f) : 255.0f;
+				e1[c] = (c < channels) ? std::min(std::max(mean[c] + axis[c] * high, 0.0f), 255.0f) : 255.0f;
+			}
+		}
+
+		/// <summary>
+		/// least squares endpoints for the positions of the texels between them (0 is e0, 1 is e1)
+		/// returns false if every texel is at the same position
+		/// </summary>
+		bool FitEndpoints(const float texels[16][4], int channels, const float positions[16], float e0[4], float e1[4])
+		{
+			float a = 0.0f, b = 0.0f, c = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				const float t = positions[i];
+				a += (1.0f - t) * (1.0f - t);
+				b += (1.0f - t) * t;
+				c += t * t;
+			}
+
+			const float determinant = a * c - b * b;
+			if (std::fabs(determinant) < 1e-6f)
+				return false;
+
+			for (int ch = 0; ch < channels; ++ch)
+			{
+				float x0 = 0.0f, x1 = 0.0f;
+				for (int i = 0; i < 16; ++i)
+				{
+					x0 += (1.0f - positions[i]) * texels[i][ch];
+					x1 += positions[i] * texels[i][ch];
+				}
+				e0[ch] = std::min(std::max((c * x0 - b * x1) / determinant, 0.0f), 255.0f);
+				e1[ch] = std::min(std::max((a * x1 - b * x0) / determinant, 0.0f), 255.0f);
+			}
+
+			return true;
+		}
+
+		//--------------------------------------------------------
+		// BC1 color block
+		//--------------------------------------------------------
+		/// <summary>
+		/// quantize a color to 5:6:5
+		/// </summary>
+		uint16_t To565(const float color[4])
+		{
+			const uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+			const uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+			const uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>((std::min(r, 31u) << 11) | (std::min(g, 63u) << 5) | std::min(b, 31u));
+		}
+
+		/// <summary>
+		/// expand a 5:6:5 color to 8 bits per channel
+		/// </summary>
+		void From565(uint16_t value, int color[3])
+		{
+			const int r = value >> 11, g = (value >> 5) & 63, b = value & 31;
+			color[0] = (r << 3) | (r >> 2);
+			color[1] = (g << 2) | (g >> 4);
+			color[2] = (b << 3) | (b >> 2);
+		}
+
+		/// <summary>
+		/// the 4 colors of a block (the four color mode, whatever the order of the endpoints)
+		/// </summary>
+		void GetColorPalette(uint16_t c0, uint16_t c1, int palette[4][3])
+		{
+			From565(c0, palette[0]);
+			From565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+			}
+		}
+
+		/// <summary>
+		/// nearest color of the palette for every texel, returns the squared error
+		/// </summary>
+		float FitColorIndices(const float texels[16][4], uint16_t c0, uint16_t c1, uint8_t indices[16])
+		{
+			int palette[4][3];
+			GetColorPalette(c0, c1, palette);
+
+			float total = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				float best = std::numeric_limits<float>::max();
+				for (uint8_t p = 0; p < 4; ++p)
+				{
+					float error = 0.0f;
+					for (int c = 0; c < 3; ++c) error += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+					if (error < best)
+					{
+						best = error;
+						indices[i] = p;
+					}
+				}
+				total += best;
+			}
+
+			return total;
+		}
+
+		/// <summary>
+		/// encode the colors of a block in the four color mode (BC1 of an opaque block, and the color half of BC3)
+		/// </summary>
+		void EncodeColorBlock(const uint8_t block[16][4], uint8_t* p_out)
+		{
+			// position of each index between the endpoints
+			static const float s_positions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+			float texels[16][4];
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 4; ++c) texels[i][c] = block[i][c];
+			}
+
+			float e0[4], e1[4];
+			ComputeEndpoints(texels, 3, e0, e1);
+
+			uint16_t c0 = To565(e1), c1 = To565(e0);
+			uint8_t indices[16];
+			float error = FitColorIndices(texels, c0, c1, indices);
+
+			for (int pass = 0; pass < REFINE_PASSES && error > 0.0f; ++pass)
+			{
+				float positions[16];
+				for (int i = 0; i < 16; ++i) positions[i] = s_positions[indices[i]];
+
+				float f0[4], f1[4];
+				if (!FitEndpoints(texels, 3, positions, f0, f1))
+					break;
+
+				const uint16_t r0 = To565(f0), r1 = To565(f1);
+				uint8_t refined[16];
+				const float refined_error = FitColorIndices(texels, r0, r1, refined);
+				if (refined_error >= error)
+					break;
+
+				c0 = r0;
+				c1 = r1;
+				error = refined_error;
+				std::memcpy(indices, refined, sizeof(indices));
+			}
+
+			// the four color mode needs c0 > c1, swapping the endpoints swaps 0 with 1 and 2 with 3
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+				for (uint8_t& index : indices) index ^= 1;
+			}
+			else if (c0 == c1)
+			{
+				for (uint8_t& index : indices) index = 0;
+			}
+
+			uint32_t bits = 0;
+			for (int i = 0; i < 16; ++i) bits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+
+			p_out[0] = static_cast<uint8_t>(c0);
+			p_out[1] = static_cast<uint8_t>(c0 >> 8);
+			p_out[2] = static_cast<uint8_t>(c1);
+			p_out[3] = static_cast<uint8_t>(c1 >> 8);
+			std::memcpy(&p_out[4], &bits, 4);
+		}
+
+		/// <summary>
+		/// decode the colors of a block, the three color mode with transparent black only where allowed (BC1)
+		/// </summary>
+		void DecodeColorBlock(const uint8_t* p_in, bool allowThreeColors, uint8_t block[16][4])
+		{
+			const uint16_t c0 = static_cast<uint16_t>(p_in[0] | (p_in[1] << 8));
+			const uint16_t c1 = static_cast<uint16_t>(p_in[2] | (p_in[3] << 8));
+			uint32_t bits;
+			std::memcpy(&bits, &p_in[4], 4);
+
+			int palette[4][4];
+			int colors[4][3];
+			GetColorPalette(c0, c1, colors);
+			const bool is_three_colors = allowThreeColors && c0 <= c1;
+			for (int p = 0; p < 4; ++p)
+			{
+				for (int c = 0; c < 3; ++c) palette[p][c] = colors[p][c];
+				palette[p][3] = 255;
+			}
+			if (is_three_colors)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+					palette[3][c] = 0;
+				}
+				palette[3][3] = 0;
+			}
+
+			for (int i = 0; i < 16; ++i)
+			{
+				const int index = (bits >> (i * 2)) & 3;
+				for (int c = 0; c < 4; ++c) block[i][c] = static_cast<uint8_t>(palette[index][c]);
+			}
+		}
+
+		//--------------------------------------------------------
+		// BC4 channel block
+		//--------------------------------------------------------
+		/// <summary>
+		/// the 8 values of a channel block
+		/// </summary>
+		void GetChannelPalette(uint8_t e0, uint8_t e1, int palette[8])
+		{
+			palette[0] = e0;
+			palette[1] = e1;
+			if (e0 > e1)
+			{
+				for (int i = 2; i < 8; ++i) palette[i] = ((8 - i) * e0 + (i - 1) * e1 + 3) / 7;
+			}
+			else
+			{
+				for (int i = 2; i < 6; ++i) palette[i] = ((6 - i) * e0 + (i - 1) * e1 + 2) / 5;
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+		}
+
+		/// <summary>
+		/// nearest value of the palette for every texel, returns the squared error
+		/// </summary>
+		uint32_t FitChannelIndices(const uint8_t values[16], uint8_t e0, uint8_t e1, uint64_t* p_bits)
+		{
+			int palette[8];
+			GetChannelPalette(e0, e1, palette);
+
+			uint32_t total = 0;
+			*p_bits = 0;
+			for (int i = 0; i < 16; ++i)
+			{
+				uint32_t best = UINT32_MAX;
+				uint64_t best_index = 0;
+				for (int p = 0; p < 8; ++p)
+				{
+					const int difference = values[i] - palette[p];
+					const uint32_t error = static_cast<uint32_t>(difference * difference);
+					if (error < best)
+					{
+						best = error;
+						best_index = static_cast<uint64_t>(p);
+					}
+				}
+				*p_bits |= best_index << (i * 3);
+				total += best;
+			}
+
+			return total;
+		}
+
+		/// <summary>
+		/// encode one channel of a block (BC4, and the alpha half of BC3)
+		/// the eight value mode spans the values, the six value mode is tried when the block holds 0 or 255
+		/// </summary>
+		void EncodeChannelBlock(const uint8_t values[16], uint8_t* p_out)
+		{
+			uint8_t low = 255, high = 0;
+			uint8_t inner_low = 255, inner_high = 0;
+			bool has_extremes = false;
+			for (int i = 0; i < 16; ++i)
+			{
+				low  = std::min(low, values[i]);
+				high = std::max(high, values[i]);
+				if (values[i] == 0 || values[i] == 255)
+				{
+					has_extremes = true;
+					continue;
+				}
+				inner_low  = std::min(inner_low, values[i]);
+				inner_high = std::max(inner_high, values[i]);
+			}
+
+			uint8_t e0 = high, e1 = low;
+			uint64_t bits = 0;
+			uint32_t error = FitChannelIndices(values, e0, e1, &bits);
+
+			if (has_extremes && error > 0)
+			{
+				// only 0 and 255 in the block
+				if (inner_low > inner_high) inner_low = inner_high = 0;
+
+				uint64_t six_bits = 0;
+				const uint32_t six_error = FitChannelIndices(values, inner_low, inner_high, &six_bits);
+				if (six_error < error)
+				{
+					e0 = inner_low;
+					e1 = inner_high;
+					bits = six_bits;
+				}
+			}
+
+			p_out[0] = e0;
+			p_out[1] = e1;
+			for (int i = 0; i < 6; ++i) p_out[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+		}
+
+		/// <summary>
+		/// decode one channel of a block
+		/// </summary>
+		void DecodeChannelBlock(const uint8_t* p_in, uint8_t values[16])
+		{
+			int palette[8];
+			GetChannelPalette(p_in[0], p_in[1], palette);
+
+			uint64_t bits = 0;
+			for (int i = 0; i < 6; ++i) bits |= static_cast<uint64_t>(p_in[2 + i]) << (i * 8);
+
+			for (int i = 0; i < 16; ++i) values[i] = static_cast<uint8_t>(palette[(bits >> (i * 3)) & 7]);
+		}
+
+		//--------------------------------------------------------
+		// BC7 block
+		//--------------------------------------------------------
+		/// <summary>
+		/// quantize an endpoint to 7 bits per channel and a shared p-bit, with the p-bit of the lower error
+		/// </summary>
+		void QuantizeBc7Endpoint(const float endpoint[4], uint8_t quantized[4], uint8_t* p_pbit)
+		{
+			float best = std::numeric_limits<float>::max();
+			for (uint8_t pbit = 0; pbit < 2; ++pbit)
+			{
+				uint8_t candidate[4];
+				float error = 0.0f;
+				for (int c = 0; c < 4; ++c)
+				{
+					const int q = static_cast<int>((endpoint[c] - pbit) / 2.0f + 0.5f);
+					candidate[c] = static_cast<uint8_t>(std::min(std::max(q, 0), 127));
+
+					const float difference = static_cast<float>((candidate[c] << 1) | pbit) - endpoint[c];
+					error += difference * difference;
+				}
+
+				if (error < best)
+				{
+					best = error;
+					std::memcpy(quantized, candidate, 4);
+					*p_pbit = pbit;
+				}
+			}
+		}
+
+		/// <summary>
+		/// the 16 colors between two 8-bit endpoints
+		/// </summary>
+		void GetBc7Palette(const int e0[4], const int e1[4], int palette[16][4])
+		{
+			for (int p = 0; p < 16; ++p)
+			{
+				for (int c = 0; c < 4; ++c) palette[p][c] = ((64 - BC7_WEIGHTS[p]) * e0[c] + BC7_WEIGHTS[p] * e1[c] + 32) >> 6;
+			}
+		}
+
+		/// <summary>
+		/// expand 7-bit endpoints with their p-bit
+		/// </summary>
+		void ExpandBc7Endpoint(const uint8_t quantized[4], uint8_t pbit, int endpoint[4])
+		{
+			for (int c = 0; c < 4; ++c) endpoint[c] = (quantized[c] << 1) | pbit;
+		}
+
+		/// <summary>
+		/// nearest color of the palette for every texel, returns the squared error
+		/// </summary>
+		float FitBc7Indices(const float texels[16][4], const int e0[4], const int e1[4], uint8_t indices[16])
+		{
+			int palette[16][4];
+			GetBc7Palette(e0, e1, palette);
+
+			float total = 0.0f;
+			for (int i = 0; i < 16; ++i)
+			{
+				float best = std::numeric_limits<float>::max();
+				for (uint8_t p = 0; p < 16; ++p)
+				{
+					float error = 0.0f;
+					for (int c = 0; c < 4; ++c) error += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+					if (error < best)
+					{
+						best = error;
+						indices[i] = p;
+					}
+				}
+				total += best;
+			}
+
+			return total;
+		}
+
+		/// <summary>
+		/// encode a block in mode 6 of BC7
+		/// </summary>
+		void EncodeBc7Block(const uint8_t block[16][4], uint8_t* p_out)
+		{
+			float texels[16][4];
+			for (int i = 0; i < 16; ++i)
+			{
+				for (int c = 0; c < 4; ++c) texels[i][c] = block[i][c];
+			}
+
+			float f0[4], f1[4];
+			ComputeEndpoints(texels, 4, f0, f1);
+
+			uint8_t q0[4], q1[4], p0 = 0, p1 = 0;
+			QuantizeBc7Endpoint(f0, q0, &p0);
+			QuantizeBc7Endpoint(f1, q1, &p1);
+
+			int e0[4], e1[4];
+			ExpandBc7Endpoint(q0, p0, e0);
+			ExpandBc7Endpoint(q1, p1, e1);
+
+			uint8_t indices[16];
+			float error = FitBc7Indices(texels, e0, e1, indices);
+
+			for (int pass = 0; pass < REFINE_PASSES && error > 0.0f; ++pass)
+			{
+				float positions[16];
+				for (int i = 0; i < 16; ++i) positions[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+
+				if (!FitEndpoints(texels, 4, positions, f0, f1))
+					break;
+
+				uint8_t r0[4], r1[4], s0 = 0, s1 = 0;
+				QuantizeBc7Endpoint(f0, r0, &s0);
+				QuantizeBc7Endpoint(f1, r1, &s1);
+
+				int g0[4], g1[4];
+				ExpandBc7Endpoint(r0, s0, g0);
+				ExpandBc7Endpoint(r1, s1, g1);
+
+				uint8_t refined[16];
+				const float refined_error = FitBc7Indices(texels, g0, g1, refined);
+				if (refined_error >= error)
+					break;
+
+				std::memcpy(q0, r0, 4);
+				std::memcpy(q1, r1, 4);
+				p0 = s0;
+				p1 = s1;
+				error = refined_error;
+				std::memcpy(indices, refined, sizeof(indices));
+			}
+
+			// the index of the first texel is stored without its highest bit, which must be 0
+			if (indices[0] >= 8)
+			{
+				for (int c = 0; c < 4; ++c) std::swap(q0[c], q1[c]);
+				std::swap(p0, p1);
+				for (uint8_t& index : indices) index = static_cast<uint8_t>(15 - index);
+			}
+
+			std::memset(p_out, 0, 16);
+			uint32_t position = 0;
+			WriteBits(p_out, &position, 1u << BC7_MODE, BC7_MODE + 1);
+			for (int c = 0; c < 4; ++c)
+			{
+				WriteBits(p_out, &position, q0[c], 7);
+				WriteBits(p_out, &position, q1[c], 7);
+			}
+			WriteBits(p_out, &position, p0, 1);
+			WriteBits(p_out, &position, p1, 1);
+			for (int i = 0; i < 16; ++i) WriteBits(p_out, &position, indices[i], (i == 0) ? 3 : 4);
+		}
+
+		/// <summary>
+		/// decode a block of BC7, returns false if it is not in mode 6
+		/// </summary>
+		bool DecodeBc7Block(const uint8_t* p_in, uint8_t block[16][4])
+		{
+			if ((p_in[0] & 0x7f) != (1u << BC7_MODE))
+			{
+				std::memset(block, 0, 16 * 4);
+				return false;
+			}
+
+			uint32_t position = BC7_MODE + 1;
+			uint8_t q0[4], q1[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				q0[c] = static_cast<uint8_t>(ReadBits(p_in, &position, 7));
+				q1[c] = static_cast<uint8_t>(ReadBits(p_in, &position, 7));
+			}
+			const uint8_t p0 = static_cast<uint8_t>(ReadBits(p_in, &position, 1));
+			const uint8_t p1 = static_cast<uint8_t>(ReadBits(p_in, &position, 1));
+
+			int e0[4], e1[4];
+			ExpandBc7Endpoint(q0, p0, e0);
+			ExpandBc7Endpoint(q1, p1, e1);
+
+			int palette[16][4];
+			GetBc7Palette(e0, e1, palette);
+			for (int i = 0; i < 16; ++i)
+			{
+				const uint32_t index = ReadBits(p_in, &position, (i == 0) ? 3 : 4);
+				for (int c = 0; c < 4; ++c) block[i][c] = static_cast<uint8_t>(palette[index][c]);
+			}
+
+			return true;
+		}
+	}
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	/// <summary>
+	/// get the default settings of an import
+	/// </summary>
+	Settings GetDefaultSettings()
+	{
+		Settings settings = {};
+		settings.Type            = Content::Auto;
+		settings.IsCompressed    = true;
+		settings.IsHighQuality   = false;
+		settings.GenerateMips    = true;
+		settings.IsSrgb          = true;
+		settings.IsPremultiplied = false;
+
+		return settings;
+	}
+
+	/// <summary>
+	/// classify an image by its alpha
+	/// </summary>
+	Content Classify(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height)
+	{
+		const size_t count = static_cast<size_t>(width) * height;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (pixels[i * 4 + 3] != 255)
+				return Content::Alpha;
+		}
+
+		return Content::Opaque;
+	}
+
+	/// <summary>
+	/// choose the format of an asset
+	/// </summary>
+	PixelFormat ChooseFormat(_In_ Content type, _In_ const Settings& settings, _In_ uint32_t width, _In_ uint32_t height)
+	{
+		if (!settings.IsCompressed || width % BLOCK_SIZE != 0 || height % BLOCK_SIZE != 0)
+			return PixelFormat::Rgba8;
+
+		switch (type)
+		{
+		case Content::Mask:   return PixelFormat::Bc4;
+		case Content::Opaque: return settings.IsHighQuality ? PixelFormat::Bc7 : PixelFormat::Bc1;
+		default:              return settings.IsHighQuality ? PixelFormat::Bc7 : PixelFormat::Bc3;
+		}
+	}
+
+	/// <summary>
+	/// generate mip levels with the best instruction set
+	/// </summary>
+	void GenerateMips(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t mipLevels, _In_ bool isSrgb,
+		_Out_ std::vector<std::vector<uint8_t>>* p_mips)
+	{
+		GenerateMips(pixels, width, height, mipLevels, isSrgb, p_mips, QuadKernel::GetBestInstructionSet());
+	}
+
+	/// <summary>
+	/// generate mip levels with the specified instruction set (avx2 uses the sse2 filter)
+	/// </summary>
+	void GenerateMips(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t mipLevels, _In_ bool isSrgb,
+		_Out_ std::vector<std::vector<uint8_t>>* p_mips, _In_ QuadKernel::InstructionSet set)
+	{
+		mipLevels = std::min(std::max(mipLevels, 1u), TextureContainer::GetMipCount(width, height));
+
+		p_mips->assign(mipLevels, std::vector<uint8_t>());
+		(*p_mips)[0].assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		if (mipLevels == 1)
+			return;
+
+		// every level is filtered from the previous one in linear light, without rounding in between
+		std::vector<float> source(static_cast<size_t>(width) * height * 4);
+		std::vector<float> destination;
+		ParallelRows(height, [&](uint32_t begin, uint32_t end)
+		{
+			const size_t first = static_cast<size_t>(begin) * width;
+			ToLinear(&pixels[first * 4], static_cast<size_t>(end - begin) * width, isSrgb, &source[first * 4]);
+		});
+
+		uint32_t src_width = width, src_height = height;
+		for (uint32_t mip = 1; mip < mipLevels; ++mip)
+		{
+			const uint32_t dst_width  = std::max(src_width  >> 1, 1u);
+			const uint32_t dst_height = std::max(src_height >> 1, 1u);
+			destination.resize(static_cast<size_t>(dst_width) * dst_height * 4);
+
+			std::vector<uint8_t>& level = (*p_mips)[mip];
+			level.resize(destination.size());
+
+			ParallelRows(dst_height, [&](uint32_t begin, uint32_t end)
+			{
+#ifdef TEXTURE_IMPORT_X86
+				if (set != QuadKernel::InstructionSet::Scalar)
+					FilterRowsSse2(source.data(), src_width, src_height, destination.data(), dst_width, dst_height, begin, end);
+				else
+#endif
+					FilterRowsScalar(source.data(), src_width, src_height, destination.data(), dst_width, dst_height, begin, end);
+
+				const size_t first = static_cast<size_t>(begin) * dst_width;
+				FromLinear(&destination[first * 4], static_cast<size_t>(end - begin) * dst_width, isSrgb, &level[first * 4]);
+			});
+
+			source.swap(destination);
+			src_width  = dst_width;
+			src_height = dst_height;
+		}
+
+#ifndef TEXTURE_IMPORT_X86
+		(void)set;
+#endif
+	}
+
+	/// <summary>
+	/// premultiply texels with the best instruction set
+	/// </summary>
+	void Premultiply(_Inout_ uint8_t* pixels, _In_ size_t texelCount, _In_ bool isSrgb)
+	{
+		Premultiply(pixels, texelCount, isSrgb, QuadKernel::GetBestInstructionSet());
+	}
+
+	/// <summary>
+	/// premultiply texels with the specified instruction set (avx2 uses the sse2 kernel), in tasks of the thread pool
+	/// </summary>
+	void Premultiply(_Inout_ uint8_t* pixels, _In_ size_t texelCount, _In_ bool isSrgb, _In_ QuadKernel::InstructionSet set)
+	{
+		const size_t task_count = (texelCount + PREMULTIPLY_TEXELS_PER_TASK - 1) / PREMULTIPLY_TEXELS_PER_TASK;
+		ThreadPool::Manager::Instance().ParallelFor(task_count, [&](size_t task)
+		{
+			const size_t first = task * PREMULTIPLY_TEXELS_PER_TASK;
+			const size_t count = std::min(PREMULTIPLY_TEXELS_PER_TASK, texelCount - first);
+
+#ifdef TEXTURE_IMPORT_X86
+			if (set != QuadKernel::InstructionSet::Scalar)
+				PremultiplySse2(&pixels[first * 4], count, isSrgb);
+			else
+#endif
+				PremultiplyScalar(&pixels[first * 4], count, isSrgb);
+		});
+
+#ifndef TEXTURE_IMPORT_X86
+		(void)set;
+#endif
+	}
+
+	/// <summary>
+	/// encode an RGBA8 image into blocks
+	/// </summary>
+	int EncodeBlocks(_In_ PixelFormat format, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _Out_ uint8_t* p_blocks)
+	{
+		const uint32_t block_bytes = TextureContainer::GetRowPitch(format, BLOCK_SIZE);
+		if (format == PixelFormat::Rgba8 || block_bytes == 0 || width == 0 || height == 0)
+			return -2;
+
+		const uint32_t blocks_x = TextureContainer::GetRowPitch(format, width) / block_bytes;
+		const uint32_t blocks_y = TextureContainer::GetRowCount(format, height);
+
+		ParallelRows(blocks_y, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t by = begin; by < end; ++by)
+			{
+				for (uint32_t bx = 0; bx < blocks_x; ++bx)
+				{
+					uint8_t block[16][4];
+					LoadBlock(pixels, width, height, bx, by, block);
+
+					uint8_t channel[16];
+					uint8_t* p_out = &p_blocks[(static_cast<size_t>(by) * blocks_x + bx) * block_bytes];
+					switch (format)
+					{
+					case PixelFormat::Bc1:
+						EncodeColorBlock(block, p_out);
+						break;
+
+					case PixelFormat::Bc3:
+						for (int i = 0; i < 16; ++i) channel[i] = block[i][3];
+						EncodeChannelBlock(channel, p_out);
+						EncodeColorBlock(block, p_out + 8);
+						break;
+
+					case PixelFormat::Bc4:
+						for (int i = 0; i < 16; ++i) channel[i] = block[i][0];
+						EncodeChannelBlock(channel, p_out);
+						break;
+
+					default:
+						EncodeBc7Block(block, p_out);
+						break;
+					}
+				}
+			}
+		});
+
+		return 0;
+	}
+
+	/// <summary>
+	/// decode blocks into RGBA8
+	/// </summary>
+	int DecodeBlocks(_In_ PixelFormat format, _In_ const uint8_t* p_blocks, _In_ uint32_t width, _In_ uint32_t height, _Out_ uint8_t* pixels)
+	{
+		const uint32_t block_bytes = TextureContainer::GetRowPitch(format, BLOCK_SIZE);
+		if (format == PixelFormat::Rgba8 || block_bytes == 0 || width == 0 || height == 0)
+			return -2;
+
+		const uint32_t blocks_x = TextureContainer::GetRowPitch(format, width) / block_bytes;
+		const uint32_t blocks_y = TextureContainer::GetRowCount(format, height);
+
+		bool is_supported = true;
+		for (uint32_t by = 0; by < blocks_y; ++by)
+		{
+			for (uint32_t bx = 0; bx < blocks_x; ++bx)
+			{
+				uint8_t block[16][4];
+				uint8_t channel[16];
+				const uint8_t* p_in = &p_blocks[(static_cast<size_t>(by) * blocks_x + bx) * block_bytes];
+				switch (format)
+				{
+				case PixelFormat::Bc1:
+					DecodeColorBlock(p_in, true, block);
+					break;
+
+				case PixelFormat::Bc3:
+					DecodeColorBlock(p_in + 8, false, block);
+					DecodeChannelBlock(p_in, channel);
+					for (int i = 0; i < 16; ++i) block[i][3] = channel[i];
+					break;
+
+				case PixelFormat::Bc4:
+					DecodeChannelBlock(p_in, channel);
+					for (int i = 0; i < 16; ++i)
+					{
+						block[i][0] = channel[i];
+						block[i][1] = 0;
+						block[i][2] = 0;
+						block[i][3] = 255;
+					}
+					break;
+
+				default:
+					is_supported = DecodeBc7Block(p_in, block) && is_supported;
+					break;
+				}
+
+				StoreBlock(block, width, height, bx, by, pixels);
+			}
+		}
+
+		return is_supported ? 0 : -2;
+	}
+
+	/// <summary>
+	/// generate the mip chain and encode every level
+	/// </summary>
+	int Import(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ const Settings& settings, _Out_ Image* p_image)
+	{
+		if (!pixels || !p_image || width == 0 || height == 0)
+			return -2;
+
+		const Content type = (settings.Type == Content::Auto) ? Classify(pixels, width, height) : settings.Type;
+		const PixelFormat format = ChooseFormat(type, settings, width, height);
+		const uint32_t mip_levels = settings.GenerateMips
+			? std::min(TextureContainer::GetMipCount(width, height), TextureContainer::MAX_MIP_LEVELS) : 1;
+
+		// a mask is data, not a color
+		std::vector<std::vector<uint8_t>> levels;
+		GenerateMips(pixels, width, height, mip_levels, settings.IsSrgb && type != Content::Mask, &levels);
+
+		// the levels are averaged weighted by alpha, so multiplying them afterwards is filtering the premultiplied texels
+		// a container is sampled through a UNORM view, so the bytes are multiplied as the blending sees them
+		const bool is_premultiplied = settings.IsPremultiplied && type != Content::Mask;
+		if (is_premultiplied)
+		{
+			for (uint32_t mip = 0; mip < mip_levels; ++mip)
+			{
+				Premultiply(levels[mip].data(), static_cast<size_t>(std::max(width >> mip, 1u)) * std::max(height >> mip, 1u), false);
+			}
+		}
+
+		p_image->Format          = format;
+		p_image->Type            = type;
+		p_image->Width           = width;
+		p_image->Height          = height;
+		p_image->IsPremultiplied = is_premultiplied;
+		if (format == PixelFormat::Rgba8)
+		{
+			p_image->Mips = std::move(levels);
+			return 0;
+		}
+
+		p_image->Mips.assign(mip_levels, std::vector<uint8_t>());
+		for (uint32_t mip = 0; mip < mip_levels; ++mip)
+		{
+			const uint32_t mip_width  = std::max(width  >> mip, 1u);
+			const uint32_t mip_height = std::max(height >> mip, 1u);
+
+			p_image->Mips[mip].resize(static_cast<size_t>(TextureContainer::GetRowPitch(format, mip_width)) * TextureContainer::GetRowCount(format, mip_height));
+			EncodeBlocks(format, levels[mip].data(), mip_width, mip_height, p_image->Mips[mip].data());
+		}
+
+		return 0;
+	}
+
+	/// <summary>
+	/// import and write a container
+	/// </summary>
+	int Cook(_In_ const std::string& path, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ const Settings& settings,
+		_Out_opt_ Image* p_image)
+	{
+		Image image;
+		if (Import(pixels, width, height, settings, &image) != 0)
+			return -2;
+
+		std::vector<const uint8_t*> p_mips;
+		for (const std::vector<uint8_t>& mip : image.Mips) p_mips.push_back(mip.data());
+
+		const int result = TextureContainer::Write(path, image.Format, width, height, static_cast<uint32_t>(p_mips.size()), p_mips.data(),
+			image.IsPremultiplied ? TextureContainer::FLAG_PREMULTIPLIED_ALPHA : 0);
+
+		if (p_image) *p_image = std::move(image);
+
+		return result;
+	}
+
+	/// <summary>
+	/// peak signal to noise ratio of two RGBA8 images
+	/// </summary>
+	double ComputePsnr(_In_ const uint8_t* p_reference, _In_ const uint8_t* p_pixels, _In_ size_t texelCount, _In_ uint32_t channelMask)
+	{
+		uint64_t squared = 0;
+		uint64_t samples = 0;
+		for (size_t i = 0; i < texelCount; ++i)
+		{
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				if (!(channelMask & (1u << c))) continue;
+
+				const int difference = p_reference[i * 4 + c] - p_pixels[i * 4 + c];
+				squared += static_cast<uint64_t>(difference * difference);
+				++samples;
+			}
+		}
+
+		if (squared == 0 || samples == 0)
+			return std::numeric_limits<double>::infinity();
+
+		const double mse = static_cast<double>(squared) / samples;
+		return 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+
+	/// <summary>
+	/// get the name of a format
+	/// </summary>
+	const char* GetFormatName(_In_ PixelFormat format)
+	{
+		switch (format)
+		{
+		case PixelFormat::Rgba8: return "rgba8";
+		case PixelFormat::Bc1:   return "bc1";
+		case PixelFormat::Bc3:   return "bc3";
+		case PixelFormat::Bc4:   return "bc4";
+		case PixelFormat::Bc7:   return "bc7";
+		default:                 return "unknown";
+		}
+	}
+
+	/// <summary>
+	/// get the name of a content type
+	/// </summary>
+	const char* GetContentName(_In_ Content type)
+	{
+		switch (type)
+		{
+		case Content::Opaque: return "opaque";
+		case Content::Alpha:  return "alpha";
+		case Content::Mask:   return "mask";
+		default:              return "auto";
+		}
+	}
+}
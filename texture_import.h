@@ -0,0 +1,119 @@
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "portable_sal.h"
+#include "quad_kernel.h"
+#include "texture_container.h"
+
+namespace TextureImport
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// texels of a block of the compressed formats
+	constexpr uint32_t BLOCK_SIZE = 4;
+
+	// rows of blocks (or of texels of a mip level) per task of the thread pool
+	constexpr uint32_t ROWS_PER_TASK = 8;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// what an asset holds, it chooses the compressed format
+	/// </summary>
+	enum class Content : uint32_t
+	{
+		Auto = 0,                // opaque or alpha, classified from the texels
+		Opaque,                  // BC1, or BC7 in high quality
+		Alpha,                   // BC3, or BC7 in high quality
+		Mask,                    // BC4 of the red channel, filtered linearly
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// how an image is imported
+	/// </summary>
+	struct Settings
+	{
+		Content Type;
+		bool IsCompressed;       // false keeps RGBA8
+		bool IsHighQuality;      // BC7 instead of BC1 and BC3
+		bool GenerateMips;
+		bool IsSrgb;             // the colors are averaged in linear light (masks are always linear)
+		bool IsPremultiplied;    // the colors of every level are multiplied by alpha, after filtering (masks are not)
+	};
+
+	/// <summary>
+	/// imported texture, ready to be written into a container
+	/// </summary>
+	struct Image
+	{
+		TextureContainer::PixelFormat Format;
+		Content Type;            // never Auto
+		uint32_t Width;
+		uint32_t Height;
+		bool IsPremultiplied;
+
+		// one per mip level, tightly packed with TextureContainer::GetRowPitch
+		std::vector<std::vector<uint8_t>> Mips;
+	};
+
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// compressed, with the full mip chain, in sRGB
+	Settings GetDefaultSettings();
+
+	// opaque if every alpha is 255, otherwise alpha (a mask is never guessed, the shaders read it differently)
+	Content Classify(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height);
+
+	// format of an asset, RGBA8 if it is not compressed or the base level is not made of whole blocks (which D3D11 requires)
+	TextureContainer::PixelFormat ChooseFormat(_In_ Content type, _In_ const Settings& settings, _In_ uint32_t width, _In_ uint32_t height);
+
+	// generate mip levels of an RGBA8 image with a box filter, the base level is copied into the first one
+	// the colors are weighted by their alpha, so transparent texels do not bleed into the smaller levels
+	// the levels are filtered from each other in floating point, and the rows of a level in parallel
+	void GenerateMips(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t mipLevels, _In_ bool isSrgb,
+		_Out_ std::vector<std::vector<uint8_t>>* p_mips);
+	void GenerateMips(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ uint32_t mipLevels, _In_ bool isSrgb,
+		_Out_ std::vector<std::vector<uint8_t>>* p_mips, _In_ QuadKernel::InstructionSet set);
+
+	// multiply the colors of RGBA8 texels by their alpha in place, so they blend with ONE, INV_SRC_ALPHA
+	// isSrgb multiplies in linear light for views which decode sRGB, otherwise the bytes are multiplied as they are sampled
+	// the sse2 kernel writes the same bits as the scalar one
+	void Premultiply(_Inout_ uint8_t* pixels, _In_ size_t texelCount, _In_ bool isSrgb);
+	void Premultiply(_Inout_ uint8_t* pixels, _In_ size_t texelCount, _In_ bool isSrgb, _In_ QuadKernel::InstructionSet set);
+
+	// encode an RGBA8 image into blocks, the rows of blocks in parallel
+	// the texels past the edge of a partial block repeat the last row and column
+	// returns 0 on success, -2 if the format is not a compressed one
+	int EncodeBlocks(_In_ TextureContainer::PixelFormat format, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _Out_ uint8_t* p_blocks);
+
+	// decode blocks into RGBA8 as the gpu samples them (BC4 is red only, BC7 only in the modes the encoder writes)
+	// returns 0 on success, -2 if the format or a block is not supported
+	int DecodeBlocks(_In_ TextureContainer::PixelFormat format, _In_ const uint8_t* p_blocks, _In_ uint32_t width, _In_ uint32_t height, _Out_ uint8_t* pixels);
+
+	// generate the mip chain and encode every level in the chosen format
+	// returns 0 on success, -2 on invalid arguments
+	int Import(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ const Settings& settings, _Out_ Image* p_image);
+
+	// import and write a container
+	// returns 0 on success, -1 if the file cannot be written, -2 on invalid arguments
+	int Cook(_In_ const std::string& path, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ const Settings& settings,
+		_Out_opt_ Image* p_image = nullptr);
+
+	// peak signal to noise ratio in dB over the channels of the mask (bit 0 is red), infinite if equal
+	double ComputePsnr(_In_ const uint8_t* p_reference, _In_ const uint8_t* p_pixels, _In_ size_t texelCount, _In_ uint32_t channelMask = 0xf);
+
+	// getter
+	const char* GetFormatName(_In_ TextureContainer::PixelFormat format);
+	const char* GetContentName(_In_ Content type);
+}
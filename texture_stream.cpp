@@ -0,0 +1,474 @@
+
+#include "directx11_wrapper.h"
+#include "renderer.h"
+#include "png_decoder.h"
+#include "profiler.h"
+#include "texture_import.h"
+#include "texture_stream.h"
+
+namespace TextureStream
+{
+	namespace
+	{
+		/// <summary>
+		/// create the full mip chain of RGBA8 texels, filtered in linear light
+		/// premultiplied levels are multiplied after filtering, in linear light for an sRGB format as the view decodes it
+		/// </summary>
+		HRESULT CreateMipChain(_In_ DXGI_FORMAT format, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height,
+			_In_ bool isPremultiplied, _Out_ DirectX::ScratchImage& image)
+		{
+			uint32_t mip_levels = TextureContainer::GetMipCount(width, height);
+			if (mip_levels > TextureContainer::MAX_MIP_LEVELS) mip_levels = TextureContainer::MAX_MIP_LEVELS;
+
+			std::vector<std::vector<uint8_t>> mips;
+			TextureImport::GenerateMips(pixels, width, height, mip_levels, true, &mips);
+			if (isPremultiplied)
+			{
+				for (size_t mip = 0; mip < mips.size(); ++mip)
+				{
+					TextureImport::Premultiply(mips[mip].data(), mips[mip].size() / 4, format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB);
+				}
+			}
+
+			HRESULT h_result = image.Initialize2D(format, width, height, 1, mips.size());
+			if (FAILED(h_result))
+				return h_result;
+
+			for (size_t mip = 0; mip < mips.size(); ++mip)
+			{
+				const DirectX::Image* p_level = image.GetImage(mip, 0, 0);
+				const size_t row_bytes = p_level->width * 4;
+				for (size_t y = 0; y < p_level->height; ++y)
+				{
+					memcpy(p_level->pixels + y * p_level->rowPitch, &mips[mip][y * row_bytes], row_bytes);
+				}
+			}
+
+			return h_result;
+		}
+
+		/// <summary>
+		/// replace a decoded image of one level by RGBA8 with the full mip chain, filtered in linear light
+		/// without it a minified texture samples its base level (the sampler allows every level)
+		/// </summary>
+		HRESULT GenerateMipChain(_In_ bool isPremultiplied, _Inout_ DirectX::ScratchImage& image)
+		{
+			HRESULT h_result = S_OK;
+
+			const DirectX::TexMetadata& metadata = image.GetMetadata();
+			if (metadata.mipLevels > 1)
+				return h_result;
+
+			// the sRGB flavor holds the same bytes
+			DXGI_FORMAT format = metadata.format;
+			DirectX::ScratchImage converted;
+			const DirectX::Image* p_source = image.GetImage(0, 0, 0);
+			if (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+			{
+				format = DXGI_FORMAT_R8G8B8A8_UNORM;
+				h_result = DirectX::Convert(*p_source, format, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+				if (FAILED(h_result))
+					return h_result;
+
+				p_source = converted.GetImage(0, 0, 0);
+			}
+
+			const uint32_t width  = static_cast<uint32_t>(p_source->width);
+			const uint32_t height = static_cast<uint32_t>(p_source->height);
+			std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				memcpy(&pixels[static_cast<size_t>(y) * width * 4], p_source->pixels + y * p_source->rowPitch, static_cast<size_t>(width) * 4);
+			}
+
+			DirectX::ScratchImage chain;
+			h_result = CreateMipChain(format, pixels.data(), width, height, isPremultiplied, chain);
+			if (FAILED(h_result))
+				return h_result;
+
+			image = std::move(chain);
+
+			return h_result;
+		}
+	}
+
+	/// <summary>
+	/// constructor for texture stream
+	/// </summary>
+	Manager::Manager()
+	{
+		_placeholderSrv  = nullptr;
+		_isPremultiplied = false;
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// initialization process for texture stream
+	/// </summary>
+	HRESULT Manager::Initialize()
+	{
+		HRESULT h_result = S_OK;
+
+		h_result = CreatePlaceholder();
+		if (FAILED(h_result))
+			return h_result;
+
+		_streamer.Initialize(this);
+
+		return h_result;
+	}
+
+	/// <summary>
+	/// termination process for texture stream
+	/// </summary>
+	void Manager::Terminate()
+	{
+		_streamer.Terminate();
+
+		// decoded but never uploaded
+		_decodedImages.clear();
+		_mappedContainers.clear();
+
+		for (ID3D11ShaderResourceView* p_srv : _srvs)
+		{
+			if (p_srv) p_srv->Release();
+		}
+		_srvs.clear();
+
+		if (_placeholderSrv)
+		{
+			_placeholderSrv->Release();
+			_placeholderSrv = nullptr;
+		}
+	}
+
+	/// <summary>
+	/// creates the 1x1 placeholder texture
+	/// </summary>
+	HRESULT Manager::CreatePlaceholder()
+	{
+		HRESULT h_result = S_OK;
+
+		D3D11_TEXTURE2D_DESC tex2d_desc;
+		ZeroMemory(&tex2d_desc, sizeof(tex2d_desc));
+		{
+			tex2d_desc.Width     = 1;
+			tex2d_desc.Height    = 1;
+			tex2d_desc.MipLevels = 1;
+			tex2d_desc.ArraySize = 1;
+			tex2d_desc.Format    = DXGI_FORMAT_R8G8B8A8_UNORM;
+			tex2d_desc.SampleDesc.Count = 1;
+			tex2d_desc.Usage     = D3D11_USAGE_IMMUTABLE;
+			tex2d_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		}
+
+		D3D11_SUBRESOURCE_DATA subresource_data;
+		ZeroMemory(&subresource_data, sizeof(subresource_data));
+		subresource_data.pSysMem     = &PLACEHOLDER_COLOR;
+		subresource_data.SysMemPitch = sizeof(PLACEHOLDER_COLOR);
+
+		ID3D11Device& device = Renderer::Manager::Instance().GetDevice();
+
+		ID3D11Texture2D* p_texture = nullptr;
+		h_result = device.CreateTexture2D(&tex2d_desc, &subresource_data, &p_texture);
+		if (FAILED(h_result))
+			return h_result;
+
+		h_result = device.CreateShaderResourceView(p_texture, nullptr, &_placeholderSrv);
+		p_texture->Release();
+
+		return h_result;
+	}
+
+	/// <summary>
+	/// map the cooked container next to the source image on a worker thread
+	/// returns 0 if there is no valid container
+	/// </summary>
+	size_t Manager::MapContainer(Handle handle, const std::wstring& path)
+	{
+		const size_t dot = path.find_last_of(L'.');
+		if (dot == std::wstring::npos)
+			return 0;
+
+		std::wstring container_path = path.substr(0, dot);
+		for (const char* p = TextureContainer::FILE_EXTENSION; *p; ++p) container_path += static_cast<wchar_t>(*p);
+
+		std::unique_ptr<TextureContainer::Reader> container = std::make_unique<TextureContainer::Reader>();
+		if (container->Open(container_path.c_str()) != 0)
+			return 0;
+
+		// a container cooked with the other alpha is skipped, and the image decoded instead
+		const bool is_premultiplied = (container->GetHeader().Flags & TextureContainer::FLAG_PREMULTIPLIED_ALPHA) != 0;
+		if (is_premultiplied != _isPremultiplied)
+			return 0;
+
+		// the pages are read here, so the upload on the render thread does not wait for the disk
+		container->Prefetch();
+
+		size_t bytes = container->GetDataSize();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_mappedContainers[handle] = std::move(container);
+		}
+
+		return bytes;
+	}
+
+	/// <summary>
+	/// creates the Shader-Resource-View with the subresources inside the mapping
+	/// </summary>
+	HRESULT Manager::CreateSrvFromContainer(const TextureContainer::Reader& container, ID3D11ShaderResourceView** pp_srv)
+	{
+		HRESULT h_result = S_OK;
+
+		const TextureContainer::FileHeader& header = container.GetHeader();
+
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		switch (header.Format)
+		{
+		case TextureContainer::PixelFormat::Rgba8: format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+		case TextureContainer::PixelFormat::Bc1:   format = DXGI_FORMAT_BC1_UNORM;      break;
+		case TextureContainer::PixelFormat::Bc3:   format = DXGI_FORMAT_BC3_UNORM;      break;
+		case TextureContainer::PixelFormat::Bc4:   format = DXGI_FORMAT_BC4_UNORM;      break;
+		case TextureContainer::PixelFormat::Bc7:   format = DXGI_FORMAT_BC7_UNORM;      break;
+		default: return E_INVALIDARG;
+		}
+
+		D3D11_TEXTURE2D_DESC tex2d_desc;
+		ZeroMemory(&tex2d_desc, sizeof(tex2d_desc));
+		{
+			tex2d_desc.Width     = header.Width;
+			tex2d_desc.Height    = header.Height;
+			tex2d_desc.MipLevels = header.MipLevels;
+			tex2d_desc.ArraySize = 1;
+			tex2d_desc.Format    = format;
+			tex2d_desc.SampleDesc.Count = 1;
+			tex2d_desc.Usage     = D3D11_USAGE_IMMUTABLE;
+			tex2d_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		}
+
+		D3D11_SUBRESOURCE_DATA subresource_data[TextureContainer::MAX_MIP_LEVELS];
+		for (uint32_t mip = 0; mip < header.MipLevels; ++mip)
+		{
+			subresource_data[mip].pSysMem          = container.GetSubresourceData(mip);
+			subresource_data[mip].SysMemPitch      = container.GetSubresource(mip).RowPitch;
+			subresource_data[mip].SysMemSlicePitch = container.GetSubresource(mip).SlicePitch;
+		}
+
+		ID3D11Device& device = Renderer::Manager::Instance().GetDevice();
+
+		ID3D11Texture2D* p_texture = nullptr;
+		h_result = device.CreateTexture2D(&tex2d_desc, subresource_data, &p_texture);
+		if (FAILED(h_result))
+			return h_result;
+
+		h_result = device.CreateShaderResourceView(p_texture, nullptr, pp_srv);
+		p_texture->Release();
+
+		return h_result;
+	}
+
+	/// <summary>
+	/// decode a texture on a worker thread
+	/// a cooked container is mapped, otherwise the PNG (or any other WIC file) is decoded and its mip chain generated
+	/// </summary>
+	size_t Manager::Decode(Handle handle, const std::wstring& path)
+	{
+		PROFILE_SCOPE("TextureStream::Decode");
+
+		size_t bytes = MapContainer(handle, path);
+		if (bytes)
+			return bytes;
+
+		// a PNG is decoded straight into RGBA8, without COM or a converted copy
+		std::unique_ptr<DirectX::ScratchImage> image = std::make_unique<DirectX::ScratchImage>();
+		HRESULT h_result = E_FAIL;
+
+		PngDecoder::Image png;
+		if (PngDecoder::DecodeFile(path.c_str(), PngDecoder::Layout::Rgba8, &png) == 0)
+		{
+			const DXGI_FORMAT format = png.IsSrgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+			h_result = CreateMipChain(format, png.Pixels.data(), png.Width, png.Height, _isPremultiplied, *image);
+		}
+		else
+		{
+			// WIC needs COM on the calling thread
+			HRESULT h_com = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+			h_result = DirectX::LoadFromWICFile(path.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, *image);
+
+			if (SUCCEEDED(h_com)) CoUninitialize();
+
+			if (SUCCEEDED(h_result)) h_result = GenerateMipChain(_isPremultiplied, *image);
+		}
+		if (FAILED(h_result))
+			return 0;
+
+		bytes = image->GetPixelsSize();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_decodedImages[handle] = std::move(image);
+		}
+
+		return bytes;
+	}
+
+	/// <summary>
+	/// creates the Shader-Resource-View of a decoded texture
+	/// </summary>
+	bool Manager::Upload(Handle handle)
+	{
+		PROFILE_SCOPE("TextureStream::Upload");
+
+		std::unique_ptr<DirectX::ScratchImage> image;
+		std::unique_ptr<TextureContainer::Reader> container;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _decodedImages.find(handle);
+			if (it != _decodedImages.end())
+			{
+				image = std::move(it->second);
+				_decodedImages.erase(it);
+			}
+
+			auto it_container = _mappedContainers.find(handle);
+			if (it_container != _mappedContainers.end())
+			{
+				container = std::move(it_container->second);
+				_mappedContainers.erase(it_container);
+			}
+		}
+
+		// the mapping is closed when the container goes out of scope
+		ID3D11ShaderResourceView* p_srv = nullptr;
+		HRESULT h_result = E_FAIL;
+		if (container)
+		{
+			h_result = CreateSrvFromContainer(*container, &p_srv);
+		}
+		else if (image)
+		{
+			h_result = DirectX::CreateShaderResourceView(&Renderer::Manager::Instance().GetDevice(),
+				image->GetImages(), image->GetImageCount(), image->GetMetadata(), &p_srv);
+		}
+		if (FAILED(h_result))
+			return false;
+
+		// the texels are copied by the device at creation
+		FrameCounters::Manager::Instance().Add(FrameCounters::Subsystem::TextureStream, FrameCounters::Counter::UploadBytes,
+			container ? container->GetDataSize() : image->GetPixelsSize());
+
+		if (_srvs.size() <= handle) _srvs.resize(handle + 1, nullptr);
+		_srvs[handle] = p_srv;
+
+		return true;
+	}
+
+	/// <summary>
+	/// release a texture in any state
+	/// </summary>
+	void Manager::Release(Handle handle)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_decodedImages.erase(handle);
+			_mappedContainers.erase(handle);
+		}
+
+		if (handle < _srvs.size() && _srvs[handle])
+		{
+			_srvs[handle]->Release();
+			_srvs[handle] = nullptr;
+		}
+	}
+
+	/// <summary>
+	/// update process for texture stream
+	/// </summary>
+	void Manager::Update()
+	{
+		_streamer.Update();
+	}
+
+	/// <summary>
+	/// request a texture
+	/// </summary>
+	Handle Manager::Load(_In_ const wchar_t* path, _In_ int priority)
+	{
+		return _streamer.Request(path, priority);
+	}
+
+	/// <summary>
+	/// release a texture
+	/// </summary>
+	void Manager::Unload(_In_ Handle handle)
+	{
+		_streamer.Release(handle);
+	}
+
+	/// <summary>
+	/// set the bytes uploaded per frame
+	/// </summary>
+	void Manager::SetUploadBudget(_In_ size_t bytes)
+	{
+		_streamer.SetUploadBudget(bytes);
+	}
+
+	/// <summary>
+	/// set whether the textures are premultiplied
+	/// </summary>
+	void Manager::SetPremultipliedAlpha(_In_ bool isPremultiplied)
+	{
+		_isPremultiplied = isPremultiplied;
+	}
+
+	/// <summary>
+	/// get the Shader-Resource-View of a texture, or the placeholder until it is resident
+	/// </summary>
+	ID3D11ShaderResourceView* Manager::GetSrv(_In_ Handle handle) const
+	{
+		if (handle < _srvs.size() && _srvs[handle]) return _srvs[handle];
+
+		return _placeholderSrv;
+	}
+
+	/// <summary>
+	/// check whether a texture is resident
+	/// </summary>
+	bool Manager::IsResident(_In_ Handle handle) const
+	{
+		return _streamer.IsResident(handle);
+	}
+
+	/// <summary>
+	/// get whether the textures are premultiplied
+	/// </summary>
+	bool Manager::IsPremultipliedAlpha() const
+	{
+		return _isPremultiplied;
+	}
+
+	/// <summary>
+	/// get the time from the request to the upload
+	/// </summary>
+	double Manager::GetTimeToFirstPixelMs(_In_ Handle handle) const
+	{
+		return _streamer.GetTimeToFirstPixelMs(handle);
+	}
+
+	/// <summary>
+	/// get statistics of the last frame
+	/// </summary>
+	const FrameStats& Manager::GetLastFrameStats() const
+	{
+		return _streamer.GetLastFrameStats();
+	}
+}
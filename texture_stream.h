@@ -0,0 +1,85 @@
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "texture_container.h"
+#include "texture_stream_core.h"
+
+namespace TextureStream
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// drawn until the texture is resident (RGBA8, red is the lowest byte)
+	constexpr uint32_t PLACEHOLDER_COLOR = 0xff808080;
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager : public Backend
+	{
+		Streamer _streamer;
+
+		ID3D11ShaderResourceView* _placeholderSrv;
+
+		// decoded by the workers, waiting for the upload
+		std::unordered_map<Handle, std::unique_ptr<DirectX::ScratchImage>> _decodedImages;
+
+		// cooked containers mapped by the workers, uploaded straight from the mapping
+		std::unordered_map<Handle, std::unique_ptr<TextureContainer::Reader>> _mappedContainers;
+		std::mutex _mutex;
+
+		// resident textures (render thread only)
+		std::vector<ID3D11ShaderResourceView*> _srvs;
+
+		// the colors of the textures are multiplied by alpha (set before loading textures, read by the workers)
+		bool _isPremultiplied;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		HRESULT CreatePlaceholder();
+
+		size_t MapContainer(Handle handle, const std::wstring& path);
+		HRESULT CreateSrvFromContainer(const TextureContainer::Reader& container, ID3D11ShaderResourceView** pp_srv);
+
+		// backend
+		size_t Decode(Handle handle, const std::wstring& path) override;
+		bool Upload(Handle handle) override;
+		void Release(Handle handle) override;
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		static Manager& Instance();
+
+		HRESULT Initialize();
+		void Terminate();
+
+		// upload the decoded textures within the budget of the frame
+		void Update();
+
+		// the texture is decoded on a worker and becomes resident later
+		Handle Load(_In_ const wchar_t* path, _In_ int priority = 0);
+		void Unload(_In_ Handle handle);
+
+		// setter
+		void SetUploadBudget(_In_ size_t bytes);
+
+		// decoded textures are premultiplied, and only containers cooked the same way are mapped
+		void SetPremultipliedAlpha(_In_ bool isPremultiplied);
+
+		// getter
+		ID3D11ShaderResourceView* GetSrv(_In_ Handle handle) const;
+		bool IsResident(_In_ Handle handle) const;
+		bool IsPremultipliedAlpha() const;
+		double GetTimeToFirstPixelMs(_In_ Handle handle) const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
@@ -0,0 +1,283 @@
+
+#include "texture_stream_core.h"
+#include "thread_pool.h"
+
+namespace TextureStream
+{
+	/// <summary>
+	/// constructor for texture streamer
+	/// </summary>
+	Streamer::Streamer()
+	{
+		_backend = nullptr;
+		_uploadBudgetBytes  = DEFAULT_UPLOAD_BUDGET_BYTES;
+		_maxDecodesInFlight = DEFAULT_MAX_DECODES_IN_FLIGHT;
+
+		_decodesInFlight = 0;
+		_sequence = 0;
+
+		_frameStats     = {};
+		_lastFrameStats = {};
+	}
+
+	/// <summary>
+	/// initialization process for texture streamer
+	/// </summary>
+	void Streamer::Initialize(_In_ Backend* backend, _In_ size_t uploadBudgetBytes, _In_ uint32_t maxDecodesInFlight)
+	{
+		_backend = backend;
+		_uploadBudgetBytes  = uploadBudgetBytes;
+		_maxDecodesInFlight = (maxDecodesInFlight > 0) ? maxDecodesInFlight : 1;
+	}
+
+	/// <summary>
+	/// termination process for texture streamer
+	/// </summary>
+	void Streamer::Terminate()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		// the workers still refer to the entries
+		_decodeFinished.wait(lock, [this]() { return _decodesInFlight == 0; });
+
+		for (Handle handle = 0; handle < static_cast<Handle>(_entries.size()); ++handle)
+		{
+			if (_entries[handle].LoadState != State::Released && _entries[handle].LoadState != State::Queued)
+			{
+				_backend->Release(handle);
+			}
+		}
+
+		_entries.clear();
+		_requestQueue = {};
+		_uploadQueue  = {};
+	}
+
+	/// <summary>
+	/// request a texture
+	/// </summary>
+	Handle Streamer::Request(_In_ const std::wstring& path, _In_ int priority)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		Handle handle = static_cast<Handle>(_entries.size());
+
+		Entry entry;
+		entry.Path     = path;
+		entry.Priority = priority;
+		entry.LoadState    = State::Queued;
+		entry.IsReleasePending = false;
+		entry.Bytes = 0;
+		entry.RequestTime = Clock::now();
+		entry.TimeToFirstPixelMs = 0.0;
+		_entries.push_back(entry);
+
+		_requestQueue.push({ priority, _sequence++, handle });
+
+		return handle;
+	}
+
+	/// <summary>
+	/// release a texture, a running decode is released when it finishes
+	/// </summary>
+	void Streamer::Release(_In_ Handle handle)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (handle >= _entries.size()) return;
+
+		Entry& entry = _entries[handle];
+		switch (entry.LoadState)
+		{
+		case State::Decoding:
+			entry.IsReleasePending = true;
+			break;
+
+		case State::Decoded:
+		case State::Resident:
+		case State::Failed:
+			_backend->Release(handle);
+			entry.LoadState = State::Released;
+			break;
+
+		case State::Queued:
+			// skipped when it leaves the queue
+			entry.LoadState = State::Released;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	/// <summary>
+	/// start decodes and upload within the budget
+	/// </summary>
+	void Streamer::Update()
+	{
+		StartDecodes();
+		UploadDecoded();
+
+		// close statistics of the frame
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_frameStats.Queued   = static_cast<uint32_t>(_requestQueue.size());
+			_frameStats.InFlight = _decodesInFlight + static_cast<uint32_t>(_uploadQueue.size());
+			if (_frameStats.Uploads > 0) _frameStats.AverageTimeToFirstPixelMs /= _frameStats.Uploads;
+		}
+
+		_lastFrameStats = _frameStats;
+		_frameStats = {};
+	}
+
+	/// <summary>
+	/// hand the most important requests to the workers
+	/// </summary>
+	void Streamer::StartDecodes()
+	{
+		std::vector<Handle> starts;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			while (!_requestQueue.empty() && _decodesInFlight < _maxDecodesInFlight)
+			{
+				Handle handle = _requestQueue.top().TextureHandle;
+				_requestQueue.pop();
+
+				Entry& entry = _entries[handle];
+				if (entry.LoadState != State::Queued) continue;
+
+				entry.LoadState = State::Decoding;
+				_decodesInFlight++;
+				starts.push_back(handle);
+			}
+		}
+
+		for (Handle handle : starts)
+		{
+			// the path is copied, the entries may grow while the worker runs
+			std::wstring path;
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				path = _entries[handle].Path;
+			}
+
+			ThreadPool::Manager::Instance().Submit([this, handle, path]()
+			{
+				FinishDecode(handle, _backend->Decode(handle, path));
+			});
+		}
+	}
+
+	/// <summary>
+	/// called on the worker when a decode finished
+	/// </summary>
+	void Streamer::FinishDecode(_In_ Handle handle, _In_ size_t bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			Entry& entry = _entries[handle];
+			entry.Bytes = bytes;
+			entry.LoadState = (bytes > 0) ? State::Decoded : State::Failed;
+
+			// released while decoding, the render thread frees it in the next upload pass
+			_uploadQueue.push({ entry.Priority, _sequence++, handle });
+
+			_decodesInFlight--;
+		}
+		_decodeFinished.notify_all();
+	}
+
+	/// <summary>
+	/// upload decoded textures in priority order until the budget of the frame is used
+	/// </summary>
+	void Streamer::UploadDecoded()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		size_t uploaded_bytes = 0;
+		while (!_uploadQueue.empty())
+		{
+			Handle handle = _uploadQueue.top().TextureHandle;
+			Entry& entry = _entries[handle];
+
+			if (entry.IsReleasePending)
+			{
+				_uploadQueue.pop();
+				_backend->Release(handle);
+				entry.LoadState = State::Released;
+				continue;
+			}
+
+			if (entry.LoadState != State::Decoded)
+			{
+				_uploadQueue.pop();
+				continue;
+			}
+
+			// a texture larger than the budget is uploaded alone
+			if (uploaded_bytes > 0 && uploaded_bytes + entry.Bytes > _uploadBudgetBytes) break;
+			_uploadQueue.pop();
+
+			if (!_backend->Upload(handle))
+			{
+				entry.LoadState = State::Failed;
+				continue;
+			}
+
+			entry.LoadState = State::Resident;
+			entry.TimeToFirstPixelMs = std::chrono::duration<double, std::milli>(Clock::now() - entry.RequestTime).count();
+			uploaded_bytes += entry.Bytes;
+
+			_frameStats.Uploads++;
+			_frameStats.UploadBytes += entry.Bytes;
+			_frameStats.AverageTimeToFirstPixelMs += entry.TimeToFirstPixelMs;
+			if (entry.TimeToFirstPixelMs > _frameStats.MaxTimeToFirstPixelMs) _frameStats.MaxTimeToFirstPixelMs = entry.TimeToFirstPixelMs;
+		}
+	}
+
+	/// <summary>
+	/// set the bytes uploaded per frame
+	/// </summary>
+	void Streamer::SetUploadBudget(_In_ size_t bytes)
+	{
+		_uploadBudgetBytes = bytes;
+	}
+
+	/// <summary>
+	/// get the state of a texture
+	/// </summary>
+	State Streamer::GetState(_In_ Handle handle) const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (handle >= _entries.size()) return State::Failed;
+
+		return _entries[handle].LoadState;
+	}
+
+	/// <summary>
+	/// check whether a texture can be drawn
+	/// </summary>
+	bool Streamer::IsResident(_In_ Handle handle) const
+	{
+		return GetState(handle) == State::Resident;
+	}
+
+	/// <summary>
+	/// get the time from the request to the upload (0 until resident)
+	/// </summary>
+	double Streamer::GetTimeToFirstPixelMs(_In_ Handle handle) const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (handle >= _entries.size()) return 0.0;
+
+		return _entries[handle].TimeToFirstPixelMs;
+	}
+
+	/// <summary>
+	/// get statistics of the last frame
+	/// </summary>
+	const FrameStats& Streamer::GetLastFrameStats() const
+	{
+		return _lastFrameStats;
+	}
+}
@@ -0,0 +1,172 @@
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "portable_sal.h"
+
+namespace TextureStream
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	using Handle = uint32_t;
+	constexpr Handle INVALID_HANDLE = 0xffffffff;
+
+	// bytes uploaded to the gpu per frame (a single larger texture still goes alone)
+	constexpr size_t DEFAULT_UPLOAD_BUDGET_BYTES = 4 * 1024 * 1024;
+
+	// decodes running on the workers at the same time
+	constexpr uint32_t DEFAULT_MAX_DECODES_IN_FLIGHT = 4;
+
+	//--------------------------------------------------------
+	// enumerator
+	//--------------------------------------------------------
+	/// <summary>
+	/// life of a streamed texture
+	/// </summary>
+	enum class State
+	{
+		Queued,
+		Decoding,
+		Decoded,
+		Resident,
+		Failed,
+		Released,
+
+		Maximum
+	};
+
+	//--------------------------------------------------------
+	// structure
+	//--------------------------------------------------------
+	/// <summary>
+	/// statistics of one frame
+	/// </summary>
+	struct FrameStats
+	{
+		uint32_t Uploads;
+		size_t UploadBytes;
+		uint32_t Queued;     // waiting for a worker at the end of the frame
+		uint32_t InFlight;   // decoding or waiting for the upload budget
+
+		// time from the request to the first frame the texture can be drawn
+		double AverageTimeToFirstPixelMs;
+		double MaxTimeToFirstPixelMs;
+	};
+
+	//--------------------------------------------------------
+	// backend interface
+	//--------------------------------------------------------
+	/// <summary>
+	/// decoder and uploader of the textures
+	/// </summary>
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+
+		// called on a worker thread, returns the bytes to upload (0 on failure)
+		virtual size_t Decode(Handle handle, const std::wstring& path) = 0;
+
+		// called on the render thread
+		virtual bool Upload(Handle handle) = 0;
+		virtual void Release(Handle handle) = 0;
+	};
+
+	//--------------------------------------------------------
+	// streamer class
+	//--------------------------------------------------------
+	class Streamer
+	{
+		using Clock = std::chrono::steady_clock;
+
+		/// <summary>
+		/// a requested texture
+		/// </summary>
+		struct Entry
+		{
+			std::wstring Path;
+			int Priority;
+			State LoadState;
+			bool IsReleasePending;
+			size_t Bytes;
+			Clock::time_point RequestTime;
+			double TimeToFirstPixelMs;
+		};
+
+		/// <summary>
+		/// order of the queues: higher priority first, then first requested
+		/// </summary>
+		struct QueueItem
+		{
+			int Priority;
+			uint64_t Sequence;
+			Handle TextureHandle;
+
+			bool operator<(const QueueItem& other) const
+			{
+				if (Priority != other.Priority) return Priority < other.Priority;
+				return Sequence > other.Sequence;
+			}
+		};
+
+		Backend* _backend;
+		size_t _uploadBudgetBytes;
+		uint32_t _maxDecodesInFlight;
+
+		// shared with the workers
+		std::vector<Entry> _entries;
+		std::priority_queue<QueueItem> _requestQueue;
+		std::priority_queue<QueueItem> _uploadQueue;
+		uint32_t _decodesInFlight;
+		uint64_t _sequence;
+		mutable std::mutex _mutex;
+		std::condition_variable _decodeFinished;
+
+		FrameStats _frameStats;
+		FrameStats _lastFrameStats;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void StartDecodes();
+		void UploadDecoded();
+		void FinishDecode(_In_ Handle handle, _In_ size_t bytes);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Streamer();
+
+		void Initialize(_In_ Backend* backend, _In_ size_t uploadBudgetBytes = DEFAULT_UPLOAD_BUDGET_BYTES,
+			_In_ uint32_t maxDecodesInFlight = DEFAULT_MAX_DECODES_IN_FLIGHT);
+
+		// waits for the running decodes, and releases every texture
+		void Terminate();
+
+		// the texture becomes resident during a later Update
+		Handle Request(_In_ const std::wstring& path, _In_ int priority = 0);
+		void Release(_In_ Handle handle);
+
+		// start decodes and upload within the budget, once per frame on the render thread
+		void Update();
+
+		// setter
+		void SetUploadBudget(_In_ size_t bytes);
+
+		// getter
+		State GetState(_In_ Handle handle) const;
+		bool IsResident(_In_ Handle handle) const;
+		double GetTimeToFirstPixelMs(_In_ Handle handle) const;
+		const FrameStats& GetLastFrameStats() const;
+	};
+}
@@ -0,0 +1,234 @@
+
+#include "profiler.h"
+#include "thread_pool.h"
+
+namespace ThreadPool
+{
+	/// <summary>
+	/// constructor for thread pool
+	/// </summary>
+	Manager::Manager()
+	{
+		for (Job& job : _jobs)
+		{
+			job.Func      = nullptr;
+			job.Context   = nullptr;
+			job.Count     = 0;
+			job.Next      = 0;
+			job.Completed = 0;
+			job.Helpers   = 0;
+			job.IsActive  = false;
+		}
+
+		_isRunning = false;
+	}
+
+	/// <summary>
+	/// destructor for thread pool
+	/// </summary>
+	Manager::~Manager()
+	{
+		Terminate();
+	}
+
+	/// <summary>
+	/// instantiate with the Singleton Method Design Pattern
+	/// </summary>
+	Manager& Manager::Instance()
+	{
+		static Manager s_instance;
+		return s_instance;
+	}
+
+	/// <summary>
+	/// initialization process for thread pool
+	/// </summary>
+	void Manager::Initialize(_In_ uint32_t threadCount)
+	{
+		if (_isRunning) return;
+
+		if (threadCount == 0)
+		{
+			uint32_t cores = std::thread::hardware_concurrency();
+			threadCount = (cores > 1) ? cores - 1 : 0;
+		}
+
+		_isRunning = true;
+		_workers.reserve(threadCount);
+		for (uint32_t t = 0; t < threadCount; ++t)
+		{
+			_workers.emplace_back(&Manager::WorkerLoop, this);
+		}
+	}
+
+	/// <summary>
+	/// termination process for thread pool
+	/// the queued tasks are finished before the workers exit
+	/// </summary>
+	void Manager::Terminate()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_isRunning) return;
+			_isRunning = false;
+		}
+		_condition.notify_all();
+
+		for (std::thread& worker : _workers)
+		{
+			worker.join();
+		}
+		_workers.clear();
+	}
+
+	/// <summary>
+	/// loop of a worker thread
+	/// </summary>
+	void Manager::WorkerLoop()
+	{
+		PROFILE_THREAD_NAME("worker");
+
+		while (1)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_condition.wait(lock, [this]() { return !_isRunning || !_tasks.empty() || FindJob(); });
+
+				// a parallel loop keeps its caller waiting, so it goes before the queued tasks
+				Job* p_job = FindJob();
+				if (p_job)
+				{
+					p_job->Helpers.fetch_add(1, std::memory_order_relaxed);
+					lock.unlock();
+
+					RunJob(*p_job);
+					p_job->Helpers.fetch_sub(1, std::memory_order_release);
+					continue;
+				}
+
+				if (_tasks.empty()) return;
+
+				task = std::move(_tasks.front());
+				_tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+
+	/// <summary>
+	/// find a parallel loop with indices left, call with the mutex locked
+	/// </summary>
+	Manager::Job* Manager::FindJob()
+	{
+		for (Job& job : _jobs)
+		{
+			if (job.IsActive && job.Next.load(std::memory_order_relaxed) < job.Count) return &job;
+		}
+
+		return nullptr;
+	}
+
+	/// <summary>
+	/// take the indices of a parallel loop until none are left
+	/// </summary>
+	void Manager::RunJob(_Inout_ Job& job)
+	{
+		size_t i;
+		while ((i = job.Next.fetch_add(1)) < job.Count)
+		{
+			job.Func(job.Context, i);
+			job.Completed.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+	/// <summary>
+	/// run a task on a worker thread
+	/// </summary>
+	void Manager::Submit(_In_ std::function<void()> task)
+	{
+		// without workers the task runs in place
+		if (_workers.empty())
+		{
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.push_back(std::move(task));
+		}
+		_condition.notify_one();
+	}
+
+	/// <summary>
+	/// run func for every index on the workers and the calling thread, and wait for them
+	/// </summary>
+	void Manager::ParallelFor(_In_ size_t count, _In_ const std::function<void(size_t)>& func)
+	{
+		ParallelFor(count, [](void* p_context, size_t index) { (*static_cast<const std::function<void(size_t)>*>(p_context))(index); },
+			const_cast<std::function<void(size_t)>*>(&func));
+	}
+
+	/// <summary>
+	/// run a function for every index on the workers and the calling thread, and wait for them
+	/// the loop takes a preallocated slot, and the slot is reused only after every worker which joined it left
+	/// </summary>
+	void Manager::ParallelFor(_In_ size_t count, _In_ JobFunc p_func, _In_opt_ void* p_context)
+	{
+		if (count == 0) return;
+
+		Job* p_job = nullptr;
+		if (!_workers.empty() && count > 1)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			for (Job& job : _jobs)
+			{
+				if (job.IsActive || job.Helpers.load(std::memory_order_acquire) != 0) continue;
+
+				job.Func      = p_func;
+				job.Context   = p_context;
+				job.Count     = count;
+				job.Next      = 0;
+				job.Completed = 0;
+				job.IsActive  = true;
+				p_job = &job;
+				break;
+			}
+		}
+
+		// without workers or a free slot the loop runs in place
+		if (!p_job)
+		{
+			for (size_t i = 0; i < count; ++i) p_func(p_context, i);
+			return;
+		}
+		_condition.notify_all();
+
+		// the calling thread works too, then waits for the rest
+		RunJob(*p_job);
+		while (p_job->Completed.load(std::memory_order_acquire) < count)
+		{
+			std::this_thread::yield();
+		}
+
+		// no worker joins from now on, the ones which did only find the indices taken
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			p_job->IsActive = false;
+		}
+		while (p_job->Helpers.load(std::memory_order_acquire) != 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	/// <summary>
+	/// get the number of worker threads
+	/// </summary>
+	uint32_t Manager::GetWorkerCount() const
+	{
+		return static_cast<uint32_t>(_workers.size());
+	}
+}
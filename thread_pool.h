@@ -0,0 +1,91 @@
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "portable_sal.h"
+
+namespace ThreadPool
+{
+	//--------------------------------------------------------
+	// constant
+	//--------------------------------------------------------
+	// parallel loops running at once (nested or from several threads), a loop beyond them runs on the calling thread
+	constexpr uint32_t MAX_JOB_COUNT = 8;
+
+	// one index of a parallel loop
+	using JobFunc = void (*)(void* p_context, size_t index);
+
+	//--------------------------------------------------------
+	// manager class
+	//--------------------------------------------------------
+	class Manager
+	{
+		/// <summary>
+		/// a parallel loop, the workers take its indices until none are left
+		/// </summary>
+		struct Job
+		{
+			JobFunc Func;
+			void* Context;
+			size_t Count;
+			std::atomic<size_t> Next;
+			std::atomic<size_t> Completed;
+
+			// workers inside the loop, the slot is reused once they all left
+			std::atomic<uint32_t> Helpers;
+			bool IsActive;
+		};
+
+		std::vector<std::thread> _workers;
+
+		// task queue
+		std::deque<std::function<void()>> _tasks;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+
+		// slots of the parallel loops, so a loop does not allocate
+		Job _jobs[MAX_JOB_COUNT];
+
+		bool _isRunning;
+
+		//-----------------------------------
+		// private funcs
+		//-----------------------------------
+		void WorkerLoop();
+		Job* FindJob();
+		static void RunJob(_Inout_ Job& job);
+
+		//-----------------------------------
+		// public funcs
+		//-----------------------------------
+	public:
+		Manager();
+		~Manager();
+		static Manager& Instance();
+
+		// threadCount == 0 means one worker per core except the calling thread
+		void Initialize(_In_ uint32_t threadCount = 0);
+		void Terminate();
+
+		// run a task on a worker thread
+		void Submit(_In_ std::function<void()> task);
+
+		// run func(0) .. func(count - 1) on the workers and the calling thread, and wait for them
+		void ParallelFor(_In_ size_t count, _In_ const std::function<void(size_t)>& func);
+
+		// the same with a function pointer, it does not allocate
+		void ParallelFor(_In_ size_t count, _In_ JobFunc p_func, _In_opt_ void* p_context);
+
+		// getter
+		uint32_t GetWorkerCount() const;
+	};
+}
@@ -0,0 +1,246 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <windows.h>
+#include <directxtex.h>
+
+#pragma comment (lib, "directxtex.lib")
+
+#include "atlas_manifest.h"
+#include "atlas_packer.h"
+#include "png_decoder.h"
+#include "thread_pool.h"
+#include "tools.h"
+
+namespace Tools
+{
+	namespace
+	{
+		/// <summary>
+		/// image to pack, and the name sprites use to find it
+		/// </summary>
+		struct SourceImage
+		{
+			std::string Name;
+			PngDecoder::Image Image;
+		};
+
+		/// <summary>
+		/// check whether the file is an image to pack
+		/// </summary>
+		bool IsImageFile(const std::filesystem::path& path)
+		{
+			std::wstring extension = path.extension().wstring();
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
+
+			return extension == L".png" || extension == L".bmp" || extension == L".jpg" || extension == L".jpeg" ||
+				extension == L".gif" || extension == L".tif" || extension == L".tiff";
+		}
+
+		/// <summary>
+		/// load an image through WIC as RGBA8 (red is the lowest byte), for the files the PNG decoder does not read
+		/// </summary>
+		HRESULT LoadImageRgba8(const std::filesystem::path& path, PngDecoder::Image* p_image)
+		{
+			DirectX::ScratchImage loaded;
+			HRESULT h_result = DirectX::LoadFromWICFile(path.c_str(), DirectX::WIC_FLAGS_IGNORE_SRGB, nullptr, loaded);
+			if (FAILED(h_result))
+				return h_result;
+
+			DirectX::ScratchImage converted;
+			const DirectX::Image* p_source = loaded.GetImage(0, 0, 0);
+			if (loaded.GetMetadata().format != DXGI_FORMAT_R8G8B8A8_UNORM)
+			{
+				h_result = DirectX::Convert(*p_source, DXGI_FORMAT_R8G8B8A8_UNORM,
+					DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+				if (FAILED(h_result))
+					return h_result;
+
+				p_source = converted.GetImage(0, 0, 0);
+			}
+
+			p_image->Width  = static_cast<uint32_t>(p_source->width);
+			p_image->Height = static_cast<uint32_t>(p_source->height);
+			p_image->IsSrgb = false;
+			p_image->Pixels.resize(static_cast<size_t>(p_image->Width) * p_image->Height * 4);
+			for (uint32_t y = 0; y < p_image->Height; ++y)
+			{
+				memcpy(&p_image->Pixels[static_cast<size_t>(y) * p_image->Width * 4], p_source->pixels + y * p_source->rowPitch,
+					static_cast<size_t>(p_image->Width) * 4);
+			}
+
+			return S_OK;
+		}
+
+		/// <summary>
+		/// parse the value of a numeric option
+		/// </summary>
+		bool ParseOption(int argc, wchar_t* argv[], int* p_index, uint32_t* p_value)
+		{
+			if (*p_index + 1 >= argc) return false;
+
+			*p_value = static_cast<uint32_t>(std::wcstoul(argv[++*p_index], nullptr, 10));
+			return true;
+		}
+	}
+
+	/// <summary>
+	/// pack every image under a directory into atlas pages, and write the manifest
+	/// the pages are written next to the manifest as <manifest name>_<index>.png
+	/// </summary>
+	int RunAtlas(int argc, wchar_t* argv[])
+	{
+		if (argc < 2)
+		{
+			std::printf("usage: tools atlas <input directory> <output manifest> [--padding N] [--extrude N] [--max-size N] [--no-rotate]\n");
+			return 1;
+		}
+
+		const std::filesystem::path input_directory = argv[0];
+		const std::filesystem::path manifest_path   = argv[1];
+
+		AtlasPacker::Settings settings = AtlasPacker::GetDefaultSettings();
+		for (int a = 2; a < argc; ++a)
+		{
+			uint32_t max_size = 0;
+			bool is_valid = true;
+
+			if (std::wcscmp(argv[a], L"--padding") == 0)        is_valid = ParseOption(argc, argv, &a, &settings.Padding);
+			else if (std::wcscmp(argv[a], L"--extrude") == 0)   is_valid = ParseOption(argc, argv, &a, &settings.Extrude);
+			else if (std::wcscmp(argv[a], L"--max-size") == 0) is_valid = ParseOption(argc, argv, &a, &max_size);
+			else if (std::wcscmp(argv[a], L"--no-rotate") == 0) settings.AllowRotation = false;
+			else is_valid = false;
+
+			if (!is_valid)
+			{
+				std::printf("atlas: invalid option %ls\n", argv[a]);
+				return 1;
+			}
+			if (max_size) settings.MaxWidth = settings.MaxHeight = max_size;
+		}
+
+		//-----------------------------------
+		// load the images in path order, so the output does not depend on the file system
+		//-----------------------------------
+		std::vector<std::filesystem::path> paths;
+		for (const auto& entry : std::filesystem::recursive_directory_iterator(input_directory))
+		{
+			if (entry.is_regular_file() && IsImageFile(entry.path())) paths.push_back(entry.path());
+		}
+		std::sort(paths.begin(), paths.end());
+
+		// the PNGs are decoded on every core, WIC takes the other formats and what the decoder rejects
+		std::vector<std::wstring> path_names(paths.begin(), paths.end());
+		std::vector<PngDecoder::Image> decoded;
+		std::vector<int> results;
+		ThreadPool::Manager::Instance().Initialize();
+		PngDecoder::DecodeFiles(path_names, PngDecoder::Layout::Rgba8, &decoded, &results);
+		ThreadPool::Manager::Instance().Terminate();
+
+		std::vector<SourceImage> images(paths.size());
+		std::vector<AtlasPacker::AtlasSize> sizes(paths.size());
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			images[i].Image = std::move(decoded[i]);
+			if (results[i] != 0 && FAILED(LoadImageRgba8(paths[i], &images[i].Image)))
+			{
+				std::printf("atlas: cannot load %ls\n", paths[i].c_str());
+				return 1;
+			}
+
+			// sprites find the image by its relative path without the extension
+			std::filesystem::path name = std::filesystem::relative(paths[i], input_directory);
+			name.replace_extension();
+			images[i].Name = name.generic_u8string();
+
+			sizes[i] = { images[i].Image.Width, images[i].Image.Height };
+		}
+
+		//-----------------------------------
+		// pack
+		//-----------------------------------
+		std::vector<AtlasPacker::Placement> placements;
+		std::vector<AtlasPacker::AtlasSize> atlases;
+		if (AtlasPacker::Pack(sizes, settings, &placements, &atlases) != 0)
+		{
+			std::printf("atlas: an image is larger than %u x %u\n", settings.MaxWidth, settings.MaxHeight);
+			return 1;
+		}
+
+		//-----------------------------------
+		// write the pages and the manifest
+		//-----------------------------------
+		AtlasManifest::Manifest manifest;
+		const std::wstring stem = manifest_path.stem().wstring();
+
+		for (size_t p = 0; p < atlases.size(); ++p)
+		{
+			const AtlasPacker::AtlasSize& size = atlases[p];
+
+			DirectX::ScratchImage page;
+			if (FAILED(page.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, size.Width, size.Height, 1, 1)))
+				return 1;
+			std::fill_n(page.GetPixels(), page.GetPixelsSize(), static_cast<uint8_t>(0));
+
+			for (size_t i = 0; i < images.size(); ++i)
+			{
+				if (placements[i].Atlas != p) continue;
+
+				AtlasPacker::Blit(reinterpret_cast<const uint32_t*>(images[i].Image.Pixels.data()), sizes[i].Width, sizes[i].Height,
+					placements[i], settings.Extrude,
+					reinterpret_cast<uint32_t*>(page.GetPixels()), size.Width, size.Height);
+			}
+
+			const std::filesystem::path file_name = stem + L"_" + std::to_wstring(p) + L".png";
+			const std::filesystem::path page_path = manifest_path.parent_path() / file_name;
+			if (FAILED(DirectX::SaveToWICFile(*page.GetImage(0, 0, 0), DirectX::WIC_FLAGS_NONE,
+				DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), page_path.c_str())))
+			{
+				std::printf("atlas: cannot write %ls\n", page_path.c_str());
+				return 1;
+			}
+
+			manifest.AddPage({ file_name.u8string(), size.Width, size.Height });
+		}
+
+		uint64_t used_texels = 0;
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			const AtlasPacker::Placement& placement = placements[i];
+			const AtlasPacker::AtlasSize& size = atlases[placement.Atlas];
+
+			AtlasManifest::Region region;
+			region.Atlas       = placement.Atlas;
+			region.Texcoord[0] = static_cast<float>(placement.X) / size.Width;
+			region.Texcoord[1] = static_cast<float>(placement.Y) / size.Height;
+			region.TexSize[0]  = static_cast<float>(placement.Width)  / size.Width;
+			region.TexSize[1]  = static_cast<float>(placement.Height) / size.Height;
+			region.Width       = sizes[i].Width;
+			region.Height      = sizes[i].Height;
+			region.Rotated     = placement.Rotated;
+			manifest.AddRegion(images[i].Name, region);
+
+			used_texels += static_cast<uint64_t>(sizes[i].Width) * sizes[i].Height;
+		}
+
+		if (manifest.Save(manifest_path.u8string()) != 0)
+		{
+			std::printf("atlas: cannot write %ls\n", manifest_path.c_str());
+			return 1;
+		}
+
+		uint64_t total_texels = 0;
+		for (const AtlasPacker::AtlasSize& size : atlases) total_texels += static_cast<uint64_t>(size.Width) * size.Height;
+
+		std::printf("atlas: %zu images into %zu pages, %.1f %% occupancy\n", images.size(), atlases.size(),
+			total_texels ? 100.0 * used_texels / total_texels : 0.0);
+
+		return 0;
+	}
+}
@@ -0,0 +1,108 @@
+
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <filesystem>
+
+#include <windows.h>
+#include <directxtex.h>
+
+#pragma comment (lib, "directxtex.lib")
+
+#include "png_decoder.h"
+#include "texture_container.h"
+#include "texture_import.h"
+#include "thread_pool.h"
+#include "tools.h"
+
+namespace Tools
+{
+	/// <summary>
+	/// cook an image into a texture container with the full mip chain, block compressed by its content
+	/// the output defaults to the input with the container extension, where the texture stream looks for it
+	/// </summary>
+	int RunCook(int argc, wchar_t* argv[])
+	{
+		if (argc < 1)
+		{
+			std::printf("usage: tools cook <input image> [output container] [--opaque | --alpha | --mask] [--hq] [--uncompressed] [--linear] [--no-mips] [--premultiplied]\n");
+			return 1;
+		}
+
+		const std::filesystem::path input_path = argv[0];
+		std::filesystem::path output_path = input_path;
+		output_path.replace_extension(TextureContainer::FILE_EXTENSION);
+
+		TextureImport::Settings settings = TextureImport::GetDefaultSettings();
+		for (int a = 1; a < argc; ++a)
+		{
+			if      (std::wcscmp(argv[a], L"--opaque") == 0)        settings.Type = TextureImport::Content::Opaque;
+			else if (std::wcscmp(argv[a], L"--alpha") == 0)         settings.Type = TextureImport::Content::Alpha;
+			else if (std::wcscmp(argv[a], L"--mask") == 0)          settings.Type = TextureImport::Content::Mask;
+			else if (std::wcscmp(argv[a], L"--hq") == 0)            settings.IsHighQuality = true;
+			else if (std::wcscmp(argv[a], L"--uncompressed") == 0)  settings.IsCompressed = false;
+			else if (std::wcscmp(argv[a], L"--linear") == 0)        settings.IsSrgb = false;
+			else if (std::wcscmp(argv[a], L"--no-mips") == 0)       settings.GenerateMips = false;
+			else if (std::wcscmp(argv[a], L"--premultiplied") == 0) settings.IsPremultiplied = true;
+			else output_path = argv[a];
+		}
+
+		//-----------------------------------
+		// decode as RGBA8 (red is the lowest byte), a PNG by the built-in decoder and anything else by WIC
+		//-----------------------------------
+		PngDecoder::Image image;
+		if (PngDecoder::DecodeFile(input_path.c_str(), PngDecoder::Layout::Rgba8, &image) != 0)
+		{
+			DirectX::ScratchImage loaded;
+			HRESULT h_result = DirectX::LoadFromWICFile(input_path.c_str(), DirectX::WIC_FLAGS_IGNORE_SRGB, nullptr, loaded);
+			if (FAILED(h_result))
+			{
+				std::printf("cook: cannot load %ls\n", input_path.c_str());
+				return 1;
+			}
+
+			DirectX::ScratchImage converted;
+			const DirectX::Image* p_source = loaded.GetImage(0, 0, 0);
+			if (loaded.GetMetadata().format != DXGI_FORMAT_R8G8B8A8_UNORM)
+			{
+				h_result = DirectX::Convert(*p_source, DXGI_FORMAT_R8G8B8A8_UNORM,
+					DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+				if (FAILED(h_result))
+					return 1;
+
+				p_source = converted.GetImage(0, 0, 0);
+			}
+
+			image.Width  = static_cast<uint32_t>(p_source->width);
+			image.Height = static_cast<uint32_t>(p_source->height);
+			image.IsSrgb = false;
+			image.Pixels.resize(static_cast<size_t>(image.Width) * image.Height * 4);
+			for (uint32_t y = 0; y < image.Height; ++y)
+			{
+				memcpy(&image.Pixels[static_cast<size_t>(y) * image.Width * 4], p_source->pixels + y * p_source->rowPitch, static_cast<size_t>(image.Width) * 4);
+			}
+		}
+
+		//-----------------------------------
+		// mips and blocks on every core, then write
+		//-----------------------------------
+		ThreadPool::Manager::Instance().Initialize();
+
+		TextureImport::Image imported;
+		const int result = TextureImport::Cook(output_path.u8string(), image.Pixels.data(), image.Width, image.Height, settings, &imported);
+
+		ThreadPool::Manager::Instance().Terminate();
+
+		if (result != 0)
+		{
+			std::printf("cook: cannot write %ls\n", output_path.c_str());
+			return 1;
+		}
+
+		std::printf("cook: %ls (%u x %u, %s) -> %ls (%s, %zu mips%s)\n", input_path.c_str(), image.Width, image.Height,
+			TextureImport::GetContentName(imported.Type), output_path.c_str(), TextureImport::GetFormatName(imported.Format), imported.Mips.size(),
+			imported.IsPremultiplied ? ", premultiplied" : "");
+
+		return 0;
+	}
+}
@@ -0,0 +1,93 @@
+
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "shader_cache.h"
+#include "shader_compiler.h"
+#include "shader_permutation.h"
+#include "tools.h"
+
+namespace Tools
+{
+	/// <summary>
+	/// compile the shaders of the renderer into the shader cache, so the first launch does not run the compiler
+	/// the vertex shader and every pixel shader variant of the manifest are compiled
+	/// the shaders are read from the working directory, as the renderer does
+	/// </summary>
+	int RunShaders(int argc, wchar_t* argv[])
+	{
+		std::string directory = ShaderCompiler::CACHE_DIRECTORY;
+
+		bool is_debug = false;
+		for (int a = 0; a < argc; ++a)
+		{
+			if (std::wcscmp(argv[a], L"--debug") == 0)
+			{
+				is_debug = true;
+			}
+			else
+			{
+				directory = std::filesystem::path(argv[a]).string();
+			}
+		}
+
+		ShaderCompiler::Compiler compiler;
+		ShaderCache::Cache cache;
+		cache.Initialize(directory, &compiler);
+
+		// the same variants as the renderer creates at startup
+		std::vector<ShaderPermutation::Key> keys;
+		if (ShaderPermutation::LoadManifest(ShaderPermutation::MANIFEST_PATH, &keys) != 0)
+		{
+			std::printf("shaders: cannot read %s, only the default variant is compiled\n", ShaderPermutation::MANIFEST_PATH);
+		}
+		if (std::find(keys.begin(), keys.end(), ShaderPermutation::DEFAULT_KEY) == keys.end())
+		{
+			keys.push_back(ShaderPermutation::DEFAULT_KEY);
+		}
+
+		std::vector<ShaderCache::Desc> descs;
+		std::vector<std::string> names;
+		descs.push_back(ShaderCompiler::GetRendererShader(ShaderCompiler::RendererShader::Vertex, is_debug));
+		names.push_back("vertex");
+		for (ShaderPermutation::Key key : keys)
+		{
+			descs.push_back(ShaderCompiler::GetPixelShaderVariant(key, is_debug));
+			names.push_back("pixel " + ShaderPermutation::GetKeyName(key));
+		}
+
+		int result = 0;
+		std::vector<uint8_t> bytecode;
+		std::string errors;
+		for (size_t d = 0; d < descs.size(); ++d)
+		{
+			const ShaderCache::Desc& desc = descs[d];
+
+			const int load_result = cache.Load(desc, &bytecode, &errors);
+			if (load_result < 0)
+			{
+				std::printf("shaders: %s (%s) failed\n%s\n", names[d].c_str(), desc.Profile.c_str(), errors.c_str());
+				result = 1;
+				continue;
+			}
+
+			std::printf("shaders: %s (%s) %s -> %s\n", names[d].c_str(), desc.Profile.c_str(),
+				load_result == 0 ? "up to date" : "compiled", cache.GetEntryPath(desc).c_str());
+		}
+
+		const ShaderCache::Stats& stats = cache.GetStats();
+		if (stats.WriteFailures > 0)
+		{
+			std::printf("shaders: cannot write %u entries to %s\n", stats.WriteFailures, directory.c_str());
+			result = 1;
+		}
+
+		cache.Terminate();
+
+		return result;
+	}
+}
@@ -0,0 +1,13 @@
+
+#pragma once
+
+namespace Tools
+{
+	//--------------------------------------------------------
+	// functions
+	//--------------------------------------------------------
+	// commands receive the arguments after their name, and return the exit code
+	int RunAtlas(int argc, wchar_t* argv[]);
+	int RunCook(int argc, wchar_t* argv[]);
+	int RunShaders(int argc, wchar_t* argv[]);
+}
@@ -0,0 +1,60 @@
+
+#include <cstdio>
+#include <cwchar>
+
+#include <windows.h>
+
+#include "tools.h"
+
+namespace
+{
+	/// <summary>
+	/// print the commands
+	/// </summary>
+	void PrintUsage()
+	{
+		std::printf("usage: tools <command> [arguments]\n\n");
+		std::printf("commands:\n");
+		std::printf("  atlas <input directory> <output manifest> [--padding N] [--extrude N] [--max-size N] [--no-rotate]\n");
+		std::printf("  cook  <input image> [output container] [--opaque | --alpha | --mask] [--hq] [--uncompressed] [--linear] [--no-mips]\n");
+		std::printf("  shaders [cache directory] [--debug]\n");
+	}
+}
+
+/// <summary>
+/// main func of the offline tools
+/// </summary>
+int wmain(int argc, wchar_t* argv[])
+{
+	if (argc < 2)
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// DirectXTex reads and writes images through WIC
+	if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED)))
+		return 1;
+
+	int result = 1;
+	if (std::wcscmp(argv[1], L"atlas") == 0)
+	{
+		result = Tools::RunAtlas(argc - 2, argv + 2);
+	}
+	else if (std::wcscmp(argv[1], L"cook") == 0)
+	{
+		result = Tools::RunCook(argc - 2, argv + 2);
+	}
+	else if (std::wcscmp(argv[1], L"shaders") == 0)
+	{
+		result = Tools::RunShaders(argc - 2, argv + 2);
+	}
+	else
+	{
+		PrintUsage();
+	}
+
+	CoUninitialize();
+
+	return result;
+}
@@ -10,8 +10,11 @@ namespace Vertex
 	Manager::Manager()
 	{
 		Position = {};
-		Normal   = {};
+		Scale    = {};
+		Rotation = 0;
+		Texture  = 0;
+		UvRect   = {};
 		Color    = {};
-		Texcoord = {};
+		Material = 0;
 	}
 }
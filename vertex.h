@@ -6,12 +6,15 @@ namespace Vertex
 	class Manager
 	{
 	public:
-		// these need to be the same as input-layout
+		// these need to be the same as input-layout (one instance per sprite)
 		// just dont worry about alignment here
-		DirectX::XMFLOAT3 Position;
-		DirectX::XMFLOAT3 Normal;
-		DirectX::XMFLOAT4 Color;
-		DirectX::XMFLOAT2 Texcoord;
+		DirectX::XMFLOAT2 Position;
+		DirectX::PackedVector::XMHALF2 Scale;
+		int16_t Rotation;
+		uint16_t Texture;
+		DirectX::PackedVector::XMUSHORTN4 UvRect;
+		DirectX::PackedVector::XMUBYTEN4 Color;
+		uint32_t Material;
 
 		Manager();
 	};
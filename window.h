@@ -46,17 +46,6 @@ namespace Window
 
 		BOOL _isWindowedMode;
 
-		// time
-		DWORD _preExecTime;
-		DWORD _preFpsTime;
-		DWORD _curTime;
-		DWORD _frameCount;
-
-#ifdef _DEBUG
-		int _fpsCount;
-		TCHAR _debugStr[2048];
-#endif
-
 #ifdef WINDOW_MODE_SWITCHABLE_ENABLED
 		HMENU _hMenu;
 		HMENU _hPopupMenu;
@@ -90,7 +79,6 @@ namespace Window
 
 		HRESULT Initialize();
 		void Terminate();
-		void Run();
 
 #ifdef WINDOW_MODE_SWITCHABLE_ENABLED
 		void ChangeWindowModeWindowed();